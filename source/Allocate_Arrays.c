@@ -521,16 +521,9 @@ void Allocate_Arrays(int wherefrom)
 	}
       }
 
-      Spe_RF_Bessel = (double****)malloc(sizeof(double***)*List_YOUSO[18]);
-      for (i=0; i<List_YOUSO[18]; i++){
-        Spe_RF_Bessel[i] = (double***)malloc(sizeof(double**)*(List_YOUSO[25]+1));
-        for (j=0; j<=List_YOUSO[25]; j++){
-          Spe_RF_Bessel[i][j] = (double**)malloc(sizeof(double*)*List_YOUSO[24]);
-          for (k=0; k<List_YOUSO[24]; k++){
-            Spe_RF_Bessel[i][j][k] = (double*)malloc(sizeof(double)*List_YOUSO[15]);
-	  }
-	}
-      }
+      /* one copy per node, see Shared_Memory.c */
+
+      Spe_RF_Bessel = Shm_Malloc_Double4(List_YOUSO[18],List_YOUSO[25]+1,List_YOUSO[24],List_YOUSO[15]);
 
     break;
 
@@ -595,16 +588,7 @@ void Allocate_Arrays(int wherefrom)
         for (j=0; j<List_YOUSO[19]; j++) Spe_VPS_List[i][j] = 0;
       }
 
-      Spe_NLRF_Bessel = (double****)malloc(sizeof(double***)*(SO_switch+1));
-      for (so=0; so<(SO_switch+1); so++){
-        Spe_NLRF_Bessel[so] = (double***)malloc(sizeof(double**)*List_YOUSO[18]);
-        for (i=0; i<List_YOUSO[18]; i++){
-          Spe_NLRF_Bessel[so][i] = (double**)malloc(sizeof(double*)*(List_YOUSO[19]+2));
-          for (j=0; j<(List_YOUSO[19]+2); j++){
-            Spe_NLRF_Bessel[so][i][j] = (double*)malloc(sizeof(double)*List_YOUSO[15]);
-	  }
-        }
-      }
+      Spe_NLRF_Bessel = Shm_Malloc_Double4(SO_switch+1,List_YOUSO[18],List_YOUSO[19]+2,List_YOUSO[15]);
 
       if (ProExpn_VNA==1){
 
@@ -628,16 +612,7 @@ void Allocate_Arrays(int wherefrom)
 	  }
 	}
 
-        Spe_VNA_Bessel = (double****)malloc(sizeof(double***)*List_YOUSO[18]);
-        for (i=0; i<List_YOUSO[18]; i++){
-          Spe_VNA_Bessel[i] = (double***)malloc(sizeof(double**)*(List_YOUSO[35]+1));
-          for (L=0; L<(List_YOUSO[35]+1); L++){
-            Spe_VNA_Bessel[i][L] = (double**)malloc(sizeof(double*)*List_YOUSO[34]);
-            for (j=0; j<List_YOUSO[34]; j++){
-              Spe_VNA_Bessel[i][L][j] = (double*)malloc(sizeof(double)*(GL_Mesh+2));
-            }
-	  }
-        }
+        Spe_VNA_Bessel = Shm_Malloc_Double4(List_YOUSO[18],List_YOUSO[35]+1,List_YOUSO[34],GL_Mesh+2);
 
         Spe_CrudeVNA_Bessel = (double**)malloc(sizeof(double*)*List_YOUSO[18]);
         for (i=0; i<List_YOUSO[18]; i++){
@@ -0,0 +1,268 @@
+/**********************************************************************
+  Arena.c:
+
+     Arena.c is a set of subroutines for the allocation of work arrays
+     which are used only during a call of a kernel, e.g., work arrays of
+     LAPACK, buffers of MPI communication, and arrays of radial and
+     angular parts of basis functions.
+
+     Each OpenMP thread owns its own arena, so the allocation needs
+     neither a lock nor a system call. Work arrays are allocated in a
+     stack-like way:
+
+       Arena_Push();
+       A = (double*)Arena_Alloc(sizeof(double)*n);
+       B = (double*)Arena_Alloc(sizeof(double)*n);
+       ...
+       Arena_Pop();     (A and B are released together)
+
+     If the arena is too small, the request is served by malloc and
+     the size needed is recorded. The arena is then enlarged to the
+     high-water mark by Arena_Reset, which is called at the beginning
+     of each SCF step, so that the later SCF steps do not call malloc
+     in the kernels. The high-water marks are output by PrintMemory.
+
+  Log of Arena.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "openmx_common.h"
+#include <omp.h>
+
+#define Arena_Align      64
+#define Arena_Max_Depth  64
+#define Arena_Max_Thrds  1024
+
+struct Arena_Struct {
+  char *base;                       /* memory of the arena */
+  size_t size;                      /* size of base */
+  size_t top;                       /* used size of base */
+  size_t need;                      /* size needed including overflows */
+  size_t high;                      /* high-water mark of need */
+  int depth;                        /* depth of Arena_Push */
+  size_t mark_top[Arena_Max_Depth];
+  size_t mark_need[Arena_Max_Depth];
+  int mark_novf[Arena_Max_Depth];
+  int novf,max_novf;                /* overflows served by malloc */
+  void **ovf;
+  long int num_ovf;                 /* # of overflows in total */
+};
+
+static struct Arena_Struct *Arena_Thrd = NULL;
+#pragma omp threadprivate(Arena_Thrd)
+
+static struct Arena_Struct *Arena_List[Arena_Max_Thrds];
+static int Arena_Num = 0;
+
+static struct Arena_Struct *Arena_Get();
+static size_t Arena_Round(size_t size);
+
+
+
+void Arena_Push()
+{
+  struct Arena_Struct *ar;
+
+  ar = Arena_Get();
+
+  if (Arena_Max_Depth<=ar->depth){
+    printf("Arena_Push: the depth exceeds %d.\n",Arena_Max_Depth);
+    MPI_Finalize();
+    exit(0);
+  }
+
+  ar->mark_top[ar->depth]  = ar->top;
+  ar->mark_need[ar->depth] = ar->need;
+  ar->mark_novf[ar->depth] = ar->novf;
+  ar->depth++;
+}
+
+
+
+void *Arena_Alloc(size_t size)
+{
+  struct Arena_Struct *ar;
+  void *p;
+
+  ar = Arena_Get();
+  size = Arena_Round(size);
+
+  ar->need += size;
+  if (ar->high<ar->need) ar->high = ar->need;
+
+  /* from the arena */
+
+  if ((ar->top+size)<=ar->size){
+    p = (void*)(ar->base + ar->top);
+    ar->top += size;
+    return p;
+  }
+
+  /* by malloc */
+
+  if (ar->max_novf<=ar->novf){
+    ar->max_novf = 2*ar->max_novf + 16;
+    ar->ovf = (void**)realloc(ar->ovf, sizeof(void*)*ar->max_novf);
+  }
+
+  if (posix_memalign(&p, Arena_Align, size)!=0){
+    printf("Arena_Alloc: could not allocate %lu bytes.\n",(unsigned long)size);
+    MPI_Finalize();
+    exit(0);
+  }
+
+  ar->ovf[ar->novf++] = p;
+  ar->num_ovf++;
+
+  return p;
+}
+
+
+
+void Arena_Pop()
+{
+  struct Arena_Struct *ar;
+
+  ar = Arena_Get();
+
+  if (ar->depth<=0){
+    printf("Arena_Pop: Arena_Push was not called.\n");
+    MPI_Finalize();
+    exit(0);
+  }
+
+  ar->depth--;
+
+  while (ar->mark_novf[ar->depth]<ar->novf){
+    ar->novf--;
+    free(ar->ovf[ar->novf]);
+  }
+
+  ar->top  = ar->mark_top[ar->depth];
+  ar->need = ar->mark_need[ar->depth];
+}
+
+
+
+/****************************************************
+  Arena_Reset enlarges each arena to its high-water
+  mark. It has to be called outside OpenMP parallel
+  regions when no work array is in use.
+****************************************************/
+
+void Arena_Reset()
+{
+  int i;
+  struct Arena_Struct *ar;
+
+  for (i=0; i<Arena_Num; i++){
+
+    ar = Arena_List[i];
+
+    if (ar->depth!=0) continue;
+
+    if (ar->size<ar->high){
+      free(ar->base);
+      ar->size = Arena_Round(ar->high + ar->high/8);
+      if (posix_memalign((void**)&ar->base, Arena_Align, ar->size)!=0){
+        ar->base = NULL;
+        ar->size = 0;
+      }
+    }
+
+    ar->top = 0;
+    ar->need = 0;
+  }
+}
+
+
+
+void Arena_PrintMemory()
+{
+  int i;
+  long int num;
+  size_t high,size;
+  char name[YOUSO10];
+
+  high = 0;
+  size = 0;
+  num = 0;
+
+  for (i=0; i<Arena_Num; i++){
+    sprintf(name,"Arena: thread %d (high-water)",i);
+    PrintMemory(name,(long int)Arena_List[i]->high,NULL);
+    if (high<Arena_List[i]->high) high = Arena_List[i]->high;
+    size += Arena_List[i]->size;
+    num += Arena_List[i]->num_ovf;
+  }
+
+  if (memoryusage_fileout && 0<level_stdout){
+    printf("<Arena>  %d arenas, %10.3f MBytes in total, max. high-water %10.3f MBytes, %ld overflows\n",
+           Arena_Num,(double)size/(1024.0*1024.0),(double)high/(1024.0*1024.0),num);
+  }
+}
+
+
+
+void Arena_Free()
+{
+  int i;
+  struct Arena_Struct *ar;
+
+  for (i=0; i<Arena_Num; i++){
+
+    ar = Arena_List[i];
+
+    while (0<ar->novf){
+      ar->novf--;
+      free(ar->ovf[ar->novf]);
+    }
+
+    if (ar->ovf!=NULL) free(ar->ovf);
+    if (ar->base!=NULL) free(ar->base);
+
+    ar->base = NULL;
+    ar->ovf = NULL;
+    ar->size = 0;
+    ar->top = 0;
+    ar->need = 0;
+    ar->max_novf = 0;
+  }
+}
+
+
+
+/* the arena of the calling thread is created at the first call */
+
+static struct Arena_Struct *Arena_Get()
+{
+  struct Arena_Struct *ar;
+
+  if (Arena_Thrd!=NULL) return Arena_Thrd;
+
+  ar = (struct Arena_Struct*)malloc(sizeof(struct Arena_Struct));
+  memset(ar, 0, sizeof(struct Arena_Struct));
+
+#pragma omp critical (Arena_critical)
+  {
+    if (Arena_Num<Arena_Max_Thrds){
+      Arena_List[Arena_Num++] = ar;
+    }
+  }
+
+  Arena_Thrd = ar;
+  return ar;
+}
+
+
+
+static size_t Arena_Round(size_t size)
+{
+  if (size==0) size = 1;
+  return ((size + Arena_Align - 1)/Arena_Align)*Arena_Align;
+}
@@ -0,0 +1,203 @@
+/**********************************************************************
+  Atom_Exchange.c:
+
+     Atom_Exchange.c is a set of subroutines to share data computed
+     by the owners of atoms, k-points, and so on, with a single
+     collective communication instead of one MPI_Bcast per item.
+
+     Rows_Allgather_Double:  rows[i] computed by owner[i] are shared
+                             by one MPI_Allgatherv
+     Atom_Allgather_Double:  a[Gc_AN][i0:i0+n-1] computed by G2ID[Gc_AN]
+     Atom_Allgather_Vector:  a[(Gc_AN-1)*n:Gc_AN*n-1] computed by G2ID[Gc_AN]
+     Atom_Bcast_Double:      a[Gc_AN][i0:i0+n-1] of all the atoms
+                             computed by root
+
+     The layout of the packed buffer, which depends only on the owners,
+     is kept and reused as long as the owners are not changed.
+
+  Log of Atom_Exchange.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "mpi.h"
+
+#define AE_MaxLayouts  8
+
+typedef struct {
+  int num;
+  int *owner;     /* copy of the owners to check the validity    */
+  int *order;     /* rows sorted by their owners                 */
+  int *counts;    /* the number of rows of each process          */
+  int *displs;    /* the first position of rows of each process  */
+} AE_Layout;
+
+static AE_Layout AE_List[AE_MaxLayouts];
+static int AE_Num = 0;
+static int AE_Next = 0;
+
+static AE_Layout *AE_Find_Layout(int num, int *owner);
+
+
+
+static AE_Layout *AE_Find_Layout(int num, int *owner)
+{
+  int numprocs,i,k,ID;
+  AE_Layout *L;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+
+  for (k=0; k<AE_Num; k++){
+    L = &AE_List[k];
+    if (L->num==num && memcmp(L->owner,owner,sizeof(int)*num)==0) return L;
+  }
+
+  /* make a new layout, replacing the oldest one if full */
+
+  if (AE_Num<AE_MaxLayouts){
+    L = &AE_List[AE_Num];
+    AE_Num++;
+  }
+  else{
+    L = &AE_List[AE_Next];
+    AE_Next = (AE_Next+1) % AE_MaxLayouts;
+    free(L->owner);
+    free(L->order);
+    free(L->counts);
+    free(L->displs);
+  }
+
+  L->num = num;
+  L->owner  = (int*)malloc(sizeof(int)*(num+1));
+  L->order  = (int*)malloc(sizeof(int)*(num+1));
+  L->counts = (int*)malloc(sizeof(int)*numprocs);
+  L->displs = (int*)malloc(sizeof(int)*numprocs);
+
+  memcpy(L->owner,owner,sizeof(int)*num);
+
+  for (ID=0; ID<numprocs; ID++) L->counts[ID] = 0;
+  for (i=0; i<num; i++) L->counts[owner[i]]++;
+
+  L->displs[0] = 0;
+  for (ID=1; ID<numprocs; ID++) L->displs[ID] = L->displs[ID-1] + L->counts[ID-1];
+
+  for (ID=0; ID<numprocs; ID++) L->counts[ID] = 0;
+  for (i=0; i<num; i++){
+    ID = owner[i];
+    L->order[L->displs[ID]+L->counts[ID]] = i;
+    L->counts[ID]++;
+  }
+
+  return L;
+}
+
+
+void Rows_Allgather_Double(double **rows, int num, int n, int *owner)
+{
+  int numprocs,myid,ID,i,j;
+  int *rcounts,*rdispls;
+  double *sbuf,*rbuf;
+  AE_Layout *L;
+
+  if (num<=0 || n<=0) return;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  L = AE_Find_Layout(num,owner);
+
+  rcounts = (int*)malloc(sizeof(int)*numprocs);
+  rdispls = (int*)malloc(sizeof(int)*numprocs);
+
+  for (ID=0; ID<numprocs; ID++){
+    rcounts[ID] = L->counts[ID]*n;
+    rdispls[ID] = L->displs[ID]*n;
+  }
+
+  /* pack the rows of myid */
+
+  sbuf = (double*)malloc(sizeof(double)*(L->counts[myid]*n+1));
+  rbuf = (double*)malloc(sizeof(double)*((long int)num*n));
+
+  for (j=0; j<L->counts[myid]; j++){
+    i = L->order[L->displs[myid]+j];
+    memcpy(&sbuf[j*n], rows[i], sizeof(double)*n);
+  }
+
+  MPI_Allgatherv(sbuf, rcounts[myid], MPI_DOUBLE,
+                 rbuf, rcounts, rdispls, MPI_DOUBLE, mpi_comm_level1);
+
+  /* unpack the rows of the others */
+
+  for (j=0; j<num; j++){
+    i = L->order[j];
+    if (owner[i]!=myid) memcpy(rows[i], &rbuf[(long int)j*n], sizeof(double)*n);
+  }
+
+  free(rbuf);
+  free(sbuf);
+  free(rdispls);
+  free(rcounts);
+}
+
+
+void Atom_Allgather_Double(double **a, int i0, int n)
+{
+  int Gc_AN;
+  double **rows;
+
+  rows = (double**)malloc(sizeof(double*)*(atomnum+1));
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++) rows[Gc_AN-1] = &a[Gc_AN][i0];
+
+  Rows_Allgather_Double(rows, atomnum, n, &G2ID[1]);
+
+  free(rows);
+}
+
+
+void Atom_Allgather_Vector(double *a, int n)
+{
+  int Gc_AN;
+  double **rows;
+
+  rows = (double**)malloc(sizeof(double*)*(atomnum+1));
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++) rows[Gc_AN-1] = &a[(long int)(Gc_AN-1)*n];
+
+  Rows_Allgather_Double(rows, atomnum, n, &G2ID[1]);
+
+  free(rows);
+}
+
+
+void Atom_Bcast_Double(double **a, int i0, int n, int root)
+{
+  int Gc_AN,myid;
+  double *buf;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  buf = (double*)malloc(sizeof(double)*((long int)atomnum*n+1));
+
+  if (myid==root){
+    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+      memcpy(&buf[(long int)(Gc_AN-1)*n], &a[Gc_AN][i0], sizeof(double)*n);
+    }
+  }
+
+  MPI_Bcast(buf, atomnum*n, MPI_DOUBLE, root, mpi_comm_level1);
+
+  if (myid!=root){
+    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+      memcpy(&a[Gc_AN][i0], &buf[(long int)(Gc_AN-1)*n], sizeof(double)*n);
+    }
+  }
+
+  free(buf);
+}
+
@@ -0,0 +1,232 @@
+/**********************************************************************
+  Atom_Schedule.c:
+
+     Atom_Schedule.c is a set of subroutines to distribute atoms to
+     OpenMP threads in the O(N) methods (DC, Krylov), where the cost of
+     each atom is dominated by the diagonalization of its cluster.
+
+     Atoms are handed out from a shared queue in descending order of
+     their estimated cost, i.e., the largest clusters first, so that the
+     small clusters fill the gaps at the end of the loop. The cost of
+     each atom is measured at each call, and the measured one is used
+     in the next call. At the first call, it is estimated from the size
+     of the cluster. The idle time of threads at the end of the loop
+     is output if level_stdout>1.
+
+       Atom_Schedule_Start(phase, s1, s2);
+       #pragma omp parallel
+       {
+         while ((Mc_AN=Atom_Schedule_Next(phase))!=0){ ... }
+       }
+       Atom_Schedule_End(phase, "DC");
+
+  Log of Atom_Schedule.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "openmx_common.h"
+#include "mpi.h"
+#include <omp.h>
+
+static int Sched_Natom[Sched_Num];        /* Matomnum at the last call */
+static int *Sched_Order[Sched_Num];       /* Mc_AN in descending order of cost */
+static int Sched_Count[Sched_Num];        /* next position in Sched_Order */
+static double *Sched_Cost[Sched_Num];     /* measured cost indexed by Gc_AN */
+static int Sched_atomnum[Sched_Num];
+
+/* for each thread */
+static int Sched_Nthrds[Sched_Num];
+static int *Sched_Cur[Sched_Num];         /* Mc_AN being calculated */
+static double *Sched_Stime[Sched_Num];    /* when it started */
+static double *Sched_Etime[Sched_Num];    /* when the thread finished */
+
+static void Sched_Sort(int n, double *key, int *idx);
+
+
+
+/****************************************************
+  Atom_Schedule_Start sets up the queue. The cost of
+  Mc_AN is estimated as s1[Mc_AN]^2*s2[Mc_AN] if it
+  has not been measured yet.
+****************************************************/
+
+void Atom_Schedule_Start(int phase, int *s1, int *s2)
+{
+  int Mc_AN,Gc_AN,i,n,po;
+  double *key;
+
+  n = Matomnum;
+
+  if (Sched_atomnum[phase]!=atomnum){
+    if (Sched_Cost[phase]!=NULL) free(Sched_Cost[phase]);
+    Sched_Cost[phase] = (double*)malloc(sizeof(double)*(atomnum+1));
+    for (i=0; i<=atomnum; i++) Sched_Cost[phase][i] = 0.0;
+    Sched_atomnum[phase] = atomnum;
+  }
+
+  if (Sched_Order[phase]!=NULL) free(Sched_Order[phase]);
+  Sched_Order[phase] = (int*)malloc(sizeof(int)*(n+1));
+  key = (double*)malloc(sizeof(double)*(n+1));
+
+  /* the measured cost is used only if it is available for all the atoms */
+
+  po = 1;
+  for (Mc_AN=1; Mc_AN<=n; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    if (Sched_Cost[phase][Gc_AN]<=0.0) po = 0;
+  }
+
+  for (Mc_AN=1; Mc_AN<=n; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    Sched_Order[phase][Mc_AN-1] = Mc_AN;
+    if (po) key[Mc_AN-1] = Sched_Cost[phase][Gc_AN];
+    else    key[Mc_AN-1] = (double)s1[Mc_AN]*(double)s1[Mc_AN]*(double)s2[Mc_AN];
+  }
+
+  Sched_Sort(n, key, Sched_Order[phase]);
+
+  Sched_Natom[phase] = n;
+  Sched_Count[phase] = 0;
+
+  /* arrays for threads */
+
+  if (Sched_Nthrds[phase]<omp_get_max_threads()){
+
+    if (Sched_Cur[phase]!=NULL){
+      free(Sched_Cur[phase]);
+      free(Sched_Stime[phase]);
+      free(Sched_Etime[phase]);
+    }
+
+    Sched_Nthrds[phase] = omp_get_max_threads();
+    Sched_Cur[phase]   = (int*)malloc(sizeof(int)*Sched_Nthrds[phase]);
+    Sched_Stime[phase] = (double*)malloc(sizeof(double)*Sched_Nthrds[phase]);
+    Sched_Etime[phase] = (double*)malloc(sizeof(double)*Sched_Nthrds[phase]);
+  }
+
+  for (i=0; i<Sched_Nthrds[phase]; i++){
+    Sched_Cur[phase][i] = -1;
+    Sched_Etime[phase][i] = -1.0;
+  }
+
+  free(key);
+}
+
+
+
+/****************************************************
+  Atom_Schedule_Next returns Mc_AN to be calculated
+  by the calling thread, or 0 if no atom is left.
+****************************************************/
+
+int Atom_Schedule_Next(int phase)
+{
+  int OMPID,i,Mc_AN;
+  double now;
+
+  OMPID = omp_get_thread_num();
+  dtime(&now);
+
+  /* the cost of the previous atom */
+
+  if (0<Sched_Cur[phase][OMPID]){
+    Mc_AN = Sched_Cur[phase][OMPID];
+    Sched_Cost[phase][M2G[Mc_AN]] = now - Sched_Stime[phase][OMPID];
+  }
+
+#pragma omp atomic capture
+  i = Sched_Count[phase]++;
+
+  if (Sched_Natom[phase]<=i){
+    Sched_Cur[phase][OMPID] = 0;
+    Sched_Etime[phase][OMPID] = now;
+    return 0;
+  }
+
+  Mc_AN = Sched_Order[phase][i];
+  Sched_Cur[phase][OMPID] = Mc_AN;
+  Sched_Stime[phase][OMPID] = now;
+
+  return Mc_AN;
+}
+
+
+
+void Atom_Schedule_End(int phase, char *name)
+{
+  int i,n,myid;
+  double emax,emin,idle;
+
+  if (level_stdout<=1) return;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  emax = -1.0e+100;
+  emin =  1.0e+100;
+  n = 0;
+
+  for (i=0; i<Sched_Nthrds[phase]; i++){
+    if (Sched_Etime[phase][i]<0.0) continue;
+    if (emax<Sched_Etime[phase][i]) emax = Sched_Etime[phase][i];
+    if (Sched_Etime[phase][i]<emin) emin = Sched_Etime[phase][i];
+    n++;
+  }
+
+  if (n==0) return;
+
+  idle = 0.0;
+  for (i=0; i<Sched_Nthrds[phase]; i++){
+    if (Sched_Etime[phase][i]<0.0) continue;
+    idle += emax - Sched_Etime[phase][i];
+  }
+
+  printf("<%s> myid=%2d  idle time of %d threads: total %10.5f sec, max %10.5f sec\n",
+         name,myid,n,idle,emax-emin);
+}
+
+
+
+/* sort idx in descending order of key (heap sort) */
+
+static void Sched_Sort(int n, double *key, int *idx)
+{
+  int i,j,k,m,ti;
+  double tk;
+
+  if (n<=1) return;
+
+  for (k=n/2-1; ; k--){
+
+    for (i=k; ; i=j){
+      j = 2*i + 1;
+      if (n<=j) break;
+      if ((j+1)<n && key[j+1]<key[j]) j++;
+      if (key[i]<=key[j]) break;
+      tk = key[i]; key[i] = key[j]; key[j] = tk;
+      ti = idx[i]; idx[i] = idx[j]; idx[j] = ti;
+    }
+
+    if (k<=0) break;
+  }
+
+  /* the minimum is moved to the end */
+
+  for (m=n-1; 0<m; m--){
+
+    tk = key[0]; key[0] = key[m]; key[m] = tk;
+    ti = idx[0]; idx[0] = idx[m]; idx[m] = ti;
+
+    for (i=0; ; i=j){
+      j = 2*i + 1;
+      if (m<=j) break;
+      if ((j+1)<m && key[j+1]<key[j]) j++;
+      if (key[i]<=key[j]) break;
+      tk = key[i]; key[i] = key[j]; key[j] = tk;
+      ti = idx[i]; idx[i] = idx[j]; idx[j] = ti;
+    }
+  }
+}
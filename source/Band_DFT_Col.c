@@ -7,6 +7,8 @@
   Log of Band_DFT_Col.c:
 
      22/Nov/2001  Released by T.Ozaki
+     18/Oct/2026  EIGEN shared by Rows_Allgather_Double
+     18/Oct/2026  S and H made by Bloch_Sum_Col
 
 ***********************************************************************/
 
@@ -147,6 +149,7 @@ double Band_DFT_Col(int SCF_iter,
 
   dcomplex *BLAS_H;
   dcomplex *BLAS_C;
+  dcomplex *phase;
 
   /* for OpenMP */
   int OMPID,Nthrds,Nprocs;
@@ -662,6 +665,10 @@ diagonalize1:
 
   dtime(&SiloopTime);
 
+  /* phase factors of the k-points of myid */
+
+  phase = Bloch_Sum_Phase(num_kloop0,&T_KGrids1[S_knum],&T_KGrids2[S_knum],&T_KGrids3[S_knum]);
+
   for (kloop0=0; kloop0<num_kloop0; kloop0++){
 
     kloop = S_knum + kloop0;
@@ -670,75 +677,22 @@ diagonalize1:
     k2 = T_KGrids2[kloop];
     k3 = T_KGrids3[kloop];
 
-    /* make S and H */
+    /* make S and H, where BLAS_S is used as a work array
+       until S*1/sqrt(ko) is stored */
+
+    Bloch_Sum_Col(&phase[kloop0*(TCpyCell+1)], order_GA, MP, H1, BLAS_H, n);
 
     if (SCF_iter==1 || rediagonalize_flag_overlap_matrix==1 || all_knum!=1){
 
-      for (i1=0; i1<n*n; i1++) BLAS_S[i1] = Complex(0.0,0.0);
+      Bloch_Sum_Col(&phase[kloop0*(TCpyCell+1)], order_GA, MP, S1, BLAS_S, n);
 
       for (i1=1; i1<=n; i1++){
 	for (j1=1; j1<=n; j1++){
-	  S[i1][j1] = Complex(0.0,0.0);
+	  S[i1][j1] = BLAS_S[(j1-1)*n+i1-1];
 	} 
       } 
     }
 
-    for (i1=1; i1<=n; i1++){
-      for (j1=1; j1<=n; j1++){
-	H[i1][j1] = Complex(0.0,0.0);
-      } 
-    } 
-
-    k = 0;
-    for (AN=1; AN<=atomnum; AN++){
-      GA_AN = order_GA[AN];
-      wanA = WhatSpecies[GA_AN];
-      tnoA = Spe_Total_CNO[wanA];
-      Anum = MP[GA_AN];
-
-      for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	GB_AN = natn[GA_AN][LB_AN];
-	Rn = ncn[GA_AN][LB_AN];
-	wanB = WhatSpecies[GB_AN];
-	tnoB = Spe_Total_CNO[wanB];
-	Bnum = MP[GB_AN];
-
-	l1 = atv_ijk[Rn][1];
-	l2 = atv_ijk[Rn][2];
-	l3 = atv_ijk[Rn][3];
-	kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	si = sin(2.0*PI*kRn);
-	co = cos(2.0*PI*kRn);
-
-	for (i=0; i<tnoA; i++){
-
-	  for (j=0; j<tnoB; j++){
-
-	    H[Anum+i][Bnum+j].r += H1[k]*co;
-	    H[Anum+i][Bnum+j].i += H1[k]*si;
-
-	    k++;
-
-	  }
-
-          if (SCF_iter==1 || rediagonalize_flag_overlap_matrix==1 || all_knum!=1){
-
-            k -= tnoB; 
-
-  	    for (j=0; j<tnoB; j++){
-
-	      S[Anum+i][Bnum+j].r += S1[k]*co;
-	      S[Anum+i][Bnum+j].i += S1[k]*si;
-
-  	      k++;
-	    }
-	  }
-
-	}
-      }
-    }
-
     /*---------- added by TOYODA 15/FEB/2010 */
     if (5==XC_switch) {  
 
@@ -746,17 +700,21 @@ diagonalize1:
       if (1<SCF_iter) { EXX_Debug_Check_DM(exx, exx_CDM, CDM); }
 #endif
 
-      EXX_Fock_Band(H, exx, exx_CDM, MP, k1, k2, k3, spin);
-    }
-    /*---------- until here */
+      for (i1=1; i1<=n; i1++){
+	for (j1=1; j1<=n; j1++){
+	  H[i1][j1] = BLAS_H[(j1-1)*n+i1-1];
+	} 
+      } 
 
-    /* for blas */
+      EXX_Fock_Band(H, exx, exx_CDM, MP, k1, k2, k3, spin);
 
-    for (i1=1; i1<=n; i1++){
-      for (j1=1; j1<=n; j1++){
-	BLAS_H[(j1-1)*n+i1-1] = H[i1][j1];
+      for (i1=1; i1<=n; i1++){
+	for (j1=1; j1<=n; j1++){
+	  BLAS_H[(j1-1)*n+i1-1] = H[i1][j1];
+	} 
       } 
-    } 
+    }
+    /*---------- until here */
 
     /* diagonalize S */
 
@@ -1292,6 +1250,8 @@ diagonalize1:
 
   } /* kloop0 */
 
+  free(phase);
+
   dtime(&EiloopTime);
 
   if (SpinP_switch==1 && numprocs0==1 && spin==0){
@@ -1308,13 +1268,30 @@ diagonalize1:
   MPI_Barrier(mpi_comm_level1);
   dtime(&Stime);
 
-  for (spin=0; spin<=SpinP_switch; spin++){
-    for (kloop=0; kloop<T_knum; kloop++){
+  {
+    int num,*owner;
+    double **rows;
 
-      /* get ID in the zeroth world */
-      ID = Comm_World_StartID1[spin] + T_k_ID[spin][kloop];
-      MPI_Bcast(&EIGEN[spin][kloop][0], MaxN+1, MPI_DOUBLE, ID, mpi_comm_level1);
-    } 
+    owner = (int*)malloc(sizeof(int)*(SpinP_switch+1)*T_knum);
+    rows = (double**)malloc(sizeof(double*)*(SpinP_switch+1)*T_knum);
+
+    num = 0;
+    for (spin=0; spin<=SpinP_switch; spin++){
+      for (kloop=0; kloop<T_knum; kloop++){
+
+        /* get ID in the zeroth world */
+        owner[num] = Comm_World_StartID1[spin] + T_k_ID[spin][kloop];
+        rows[num] = EIGEN[spin][kloop];
+        num++;
+      } 
+    }
+
+    /* one MPI_Allgatherv for all the k-points */
+
+    Rows_Allgather_Double(rows, num, MaxN+1, owner);
+
+    free(rows);
+    free(owner);
   }
 
   dtime(&Etime);
@@ -1904,6 +1881,8 @@ diagonalize1:
 
     /* for kloop */
 
+    phase = Bloch_Sum_Phase(num_kloop0,&T_KGrids1[S_knum],&T_KGrids2[S_knum],&T_KGrids3[S_knum]);
+
     for (kloop0=0; kloop0<num_kloop0; kloop0++){
 
       kloop = kloop0 + S_knum;
@@ -1912,57 +1891,14 @@ diagonalize1:
       k2 = T_KGrids2[kloop];
       k3 = T_KGrids3[kloop];
 
-      /* make S and H */
-
-      for (i1=1; i1<=n; i1++){
-	for (j1=1; j1<=n; j1++){
-	  S[i1][j1] = Complex(0.0,0.0);
-	  H[i1][j1] = Complex(0.0,0.0);
-	} 
-      } 
+      /* make S and H, where BLAS_S is used as a work array */
 
-      k = 0;
-      for (AN=1; AN<=atomnum; AN++){
-	GA_AN = order_GA[AN];
-	wanA = WhatSpecies[GA_AN];
-	tnoA = Spe_Total_CNO[wanA];
-	Anum = MP[GA_AN];
-
-	for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	  GB_AN = natn[GA_AN][LB_AN];
-	  Rn = ncn[GA_AN][LB_AN];
-	  wanB = WhatSpecies[GB_AN];
-	  tnoB = Spe_Total_CNO[wanB];
-	  Bnum = MP[GB_AN];
-
-	  l1 = atv_ijk[Rn][1];
-	  l2 = atv_ijk[Rn][2];
-	  l3 = atv_ijk[Rn][3];
-	  kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	  si = sin(2.0*PI*kRn);
-	  co = cos(2.0*PI*kRn);
-
-	  for (i=0; i<tnoA; i++){
-	    for (j=0; j<tnoB; j++){
-
-	      S[Anum+i][Bnum+j].r += S1[k]*co;
-	      S[Anum+i][Bnum+j].i += S1[k]*si;
-	      H[Anum+i][Bnum+j].r += H1[k]*co;
-	      H[Anum+i][Bnum+j].i += H1[k]*si;
-
-	      k++;
-
-	    }
-	  }
-	}
-      }
-
-      /* for blas */
+      Bloch_Sum_Col(&phase[kloop0*(TCpyCell+1)], order_GA, MP, H1, BLAS_H, n);
+      Bloch_Sum_Col(&phase[kloop0*(TCpyCell+1)], order_GA, MP, S1, BLAS_S, n);
 
       for (i1=1; i1<=n; i1++){
 	for (j1=1; j1<=n; j1++){
-	  BLAS_H[(j1-1)*n+i1-1] = H[i1][j1];
+	  S[i1][j1] = BLAS_S[(j1-1)*n+i1-1];
 	} 
       } 
 
@@ -2475,6 +2411,8 @@ diagonalize1:
 
     } /* kloop0 */
 
+    free(phase);
+
     /*******************************************************
          sum of CDM1 and EDM1 by Allreduce in MPI
     *******************************************************/
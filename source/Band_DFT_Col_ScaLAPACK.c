@@ -7,6 +7,8 @@
   Log of Band_DFT_Col.c:
 
      22/Nov/2001  Released by T.Ozaki
+     18/Oct/2026  EIGEN shared by Rows_Allgather_Double
+     18/Oct/2026  Cs and Hs made by Bloch_Sum_BlockCyclic
 
 ***********************************************************************/
 
@@ -201,6 +203,7 @@ double Band_DFT_Col_ScaLAPACK(
 
   dcomplex *BLAS_H;
   dcomplex *BLAS_C;
+  dcomplex *phase;
 
   /* for OpenMP */
   int OMPID,Nthrds,Nprocs;
@@ -739,6 +742,10 @@ diagonalize1:
 
   dtime(&SiloopTime);
 
+  /* phase factors of the k-points of myid */
+
+  phase = Bloch_Sum_Phase(num_kloop0,&T_KGrids1[S_knum],&T_KGrids2[S_knum],&T_KGrids3[S_knum]);
+
   for (kloop0=0; kloop0<num_kloop0; kloop0++){
 
     kloop = S_knum + kloop0;
@@ -747,28 +754,24 @@ diagonalize1:
     k2 = T_KGrids2[kloop];
     k3 = T_KGrids3[kloop];
 
-    /* make S and H */
+    /* make S and H directly in the block cyclic distribution */
 
-    /*
     if (SCF_iter==1 || all_knum!=1){
+      Bloch_Sum_BlockCyclic(&phase[kloop0*(TCpyCell+1)], order_GA, MP, S1, Cs, n,
+                            nblk, np_rows, np_cols, my_prow, my_pcol, na_rows, na_cols);
+    }
 
-      for (i1=0; i1<n*n; i1++) BLAS_S[i1] = Complex(0.0,0.0);
+    /*---------- added by TOYODA 15/FEB/2010 */
+    if (5==XC_switch) {  
+
+      /* EXX_Fock_Band needs the full H */
 
       for (i1=1; i1<=n; i1++){
 	for (j1=1; j1<=n; j1++){
-	  S[i1][j1] = Complex(0.0,0.0);
+	  H[i1][j1] = Complex(0.0,0.0);
 	} 
       } 
-    }
-    */
-
-    for (i1=1; i1<=n; i1++){
-      for (j1=1; j1<=n; j1++){
-	H[i1][j1] = Complex(0.0,0.0);
-      } 
-    } 
 
-    if (SCF_iter==1 || all_knum!=1){
       k = 0;
       for (AN=1; AN<=atomnum; AN++){
 	GA_AN = order_GA[AN];
@@ -783,104 +786,43 @@ diagonalize1:
 	  tnoB = Spe_Total_CNO[wanB];
 	  Bnum = MP[GB_AN];
 
-	  l1 = atv_ijk[Rn][1];
-	  l2 = atv_ijk[Rn][2];
-	  l3 = atv_ijk[Rn][3];
-	  kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	  si = sin(2.0*PI*kRn);
-	  co = cos(2.0*PI*kRn);
+	  co = phase[kloop0*(TCpyCell+1)+Rn].r;
+	  si = phase[kloop0*(TCpyCell+1)+Rn].i;
 
 	  for (i=0; i<tnoA; i++){
-
 	    for (j=0; j<tnoB; j++){
 
-	      H[Anum+i][Bnum+j].r += S1[k]*co;
-	      H[Anum+i][Bnum+j].i += S1[k]*si;
+	      H[Anum+i][Bnum+j].r += H1[k]*co;
+	      H[Anum+i][Bnum+j].i += H1[k]*si;
 
 	      k++;
-
 	    }
 	  }
 	}
       }
 
+#if 0
+      if (1<SCF_iter) { EXX_Debug_Check_DM(exx, exx_CDM, CDM); }
+#endif
+
+      EXX_Fock_Band(H, exx, exx_CDM, MP, k1, k2, k3, spin);
+
       for(i=0;i<na_rows;i++){
 	for(j=0;j<na_cols;j++){
 	  ig = np_rows*nblk*((i)/nblk) + (i)%nblk + ((np_rows+my_prow)%np_rows)*nblk + 1;
 	  jg = np_cols*nblk*((j)/nblk) + (j)%nblk + ((np_cols+my_pcol)%np_cols)*nblk + 1;
-	  Cs[j*na_rows+i].r = H[ig][jg].r;
-	  Cs[j*na_rows+i].i = H[ig][jg].i;
-	}
-      }
-      
-    }
-
-
-    for (i1=1; i1<=n; i1++){
-      for (j1=1; j1<=n; j1++){
-	H[i1][j1] = Complex(0.0,0.0);
-      } 
-    } 
-
-    k = 0;
-    for (AN=1; AN<=atomnum; AN++){
-      GA_AN = order_GA[AN];
-      wanA = WhatSpecies[GA_AN];
-      tnoA = Spe_Total_CNO[wanA];
-      Anum = MP[GA_AN];
-
-      for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	GB_AN = natn[GA_AN][LB_AN];
-	Rn = ncn[GA_AN][LB_AN];
-	wanB = WhatSpecies[GB_AN];
-	tnoB = Spe_Total_CNO[wanB];
-	Bnum = MP[GB_AN];
-
-	l1 = atv_ijk[Rn][1];
-	l2 = atv_ijk[Rn][2];
-	l3 = atv_ijk[Rn][3];
-	kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	si = sin(2.0*PI*kRn);
-	co = cos(2.0*PI*kRn);
-
-	for (i=0; i<tnoA; i++){
-
-	  for (j=0; j<tnoB; j++){
-
-	    H[Anum+i][Bnum+j].r += H1[k]*co;
-	    H[Anum+i][Bnum+j].i += H1[k]*si;
-
-	    k++;
-
-	  }
-
+	  Hs[j*na_rows+i].r = H[ig][jg].r;
+	  Hs[j*na_rows+i].i = H[ig][jg].i;
 	}
       }
     }
-    
-    /*---------- added by TOYODA 15/FEB/2010 */
-    if (5==XC_switch) {  
-
-#if 0
-      if (1<SCF_iter) { EXX_Debug_Check_DM(exx, exx_CDM, CDM); }
-#endif
-
-      EXX_Fock_Band(H, exx, exx_CDM, MP, k1, k2, k3, spin);
-    }
     /*---------- until here */
 
-    for(i=0;i<na_rows;i++){
-      for(j=0;j<na_cols;j++){
-	ig = np_rows*nblk*((i)/nblk) + (i)%nblk + ((np_rows+my_prow)%np_rows)*nblk + 1;
-	jg = np_cols*nblk*((j)/nblk) + (j)%nblk + ((np_cols+my_pcol)%np_cols)*nblk + 1;
-	Hs[j*na_rows+i].r = H[ig][jg].r;
-	Hs[j*na_rows+i].i = H[ig][jg].i;
-      }
+    else{
+      Bloch_Sum_BlockCyclic(&phase[kloop0*(TCpyCell+1)], order_GA, MP, H1, Hs, n,
+                            nblk, np_rows, np_cols, my_prow, my_pcol, na_rows, na_cols);
     }
 
-
     /* diagonalize S */
 
     dtime(&Stime);
@@ -1212,6 +1154,8 @@ diagonalize1:
 
   } /* kloop0 */
 
+  free(phase);
+
   dtime(&EiloopTime);
 
   if (SpinP_switch==1 && numprocs0==1 && spin==0){
@@ -1228,13 +1172,30 @@ diagonalize1:
   MPI_Barrier(mpi_comm_level1);
   dtime(&Stime);
 
-  for (spin=0; spin<=SpinP_switch; spin++){
-    for (kloop=0; kloop<T_knum; kloop++){
+  {
+    int num,*owner;
+    double **rows;
 
-      /* get ID in the zeroth world */
-      ID = Comm_World_StartID1[spin] + T_k_ID[spin][kloop];
-      MPI_Bcast(&EIGEN[spin][kloop][0], MaxN+1, MPI_DOUBLE, ID, mpi_comm_level1);
-    } 
+    owner = (int*)malloc(sizeof(int)*(SpinP_switch+1)*T_knum);
+    rows = (double**)malloc(sizeof(double*)*(SpinP_switch+1)*T_knum);
+
+    num = 0;
+    for (spin=0; spin<=SpinP_switch; spin++){
+      for (kloop=0; kloop<T_knum; kloop++){
+
+        /* get ID in the zeroth world */
+        owner[num] = Comm_World_StartID1[spin] + T_k_ID[spin][kloop];
+        rows[num] = EIGEN[spin][kloop];
+        num++;
+      } 
+    }
+
+    /* one MPI_Allgatherv for all the k-points */
+
+    Rows_Allgather_Double(rows, num, MaxN+1, owner);
+
+    free(rows);
+    free(owner);
   }
 
   dtime(&Etime);
@@ -1854,6 +1815,8 @@ diagonalize1:
 
     /* for kloop */
 
+    phase = Bloch_Sum_Phase(num_kloop0,&T_KGrids1[S_knum],&T_KGrids2[S_knum],&T_KGrids3[S_knum]);
+
     for (kloop0=0; kloop0<num_kloop0; kloop0++){
 
       kloop = kloop0 + S_knum;
@@ -1862,108 +1825,12 @@ diagonalize1:
       k2 = T_KGrids2[kloop];
       k3 = T_KGrids3[kloop];
 
-      /* make S and H */
+      /* make S and H directly in the block cyclic distribution */
 
-      for (i1=1; i1<=n; i1++){
-	for (j1=1; j1<=n; j1++){
-	  H[i1][j1] = Complex(0.0,0.0);
-	} 
-      } 
-
-      k = 0;
-      for (AN=1; AN<=atomnum; AN++){
-	GA_AN = order_GA[AN];
-	wanA = WhatSpecies[GA_AN];
-	tnoA = Spe_Total_CNO[wanA];
-	Anum = MP[GA_AN];
-
-	for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	  GB_AN = natn[GA_AN][LB_AN];
-	  Rn = ncn[GA_AN][LB_AN];
-	  wanB = WhatSpecies[GB_AN];
-	  tnoB = Spe_Total_CNO[wanB];
-	  Bnum = MP[GB_AN];
-
-	  l1 = atv_ijk[Rn][1];
-	  l2 = atv_ijk[Rn][2];
-	  l3 = atv_ijk[Rn][3];
-	  kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	  si = sin(2.0*PI*kRn);
-	  co = cos(2.0*PI*kRn);
-
-	  for (i=0; i<tnoA; i++){
-	    for (j=0; j<tnoB; j++){
-
-	      H[Anum+i][Bnum+j].r += S1[k]*co;
-	      H[Anum+i][Bnum+j].i += S1[k]*si;
-
-	      k++;
-
-	    }
-	  }
-	}
-      }
-
-      for(i=0;i<na_rows;i++){
-	for(j=0;j<na_cols;j++){
-	  ig = np_rows*nblk*((i)/nblk) + (i)%nblk + ((np_rows+my_prow)%np_rows)*nblk + 1;
-	  jg = np_cols*nblk*((j)/nblk) + (j)%nblk + ((np_cols+my_pcol)%np_cols)*nblk + 1;
-	  Cs[j*na_rows+i].r = H[ig][jg].r;
-	  Cs[j*na_rows+i].i = H[ig][jg].i;
-	}
-      }
-
-
-      for (i1=1; i1<=n; i1++){
-	for (j1=1; j1<=n; j1++){
-	  H[i1][j1] = Complex(0.0,0.0);
-	} 
-      } 
-
-      k = 0;
-      for (AN=1; AN<=atomnum; AN++){
-	GA_AN = order_GA[AN];
-	wanA = WhatSpecies[GA_AN];
-	tnoA = Spe_Total_CNO[wanA];
-	Anum = MP[GA_AN];
-
-	for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	  GB_AN = natn[GA_AN][LB_AN];
-	  Rn = ncn[GA_AN][LB_AN];
-	  wanB = WhatSpecies[GB_AN];
-	  tnoB = Spe_Total_CNO[wanB];
-	  Bnum = MP[GB_AN];
-
-	  l1 = atv_ijk[Rn][1];
-	  l2 = atv_ijk[Rn][2];
-	  l3 = atv_ijk[Rn][3];
-	  kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	  si = sin(2.0*PI*kRn);
-	  co = cos(2.0*PI*kRn);
-
-	  for (i=0; i<tnoA; i++){
-	    for (j=0; j<tnoB; j++){
-
-	      H[Anum+i][Bnum+j].r += H1[k]*co;
-	      H[Anum+i][Bnum+j].i += H1[k]*si;
-
-	      k++;
-
-	    }
-	  }
-	}
-      }
-
-      for(i=0;i<na_rows;i++){
-	for(j=0;j<na_cols;j++){
-	  ig = np_rows*nblk*((i)/nblk) + (i)%nblk + ((np_rows+my_prow)%np_rows)*nblk + 1;
-	  jg = np_cols*nblk*((j)/nblk) + (j)%nblk + ((np_cols+my_pcol)%np_cols)*nblk + 1;
-	  Hs[j*na_rows+i].r = H[ig][jg].r;
-	  Hs[j*na_rows+i].i = H[ig][jg].i;
-	}
-      }
+      Bloch_Sum_BlockCyclic(&phase[kloop0*(TCpyCell+1)], order_GA, MP, S1, Cs, n,
+                            nblk, np_rows, np_cols, my_prow, my_pcol, na_rows, na_cols);
+      Bloch_Sum_BlockCyclic(&phase[kloop0*(TCpyCell+1)], order_GA, MP, H1, Hs, n,
+                            nblk, np_rows, np_cols, my_prow, my_pcol, na_rows, na_cols);
 
       /* diagonalize S */
 
@@ -2460,6 +2327,8 @@ diagonalize1:
 
     } /* kloop0 */
 
+    free(phase);
+
     /*******************************************************
          sum of CDM1 and EDM1 by Allreduce in MPI
     *******************************************************/
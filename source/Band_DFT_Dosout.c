@@ -8,6 +8,7 @@
 
      12/May/2003  Released by H.Kino
      25/Dec/2003  a non-collinear part (added by T.Ozaki)
+     18/Oct/2026  on-the-fly DOS and PDOS by Dos.Accumulate
 
 ***********************************************************************/
 
@@ -3295,7 +3296,14 @@ static double Band_DFT_Dosout_Col(
                      eigenvalues and eigenvectors
    ****************************************************************/
 
-  if (myid==Host_ID){
+  fp_eig = NULL;
+  fp_ev = NULL;
+
+  if (Dos_Accum_Method!=0){
+    Dos_Accum_Init(n,SpinP_switch,knum_i,knum_j,knum_k);
+  }
+
+  if (myid==Host_ID && Dos_Dump){
 
     sprintf(file_eig,"%s%s.Dos.val",filepath,filename);
     if ( (fp_eig=fopen(file_eig,"w"))==NULL ) {
@@ -3312,12 +3320,15 @@ static double Band_DFT_Dosout_Col(
     }
   }
 
-  sprintf(file_ev,"%s%s.Dos.vec%d",filepath,filename,myid);
-  if ( (fp_ev=fopen(file_ev,"w"))==NULL ) {
-    printf("cannot open a file %s\n",file_ev);
-  }
-  if ( fp_ev==NULL ) {
-    goto Finishing;
+  if (Dos_Dump){
+
+    sprintf(file_ev,"%s%s.Dos.vec%d",filepath,filename,myid);
+    if ( (fp_ev=fopen(file_ev,"w"))==NULL ) {
+      printf("cannot open a file %s\n",file_ev);
+    }
+    if ( fp_ev==NULL ) {
+      goto Finishing;
+    }
   }
 
   if (myid==Host_ID){
@@ -3721,12 +3732,21 @@ static double Band_DFT_Dosout_Col(
                    writing a binary file 
 	  *********************************************/
 
-	  i_vec[0] = Ti_KGrids1[kloop];
-	  i_vec[1] = Tj_KGrids2[kloop];
-	  i_vec[2] = Tk_KGrids3[kloop];
+	  if (fp_ev){
 
-	  fwrite(i_vec,sizeof(int),3,fp_ev);
-	  fwrite(&SD[1],sizeof(float),n,fp_ev);
+	    i_vec[0] = Ti_KGrids1[kloop];
+	    i_vec[1] = Tj_KGrids2[kloop];
+	    i_vec[2] = Tk_KGrids3[kloop];
+
+	    fwrite(i_vec,sizeof(int),3,fp_ev);
+	    fwrite(&SD[1],sizeof(float),n,fp_ev);
+	  }
+
+	  /* on-the-fly DOS and PDOS */
+
+	  if (Dos_Accum_Method!=0){
+	    Dos_Accum_Add(spin,kloop,l,ko[spin][l],SD);
+	  }
 
 	} /* l */
       } /* spin */
@@ -3905,6 +3925,14 @@ static double Band_DFT_Dosout_Col(
     }
   }
 
+  /****************************************************
+     write: DOS and PDOS accumulated on the fly
+  ****************************************************/
+
+  if (Dos_Accum_Method!=0){
+    Dos_Accum_Output(EIGEN);
+  }
+
 Finishing: 
 
   if (myid==Host_ID){
@@ -3923,7 +3951,7 @@ Finishing:
 
   MPI_Barrier(mpi_comm_level1);
 
-  if (myid==Host_ID){
+  if (myid==Host_ID && Dos_Dump){
 
     sprintf(file_ev0,"%s%s.Dos.vec",filepath,filename);
     if ( (fp_ev0=fopen(file_ev0,"w"))==NULL ) {
@@ -3961,7 +3989,7 @@ Finishing:
   MPI_Barrier(mpi_comm_level1);
 
   /* delete files */
-  if (myid==Host_ID){
+  if (myid==Host_ID && Dos_Dump){
     for (ID=0; ID<numprocs; ID++){
       sprintf(file_ev,"%s%s.Dos.vec%d",filepath,filename,ID);
       remove(file_ev);
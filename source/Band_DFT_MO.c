@@ -7,6 +7,7 @@
   Log of Band_DFT_MO.c:
 
      15/May/2003  Released by T.Ozaki
+     18/Oct/2026  S and H of the collinear case made by Bloch_Sum_Col
 
 ***********************************************************************/
 
@@ -56,25 +57,24 @@ static void Band_DFT_MO_Col(
                       double *****nh,
                       double ****CntOLP)
 {
-  int i,j,k,l,n,wan;
+  int i,j,l,n,wan;
   int *MP,*order_GA,*My_NZeros,*SP_NZeros,*SP_Atoms;
   int i1,j1,po,spin,n1,size_H1;
-  int num2,RnB,l1,l2,l3,kloop;
-  int ct_AN,h_AN,wanA,tnoA,wanB,tnoB;
+  int num2,RnB,kloop;
+  int ct_AN,h_AN,wanA,tnoA;
   int GA_AN,Anum,nhomos,nlumos;
-  int ii,ij,ik,Rn,AN;
+  int ii,ij,ik;
   int num0,num1,mul,m,wan1,Gc_AN;
-  int LB_AN,GB_AN,Bnum;
   double time0,tmp,av_num;
   double snum_i,snum_j,snum_k,k1,k2,k3,sum,sumi,Num_State,FermiF;
   double x,Dnum,Dnum2,AcP,ChemP_MAX,ChemP_MIN,EV_cut0;
   double **ko,*M1,***EIGEN;
   double *koS;
   double *S1,**H1;
-  dcomplex ***H,**S,***C;
+  dcomplex ***H,**S,***C,*BS,*phase;
   dcomplex Ctmp1,Ctmp2;
   double u2,v2,uv,vu;
-  double dum,sumE,kRn,si,co;
+  double dum,sumE;
   double Resum,ResumE,Redum,Redum2,Imdum;
   double TStime,TEtime,SiloopTime,EiloopTime;
   double FermiEps = 1.0e-14;
@@ -146,6 +146,9 @@ static void Band_DFT_MO_Col(
 
   M1 = (double*)malloc(sizeof(double)*(n+1));
 
+  /* work array for Bloch_Sum_Col */
+  BS = (dcomplex*)malloc(sizeof(dcomplex)*n*n);
+
   C = (dcomplex***)malloc(sizeof(dcomplex**)*List_YOUSO[23]);
   for (i=0; i<List_YOUSO[23]; i++){
     C[i] = (dcomplex**)malloc(sizeof(dcomplex*)*(n+1));
@@ -228,46 +231,15 @@ static void Band_DFT_MO_Col(
 
     /* make S */
 
+    phase = Bloch_Sum_Phase(1,&k1,&k2,&k3);
+    Bloch_Sum_Col(phase, order_GA, MP, S1, BS, n);
+
     for (i1=1; i1<=n; i1++){
       for (j1=1; j1<=n; j1++){
-	S[i1][j1] = Complex(0.0,0.0);
+	S[i1][j1] = BS[(j1-1)*n+i1-1];
       } 
     } 
 
-    k = 0;
-    for (AN=1; AN<=atomnum; AN++){
-      GA_AN = order_GA[AN];
-      wanA = WhatSpecies[GA_AN];
-      tnoA = Spe_Total_CNO[wanA];
-      Anum = MP[GA_AN];
-
-      for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	GB_AN = natn[GA_AN][LB_AN];
-	Rn = ncn[GA_AN][LB_AN];
-	wanB = WhatSpecies[GB_AN];
-	tnoB = Spe_Total_CNO[wanB];
-	Bnum = MP[GB_AN];
-
-	l1 = atv_ijk[Rn][1];
-	l2 = atv_ijk[Rn][2];
-	l3 = atv_ijk[Rn][3];
-	kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	si = sin(2.0*PI*kRn);
-	co = cos(2.0*PI*kRn);
-
-	for (i=0; i<tnoA; i++){
-	  for (j=0; j<tnoB; j++){
-
-	    S[Anum+i][Bnum+j].r += S1[k]*co;
-	    S[Anum+i][Bnum+j].i += S1[k]*si;
-
-	    k++;
-	  }
-	}
-      }
-    }
-
     /* diagonalization of S */
     Eigen_PHH(mpi_comm_level1,S,koS,n,n,1);
 
@@ -303,48 +275,14 @@ static void Band_DFT_MO_Col(
 
       /* make H */
 
+      Bloch_Sum_Col(phase, order_GA, MP, H1[spin], BS, n);
+
       for (i1=1; i1<=n; i1++){
 	for (j1=1; j1<=n; j1++){
-	  H[spin][i1][j1] = Complex(0.0,0.0);
+	  H[spin][i1][j1] = BS[(j1-1)*n+i1-1];
 	} 
       } 
 
-      k = 0;
-      for (AN=1; AN<=atomnum; AN++){
-	GA_AN = order_GA[AN];
-	wanA = WhatSpecies[GA_AN];
-	tnoA = Spe_Total_CNO[wanA];
-	Anum = MP[GA_AN];
-
-	for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
-	  GB_AN = natn[GA_AN][LB_AN];
-	  Rn = ncn[GA_AN][LB_AN];
-	  wanB = WhatSpecies[GB_AN];
-	  tnoB = Spe_Total_CNO[wanB];
-	  Bnum = MP[GB_AN];
-
-	  l1 = atv_ijk[Rn][1];
-	  l2 = atv_ijk[Rn][2];
-	  l3 = atv_ijk[Rn][3];
-	  kRn = k1*(double)l1 + k2*(double)l2 + k3*(double)l3;
-
-	  si = sin(2.0*PI*kRn);
-	  co = cos(2.0*PI*kRn);
-
-	  for (i=0; i<tnoA; i++){
-
-	    for (j=0; j<tnoB; j++){
-
-	      H[spin][Anum+i][Bnum+j].r += H1[spin][k]*co;
-	      H[spin][Anum+i][Bnum+j].i += H1[spin][k]*si;
-
-	      k++;
-
-	    }
-	  }
-	}
-      }
-
       /* first transpose of S */
 
       for (i1=1; i1<=n; i1++){
@@ -784,6 +722,8 @@ static void Band_DFT_MO_Col(
       }
     } /* if (myid==Host_ID) */
 
+    free(phase);
+
   }  /* kloop */
 
   /****************************************************
@@ -832,6 +772,7 @@ static void Band_DFT_MO_Col(
   free(S);
 
   free(M1);
+  free(BS);
 
   for (i=0; i<List_YOUSO[23]; i++){
     for (j=0; j<n+1; j++){
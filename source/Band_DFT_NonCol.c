@@ -7,6 +7,7 @@
   Log of Band_DFT_NonCol.c:
 
      22/Nov/2001  Released by T.Ozaki
+     18/Oct/2026  EIGEN shared by Rows_Allgather_Double
 
 ***********************************************************************/
 
@@ -1375,10 +1376,9 @@ double Band_DFT_NonCol(int SCF_iter,
 
   dtime(&Stime);
 
-  for (kloop=0; kloop<T_knum; kloop++){
-    ID = T_k_ID[kloop];
-    MPI_Bcast(&EIGEN[kloop][0], MaxN+1, MPI_DOUBLE, ID, mpi_comm_level1);
-  } 
+  /* one MPI_Allgatherv for all the k-points */
+
+  Rows_Allgather_Double(EIGEN, T_knum, MaxN+1, T_k_ID);
 
   dtime(&Etime);
   time10 += Etime - Stime; 
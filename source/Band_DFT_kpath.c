@@ -12,6 +12,9 @@
 
      12/May/2003  Released by H.Kino
      25/Dec/2003  a non-collinear part (added by T.Ozaki)
+     18/Oct/2026  file.Band written during the calculation, and resumed
+                  by Band.restart
+     18/Oct/2026  S and H of the collinear case made by Bloch_Sum_Col
 
 ***********************************************************************/
 
@@ -41,6 +44,16 @@ static void Band_DFT_kpath_NonCol(
                       double *****ImNL,
                       double ****CntOLP);
 
+static FILE *Band_File_Open(int nkpath, int *n_perk,
+                            double ***kpath, char ***kname,
+                            int n, int spin_switch, int T_knum, int *K0);
+
+static unsigned long long Band_Path_Key(int nkpath, int *n_perk, double ***kpath);
+
+static void Band_File_Write(FILE *fp_Band, int *n_perk, double ***kpath,
+                            int *ik_list, int *i_perk_list, int *arpo,
+                            int numprocs, int n, int spinsize, double *Eall);
+
 void Band_DFT_kpath( int nkpath, int *n_perk,
                      double ***kpath, char ***kname, 
                      int  SpinP_switch, 
@@ -59,6 +72,118 @@ void Band_DFT_kpath( int nkpath, int *n_perk,
 }
 
 
+
+static FILE *Band_File_Open(int nkpath, int *n_perk,
+                            double ***kpath, char ***kname,
+                            int n, int spin_switch, int T_knum, int *K0)
+{
+  int i,j,myid;
+  char file_Band[YOUSO10];
+  char *exts[1] = {".Band"};
+#ifdef xt3
+  static char buf[fp_bsize];          /* setvbuf */
+#endif
+  FILE *fp_Band;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* the k-points already written in a previous run */
+
+  fp_Band = NULL;
+  *K0 = Kpath_Restart_Open(".Band_restart", T_knum, n, Band_Path_Key(nkpath,n_perk,kpath),
+                           1, exts, &fp_Band);
+
+  if (myid==Host_ID && *K0==0){
+
+    strcpy(file_Band,".Band");
+    fnjoint(filepath,filename,file_Band);  
+
+    if ((fp_Band = fopen(file_Band,"w"))==NULL) {
+      printf("<Band_DFT_kpath> can not open a file (%s)\n",file_Band);
+      return NULL;
+    }
+
+#ifdef xt3
+    setvbuf(fp_Band,buf,_IOFBF,fp_bsize);  /* setvbuf */
+#endif
+
+    fprintf(fp_Band," %d  %d  %18.15f\n",n,spin_switch,ChemP);
+    for (i=1;i<=3;i++) 
+      for (j=1;j<=3;j++) {
+	fprintf(fp_Band,"%18.15f ", rtv[i][j]);
+      }
+    fprintf(fp_Band,"\n");
+    fprintf(fp_Band,"%d\n",nkpath);
+    for (i=1;i<=nkpath;i++) {
+      fprintf(fp_Band,"%d %18.15f %18.15f %18.15f  %18.15f %18.15f %18.15f  %s %s\n",
+	      n_perk[i],
+	      kpath[i][1][1], kpath[i][1][2], kpath[i][1][3],
+	      kpath[i][2][1], kpath[i][2][2], kpath[i][2][3],
+	      kname[i][1],kname[i][2]);
+    }
+  }
+
+  return fp_Band;
+}
+
+
+static unsigned long long Band_Path_Key(int nkpath, int *n_perk, double ***kpath)
+{
+  int ik;
+  unsigned long long key;
+
+  key = 0;
+  for (ik=1; ik<=nkpath; ik++){
+    key = Kpath_Restart_Hash(key, &n_perk[ik], sizeof(int));
+    key = Kpath_Restart_Hash(key, &kpath[ik][1][1], sizeof(double)*3);
+    key = Kpath_Restart_Hash(key, &kpath[ik][2][1], sizeof(double)*3);
+  }
+
+  return key;
+}
+
+
+static void Band_File_Write(FILE *fp_Band, int *n_perk, double ***kpath,
+                            int *ik_list, int *i_perk_list, int *arpo,
+                            int numprocs, int n, int spinsize, double *Eall)
+{
+  int ID,kloop,ik,i_perk,id,spin,l;
+  double k1,k2,k3;
+
+  /* the k-points of arpo follow each other along the path */
+
+  for (ID=0; ID<numprocs; ID++){
+
+    kloop = arpo[ID];
+    if (kloop<0) continue;
+
+    ik     = ik_list[kloop];
+    i_perk = i_perk_list[kloop];
+
+    id=1;
+    k1 = kpath[ik][1][id]+
+      (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
+    id=2;
+    k2 = kpath[ik][1][id]+
+      (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
+    id=3;
+    k3 = kpath[ik][1][id]+
+      (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
+
+    for (spin=0; spin<spinsize; spin++){
+
+      fprintf(fp_Band,"%d %18.15f %18.15f %18.15f\n", n,k1,k2,k3);
+
+      for (l=0; l<n; l++) {
+	fprintf(fp_Band,"%18.15f ",Eall[((long int)ID*spinsize+spin)*n+l]);
+      }
+      fprintf(fp_Band  ,"\n");
+    }
+  }
+}
+
+
+
 void Band_DFT_kpath_Col( int nkpath, int *n_perk,
                          double ***kpath, char ***kname, 
                          int  SpinP_switch, 
@@ -69,33 +194,33 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
   static int firsttime=1;
   int i,j,k,l,n,wan;
   int *MP,*arpo,num_kloop0,T_knum;
+  int *order_GA,*My_NZeros,*SP_NZeros,*SP_Atoms,size_H1;
   int i1,j1,po,spin,spinsize,n1;
-  int num2,RnB,l1,l2,l3,S_knum,E_knum;
+  int num2,RnB,l1,l2,l3;
   int ct_AN,h_AN,wanA,tnoA,wanB,tnoB;
-  int GA_AN,Anum,ID,ID1,s1,e1,kloop,kloop0;
+  int GA_AN,Anum,kloop,kloop0;
   double time0;
   int LB_AN,GB_AN,Bnum;
   double snum_i,snum_j,snum_k,k1,k2,k3,sum,sumi,Num_State,FermiF;
   double x,Dnum,Dnum2,AcP,ChemP_MAX,ChemP_MIN,EV_cut0;
   double **ko,*M1;
   double *koS;
+  double *S1,**H1,tmp;
   double ****Dummy_ImNL;
-  dcomplex **H,**S,**C,**TmpM;
+  dcomplex **H,**S,**C,*BS,*phase;
   dcomplex Ctmp1,Ctmp2;
-  double ****EigenVal;
+  double *Ebuf,*Eall;
   int ii,ij,ik;
-  double u2,v2,uv,vu,tmp;
+  double u2,v2,uv,vu;
   double dum,sumE,kRn,si,co;
   double Resum,ResumE,Redum,Redum2,Imdum;
   double TStime,TEtime, SiloopTime,EiloopTime;
 
-  int numprocs,myid;
+  int numprocs,myid,K0;
   int *ik_list,*i_perk_list;
   int i_perk,id;
 
-  char file_Band[YOUSO10];
   FILE *fp_Band;
-  char buf[fp_bsize];          /* setvbuf */
 
   /* MPI */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -119,9 +244,14 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
    dcomplex  S[n+1][n+1]
    double    M1[n+1]
    dcomplex  C[n+1][n+1]
+   dcomplex  BS[n*n]
   ****************************************************/
 
   MP = (int*)malloc(sizeof(int)*List_YOUSO[1]);
+  order_GA = (int*)malloc(sizeof(int)*(List_YOUSO[1]+1));
+  My_NZeros = (int*)malloc(sizeof(int)*numprocs);
+  SP_NZeros = (int*)malloc(sizeof(int)*numprocs);
+  SP_Atoms = (int*)malloc(sizeof(int)*numprocs);
   
   n = 0;
   for (i=1; i<=atomnum; i++){
@@ -145,10 +275,7 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
     H[j] = (dcomplex*)malloc(sizeof(dcomplex)*(n+1));
   }
 
-  TmpM = (dcomplex**)malloc(sizeof(dcomplex*)*(n+1));
-  for (j=0; j<n+1; j++){
-    TmpM[j] = (dcomplex*)malloc(sizeof(dcomplex)*(n+1));
-  }
+  BS = (dcomplex*)malloc(sizeof(dcomplex)*n*n);
 
   S = (dcomplex**)malloc(sizeof(dcomplex*)*(n+1));
   for (i=0; i<n+1; i++){
@@ -162,19 +289,33 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
     C[j] = (dcomplex*)malloc(sizeof(dcomplex)*(n+1));
   }
 
+  /* all the elements of the overlap and Hamiltonian matrices
+     are stored in each process, so that S(k) and H(k) of the
+     k-point of myid are made without communication */
+
+  size_H1 = Get_OneD_HS_Col(0, CntOLP, &tmp, MP, order_GA, My_NZeros, SP_NZeros, SP_Atoms);
+
+  S1 = (double*)malloc(sizeof(double)*size_H1);
+  H1 = (double**)malloc(sizeof(double*)*(SpinP_switch+1));
+  for (spin=0; spin<=SpinP_switch; spin++){
+    H1[spin] = (double*)malloc(sizeof(double)*size_H1);
+  }
+
+  size_H1 = Get_OneD_HS_Col(1, CntOLP, S1, MP, order_GA, My_NZeros, SP_NZeros, SP_Atoms);
+  for (spin=0; spin<=SpinP_switch; spin++){
+    size_H1 = Get_OneD_HS_Col(1, nh[spin], H1[spin], MP, order_GA, My_NZeros, SP_NZeros, SP_Atoms);
+  }
+
   if      (SpinP_switch==0){ spinsize=1; }
   else if (SpinP_switch==1){ spinsize=2; }
   else if (SpinP_switch==3){ spinsize=1; } 
 
-  EigenVal = (double****)malloc(sizeof(double***)*(nkpath+1));
-  for (ik=0; ik<=nkpath; ik++) {
-    EigenVal[ik] = (double***)malloc(sizeof(double**)*(n_perk[ik]+1));
-    for (i_perk=0; i_perk<=n_perk[ik]; i_perk++) {
-      EigenVal[ik][i_perk] = (double**)malloc(sizeof(double*)*spinsize);
-      for (spin=0; spin<spinsize; spin++){
-        EigenVal[ik][i_perk][spin] = (double*)malloc(sizeof(double)*(n+2));
-      }
-    }
+  /* eigenvalues of a k-point of myid, and those of all the processes */
+
+  Ebuf = (double*)malloc(sizeof(double)*(spinsize*n+1));
+  Eall = NULL;
+  if (myid==Host_ID){
+    Eall = (double*)malloc(sizeof(double)*((long int)numprocs*spinsize*n+1));
   }
 
   /* no spin-orbit coupling */
@@ -226,26 +367,13 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
     }
   }
 
-  /* allocate k-points into proccessors */
+  /* allocate k-points into proccessors cyclically, so that the
+     k-points of each kloop0 follow each other along the path, and
+     are written as soon as they are calculated */
 
-  if (T_knum<=myid){
-    S_knum = -10;
-    E_knum = -100;
-    num_kloop0 = 1;
-  }
-  else if (T_knum<numprocs) {
-    S_knum = myid;
-    E_knum = myid;
-    num_kloop0 = 1;
-  }
-  else {
-    tmp = (double)T_knum/(double)numprocs; 
-    num_kloop0 = (int)tmp + 1;
-    S_knum = (int)((double)myid*(tmp+0.0001)); 
-    E_knum = (int)((double)(myid+1)*(tmp+0.0001)) - 1;
-    if (myid==(numprocs-1)) E_knum = T_knum - 1;
-    if (E_knum<0)           E_knum = 0;
-  }
+  fp_Band = Band_File_Open(nkpath,n_perk,kpath,kname,n,SpinP_switch,T_knum,&K0);
+
+  num_kloop0 = (T_knum - K0 + numprocs - 1)/numprocs;
 
   /*****************************************************
            calculate eigenvalues along k-paths
@@ -253,51 +381,37 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
 
   for (kloop0=0; kloop0<num_kloop0; kloop0++){
 
-    kloop = kloop0 + S_knum;
-    arpo[myid] = -1;
-    if (S_knum<=kloop && kloop<=E_knum) arpo[myid] = kloop;
-    for (ID=0; ID<numprocs; ID++){
-      MPI_Bcast(&arpo[ID], 1, MPI_INT, ID, mpi_comm_level1);
-    }
+    kloop = K0 + kloop0*numprocs + myid;
+    if (T_knum<=kloop) kloop = -1;
+    MPI_Allgather(&kloop, 1, MPI_INT, arpo, 1, MPI_INT, mpi_comm_level1);
 
     /* set S and diagonalize it */
-    
-    for (ID=0; ID<numprocs; ID++){
 
-      kloop = arpo[ID];
-
-      if (0<=kloop){
-
-        ik     = ik_list[kloop];
-        i_perk = i_perk_list[kloop];
+    kloop = arpo[myid];
 
-        id=1;
-        k1 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-        id=2;
-        k2 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-        id=3;
-        k3 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
+    if (0<=kloop) {
 
-        Overlap_Band(ID,CntOLP,TmpM,MP,k1,k2,k3);
-        n = TmpM[0][0].r;
+      ik     = ik_list[kloop];
+      i_perk = i_perk_list[kloop];
 
-        if (myid==ID){
-	  for (i1=1; i1<=n; i1++){
-	    for (j1=1; j1<=n; j1++){
-	      S[i1][j1].r = TmpM[i1][j1].r;
-	      S[i1][j1].i = TmpM[i1][j1].i;
-	    } 
-	  } 
-        } 
-      }
-    }
+      id=1;
+      k1 = kpath[ik][1][id]+
+        (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
+      id=2;
+      k2 = kpath[ik][1][id]+
+        (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
+      id=3;
+      k3 = kpath[ik][1][id]+
+        (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
 
-    kloop = arpo[myid];
+      phase = Bloch_Sum_Phase(1,&k1,&k2,&k3);
+      Bloch_Sum_Col(phase, order_GA, MP, S1, BS, n);
 
-    if (0<=kloop) {
+      for (i1=1; i1<=n; i1++){
+	for (j1=1; j1<=n; j1++){
+	  S[i1][j1] = BS[(j1-1)*n+i1-1];
+	} 
+      } 
 
       EigenBand_lapack(S,ko[0],n,n,1);
 
@@ -337,44 +451,17 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
 
     for (spin=0; spin<=SpinP_switch; spin++){
 
-      for (ID=0; ID<numprocs; ID++){
-
-        kloop = arpo[ID];
-
-        if (0<=kloop) {
-
-	  ik     = ik_list[kloop];
-	  i_perk = i_perk_list[kloop];
-
-	  id=1;
-	  k1 = kpath[ik][1][id]+
-	    (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-	  id=2;
-	  k2 = kpath[ik][1][id]+
-	    (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-	  id=3;
-	  k3 = kpath[ik][1][id]+
-	    (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-
-          Hamiltonian_Band(ID, nh[spin], TmpM, MP, k1, k2, k3);
-
-          if (myid==ID){
-	    for (i1=1; i1<=n; i1++){
-	      for (j1=1; j1<=n; j1++){
-	        H[i1][j1].r = TmpM[i1][j1].r;
-	        H[i1][j1].i = TmpM[i1][j1].i;
-	      } 
-	    } 
-          } 
-	} /* if (0<=kloop) */
-      } /* ID */
-
       kloop = arpo[myid];
 
       if (0<=kloop){
 
-        ik     = ik_list[kloop];
-	i_perk = i_perk_list[kloop];
+        Bloch_Sum_Col(phase, order_GA, MP, H1[spin], BS, n);
+
+	for (i1=1; i1<=n; i1++){
+	  for (j1=1; j1<=n; j1++){
+	    H[i1][j1] = BS[(j1-1)*n+i1-1];
+	  } 
+	} 
 
         /****************************************************
  	                 M1 * U^t * H * U * M1
@@ -535,119 +622,45 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
 	}
 
 	for (l=1; l<=n; l++){
-	  EigenVal[ik][i_perk][spin][l-1] = ko[spin][l];
+	  Ebuf[spin*n+l-1] = ko[spin][l];
 	}
 
       } /* if (0<=kloop) */
     } /* spin */
-  } /* kloop0 */
-
-  /****************************************************
-     MPI:
 
-     EigenVal
-  ****************************************************/
-
-  tmp = (double)T_knum/(double)numprocs; 
+    if (0<=arpo[myid]) free(phase);
 
-  for (spin=0; spin<=SpinP_switch; spin++){
-    for (kloop=0; kloop<T_knum; kloop++){
-
-      ik     = ik_list[kloop];
-      i_perk = i_perk_list[kloop];
+    /* write the eigenvalues of the k-points of kloop0 */
 
-      for (ID=0; ID<numprocs; ID++){
+    MPI_Gather(Ebuf, spinsize*n, MPI_DOUBLE, Eall, spinsize*n, MPI_DOUBLE, Host_ID, mpi_comm_level1);
 
-	if (T_knum<=ID){
-	  s1 = -10;
-	  e1 = -100;
-	}
-	else if (T_knum<numprocs) {
-	  s1 = ID;
-	  e1 = ID;
-	}
-	else {
-	  s1 = (int)((double)ID*(tmp+0.0001));
-          e1 = (int)((double)(ID+1)*(tmp+0.0001)) - 1;
-          if (ID==(numprocs-1)) e1 = T_knum - 1;
-          if (e1<0)             e1 = 0;
-	}
-        if (s1<=kloop && kloop<=e1)  ID1 = ID;
-      }
-
-      MPI_Bcast(&EigenVal[ik][i_perk][spin][0], n+1, MPI_DOUBLE, ID1, mpi_comm_level1);
-
-    } /* kloop */
-  } /* spin */
-
-  /****************************************************
-                    write a file 
-  ****************************************************/
-
-  if (myid==Host_ID) {
-
-    strcpy(file_Band,".Band");
-    fnjoint(filepath,filename,file_Band);  
-
-    if ((fp_Band = fopen(file_Band,"w"))==NULL) {
-
-#ifdef xt3
-      setvbuf(fp_Band,buf,_IOFBF,fp_bsize);  /* setvbuf */
-#endif
-
-      printf("<Band_DFT_kpath> can not open a file (%s)\n",file_Band);
-      return;
+    if (myid==Host_ID && fp_Band!=NULL){
+      Band_File_Write(fp_Band,n_perk,kpath,ik_list,i_perk_list,arpo,numprocs,n,spinsize,Eall);
+      kloop = K0 + (kloop0+1)*numprocs;
+      if (T_knum<kloop) kloop = T_knum;
+      Kpath_Restart_Save(".Band_restart", T_knum, n, Band_Path_Key(nkpath,n_perk,kpath),
+                         kloop, 1, &fp_Band);
     }
 
-    fprintf(fp_Band," %d  %d  %18.15f\n",n,SpinP_switch,ChemP);
-    for (i=1;i<=3;i++) 
-      for (j=1;j<=3;j++) {
-	fprintf(fp_Band,"%18.15f ", rtv[i][j]);
-      }
-    fprintf(fp_Band,"\n");
-    fprintf(fp_Band,"%d\n",nkpath);
-    for (i=1;i<=nkpath;i++) {
-      fprintf(fp_Band,"%d %18.15f %18.15f %18.15f  %18.15f %18.15f %18.15f  %s %s\n",
-	      n_perk[i],
-	      kpath[i][1][1], kpath[i][1][2], kpath[i][1][3],
-	      kpath[i][2][1], kpath[i][2][2], kpath[i][2][3],
-	      kname[i][1],kname[i][2]);
-    }
-
-    for (ik=1; ik<=nkpath; ik++) {
-      for (i_perk=1; i_perk<=n_perk[ik]; i_perk++) {
-
-        id=1;
-        k1 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-        id=2;
-        k2 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-        id=3;
-        k3 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-
-        for (spin=0; spin<=SpinP_switch; spin++){
-
-	  fprintf(fp_Band,"%d %18.15f %18.15f %18.15f\n", n,k1,k2,k3);
-
-	  for (l=0; l<n; l++) {
-	    fprintf(fp_Band,"%18.15f ",EigenVal[ik][i_perk][spin][l]);
-	  }
-	  fprintf(fp_Band  ,"\n");
-	}
-      }
-    }
+  } /* kloop0 */
 
-    fclose(fp_Band);
+  if (myid==Host_ID && fp_Band!=NULL) fclose(fp_Band);
 
-  } /* if (myid==Host_ID) */
-  
   /****************************************************
                        free arrays
   ****************************************************/
 
   free(MP);
+  free(order_GA);
+  free(My_NZeros);
+  free(SP_NZeros);
+  free(SP_Atoms);
+
+  free(S1);
+  for (spin=0; spin<=SpinP_switch; spin++){
+    free(H1[spin]);
+  }
+  free(H1);
 
   for (i=0; i<List_YOUSO[23]; i++){
     free(ko[i]);
@@ -661,10 +674,7 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
   }
   free(H);
 
-  for (j=0; j<n+1; j++){
-    free(TmpM[j]);
-  }
-  free(TmpM);
+  free(BS);
 
   for (i=0; i<n+1; i++){
     free(S[i]);
@@ -678,16 +688,8 @@ void Band_DFT_kpath_Col( int nkpath, int *n_perk,
   }
   free(C);
 
-  for (ik=0; ik<=nkpath; ik++) {
-    for (i_perk=0; i_perk<=n_perk[ik]; i_perk++) {
-      for (spin=0; spin<spinsize; spin++){
-        free(EigenVal[ik][i_perk][spin]);
-      }
-      free(EigenVal[ik][i_perk]);
-    }
-    free(EigenVal[ik]);
-  }
-  free(EigenVal);
+  free(Ebuf);
+  if (myid==Host_ID) free(Eall);
 
   /* no spin-orbit coupling */
   if (SO_switch==0){
@@ -734,21 +736,19 @@ void Band_DFT_kpath_NonCol( int nkpath, int *n_perk,
   double *****Dummy_ImNL;
   dcomplex **H,**S,**C,**TmpM;
   dcomplex Ctmp1,Ctmp2;
-  double ***EigenVal;
+  double *Ebuf,*Eall;
   int ii,ij,ik;
   int *ik_list,*i_perk_list,*arpo;
-  double u2,v2,uv,vu,tmp;
+  double u2,v2,uv,vu;
   double dum,sumE,kRn,si,co;
   double Resum,ResumE,Redum,Redum2,Imdum;
   double TStime,TEtime, SiloopTime,EiloopTime;
 
-  int numprocs,myid,ID,ID1;
-  int e1,s1,kloop,T_knum,mn,S_knum,E_knum;
+  int numprocs,myid,ID,K0;
+  int kloop,T_knum,mn;
   int num_kloop0,kloop0,spinsize; 
 
   int i_perk,id;
-  char buf[fp_bsize];          /* setvbuf */
-  char file_Band[YOUSO10];
   FILE *fp_Band;
 
   /* MPI */
@@ -826,12 +826,12 @@ void Band_DFT_kpath_NonCol( int nkpath, int *n_perk,
   printf("myid=%2d n2=%2d\n",myid,n2);
   */
 
-  EigenVal = (double***)malloc(sizeof(double**)*(nkpath+1));
-  for (ik=0; ik<=nkpath; ik++) {
-    EigenVal[ik] = (double**)malloc(sizeof(double*)*(n_perk[ik]+1));
-    for (i_perk=0; i_perk<=n_perk[ik]; i_perk++) {
-      EigenVal[ik][i_perk] = (double*)malloc(sizeof(double)*n2);
-    }
+  /* eigenvalues of a k-point of myid, and those of all the processes */
+
+  Ebuf = (double*)malloc(sizeof(double)*n2);
+  Eall = NULL;
+  if (myid==Host_ID){
+    Eall = (double*)malloc(sizeof(double)*((long int)numprocs*2*n+1));
   }
 
   /* non-spin-orbit coupling and non-LDA+U */
@@ -881,26 +881,13 @@ void Band_DFT_kpath_NonCol( int nkpath, int *n_perk,
     }
   }
 
-  /* allocate k-points into proccessors */
+  /* allocate k-points into proccessors cyclically, so that the
+     k-points of each kloop0 follow each other along the path, and
+     are written as soon as they are calculated */
 
-  if (T_knum<=myid){
-    S_knum = -10;
-    E_knum = -100;
-    num_kloop0 = 1;
-  }
-  else if (T_knum<numprocs) {
-    S_knum = myid;
-    E_knum = myid;
-    num_kloop0 = 1;
-  }
-  else {
-    tmp = (double)T_knum/(double)numprocs; 
-    num_kloop0 = (int)tmp + 1;
-    S_knum = (int)((double)myid*(tmp+0.0001)); 
-    E_knum = (int)((double)(myid+1)*(tmp+0.0001)) - 1;
-    if (myid==(numprocs-1)) E_knum = T_knum - 1;
-    if (E_knum<0)           E_knum = 0;
-  }
+  fp_Band = Band_File_Open(nkpath,n_perk,kpath,kname,2*n,0,T_knum,&K0);
+
+  num_kloop0 = (T_knum - K0 + numprocs - 1)/numprocs;
 
   /*****************************************************
            calculate eigenvalues along k-paths
@@ -908,12 +895,9 @@ void Band_DFT_kpath_NonCol( int nkpath, int *n_perk,
 
   for (kloop0=0; kloop0<num_kloop0; kloop0++){
 
-    kloop = kloop0 + S_knum;
-    arpo[myid] = -1;
-    if (S_knum<=kloop && kloop<=E_knum) arpo[myid] = kloop;
-    for (ID=0; ID<numprocs; ID++){
-      MPI_Bcast(&arpo[ID], 1, MPI_INT, ID, mpi_comm_level1);
-    }
+    kloop = K0 + kloop0*numprocs + myid;
+    if (T_knum<=kloop) kloop = -1;
+    MPI_Allgather(&kloop, 1, MPI_INT, arpo, 1, MPI_INT, mpi_comm_level1);
 
     /* set S and diagonalize it */
     
@@ -1157,107 +1141,26 @@ void Band_DFT_kpath_NonCol( int nkpath, int *n_perk,
       EigenBand_lapack(C,ko,n1,n1,0);
 
       for (l=1; l<=n1; l++){
-        EigenVal[ik][i_perk][l-1] = ko[l];
+        Ebuf[l-1] = ko[l];
       }
 
     } /* if (0<=kloop) */
-  } /* kloop0 */
 
-  /****************************************************
-     MPI:
+    /* write the eigenvalues of the k-points of kloop0 */
 
-     EigenVal
-  ****************************************************/
-
-  tmp = (double)T_knum/(double)numprocs; 
-
-  for (kloop=0; kloop<T_knum; kloop++){
+    MPI_Gather(Ebuf, 2*n, MPI_DOUBLE, Eall, 2*n, MPI_DOUBLE, Host_ID, mpi_comm_level1);
 
-    ik     = ik_list[kloop];
-    i_perk = i_perk_list[kloop];
-
-    for (ID=0; ID<numprocs; ID++){
-
-      if (T_knum<=ID){
-	s1 = -10;
-	e1 = -100;
-      }
-      else if (T_knum<numprocs) {
-	s1 = ID;
-	e1 = ID;
-      }
-      else {
-	s1 = (int)((double)ID*(tmp+0.0001));
-	e1 = (int)((double)(ID+1)*(tmp+0.0001)) - 1;
-	if (ID==(numprocs-1)) e1 = T_knum - 1;
-	if (e1<0)             e1 = 0;
-      }
-      if (s1<=kloop && kloop<=e1)  ID1 = ID;
+    if (myid==Host_ID && fp_Band!=NULL){
+      Band_File_Write(fp_Band,n_perk,kpath,ik_list,i_perk_list,arpo,numprocs,2*n,1,Eall);
+      kloop = K0 + (kloop0+1)*numprocs;
+      if (T_knum<kloop) kloop = T_knum;
+      Kpath_Restart_Save(".Band_restart", T_knum, 2*n, Band_Path_Key(nkpath,n_perk,kpath),
+                         kloop, 1, &fp_Band);
     }
 
-    MPI_Bcast(&EigenVal[ik][i_perk][0], 2*n+1, MPI_DOUBLE, ID1, mpi_comm_level1);
-
-  } /* kloop */
-
-  /****************************************************
-                    write a file 
-  ****************************************************/
-
-  if (myid==Host_ID) {
-
-    strcpy(file_Band,".Band");
-    fnjoint(filepath,filename,file_Band);  
-
-    if ((fp_Band = fopen(file_Band,"w"))==NULL) {
-
-#ifdef xt3
-      setvbuf(fp_Band,buf,_IOFBF,fp_bsize);  /* setvbuf */
-#endif
-
-      printf("<Band_DFT_kpath> can not open a file (%s)\n",file_Band);
-      return;
-    }
-
-    fprintf(fp_Band," %d  %d  %18.15f\n",2*n,0,ChemP);  /* set SpinP_switch==0 */
-    for (i=1;i<=3;i++) 
-      for (j=1;j<=3;j++) {
-	fprintf(fp_Band,"%18.15f ", rtv[i][j]);
-      }
-    fprintf(fp_Band,"\n");
-    fprintf(fp_Band,"%d\n",nkpath);
-    for (i=1;i<=nkpath;i++) {
-      fprintf(fp_Band,"%d %18.15f %18.15f %18.15f  %18.15f %18.15f %18.15f  %s %s\n",
-	      n_perk[i],
-	      kpath[i][1][1], kpath[i][1][2], kpath[i][1][3],
-	      kpath[i][2][1], kpath[i][2][2], kpath[i][2][3],
-	      kname[i][1],kname[i][2]);
-    }
-
-    for (ik=1; ik<=nkpath; ik++) {
-      for (i_perk=1; i_perk<=n_perk[ik]; i_perk++) {
-
-        id=1;
-        k1 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-        id=2;
-        k2 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-        id=3;
-        k3 = kpath[ik][1][id]+
-          (kpath[ik][2][id]-kpath[ik][1][id])*(i_perk-1)/(n_perk[ik]-1);
-
-	fprintf(fp_Band,"%d %18.15f %18.15f %18.15f\n", 2*n,k1,k2,k3);
-
-	for (l=0; l<2*n; l++) {
-	  fprintf(fp_Band,"%18.15f ",EigenVal[ik][i_perk][l]);
-	}
-	fprintf(fp_Band  ,"\n");
-      }
-    }
-
-    fclose(fp_Band);
+  } /* kloop0 */
 
-  } /* if (myid==Host_ID) */
+  if (myid==Host_ID && fp_Band!=NULL) fclose(fp_Band);
 
   /****************************************************
                        free arrays
@@ -1299,13 +1202,8 @@ void Band_DFT_kpath_NonCol( int nkpath, int *n_perk,
     free(Dummy_ImNL);
   }
 
-  for (ik=0; ik<=nkpath; ik++) {
-    for (i_perk=0; i_perk<=n_perk[ik]; i_perk++) {
-      free(EigenVal[ik][i_perk]);
-    }
-    free(EigenVal[ik]);
-  }
-  free(EigenVal);
+  free(Ebuf);
+  if (myid==Host_ID) free(Eall);
 
   free(ik_list);
   free(i_perk_list);
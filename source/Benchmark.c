@@ -0,0 +1,618 @@
+/**********************************************************************
+  Benchmark.c:
+
+     Benchmark.c is a subroutine to measure the performance of the
+     main computational kernels of OpenMX for synthetic systems whose
+     size can be scaled, and to measure strong and weak scaling with
+     respect to the number of OpenMP threads and MPI processes.
+
+     ./openmx -benchmark [size] -nt #
+
+     Diamond supercells consisting of (size*m) x size x size cubic
+     cells are generated in the directory 'benchmark_work', and SCF
+     calculations with the Band, DC and Krylov solvers are performed
+     for a few iterations. For each kernel, the elapsed time, the
+     achieved GFLOP/s and GB/s estimated by a simple operation and
+     traffic model are written to 'benchmark.result', and the same
+     data in a machine-readable format to 'benchmark.dat'.
+     If a file 'benchmark.ref', which is a copy of 'benchmark.dat'
+     made by another build, exists, slowdowns compared to the
+     reference are reported in 'benchmark.result'.
+
+  Log of Benchmark.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+/*  stat section */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+/*  end stat section */
+#include "openmx_common.h"
+#include "Inputtools.h"
+#include "mpi.h"
+#include <omp.h>
+
+#define Num_Bench_Workloads  3
+#define Bench_SCF_maxIter    4
+#define Bench_Tolerance      0.10  /* relative slowdown reported as a regression */
+
+static char *Bench_Kernel_Name[Num_Bench_Kernels] = {
+  "Set_Orbitals_Grid", "Set_Density_Grid", "Calc_MatrixElements",
+  "FFT_Poisson", "Set_XC_Grid", "Eigen_PHH", "Krylov", "DC" };
+
+static char *Bench_Workload[Num_Bench_Workloads] = { "Band", "DC", "Krylov" };
+
+typedef struct {
+  char workload[16];
+  char mode[16];
+  int procs,threads,atoms;
+  int calls[Num_Bench_Kernels];
+  double time[Num_Bench_Kernels];
+  double flops[Num_Bench_Kernels];
+  double bytes[Num_Bench_Kernels];
+  double DFT_time;
+} bench_type;
+
+static void Make_Bench_Input(char *fname_dat, char *sname, char *workload, int n1, int n2, int n3);
+static void run_bench(char *argv[], char *fname_dat, bench_type *res);
+static void Bench_Model(double *flops, double *bytes);
+static void Output_Bench(int Num_Res, bench_type *res, int size);
+static void Compare_Bench_Ref(FILE *fp, int Num_Res, bench_type *res);
+
+
+
+void Bench_Record(int kernel, double time0)
+{
+  Bench_Time[kernel] += time0;
+  Bench_Calls[kernel]++;
+}
+
+
+
+void Benchmark(int argc, char *argv[])
+{
+  int i,w,p,t,m,mode,size;
+  int numprocs,myid,color;
+  int threads_max,Num_Res,Max_Res;
+  char fname_dat[YOUSO10];
+  char sname[YOUSO10];
+  bench_type *res;
+  bench_type res1;
+  MPI_Comm comm1;
+
+  /* set up MPI */
+
+  MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+  MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+  size = 1;
+  if (3<=argc && argv[2][0]!='-') size = atoi(argv[2]);
+  if (size<1) size = 1;
+
+  threads_max = openmp_threads_num;
+  Runtest_flag = 1;
+
+  if (myid==Host_ID){
+
+    printf("\n*******************************************************\n");  fflush(stdout);
+    printf("*******************************************************\n");    fflush(stdout);
+    printf(" Welcome to OpenMX   Ver. %s                           \n",Version_OpenMX); fflush(stdout);
+    printf(" Copyright (C), 2002-2014, T.Ozaki                     \n");    fflush(stdout);
+    printf(" OpenMX comes with ABSOLUTELY NO WARRANTY.             \n");    fflush(stdout);
+    printf(" This is free software, and you are welcome to         \n");    fflush(stdout);
+    printf(" redistribute it under the constitution of the GNU-GPL.\n");    fflush(stdout);
+    printf("*******************************************************\n");    fflush(stdout);
+    printf("*******************************************************\n\n\n");fflush(stdout);
+
+    printf(" OpenMX is now in the mode to measure the performance of\n");
+    printf(" computational kernels for synthetic systems.\n");
+    printf(" size=%d, the maximum number of processes=%d and threads=%d\n\n",
+           size,numprocs,threads_max);
+    fflush(stdout);
+
+    mkdir("benchmark_work",0775);
+  }
+
+  /* the number of runs: 4 series with log2 steps for each workload */
+
+  Max_Res = 0;
+  for (p=1; p<=numprocs; p*=2)    Max_Res += 2;
+  for (t=1; t<=threads_max; t*=2) Max_Res += 2;
+  Max_Res *= Num_Bench_Workloads;
+
+  res = (bench_type*)malloc(sizeof(bench_type)*Max_Res);
+  Num_Res = 0;
+
+  /***********************************************************
+     mode 0: strong scaling over threads with one process
+     mode 1: weak scaling over threads with one process
+     mode 2: strong scaling over processes with one thread
+     mode 3: weak scaling over processes with one thread
+  ***********************************************************/
+
+  for (w=0; w<Num_Bench_Workloads; w++){
+    for (mode=0; mode<4; mode++){
+
+      if (mode<=1) m = threads_max;
+      else         m = numprocs;
+
+      for (i=1; i<=m; i*=2){
+
+        if (mode<=1){ p = 1; t = i; }
+        else        { p = i; t = 1; }
+
+        snprintf(sname,YOUSO10,"bench_%s_%s_p%d_t%d",Bench_Workload[w],
+                 (mode==0 || mode==2) ? "strong":"weak",p,t);
+        if (YOUSO10<=snprintf(fname_dat,YOUSO10,"benchmark_work/%s.dat",sname)) continue;
+
+        if (myid==Host_ID){
+          if (mode==0 || mode==2) Make_Bench_Input(fname_dat,sname,Bench_Workload[w],size,size,size);
+          else                    Make_Bench_Input(fname_dat,sname,Bench_Workload[w],size*i,size,size);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        /* make a communicator consisting of p processes */
+
+        if (myid<p) color = 0;
+        else        color = MPI_UNDEFINED;
+        MPI_Comm_split(MPI_COMM_WORLD, color, myid, &comm1);
+
+        if (myid<p){
+
+          MPI_COMM_WORLD1 = comm1;
+          mpi_comm_level1 = comm1;
+          NUMPROCS_MPI_COMM_WORLD = p;
+          MYID_MPI_COMM_WORLD = myid;
+          Num_Procs = p;
+
+          openmp_threads_num = t;
+          omp_set_num_threads(t);
+
+          run_bench(argv, fname_dat, &res1);
+
+          strcpy(res1.workload,Bench_Workload[w]);
+          strcpy(res1.mode,(mode==0 || mode==2) ? "strong":"weak");
+          res1.procs = p;
+          res1.threads = t;
+
+          MPI_Comm_free(&comm1);
+        }
+
+        /* restore the original communicator */
+
+        MPI_COMM_WORLD1 = MPI_COMM_WORLD;
+        mpi_comm_level1 = MPI_COMM_WORLD;
+        NUMPROCS_MPI_COMM_WORLD = numprocs;
+        MYID_MPI_COMM_WORLD = myid;
+        Num_Procs = numprocs;
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        if (myid==Host_ID){
+          res[Num_Res] = res1;
+          Num_Res++;
+          printf(" %-8s %-6s procs=%3d threads=%3d atoms=%5d  DFT time(s)=%10.3f\n",
+                 res1.workload,res1.mode,p,t,res1.atoms,res1.DFT_time);
+          fflush(stdout);
+        }
+      }
+    }
+  }
+
+  openmp_threads_num = threads_max;
+  omp_set_num_threads(threads_max);
+
+  /* output the results */
+
+  if (myid==Host_ID){
+    Output_Bench(Num_Res,res,size);
+    printf("\n\nThe results can be found in 'benchmark.result' and 'benchmark.dat'.\n\n");
+  }
+
+  free(res);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Finalize();
+  exit(0);
+}
+
+
+
+static void Make_Bench_Input(char *fname_dat, char *sname, char *workload, int n1, int n2, int n3)
+{
+  /* diamond structure in the conventional cubic cell */
+
+  static double frac[8][3] = {
+    {0.00,0.00,0.00}, {0.00,0.50,0.50}, {0.50,0.00,0.50}, {0.50,0.50,0.00},
+    {0.25,0.25,0.25}, {0.25,0.75,0.75}, {0.75,0.25,0.75}, {0.75,0.75,0.25} };
+  double a = 3.567;
+  int i,i1,i2,i3,num;
+  FILE *fp;
+
+  if ((fp = fopen(fname_dat,"w")) == NULL){
+    printf("could not save %s\n",fname_dat);
+    MPI_Abort(MPI_COMM_WORLD,1);
+  }
+
+  fprintf(fp,"System.CurrrentDirectory   ./benchmark_work/\n");
+  fprintf(fp,"System.Name                %s\n",sname);
+  fprintf(fp,"DATA.PATH                  ../DFT_DATA13\n");
+  fprintf(fp,"level.of.stdout            0\n");
+  fprintf(fp,"level.of.fileout           0\n\n");
+
+  fprintf(fp,"Species.Number             1\n");
+  fprintf(fp,"<Definition.of.Atomic.Species\n");
+  fprintf(fp,"  C   C6.0-s2p2d1   C_PBE13\n");
+  fprintf(fp,"Definition.of.Atomic.Species>\n\n");
+
+  fprintf(fp,"Atoms.Number               %d\n",8*n1*n2*n3);
+  fprintf(fp,"Atoms.SpeciesAndCoordinates.Unit   Ang\n");
+  fprintf(fp,"<Atoms.SpeciesAndCoordinates\n");
+
+  num = 0;
+  for (i1=0; i1<n1; i1++){
+    for (i2=0; i2<n2; i2++){
+      for (i3=0; i3<n3; i3++){
+        for (i=0; i<8; i++){
+          num++;
+          fprintf(fp," %5d  C  %12.7f %12.7f %12.7f   2.0  2.0\n",num,
+                  a*((double)i1+frac[i][0]),
+                  a*((double)i2+frac[i][1]),
+                  a*((double)i3+frac[i][2]));
+        }
+      }
+    }
+  }
+
+  fprintf(fp,"Atoms.SpeciesAndCoordinates>\n");
+  fprintf(fp,"Atoms.UnitVectors.Unit     Ang\n");
+  fprintf(fp,"<Atoms.UnitVectors\n");
+  fprintf(fp,"  %12.7f   0.0000000   0.0000000\n",a*(double)n1);
+  fprintf(fp,"   0.0000000  %12.7f   0.0000000\n",a*(double)n2);
+  fprintf(fp,"   0.0000000   0.0000000  %12.7f\n",a*(double)n3);
+  fprintf(fp,"Atoms.UnitVectors>\n\n");
+
+  fprintf(fp,"scf.XcType                 GGA-PBE\n");
+  fprintf(fp,"scf.SpinPolarization      off\n");
+  fprintf(fp,"scf.ElectronicTemperature  300.0\n");
+  fprintf(fp,"scf.energycutoff           150.0\n");
+  fprintf(fp,"scf.maxIter                %d\n",Bench_SCF_maxIter);
+  fprintf(fp,"scf.EigenvalueSolver       %s\n",workload);
+  fprintf(fp,"scf.Kgrid                  1 1 1\n");
+  fprintf(fp,"scf.Mixing.Type            RMM-DIIS\n");
+  fprintf(fp,"scf.criterion              1.0e-12\n\n");
+
+  fprintf(fp,"orderN.HoppingRanges       4.0\n");
+  fprintf(fp,"orderN.KrylovH.order       100\n\n");
+
+  fprintf(fp,"MD.Type                    NOMD\n");
+  fprintf(fp,"MD.maxIter                 1\n");
+
+  fclose(fp);
+}
+
+
+
+static void run_bench(char *argv[], char *fname_dat, bench_type *res)
+{
+  int i,j,k,numprocs,myid;
+  double flops[Num_Bench_Kernels],bytes[Num_Bench_Kernels];
+  double time1[Num_Bench_Kernels],DFT_time;
+  int calls[Num_Bench_Kernels];
+  char fileMemory[YOUSO10];
+
+  MPI_Comm_size(MPI_COMM_WORLD1,&numprocs);
+  MPI_Comm_rank(MPI_COMM_WORLD1,&myid);
+
+  /* allocation of CompTime */
+
+  CompTime = (double**)malloc(sizeof(double*)*numprocs);
+  for (i=0; i<numprocs; i++){
+    CompTime[i] = (double*)malloc(sizeof(double)*30);
+    for (j=0; j<30; j++) CompTime[i][j] = 0.0;
+  }
+
+  /* initialize the kernel timers */
+
+  for (k=0; k<Num_Bench_Kernels; k++){
+    Bench_Time[k] = 0.0;
+    Bench_Calls[k] = 0;
+  }
+
+  Init_List_YOUSO();
+  remake_headfile = 0;
+  ScaleSize = 1.2;
+
+  argv[1] = fname_dat;
+  init_alloc_first();
+  CompTime[myid][1] = readfile(argv);
+  MPI_Barrier(MPI_COMM_WORLD1);
+
+  if (YOUSO10<=snprintf(fileMemory,YOUSO10,"%s%s.memory%i",filepath,filename,myid)){
+    snprintf(fileMemory,YOUSO10,"bench.memory%i",myid);
+  }
+  PrintMemory(fileMemory,0,"init");
+  PrintMemory_Fix();
+
+  init();
+
+  /* only the SCF calculation is timed */
+
+  Bench_flag = 1;
+  CompTime[myid][2] += truncation(1,1);
+  DFT_time = DFT(1,1);
+  Bench_flag = 0;
+
+  /* the operation and traffic model for the current system */
+
+  Bench_Model(flops,bytes);
+
+  MPI_Allreduce(Bench_Time, time1, Num_Bench_Kernels, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD1);
+  MPI_Allreduce(Bench_Calls, calls, Num_Bench_Kernels, MPI_INT, MPI_MAX, MPI_COMM_WORLD1);
+  MPI_Allreduce(&DFT_time, &res->DFT_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD1);
+  MPI_Allreduce(flops, res->flops, Num_Bench_Kernels, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD1);
+  MPI_Allreduce(bytes, res->bytes, Num_Bench_Kernels, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD1);
+
+  /* Eigen_PHH is called collectively, so that its model is not summed */
+
+  res->flops[Bench_Eigen_PHH] = flops[Bench_Eigen_PHH];
+  res->bytes[Bench_Eigen_PHH] = bytes[Bench_Eigen_PHH];
+
+  for (k=0; k<Num_Bench_Kernels; k++){
+    res->time[k]   = time1[k];
+    res->calls[k]  = calls[k];
+    res->flops[k] *= (double)calls[k];
+    res->bytes[k] *= (double)calls[k];
+  }
+  res->atoms = atomnum;
+
+  /* freeing of arrays */
+
+  for (i=0; i<numprocs; i++){
+    free(CompTime[i]);
+  }
+  free(CompTime);
+
+  Free_Arrays(0);
+  PrintMemory("total",0,"sum");
+}
+
+
+
+static void Bench_Model(double *flops, double *bytes)
+{
+  /****************************************************
+     operation counts and memory traffic per call of
+     each kernel on this process. the models count the
+     dominant loops only, and the results are meant to
+     be compared between builds rather than taken as
+     absolute hardware counters.
+  ****************************************************/
+
+  int k,Mc_AN,Gc_AN,h_AN,Gh_AN,wan,hwan,i,Gi;
+  int spinN,NOi,NOj,NOLG,numprocs,myid;
+  double n,N,Msize,m;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  for (k=0; k<Num_Bench_Kernels; k++){
+    flops[k] = 0.0;
+    bytes[k] = 0.0;
+  }
+
+  if (SpinP_switch==0) spinN = 1;
+  else                 spinN = 2;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+    Gc_AN = M2G[Mc_AN];
+    wan = WhatSpecies[Gc_AN];
+    NOi = Spe_Total_NO[wan];
+
+    /* radial interpolation and real spherical harmonics */
+
+    n = (double)GridN_Atom[Gc_AN];
+    flops[Bench_Orbitals_Grid] += n*(60.0 + 20.0*(double)NOi);
+    bytes[Bench_Orbitals_Grid] += n*((double)NOi*sizeof(Type_Orbs_Grid) + 3.0*sizeof(double));
+
+    /* contraction of orbital pairs on the overlapping grids */
+
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      hwan = WhatSpecies[Gh_AN];
+      NOj = Spe_Total_NO[hwan];
+      NOLG = NumOLG[Mc_AN][h_AN];
+
+      flops[Bench_Density_Grid] += 2.0*(double)(NOLG*spinN)*(double)(NOi*NOj + NOi);
+      bytes[Bench_Density_Grid] += (double)NOLG*((double)(NOi+NOj)*sizeof(Type_Orbs_Grid)
+                                                 + (double)spinN*sizeof(double));
+
+      flops[Bench_MatrixElements] += 2.0*(double)(NOLG*spinN)*(double)(NOi*NOj + NOj);
+      bytes[Bench_MatrixElements] += (double)NOLG*((double)(NOi+NOj)*sizeof(Type_Orbs_Grid)
+                                                   + (double)spinN*sizeof(double));
+    }
+
+    /* the dimension of the cluster used in DC and Krylov */
+
+    Msize = 0.0;
+    for (i=0; i<=(FNAN[Gc_AN]+SNAN[Gc_AN]); i++){
+      Gi = natn[Gc_AN][i];
+      Msize += (double)Spe_Total_CNO[WhatSpecies[Gi]];
+    }
+
+    flops[Bench_DC] += (double)spinN*10.0*Msize*Msize*Msize;
+    bytes[Bench_DC] += (double)spinN*3.0*Msize*Msize*sizeof(double);
+
+    m = (double)KrylovH_order;
+    if (Msize<m) m = Msize;
+    flops[Bench_Krylov] += (double)spinN*(2.0*Msize*Msize*m + 10.0*m*m*m);
+    bytes[Bench_Krylov] += (double)spinN*(2.0*Msize*Msize + 2.0*Msize*m)*sizeof(double);
+  }
+
+  /* forward and inverse 3D-FFT and the transposes */
+
+  N = (double)Ngrid1*(double)Ngrid2*(double)Ngrid3;
+  flops[Bench_Poisson] = 2.0*5.0*N*log(N)/log(2.0)/(double)numprocs;
+  bytes[Bench_Poisson] = 4.0*2.0*2.0*sizeof(double)*N/(double)numprocs;
+
+  /* exchange-correlation on the partition D */
+
+  n = (double)My_NumGridD;
+  if (XC_switch==4){
+    flops[Bench_XC_Grid] = n*(500.0 + 50.0*(double)spinN);
+    bytes[Bench_XC_Grid] = n*(double)spinN*(2.0 + 12.0)*sizeof(double);
+  }
+  else{
+    flops[Bench_XC_Grid] = n*60.0;
+    bytes[Bench_XC_Grid] = n*(double)spinN*2.0*sizeof(double);
+  }
+
+  /* dense Hermitian eigenproblem with eigenvectors */
+
+  n = 0.0;
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    n += (double)Spe_Total_CNO[WhatSpecies[Gc_AN]];
+  }
+  flops[Bench_Eigen_PHH] = (16.0/3.0 + 8.0)*n*n*n;
+  bytes[Bench_Eigen_PHH] = 3.0*n*n*2.0*sizeof(double);
+}
+
+
+
+static void Output_Bench(int Num_Res, bench_type *res, int size)
+{
+  int r,r0,k;
+  double gflops,gbytes,eff,time0;
+  FILE *fp,*fp1;
+
+  if ( (fp = fopen("benchmark.result","w")) == NULL ||
+       (fp1 = fopen("benchmark.dat","w")) == NULL ){
+    printf("could not save the results of the benchmark.\n");
+    return;
+  }
+
+  fprintf(fp,"\n");
+  fprintf(fp,"***********************************************************\n");
+  fprintf(fp,"***********************************************************\n");
+  fprintf(fp,"             Benchmark of computational kernels            \n");
+  fprintf(fp,"***********************************************************\n");
+  fprintf(fp,"***********************************************************\n\n");
+  fprintf(fp,"  OpenMX Ver. %s   size=%d\n\n",Version_OpenMX,size);
+
+  fprintf(fp1,"# OpenMX Ver. %s benchmark, size=%d\n",Version_OpenMX,size);
+  fprintf(fp1,"# workload mode procs threads atoms kernel calls time(s) GFLOP/s GB/s\n");
+
+  for (r=0; r<Num_Res; r++){
+
+    fprintf(fp,"  %s  %s  procs=%d  threads=%d  atoms=%d  DFT time(s)=%10.3f\n",
+            res[r].workload,res[r].mode,res[r].procs,res[r].threads,
+            res[r].atoms,res[r].DFT_time);
+    fprintf(fp,"    %-22s %6s %12s %10s %10s\n","kernel","calls","time(s)","GFLOP/s","GB/s");
+
+    for (k=0; k<Num_Bench_Kernels; k++){
+
+      if (res[r].calls[k]==0) continue;
+
+      if (1.0e-12<res[r].time[k]){
+        gflops = res[r].flops[k]/res[r].time[k]*1.0e-9;
+        gbytes = res[r].bytes[k]/res[r].time[k]*1.0e-9;
+      }
+      else{
+        gflops = 0.0;
+        gbytes = 0.0;
+      }
+
+      fprintf(fp,"    %-22s %6d %12.5f %10.3f %10.3f\n",
+              Bench_Kernel_Name[k],res[r].calls[k],res[r].time[k],gflops,gbytes);
+
+      fprintf(fp1,"%s %s %d %d %d %s %d %.6e %.6e %.6e\n",
+              res[r].workload,res[r].mode,res[r].procs,res[r].threads,res[r].atoms,
+              Bench_Kernel_Name[k],res[r].calls[k],res[r].time[k],gflops,gbytes);
+    }
+    fprintf(fp,"\n");
+  }
+
+  /* parallel efficiency relative to the first run of each series */
+
+  fprintf(fp,"\n  Parallel efficiency of the SCF (DFT time)\n\n");
+  fprintf(fp,"    %-8s %-6s %6s %8s %12s %10s\n","workload","mode","procs","threads","time(s)","efficiency");
+
+  r0 = 0;
+  for (r=0; r<Num_Res; r++){
+
+    if ( r==0
+         || strcmp(res[r].workload,res[r-1].workload)!=0
+         || strcmp(res[r].mode,res[r-1].mode)!=0
+         || (res[r].procs==1 && res[r].threads==1) ){
+      r0 = r;
+    }
+
+    time0 = res[r].DFT_time;
+    if (strcmp(res[r].mode,"strong")==0)
+      eff = res[r0].DFT_time/(time0*(double)(res[r].procs*res[r].threads));
+    else
+      eff = res[r0].DFT_time/time0;
+
+    fprintf(fp,"    %-8s %-6s %6d %8d %12.4f %10.3f\n",
+            res[r].workload,res[r].mode,res[r].procs,res[r].threads,time0,eff);
+  }
+
+  Compare_Bench_Ref(fp,Num_Res,res);
+
+  fclose(fp);
+  fclose(fp1);
+}
+
+
+
+static void Compare_Bench_Ref(FILE *fp, int Num_Res, bench_type *res)
+{
+  int r,k,procs,threads,atoms,calls,num;
+  double time0,gflops,gbytes;
+  char workload[YOUSO10],mode[YOUSO10],kernel[YOUSO10],buf[YOUSO10];
+  FILE *fp0;
+
+  if ((fp0 = fopen("benchmark.ref","r")) == NULL) return;
+
+  fprintf(fp,"\n\n  Comparison with benchmark.ref (slowdown larger than %.0f%%)\n\n",
+          100.0*Bench_Tolerance);
+
+  num = 0;
+
+  while (fgets(buf,YOUSO10,fp0)!=NULL){
+
+    if (buf[0]=='#') continue;
+    if (sscanf(buf,"%s %s %d %d %d %s %d %lf %lf %lf",
+               workload,mode,&procs,&threads,&atoms,kernel,
+               &calls,&time0,&gflops,&gbytes)!=10) continue;
+
+    for (r=0; r<Num_Res; r++){
+
+      if ( strcmp(res[r].workload,workload)!=0 || strcmp(res[r].mode,mode)!=0
+           || res[r].procs!=procs || res[r].threads!=threads || res[r].atoms!=atoms ) continue;
+
+      for (k=0; k<Num_Bench_Kernels; k++){
+        if ( strcmp(Bench_Kernel_Name[k],kernel)==0 && 0<res[r].calls[k] && 1.0e-12<time0
+             && (1.0+Bench_Tolerance)*time0<res[r].time[k] ){
+
+          fprintf(fp,"    %-8s %-6s procs=%3d threads=%3d %-22s %10.5f -> %10.5f (%+6.1f%%)\n",
+                  workload,mode,procs,threads,kernel,time0,res[r].time[k],
+                  100.0*(res[r].time[k]-time0)/time0);
+          num++;
+        }
+      }
+    }
+  }
+
+  if (num==0) fprintf(fp,"    no regression was found.\n");
+
+  fclose(fp0);
+}
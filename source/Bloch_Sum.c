@@ -0,0 +1,238 @@
+/**********************************************************************
+  Bloch_Sum.c:
+
+     Bloch_Sum.c is a set of subroutines to construct the Bloch sums
+     of the one-dimensionalized Hamiltonian and overlap matrices given
+     by Get_OneD_HS_Col, i.e., A(k) = sum_R A(R) exp(i 2pi k*R).
+
+     Bloch_Sum_Phase:        phase factors exp(i 2pi k*R) of the cells
+                             R=0..TCpyCell for a set of k-points
+     Bloch_Sum_Col:          A(k) stored in column major order, as used
+                             by LAPACK and BLAS
+     Bloch_Sum_BlockCyclic:  the local part of A(k) in the 2D block
+                             cyclic distribution used by ScaLAPACK
+
+     The phases are computed once per cell instead of once per pair
+     of atoms.
+
+  Log of Bloch_Sum.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "mpi.h"
+#include <omp.h>
+
+static long int *BS_Offsets(int *order_GA);
+
+
+
+static long int *BS_Offsets(int *order_GA)
+{
+  int AN,GA_AN,LB_AN,tnoA,sum;
+  long int *off;
+
+  /* the first position of the blocks of order_GA[AN] in the
+     one-dimensionalized array, so that the atoms can be
+     distributed over the threads */
+
+  off = (long int*)malloc(sizeof(long int)*(atomnum+2));
+
+  off[1] = 0;
+  for (AN=1; AN<=atomnum; AN++){
+    GA_AN = order_GA[AN];
+    tnoA = Spe_Total_CNO[WhatSpecies[GA_AN]];
+    sum = 0;
+    for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
+      sum += Spe_Total_CNO[WhatSpecies[natn[GA_AN][LB_AN]]];
+    }
+    off[AN+1] = off[AN] + (long int)tnoA*sum;
+  }
+
+  return off;
+}
+
+
+dcomplex *Bloch_Sum_Phase(int nk, double *k1, double *k2, double *k3)
+{
+  int ik,Rn;
+  double kRn;
+  dcomplex *phase;
+
+  /* phase[ik*(TCpyCell+1)+Rn] */
+
+  phase = (dcomplex*)malloc(sizeof(dcomplex)*((long int)nk*(TCpyCell+1)));
+
+  for (ik=0; ik<nk; ik++){
+    for (Rn=0; Rn<=TCpyCell; Rn++){
+      kRn = k1[ik]*(double)atv_ijk[Rn][1]
+          + k2[ik]*(double)atv_ijk[Rn][2]
+          + k3[ik]*(double)atv_ijk[Rn][3];
+      phase[(long int)ik*(TCpyCell+1)+Rn].r = cos(2.0*PI*kRn);
+      phase[(long int)ik*(TCpyCell+1)+Rn].i = sin(2.0*PI*kRn);
+    }
+  }
+
+  return phase;
+}
+
+
+void Bloch_Sum_Col(dcomplex *phase, int *order_GA, int *MP,
+                   double *A1, dcomplex *Ak, int n)
+{
+  long int nn,*off;
+
+  /* Ak[(j-1)*n+i-1] = A(k)[i][j] for i,j=1..n, where phase
+     is a k-point of Bloch_Sum_Phase */
+
+  nn = (long int)n*n;
+  off = BS_Offsets(order_GA);
+
+#pragma omp parallel shared(phase,order_GA,MP,A1,Ak,n,nn,off,atomnum,FNAN,natn,ncn,WhatSpecies,Spe_Total_CNO)
+  {
+    int OMPID,Nthrds,AN,GA_AN,LB_AN,GB_AN,Rn;
+    int tnoA,tnoB,Anum,Bnum,i,j;
+    long int k,p,ps,pe;
+    double a;
+    dcomplex ph,*col;
+
+    OMPID = omp_get_thread_num();
+    Nthrds = omp_get_num_threads();
+
+    ps = OMPID*nn/Nthrds;
+    pe = (OMPID+1)*nn/Nthrds;
+    for (p=ps; p<pe; p++) Ak[p] = Complex(0.0,0.0);
+
+#pragma omp barrier
+
+    /* the rows of GA_AN are updated only by the thread having AN */
+
+    for (AN=1+OMPID; AN<=atomnum; AN+=Nthrds){
+
+      GA_AN = order_GA[AN];
+      tnoA = Spe_Total_CNO[WhatSpecies[GA_AN]];
+      Anum = MP[GA_AN];
+      k = off[AN];
+
+      for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
+
+	GB_AN = natn[GA_AN][LB_AN];
+	Rn = ncn[GA_AN][LB_AN];
+	tnoB = Spe_Total_CNO[WhatSpecies[GB_AN]];
+	Bnum = MP[GB_AN];
+
+	ph = phase[Rn];
+
+	/* the block is stored as A1[k+i*tnoB+j], and a column of Ak
+	   is contiguous in i */
+
+	for (j=0; j<tnoB; j++){
+	  col = &Ak[(long int)(Bnum+j-1)*n + Anum - 1];
+	  for (i=0; i<tnoA; i++){
+	    a = A1[k+i*tnoB+j];
+	    col[i].r += a*ph.r;
+	    col[i].i += a*ph.i;
+	  }
+	}
+
+	k += (long int)tnoA*tnoB;
+      }
+    }
+
+  } /* #pragma omp parallel */
+
+  free(off);
+}
+
+
+void Bloch_Sum_BlockCyclic(dcomplex *phase, int *order_GA, int *MP,
+                           double *A1, dcomplex *As, int n,
+                           int nblk, int np_rows, int np_cols,
+                           int my_prow, int my_pcol,
+                           int na_rows, int na_cols)
+{
+  int g,b;
+  int *lrow,*lcol;
+  long int *off;
+
+  /* local indices of the global rows and columns, -1 if not owned.
+     the inverse of ig = np_rows*nblk*(i/nblk) + i%nblk + my_prow*nblk + 1 */
+
+  lrow = (int*)malloc(sizeof(int)*(n+1));
+  lcol = (int*)malloc(sizeof(int)*(n+1));
+
+  for (g=1; g<=n; g++){
+    b = (g-1)/nblk;
+    if (b%np_rows==my_prow) lrow[g] = (b/np_rows)*nblk + (g-1)%nblk;
+    else                    lrow[g] = -1;
+    if (b%np_cols==my_pcol) lcol[g] = (b/np_cols)*nblk + (g-1)%nblk;
+    else                    lcol[g] = -1;
+  }
+
+  off = BS_Offsets(order_GA);
+
+#pragma omp parallel shared(phase,order_GA,MP,A1,As,na_rows,na_cols,lrow,lcol,off,atomnum,FNAN,natn,ncn,WhatSpecies,Spe_Total_CNO)
+  {
+    int OMPID,Nthrds,AN,GA_AN,LB_AN,GB_AN,Rn;
+    int tnoA,tnoB,Anum,Bnum,i,j,il,jl;
+    long int k,p,ps,pe,nl;
+    double a;
+    dcomplex ph;
+
+    OMPID = omp_get_thread_num();
+    Nthrds = omp_get_num_threads();
+
+    nl = (long int)na_rows*na_cols;
+    ps = OMPID*nl/Nthrds;
+    pe = (OMPID+1)*nl/Nthrds;
+    for (p=ps; p<pe; p++) As[p] = Complex(0.0,0.0);
+
+#pragma omp barrier
+
+    for (AN=1+OMPID; AN<=atomnum; AN+=Nthrds){
+
+      GA_AN = order_GA[AN];
+      tnoA = Spe_Total_CNO[WhatSpecies[GA_AN]];
+      Anum = MP[GA_AN];
+      k = off[AN];
+
+      for (LB_AN=0; LB_AN<=FNAN[GA_AN]; LB_AN++){
+
+	GB_AN = natn[GA_AN][LB_AN];
+	Rn = ncn[GA_AN][LB_AN];
+	tnoB = Spe_Total_CNO[WhatSpecies[GB_AN]];
+	Bnum = MP[GB_AN];
+	ph = phase[Rn];
+
+	for (j=0; j<tnoB; j++){
+
+	  jl = lcol[Bnum+j];
+	  if (jl<0) continue;
+
+	  for (i=0; i<tnoA; i++){
+
+	    il = lrow[Anum+i];
+	    if (il<0) continue;
+
+	    a = A1[k+i*tnoB+j];
+	    As[(long int)jl*na_rows+il].r += a*ph.r;
+	    As[(long int)jl*na_rows+il].i += a*ph.i;
+	  }
+	}
+
+	k += (long int)tnoA*tnoB;
+      }
+    }
+
+  } /* #pragma omp parallel */
+
+  free(off);
+  free(lcol);
+  free(lrow);
+}
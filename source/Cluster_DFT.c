@@ -713,10 +713,22 @@ static double Cluster_collinear(
   */
 
 
-  if (numprocs1<n && 1<numprocs1)
-    Eigen_PReHH(MPI_CommWD1[myworld1],C[spin],ko[spin],n,MaxN,bcast_flag);
-  else 
-    Eigen_lapack(C[spin],ko[spin],n,n);
+  /* warm-started subspace iteration, which falls back to
+     the dense diagonalization if it does not converge */
+
+  po = 0;
+
+  if (Eigen_Subspace_flag && !(SCF_iter==1 || rediagonalize_flag_overlap_matrix==1)){
+    po = Eigen_Subspace(MPI_CommWD1[myworld1],spin,C[spin],ko[spin],n,MaxN);
+  }
+
+  if (po==0){
+
+    if (numprocs1<n && 1<numprocs1)
+      Eigen_PReHH(MPI_CommWD1[myworld1],C[spin],ko[spin],n,MaxN,bcast_flag);
+    else 
+      Eigen_lapack(C[spin],ko[spin],n,n);
+  }
 
   /*
     if(myid0==0){
@@ -746,6 +758,12 @@ static double Cluster_collinear(
     }
   }
 
+  /* keep the eigenvectors for the subspace iteration at the next SCF step */
+
+  if (Eigen_Subspace_flag && po==0){
+    Eigen_Subspace_Store(MPI_CommWD1[myworld1],spin,H[spin],n,MaxN,is2,ie2);
+  }
+
   if (measure_time){
     dtime(&etime);
     time3 += etime - stime;
@@ -2653,7 +2671,10 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
 
   /* open file pointers */
 
-  if (myid==Host_ID){
+  fp_eig = NULL;
+  fp_ev = NULL;
+
+  if (myid==Host_ID && Dos_Dump){
 
     strcpy(file_eig,".Dos.val");
     fnjoint(filepath,filename,file_eig);
@@ -2703,6 +2724,10 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
 
   Overlap_Cluster(OLP0,S,MP);
 
+  if (Dos_Accum_Method!=0){
+    Dos_Accum_Init(n,SpinP_switch,1,1,1);
+  }
+
   /****************************************************
                    save *.Dos.vec
   ****************************************************/
@@ -2713,7 +2738,7 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
       for (i=0; i<(atomnum+1)*List_YOUSO[7]; i++) SD[i] = 0.0;
 
       i_vec[0]=i_vec[1]=i_vec[2]=0;
-      if (myid==Host_ID) fwrite(i_vec,sizeof(int),3,fp_ev);
+      if (myid==Host_ID && fp_ev) fwrite(i_vec,sizeof(int),3,fp_ev);
 
       tmp = (double)atomnum/(double)numprocs;
 
@@ -2756,57 +2781,69 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
 
       } /* #pragma omp parallel */
 
-      /* MPI communication */
+      /* on-the-fly DOS and PDOS by the local atoms */
 
-      if (myid!=Host_ID){
-      
-        wanA = WhatSpecies[eAN];
-        tnoA = Spe_Total_CNO[wanA];
-        num0 = MP[eAN] + tnoA - MP[sAN]; 
-
-        tag = 999;
-        MPI_Send(&SD[MP[sAN]],num0,MPI_FLOAT,Host_ID,tag,mpi_comm_level1);
+      if (Dos_Accum_Method!=0){
+        Dos_Accum_Add(spin,0,k,ko[spin][k],SD);
       }
-   
-      else {
-
-        for (ID=1; ID<numprocs; ID++){ 
 
-          tmp = (double)atomnum/(double)numprocs;
+      if (Dos_Dump){
 
-          sAN0 = (int)(tmp*(double)ID) + 1;
-          eAN0 = (int)(tmp*(double)(ID+1));
+	/* MPI communication */
 
-	  wanA = WhatSpecies[eAN0];
+	if (myid!=Host_ID){
+      
+	  wanA = WhatSpecies[eAN];
 	  tnoA = Spe_Total_CNO[wanA];
-	  num1 = MP[eAN0] + tnoA - MP[sAN0]; 
+	  num0 = MP[eAN] + tnoA - MP[sAN]; 
 
 	  tag = 999;
-	  MPI_Irecv(&SD[MP[sAN0]], num1, MPI_FLOAT, ID, tag, mpi_comm_level1, &request_recv[ID]);
+	  MPI_Send(&SD[MP[sAN]],num0,MPI_FLOAT,Host_ID,tag,mpi_comm_level1);
 	}
+   
+	else {
 
-        for (ID=1; ID<numprocs; ID++){ 
-          MPI_Wait(&request_recv[ID],&stat);
-	}
-      }      
+	  for (ID=1; ID<numprocs; ID++){ 
 
-      /* write *.Dos.vec */
+	    tmp = (double)atomnum/(double)numprocs;
 
-      if (myid==Host_ID){
-	wanA = WhatSpecies[atomnum];
-	tnoA = Spe_Total_CNO[wanA];
-        num = MP[atomnum] + tnoA - 1;
-        fwrite(&SD[1],sizeof(float),num,fp_ev);
-      }
+	    sAN0 = (int)(tmp*(double)ID) + 1;
+	    eAN0 = (int)(tmp*(double)(ID+1));
+
+	    wanA = WhatSpecies[eAN0];
+	    tnoA = Spe_Total_CNO[wanA];
+	    num1 = MP[eAN0] + tnoA - MP[sAN0]; 
+
+	    tag = 999;
+	    MPI_Irecv(&SD[MP[sAN0]], num1, MPI_FLOAT, ID, tag, mpi_comm_level1, &request_recv[ID]);
+	  }
 
+	  for (ID=1; ID<numprocs; ID++){ 
+	    MPI_Wait(&request_recv[ID],&stat);
+	  }
+	}      
+
+	/* write *.Dos.vec */
+
+	if (myid==Host_ID){
+	  wanA = WhatSpecies[atomnum];
+	  tnoA = Spe_Total_CNO[wanA];
+	  num = MP[atomnum] + tnoA - 1;
+	  if (fp_ev) fwrite(&SD[1],sizeof(float),num,fp_ev);
+	}
+      }
     }
   }
 
+  if (Dos_Accum_Method!=0){
+    Dos_Accum_Output(NULL);
+  }
+
   /****************************************************
                    save *.Dos.val
   ****************************************************/
 
-  if (myid==Host_ID){
+  if (myid==Host_ID && fp_eig){
 
     fprintf(fp_eig,"mode        1\n");
     fprintf(fp_eig,"NonCol      0\n");
@@ -2584,7 +2584,10 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
 
   /* open file pointers */
 
-  if (myid==Host_ID){
+  fp_eig = NULL;
+  fp_ev = NULL;
+
+  if (myid==Host_ID && Dos_Dump){
 
     strcpy(file_eig,".Dos.val");
     fnjoint(filepath,filename,file_eig);
@@ -2634,6 +2637,10 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
 
   Overlap_Cluster(OLP0,S,MP);
 
+  if (Dos_Accum_Method!=0){
+    Dos_Accum_Init(n,SpinP_switch,1,1,1);
+  }
+
   /****************************************************
                    save *.Dos.vec
   ****************************************************/
@@ -2644,7 +2651,7 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
       for (i=0; i<(atomnum+1)*List_YOUSO[7]; i++) SD[i] = 0.0;
 
       i_vec[0]=i_vec[1]=i_vec[2]=0;
-      if (myid==Host_ID) fwrite(i_vec,sizeof(int),3,fp_ev);
+      if (myid==Host_ID && fp_ev) fwrite(i_vec,sizeof(int),3,fp_ev);
 
       tmp = (double)atomnum/(double)numprocs;
 
@@ -2687,57 +2694,69 @@ void Save_DOS_Col(int n, int MaxN, int *MP, double ****OLP0, double ***C, double
 
       } /* #pragma omp parallel */
 
-      /* MPI communication */
+      /* on-the-fly DOS and PDOS by the local atoms */
 
-      if (myid!=Host_ID){
-      
-        wanA = WhatSpecies[eAN];
-        tnoA = Spe_Total_CNO[wanA];
-        num0 = MP[eAN] + tnoA - MP[sAN]; 
-
-        tag = 999;
-        MPI_Send(&SD[MP[sAN]],num0,MPI_FLOAT,Host_ID,tag,mpi_comm_level1);
+      if (Dos_Accum_Method!=0){
+        Dos_Accum_Add(spin,0,k,ko[spin][k],SD);
       }
-   
-      else {
 
-        for (ID=1; ID<numprocs; ID++){ 
+      if (Dos_Dump){
 
-          tmp = (double)atomnum/(double)numprocs;
+	/* MPI communication */
 
-          sAN0 = (int)(tmp*(double)ID) + 1;
-          eAN0 = (int)(tmp*(double)(ID+1));
-
-	  wanA = WhatSpecies[eAN0];
+	if (myid!=Host_ID){
+      
+	  wanA = WhatSpecies[eAN];
 	  tnoA = Spe_Total_CNO[wanA];
-	  num1 = MP[eAN0] + tnoA - MP[sAN0]; 
+	  num0 = MP[eAN] + tnoA - MP[sAN]; 
 
 	  tag = 999;
-	  MPI_Irecv(&SD[MP[sAN0]], num1, MPI_FLOAT, ID, tag, mpi_comm_level1, &request_recv[ID]);
+	  MPI_Send(&SD[MP[sAN]],num0,MPI_FLOAT,Host_ID,tag,mpi_comm_level1);
 	}
+   
+	else {
 
-        for (ID=1; ID<numprocs; ID++){ 
-          MPI_Wait(&request_recv[ID],&stat);
-	}
-      }      
+	  for (ID=1; ID<numprocs; ID++){ 
 
-      /* write *.Dos.vec */
+	    tmp = (double)atomnum/(double)numprocs;
 
-      if (myid==Host_ID){
-	wanA = WhatSpecies[atomnum];
-	tnoA = Spe_Total_CNO[wanA];
-        num = MP[atomnum] + tnoA - 1;
-        fwrite(&SD[1],sizeof(float),num,fp_ev);
-      }
+	    sAN0 = (int)(tmp*(double)ID) + 1;
+	    eAN0 = (int)(tmp*(double)(ID+1));
 
+	    wanA = WhatSpecies[eAN0];
+	    tnoA = Spe_Total_CNO[wanA];
+	    num1 = MP[eAN0] + tnoA - MP[sAN0]; 
+
+	    tag = 999;
+	    MPI_Irecv(&SD[MP[sAN0]], num1, MPI_FLOAT, ID, tag, mpi_comm_level1, &request_recv[ID]);
+	  }
+
+	  for (ID=1; ID<numprocs; ID++){ 
+	    MPI_Wait(&request_recv[ID],&stat);
+	  }
+	}      
+
+	/* write *.Dos.vec */
+
+	if (myid==Host_ID){
+	  wanA = WhatSpecies[atomnum];
+	  tnoA = Spe_Total_CNO[wanA];
+	  num = MP[atomnum] + tnoA - 1;
+	  if (fp_ev) fwrite(&SD[1],sizeof(float),num,fp_ev);
+	}
+      }
     }
   }
 
+  if (Dos_Accum_Method!=0){
+    Dos_Accum_Output(NULL);
+  }
+
   /****************************************************
                    save *.Dos.val
   ****************************************************/
 
-  if (myid==Host_ID){
+  if (myid==Host_ID && fp_eig){
 
     fprintf(fp_eig,"mode        1\n");
     fprintf(fp_eig,"NonCol      0\n");
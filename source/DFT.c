@@ -875,6 +875,16 @@ double DFT(int MD_iter, int Cnt_Now)
     
     SCF_iter++;
     LSCF_iter++;
+
+    /* the data on grids are exchanged in single precision until NormRD
+       falls below scf.Grid.Promotion.Criterion if scf.Grid.Precision is Mixed */
+
+    Grid_Precision_Set(NormRD[0]);
+
+    /* work arrays of kernels are allocated from arenas enlarged
+       to the high-water mark of the previous SCF step */
+
+    Arena_Reset();
     
     /*****************************************************
                          print stdout
@@ -1034,7 +1044,8 @@ double DFT(int MD_iter, int Cnt_Now)
 
       if (SucceedReadingDMfile && Cnt_switch==0) {
 
-	if (Solver!=4 && ESM_switch==0)      time4 += Poisson(1,ReVk,ImVk);
+	if (Solver!=4 && ESM_switch==0 && Poisson_RS_switch==1) time4 += Poisson_RS();
+        else if (Solver!=4 && ESM_switch==0) time4 += Poisson(1,ReVk,ImVk);
         else if (Solver!=4 && ESM_switch!=0) time4 += Poisson_ESM(1,ReVk,ImVk); /* added by Ohwaki */
         else                                 time4 += TRAN_Poisson(ReVk,ImVk); 
 
@@ -1085,7 +1096,8 @@ double DFT(int MD_iter, int Cnt_Now)
       else if (Cnt_switch==1)                             Cnt_kind = 1;
       else                                                Cnt_kind = 0;
 
-      if (Solver!=4 && ESM_switch==0)       time4 += Poisson(fft_charge_flag,ReVk,ImVk);
+      if (Solver!=4 && ESM_switch==0 && Poisson_RS_switch==1) time4 += Poisson_RS();
+      else if (Solver!=4 && ESM_switch==0)  time4 += Poisson(fft_charge_flag,ReVk,ImVk);
       else if (Solver!=4 && ESM_switch!=0)  time4 += Poisson_ESM(fft_charge_flag,ReVk,ImVk); /* added by Ohwaki */
       else                                  time4 += TRAN_Poisson(ReVk,ImVk); 
 
@@ -1122,7 +1134,7 @@ double DFT(int MD_iter, int Cnt_Now)
     s_vec[0]="Recursion";     s_vec[1]="Cluster"; s_vec[2]="Band";
     s_vec[3]="NEGF";          s_vec[4]="DC";      s_vec[5]="GDC";
     s_vec[6]="Cluster-DIIS";  s_vec[7]="Krylov";  s_vec[8]="Cluster2";
-    s_vec[9]="EC";
+    s_vec[9]="EC";            s_vec[10]="Purify";  s_vec[11]="Pole";
 
     if (MYID_MPI_COMM_WORLD==Host_ID && 0<level_stdout){
       printf("<%s>  Solving the eigenvalue problem...\n",s_vec[Solver-1]);fflush(stdout);
@@ -1358,6 +1370,14 @@ double DFT(int MD_iter, int Cnt_Now)
 	time5 += EC("scf",LSCF_iter,H,iHNL,OLP[0],DM[0],EDM,Eele0,Eele1);
 	break;
 
+      case 11:
+	time5 += Purify("scf",LSCF_iter,H,iHNL,OLP[0],DM[0],EDM,Eele0,Eele1);
+	break;
+
+      case 12:
+	time5 += Pole_DFT("scf",LSCF_iter,H,iHNL,OLP[0],DM[0],EDM,Eele0,Eele1);
+	break;
+
       }
 
     }
@@ -1599,6 +1619,14 @@ double DFT(int MD_iter, int Cnt_Now)
 	time5 += EC("scf",LSCF_iter,CntH,iCntHNL,CntOLP[0],DM[0],EDM,Eele0,Eele1);
 	break;
 
+      case 11:
+	time5 += Purify("scf",LSCF_iter,CntH,iCntHNL,CntOLP[0],DM[0],EDM,Eele0,Eele1);
+	break;
+
+      case 12:
+	time5 += Pole_DFT("scf",LSCF_iter,CntH,iCntHNL,CntOLP[0],DM[0],EDM,Eele0,Eele1);
+	break;
+
       }
     }
 
@@ -1657,7 +1685,7 @@ double DFT(int MD_iter, int Cnt_Now)
       /*
 	time10 += Set_Orbitals_Grid(1);
 	time11 += Set_Density_Grid(1, 0, DM[0]);
-	time7 += Force(H0,DS_NL,OLP,DM[0],EDM);
+	time7 += Force("force",H0,DS_NL,OLP,DM[0],EDM);
 	time8 += Total_Energy(MD_iter,DM[0],ECE);
 	time10 += Set_Orbitals_Grid(0);
 
@@ -1979,6 +2007,10 @@ double DFT(int MD_iter, int Cnt_Now)
 
   } while (po==0 && SCF_iter<SCF_MAX);
 
+  /* the energy and forces are calculated with the data exchanged in double precision */
+
+  Grid_Precision_Set(0.0);
+
   /*****************************************************
           making of the input data for TranMain
   *****************************************************/
@@ -2373,10 +2405,14 @@ double DFT(int MD_iter, int Cnt_Now)
                calculation of forces
   ****************************************************/
 
-  if (!orbitalOpt_Force_Skip) time7 += Force(H0,DS_NL,OLP,DM[0],EDM);
+  /* forces and stress share the derivative blocks in case of "force+stress" */
 
   if (scf_stress_flag){
-    Stress(H0,DS_NL,OLP,DM[0],EDM); 
+    if (!orbitalOpt_Force_Skip) time7 += Force("force+stress",H0,DS_NL,OLP,DM[0],EDM);
+    else                        Force("stress",H0,DS_NL,OLP,DM[0],EDM);
+  }
+  else if (!orbitalOpt_Force_Skip){
+    time7 += Force("force",H0,DS_NL,OLP,DM[0],EDM);
   }
 
   /*
@@ -81,6 +81,8 @@ double Divide_Conquer(char *mode,
     time0 = DC_NonCol(mode,SCF_iter, Hks, ImNL, OLP0, CDM, EDM, Eele0, Eele1);
   }
 
+  if (Bench_flag) Bench_Record(Bench_DC,time0);
+
   return time0;
 }
 
@@ -643,6 +645,8 @@ static double DC_Col(char *mode,
               atom i in arraies H and S
   ****************************************************/
 
+  Atom_Schedule_Start(Sched_DC_Col, Msize, Msize);
+
 #pragma omp parallel shared(OLP_eigen_cut,List_YOUSO,Etime_atom,time_per_atom,time3,Residues,EVal,time2,time1,S12,level_stdout,SpinP_switch,Hks,OLP0,SCF_iter,RMI1,S_G2M,Spe_Total_CNO,natn,FNAN,SNAN,WhatSpecies,M2G,Matomnum) private(OMPID,Nthrds,Nprocs,Mc_AN,Stime_atom,Gc_AN,wan,Anum,i,j,MP,Gi,wanA,NUM,NUM1,n2,spin,S_DC,H_DC,ko,M1,C,ig,ian,ih,kl,jg,jan,Bnum,m,n,stime,P_min,l,i1,j1,etime,tmp1,tmp2,sum1,sum2,sum3,sum4,j1s,sum,tno1,h_AN,Gh_AN,wanB,tno2)
   { 
 
@@ -658,7 +662,7 @@ static double DC_Col(char *mode,
 
     /* start of the Mc_AN loop which is parallelized by OpenMP */
 
-    for (Mc_AN=1+OMPID; Mc_AN<=Matomnum; Mc_AN+=Nthrds){
+    while ((Mc_AN=Atom_Schedule_Next(Sched_DC_Col))!=0){
 
       dtime(&Stime_atom);
 
@@ -1089,6 +1093,8 @@ static double DC_Col(char *mode,
 
   } /* #pragma omp parallel */
 
+  Atom_Schedule_End(Sched_DC_Col, "DC");
+
   if ( strcasecmp(mode,"scf")==0 ){
 
     /****************************************************
@@ -2185,6 +2191,8 @@ static double DC_NonCol(char *mode,
               atom i in arraies H and S
   ****************************************************/
 
+  Atom_Schedule_Start(Sched_DC_NonCol, Msize, Msize);
+
 #pragma omp parallel shared(List_YOUSO,time_per_atom,Residues,EVal,S12,OLP_eigen_cut,ImNL,Hks,Zeeman_NCO_switch,Zeeman_NCS_switch,Constraint_NCS_switch,Hub_U_switch,SO_switch,OLP0,SCF_iter,RMI1,S_G2M,Spe_Total_CNO,natn,SNAN,FNAN,WhatSpecies,M2G,Matomnum) private(OMPID,Nthrds,Nprocs,Mc_AN,Etime_atom,Stime_atom,Gc_AN,wan,Anum,i,MP,Gi,wanA,NUM,n2,S_DC,H_DC,ko,M1,C,ig,ian,ih,j,kl,jg,jan,Bnum,m,n,P_min,l,i1,j1,tmp1,tmp2,k,jj1,k1,sum_r,sum_i,l1,sum1_r,sum1_i,sum2_r,sum2_i,ii1,NUM1,tno1,h_AN,Gh_AN,wanB,tno2)
   { 
 
@@ -2200,7 +2208,7 @@ static double DC_NonCol(char *mode,
 
     /* start of the Mc_AN loop which is parallelized by OpenMP */
 
-    for (Mc_AN=1+OMPID; Mc_AN<=Matomnum; Mc_AN+=Nthrds){
+    while ((Mc_AN=Atom_Schedule_Next(Sched_DC_NonCol))!=0){
 
       dtime(&Stime_atom);
 
@@ -2616,6 +2624,8 @@ static double DC_NonCol(char *mode,
 
   } /* #pragma omp parallel */
 
+  Atom_Schedule_End(Sched_DC_NonCol, "DC");
+
   if ( strcasecmp(mode,"scf")==0 ){
 
     /****************************************************
@@ -0,0 +1,416 @@
+/**********************************************************************
+  Dos_Accum.c:
+
+     Dos_Accum.c is a set of subroutines to accumulate the density of
+     states (DOS) and the projected DOS (PDOS) while the eigenvectors
+     are in memory, so that the spectra can be obtained without
+     re-reading *.Dos.val and *.Dos.vec by DosMain.
+
+     Dos_Accum_Init:    allocates the spectra on the energy mesh
+     Dos_Accum_Add:     adds the Mulliken populations of an eigenstate
+     Dos_Accum_Output:  reduces the spectra over the processes and
+                        writes *.DOS.* and *.PDOS.* files
+
+     The method is selected by Dos.Accumulate. The Gaussian and the
+     histogram contributions are binned immediately. In the tetrahedron
+     method, the populations at the local k-points are kept until the
+     eigenvalues at all the k-points are known. Since the spectrum of
+     the tetrahedron method by Bloechl et al. is linear in the values
+     at the corners, each k-point adds its own share of every
+     tetrahedron containing it, and no population is communicated.
+
+  Log of Dos_Accum.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "mpi.h"
+#include <omp.h>
+
+/* Tetrahedron_Blochl.c */
+void OrderE(double *e,double *a, int n);
+void ATM_Spectrum(double *et,double *at, double *e, double *spectrum);
+
+static void Write_Dos(char *file, int Nspin, int Nmesh, double *E, double **D);
+
+static int Acc_n,Acc_Nspin,Acc_Nmesh,Acc_method;
+static int Acc_knum[3];
+static double *Acc_E;
+static double *Acc_Dos;   /* Acc_Dos[(spin*Acc_n+i-1)*Acc_Nmesh+ie] for SD[i] */
+
+/* populations kept for the tetrahedron method */
+
+static int Acc_Nrec,Acc_Mrec;
+static int *Acc_rec;      /* kloop, spin, and state for each record */
+static float *Acc_SD;
+
+
+
+void Dos_Accum_Init(int n, int Nspin, int knum_i, int knum_j, int knum_k)
+{
+  int ie,myid;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  Acc_n = n;
+  Acc_Nspin = Nspin;
+  Acc_Nmesh = DosGauss_Num_Mesh;
+  Acc_method = Dos_Accum_Method;
+  Acc_knum[0] = knum_i;
+  Acc_knum[1] = knum_j;
+  Acc_knum[2] = knum_k;
+
+  /* the tetrahedron method needs a k-mesh */
+
+  if (Acc_method==3 && knum_i*knum_j*knum_k==1){
+    if (myid==Host_ID){
+      printf("Dos.Accumulate: the Gaussian broadening is used for a single k-point.\n");
+    }
+    Acc_method = 1;
+  }
+
+  Acc_E = (double*)malloc(sizeof(double)*Acc_Nmesh);
+  for (ie=0; ie<Acc_Nmesh; ie++){
+    Acc_E[ie] = Dos_Erange[0] + (Dos_Erange[1]-Dos_Erange[0])*(double)ie/(double)(Acc_Nmesh-1);
+  }
+
+  Acc_Dos = (double*)calloc((size_t)(Nspin+1)*n*Acc_Nmesh,sizeof(double));
+
+  Acc_Nrec = 0;
+  Acc_Mrec = 0;
+  Acc_rec = NULL;
+  Acc_SD = NULL;
+}
+
+
+
+void Dos_Accum_Add(int spin, int kloop, int l, double eig, float *SD)
+{
+  int i,ie,iemin,iemax,iecenter,iewidth;
+  double e,x,xa,w,factor,dE,pi2;
+  double *Dos;
+
+  e = eig - ChemP;
+  Dos = &Acc_Dos[(size_t)spin*Acc_n*Acc_Nmesh];
+  factor = 1.0/(double)(Acc_knum[0]*Acc_knum[1]*Acc_knum[2]);
+  dE = (Dos_Erange[1]-Dos_Erange[0])/(double)(Acc_Nmesh-1);
+
+  /* Gaussian */
+
+  if (Acc_method==1){
+
+    pi2 = sqrt(PI);
+    iewidth = DosGauss_Width*3.0/dE + 3;
+
+    x = (e-Dos_Erange[0])/dE;
+    iecenter = (int)x;
+    iemin = iecenter - iewidth;
+    iemax = iecenter + iewidth;
+    if (iemin<0) iemin = 0;
+    if (Acc_Nmesh<=iemax) iemax = Acc_Nmesh - 1;
+
+    for (ie=iemin; ie<=iemax; ie++){
+
+      xa = (e-Acc_E[ie])/DosGauss_Width;
+      w = factor*exp(-xa*xa)/(DosGauss_Width*pi2*eV2Hartree);
+
+      for (i=1; i<=Acc_n; i++){
+        Dos[(i-1)*Acc_Nmesh+ie] += w*SD[i];
+      }
+    }
+  }
+
+  /* histogram */
+
+  else if (Acc_method==2){
+
+    x = (e-Dos_Erange[0])/dE;
+    ie = (int)x;
+
+    if (0<=x && ie<Acc_Nmesh){
+
+      w = factor/(dE*eV2Hartree);
+
+      for (i=1; i<=Acc_n; i++){
+        Dos[(i-1)*Acc_Nmesh+ie] += w*SD[i];
+      }
+    }
+  }
+
+  /* tetrahedron: keep the populations */
+
+  else if (Acc_method==3){
+
+    if (Acc_Nrec==Acc_Mrec){
+      Acc_Mrec = 2*Acc_Mrec + 16;
+      Acc_rec = (int*)realloc(Acc_rec,sizeof(int)*3*Acc_Mrec);
+      Acc_SD = (float*)realloc(Acc_SD,sizeof(float)*(size_t)Acc_Mrec*Acc_n);
+    }
+
+    Acc_rec[3*Acc_Nrec  ] = kloop;
+    Acc_rec[3*Acc_Nrec+1] = spin;
+    Acc_rec[3*Acc_Nrec+2] = l;
+    memcpy(&Acc_SD[(size_t)Acc_Nrec*Acc_n],&SD[1],sizeof(float)*Acc_n);
+    Acc_Nrec++;
+  }
+}
+
+
+
+void Dos_Accum_Output(double ***EIGEN)
+{
+  static int tetra_id[6][4]= { {0,1,2,5}, {1,2,3,5}, {2,3,5,7},
+                               {0,2,4,5}, {2,4,5,6}, {2,5,6,7} };
+  static char *Lname[5]={"s","p","d","f","g"};
+  static char *Mname[4]={"","Gaussian","Histgram","Tetrahedron"};
+  int r,i,j,k,i0,j0,k0,i_in,j_in,k_in,c,ic,itetra,spin,l,ie,iemin,iemax;
+  int GA_AN,wanA,tnoA,Anum,L,M,mul,num,LM,myid;
+  int kc[8];
+  double w,x,factor,dE,result;
+  double cell_e[8],tetra_e[4],tetra_a[4];
+  double *Dos,*WT,**D;
+  float *SD;
+  char file[YOUSO10];
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  dE = (Dos_Erange[1]-Dos_Erange[0])/(double)(Acc_Nmesh-1);
+
+  /****************************************************
+     tetrahedron method: add the share of each corner
+  ****************************************************/
+
+  if (Acc_method==3){
+
+    factor = 1.0/(double)(eV2Hartree*Acc_knum[0]*Acc_knum[1]*Acc_knum[2]*6);
+    WT = (double*)malloc(sizeof(double)*Acc_Nmesh);
+
+    for (r=0; r<Acc_Nrec; r++){
+
+      spin = Acc_rec[3*r+1];
+      l    = Acc_rec[3*r+2];
+      SD   = &Acc_SD[(size_t)r*Acc_n];
+      Dos  = &Acc_Dos[(size_t)spin*Acc_n*Acc_Nmesh];
+
+      /* the k-points are ordered as (i*knum_j+j)*knum_k+k */
+
+      i0 = Acc_rec[3*r]/(Acc_knum[1]*Acc_knum[2]);
+      j0 = (Acc_rec[3*r]/Acc_knum[2])%Acc_knum[1];
+      k0 = Acc_rec[3*r]%Acc_knum[2];
+
+      for (ie=0; ie<Acc_Nmesh; ie++) WT[ie] = 0.0;
+
+      /* eight cells sharing the k-point as the corner c */
+
+      for (c=0; c<8; c++){
+
+        i_in = c/4;
+        j_in = (c/2)%2;
+        k_in = c%2;
+
+        i = (i0 - i_in + Acc_knum[0])%Acc_knum[0];
+        j = (j0 - j_in + Acc_knum[1])%Acc_knum[1];
+        k = (k0 - k_in + Acc_knum[2])%Acc_knum[2];
+
+        for (ic=0; ic<8; ic++){
+          kc[ic] = ( ((i+ic/4)%Acc_knum[0])*Acc_knum[1]
+                    +(j+(ic/2)%2)%Acc_knum[1] )*Acc_knum[2]
+                    +(k+ic%2)%Acc_knum[2];
+          cell_e[ic] = EIGEN[spin][kc[ic]][l] - ChemP;
+        }
+
+        for (itetra=0; itetra<6; itetra++){
+
+          for (ic=0; ic<4; ic++){
+            if (tetra_id[itetra][ic]==c) break;
+          }
+          if (ic==4) continue;
+
+          for (ic=0; ic<4; ic++){
+            tetra_e[ic] = cell_e[tetra_id[itetra][ic]];
+            tetra_a[ic] = (tetra_id[itetra][ic]==c) ? 1.0 : 0.0;
+          }
+          OrderE(tetra_e,tetra_a,4);
+
+          x = (tetra_e[0]-Dos_Erange[0])/dE - 1.0;
+          iemin = (int)x;
+          x = (tetra_e[3]-Dos_Erange[0])/dE + 1.0;
+          iemax = (int)x;
+          if (iemin<0) iemin = 0;
+          if (Acc_Nmesh<=iemax) iemax = Acc_Nmesh - 1;
+
+          for (ie=iemin; ie<=iemax; ie++){
+            ATM_Spectrum(tetra_e,tetra_a,&Acc_E[ie],&result);
+            WT[ie] += result;
+          }
+        }
+      }
+
+      for (ie=0; ie<Acc_Nmesh; ie++){
+        if (WT[ie]!=0.0){
+          w = factor*WT[ie];
+          for (i=0; i<Acc_n; i++){
+            Dos[i*Acc_Nmesh+ie] += w*SD[i];
+          }
+        }
+      }
+    }
+
+    free(WT);
+  }
+
+  /****************************************************
+                 MPI: sum of the spectra
+  ****************************************************/
+
+  num = (Acc_Nspin+1)*Acc_n*Acc_Nmesh;
+
+  if (myid==Host_ID){
+    MPI_Reduce(MPI_IN_PLACE, Acc_Dos, num, MPI_DOUBLE, MPI_SUM, Host_ID, mpi_comm_level1);
+  }
+  else{
+    MPI_Reduce(Acc_Dos, NULL, num, MPI_DOUBLE, MPI_SUM, Host_ID, mpi_comm_level1);
+  }
+
+  /****************************************************
+                   write the spectra
+  ****************************************************/
+
+  if (myid==Host_ID){
+
+    D = (double**)malloc(sizeof(double*)*(Acc_Nspin+1));
+    for (spin=0; spin<=Acc_Nspin; spin++){
+      D[spin] = (double*)malloc(sizeof(double)*Acc_Nmesh);
+    }
+
+    /* total DOS */
+
+    for (spin=0; spin<=Acc_Nspin; spin++){
+      for (ie=0; ie<Acc_Nmesh; ie++){
+        D[spin][ie] = 0.0;
+        for (i=0; i<Acc_n; i++){
+          D[spin][ie] += Acc_Dos[((size_t)spin*Acc_n+i)*Acc_Nmesh+ie];
+        }
+      }
+    }
+
+    /* a file whose name does not fit in YOUSO10 is not written */
+
+    if (snprintf(file,YOUSO10,"%s%s.DOS.%s",filepath,filename,Mname[Acc_method])<YOUSO10){
+      Write_Dos(file,Acc_Nspin,Acc_Nmesh,Acc_E,D);
+    }
+
+    /* PDOS of each atom and of each angular momentum */
+
+    Anum = 0;
+    for (GA_AN=1; GA_AN<=atomnum; GA_AN++){
+
+      wanA = WhatSpecies[GA_AN];
+      tnoA = Spe_Total_CNO[wanA];
+
+      for (spin=0; spin<=Acc_Nspin; spin++){
+        for (ie=0; ie<Acc_Nmesh; ie++){
+          D[spin][ie] = 0.0;
+          for (i=0; i<tnoA; i++){
+            D[spin][ie] += Acc_Dos[((size_t)spin*Acc_n+Anum+i)*Acc_Nmesh+ie];
+          }
+        }
+      }
+
+      if (snprintf(file,YOUSO10,"%s%s.PDOS.%s.atom%d",filepath,filename,Mname[Acc_method],GA_AN)<YOUSO10){
+        Write_Dos(file,Acc_Nspin,Acc_Nmesh,Acc_E,D);
+      }
+
+      /* the orbitals are ordered by L, multiplicity, and M */
+
+      for (L=0; L<=Supported_MaxL; L++){
+        if (0<Spe_Num_CBasis[wanA][L]){
+
+          LM = 0;
+          for (l=0; l<L; l++) LM += Spe_Num_CBasis[wanA][l]*(2*l+1);
+
+          for (M=0; M<(2*L+1); M++){
+
+            for (spin=0; spin<=Acc_Nspin; spin++){
+              for (ie=0; ie<Acc_Nmesh; ie++){
+
+                D[spin][ie] = 0.0;
+                for (mul=0; mul<Spe_Num_CBasis[wanA][L]; mul++){
+                  i = Anum + LM + mul*(2*L+1) + M;
+                  D[spin][ie] += Acc_Dos[((size_t)spin*Acc_n+i)*Acc_Nmesh+ie];
+                }
+              }
+            }
+
+            if (snprintf(file,YOUSO10,"%s%s.PDOS.%s.atom%d.%s%d",
+                         filepath,filename,Mname[Acc_method],GA_AN,Lname[L],M+1)<YOUSO10){
+              Write_Dos(file,Acc_Nspin,Acc_Nmesh,Acc_E,D);
+            }
+          }
+        }
+      }
+
+      Anum += tnoA;
+    }
+
+    for (spin=0; spin<=Acc_Nspin; spin++){
+      free(D[spin]);
+    }
+    free(D);
+  }
+
+  /* freeing of arrays */
+
+  free(Acc_E);
+  free(Acc_Dos);
+  if (Acc_rec!=NULL) free(Acc_rec);
+  if (Acc_SD!=NULL)  free(Acc_SD);
+  Acc_rec = NULL;
+  Acc_SD = NULL;
+  Acc_Nrec = 0;
+  Acc_Mrec = 0;
+}
+
+
+
+static void Write_Dos(char *file, int Nspin, int Nmesh, double *E, double **D)
+{
+  /* the same format and Simpson's rule as in DosMain */
+
+  int spin,q,ie;
+  double h,s1,s2,ssum[2];
+  FILE *fp;
+
+  if ( (fp=fopen(file,"w"))==NULL ){
+    printf("cannot open a file %s\n",file);
+    return;
+  }
+
+  h = (E[Nmesh-1]-E[0])/(double)(Nmesh-1)*eV2Hartree;
+
+  for (q=0; q<Nmesh; q++){
+
+    for (spin=0; spin<=Nspin; spin++){
+      s1 = 0.0;
+      s2 = 0.0;
+      for (ie=1; ie<q; ie+=2) s1 += D[spin][ie];
+      for (ie=2; ie<q; ie+=2) s2 += D[spin][ie];
+      ssum[spin] = (D[spin][0]+4.0*s1+2.0*s2+D[spin][q])*h/3.0;
+    }
+
+    if (Nspin==1){
+      fprintf(fp,"%lf %lf %lf %lf %lf\n",E[q]*eV2Hartree,D[0][q],-D[1][q],ssum[0],ssum[1]);
+    }
+    else{
+      fprintf(fp,"%lf %lf %lf\n",E[q]*eV2Hartree,D[0][q]*2.0,ssum[0]*2.0);
+    }
+  }
+
+  fclose(fp);
+}
@@ -4711,6 +4711,8 @@ static double DC_NonCol(char *mode,
               atom i in arraies H and S
   ****************************************************/
 
+  Atom_Schedule_Start(Sched_DC_NonCol, Msize, Msize);
+
 #pragma omp parallel shared(List_YOUSO,time_per_atom,Residues,EVal,S12,OLP_eigen_cut,ImNL,Hks,Zeeman_NCO_switch,Zeeman_NCS_switch,Constraint_NCS_switch,Hub_U_switch,SO_switch,OLP0,SCF_iter,RMI1,S_G2M,Spe_Total_CNO,natn,SNAN,FNAN,WhatSpecies,M2G,Matomnum) private(OMPID,Nthrds,Nprocs,Mc_AN,Etime_atom,Stime_atom,Gc_AN,wan,Anum,i,MP,Gi,wanA,NUM,n2,S_DC,H_DC,ko,M1,C,ig,ian,ih,j,kl,jg,jan,Bnum,m,n,P_min,l,i1,j1,tmp1,tmp2,k,jj1,k1,sum_r,sum_i,l1,sum1_r,sum1_i,sum2_r,sum2_i,ii1,NUM1,tno1,h_AN,Gh_AN,wanB,tno2)
   { 
 
@@ -4726,7 +4728,7 @@ static double DC_NonCol(char *mode,
 
     /* start of the Mc_AN loop which is parallelized by OpenMP */
 
-    for (Mc_AN=1+OMPID; Mc_AN<=Matomnum; Mc_AN+=Nthrds){
+    while ((Mc_AN=Atom_Schedule_Next(Sched_DC_NonCol))!=0){
 
       dtime(&Stime_atom);
 
@@ -5142,6 +5144,8 @@ static double DC_NonCol(char *mode,
 
   } /* #pragma omp parallel */
 
+  Atom_Schedule_End(Sched_DC_NonCol, "DC");
+
   if ( strcasecmp(mode,"scf")==0 ){
 
     /****************************************************
@@ -35,9 +35,12 @@ void Eigen_PHH(MPI_Comm MPI_Current_Comm_WD,
                dcomplex **ac, double *ko, int n, int EVmax, int bcast_flag)
 {
   int numprocs;
+  double TStime,TEtime;
 
   MPI_Comm_size(MPI_Current_Comm_WD,&numprocs);
 
+  dtime(&TStime);
+
   if (n<20 || n<numprocs)
     EigenBand_lapack(ac, ko, n, n, 1);
 
@@ -46,6 +49,9 @@ void Eigen_PHH(MPI_Comm MPI_Current_Comm_WD,
 
   else if (scf_eigen_lib_flag==1)
     Eigen_ELPA1_Co(MPI_Current_Comm_WD, ac, ko, n, EVmax, bcast_flag);
+
+  dtime(&TEtime);
+  if (Bench_flag) Bench_Record(Bench_Eigen_PHH,TEtime-TStime);
 }
 
 
@@ -0,0 +1,583 @@
+/**********************************************************************
+  Eigen_Subspace.c:
+
+     Eigen_Subspace.c is a set of subroutines to find the lowest MaxN
+     eigenstates of a real symmetric matrix by the Chebyshev-filtered
+     subspace iteration, which is warm-started from the eigenvectors
+     obtained at the previous SCF step.
+
+     Eigen_Subspace:        called from Cluster_DFT instead of the dense
+                            diagonalization if scf.Eigen.Subspace=on
+     Eigen_Subspace_Store:  called after the dense diagonalization to
+                            keep the eigenvectors for the next SCF step
+
+     The matrix a[1..n][1..n] is given on all the processes in comm.
+     Each process holds a block of rows of the subspace, and matrix
+     products are performed by dgemm on the block. The Rayleigh-Ritz
+     step solves the small generalized eigenvalue problem in the
+     subspace by Eigen_lapack as done for the overlap matrix in
+     Cluster_DFT. If the iteration does not converge, 0 is returned
+     and the caller performs the dense diagonalization.
+
+  Log of Eigen_Subspace.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "lapack_prototypes.h"
+#include "mpi.h"
+#include <omp.h>
+
+#define Max_Spin_Subspace  2
+
+/* stored eigenvectors: Sub_V[spin][(i-1)*Sub_m[spin]+(j-1)] = a[i][j] */
+
+static int Sub_n[Max_Spin_Subspace] = {0,0};
+static int Sub_m[Max_Spin_Subspace] = {0,0};
+static double *Sub_V[Max_Spin_Subspace] = {NULL,NULL};
+
+static void Gather_Rows(MPI_Comm comm, double *loc, double *full, int m, int *rs, int *re);
+static void Mult_A(int nl, int n, int m, double *Aloc, double *V, double *AV);
+static int Rayleigh_Ritz(MPI_Comm comm, int nl, int m, double *Y, double *AY,
+                         double *V, double *AV, double *theta);
+static double Upper_Bound(double **a, int n, int *frozen);
+
+
+
+int Eigen_Subspace(MPI_Comm comm, int spin, double **a, double *ko, int n, int MaxN)
+{
+  int i,j,k,m,nl,iter,deg,po,numprocs,myid;
+  int *rs,*re,*frozen;
+  double *Aloc,*V,*AV,*X,*Y,*AY,*Vfull,*theta,*rnorm;
+  double lb,ub,a0,e,c,sigma,sigma1,tau,res,r,fac1,fac2;
+  unsigned long int seed;
+
+  MPI_Comm_size(comm,&numprocs);
+  MPI_Comm_rank(comm,&myid);
+
+  if (Sub_V[spin]==NULL || Sub_n[spin]!=n) return 0;
+
+  m = MaxN + MaxN/20 + 10;
+  if (n<m) m = n;
+
+  /* the dense diagonalization is faster for a large subspace */
+
+  if (n<2*m) return 0;
+
+  /* rows of the subspace in each process */
+
+  rs = (int*)malloc(sizeof(int)*(numprocs+1));
+  re = (int*)malloc(sizeof(int)*(numprocs+1));
+
+  for (i=0; i<numprocs; i++){
+    rs[i] = (int)(((long int)n*i)/numprocs);
+    re[i] = (int)(((long int)n*(i+1))/numprocs);
+  }
+  nl = re[myid] - rs[myid];
+
+  /* rows decoupled by the penalty for ill-conditioned states in Cluster_DFT */
+
+  frozen = (int*)malloc(sizeof(int)*(n+1));
+
+  for (i=1; i<=n; i++){
+    po = 1;
+    for (j=1; j<=n && po; j++){
+      if (i!=j && a[i][j]!=0.0) po = 0;
+    }
+    frozen[i] = po && (1.0e+3<a[i][i]);
+  }
+
+  /* allocation of arrays */
+
+  Aloc  = (double*)malloc(sizeof(double)*(nl*n+1));
+  Vfull = (double*)malloc(sizeof(double)*(n*m+1));
+  V     = (double*)malloc(sizeof(double)*(nl*m+1));
+  AV    = (double*)malloc(sizeof(double)*(nl*m+1));
+  X     = (double*)malloc(sizeof(double)*(nl*m+1));
+  Y     = (double*)malloc(sizeof(double)*(nl*m+1));
+  AY    = (double*)malloc(sizeof(double)*(nl*m+1));
+  theta = (double*)malloc(sizeof(double)*(m+1));
+  rnorm = (double*)malloc(sizeof(double)*(m+1));
+
+  for (i=0; i<nl; i++){
+    for (j=0; j<n; j++){
+      Aloc[i*n+j] = a[rs[myid]+i+1][j+1];
+    }
+  }
+
+  /* initial subspace: the stored vectors, supplemented by
+     pseudo-random vectors which are identical in all the processes */
+
+  seed = 12345;
+
+  for (i=0; i<n; i++){
+    for (j=0; j<m; j++){
+
+      seed = seed*1103515245 + 12345;
+
+      if (frozen[i+1])       Vfull[i*m+j] = 0.0;
+      else if (j<Sub_m[spin]) Vfull[i*m+j] = Sub_V[spin][i*Sub_m[spin]+j];
+      else                    Vfull[i*m+j] = (double)((seed/65536)%32768)/32768.0 - 0.5;
+    }
+  }
+
+  for (i=0; i<nl; i++){
+    for (j=0; j<m; j++){
+      Y[i*m+j] = Vfull[(rs[myid]+i)*m+j];
+    }
+  }
+
+  Mult_A(nl, n, m, Aloc, Vfull, AY);
+
+  po = Rayleigh_Ritz(comm, nl, m, Y, AY, V, AV, theta);
+
+  ub = Upper_Bound(a, n, frozen);
+
+  /****************************************************
+                 Chebyshev filtering
+  ****************************************************/
+
+  deg = Eigen_Subspace_Degree;
+  iter = 0;
+
+  while (po){
+
+    /* residuals of the lowest MaxN states */
+
+    for (j=0; j<MaxN; j++) rnorm[j] = 0.0;
+
+    for (i=0; i<nl; i++){
+      for (j=0; j<MaxN; j++){
+        r = AV[i*m+j] - theta[j]*V[i*m+j];
+        rnorm[j] += r*r;
+      }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, rnorm, MaxN, MPI_DOUBLE, MPI_SUM, comm);
+
+    res = 0.0;
+    for (j=0; j<MaxN; j++){
+      if (res<rnorm[j]) res = rnorm[j];
+    }
+    res = sqrt(res);
+
+    if (2<=level_stdout && myid==Host_ID){
+      printf("<Eigen_Subspace> spin=%d iter=%2d  max residual=%10.5e\n",spin,iter,res);
+    }
+
+    if (res<Eigen_Subspace_Criterion) break;
+
+    if (Eigen_Subspace_MaxIter<=iter){
+      po = 0;
+      break;
+    }
+
+    /* filter damping [lb,ub] with the scaling at a0 */
+
+    lb = theta[m-1];
+    a0 = theta[0];
+    if (ub<=lb){
+      po = 0;
+      break;
+    }
+
+    e = 0.5*(ub - lb);
+    c = 0.5*(ub + lb);
+    sigma = e/(a0 - c);
+    tau = 2.0/sigma;
+
+    fac1 = sigma/e;
+    for (i=0; i<nl*m; i++){
+      X[i] = V[i];
+      Y[i] = (AV[i] - c*V[i])*fac1;
+    }
+
+    for (k=2; k<=deg; k++){
+
+      Gather_Rows(comm, Y, Vfull, m, rs, re);
+      Mult_A(nl, n, m, Aloc, Vfull, AY);
+
+      sigma1 = 1.0/(tau - sigma);
+      fac1 = 2.0*sigma1/e;
+      fac2 = sigma*sigma1;
+
+      for (i=0; i<nl*m; i++){
+        r = (AY[i] - c*Y[i])*fac1 - fac2*X[i];
+        X[i] = Y[i];
+        Y[i] = r;
+      }
+
+      sigma = sigma1;
+    }
+
+    /* Rayleigh-Ritz */
+
+    Gather_Rows(comm, Y, Vfull, m, rs, re);
+    Mult_A(nl, n, m, Aloc, Vfull, AY);
+
+    po = Rayleigh_Ritz(comm, nl, m, Y, AY, V, AV, theta);
+
+    iter++;
+  }
+
+  /* store the results */
+
+  if (po){
+
+    Gather_Rows(comm, V, Vfull, m, rs, re);
+
+    for (i=1; i<=n; i++){
+      for (j=1; j<=MaxN; j++){
+        a[i][j] = Vfull[(i-1)*m+(j-1)];
+      }
+    }
+
+    for (j=1; j<=MaxN; j++) ko[j] = theta[j-1];
+
+    free(Sub_V[spin]);
+    Sub_V[spin] = Vfull;
+    Sub_n[spin] = n;
+    Sub_m[spin] = m;
+  }
+  else {
+
+    if (1<=level_stdout && myid==Host_ID){
+      printf("<Eigen_Subspace> not converged, switch to the dense diagonalization\n");
+    }
+
+    free(Vfull);
+  }
+
+  /* freeing of arrays */
+
+  free(rnorm);
+  free(theta);
+  free(AY);
+  free(Y);
+  free(X);
+  free(AV);
+  free(V);
+  free(Aloc);
+  free(frozen);
+  free(re);
+  free(rs);
+
+  return po;
+}
+
+
+
+/****************************************************
+  Eigen_Subspace_Store keeps the lowest MaxN eigen-
+  vectors given in rows is[myid]..ie[myid] of H, i.e.,
+  H[j][1..n] is the j-th eigenvector.
+****************************************************/
+
+void Eigen_Subspace_Store(MPI_Comm comm, int spin, double **H, int n, int MaxN,
+                          int *is, int *ie)
+{
+  int i,j,ID,m,numprocs,myid;
+  int *cnt,*dsp;
+  double *loc;
+
+  MPI_Comm_size(comm,&numprocs);
+  MPI_Comm_rank(comm,&myid);
+
+  /* Eigen_Subspace uses at most n/2 vectors */
+
+  m = MaxN;
+  if (n/2<m) m = n/2;
+
+  cnt = (int*)malloc(sizeof(int)*numprocs);
+  dsp = (int*)malloc(sizeof(int)*numprocs);
+
+  for (ID=0; ID<numprocs; ID++){
+    if (is[ID]<=ie[ID] && is[ID]<=m){
+      dsp[ID] = (is[ID]-1)*n;
+      cnt[ID] = ((ie[ID]<m ? ie[ID] : m) - is[ID] + 1)*n;
+    }
+    else {
+      dsp[ID] = 0;
+      cnt[ID] = 0;
+    }
+  }
+
+  loc = (double*)malloc(sizeof(double)*(n*m+1));
+
+  if (cnt[myid]!=0){
+    for (j=is[myid]; j<=ie[myid] && j<=m; j++){
+      for (i=1; i<=n; i++){
+        loc[(j-1)*n+(i-1)] = H[j][i];
+      }
+    }
+  }
+
+  /* loc[(j-1)*n+(i-1)] is gathered, and then transposed */
+
+  MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DOUBLE, loc, cnt, dsp, MPI_DOUBLE, comm);
+
+  if (Sub_V[spin]!=NULL) free(Sub_V[spin]);
+  Sub_V[spin] = (double*)malloc(sizeof(double)*(n*m+1));
+
+  for (j=0; j<m; j++){
+    for (i=0; i<n; i++){
+      Sub_V[spin][i*m+j] = loc[j*n+i];
+    }
+  }
+
+  Sub_n[spin] = n;
+  Sub_m[spin] = m;
+
+  free(loc);
+  free(dsp);
+  free(cnt);
+}
+
+
+
+static void Gather_Rows(MPI_Comm comm, double *loc, double *full, int m, int *rs, int *re)
+{
+  int ID,numprocs,myid;
+  int *cnt,*dsp;
+
+  MPI_Comm_size(comm,&numprocs);
+  MPI_Comm_rank(comm,&myid);
+
+  cnt = (int*)malloc(sizeof(int)*numprocs);
+  dsp = (int*)malloc(sizeof(int)*numprocs);
+
+  for (ID=0; ID<numprocs; ID++){
+    cnt[ID] = (re[ID] - rs[ID])*m;
+    dsp[ID] = rs[ID]*m;
+  }
+
+  MPI_Allgatherv(loc, cnt[myid], MPI_DOUBLE, full, cnt, dsp, MPI_DOUBLE, comm);
+
+  free(dsp);
+  free(cnt);
+}
+
+
+
+/* AV[nl][m] = Aloc[nl][n] * V[n][m] in row-major order */
+
+static void Mult_A(int nl, int n, int m, double *Aloc, double *V, double *AV)
+{
+  double alpha=1.0,beta=0.0;
+
+  if (nl==0) return;
+
+  F77_NAME(dgemm,DGEMM)("N","N", &m, &nl, &n, &alpha, V, &m, Aloc, &n, &beta, AV, &m);
+}
+
+
+
+/****************************************************
+  Rayleigh_Ritz solves (Y^T A Y) q = theta (Y^T Y) q,
+  and gives V = Y*Q and AV = AY*Q. Y^T Y is
+  diagonalized first as S in Cluster_DFT.
+  0 is returned if Y is numerically rank deficient.
+****************************************************/
+
+static int Rayleigh_Ritz(MPI_Comm comm, int nl, int m, double *Y, double *AY,
+                         double *V, double *AV, double *theta)
+{
+  int i,j;
+  double *G,*Hs,*R,*ev;
+  double **b;
+  double alpha=1.0,beta=0.0;
+
+  G  = (double*)malloc(sizeof(double)*m*m);
+  Hs = (double*)malloc(sizeof(double)*m*m);
+  R  = (double*)malloc(sizeof(double)*m*m);
+  ev = (double*)malloc(sizeof(double)*(m+1));
+
+  b = (double**)malloc(sizeof(double*)*(m+1));
+  for (i=0; i<=m; i++){
+    b[i] = (double*)malloc(sizeof(double)*(m+1));
+  }
+
+  /* G = Y^T Y and Hs = Y^T AY */
+
+  if (nl!=0){
+    F77_NAME(dgemm,DGEMM)("N","T", &m, &m, &nl, &alpha, Y, &m, Y, &m, &beta, G, &m);
+    F77_NAME(dgemm,DGEMM)("N","T", &m, &m, &nl, &alpha, Y, &m, AY, &m, &beta, Hs, &m);
+  }
+  else {
+    for (i=0; i<m*m; i++){ G[i] = 0.0; Hs[i] = 0.0; }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, G, m*m, MPI_DOUBLE, MPI_SUM, comm);
+  MPI_Allreduce(MPI_IN_PLACE, Hs, m*m, MPI_DOUBLE, MPI_SUM, comm);
+
+  /* G = W ev W^T, and X = W ev^{-1/2} is stored in R */
+
+  for (i=0; i<m; i++){
+    for (j=0; j<m; j++){
+      b[i+1][j+1] = 0.5*(G[i*m+j] + G[j*m+i]);
+    }
+  }
+
+  Eigen_lapack(b, ev, m, m);
+
+  if (ev[1]<=1.0e-12*ev[m]){
+
+    for (i=0; i<=m; i++) free(b[i]);
+    free(b);
+    free(ev);
+    free(R);
+    free(Hs);
+    free(G);
+
+    return 0;
+  }
+
+  for (i=0; i<m; i++){
+    for (j=0; j<m; j++){
+      R[i*m+j] = b[i+1][j+1]/sqrt(ev[j+1]);
+    }
+  }
+
+  /* X^T Hs X, where the matrices are in row-major order */
+
+  F77_NAME(dgemm,DGEMM)("N","N", &m, &m, &m, &alpha, R, &m, Hs, &m, &beta, G, &m);
+  F77_NAME(dgemm,DGEMM)("N","T", &m, &m, &m, &alpha, G, &m, R, &m, &beta, Hs, &m);
+
+  for (i=0; i<m; i++){
+    for (j=0; j<m; j++){
+      b[i+1][j+1] = 0.5*(Hs[i*m+j] + Hs[j*m+i]);
+    }
+  }
+
+  Eigen_lapack(b, ev, m, m);
+
+  for (j=0; j<m; j++) theta[j] = ev[j+1];
+
+  /* rotation: X Q */
+
+  for (i=0; i<m; i++){
+    for (j=0; j<m; j++){
+      Hs[i*m+j] = b[i+1][j+1];
+    }
+  }
+
+  F77_NAME(dgemm,DGEMM)("N","N", &m, &m, &m, &alpha, Hs, &m, R, &m, &beta, G, &m);
+
+  if (nl!=0){
+    F77_NAME(dgemm,DGEMM)("N","N", &m, &nl, &m, &alpha, G, &m, Y, &m, &beta, V, &m);
+    F77_NAME(dgemm,DGEMM)("N","N", &m, &nl, &m, &alpha, G, &m, AY, &m, &beta, AV, &m);
+  }
+
+  /* freeing of arrays */
+
+  for (i=0; i<=m; i++) free(b[i]);
+  free(b);
+  free(ev);
+  free(R);
+  free(Hs);
+  free(G);
+
+  return 1;
+}
+
+
+
+/****************************************************
+  an upper bound of the spectrum by the Lanczos
+  method with 10 steps, excluding the frozen rows
+****************************************************/
+
+static double Upper_Bound(double **a, int n, int *frozen)
+{
+  int i,j,k,kmax,kd;
+  double *v0,*v1,*w,*al,*be,*ev;
+  double **T;
+  double sum,ub;
+
+  kmax = 10;
+  if (n<kmax) kmax = n;
+
+  v0 = (double*)malloc(sizeof(double)*(n+1));
+  v1 = (double*)malloc(sizeof(double)*(n+1));
+  w  = (double*)malloc(sizeof(double)*(n+1));
+  al = (double*)malloc(sizeof(double)*(kmax+1));
+  be = (double*)malloc(sizeof(double)*(kmax+1));
+  ev = (double*)malloc(sizeof(double)*(kmax+1));
+
+  kd = kmax;
+  T = (double**)malloc(sizeof(double*)*(kmax+1));
+  for (i=0; i<=kmax; i++){
+    T[i] = (double*)malloc(sizeof(double)*(kmax+1));
+    for (j=0; j<=kmax; j++) T[i][j] = 0.0;
+  }
+
+  sum = 0.0;
+  for (i=1; i<=n; i++){
+    v0[i] = 0.0;
+    v1[i] = frozen[i] ? 0.0 : 1.0 + 0.1*sin((double)i);
+    sum += v1[i]*v1[i];
+  }
+  sum = 1.0/sqrt(sum);
+  for (i=1; i<=n; i++) v1[i] *= sum;
+
+  be[0] = 0.0;
+
+  for (k=1; k<=kmax; k++){
+
+#pragma omp parallel for private(i,j,sum)
+    for (i=1; i<=n; i++){
+      sum = 0.0;
+      for (j=1; j<=n; j++) sum += a[i][j]*v1[j];
+      w[i] = sum;
+    }
+
+    sum = 0.0;
+    for (i=1; i<=n; i++) sum += w[i]*v1[i];
+    al[k] = sum;
+
+    sum = 0.0;
+    for (i=1; i<=n; i++){
+      w[i] -= al[k]*v1[i] + be[k-1]*v0[i];
+      sum += w[i]*w[i];
+    }
+    be[k] = sqrt(sum);
+
+    if (be[k]<1.0e-12){
+      kmax = k;
+      break;
+    }
+
+    for (i=1; i<=n; i++){
+      v0[i] = v1[i];
+      v1[i] = w[i]/be[k];
+    }
+  }
+
+  for (k=1; k<=kmax; k++){
+    T[k][k] = al[k];
+    if (k<kmax){
+      T[k][k+1] = be[k];
+      T[k+1][k] = be[k];
+    }
+  }
+
+  Eigen_lapack(T, ev, kmax, kmax);
+
+  ub = ev[kmax] + be[kmax];
+
+  for (i=0; i<=kd; i++) free(T[i]);
+  free(T);
+  free(ev);
+  free(be);
+  free(al);
+  free(w);
+  free(v1);
+  free(v0);
+
+  return ub;
+}
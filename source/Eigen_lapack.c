@@ -140,13 +140,15 @@ void Eigen_lapack_x(double **a, double *ko, int n0, int EVmax)
 
   int i,j;
 
-  A=(double*)malloc(sizeof(double)*n*n);
-  Z=(double*)malloc(sizeof(double)*n*n);
+  Arena_Push();
+
+  A=(double*)Arena_Alloc(sizeof(double)*n*n);
+  Z=(double*)Arena_Alloc(sizeof(double)*n*n);
 
   LWORK=n*8;
-  WORK=(double*)malloc(sizeof(double)*LWORK);
-  IWORK=(INTEGER*)malloc(sizeof(INTEGER)*n*5);
-  IFAIL=(INTEGER*)malloc(sizeof(INTEGER)*n);
+  WORK=(double*)Arena_Alloc(sizeof(double)*LWORK);
+  IWORK=(INTEGER*)Arena_Alloc(sizeof(INTEGER)*n*5);
+  IFAIL=(INTEGER*)Arena_Alloc(sizeof(INTEGER)*n);
 
   IL = 1;
   IU = EVmax;
@@ -197,7 +199,7 @@ void Eigen_lapack_x(double **a, double *ko, int n0, int EVmax)
      exit(10);
   }
    
-  free(IFAIL); free(IWORK); free(WORK); free(Z); free(A);
+  Arena_Pop();
 
 }
 
@@ -235,13 +237,15 @@ void Eigen_lapack_d(double **a, double *ko, int n0, int EVmax)
 
   int i,j;
 
-  A=(double*)malloc(sizeof(double)*n*n);
+  Arena_Push();
+
+  A=(double*)Arena_Alloc(sizeof(double)*n*n);
 
   LWORK=  1 + 6*n + 2*n*n;
-  WORK=(double*)malloc(sizeof(double)*LWORK);
+  WORK=(double*)Arena_Alloc(sizeof(double)*LWORK);
 
   LIWORK = 3 + 5*n;
-  IWORK=(INTEGER*)malloc(sizeof(INTEGER)*LIWORK);
+  IWORK=(INTEGER*)Arena_Alloc(sizeof(INTEGER)*LIWORK);
 
 
   IL = 1;
@@ -290,7 +294,7 @@ void Eigen_lapack_d(double **a, double *ko, int n0, int EVmax)
      exit(10);
   }
    
-  free(IWORK); free(WORK); free(A);
+  Arena_Pop();
 }
 
 
@@ -329,16 +333,18 @@ void Eigen_lapack_r(double **a, double *ko, int n0, int EVmax)
 
   int i,j;
 
-  A=(double*)malloc(sizeof(double)*n*n);
-  Z=(double*)malloc(sizeof(double)*n*n);
+  Arena_Push();
+
+  A=(double*)Arena_Alloc(sizeof(double)*n*n);
+  Z=(double*)Arena_Alloc(sizeof(double)*n*n);
 
   LWORK= (n+16)*n;   /*  n*26 of (n+6)*n */
-  WORK=(double*)malloc(sizeof(double)*LWORK);
+  WORK=(double*)Arena_Alloc(sizeof(double)*LWORK);
 
   LIWORK = (n+1)*n;  /*  n*10 or ??? */
-  IWORK=(INTEGER*)malloc(sizeof(INTEGER)*LIWORK);
+  IWORK=(INTEGER*)Arena_Alloc(sizeof(INTEGER)*LIWORK);
 
-  ISUPPZ =(INTEGER*)malloc(sizeof(INTEGER)*n*2);
+  ISUPPZ =(INTEGER*)Arena_Alloc(sizeof(INTEGER)*n*2);
 
   IL = 1;
   IU = EVmax; 
@@ -388,7 +394,7 @@ void Eigen_lapack_r(double **a, double *ko, int n0, int EVmax)
      exit(10);
   }
    
-  free(ISUPPZ); free(IWORK); free(WORK); free(Z); free(A);
+  Arena_Pop();
 
 }
 
@@ -7,6 +7,8 @@
   Log of FT_NLP.c:
 
      15/Sep/2002  Released by T.Ozaki
+     18/Oct/2026  Spe_NLRF_Bessel in a node-shared window
+     18/Oct/2026  Spe_NLRF_Bessel kept in the species cache
 
 ***********************************************************************/
 
@@ -25,17 +27,21 @@
 
 
 
+static int Table_Rows(double **rows);
+
 void FT_NLP()
 {
   int numprocs,myid,ID,tag=999;
   int count,NumSpe;
   int i,kj,num_k,so;
   int Lspe,spe,L,GL,MaxGL;
-  int RestartRead_Succeed;
+  int RestartRead_Succeed,nrows;
+  double **rows;
   double dk,norm_k;
   double rmin,rmax,r,r2,h,sum[2];
   double **SphB;
   double *tmp_SphB,*tmp_SphBp;
+  double *tmp_read;
   double TStime, TEtime;
   /* for MPI */
   MPI_Status stat;
@@ -77,6 +83,10 @@ void FT_NLP()
                       read Spe_NLRF_Bessel
     ***********************************************************/
 
+    /* all the processes read the file, and the writer of the node stores it */
+
+    tmp_read = (double*)malloc(sizeof(double)*List_YOUSO[15]);
+
     sprintf(fileFT,"%s%s_rst/%s.ftnlp",filepath,filename,filename);
 
     if ((fp = fopen(fileFT,"rb")) != NULL){
@@ -87,8 +97,11 @@ void FT_NLP()
 	for (so=0; so<=VPS_j_dependency[spe]; so++){
 	  for (L=1; L<=Spe_Num_RVPS[spe]; L++){
 
-	    size = fread(&Spe_NLRF_Bessel[so][spe][L][0],sizeof(double),List_YOUSO[15],fp);
+	    size = fread(tmp_read,sizeof(double),List_YOUSO[15],fp);
 	    if (size!=List_YOUSO[15]) RestartRead_Succeed = 0;
+	    if (Shm_Writer(Spe_NLRF_Bessel)){
+	      for (i=0; i<List_YOUSO[15]; i++) Spe_NLRF_Bessel[so][spe][L][i] = tmp_read[i];
+	    }
 	  }
 	}
       }
@@ -98,6 +111,29 @@ void FT_NLP()
     else{
       printf("Could not open a file %s in FT_NLP\n",fileFT);
     }
+
+    free(tmp_read);
+    Shm_Sync();
+  }
+
+  /***********************************************************
+     otherwise, read Spe_NLRF_Bessel from the species cache
+  ***********************************************************/
+
+  else if (Species_Cache_File(".ftnlp",fileFT)){
+
+    dk = PAO_Nkmax/(double)Ngrid_NormK;
+    for (i=0; i<Ngrid_NormK; i++){
+      NormK[i] = (double)i*dk;
+    }
+
+    nrows = Table_Rows(NULL);
+    rows = (double**)malloc(sizeof(double*)*nrows);
+    Table_Rows(rows);
+
+    RestartRead_Succeed = Species_Cache_Read(fileFT, Spe_NLRF_Bessel, rows, nrows, List_YOUSO[15]);
+
+    free(rows);
   }
 
   /***********************************************************
@@ -229,8 +265,8 @@ void FT_NLP()
 	spe = Species_Top[ID] + Lspe;
 	for (so=0; so<=VPS_j_dependency[spe]; so++){
 	  for (L=1; L<=Spe_Num_RVPS[spe]; L++){
-	    MPI_Bcast(&Spe_NLRF_Bessel[so][spe][L][0],
-		      List_YOUSO[15],MPI_DOUBLE,ID,mpi_comm_level1);
+	    Shm_Bcast_Double(Spe_NLRF_Bessel, &Spe_NLRF_Bessel[so][spe][L][0],
+		         List_YOUSO[15], ID);
 	  }
 	}
       }
@@ -261,6 +297,21 @@ void FT_NLP()
       }
     }
 
+    /***********************************************************
+                 save Spe_NLRF_Bessel in the species cache
+    ***********************************************************/
+
+    if (Species_Cache_File(".ftnlp",fileFT)){
+
+      nrows = Table_Rows(NULL);
+      rows = (double**)malloc(sizeof(double*)*nrows);
+      Table_Rows(rows);
+
+      Species_Cache_Write(fileFT, rows, nrows, List_YOUSO[15]);
+
+      free(rows);
+    }
+
   } /* if (RestartRead_Succeed==0) */
 
   /***********************************************************
@@ -276,3 +327,23 @@ void FT_NLP()
   */
 
 }
+
+
+static int Table_Rows(double **rows)
+{
+  int spe,so,L,n;
+
+  /* rows of the table in the order of the file */
+
+  n = 0;
+  for (spe=0; spe<SpeciesNum; spe++){
+    for (so=0; so<=VPS_j_dependency[spe]; so++){
+      for (L=1; L<=Spe_Num_RVPS[spe]; L++){
+        if (rows!=NULL) rows[n] = Spe_NLRF_Bessel[so][spe][L];
+        n++;
+      }
+    }
+  }
+
+  return n;
+}
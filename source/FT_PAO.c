@@ -7,6 +7,8 @@
   Log of FT_PAO.c:
 
      15/Sep/2002  Released by T.Ozaki
+     18/Oct/2026  Spe_RF_Bessel in a node-shared window
+     18/Oct/2026  Spe_RF_Bessel kept in the species cache
 
 ***********************************************************************/
 
@@ -26,19 +28,23 @@
 
 
 
+static int Table_Rows(double **rows);
+
 void FT_PAO()
 {
   int numprocs,myid,ID,tag=999;
   int count,NumSpe;
   int i,kj,num_k;
   int Lspe,spe,GL,Mul;
-  int RestartRead_Succeed;
+  int RestartRead_Succeed,nrows;
+  double **rows;
   double dk,norm_k,h;
   double rmin,rmax,r,r2,sum;
   double sy,sjp,syp;
   double Sr,Dr,dum0;
   double **SphB;
   double *tmp_SphB,*tmp_SphBp;
+  double *tmp_read;
   double TStime, TEtime;
   /* for MPI */
   MPI_Status stat;
@@ -80,6 +86,10 @@ void FT_PAO()
                       read Spe_RF_Bessel
     ***********************************************************/
 
+    /* all the processes read the file, and the writer of the node stores it */
+
+    tmp_read = (double*)malloc(sizeof(double)*List_YOUSO[15]);
+
     sprintf(fileFT,"%s%s_rst/%s.ftpao",filepath,filename,filename);
 
     if ((fp = fopen(fileFT,"rb")) != NULL){
@@ -90,8 +100,11 @@ void FT_PAO()
 	for (GL=0; GL<=Spe_MaxL_Basis[spe]; GL++){
 	  for (Mul=0; Mul<Spe_Num_Basis[spe][GL]; Mul++){
 
-	    size = fread(&Spe_RF_Bessel[spe][GL][Mul][0],sizeof(double),List_YOUSO[15],fp);
+            size = fread(tmp_read,sizeof(double),List_YOUSO[15],fp);
             if (size!=List_YOUSO[15]) RestartRead_Succeed = 0;
+            if (Shm_Writer(Spe_RF_Bessel)){
+              for (i=0; i<List_YOUSO[15]; i++) Spe_RF_Bessel[spe][GL][Mul][i] = tmp_read[i];
+            }
 	  }
 	}
       }  
@@ -101,6 +114,29 @@ void FT_PAO()
     else{
       printf("Could not open a file %s in FT_PAO\n",fileFT);
     }
+
+    free(tmp_read);
+    Shm_Sync();
+  }
+
+  /***********************************************************
+     otherwise, read Spe_RF_Bessel from the species cache
+  ***********************************************************/
+
+  else if (Species_Cache_File(".ftpao",fileFT)){
+
+    dk = PAO_Nkmax/(double)Ngrid_NormK;
+    for (i=0; i<Ngrid_NormK; i++){
+      NormK[i] = (double)i*dk;
+    }
+
+    nrows = Table_Rows(NULL);
+    rows = (double**)malloc(sizeof(double*)*nrows);
+    Table_Rows(rows);
+
+    RestartRead_Succeed = Species_Cache_Read(fileFT, Spe_RF_Bessel, rows, nrows, List_YOUSO[15]);
+
+    free(rows);
   }
 
   /***********************************************************
@@ -222,8 +258,8 @@ void FT_PAO()
 	for (GL=0; GL<=Spe_MaxL_Basis[spe]; GL++){
 	  for (Mul=0; Mul<Spe_Num_Basis[spe][GL]; Mul++){
 
-	    MPI_Bcast(&Spe_RF_Bessel[spe][GL][Mul][0],
-		      List_YOUSO[15],MPI_DOUBLE,ID, mpi_comm_level1);
+	    Shm_Bcast_Double(Spe_RF_Bessel, &Spe_RF_Bessel[spe][GL][Mul][0],
+		         List_YOUSO[15], ID);
             MPI_Barrier(mpi_comm_level1);
 	  }
 	}
@@ -258,6 +294,21 @@ void FT_PAO()
       }
     }
 
+    /***********************************************************
+                 save Spe_RF_Bessel in the species cache
+    ***********************************************************/
+
+    if (Species_Cache_File(".ftpao",fileFT)){
+
+      nrows = Table_Rows(NULL);
+      rows = (double**)malloc(sizeof(double*)*nrows);
+      Table_Rows(rows);
+
+      Species_Cache_Write(fileFT, rows, nrows, List_YOUSO[15]);
+
+      free(rows);
+    }
+
   } /* if (RestartRead_Succeed==0) */
 
   /***********************************************************
@@ -275,4 +326,21 @@ void FT_PAO()
 }
 
 
+static int Table_Rows(double **rows)
+{
+  int spe,GL,Mul,n;
+
+  /* rows of the table in the order of the file */
+
+  n = 0;
+  for (spe=0; spe<SpeciesNum; spe++){
+    for (GL=0; GL<=Spe_MaxL_Basis[spe]; GL++){
+      for (Mul=0; Mul<Spe_Num_Basis[spe][GL]; Mul++){
+        if (rows!=NULL) rows[n] = Spe_RF_Bessel[spe][GL][Mul];
+        n++;
+      }
+    }
+  }
 
+  return n;
+}
@@ -7,6 +7,8 @@
   Log of FT_ProExpn_VNA.c:
 
      7/Apr/2004  Released by T.Ozaki
+     18/Oct/2026  Spe_VNA_Bessel in a node-shared window
+     18/Oct/2026  Spe_VNA_Bessel kept in the species cache
 
 ***********************************************************************/
 
@@ -25,13 +27,16 @@
 
 
 
+static int Table_Rows(double **rows);
+
 void FT_ProExpn_VNA()
 {
   int numprocs,myid,ID,tag=999;
   int count,NumSpe;
   int L,i,kj;
   int Lspe,spe,GL,Mul;
-  int RestartRead_Succeed;
+  int RestartRead_Succeed,nrows;
+  double **rows;
   double Sr,Dr;
   double norm_k,h,dum0;
   double rmin,rmax,r,sum;
@@ -41,6 +46,7 @@ void FT_ProExpn_VNA()
   double tmp0,tmp1;
   double **SphB;
   double *tmp_SphB,*tmp_SphBp;
+  double *tmp_read;
   double TStime, TEtime;
   /* for MPI */
   MPI_Status stat;
@@ -87,6 +93,10 @@ void FT_ProExpn_VNA()
                         read Spe_VNA_Bessel
     ***********************************************************/
 
+    /* all the processes read the file, and the writer of the node stores it */
+
+    tmp_read = (double*)malloc(sizeof(double)*GL_Mesh);
+
     sprintf(fileFT,"%s%s_rst/%s.ftPEvna",filepath,filename,filename);
 
     if ((fp = fopen(fileFT,"rb")) != NULL){
@@ -97,8 +107,11 @@ void FT_ProExpn_VNA()
         for (L=0; L<=List_YOUSO[35]; L++){
 	  for (Mul=0; Mul<List_YOUSO[34]; Mul++){
 
-	    size = fread(&Spe_VNA_Bessel[spe][L][Mul][0],sizeof(double),GL_Mesh,fp);
+	    size = fread(tmp_read,sizeof(double),GL_Mesh,fp);
 	    if (size!=GL_Mesh) RestartRead_Succeed = 0;
+	    if (Shm_Writer(Spe_VNA_Bessel)){
+	      for (i=0; i<GL_Mesh; i++) Spe_VNA_Bessel[spe][L][Mul][i] = tmp_read[i];
+	    }
 	  }
         }
       }
@@ -108,6 +121,33 @@ void FT_ProExpn_VNA()
     else{
       printf("Could not open a file %s in FT_ProExpn_VNA\n",fileFT);
     }
+
+    free(tmp_read);
+    Shm_Sync();
+  }
+
+  /***********************************************************
+     otherwise, read Spe_VNA_Bessel from the species cache
+  ***********************************************************/
+
+  else if (Species_Cache_File(".ftPEvna",fileFT)){
+
+    for (kj=0; kj<GL_Mesh; kj++){
+      kmin = Radial_kmin;
+      kmax = PAO_Nkmax;
+      Sk = kmax + kmin;
+      Dk = kmax - kmin;
+      norm_k = 0.50*(Dk*GL_Abscissae[kj] + Sk);
+      GL_NormK[kj] = norm_k;
+    }
+
+    nrows = Table_Rows(NULL);
+    rows = (double**)malloc(sizeof(double*)*nrows);
+    Table_Rows(rows);
+
+    RestartRead_Succeed = Species_Cache_Read(fileFT, Spe_VNA_Bessel, rows, nrows, GL_Mesh);
+
+    free(rows);
   }
 
   /***********************************************************
@@ -248,8 +288,8 @@ void FT_ProExpn_VNA()
 	spe = Species_Top[ID] + Lspe;
 	for (L=0; L<=List_YOUSO[35]; L++){
 	  for (Mul=0; Mul<List_YOUSO[34]; Mul++){
-	    MPI_Bcast(&Spe_VNA_Bessel[spe][L][Mul][0],
-		      GL_Mesh,MPI_DOUBLE,ID,mpi_comm_level1);
+	    Shm_Bcast_Double(Spe_VNA_Bessel, &Spe_VNA_Bessel[spe][L][Mul][0],
+		         GL_Mesh, ID);
 	  }
 	}
       }
@@ -280,6 +320,21 @@ void FT_ProExpn_VNA()
       }
     }
 
+    /***********************************************************
+                 save Spe_VNA_Bessel in the species cache
+    ***********************************************************/
+
+    if (Species_Cache_File(".ftPEvna",fileFT)){
+
+      nrows = Table_Rows(NULL);
+      rows = (double**)malloc(sizeof(double*)*nrows);
+      Table_Rows(rows);
+
+      Species_Cache_Write(fileFT, rows, nrows, GL_Mesh);
+
+      free(rows);
+    }
+
   } /* if (RestartRead_Succeed==0) */
 
   /***********************************************************
@@ -297,5 +352,21 @@ void FT_ProExpn_VNA()
 }
 
 
+static int Table_Rows(double **rows)
+{
+  int spe,L,Mul,n;
 
+  /* rows of the table in the order of the file */
 
+  n = 0;
+  for (spe=0; spe<SpeciesNum; spe++){
+    for (L=0; L<=List_YOUSO[35]; L++){
+      for (Mul=0; Mul<List_YOUSO[34]; Mul++){
+        if (rows!=NULL) rows[n] = Spe_VNA_Bessel[spe][L][Mul];
+        n++;
+      }
+    }
+  }
+
+  return n;
+}
@@ -7,6 +7,7 @@
   Log of FT_ProductPAO.c:
 
      18/May/2004  Released by T.Ozaki
+     18/Oct/2026  Spe_ProductRF_Bessel kept in the species cache
 
 ***********************************************************************/
 
@@ -26,13 +27,16 @@
 
 
 
+static int Table_Rows(double **rows);
+
 void FT_ProductPAO()
 {
   int numprocs,myid,ID,tag=999;
   int count,NumSpe;
   int L,i,j,kj,l,Lmax;
   int Lspe,spe,GL,GL1,Mul1,GL2,Mul2;
-  int RestartRead_Succeed;
+  int RestartRead_Succeed,nrows;
+  double **rows;
   double Sr,Dr,Sk,Dk,kmin,kmax;
   double norm_k,h,dum0;
   double rmin,rmax,r,sum;
@@ -128,6 +132,30 @@ void FT_ProductPAO()
     }
   }
 
+  /***********************************************************
+     otherwise, read Spe_ProductRF_Bessel from the species cache
+  ***********************************************************/
+
+  else if (Species_Cache_File(".ftProPAO",fileFT)){
+
+    for (j=0; j<GL_Mesh; j++){
+      kmin = Radial_kmin;
+      kmax = PAO_Nkmax;
+      Sk = kmax + kmin;
+      Dk = kmax - kmin;
+      norm_k = 0.50*(Dk*GL_Abscissae[j] + Sk);
+      GL_NormK[j] = norm_k;
+    }
+
+    nrows = Table_Rows(NULL);
+    rows = (double**)malloc(sizeof(double*)*nrows);
+    Table_Rows(rows);
+
+    RestartRead_Succeed = Species_Cache_Read(fileFT, Spe_ProductRF_Bessel, rows, nrows, GL_Mesh);
+
+    free(rows);
+  }
+
   /***********************************************************
    if (RestartRead_Succeed==0), calculate Spe_ProductRF_Bessel
   ***********************************************************/
@@ -356,6 +384,21 @@ void FT_ProductPAO()
       }
     }
 
+    /***********************************************************
+                 save Spe_ProductRF_Bessel in the species cache
+    ***********************************************************/
+
+    if (Species_Cache_File(".ftProPAO",fileFT)){
+
+      nrows = Table_Rows(NULL);
+      rows = (double**)malloc(sizeof(double*)*nrows);
+      Table_Rows(rows);
+
+      Species_Cache_Write(fileFT, rows, nrows, GL_Mesh);
+
+      free(rows);
+    }
+
   } /* if (RestartRead_Succeed==0) */
 
   /***********************************************************
@@ -371,3 +414,29 @@ void FT_ProductPAO()
   */
 
 }
+
+
+static int Table_Rows(double **rows)
+{
+  int spe,GL1,Mul1,GL2,Mul2,l,n;
+
+  /* rows of the table in the order of the file */
+
+  n = 0;
+  for (spe=0; spe<SpeciesNum; spe++){
+    for (GL1=0; GL1<=Spe_MaxL_Basis[spe]; GL1++){
+      for (Mul1=0; Mul1<Spe_Num_Basis[spe][GL1]; Mul1++){
+        for (GL2=GL1; GL2<=Spe_MaxL_Basis[spe]; GL2++){
+          for (Mul2=0; Mul2<Spe_Num_Basis[spe][GL2]; Mul2++){
+            for (l=0; l<=2*GL2; l++){
+              if (rows!=NULL) rows[n] = Spe_ProductRF_Bessel[spe][GL1][Mul1][GL2][Mul2][l];
+              n++;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return n;
+}
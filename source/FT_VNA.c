@@ -6,6 +6,7 @@
   Log of FT_VNA.c:
 
      18/May/2004  Released by T.Ozaki
+     18/Oct/2026  Spe_CrudeVNA_Bessel kept in the species cache
 
 ***********************************************************************/
 
@@ -26,13 +27,16 @@
 
 
 
+static int Table_Rows(double **rows);
+
 void FT_VNA()
 {
   int numprocs,myid,ID,tag=999;
   int count,NumSpe;
   int L,i,j;
   int Lspe,spe,GL,Mul;
-  int RestartRead_Succeed;
+  int RestartRead_Succeed,nrows;
+  double **rows;
   double Sr,Dr,Sk,Dk,kmin,kmax;
   double norm_k,h,dum0;
   double xmin,xmax,x,r,sum;
@@ -108,6 +112,30 @@ void FT_VNA()
     }
   }
 
+  /***********************************************************
+     otherwise, read Spe_CrudeVNA_Bessel from the species cache
+  ***********************************************************/
+
+  else if (Species_Cache_File(".ftCvna",fileFT)){
+
+    for (j=0; j<GL_Mesh; j++){
+      kmin = Radial_kmin;
+      kmax = PAO_Nkmax;
+      Sk = kmax + kmin;
+      Dk = kmax - kmin;
+      norm_k = 0.50*(Dk*GL_Abscissae[j] + Sk);
+      GL_NormK[j] = norm_k;
+    }
+
+    nrows = Table_Rows(NULL);
+    rows = (double**)malloc(sizeof(double*)*nrows);
+    Table_Rows(rows);
+
+    RestartRead_Succeed = Species_Cache_Read(fileFT, Spe_CrudeVNA_Bessel, rows, nrows, GL_Mesh);
+
+    free(rows);
+  }
+
   /***********************************************************
    if (RestartRead_Succeed==0), calculate Spe_CrudeVNA_Bessel
   ***********************************************************/
@@ -239,6 +267,21 @@ void FT_VNA()
       }
     }
 
+    /***********************************************************
+                 save Spe_CrudeVNA_Bessel in the species cache
+    ***********************************************************/
+
+    if (Species_Cache_File(".ftCvna",fileFT)){
+
+      nrows = Table_Rows(NULL);
+      rows = (double**)malloc(sizeof(double*)*nrows);
+      Table_Rows(rows);
+
+      Species_Cache_Write(fileFT, rows, nrows, GL_Mesh);
+
+      free(rows);
+    }
+
   } /* if (RestartRead_Succeed==0) */
 
   /***********************************************************
@@ -255,5 +298,17 @@ void FT_VNA()
 }
 
 
+static int Table_Rows(double **rows)
+{
+  int spe,n;
 
+  /* rows of the table in the order of the file */
 
+  n = 0;
+  for (spe=0; spe<SpeciesNum; spe++){
+    if (rows!=NULL) rows[n] = Spe_CrudeVNA_Bessel[spe];
+    n++;
+  }
+
+  return n;
+}
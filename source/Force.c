@@ -7,12 +7,16 @@
 
      22/Nov/2001  Released by T. Ozaki
      18/Apr/2013  Force3() modified by A.M. Ito
+     18/Oct/2026  modes "force", "stress", and "force+stress" added;
+                  in "force+stress" #1-#5 and the on-site parts of the
+                  projector terms are taken from Stress()
 
 ***********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 #include "openmx_common.h"
 #include "mpi.h"
@@ -40,7 +44,7 @@ static void dHVNA(int where_flag, int Mc_AN, int h_AN, int q_AN,
                   double **Hx, double **Hy, double **Hz);
 
 
-static void dHNL_SO(
+void dHNL_SO(
 	     double *sumx0r,
 	     double *sumy0r, 
 	     double *sumz0r, 
@@ -69,15 +73,19 @@ static void dHNL_SO(
 	     int Mj_AN, int kl, int n,
 	     double ******DS_NL1);
 
-static void MPI_OLP(double *****OLP1);
+void MPI_OLP(double *****OLP1);
 static void Force3();
 static void Force4();
 static void Force4B(double *****CDM0);
 
 static void Force_HNL(double *****CDM0, double *****iDM0);
 
+/* 1: the terms shared with the stress have been evaluated in Stress() */
+static int Stress_flag;
+
 
-double Force(double *****H0,
+double Force(char *mode,
+             double *****H0,
              double ******DS_NL,
              double *****OLP,
              double *****CDM,
@@ -138,9 +146,39 @@ double Force(double *****H0,
   MPI_Comm_size(mpi_comm_level1,&numprocs);
   MPI_Comm_rank(mpi_comm_level1,&myid);
 
+  /* stress only */
+
+  if (strcasecmp(mode,"stress")==0){
+    return Stress("stress",H0,DS_NL,OLP,CDM,EDM);
+  }
+
   MPI_Barrier(mpi_comm_level1);
   dtime(&TStime);
 
+  /****************************************************
+   In case of "force+stress", Stress() adds #1-#5 and 
+   the terms of Force4B() and Force_HNL() with I=i or 
+   I=j to Gxyz[][17,18,19] while evaluating the stress, 
+   so that each derivative block is computed only once.
+   Since Stress() does not evaluate the terms of LDA+U,
+   the constraint, and the Zeeman terms, the stress and
+   the forces are calculated separately in those cases.
+  ****************************************************/
+
+  if (strcasecmp(mode,"force+stress")==0
+      && Hub_U_switch==0 && Constraint_NCS_switch==0
+      && Zeeman_NCS_switch==0 && Zeeman_NCO_switch==0){
+    Stress_flag = 1;
+    Stress("force+stress",H0,DS_NL,OLP,CDM,EDM);
+  }
+  else if (strcasecmp(mode,"force+stress")==0){
+    Stress_flag = 0;
+    Stress("stress",H0,DS_NL,OLP,CDM,EDM);
+  }
+  else{
+    Stress_flag = 0;
+  }
+
   /****************************************************
    allocation of arrays:
   ****************************************************/
@@ -663,6 +701,8 @@ double Force(double *****H0,
   } /* if ( SO_switch==1 || (Hub_U_switch==1 && F_U_flag==1 && SpinP_switch==3) 
      || 1<=Constraint_NCS_switch || Zeeman_NCS_switch==1 || Zeeman_NCO_switch==1) */
 
+  if (Stress_flag) goto Force1_wall;
+
   /****************************************************
                       #1 of force
 
@@ -822,6 +862,8 @@ double Force(double *****H0,
      the boundary of the unit cell along the a-axis.
   ****************************************************/
 
+ Force1_wall:
+
   if (ESM_switch!=0){
 
     double fx,xb,x0,x,a;
@@ -886,6 +928,8 @@ double Force(double *****H0,
 
   MPI_Barrier(mpi_comm_level1);
 
+  if (Stress_flag) goto Force4_VNA;
+
   /****************************************************
                       #2 of force
 
@@ -1455,13 +1499,15 @@ double Force(double *****H0,
        Force4B:  from separable VNA projectors
   ****************************************************/
 
+ Force4_VNA:
+
   dtime(&stime);
 
   if (myid==Host_ID && 0<level_stdout){
     printf("  Force calculation #4\n");fflush(stdout);
   }
 
-  if (ProExpn_VNA==0 && F_VNA_flag==1){
+  if (ProExpn_VNA==0 && F_VNA_flag==1 && Stress_flag==0){
     Force4();
   }
   else if (ProExpn_VNA==1 && F_VNA_flag==1){
@@ -1473,6 +1519,8 @@ double Force(double *****H0,
     printf("Time for force#4=%18.5f\n",etime-stime);fflush(stdout);
   } 
 
+  if (Stress_flag) goto Force_U_dual;
+
   /****************************************************
                       #5 of Force
 
@@ -1576,6 +1624,8 @@ double Force(double *****H0,
    term is added.  
   ****************************************************************/
 
+ Force_U_dual:
+
   if (   (Hub_U_switch==1 || 1<=Constraint_NCS_switch || Zeeman_NCS_switch==1 || Zeeman_NCO_switch==1)
 	 && (Hub_U_occupation==1 || Hub_U_occupation==2)
 	 && SpinP_switch!=3 ){
@@ -2274,7 +2324,17 @@ void Force3()
 	double dy = y - Gxyz[Gc_AN][2];
 	double dz = z - Gxyz[Gc_AN][3];
 
-	if (Cnt_switch==0){
+	/* gradients stored by Set_Orbitals_Grid() */
+
+	if (dOrbs_Grid_flag && dOrbs_Grid_kind==Cnt_switch){
+	  int i;
+	  for (i=0; i<NO0; i++){
+	    dorbs0[1][i] = dOrbs_Grid[Mc_AN][Nc][3*i  ];
+	    dorbs0[2][i] = dOrbs_Grid[Mc_AN][Nc][3*i+1];
+	    dorbs0[3][i] = dOrbs_Grid[Mc_AN][Nc][3*i+2];
+	  }
+	}
+	else if (Cnt_switch==0){
 	  Get_dOrbitals(Cwan,dx,dy,dz,dorbs0);
 	}else{
 	  Get_Cnt_dOrbitals(Mc_AN,dx,dy,dz,dorbs0);
@@ -3178,6 +3238,8 @@ void Force_HNL(double *****CDM0, double *****iDM0)
     }
   }
 
+  if (Stress_flag) goto Second_Case;
+
   /*****************************************}********************** 
       THE FIRST CASE:
       In case of I=i or I=j 
@@ -4026,6 +4088,8 @@ void Force_HNL(double *****CDM0, double *****iDM0)
      on own site but projector part is located on own site. 
   ************************************************************/
 
+ Second_Case:
+
   MPI_Barrier(mpi_comm_level1);
   dtime(&stime);
 
@@ -4693,6 +4757,10 @@ void Force4B(double *****CDM0)
     }
   }
 
+  /* in case of "force+stress", the following has been done in Stress4B() */
+
+  if (Stress_flag) goto Second_Case;
+
   /*****************************************************
      (1) pre-multiplying DS_VNA[kk] with ene
      (2) copy DS_VNA[kk] or CntDS_VNA[kk] into DS_VNA[kk]
@@ -5275,6 +5343,8 @@ void Force4B(double *****CDM0)
      on own site but projector part is located on own site. 
   ************************************************************/
 
+ Second_Case:
+
   MPI_Barrier(mpi_comm_level1);
   dtime(&stime);
 
@@ -218,22 +218,27 @@ void array0()
     /* AITUNE */
     /* Orbs_Grid */
     for (Mc_AN=0; Mc_AN<=Matomnum; Mc_AN++){
-      if (Mc_AN==0){
-        Gc_AN = 0;
-        num = 1;
-      }
-      else{
-        Gc_AN = F_M2G[Mc_AN];
-        num = GridN_Atom[Gc_AN];
-      }
-
-      for (Nc=0; Nc<num; Nc++){
-        free(Orbs_Grid[Mc_AN][Nc]);
-      }
+      free(Orbs_Grid[Mc_AN][0]);
       free(Orbs_Grid[Mc_AN]); 
     }
     free(Orbs_Grid); 
 
+    /* the cached fuzzy weights */
+
+    Fuzzy_Weight_Free();
+
+    /* dOrbs_Grid */
+
+    if (dOrbs_Grid_flag){
+      for (Mc_AN=0; Mc_AN<=Matomnum; Mc_AN++){
+        free(dOrbs_Grid[Mc_AN][0]);
+        free(dOrbs_Grid[Mc_AN]); 
+      }
+      free(dOrbs_Grid); 
+
+      dOrbs_Grid_flag = 0;
+    }
+
     /* COrbs_Grid */
     if (Cnt_switch!=0){
       for (Mc_AN=0; Mc_AN<=(Matomnum+MatomnumF); Mc_AN++){
@@ -2693,27 +2698,8 @@ void array0()
   }
   free(Spe_Atomic_Den2);
 
-  for (i=0; i<List_YOUSO[18]; i++){
-    for (j=0; j<=List_YOUSO[25]; j++){
-      for (k=0; k<List_YOUSO[24]; k++){
-        free(Spe_PAO_RWF[i][j][k]);
-      }
-      free(Spe_PAO_RWF[i][j]);
-    }
-    free(Spe_PAO_RWF[i]);
-  }
-  free(Spe_PAO_RWF);
-
-  for (i=0; i<List_YOUSO[18]; i++){
-    for (j=0; j<=List_YOUSO[25]; j++){
-      for (k=0; k<List_YOUSO[24]; k++){
-        free(Spe_RF_Bessel[i][j][k]);
-      }
-      free(Spe_RF_Bessel[i][j]);
-    }
-    free(Spe_RF_Bessel[i]);
-  }
-  free(Spe_RF_Bessel);
+  Shm_Free_Double4(Spe_PAO_RWF,List_YOUSO[18],List_YOUSO[25]+1,List_YOUSO[24]);
+  Shm_Free_Double4(Spe_RF_Bessel,List_YOUSO[18],List_YOUSO[25]+1,List_YOUSO[24]);
 
   /* Allocate_Arrays(7) in SetPara_DFT.c */
 
@@ -2742,16 +2728,7 @@ void array0()
   }
   free(Spe_Atomic_PCC);
 
-  for (so=0; so<(SO_switch+1); so++){
-    for (i=0; i<List_YOUSO[18]; i++){
-      for (j=0; j<List_YOUSO[19]; j++){
-        free(Spe_VNL[so][i][j]);
-      }
-      free(Spe_VNL[so][i]);
-    }
-    free(Spe_VNL[so]);
-  }
-  free(Spe_VNL);
+  Shm_Free_Double4(Spe_VNL,SO_switch+1,List_YOUSO[18],List_YOUSO[19]);
 
   for (so=0; so<(SO_switch+1); so++){
     for (i=0; i<List_YOUSO[18]; i++){
@@ -2766,29 +2743,11 @@ void array0()
   }
   free(Spe_VPS_List);
 
-  for (so=0; so<(SO_switch+1); so++){
-    for (i=0; i<List_YOUSO[18]; i++){
-      for (j=0; j<(List_YOUSO[19]+2); j++){
-        free(Spe_NLRF_Bessel[so][i][j]);
-      }
-      free(Spe_NLRF_Bessel[so][i]);
-    }
-    free(Spe_NLRF_Bessel[so]);
-  }
-  free(Spe_NLRF_Bessel);
+  Shm_Free_Double4(Spe_NLRF_Bessel,SO_switch+1,List_YOUSO[18],List_YOUSO[19]+2);
 
   if (ProExpn_VNA==1){
 
-    for (i=0; i<List_YOUSO[18]; i++){
-      for (L=0; L<(List_YOUSO[35]+1); L++){
-	for (j=0; j<List_YOUSO[34]; j++){
-	  free(Projector_VNA[i][L][j]);
-	}
-        free(Projector_VNA[i][L]);
-      }
-      free(Projector_VNA[i]);
-    }
-    free(Projector_VNA);
+    Shm_Free_Double4(Projector_VNA,List_YOUSO[18],List_YOUSO[35]+1,List_YOUSO[34]);
 
     for (i=0; i<List_YOUSO[18]; i++){
       for (L=0; L<(List_YOUSO[35]+1); L++){
@@ -2798,16 +2757,7 @@ void array0()
     }
     free(VNA_proj_ene);
 
-    for (i=0; i<List_YOUSO[18]; i++){
-      for (L=0; L<(List_YOUSO[35]+1); L++){
-	for (j=0; j<List_YOUSO[34]; j++){
-	  free(Spe_VNA_Bessel[i][L][j]);
-	}
-        free(Spe_VNA_Bessel[i][L]);
-      }
-      free(Spe_VNA_Bessel[i]);
-    }
-    free(Spe_VNA_Bessel);
+    Shm_Free_Double4(Spe_VNA_Bessel,List_YOUSO[18],List_YOUSO[35]+1,List_YOUSO[34]);
 
     for (i=0; i<List_YOUSO[18]; i++){
       free(Spe_CrudeVNA_Bessel[i]);
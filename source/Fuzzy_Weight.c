@@ -4,25 +4,45 @@
      Fuzzy_Weight.c is a subrutine to calculate the fuzzy weight
      at position (x,y,z).
 
+     Fuzzy_Weight_Grid:  the fuzzy weights at all the grid points of
+                         an atom, with the geometry of the pairs made
+                         once per atom, the cell functions saturated
+                         to zero pruned, and the grid points treated
+                         in batches. The weights can be kept in a cache,
+                         so that they are shared by Voronoi_Charge and
+                         Voronoi_Orbital_Moment (Voronoi.weight.cache).
+     Fuzzy_Weight_Alloc: allocates the cache, called outside of
+                         the parallel regions
+     Fuzzy_Weight_Free:  frees the cache
+
   Log of Fuzzy_Weight.c:
 
      22/Nov/2001  Released by T.Ozaki
+     18/Oct/2026  Fuzzy_Weight_Grid and Fuzzy_Weight_Free added
 
 ***********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 #include "openmx_common.h"
 #include "mpi.h"
+#include <omp.h>
 
 
 #define Degree_Smear  5
+#define FW_Batch     16   /* the number of grid points in a batch */
 
+#pragma omp declare simd
 static double Smear(double mu);
+#pragma omp declare simd
 static double Smear_Beck(double x);
 
+static double **FW_Cache = NULL;
+static int FW_Cache_Num = 0;
+
 double Fuzzy_Weight(int ct_AN, int Mc_AN, int Rn, double x, double y, double z)
 {
   int i,j,p_AN,Gp_AN,Gs_AN,s_AN,Rnp,Rns;
@@ -93,9 +113,200 @@ double Fuzzy_Weight(int ct_AN, int Mc_AN, int Rn, double x, double y, double z)
 }
 
 
+void Fuzzy_Weight_Grid(int Mc_AN, double *W)
+{
+  int Gc_AN,p_AN,Gp_AN,s_AN,Gs_AN,Rnp,Rns,Np,NumG;
+  int b,q,nq,GNc,GRc,live;
+  int *Ns;
+  double ***Xs,*Xp,**iR;
+  double xs,ys,zs,ir,rj;
+  double Cxyz[4],x[FW_Batch],y[FW_Batch],z[FW_Batch];
+  double sri[FW_Batch],P[FW_Batch],P0[FW_Batch],Den[FW_Batch];
+
+  Gc_AN = M2G[Mc_AN];
+  NumG = GridN_Atom[Gc_AN];
+
+  /* the cached weights */
+
+  if (FW_Cache!=NULL && FW_Cache[Mc_AN]!=NULL){
+    memcpy(W, FW_Cache[Mc_AN], sizeof(double)*NumG);
+    return;
+  }
+
+  /*****************************************************
+   geometry of the pairs (p,s), where p is a neighbor
+   of Gc_AN and s is a neighbor of p, made once per atom
+  *****************************************************/
+
+  Np = FNAN[Gc_AN] + 1;
+
+  Ns = (int*)malloc(sizeof(int)*Np);
+  Xp = (double*)malloc(sizeof(double)*3*Np);
+  Xs = (double***)malloc(sizeof(double**)*Np);
+  iR = (double**)malloc(sizeof(double*)*Np);
+
+  for (p_AN=0; p_AN<Np; p_AN++){
+
+    Gp_AN = natn[Gc_AN][p_AN];
+    Rnp = ncn[Gc_AN][p_AN];
+    Ns[p_AN] = FNAN[Gp_AN];
+
+    Xp[3*p_AN+0] = Gxyz[Gp_AN][1] + atv[Rnp][1];
+    Xp[3*p_AN+1] = Gxyz[Gp_AN][2] + atv[Rnp][2];
+    Xp[3*p_AN+2] = Gxyz[Gp_AN][3] + atv[Rnp][3];
+
+    Xs[p_AN] = (double**)malloc(sizeof(double*)*(Ns[p_AN]+1));
+    iR[p_AN] = (double*)malloc(sizeof(double)*(Ns[p_AN]+1));
+
+    for (s_AN=1; s_AN<=Ns[p_AN]; s_AN++){
+
+      Gs_AN = natn[Gp_AN][s_AN];
+      Rns = ncn[Gp_AN][s_AN];
+
+      Xs[p_AN][s_AN] = (double*)malloc(sizeof(double)*3);
+      Xs[p_AN][s_AN][0] = Gxyz[Gs_AN][1] + atv[Rns][1] + atv[Rnp][1];
+      Xs[p_AN][s_AN][1] = Gxyz[Gs_AN][2] + atv[Rns][2] + atv[Rnp][2];
+      Xs[p_AN][s_AN][2] = Gxyz[Gs_AN][3] + atv[Rns][3] + atv[Rnp][3];
+
+      iR[p_AN][s_AN] = 1.0/sqrt( (Xp[3*p_AN+0]-Xs[p_AN][s_AN][0])*(Xp[3*p_AN+0]-Xs[p_AN][s_AN][0])
+                               + (Xp[3*p_AN+1]-Xs[p_AN][s_AN][1])*(Xp[3*p_AN+1]-Xs[p_AN][s_AN][1])
+                               + (Xp[3*p_AN+2]-Xs[p_AN][s_AN][2])*(Xp[3*p_AN+2]-Xs[p_AN][s_AN][2]) );
+    }
+  }
+
+  /*****************************************************
+   the weights in batches of FW_Batch grid points.
+   The product of the cell functions of p is stopped
+   as soon as it is zero for all the points in a batch,
+   and the other p are skipped if Pn[0] is zero, since
+   such products do not change the weights.
+  *****************************************************/
+
+#pragma omp parallel for schedule(dynamic) if(!omp_in_parallel()) shared(W,NumG,Np,Ns,Xp,Xs,iR,Mc_AN) private(b,q,nq,GNc,GRc,live,p_AN,s_AN,xs,ys,zs,ir,rj,Cxyz,x,y,z,sri,P,P0,Den)
+  for (b=0; b<NumG; b+=FW_Batch){
+
+    nq = (NumG-b<FW_Batch) ? NumG-b : FW_Batch;
+
+    for (q=0; q<nq; q++){
+      GNc = GridListAtom[Mc_AN][b+q];
+      GRc = CellListAtom[Mc_AN][b+q];
+      Get_Grid_XYZ(GNc,Cxyz);
+      x[q] = Cxyz[1] + atv[GRc][1];
+      y[q] = Cxyz[2] + atv[GRc][2];
+      z[q] = Cxyz[3] + atv[GRc][3];
+    }
+    for (q=nq; q<FW_Batch; q++){
+      x[q] = x[0];
+      y[q] = y[0];
+      z[q] = z[0];
+    }
+
+    for (q=0; q<FW_Batch; q++) Den[q] = 0.0;
+
+    for (p_AN=0; p_AN<Np; p_AN++){
+
+      for (q=0; q<FW_Batch; q++){
+        P[q] = 1.0;
+        sri[q] = sqrt( (x[q]-Xp[3*p_AN+0])*(x[q]-Xp[3*p_AN+0])
+                     + (y[q]-Xp[3*p_AN+1])*(y[q]-Xp[3*p_AN+1])
+                     + (z[q]-Xp[3*p_AN+2])*(z[q]-Xp[3*p_AN+2]) );
+      }
+
+      for (s_AN=1; s_AN<=Ns[p_AN]; s_AN++){
+
+        xs = Xs[p_AN][s_AN][0];
+        ys = Xs[p_AN][s_AN][1];
+        zs = Xs[p_AN][s_AN][2];
+        ir = iR[p_AN][s_AN];
+
+#pragma omp simd private(rj)
+        for (q=0; q<FW_Batch; q++){
+          rj = sqrt( (x[q]-xs)*(x[q]-xs) + (y[q]-ys)*(y[q]-ys) + (z[q]-zs)*(z[q]-zs) );
+          P[q] *= Smear( (sri[q]-rj)*ir );
+        }
+
+        /* saturated cell functions */
+
+        live = 0;
+        for (q=0; q<nq; q++) live |= (P[q]!=0.0);
+        if (live==0) break;
+      }
+
+      for (q=0; q<FW_Batch; q++) Den[q] += P[q];
+
+      if (p_AN==0){
+        for (q=0; q<FW_Batch; q++) P0[q] = P[q];
+        live = 0;
+        for (q=0; q<nq; q++) live |= (P0[q]!=0.0);
+        if (live==0) break;
+      }
+    }
+
+    for (q=0; q<nq; q++){
+      if (fabs(Den[q])<1.0e-14 || P0[q]==0.0) W[b+q] = 0.0;
+      else                                    W[b+q] = P0[q]/Den[q];
+    }
+  }
+
+  /* store the weights */
+
+  /* the entry Mc_AN is written only by the thread treating Mc_AN */
+
+  if (FW_Cache!=NULL){
+    FW_Cache[Mc_AN] = (double*)malloc(sizeof(double)*(NumG+1));
+    memcpy(FW_Cache[Mc_AN], W, sizeof(double)*NumG);
+  }
+
+  /* freeing of arrays */
+
+  for (p_AN=0; p_AN<Np; p_AN++){
+    for (s_AN=1; s_AN<=Ns[p_AN]; s_AN++){
+      free(Xs[p_AN][s_AN]);
+    }
+    free(Xs[p_AN]);
+    free(iR[p_AN]);
+  }
+  free(iR);
+  free(Xs);
+  free(Xp);
+  free(Ns);
+}
+
+
+void Fuzzy_Weight_Alloc()
+{
+  int Mc_AN;
+
+  if (Voronoi_Weight_Cache==0 || FW_Cache!=NULL) return;
+
+  FW_Cache_Num = Matomnum;
+  FW_Cache = (double**)malloc(sizeof(double*)*(FW_Cache_Num+1));
+  for (Mc_AN=0; Mc_AN<=FW_Cache_Num; Mc_AN++) FW_Cache[Mc_AN] = NULL;
+}
+
+
+void Fuzzy_Weight_Free()
+{
+  int Mc_AN;
+
+  /* called when the grids or the geometry are changed */
+
+  if (FW_Cache==NULL) return;
+
+  for (Mc_AN=0; Mc_AN<=FW_Cache_Num; Mc_AN++){
+    if (FW_Cache[Mc_AN]!=NULL) free(FW_Cache[Mc_AN]);
+  }
+  free(FW_Cache);
+
+  FW_Cache = NULL;
+  FW_Cache_Num = 0;
+}
+
+
+#pragma omp declare simd
 double Smear(double mu)
 {
-  int i,j,k;
+  int i;
   double f0,f1,result;
 
   f0 = Smear_Beck(mu);
@@ -108,6 +319,7 @@ double Smear(double mu)
   return result;
 }
 
+#pragma omp declare simd
 double Smear_Beck(double x)
 {
   double result;
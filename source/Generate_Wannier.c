@@ -8,6 +8,8 @@
      24/Mar/2008   Started by Hongming Weng
      06/Jun/2008   Start the coding for disentangling of mixed bands
      23/Sep/2015   Interface with wannier90 is added by Fumiyuki Ishii
+     18/Oct/2026   Mmn(k,b) by ZGEMMs over (k,b) pairs, Amn(k) and the
+                   minimization parallelized over k-points
 ***********************************************************************/
 
 #include <stdio.h>
@@ -122,9 +124,7 @@ void Calc_SpinDirection_WF(int rnum, int **rvect);
 
 void MPI_comm_OLP_Hks_iHks(double ****OLP, double *****Hks, double *****iHks);
 
-void Calc_Mmnkb(int k, int kk, double k1[4], double k2[4], double b[4], 
-                int bindx, int SpinP_switch, int *MP, double Sop[2], 
-		dcomplex *Wk1, dcomplex *Wk2, int fsize, int mm, int nn);
+void Calc_OLPe_k(double k1[4], double b[4], int bindx, int *MP, int fsize, dcomplex *Pkb);
 
 void Overlap_Band_Wannier(double ****OLP,
 			  dcomplex **S,int *MP,
@@ -2001,78 +2001,58 @@ void Wannier(int Solver,
     } /* For each k point: find its eigenvalue and wavefunction */
     } /* #pragma omp parallel */
 
-    /* MPI communicatio of Wkall */
+    /* MPI communication of Wkall and EigenValall,
+       where k is calculated by the process k%numprocs */
 
     { 
-      int num0,num;
-      double *vec0;
+      int num0,num,*owner;
+      double **vec0;
    
-      num0 = 2*spinsize*fsize3*fsize3;
-      vec0 = (double*)malloc(sizeof(double)*num0);
+      num0 = 2*spinsize*fsize3*fsize3 + spinsize*fsize3;
+      vec0 = (double**)malloc(sizeof(double*)*kpt_num);
+      owner = (int*)malloc(sizeof(int)*kpt_num);
 
       for( k=0; k<kpt_num; k++ ){
       
-	ID = k % numprocs;
+	owner[k] = k % numprocs;
+	vec0[k] = (double*)malloc(sizeof(double)*num0);
 
-	num = 0;
-	for (spin=0; spin<spinsize; spin++){
-	  for (i=0; i<fsize3; i++){
-	    for (j=0; j<fsize3; j++){ 
-	      vec0[num] = Wkall[k][spin][i][j].r; num++;
-	      vec0[num] = Wkall[k][spin][i][j].i; num++;
-	    }
-	  }
-	}
+	if (owner[k]==myid){
 
-	MPI_Bcast(&vec0[0], num0, MPI_DOUBLE, ID, mpi_comm_level1);
-
-	num = 0;
-	for (spin=0; spin<spinsize; spin++){
-	  for (i=0; i<fsize3; i++){
-	    for (j=0; j<fsize3; j++){ 
-	      Wkall[k][spin][i][j].r = vec0[num]; num++;
-	      Wkall[k][spin][i][j].i = vec0[num]; num++;
+	  num = 0;
+	  for (spin=0; spin<spinsize; spin++){
+	    for (i=0; i<fsize3; i++){
+	      memcpy(&vec0[k][num], Wkall[k][spin][i], sizeof(dcomplex)*fsize3);
+	      num += 2*fsize3;
 	    }
+	    memcpy(&vec0[k][num], EigenValall[k][spin], sizeof(double)*fsize3);
+	    num += fsize3;
 	  }
 	}
-
       }
 
-      free(vec0);
-    }
-
-    /* MPI communicatio of EigenValall */
-
-    {
-      int num0,num;
-      double *vec0;
-   
-      num0 = spinsize*fsize3;
-      vec0 = (double*)malloc(sizeof(double)*num0);
+      Rows_Allgather_Double(vec0, kpt_num, num0, owner);
 
       for( k=0; k<kpt_num; k++ ){
-      
-	ID = k % numprocs;
 
-	num = 0;
-	for (spin=0; spin<spinsize; spin++){
-	  for (i=0; i<fsize3; i++){
-	    vec0[num] = EigenValall[k][spin][i]; num++;
-	  }
-	}
-
-	MPI_Bcast(&vec0[0], num0, MPI_DOUBLE, ID, mpi_comm_level1);
+	if (owner[k]!=myid){
 
-	num = 0;
-	for (spin=0; spin<spinsize; spin++){
-	  for (i=0; i<fsize3; i++){
-	    EigenValall[k][spin][i] = vec0[num]; num++;
+	  num = 0;
+	  for (spin=0; spin<spinsize; spin++){
+	    for (i=0; i<fsize3; i++){
+	      memcpy(Wkall[k][spin][i], &vec0[k][num], sizeof(dcomplex)*fsize3);
+	      num += 2*fsize3;
+	    }
+	    memcpy(EigenValall[k][spin], &vec0[k][num], sizeof(double)*fsize3);
+	    num += fsize3;
 	  }
 	}
 
+	free(vec0[k]);
       }
 
       free(vec0);
+      free(owner);
     }
 
     /* freeing of fOLP */
@@ -2586,7 +2566,9 @@ void Wannier(int Solver,
 
   if (lreadMmnk==0){
 
-    double bk[4],k1[4],k2[4],Sop[2];
+    double bk[4],k1[4];
+    double **Mbuf;
+    int *Mown,nbmax;
 
     if (myid==Host_ID){
       printf("\nComing to the overlap matrix calculating......\n");fflush(0);
@@ -2596,156 +2578,171 @@ void Wannier(int Solver,
          calculation of Mmnkb
     ********************************
 
-    /* a parallelized loop for spinsize*kpt_num*tot_bvector*BANDNUM*BANDNUM */
-    /*                           spin    k       b          m      n      */
+    /* a parallelized loop for kpt_num*tot_bvector pairs of (k,b).
+       For each pair, the phase-weighted overlap Pkb between the Bloch
+       sums at k and k+b is made once, and Mmn(k,b) for all the bands
+       and spins is given by two ZGEMMs: W(k)^+ * Pkb * W(k+b).       */
 
-    odloop_num = spinsize*kpt_num*tot_bvector*BANDNUM*BANDNUM;
-
-#pragma omp parallel shared(odloop_num,myid,numprocs,kpt_num,tot_bvector,BANDNUM,kplusb,Nk,fsize3,kg,frac_bv,SpinP_switch,MP,Wkall,fsize,Mmnkb_zero) private(odloop,spin,itmp1,itmp2,itmp3,k,bindx,m,n,kk,m1,n1,k1,k2,bk,Sop,norm,OMPID,Nthrds,Nprocs)
-    {
-
-    /* get info. on OpenMP */ 
+    odloop_num = kpt_num*tot_bvector;
+    nbmax = BANDNUM*BANDNUM;
 
-    OMPID = omp_get_thread_num();
-    Nthrds = omp_get_num_threads();
-    Nprocs = omp_get_num_procs();
+    Mbuf = (double**)malloc(sizeof(double*)*odloop_num);
+    Mown = (int*)malloc(sizeof(int)*odloop_num);
+    for (odloop=0; odloop<odloop_num; odloop++){
+      Mbuf[odloop] = (double*)malloc(sizeof(double)*2*spinsize*nbmax);
+      Mown[odloop] = odloop % numprocs;
+    }
 
-    for( odloop=myid+numprocs*OMPID; odloop<odloop_num; odloop+=numprocs*Nthrds ){
+#pragma omp parallel shared(odloop_num,nbmax,myid,numprocs,spinsize,kpt_num,tot_bvector,BANDNUM,kplusb,Nk,fsize3,kg,frac_bv,SpinP_switch,MP,Wkall,fsize,Mbuf) private(odloop,spin,k,bindx,m,n,kk,m1,n1,k1,bk,norm,OMPID,Nthrds,Nprocs)
+    {
+      int nb1,nb2,ns,nsp,ij,BM,BN,BK;
+      dcomplex *Pkb,*W1,*W2,*T,*Mtmp,Ctmp1,Ctmp2;
 
-      /* get spin, k, bindx, m, and n */
+      /* get info. on OpenMP */ 
 
-      spin = odloop/(kpt_num*tot_bvector*BANDNUM*BANDNUM);
-      itmp1 = odloop - spin*(kpt_num*tot_bvector*BANDNUM*BANDNUM);
-      k = itmp1/(tot_bvector*BANDNUM*BANDNUM);
-      itmp2 = itmp1 - k*(tot_bvector*BANDNUM*BANDNUM);
-      bindx = itmp2/(BANDNUM*BANDNUM);
-      itmp3 = itmp2 - bindx*(BANDNUM*BANDNUM);
-      m = itmp3/BANDNUM;
-      n = itmp3 - m*BANDNUM;
+      OMPID = omp_get_thread_num();
+      Nthrds = omp_get_num_threads();
+      Nprocs = omp_get_num_procs();
 
-      /* kk is the index for k+b */
+      nsp = (SpinP_switch==3) ? 2 : 1;
 
-      kk = kplusb[k][bindx];
+      Pkb  = (dcomplex*)malloc(sizeof(dcomplex)*fsize*fsize);
+      W1   = (dcomplex*)malloc(sizeof(dcomplex)*fsize*BANDNUM);
+      W2   = (dcomplex*)malloc(sizeof(dcomplex)*fsize*BANDNUM);
+      T    = (dcomplex*)malloc(sizeof(dcomplex)*fsize*BANDNUM);
+      Mtmp = (dcomplex*)malloc(sizeof(dcomplex)*nbmax);
 
-      /* m and n must be added to the offset. */
+      for( odloop=myid+numprocs*OMPID; odloop<odloop_num; odloop+=numprocs*Nthrds ){
 
-      m1 = m + 1 + Nk[spin][k][0];      
-      n1 = n + 1 + Nk[spin][kk][0];      
+	k = odloop/tot_bvector;
+	bindx = odloop - k*tot_bvector;
 
-      if (m1<(fsize3-1) && n1<(fsize3-1)){
+	/* kk is the index for k+b */
 
-	/* get k-value */
+	kk = kplusb[k][bindx];
 
 	k1[1] = kg[k][0];
 	k1[2] = kg[k][1];
 	k1[3] = kg[k][2];
 
-	/* get k+b */
-
-	k2[1] = k1[1] + frac_bv[bindx][0];  /* Equivalent k point of k+b */
-	k2[2] = k1[2] + frac_bv[bindx][1];
-	k2[3] = k1[3] + frac_bv[bindx][2];
-
-	/* set the value of b-vector */
-
 	bk[1] = frac_bv[bindx][0]; 
 	bk[2] = frac_bv[bindx][1];
 	bk[3] = frac_bv[bindx][2];
 
-	/* calc Mmnkb */
+	Calc_OLPe_k(k1, bk, bindx, MP, fsize, Pkb);
 
-	/*
-        if (k==99 && bindx==9 && m==1 && n==0){
+	for (spin=0; spin<spinsize; spin++){
 
-          printf("EEE kk=%2d spin=%2d m1=%2d n1=%2d\n",kk,spin,m1,n1);
-          
-          for (i=1; i<=fsize2; i++){
-            printf("GGG i=%3d W1.r=%15.12f W1.i=%15.12f W2.r=%15.12f W2.i=%15.12f\n", 
-		   i,
-                   Wkall[k][spin][m1][i].r, Wkall[k][spin][m1][i].i,
-                   Wkall[kk][spin][n1][i].r,Wkall[kk][spin][n1][i].i
-                   );
-          }
-	}
-	*/
+	  /* the bands m and n must be added to the offset, 
+	     and only m1<(fsize3-1) and n1<(fsize3-1) are available. */
 
+	  nb1 = fsize3 - 2 - Nk[spin][k][0];
+	  nb2 = fsize3 - 2 - Nk[spin][kk][0];
+	  if (BANDNUM<nb1) nb1 = BANDNUM;
+	  if (BANDNUM<nb2) nb2 = BANDNUM;
+	  if (nb1<0) nb1 = 0;
+	  if (nb2<0) nb2 = 0;
 
-	Calc_Mmnkb(k, kk, k1, k2,  bk, bindx, SpinP_switch, MP, Sop, 
-		   Wkall[k][spin][m1], Wkall[kk][spin][n1], fsize, m,n);
+	  for (m=0; m<nbmax; m++){ Mtmp[m].r = 0.0; Mtmp[m].i = 0.0; }
 
+	  if (0<nb1 && 0<nb2){
 
-	/*
-	printf("k=%2d bindx=%2d m=%2d n=%2d O.r=%15.12f O.i=%15.12f\n",
-	k,bindx,m,n,Sop[0],Sop[1]);
+	    for (ns=0; ns<nsp; ns++){
 
-        if (k==0 && bindx==0 && m==0 && n==0){
+	      /* packing of the coefficients */
 
-          MPI_Finalize();
-          exit(0); 
+	      for (m=0; m<nb1; m++){
+		m1 = m + 1 + Nk[spin][k][0];
+		memcpy(&W1[m*fsize], &Wkall[k][spin][m1][1+ns*fsize], sizeof(dcomplex)*fsize);
+	      }
 
-	}
-	*/
+	      for (n=0; n<nb2; n++){
+		n1 = n + 1 + Nk[spin][kk][0];
+		memcpy(&W2[n*fsize], &Wkall[kk][spin][n1][1+ns*fsize], sizeof(dcomplex)*fsize);
+	      }
 
-	Mmnkb_zero[k][bindx][spin][m+1][n+1].r = Sop[0];
-	Mmnkb_zero[k][bindx][spin][m+1][n+1].i = Sop[1];
+	      /* T = Pkb * W(k+b) */
 
-        norm = sqrt( fabs(Sop[0]*Sop[0] + Sop[1]*Sop[1]) );
+	      BM = fsize; BN = nb2; BK = fsize;
+	      Ctmp1.r = 1.0; Ctmp1.i = 0.0;
+	      Ctmp2.r = 0.0; Ctmp2.i = 0.0;
 
-	if (norm>1.0){
-	  printf("**********************WARNNING**********************\n");
-	  printf("Attention! |Mmnkb=%10.5f|>1.0 at k=%i,b=%i,i=%i,j=%i\n",norm,k,bindx,m+1,n+1);
-	  printf("**********************WARNNING**********************\n");
-	}
+	      F77_NAME(zgemm,ZGEMM)("N","N", &BM,&BN,&BK, &Ctmp1, Pkb, &BM, W2, &BK, &Ctmp2, T, &BM);
 
+	      /* M += W(k)^+ * T */
 
-	/*
-        if (k==99 && bindx==9 && m==1 && n==0){
-          MPI_Finalize();
-          exit(0);
-	}
-	*/
+	      BM = nb1; BN = nb2; BK = fsize;
+	      Ctmp2.r = 1.0;
 
-      }
+	      F77_NAME(zgemm,ZGEMM)("C","N", &BM,&BN,&BK, &Ctmp1, W1, &BK, T, &BK, &Ctmp2, Mtmp, &BM);
+	    }
+	  }
 
-      /* if (!(m1<fsize3 && n1<fsize3))  */
+	  /* store in Mbuf */
 
-      else {
-        Mmnkb_zero[k][bindx][spin][m+1][n+1].r = -99999.0;
-        Mmnkb_zero[k][bindx][spin][m+1][n+1].i = -99999.0;
-      }
+	  for (m=0; m<BANDNUM; m++){
+	    for (n=0; n<BANDNUM; n++){
+
+	      ij = 2*(spin*nbmax + m*BANDNUM + n);
+
+	      if (m<nb1 && n<nb2){
+
+		Mbuf[odloop][ij  ] = Mtmp[n*nb1+m].r;
+		Mbuf[odloop][ij+1] = Mtmp[n*nb1+m].i;
+
+		norm = sqrt( fabs(Mtmp[n*nb1+m].r*Mtmp[n*nb1+m].r + Mtmp[n*nb1+m].i*Mtmp[n*nb1+m].i) );
+
+		if (norm>1.0){
+		  printf("**********************WARNNING**********************\n");
+		  printf("Attention! |Mmnkb=%10.5f|>1.0 at k=%i,b=%i,i=%i,j=%i\n",norm,k,bindx,m+1,n+1);
+		  printf("**********************WARNNING**********************\n");
+		}
+	      }
+	      else {
+		Mbuf[odloop][ij  ] = -99999.0;
+		Mbuf[odloop][ij+1] = -99999.0;
+	      }
+	    }
+	  }
+
+	} /* spin */
+      } /* odloop */ 
+
+      free(Pkb);
+      free(W1);
+      free(W2);
+      free(T);
+      free(Mtmp);
 
-    } /* odloop */ 
     } /* #pragma omp parallel */
 
     /*******************************
        MPI communication of Mmnkb
     ********************************/
 
-    for( odloop=0; odloop<odloop_num; odloop++ ){
-
-      /* find ID */
+    Rows_Allgather_Double(Mbuf, odloop_num, 2*spinsize*nbmax, Mown);
 
-      ID = odloop % numprocs;
+    for (odloop=0; odloop<odloop_num; odloop++){
 
-      /* get spin, k, bindx, m, and n */
+      k = odloop/tot_bvector;
+      bindx = odloop - k*tot_bvector;
 
-      spin = odloop/(kpt_num*tot_bvector*BANDNUM*BANDNUM);
-      itmp1 = odloop - spin*(kpt_num*tot_bvector*BANDNUM*BANDNUM);
-      k = itmp1/(tot_bvector*BANDNUM*BANDNUM);
-      itmp2 = itmp1 - k*(tot_bvector*BANDNUM*BANDNUM);
-      bindx = itmp2/(BANDNUM*BANDNUM);
-      itmp3 = itmp2 - bindx*(BANDNUM*BANDNUM);
-      m = itmp3/BANDNUM;
-      n = itmp3 - m*BANDNUM;
-
-      /* bcast of Mmnkb_zero */
+      for (spin=0; spin<spinsize; spin++){
+	for (m=0; m<BANDNUM; m++){
+	  for (n=0; n<BANDNUM; n++){
+	    i = 2*(spin*nbmax + m*BANDNUM + n);
+	    Mmnkb_zero[k][bindx][spin][m+1][n+1].r = Mbuf[odloop][i  ];
+	    Mmnkb_zero[k][bindx][spin][m+1][n+1].i = Mbuf[odloop][i+1];
+	  }
+	}
+      }
 
-      MPI_Bcast( &Mmnkb_zero[k][bindx][spin][m+1][n+1].r, 1, 
-                 MPI_DOUBLE, ID, mpi_comm_level1);
-      MPI_Bcast( &Mmnkb_zero[k][bindx][spin][m+1][n+1].i, 1, 
-                 MPI_DOUBLE, ID, mpi_comm_level1);
+      free(Mbuf[odloop]);
     }
 
+    free(Mbuf);
+    free(Mown);
+
     /*************************************
       save the overlap matrix Mmnkb_zero
     *************************************/
@@ -4602,19 +4599,17 @@ void Projection_Amatrix(dcomplex ****Amnk, double **kg, int spinsize,
                         dcomplex ****Wkall, int *MP, int ***Nk)
 {
   /* calculate the A matrix  */   
-  int ct_AN, h_AN, Gh_AN, i,j,k, TNO1, TNO2;
-  int spin, Rn, disentangle, BAND;
-  int nindx, windx, proj_kind, tot_loc_basis;
-  int mu1, L, tnoB, Anum, Bnum, Rnh, l1, l2, l3, i1,p;
-  double co, si, kRn, sumr, sumi, tmpr, tmpi;
-  double sr, pxr, pxi, pyr, pyi, pzr, pzi;
-  dcomplex **tmpAmn; /* temporary Amn matrix*/ 
-  dcomplex *tmpResult;
+  int i,k;
+  int spin, disentangle, BAND;
+  int nindx, tot_loc_basis, nres;
+  int mu1, L, sk, sk_num, *Aown;
+  double **Abuf;
   FILE *fp;
   char fname[300];
-  int myid;
+  int numprocs,myid;
 
   /* get MPI ID */
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
   MPI_Comm_rank(mpi_comm_level1,&myid);
   
 
@@ -4626,25 +4621,11 @@ void Projection_Amatrix(dcomplex ****Amnk, double **kg, int spinsize,
     }
   } 
 
-  if(tot_loc_basis >=(2*3+1)){
-    if(tot_loc_basis>=wan_num){
-      tmpResult=(dcomplex*)malloc(sizeof(dcomplex)*tot_loc_basis);
-    }
-    else{
-      tmpResult=(dcomplex*)malloc(sizeof(dcomplex)*wan_num);
-    }
-  }else{
-    if(wan_num<2*3+1){
-      tmpResult=(dcomplex*)malloc(sizeof(dcomplex)*(2*3+1));
-    }else{
-      tmpResult=(dcomplex*)malloc(sizeof(dcomplex)*wan_num);
-    }
-  }
+  /* size of tmpResult */
 
-  tmpAmn=(dcomplex**)malloc(sizeof(dcomplex*)*band_num);
-  for(i=0;i<band_num;i++){
-    tmpAmn[i]=(dcomplex*)malloc(sizeof(dcomplex)*tot_loc_basis);
-  }
+  nres = 2*3+1;
+  if(nres<tot_loc_basis) nres = tot_loc_basis;
+  if(nres<wan_num) nres = wan_num;
 
   BAND=band_num;
   if(band_num>wan_num){
@@ -4675,221 +4656,269 @@ void Projection_Amatrix(dcomplex ****Amnk, double **kg, int spinsize,
     }
   }
 
-  for(spin=0;spin<spinsize;spin++){
-    for(k=0;k<kpt_num;k++){
-      if(disentangle){
-	band_num=Nk[spin][k][1]-Nk[spin][k][0];
-      }else{
-	band_num=wan_num;
-      }
-      for(mu1=0;mu1<band_num;mu1++){/* band index in enegy window */
-	/* for(mu1=0;mu1<Nk[spin][k][1]-Nk[spin][k][0];mu1++){ */
-	/*     for(nindx=0;nindx<wan_num;nindx++){ */
-	windx=0;
-	for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
-          Anum = 0;
-          for (L=0; L<=3; L++){
-            Anum += (2*L+1)*Wannier_NumL_Pro[proj_kind][L]; /* total number of basis for this kind of projector */
+  /* a parallelized loop for spinsize*kpt_num pairs of (spin,k) */
+
+  sk_num = spinsize*kpt_num;
+
+  Abuf = (double**)malloc(sizeof(double*)*sk_num);
+  Aown = (int*)malloc(sizeof(int)*sk_num);
+  for(sk=0;sk<sk_num;sk++){
+    Abuf[sk] = (double*)malloc(sizeof(double)*2*BAND*wan_num);
+    Aown[sk] = sk % numprocs;
+  }
+
+#pragma omp parallel shared(sk_num,myid,numprocs,kpt_num,spinsize,fsize,SpinP_switch,disentangle,wan_num,BAND,tot_loc_basis,nres,Nk,kg,Wkall,MP,Amnk,Abuf)
+  {
+    int OMPID,Nthrds,sk,spin,k,nband,mu1,nindx,windx,proj_kind;
+    int i,j,L,Anum,h_AN,Rnh,Gh_AN,tnoB,Bnum,l1,l2,l3,i1;
+    double co,si,kRn,sumr,sumi,tmpr,tmpi;
+    dcomplex **tmpAmn,*tmpResult;
+
+    OMPID = omp_get_thread_num();
+    Nthrds = omp_get_num_threads();
+
+    tmpResult=(dcomplex*)malloc(sizeof(dcomplex)*nres);
+    tmpAmn=(dcomplex**)malloc(sizeof(dcomplex*)*BAND);
+    for(i=0;i<BAND;i++){
+      tmpAmn[i]=(dcomplex*)malloc(sizeof(dcomplex)*tot_loc_basis);
+    }
+
+    for(sk=myid+numprocs*OMPID; sk<sk_num; sk+=numprocs*Nthrds){
+
+      spin = sk/kpt_num;
+      k = sk - spin*kpt_num;
+
+          if(disentangle){
+    	nband=Nk[spin][k][1]-Nk[spin][k][0];
+          }else{
+    	nband=wan_num;
           }
-	  /*  for(nindx=0;nindx<Wannier_Num_Pro[proj_kind];nindx++){ */
-	  /*       printf("proj_kind =%i, projNum=%i Position index in tmpAmn is ",proj_kind, Anum);fflush(0); */
-          for(nindx=0;nindx<Anum;nindx++){
-	    /* 1. centeral atom  j */   
-	    sumr=0.0;sumi=0.0; 
-	    /* 3. neighboring site contributes to overlap i */
-
-	    for(h_AN=0;h_AN<FNAN_WP[proj_kind];h_AN++){ /* neighboring atoms */
-	      Rnh=ncn_WP[proj_kind][h_AN];
-	      Gh_AN=natn_WP[proj_kind][h_AN];
-	      tnoB=Total_NumOrbs[Gh_AN];
-	      Bnum=MP[Gh_AN]; 
-	      l1=atv_ijk[Rnh][1];
-	      l2=atv_ijk[Rnh][2];
-	      l3=atv_ijk[Rnh][3];
-	      kRn=-2.0*PI*(kg[k][0]*(double)l1+kg[k][1]*(double)l2+kg[k][2]*(double)l3);
-	      co=cos(kRn);
-	      si=sin(kRn);
-	      if(debug3){
-		/*	printf("glbal index=%i  local index=%i (grobal=%i, Rn=%i)\n",ct_AN,h_AN,Gh_AN,Rnh); */
-		/*		printf("overlap matrix OLP:\n"); */
-	      }
-	      for(i1=0;i1<tnoB;i1++){ /* basis on neighboring atom  alpha */
-                if(SpinP_switch!=3){
-                  tmpr= co*Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].r+si*Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].i;
-                  tmpi=-Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].i*co+si*Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].r;
-                }else{/* for non-collinear case */
-                  if(windx<tot_loc_basis/2){ /* First half is for alpha spin state */
-                    tmpr= co*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].r+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].i;
-                    tmpi=-Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].i*co+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].r;
-		    /*
-		      if(mu1==0&&k==0){
-                      printf("windx=%i. NO fsize.\n",windx);
-		      }
-		    */
-                  }else{/* Second half is for beta spin state */
-                    tmpr= co*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].r+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].i;
-                    tmpi=-Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].i*co+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].r;
-		    /*
-		      if(mu1==0&&k==0){
-                      printf("windx=%i. fsize added.\n",windx);fflush(0);
-		      }
-		    */
+          for(mu1=0;mu1<nband;mu1++){/* band index in enegy window */
+    	/* for(mu1=0;mu1<Nk[spin][k][1]-Nk[spin][k][0];mu1++){ */
+    	/*     for(nindx=0;nindx<wan_num;nindx++){ */
+    	windx=0;
+    	for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
+              Anum = 0;
+              for (L=0; L<=3; L++){
+                Anum += (2*L+1)*Wannier_NumL_Pro[proj_kind][L]; /* total number of basis for this kind of projector */
+              }
+    	  /*  for(nindx=0;nindx<Wannier_Num_Pro[proj_kind];nindx++){ */
+    	  /*       printf("proj_kind =%i, projNum=%i Position index in tmpAmn is ",proj_kind, Anum);fflush(0); */
+              for(nindx=0;nindx<Anum;nindx++){
+    	    /* 1. centeral atom  j */   
+    	    sumr=0.0;sumi=0.0; 
+    	    /* 3. neighboring site contributes to overlap i */
+
+    	    for(h_AN=0;h_AN<FNAN_WP[proj_kind];h_AN++){ /* neighboring atoms */
+    	      Rnh=ncn_WP[proj_kind][h_AN];
+    	      Gh_AN=natn_WP[proj_kind][h_AN];
+    	      tnoB=Total_NumOrbs[Gh_AN];
+    	      Bnum=MP[Gh_AN]; 
+    	      l1=atv_ijk[Rnh][1];
+    	      l2=atv_ijk[Rnh][2];
+    	      l3=atv_ijk[Rnh][3];
+    	      kRn=-2.0*PI*(kg[k][0]*(double)l1+kg[k][1]*(double)l2+kg[k][2]*(double)l3);
+    	      co=cos(kRn);
+    	      si=sin(kRn);
+    	      if(debug3){
+    		/*	printf("glbal index=%i  local index=%i (grobal=%i, Rn=%i)\n",ct_AN,h_AN,Gh_AN,Rnh); */
+    		/*		printf("overlap matrix OLP:\n"); */
+    	      }
+    	      for(i1=0;i1<tnoB;i1++){ /* basis on neighboring atom  alpha */
+                    if(SpinP_switch!=3){
+                      tmpr= co*Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].r+si*Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].i;
+                      tmpi=-Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].i*co+si*Wkall[k][spin][Nk[spin][k][0]+mu1+1][Bnum+i1].r;
+                    }else{/* for non-collinear case */
+                      if(windx<tot_loc_basis/2){ /* First half is for alpha spin state */
+                        tmpr= co*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].r+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].i;
+                        tmpi=-Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].i*co+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+i1].r;
+    		    /*
+    		      if(mu1==0&&k==0){
+                          printf("windx=%i. NO fsize.\n",windx);
+    		      }
+    		    */
+                      }else{/* Second half is for beta spin state */
+                        tmpr= co*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].r+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].i;
+                        tmpi=-Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].i*co+si*Wkall[k][0][Nk[0][k][0]+mu1+1][Bnum+fsize+i1].r;
+    		    /*
+    		      if(mu1==0&&k==0){
+                          printf("windx=%i. fsize added.\n",windx);fflush(0);
+    		      }
+    		    */
+                      }
+                    }
+    		tmpr=tmpr*OLP_WP[proj_kind][h_AN][nindx][i1]; /* sqrt((double)(FNAN[ct_AN]+1)); */
+    		tmpi=tmpi*OLP_WP[proj_kind][h_AN][nindx][i1]; /* sqrt((double)(FNAN[ct_AN]+1)); */
+
+    		sumr=sumr+tmpr;
+    		sumi=sumi+tmpi;
+    		if(debug3){
+    		  printf("%i %i %10.7f \n",nindx,i1,OLP_WP[proj_kind][h_AN][nindx][i1]);
+    		}
+    	      } /*basis on neighboring atom */
+    	    }/* neighboring atom */
+    	    tmpAmn[mu1][windx].r=sumr/sqrt(fabs((double)FNAN_WP[proj_kind])); 
+    	    tmpAmn[mu1][windx].i=sumi/sqrt(fabs((double)FNAN_WP[proj_kind]));
+    	    /*            printf("%i ", windx);fflush(0); */
+    	    windx++;
+    	  }/*  nindx */
+    	  /*            printf("\n");fflush(0); */
+    	}/* proj_kind */
+          }/* band in energy window */    
+          /* Now we make rotation firstly, then selection and at last hybridize */   
+          /*      printf("For Rotation:\n");fflush(0); */
+          for(mu1=0;mu1<nband;mu1++){
+            windx=0;
+            for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
+              for (L=0; L<=3; L++){
+                if(Wannier_NumL_Pro[proj_kind][L]!=0 && L!=0){ /* if thie L is included and L!=0, rotate it*/
+    	      /*    printf("proj_kind=%i, rotate L=%i from %i to %i\n",proj_kind,L,windx,windx+2*L+1);fflush(0); */ 
+                  for(i=0;i<2*L+1;i++){
+                    sumr=0.0;sumi=0.0;
+                    for(j=0;j<2*L+1;j++){
+    		  /*                  printf("i=%i, j=%i \n",i,j);fflush(0); */
+                      sumr=sumr+Wannier_RotMat_for_Real_Func[proj_kind][L][i][j]*tmpAmn[mu1][windx+j].r;
+                      sumi=sumi+Wannier_RotMat_for_Real_Func[proj_kind][L][i][j]*tmpAmn[mu1][windx+j].i;
+    		  /*                  printf("sumr and sumi ok\n");fflush(0); */
+                    }
+                    tmpResult[i].r=sumr; 
+                    tmpResult[i].i=sumi;
+                  }
+    	      /*              printf("windx=%i L=%i.\n",windx,L);fflush(0); */
+                  for(i=0;i<2*L+1;i++){
+    		/*                printf("i=%i \n",i);fflush(0);  */
+                    tmpAmn[mu1][windx+i].r=tmpResult[i].r; 
+                    tmpAmn[mu1][windx+i].i=tmpResult[i].i; 
+    		/*                printf("i=%i \n",i);fflush(0); */
                   }
+                  windx+=2*L+1; /* go over this L to the next */
+    	      /*              printf("windx=%i L=%i.\n",windx,L);fflush(0); */
+                }else if(Wannier_NumL_Pro[proj_kind][L]!=0 && L==0){
+    	      /* printf("proj_kind=%i, skip L=%i from %i to %i\n",proj_kind,L,windx,windx+2*L+1);fflush(0);  */
+                  windx++; /* skip s orbital */
                 }
-		tmpr=tmpr*OLP_WP[proj_kind][h_AN][nindx][i1]; /* sqrt((double)(FNAN[ct_AN]+1)); */
-		tmpi=tmpi*OLP_WP[proj_kind][h_AN][nindx][i1]; /* sqrt((double)(FNAN[ct_AN]+1)); */
-
-		sumr=sumr+tmpr;
-		sumi=sumi+tmpi;
-		if(debug3){
-		  printf("%i %i %10.7f \n",nindx,i1,OLP_WP[proj_kind][h_AN][nindx][i1]);
-		}
-	      } /*basis on neighboring atom */
-	    }/* neighboring atom */
-	    tmpAmn[mu1][windx].r=sumr/sqrt(fabs((double)FNAN_WP[proj_kind])); 
-	    tmpAmn[mu1][windx].i=sumi/sqrt(fabs((double)FNAN_WP[proj_kind]));
-	    /*            printf("%i ", windx);fflush(0); */
-	    windx++;
-	  }/*  nindx */
-	  /*            printf("\n");fflush(0); */
-	}/* proj_kind */
-      }/* band in energy window */    
-      /* Now we make rotation firstly, then selection and at last hybridize */   
-      /*      printf("For Rotation:\n");fflush(0); */
-      for(mu1=0;mu1<band_num;mu1++){
-        windx=0;
-        for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
-          for (L=0; L<=3; L++){
-            if(Wannier_NumL_Pro[proj_kind][L]!=0 && L!=0){ /* if thie L is included and L!=0, rotate it*/
-	      /*    printf("proj_kind=%i, rotate L=%i from %i to %i\n",proj_kind,L,windx,windx+2*L+1);fflush(0); */ 
-              for(i=0;i<2*L+1;i++){
+              } /* Rotation done for each L */
+            }
+          }/* band index mu1 */   
+          /* Make selection */
+          /*      printf("For Selection:\n");fflush(0); */
+          for(mu1=0;mu1<nband;mu1++){
+            windx=0; 
+            nindx=0;
+            for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
+              for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ /* Wannier_Num_Pro[proj_kind] number projectors */
+                Amnk[spin][k][mu1][nindx]=tmpAmn[mu1][Wannier_Select_Matrix[proj_kind][i]+windx];
+    	    /*       printf("proj_kind=%i, chose %i from tmpAmn to Amnk[%i]\n",
+                         proj_kind, Wannier_Select_Matrix[proj_kind][i]+windx,nindx);
+    	    */		     
+                nindx++;
+              }
+              for (L=0; L<=3; L++){
+                windx += (2*L+1)*Wannier_NumL_Pro[proj_kind][L]; /* total number of basis for this kind of projector */
+              }
+            }
+          }/* band index mu1 */  
+          /* Make hybridization */ 
+          /*      printf("For Hybridization:\n");fflush(0);  */
+          for(mu1=0;mu1<nband;mu1++){
+            nindx=0;
+            for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
+              for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ /* Wannier_Num_Pro[proj_kind] number projectors */
                 sumr=0.0;sumi=0.0;
-                for(j=0;j<2*L+1;j++){
-		  /*                  printf("i=%i, j=%i \n",i,j);fflush(0); */
-                  sumr=sumr+Wannier_RotMat_for_Real_Func[proj_kind][L][i][j]*tmpAmn[mu1][windx+j].r;
-                  sumi=sumi+Wannier_RotMat_for_Real_Func[proj_kind][L][i][j]*tmpAmn[mu1][windx+j].i;
-		  /*                  printf("sumr and sumi ok\n");fflush(0); */
+                for(j=0;j<Wannier_Num_Pro[proj_kind];j++){ 
+                  sumr=sumr+Wannier_Projector_Hybridize_Matrix[proj_kind][i][j]*Amnk[spin][k][mu1][nindx+j].r;
+                  sumi=sumi+Wannier_Projector_Hybridize_Matrix[proj_kind][i][j]*Amnk[spin][k][mu1][nindx+j].i;
                 }
-                tmpResult[i].r=sumr; 
-                tmpResult[i].i=sumi;
+                tmpResult[i].r=sumr;
+                tmpResult[i].i=sumi; 
               }
-	      /*              printf("windx=%i L=%i.\n",windx,L);fflush(0); */
-              for(i=0;i<2*L+1;i++){
-		/*                printf("i=%i \n",i);fflush(0);  */
-                tmpAmn[mu1][windx+i].r=tmpResult[i].r; 
-                tmpAmn[mu1][windx+i].i=tmpResult[i].i; 
-		/*                printf("i=%i \n",i);fflush(0); */
+              for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ /* Wannier_Num_Pro[proj_kind] number projectors */
+                Amnk[spin][k][mu1][nindx+i].r=tmpResult[i].r;
+                Amnk[spin][k][mu1][nindx+i].i=tmpResult[i].i;
               }
-              windx+=2*L+1; /* go over this L to the next */
-	      /*              printf("windx=%i L=%i.\n",windx,L);fflush(0); */
-            }else if(Wannier_NumL_Pro[proj_kind][L]!=0 && L==0){
-	      /* printf("proj_kind=%i, skip L=%i from %i to %i\n",proj_kind,L,windx,windx+2*L+1);fflush(0);  */
-              windx++; /* skip s orbital */
-            }
-          } /* Rotation done for each L */
-        }
-      }/* band index mu1 */   
-      /* Make selection */
-      /*      printf("For Selection:\n");fflush(0); */
-      for(mu1=0;mu1<band_num;mu1++){
-        windx=0; 
-        nindx=0;
-        for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
-          for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ /* Wannier_Num_Pro[proj_kind] number projectors */
-            Amnk[spin][k][mu1][nindx]=tmpAmn[mu1][Wannier_Select_Matrix[proj_kind][i]+windx];
-	    /*       printf("proj_kind=%i, chose %i from tmpAmn to Amnk[%i]\n",
-                     proj_kind, Wannier_Select_Matrix[proj_kind][i]+windx,nindx);
-	    */		     
-            nindx++;
+    	  /* 
+    	     printf("proj_kind=%i, from %i to %i hybridized.\n",proj_kind,nindx,nindx+Wannier_Num_Pro[proj_kind]);
+    	     for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ 
+    	     for(j=0;j<Wannier_Num_Pro[proj_kind];j++){
+    	     printf("%8.5f  ",Wannier_Projector_Hybridize_Matrix[proj_kind][i][j]);
+    	     }
+    	     printf("\n");
+    	     }
+    	  */
+              nindx+=Wannier_Num_Pro[proj_kind];
+            }           
+          }/* band index mu1 */  
+          /* just for Benzene MOs */
+          /*    printf("start Benzene!");fflush(0); */
+          if(0){
+    	for(mu1=0;mu1<nband;mu1++){
+    	  for(nindx=0;nindx<6*1;nindx++){
+    	    tmpResult[nindx].r=Amnk[spin][k][mu1][nindx].r;
+    	    tmpResult[nindx].i=Amnk[spin][k][mu1][nindx].i;
+    	  }
+    	  for(nindx=0;nindx<1;nindx++){
+    	    Amnk[spin][k][mu1][0+6*nindx].r=(tmpResult[0+6*nindx].r+tmpResult[1+6*nindx].r+tmpResult[2+6*nindx].r+tmpResult[3+6*nindx].r+tmpResult[4+6*nindx].r+tmpResult[5+6*nindx].r)/sqrt(6.0);
+    	    Amnk[spin][k][mu1][0+6*nindx].i=(tmpResult[0+6*nindx].i+tmpResult[1+6*nindx].i+tmpResult[2+6*nindx].i+tmpResult[3+6*nindx].i+tmpResult[4+6*nindx].i+tmpResult[5+6*nindx].i)/sqrt(6.0);
+
+    	    Amnk[spin][k][mu1][1+6*nindx].r=(tmpResult[1+6*nindx].r+tmpResult[2+6*nindx].r-tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(4.0);
+    	    Amnk[spin][k][mu1][1+6*nindx].i=(tmpResult[1+6*nindx].i+tmpResult[2+6*nindx].i-tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(4.0);
+
+    	    Amnk[spin][k][mu1][2+6*nindx].r=(2.0*tmpResult[0+6*nindx].r+tmpResult[1+6*nindx].r-tmpResult[2+6*nindx].r-2.0*tmpResult[3+6*nindx].r-tmpResult[4+6*nindx].r+tmpResult[5+6*nindx].r)/sqrt(12.0);
+    	    Amnk[spin][k][mu1][2+6*nindx].i=(2.0*tmpResult[0+6*nindx].i+tmpResult[1+6*nindx].i-tmpResult[2+6*nindx].i-2.0*tmpResult[3+6*nindx].i-tmpResult[4+6*nindx].i+tmpResult[5+6*nindx].i)/sqrt(12.0);
+
+    	    Amnk[spin][k][mu1][3+6*nindx].r=(tmpResult[1+6*nindx].r-tmpResult[2+6*nindx].r+tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(4.0);
+    	    Amnk[spin][k][mu1][3+6*nindx].i=(tmpResult[1+6*nindx].i-tmpResult[2+6*nindx].i+tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(4.0);
+
+    	    Amnk[spin][k][mu1][4+6*nindx].r=(2.0*tmpResult[0+6*nindx].r-tmpResult[1+6*nindx].r-tmpResult[2+6*nindx].r+2.0*tmpResult[3+6*nindx].r-tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(12.0);
+    	    Amnk[spin][k][mu1][4+6*nindx].i=(2.0*tmpResult[0+6*nindx].i-tmpResult[1+6*nindx].i-tmpResult[2+6*nindx].i+2.0*tmpResult[3+6*nindx].i-tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(12.0);
+
+    	    Amnk[spin][k][mu1][5+6*nindx].r=(tmpResult[0+6*nindx].r-tmpResult[1+6*nindx].r+tmpResult[2+6*nindx].r-tmpResult[3+6*nindx].r+tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(6.0);
+    	    Amnk[spin][k][mu1][5+6*nindx].i=(tmpResult[0+6*nindx].i-tmpResult[1+6*nindx].i+tmpResult[2+6*nindx].i-tmpResult[3+6*nindx].i+tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(6.0);
+    	  }
+    	}
           }
-          for (L=0; L<=3; L++){
-            windx += (2*L+1)*Wannier_NumL_Pro[proj_kind][L]; /* total number of basis for this kind of projector */
-          }
-        }
-      }/* band index mu1 */  
-      /* Make hybridization */ 
-      /*      printf("For Hybridization:\n");fflush(0);  */
-      for(mu1=0;mu1<band_num;mu1++){
-        nindx=0;
-        for(proj_kind=0;proj_kind<Wannier_Num_Kinds_Projectors; proj_kind++){
-          for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ /* Wannier_Num_Pro[proj_kind] number projectors */
-            sumr=0.0;sumi=0.0;
-            for(j=0;j<Wannier_Num_Pro[proj_kind];j++){ 
-              sumr=sumr+Wannier_Projector_Hybridize_Matrix[proj_kind][i][j]*Amnk[spin][k][mu1][nindx+j].r;
-              sumi=sumi+Wannier_Projector_Hybridize_Matrix[proj_kind][i][j]*Amnk[spin][k][mu1][nindx+j].i;
-            }
-            tmpResult[i].r=sumr;
-            tmpResult[i].i=sumi; 
-          }
-          for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ /* Wannier_Num_Pro[proj_kind] number projectors */
-            Amnk[spin][k][mu1][nindx+i].r=tmpResult[i].r;
-            Amnk[spin][k][mu1][nindx+i].i=tmpResult[i].i;
-          }
-	  /* 
-	     printf("proj_kind=%i, from %i to %i hybridized.\n",proj_kind,nindx,nindx+Wannier_Num_Pro[proj_kind]);
-	     for(i=0;i<Wannier_Num_Pro[proj_kind];i++){ 
-	     for(j=0;j<Wannier_Num_Pro[proj_kind];j++){
-	     printf("%8.5f  ",Wannier_Projector_Hybridize_Matrix[proj_kind][i][j]);
-	     }
-	     printf("\n");
-	     }
-	  */
-          nindx+=Wannier_Num_Pro[proj_kind];
-        }           
-      }/* band index mu1 */  
-      /* just for Benzene MOs */
-      /*    printf("start Benzene!");fflush(0); */
-      if(0){
-	for(mu1=0;mu1<band_num;mu1++){
-	  for(nindx=0;nindx<6*1;nindx++){
-	    tmpResult[nindx].r=Amnk[spin][k][mu1][nindx].r;
-	    tmpResult[nindx].i=Amnk[spin][k][mu1][nindx].i;
-	  }
-	  for(nindx=0;nindx<1;nindx++){
-	    Amnk[spin][k][mu1][0+6*nindx].r=(tmpResult[0+6*nindx].r+tmpResult[1+6*nindx].r+tmpResult[2+6*nindx].r+tmpResult[3+6*nindx].r+tmpResult[4+6*nindx].r+tmpResult[5+6*nindx].r)/sqrt(6.0);
-	    Amnk[spin][k][mu1][0+6*nindx].i=(tmpResult[0+6*nindx].i+tmpResult[1+6*nindx].i+tmpResult[2+6*nindx].i+tmpResult[3+6*nindx].i+tmpResult[4+6*nindx].i+tmpResult[5+6*nindx].i)/sqrt(6.0);
 
-	    Amnk[spin][k][mu1][1+6*nindx].r=(tmpResult[1+6*nindx].r+tmpResult[2+6*nindx].r-tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(4.0);
-	    Amnk[spin][k][mu1][1+6*nindx].i=(tmpResult[1+6*nindx].i+tmpResult[2+6*nindx].i-tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(4.0);
+      for(mu1=0;mu1<BAND;mu1++){
+        memcpy(&Abuf[sk][2*mu1*wan_num], Amnk[spin][k][mu1], sizeof(dcomplex)*wan_num);
+      }
+    }/* sk */
 
-	    Amnk[spin][k][mu1][2+6*nindx].r=(2.0*tmpResult[0+6*nindx].r+tmpResult[1+6*nindx].r-tmpResult[2+6*nindx].r-2.0*tmpResult[3+6*nindx].r-tmpResult[4+6*nindx].r+tmpResult[5+6*nindx].r)/sqrt(12.0);
-	    Amnk[spin][k][mu1][2+6*nindx].i=(2.0*tmpResult[0+6*nindx].i+tmpResult[1+6*nindx].i-tmpResult[2+6*nindx].i-2.0*tmpResult[3+6*nindx].i-tmpResult[4+6*nindx].i+tmpResult[5+6*nindx].i)/sqrt(12.0);
+    for(i=0;i<BAND;i++){
+      free(tmpAmn[i]); 
+    }
+    free(tmpAmn);
+    free(tmpResult);
 
-	    Amnk[spin][k][mu1][3+6*nindx].r=(tmpResult[1+6*nindx].r-tmpResult[2+6*nindx].r+tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(4.0);
-	    Amnk[spin][k][mu1][3+6*nindx].i=(tmpResult[1+6*nindx].i-tmpResult[2+6*nindx].i+tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(4.0);
+  } /* #pragma omp parallel */
 
-	    Amnk[spin][k][mu1][4+6*nindx].r=(2.0*tmpResult[0+6*nindx].r-tmpResult[1+6*nindx].r-tmpResult[2+6*nindx].r+2.0*tmpResult[3+6*nindx].r-tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(12.0);
-	    Amnk[spin][k][mu1][4+6*nindx].i=(2.0*tmpResult[0+6*nindx].i-tmpResult[1+6*nindx].i-tmpResult[2+6*nindx].i+2.0*tmpResult[3+6*nindx].i-tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(12.0);
+  /* MPI communication of Amnk */
 
-	    Amnk[spin][k][mu1][5+6*nindx].r=(tmpResult[0+6*nindx].r-tmpResult[1+6*nindx].r+tmpResult[2+6*nindx].r-tmpResult[3+6*nindx].r+tmpResult[4+6*nindx].r-tmpResult[5+6*nindx].r)/sqrt(6.0);
-	    Amnk[spin][k][mu1][5+6*nindx].i=(tmpResult[0+6*nindx].i-tmpResult[1+6*nindx].i+tmpResult[2+6*nindx].i-tmpResult[3+6*nindx].i+tmpResult[4+6*nindx].i-tmpResult[5+6*nindx].i)/sqrt(6.0);
-	  }
-	}
-      }
-      /*     printf("end Benzene!kpt=%i\n",k);fflush(0); */
-      if(Wannier_Output_Projection_Matrix && myid==Host_ID){ 
+  Rows_Allgather_Double(Abuf, sk_num, 2*BAND*wan_num, Aown);
+
+  for(sk=0;sk<sk_num;sk++){
+    spin = sk/kpt_num;
+    k = sk - spin*kpt_num;
+    for(mu1=0;mu1<BAND;mu1++){
+      memcpy(Amnk[spin][k][mu1], &Abuf[sk][2*mu1*wan_num], sizeof(dcomplex)*wan_num);
+    }
+    free(Abuf[sk]);
+  }
+  free(Abuf);
+  free(Aown);
+
+  if(Wannier_Output_Projection_Matrix && myid==Host_ID){ 
+    for(spin=0;spin<spinsize;spin++){
+      for(k=0;k<kpt_num;k++){
         for(nindx=0;nindx<wan_num;nindx++){
           for(mu1=0;mu1<BAND;mu1++){/* band index in enegy window */
             fprintf(fp,"%5d%5d%5d%18.12f%18.12f\n",mu1+1,nindx+1,k+1,Amnk[spin][k][mu1][nindx].r,Amnk[spin][k][mu1][nindx].i);
           } /* band */
         } /* wf */
-      }
-      /*    printf("next kpt=%i\n",k+1);fflush(0); */
-    }/* kpt */
-  }/* spin */  
-  if(Wannier_Output_Projection_Matrix && myid==Host_ID){
+      }/* kpt */
+    }/* spin */  
     fclose(fp);
   }
 
-  /**********************************************************
-           Free Arrays 
-  ***********************************************************/
-  for(i=0;i<band_num;i++){
-    free(tmpAmn[i]); 
-  }
-  free(tmpAmn);
-  free(tmpResult);
-
 }/* end of Projection_Amatrix */
 
 
@@ -5652,103 +5681,75 @@ void Initial_Guess_Mmnkb(dcomplex ****Uk, int spinsize, int kpt_num, int band_nu
 
 #pragma optimization_level 1
 void Updating_Mmnkb(dcomplex ***Uk, int kpt_num, int band_num, int wan_num, dcomplex ****Mmnkb, dcomplex ****Mmnkb_zero, double **kg, double **bvector, int tot_bvector, int **kplusb){
-  int bindx, nindx, spin, k, i, j;
-  int ki,kj,kk;
-  double kpb[3];
-  dcomplex **M_zero;
-  dcomplex **Uk_hermitian,**UkM;
-  dcomplex **Ukb;
-  double sumr, sumi;
-  int mu1;
-  FILE *fp;
 
-  /* allocation of arrays */
+  /* Mmnkb = Uk^{+}*Mmnkb_zero*Uk+b by two ZGEMMs for each pair of (k,b),
+     where the pairs are shared by the threads. */
 
-  M_zero=(dcomplex**)malloc(sizeof(dcomplex*)*band_num);
-  for(i=0; i<band_num; i++){
-    M_zero[i]=(dcomplex*)malloc(sizeof(dcomplex)*band_num);
-  }
+#pragma omp parallel shared(Uk,kpt_num,band_num,wan_num,Mmnkb,Mmnkb_zero,tot_bvector,kplusb)
+  {
+    int OMPID,Nthrds,kb,k,bindx,kk,i,mu1,BM,BN,BK;
+    dcomplex *U1,*U2,*M0,*UkM,*M1,Ctmp1,Ctmp2;
 
-  Uk_hermitian=(dcomplex**)malloc(sizeof(dcomplex*)*wan_num);
-  for(i=0; i<wan_num; i++){
-    Uk_hermitian[i]=(dcomplex*)malloc(sizeof(dcomplex)*band_num);
-  }
+    OMPID = omp_get_thread_num();
+    Nthrds = omp_get_num_threads();
 
-  UkM=(dcomplex**)malloc(sizeof(dcomplex*)*wan_num);
-  for(i=0; i<wan_num; i++){
-    UkM[i]=(dcomplex*)malloc(sizeof(dcomplex)*band_num);
-  }
+    /* allocation of arrays */
 
-  Ukb=(dcomplex**)malloc(sizeof(dcomplex*)*band_num);
-  for(i=0; i<band_num; i++){
-    Ukb[i]=(dcomplex*)malloc(sizeof(dcomplex)*wan_num);
-  }
+    U1  = (dcomplex*)malloc(sizeof(dcomplex)*band_num*wan_num);
+    U2  = (dcomplex*)malloc(sizeof(dcomplex)*band_num*wan_num);
+    M0  = (dcomplex*)malloc(sizeof(dcomplex)*band_num*band_num);
+    UkM = (dcomplex*)malloc(sizeof(dcomplex)*band_num*wan_num);
+    M1  = (dcomplex*)malloc(sizeof(dcomplex)*wan_num*wan_num);
 
-  /* start calc. */
+    Ctmp1.r = 1.0; Ctmp1.i = 0.0;
+    Ctmp2.r = 0.0; Ctmp2.i = 0.0;
+
+    /* start calc. */
+
+    for(kb=OMPID; kb<kpt_num*tot_bvector; kb+=Nthrds){
+
+      k = kb/tot_bvector;
+      bindx = kb - k*tot_bvector;
+      kk = kplusb[k][bindx]; 
+
+      /* column-major copies of Uk, Uk+b and Mmnkb_zero */
 
-  for(k=0;k<kpt_num;k++){ /* kpt */
-    for(bindx=0;bindx<tot_bvector;bindx++){ /* for b */
-      kk=kplusb[k][bindx]; 
-      for(mu1=0;mu1<band_num;mu1++){/*band */
-	for(nindx=0;nindx<wan_num;nindx++){ /* wan num */
-	  Uk_hermitian[nindx][mu1].r=Uk[k][mu1][nindx].r;
-	  Uk_hermitian[nindx][mu1].i=-Uk[k][mu1][nindx].i;
-	  Ukb[mu1][nindx].r=Uk[kk][mu1][nindx].r;
-	  Ukb[mu1][nindx].i=Uk[kk][mu1][nindx].i;
-	}/* wan num */
-      }/* band */
       for(mu1=0;mu1<band_num;mu1++){
-	for(i=0;i<band_num;i++){
-	  M_zero[mu1][i].r=Mmnkb_zero[k][bindx][mu1][i].r;
-	  M_zero[mu1][i].i=Mmnkb_zero[k][bindx][mu1][i].i;
+	for(i=0;i<wan_num;i++){
+	  U1[i*band_num+mu1] = Uk[k][mu1][i];
+	  U2[i*band_num+mu1] = Uk[kk][mu1][i];
 	}
-      }
-      /* updating by Uk^{+}*Mmnkb_zero*Uk+b */
-      for(i=0;i<wan_num;i++){
-	for(mu1=0;mu1<band_num;mu1++){
-	  sumr=0.0;sumi=0.0;
-	  for(j=0;j<band_num;j++){
-	    sumr=sumr+Uk_hermitian[i][j].r*M_zero[j][mu1].r-Uk_hermitian[i][j].i*M_zero[j][mu1].i;
-	    sumi=sumi+Uk_hermitian[i][j].r*M_zero[j][mu1].i+Uk_hermitian[i][j].i*M_zero[j][mu1].r;
-	  }
-	  UkM[i][mu1].r=sumr;  UkM[i][mu1].i=sumi;
+	for(i=0;i<band_num;i++){
+	  M0[i*band_num+mu1] = Mmnkb_zero[k][bindx][mu1][i];
 	}
       }
+
+      /* Uk^{+}*Mmnkb_zero */
+
+      BM = wan_num; BN = band_num; BK = band_num;
+      F77_NAME(zgemm,ZGEMM)("C","N", &BM,&BN,&BK, &Ctmp1, U1, &BK, M0, &BK, &Ctmp2, UkM, &BM);
+
+      /* (Uk^{+}*Mmnkb_zero)*Uk+b */
+
+      BM = wan_num; BN = wan_num; BK = band_num;
+      F77_NAME(zgemm,ZGEMM)("N","N", &BM,&BN,&BK, &Ctmp1, UkM, &BM, U2, &BK, &Ctmp2, M1, &BM);
+
       for(i=0;i<wan_num;i++){
-	for(j=0;j<wan_num;j++){
-	  sumr=0.0;sumi=0.0;
-	  for(mu1=0;mu1<band_num;mu1++){
-	    sumr=sumr+UkM[i][mu1].r*Ukb[mu1][j].r-UkM[i][mu1].i*Ukb[mu1][j].i;
-	    sumi=sumi+UkM[i][mu1].r*Ukb[mu1][j].i+UkM[i][mu1].i*Ukb[mu1][j].r;
-	  }
-	  Mmnkb[k][bindx][i][j].r=sumr; 
-	  Mmnkb[k][bindx][i][j].i=sumi;
+	for(mu1=0;mu1<wan_num;mu1++){
+	  Mmnkb[k][bindx][i][mu1] = M1[mu1*wan_num+i];
 	}
       }
-    }/* for b */
-  }/* kpt */
+    }/* kb */
 
-  /* freeing of arrays */
+    /* freeing of arrays */
 
-  for(i=0; i<band_num; i++){
-    free(M_zero[i]);
-  }
-  free(M_zero);
+    free(U1);
+    free(U2);
+    free(M0);
+    free(UkM);
+    free(M1);
 
-  for(i=0; i<wan_num; i++){
-    free(Uk_hermitian[i]);
-  }
-  free(Uk_hermitian);
-
-  for(i=0; i<wan_num; i++){
-    free(UkM[i]);
-  }
-  free(UkM);
-
-  for(i=0; i<band_num; i++){
-    free(Ukb[i]);
-  }
-  free(Ukb);
+  } /* #pragma omp parallel */
 
 }/* Updating_Mmnkb  */
 
@@ -6889,19 +6890,27 @@ void EigenState_k(double k1, double k2, double k3, int *MP, int spinsize, int Sp
 
 
 #pragma optimization_level 1
-void Calc_Mmnkb(int k, int kk, double k1[4], double k2[4], double b[4], 
-                int bindx, int SpinP_switch, int *MP, double Sop[2], 
-                dcomplex *Wk1, dcomplex *Wk2, int fsize, int mm, int nn)
+void Calc_OLPe_k(double k1[4], double b[4], int bindx, int *MP, int fsize, dcomplex *Pkb)
 {
+  /********************************************************************
+    Pkb is the overlap <i\alpha|exp(-ib\dot r)|j\beta> between the Bloch
+    sums at k1 and k2=k1+b, in a column-major array of fsize*fsize,
+    symmetrized in the same way as in the former element-wise loop.
+    Mmn(k,b) is then W(k1)^+ * Pkb * W(k2) for each spin component.
+  ********************************************************************/
+
   int ct_AN,tnoA,Anum,h_AN;
   int i1,j1,l1,l2,l3,Rnh,Gh_AN,tnoB,Bnum;
+  long int p,q;
   double si1,co1,si2,co2,kRn,dkx,dky,dkz;
-  double tmp1r,tmp1i,tmp2r1,tmp2i1,tmp2r2,tmp2i2;
-  double tmp3r,tmp3i,sumr,sumi;
+  double tmp3r,tmp3i;
+  double k2[4];
 
-  /****************************************************
-                 allocation of arrays:
-  ****************************************************/
+  for (p=0; p<(long int)fsize*fsize; p++){ Pkb[p].r = 0.0; Pkb[p].i = 0.0; }
+
+  k2[1] = k1[1] + b[1];
+  k2[2] = k1[2] + b[2];
+  k2[3] = k1[3] + b[3];
 
   /* b in Cartesian coordinate */
 
@@ -6909,197 +6918,59 @@ void Calc_Mmnkb(int k, int kk, double k1[4], double k2[4], double b[4],
   dky = b[1]*rtv[1][2] + b[2]*rtv[2][2] + b[3]*rtv[3][2];
   dkz = b[1]*rtv[1][3] + b[2]*rtv[2][3] + b[3]*rtv[3][3];
 
-  /****************************************************
-  calculate an overlap matrix between one-particle
-  wave functions  calculated at two k-points, k1 and k2
-  ****************************************************/
-
-  /* collinear  */
-
-  if (SpinP_switch==0 || SpinP_switch==1){
-
-    sumr = 0.0; 
-    sumi = 0.0; 
+  for (ct_AN=1; ct_AN<=atomnum; ct_AN++){ 
 
-    for (ct_AN=1; ct_AN<=atomnum; ct_AN++){ 
+    tnoA = Total_NumOrbs[ct_AN];
+    Anum = MP[ct_AN] - 1;
 
-      tnoA = Total_NumOrbs[ct_AN];
-      Anum = MP[ct_AN];
+    for (h_AN=0; h_AN<=FNAN[ct_AN]; h_AN++){
 
-      for (h_AN=0; h_AN<=FNAN[ct_AN]; h_AN++){
+      Rnh = ncn[ct_AN][h_AN];
+      Gh_AN = natn[ct_AN][h_AN];
+      tnoB = Total_NumOrbs[Gh_AN];
+      Bnum = MP[Gh_AN] - 1;
 
-	Rnh = ncn[ct_AN][h_AN];
-	Gh_AN = natn[ct_AN][h_AN];
-	tnoB = Total_NumOrbs[Gh_AN];
-	Bnum = MP[Gh_AN];
-
-	l1 = atv_ijk[Rnh][1];
-	l2 = atv_ijk[Rnh][2];
-	l3 = atv_ijk[Rnh][3];
+      l1 = atv_ijk[Rnh][1];
+      l2 = atv_ijk[Rnh][2];
+      l3 = atv_ijk[Rnh][3];
 	      
-	/*  exp[i(k2 dot Rn - dk dot taui ) ]  */
+      /*  0.5*exp[i(k2 dot Rn - dk dot taui ) ]  */
 
-	kRn = 2.0*PI*(k2[1]*(double)l1 + k2[2]*(double)l2 + k2[3]*(double)l3);
-	kRn -= (dkx*Gxyz[ct_AN][1] + dky*Gxyz[ct_AN][2] + dkz*Gxyz[ct_AN][3]);
+      kRn = 2.0*PI*(k2[1]*(double)l1 + k2[2]*(double)l2 + k2[3]*(double)l3);
+      kRn -= (dkx*Gxyz[ct_AN][1] + dky*Gxyz[ct_AN][2] + dkz*Gxyz[ct_AN][3]);
 
-	si1 = sin(kRn);  /* Imaginary part */
-	co1 = cos(kRn);  /* Real part      */
+      si1 = 0.5*sin(kRn);
+      co1 = 0.5*cos(kRn);
   	      
-	/*  exp[i(-k1 dot Rn - dk dot taui ) ]  */
-
-	kRn = -2.0*PI*(k1[1]*(double)l1 + k1[2]*(double)l2 + k1[3]*(double)l3);
-	kRn -= (dkx*Gxyz[ct_AN][1] + dky*Gxyz[ct_AN][2] + dkz*Gxyz[ct_AN][3]);
-
-	si2 = sin(kRn);  /* Imaginary part */
-	co2 = cos(kRn);  /* Real part      */
-
-	for (i1=0; i1<tnoA; i1++){
-	  for (j1=0; j1<tnoB; j1++){
-
-	    tmp1r = Wk1[Anum+i1].r*Wk2[Bnum+j1].r
-	          + Wk1[Anum+i1].i*Wk2[Bnum+j1].i;
-	    tmp1i = Wk1[Anum+i1].r*Wk2[Bnum+j1].i
-	          - Wk1[Anum+i1].i*Wk2[Bnum+j1].r;
-
-	    tmp2r1 = co1*tmp1r - si1*tmp1i;  
-	    tmp2i1 = co1*tmp1i + si1*tmp1r; 
-
-	    tmp1r = Wk1[Bnum+j1].r*Wk2[Anum+i1].r
-	          + Wk1[Bnum+j1].i*Wk2[Anum+i1].i;
-
-	    tmp1i = Wk1[Bnum+j1].r*Wk2[Anum+i1].i
-	          - Wk1[Bnum+j1].i*Wk2[Anum+i1].r;
-
-            tmp2r2 = co2*tmp1r - si2*tmp1i;
-            tmp2i2 = co2*tmp1i + si2*tmp1r;
+      /*  0.5*exp[i(-k1 dot Rn - dk dot taui ) ]  */
 
-            tmp3r = OLPe[bindx][ct_AN][h_AN][i1][j1].r;
-            tmp3i = OLPe[bindx][ct_AN][h_AN][i1][j1].i;
+      kRn = -2.0*PI*(k1[1]*(double)l1 + k1[2]*(double)l2 + k1[3]*(double)l3);
+      kRn -= (dkx*Gxyz[ct_AN][1] + dky*Gxyz[ct_AN][2] + dkz*Gxyz[ct_AN][3]);
 
-	    /* symmetrizing */
+      si2 = 0.5*sin(kRn);
+      co2 = 0.5*cos(kRn);
 
-	    sumr += 0.5*(tmp2r1+tmp2r2)*tmp3r - 0.5*(tmp2i1+tmp2i2)*tmp3i;
-	    sumi += 0.5*(tmp2r1+tmp2r2)*tmp3i + 0.5*(tmp2i1+tmp2i2)*tmp3r;
+      for (i1=0; i1<tnoA; i1++){
+	for (j1=0; j1<tnoB; j1++){
 
-	    /* no symmetrizing */
+	  tmp3r = OLPe[bindx][ct_AN][h_AN][i1][j1].r;
+	  tmp3i = OLPe[bindx][ct_AN][h_AN][i1][j1].i;
 
-	    /*
-	    sumr += tmp2r1*tmp3r - tmp2i1*tmp3i;
-	    sumi += tmp2r1*tmp3i + tmp2i1*tmp3r;
-	    */
-
-	  }/* j1*/
-	}/* i1 */
-      }   
-    }       
-
-    Sop[0] = sumr;
-    Sop[1] = sumi;
-
-  } /* if (SpinP_switch==0 || SpinP_switch==1) */
-
-  /* non-collinear  */
-
-  else if (SpinP_switch==3){
-
-    sumr = 0.0; 
-    sumi = 0.0; 
-
-    for (ct_AN=1; ct_AN<=atomnum; ct_AN++){ 
+	  /* row Anum+i1 of k1 and column Bnum+j1 of k2 */
 
-      tnoA = Total_NumOrbs[ct_AN];
-      Anum = MP[ct_AN];
+	  p = (long int)(Bnum+j1)*fsize + Anum + i1;
+	  Pkb[p].r += co1*tmp3r - si1*tmp3i;
+	  Pkb[p].i += co1*tmp3i + si1*tmp3r;
 
-      for (h_AN=0; h_AN<=FNAN[ct_AN]; h_AN++){
-
-	Rnh = ncn[ct_AN][h_AN];
-	Gh_AN = natn[ct_AN][h_AN];
-	tnoB = Total_NumOrbs[Gh_AN];
-	Bnum = MP[Gh_AN];
-
-	l1 = atv_ijk[Rnh][1];
-	l2 = atv_ijk[Rnh][2];
-	l3 = atv_ijk[Rnh][3];
-
-	/*  exp[i(k2 dot Rn - dk dot taui ) ]  */
-
-	kRn = 2.0*PI*(k2[1]*(double)l1 + k2[2]*(double)l2 + k2[3]*(double)l3);
-	kRn -= (dkx*Gxyz[ct_AN][1] + dky*Gxyz[ct_AN][2] + dkz*Gxyz[ct_AN][3]);
-
-	si1 = sin(kRn);  /* Imaginary part */
-	co1 = cos(kRn);  /* Real part      */
-
-	/*  exp[i(-k1 dot Rn - dk dot taui ) ]  */
-
-	kRn = -2.0*PI*(k1[1]*(double)l1 + k1[2]*(double)l2 + k1[3]*(double)l3);
-	kRn -= (dkx*Gxyz[ct_AN][1] + dky*Gxyz[ct_AN][2] + dkz*Gxyz[ct_AN][3]);
-
-	si2 = sin(kRn);  /* Imaginary part */
-	co2 = cos(kRn);  /* Real part      */
-    
-	for (i1=0; i1<tnoA; i1++){
-	  for (j1=0; j1<tnoB; j1++){
-
-	    tmp1r = Wk1[Anum      +i1].r*Wk2[Bnum      +j1].r
- 	          + Wk1[Anum      +i1].i*Wk2[Bnum      +j1].i
-	          + Wk1[Anum+fsize+i1].r*Wk2[Bnum+fsize+j1].r
-	          + Wk1[Anum+fsize+i1].i*Wk2[Bnum+fsize+j1].i;
-
-	    tmp1i = Wk1[Anum      +i1].r*Wk2[Bnum      +j1].i
-	          - Wk1[Anum      +i1].i*Wk2[Bnum      +j1].r
-	          + Wk1[Anum+fsize+i1].r*Wk2[Bnum+fsize+j1].i
-	          - Wk1[Anum+fsize+i1].i*Wk2[Bnum+fsize+j1].r;
-
-	    tmp2r1 = co1*tmp1r - si1*tmp1i;
-	    tmp2i1 = co1*tmp1i + si1*tmp1r;
-
-	    tmp1r = Wk1[Bnum      +j1].r*Wk2[Anum      +i1].r
- 	          + Wk1[Bnum      +j1].i*Wk2[Anum      +i1].i
-	          + Wk1[Bnum+fsize+j1].r*Wk2[Anum+fsize+i1].r
-	          + Wk1[Bnum+fsize+j1].i*Wk2[Anum+fsize+i1].i;
-
-	    tmp1i = Wk1[Bnum      +j1].r*Wk2[Anum      +i1].i
- 	          - Wk1[Bnum      +j1].i*Wk2[Anum      +i1].r
-	          + Wk1[Bnum+fsize+j1].r*Wk2[Anum+fsize+i1].i
-	          - Wk1[Bnum+fsize+j1].i*Wk2[Anum+fsize+i1].r;
-
-	    tmp2r2 = co2*tmp1r - si2*tmp1i;
-	    tmp2i2 = co2*tmp1i + si2*tmp1r;
-
-	    tmp3r = OLPe[bindx][ct_AN][h_AN][i1][j1].r;
-	    tmp3i = OLPe[bindx][ct_AN][h_AN][i1][j1].i;
-
-	    /* symmetrizing */
-
-	    sumr += 0.5*(tmp2r1+tmp2r2)*tmp3r - 0.5*(tmp2i1+tmp2i2)*tmp3i;
-	    sumi += 0.5*(tmp2r1+tmp2r2)*tmp3i + 0.5*(tmp2i1+tmp2i2)*tmp3r;
-
-	    /* no symmetrizing */
-
-	    /*
-	    sumr += tmp2r1*tmp3r - tmp2i1*tmp3i;
-	    sumi += tmp2r1*tmp3i + tmp2i1*tmp3r;
-	    */
-
-
-	    /*
-        if (k==99 && bindx==9 && mm==1 && nn==0){
-
-    printf("bindx=%2d ct_AN=%2d h_AN=%2d i1=%2d j1=%2d tmp2r1=%15.12f tmp2i1=%15.12f tmp3r=%15.12f tmp3i=%15.12f sumr=%15.12f sumi=%15.12f\n",
-	   bindx,ct_AN,h_AN,i1,j1,tmp2r1,tmp2i1,tmp3r,tmp3i,sumr,sumi); 
-	}
-	    */
+	  /* row Bnum+j1 of k1 and column Anum+i1 of k2 */
 
-	  }
+	  q = (long int)(Anum+i1)*fsize + Bnum + j1;
+	  Pkb[q].r += co2*tmp3r - si2*tmp3i;
+	  Pkb[q].i += co2*tmp3i + si2*tmp3r;
 	}
-      }   
-    }       
-
-    Sop[0] = sumr;
-    Sop[1] = sumi;
-
-  } /* else if (SpinP_switch==3) */
-
+      }
+    }   
+  }       
 }  
 
 
@@ -8157,7 +8028,7 @@ void Disentangling_Bands(dcomplex ****Uk, dcomplex *****Mmnkb_zero, int spinsize
   double omega_I, omega_I_prev, delta_OI,dis_conv_tol,dis_alpha_mix; 
   double wbtot, sumr, sumi;
   dcomplex ****Mmnkb, ***Udis;
-  int **nbandwin, **nbandfroz, Mk, kpb, kpb_band, lwork, lda, info;
+  int **nbandwin, **nbandfroz, Mk, lwork, lda, info;
   dcomplex **Utmp;
   char jobz, uplo; 
   dcomplex *work;
@@ -8324,9 +8195,29 @@ void Disentangling_Bands(dcomplex ****Uk, dcomplex *****Mmnkb_zero, int spinsize
       omega_I_prev=omega_I;
       omega_I=0.0;
       /* omega_I contributed by frozen states
-	 Eq. (12) of paper of SMV */
+	 Eq. (12) of paper of SMV.
+         The k-points are shared by the threads. */
+
+      sumi=0.0;
+
+#pragma omp parallel shared(kpt_num,tot_bvector,nbandwin,nbandfroz,kplusb,Udis,Mmnkb,wb,wan_num,BAND) reduction(+:sumi)
+      {
+        int k,bindx,i,j,l,nband,Mk,kpb,kpb_band;
+        double sumr,sumi2;
+        dcomplex **Utmp,**Hrot;
+
+        Utmp=(dcomplex**)malloc(sizeof(dcomplex*)*BAND);
+        for(i=0;i<BAND;i++){
+          Utmp[i]=(dcomplex*)malloc(sizeof(dcomplex)*BAND);
+        }
+        Hrot=(dcomplex**)malloc(sizeof(dcomplex*)*wan_num);
+        for(i=0;i<wan_num;i++){
+          Hrot[i]=(dcomplex*)malloc(sizeof(dcomplex)*wan_num);
+        }
+
+#pragma omp for schedule(dynamic)
       for(k=0;k<kpt_num;k++){
-	band_num=nbandwin[k][1]-nbandwin[k][0];
+	nband=nbandwin[k][1]-nbandwin[k][0];
 	Mk=nbandfroz[k][1]-nbandfroz[k][0];
 	if(Mk>0){ 
 	  for(bindx=0;bindx<tot_bvector;bindx++){
@@ -8335,25 +8226,25 @@ void Disentangling_Bands(dcomplex ****Uk, dcomplex *****Mmnkb_zero, int spinsize
 	    /* U(k)^dagger * M(k,b) (Mk1 x Nk1) x (Nk1 x Nk2) */
 	    for(i=0;i<Mk;i++){  /* frozen states are putted in the lowest coloumns */
 	      for(j=0;j<kpb_band;j++){
-		sumr=0.0; sumi=0.0;
-		for(l=0;l<band_num;l++){
+		sumr=0.0; sumi2=0.0;
+		for(l=0;l<nband;l++){
 		  sumr=sumr+Udis[k][l][i].r*Mmnkb[k][bindx][l][j].r+Udis[k][l][i].i*Mmnkb[k][bindx][l][j].i;
-		  sumi=sumi+Udis[k][l][i].r*Mmnkb[k][bindx][l][j].i-Udis[k][l][i].i*Mmnkb[k][bindx][l][j].r;
+		  sumi2=sumi2+Udis[k][l][i].r*Mmnkb[k][bindx][l][j].i-Udis[k][l][i].i*Mmnkb[k][bindx][l][j].r;
 		}
 		Utmp[i][j].r=sumr;
-		Utmp[i][j].i=sumi;
+		Utmp[i][j].i=sumi2;
 	      } 
 	    }
 	    /* U(k)^dagger * M(k,b) * U(k+b)  ( Mk1 x Nk2 ) x (Nk2 x WAN_NUM) */
 	    for(i=0;i<Mk;i++){
 	      for(j=0;j<wan_num;j++){
-		sumr=0.0; sumi=0.0;
+		sumr=0.0; sumi2=0.0;
 		for(l=0;l<kpb_band;l++){
 		  sumr=sumr+Utmp[i][l].r*Udis[kpb][l][j].r-Utmp[i][l].i*Udis[kpb][l][j].i;
-		  sumi=sumi+Utmp[i][l].r*Udis[kpb][l][j].i+Utmp[i][l].i*Udis[kpb][l][j].r;
+		  sumi2=sumi2+Utmp[i][l].r*Udis[kpb][l][j].i+Utmp[i][l].i*Udis[kpb][l][j].r;
 		}
 		Hrot[i][j].r=sumr;
-		Hrot[i][j].i=sumi;
+		Hrot[i][j].i=sumi2;
 	      } 
 	    }
 	    /* Now Hrot contains the rotated overlap matrix (Mk1 x wan_num) */
@@ -8363,10 +8254,24 @@ void Disentangling_Bands(dcomplex ****Uk, dcomplex *****Mmnkb_zero, int spinsize
 		sumr=sumr+Hrot[i][j].r*Hrot[i][j].r+Hrot[i][j].i*Hrot[i][j].i;
 	      }
 	    }   
-	    omega_I=omega_I+wb[bindx]*sumr;
+	    sumi=sumi+wb[bindx]*sumr;
 	  }/*  bindx */ 
 	}/* if there is frozen state */  
       }/* kpt */  
+
+        for(i=0;i<BAND;i++){
+          free(Utmp[i]);
+        }
+        free(Utmp);
+        for(i=0;i<wan_num;i++){
+          free(Hrot[i]);
+        }
+        free(Hrot);
+
+      } /* #pragma omp parallel */
+
+      omega_I=omega_I+sumi;
+
       for(k=0;k<kpt_num;k++){
 	band_num=nbandwin[k][1]-nbandwin[k][0];
 	Mk=nbandfroz[k][1]-nbandfroz[k][0];
@@ -8380,19 +8285,43 @@ void Disentangling_Bands(dcomplex ****Uk, dcomplex *****Mmnkb_zero, int spinsize
          MPI_Finalize();
 	 exit(0);
 	}
+      }/* kpt*/
+
+      /* the Z matrices of the k-points are calculated by the threads */
+
+#pragma omp parallel shared(kpt_num,nbandwin,nbandfroz,wb,tot_bvector,Mmnkb,Udis,kplusb,wan_num,Zmat_i,BAND)
+      {
+        int k,i,j,nband,Mk;
+        dcomplex **Utmp;
+
+        Utmp=(dcomplex**)malloc(sizeof(dcomplex*)*BAND);
+        for(i=0;i<BAND;i++){
+          Utmp[i]=(dcomplex*)malloc(sizeof(dcomplex)*BAND);
+        }
+
+#pragma omp for schedule(dynamic)
+      for(k=0;k<kpt_num;k++){
+	nband=nbandwin[k][1]-nbandwin[k][0];
+	Mk=nbandfroz[k][1]-nbandfroz[k][0];
 	if(Mk<wan_num){
-	  Getting_Zmatrix(Utmp,k,wb,tot_bvector,Mmnkb,Udis,kplusb,band_num,wan_num,Mk,nbandwin,nbandfroz);
-	  for(i=0;i<band_num-Mk;i++){
-	    for(j=0;j<band_num-Mk;j++){
+	  Getting_Zmatrix(Utmp,k,wb,tot_bvector,Mmnkb,Udis,kplusb,nband,wan_num,Mk,nbandwin,nbandfroz);
+	  for(i=0;i<nband-Mk;i++){
+	    for(j=0;j<nband-Mk;j++){
 	      Zmat_i[k][i][j].r=Utmp[i][j].r;
 	      Zmat_i[k][i][j].i=Utmp[i][j].i;
 	    }
 	  }
-	}else{
-	  continue; /* ignore those k points with Mk equal to wan_num */
 	}
+	/* ignore those k points with Mk equal to wan_num */
       }/* kpt*/
 
+        for(i=0;i<BAND;i++){
+          free(Utmp[i]);
+        }
+        free(Utmp);
+
+      } /* #pragma omp parallel */
+
       for(k=0;k<kpt_num;k++){
 	band_num=nbandwin[k][1]-nbandwin[k][0];
 	Mk=nbandfroz[k][1]-nbandfroz[k][0];
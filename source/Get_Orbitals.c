@@ -40,14 +40,16 @@ void Get_Orbitals(int wan, double x, double y, double z, double *Chi)
    double AF[List_YOUSO[25]+1][2*(List_YOUSO[25]+1)+1];
   ****************************************************/
 
-  RF = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  Arena_Push();
+
+  RF = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    RF[i] = (double*)malloc(sizeof(double)*List_YOUSO[24]);
+    RF[i] = (double*)Arena_Alloc(sizeof(double)*List_YOUSO[24]);
   }
 
-  AF = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  AF = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    AF[i] = (double*)malloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
+    AF[i] = (double*)Arena_Alloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
   }
 
   /* start calc. */
@@ -295,14 +297,6 @@ void Get_Orbitals(int wan, double x, double y, double z, double *Chi)
    double AF[List_YOUSO[25]+1][2*(List_YOUSO[25]+1)+1];
   ****************************************************/
 
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(RF[i]);
-  }
-  free(RF);
-
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(AF[i]);
-  }
-  free(AF);
+  Arena_Pop();
 
 }
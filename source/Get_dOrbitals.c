@@ -49,29 +49,31 @@ void Get_dOrbitals(int wan, double x, double y, double z, double **dChi)
    double dAFP[List_YOUSO[25]+1][2*(List_YOUSO[25]+1)+1];
   ****************************************************/
 
-  RF = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  Arena_Push();
+
+  RF = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    RF[i] = (double*)malloc(sizeof(double)*List_YOUSO[24]);
+    RF[i] = (double*)Arena_Alloc(sizeof(double)*List_YOUSO[24]);
   }
 
-  dRF = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  dRF = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    dRF[i] = (double*)malloc(sizeof(double)*List_YOUSO[24]);
+    dRF[i] = (double*)Arena_Alloc(sizeof(double)*List_YOUSO[24]);
   }
 
-  AF = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  AF = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    AF[i] = (double*)malloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
+    AF[i] = (double*)Arena_Alloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
   }
 
-  dAFQ = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  dAFQ = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    dAFQ[i] = (double*)malloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
+    dAFQ[i] = (double*)Arena_Alloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
   }
 
-  dAFP = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
+  dAFP = (double**)Arena_Alloc(sizeof(double*)*(List_YOUSO[25]+1));
   for (i=0; i<(List_YOUSO[25]+1); i++){
-    dAFP[i] = (double*)malloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
+    dAFP[i] = (double*)Arena_Alloc(sizeof(double)*(2*(List_YOUSO[25]+1)+1));
   }
 
   /* start calc. */
@@ -437,30 +439,7 @@ void Get_dOrbitals(int wan, double x, double y, double z, double **dChi)
    double dAFP[List_YOUSO[25]+1][2*(List_YOUSO[25]+1)+1];
   ****************************************************/
 
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(RF[i]);
-  }
-  free(RF);
-
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(dRF[i]);
-  }
-  free(dRF);
-
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(AF[i]);
-  }
-  free(AF);
-
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(dAFQ[i]);
-  }
-  free(dAFQ);
-
-  for (i=0; i<(List_YOUSO[25]+1); i++){
-    free(dAFP[i]);
-  }
-  free(dAFP);
+  Arena_Pop();
 
 }
 
@@ -0,0 +1,83 @@
+/**********************************************************************
+  Grid_Precision.c:
+
+     Grid_Precision.c is a set of subroutines to exchange the data on
+     grids between the partitions A, B, C, and D in single precision
+     during the SCF iterations.
+
+     Grid_Precision_Set:  the precision of the exchange is chosen by
+                          scf.Grid.Precision and the residual norm
+     Grid_Float_Pack:     doubles in a send buffer are converted to
+                          floats in place
+     Grid_Float_Unpack:   floats in a receive buffer are converted
+                          back to doubles in place
+
+     The data on grids are stored and accumulated in double precision,
+     and only the messages are halved. The exchange is promoted to
+     double precision once NormRD falls below the criterion given by
+     scf.Grid.Promotion.Criterion, and after the SCF, so that the
+     converged density and the total energy are not affected.
+
+  Log of Grid_Precision.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "mpi.h"
+
+
+
+void Grid_Precision_Set(double NormRD0)
+{
+  int myid,po;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  po = Grid_Float_Comm;
+
+  if (Grid_Precision==1 && Grid_Promotion_Criterion<NormRD0) Grid_Float_Comm = 1;
+  else                                                       Grid_Float_Comm = 0;
+
+  if (po==1 && Grid_Float_Comm==0 && myid==Host_ID && 0<level_stdout){
+    printf("<Grid_Precision> the data on grids are exchanged in double precision\n");
+  }
+}
+
+
+void Grid_Float_Pack(double *a, int n)
+{
+  int i;
+  float f;
+
+  if (Grid_Float_Comm==0) return;
+
+  /* the i-th float overwrites only a[i/2], which has been read */
+
+  for (i=0; i<n; i++){
+    f = (float)a[i];
+    memcpy((char*)a+sizeof(float)*i, &f, sizeof(float));
+  }
+}
+
+
+void Grid_Float_Unpack(double *a, int n)
+{
+  int i;
+  float f;
+
+  if (Grid_Float_Comm==0) return;
+
+  /* a[i] overwrites only the (2i)-th and (2i+1)-th floats,
+     which have been read */
+
+  for (i=n-1; 0<=i; i--){
+    memcpy(&f, (char*)a+sizeof(float)*i, sizeof(float));
+    a[i] = (double)f;
+  }
+}
@@ -89,6 +89,15 @@ void Input_std(char *file)
   input_int("level.of.stdout", &level_stdout,1);
   input_int("level.of.fileout",&level_fileout,1);
   input_logical("memory.usage.fileout",&memoryusage_fileout,0); /* default=off */
+  input_logical("memory.shared.tables",&Shared_Tables_flag,1); /* default=on */
+
+  s_vec[0]="None"; s_vec[1]="Compact"; s_vec[2]="Spread";
+  i_vec[0]=0;      i_vec[1]=1;         i_vec[2]=2;
+  input_string2int("NUMA.Bind",&NUMA_Bind,3,s_vec,i_vec);
+  input_logical("NUMA.FirstTouch",&NUMA_FirstTouch,1); /* default=on */
+
+  input_logical("species.cache",&Species_Cache_flag,0); /* default=off */
+  input_string("species.cache.dir",Species_Cache_Dir,"./species_cache");
 
   if (level_stdout<0 || 3<level_stdout){
     printf("Invalid value of level.of.stdout\n");
@@ -107,6 +116,14 @@ void Input_std(char *file)
   input_logical("scf.ProExpn.VNA",&ProExpn_VNA,1); /* default=on */
   input_int("scf.BufferL.VNA", &BufferL_ProVNA,6);
   input_int("scf.RadialF.VNA", &List_YOUSO[34],12);
+
+  /****************************************************
+       storing gradients of orbitals on grids
+  ****************************************************/
+
+  s_vec[0]="Auto"; s_vec[1]="On"; s_vec[2]="Off";
+  i_vec[0]=2;      i_vec[1]=1;    i_vec[2]=0;
+  input_string2int("scf.dOrbs.Grid",&dOrbs_Grid_switch,3,s_vec,i_vec);
   
   /****************************************************
                       cutoff energy 
@@ -591,14 +608,14 @@ void Input_std(char *file)
   s_vec[0]="Recursion";     s_vec[1]="Cluster"; s_vec[2]="Band";
   s_vec[3]="NEGF";          s_vec[4]="DC";      s_vec[5]="GDC";
   s_vec[6]="Cluster-DIIS";  s_vec[7]="Krylov";  s_vec[8]="Cluster2";  
-  s_vec[9]="EC";  
+  s_vec[9]="EC";            s_vec[10]="Purify";  s_vec[11]="Pole";
   
   i_vec[0]=1;  i_vec[1]=2;  i_vec[2]=3;
   i_vec[3]=4;  i_vec[4]=5;  i_vec[5]=6;
   i_vec[6]=7;  i_vec[7]=8;  i_vec[8]=9;
-  i_vec[9]=10;
+  i_vec[9]=10; i_vec[10]=11; i_vec[11]=12;
 
-  input_string2int("scf.EigenvalueSolver", &Solver, 10, s_vec,i_vec);
+  input_string2int("scf.EigenvalueSolver", &Solver, 12, s_vec,i_vec);
 
   if (Solver==1){
     if (myid==Host_ID){
@@ -625,6 +642,15 @@ void Input_std(char *file)
   i_vec[0]=1;       i_vec[1]=0;       
   input_string2int("scf.eigen.lib", &scf_eigen_lib_flag, 3, s_vec,i_vec);
 
+  /* Chebyshev-filtered subspace iteration for the cluster calculation */
+
+  input_logical("scf.Eigen.Subspace",&Eigen_Subspace_flag,0); /* default=off */
+  input_int("scf.Eigen.Subspace.Degree",&Eigen_Subspace_Degree,8);
+  input_int("scf.Eigen.Subspace.MaxIter",&Eigen_Subspace_MaxIter,10);
+  input_double("scf.Eigen.Subspace.Criterion",&Eigen_Subspace_Criterion,(double)1.0e-7);
+
+  if (Eigen_Subspace_Degree<2) Eigen_Subspace_Degree = 2;
+
   if (Solver==1){
     if (myid==Host_ID){
       printf("Recursion method is not supported in this version.\n");
@@ -684,6 +710,22 @@ void Input_std(char *file)
     exit(1);
   }
 
+  if (SpinP_switch==3 && Solver==11){
+    if (myid==Host_ID){
+      printf("The purification method is not supported for non-collinear calculations.\n");
+    }
+    MPI_Finalize();
+    exit(1);
+  }
+
+  if (SpinP_switch==3 && Solver==12){
+    if (myid==Host_ID){
+      printf("The pole expansion method is not supported for non-collinear calculations.\n");
+    }
+    MPI_Finalize();
+    exit(1);
+  }
+
   if (XC_switch==1 && 1<=SpinP_switch){
     if (myid==Host_ID){
       printf("SpinP_switch should be OFF for this exchange functional.\n");
@@ -1017,6 +1059,18 @@ void Input_std(char *file)
     po++;
   }
 
+  /* precision of the data on grids exchanged during SCF */
+
+  s_vec[0]="Double"; s_vec[1]="Mixed";
+  i_vec[0]=0;        i_vec[1]=1;
+  input_string2int("scf.Grid.Precision",&Grid_Precision,2,s_vec,i_vec);
+
+  input_double("scf.Grid.Promotion.Criterion",&Grid_Promotion_Criterion,(double)(100.0*SCF_Criterion));
+  if (Grid_Promotion_Criterion<0.0){
+    printf("scf.Grid.Promotion.Criterion=%10.9f should be larger than 0.\n",Grid_Promotion_Criterion);
+    po++;
+  }
+
   input_double("scf.system.charge",&system_charge,(double)0.0);
 
   /* scf.fixed.grid */
@@ -1027,6 +1081,48 @@ void Input_std(char *file)
   TRAN_Input_std(MPI_COMM_WORLD1, Solver, SpinP_switch, filepath, kB, 
                  eV2Hartree, E_Temp, &output_hks);
 
+  /********************************************************
+              solver of Poisson's equation
+  *********************************************************/
+
+  s_vec[0]="FFT"; s_vec[1]="CG";
+  i_vec[0]=0    ; i_vec[1]=1   ;
+  input_string2int("scf.Poisson.Solver", &Poisson_RS_switch, 2, s_vec,i_vec);
+
+  {
+    char bcbuf[3][YOUSO10],*bc[3],*bcdef[3];
+
+    for (i=0; i<3; i++){
+      bc[i] = bcbuf[i];
+      bcdef[i] = "periodic";
+    }
+
+    input_stringv("scf.Poisson.Boundary",3,bc,bcdef);
+
+    for (i=0; i<3; i++){
+      if      (strcasecmp(bc[i],"periodic")==0) Poisson_RS_BC[i+1] = 0;
+      else if (strcasecmp(bc[i],"open")==0)     Poisson_RS_BC[i+1] = 1;
+      else {
+        if (myid==Host_ID){
+          printf("scf.Poisson.Boundary should be periodic or open for each axis.\n");
+        }
+        MPI_Finalize();
+        exit(0);
+      }
+    }
+  }
+
+  input_int("scf.Poisson.CG.MaxIter",&Poisson_RS_MaxIter,500);
+  input_double("scf.Poisson.CG.Criterion",&Poisson_RS_Criterion,(double)1.0e-10);
+
+  if (Poisson_RS_switch==0 && (Poisson_RS_BC[1]!=0 || Poisson_RS_BC[2]!=0 || Poisson_RS_BC[3]!=0)){
+    if (myid==Host_ID){
+      printf("The open boundary of scf.Poisson.Boundary is supported only by scf.Poisson.Solver=CG.\n");
+    }
+    MPI_Finalize();
+    exit(0);
+  }
+
   /********************************************************
     Effective Screening Medium (ESM) method Calculation 
                                       added by T.Ohwaki                                   
@@ -1970,6 +2066,16 @@ void Input_std(char *file)
     po++;
   }
 
+  /****************************************************
+        parameters for the pole expansion method
+  ****************************************************/
+
+  input_int("scf.Npoles.Pole",&Pole_Npoles,100);
+  if (Pole_Npoles<1) {
+    printf("scf.Npoles.Pole should be over 0.\n");
+    po++;
+  }
+
   /****************************************************
                  Net charge of the system
   ****************************************************/
@@ -2012,6 +2118,7 @@ void Input_std(char *file)
   ****************************************************/
 
   input_logical("Band.dispersion",&Band_disp_switch, 0);
+  input_logical("Band.restart",&Band_Restart,0); /* default=off */
 
   Band_kpath=NULL;
   Band_kname=NULL;
@@ -2187,7 +2294,7 @@ void Input_std(char *file)
   BCR=BCR/BohrR;
 
   input_int("orderN.NumHoppings",&NOHS_L,2);
-  if (Solver==2 || Solver==3 || Solver==4 || Solver==7 || Solver==9){
+  if (Solver==2 || Solver==3 || Solver==4 || Solver==7 || Solver==9 || Solver==11 || Solver==12){
     NOHS_L = 1;
     BCR = 1.0;
   }
@@ -2200,6 +2307,14 @@ void Input_std(char *file)
 
   /* end EC */
 
+  /* start Purify */
+
+  input_double("orderN.Purify.Threshold",&Purify_Threshold,(double)1.0e-7);
+  input_double("orderN.Purify.Criterion",&Purify_Criterion,(double)1.0e-10);
+  input_int("orderN.Purify.MaxIter",&Purify_MaxIter,100);
+
+  /* end Purify */
+
   /* start Krylov */
 
   /* input_int("orderN.Kgrid",&orderN_Kgrid,5); */
@@ -2725,6 +2840,33 @@ void Input_std(char *file)
   i_vec[0]=Kspace_grid1; i_vec[1]=Kspace_grid2, i_vec[2]=Kspace_grid3;
   input_intv("Dos.Kgrid",3,Dos_Kgrid,i_vec);
 
+  /* on-the-fly accumulation of DOS and PDOS, and the dump for DosMain */
+
+  s_vec[0]="Off"; s_vec[1]="Gaussian"; s_vec[2]="Histgram"; s_vec[3]="Tetrahedron";
+  i_vec[0]=0;     i_vec[1]=1;          i_vec[2]=2;          i_vec[3]=3;
+  input_string2int("Dos.Accumulate",&Dos_Accum_Method,4,s_vec,i_vec);
+  input_logical("Dos.Dump",&Dos_Dump,1);
+
+  if (Dos_Accum_Method!=0 && Dos_fileout==0){
+
+    if (myid==Host_ID){
+      printf("Dos.Accumulate is supported only if Dos.fileout=on.\n");
+    }
+    MPI_Finalize();
+    exit(1);
+  }
+
+  if (Dos_Accum_Method!=0 && (SpinP_switch==3 || Opticalconductivity_fileout || (Solver!=2 && Solver!=3))){
+
+    if (myid==Host_ID){
+      printf("Dos.Accumulate is supported only for the collinear cluster and band calculations.\n");
+    }
+    MPI_Finalize();
+    exit(1);
+  }
+
+  if (Dos_Accum_Method==0) Dos_Dump = 1;
+
   /**********************************************************
    calculation of partial charge for scanning tunneling 
    microscopy (STM) simulations by the Tersoff-Hamann scheme
@@ -2787,6 +2929,12 @@ void Input_std(char *file)
 
   input_logical("Voronoi.orbital.moment",&Voronoi_OrbM_flag,0);
 
+  /****************************************************
+     cache of the fuzzy weights shared by the above
+  ****************************************************/
+
+  input_logical("Voronoi.weight.cache",&Voronoi_Weight_Cache,1);
+
   /****************************************************
        parameters on Wannier funtions by hmweng
   ****************************************************/
@@ -45,6 +45,30 @@ int input_open(const  char *fname)
   return 1;
 }
 
+/* the same as input_open, but for a stream opened by the caller, 
+   e.g., an image of the file in memory */
+
+int input_open_stream(FILE *f, const  char *fname)
+{
+
+  nestlevel++;
+  if (nestlevel>=MAXNEST) {
+    printf("input_open: can not open a further file. nestlevel=%d\n",nestlevel);
+    return 0; 
+  }
+
+  fp=fpnest[nestlevel]=f;
+
+  errorlevel = 0;
+
+  if (fp==NULL) {
+    printf("input_open: can not open %s\n",fname);
+    return 0;
+  }
+
+  return 1;
+}
+
 int input_close()
 {
   int ret;
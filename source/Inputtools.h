@@ -1,4 +1,5 @@
 int input_open(const  char *fname);
+int input_open_stream(FILE *f, const  char *fname);
 int input_close();
 int input_cmpstring( char *str,  int *ret, int nvals,  char **strval,  int *ivals);
 int input_logical(const char *key, int *ret,const  int defval);
@@ -0,0 +1,155 @@
+/**********************************************************************
+  Kpath_Restart.c:
+
+     Kpath_Restart.c is a set of subroutines to resume calculations
+     along k-paths, i.e., the band dispersion and the unfolding, from
+     the k-points already written to the output files.
+
+     Kpath_Restart_Open:  Host_ID reopens the output files cut at the
+                          end of the last finished k-point, and the
+                          number of the finished k-points is returned
+                          to all the processes
+     Kpath_Restart_Save:  Host_ID flushes the output files, and records
+                          their sizes with the number of the finished
+                          k-points
+     Kpath_Restart_Hash:  a hash of the k-paths, i.e., the end points
+                          and the numbers of k-points of the segments
+
+     The record is stored in System.Name with a given extension, and
+     is used only if Band.restart is on, and the number of k-points,
+     the size of the matrices, and the hash of the k-paths are the
+     same as the calculation.
+
+  Log of Kpath_Restart.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "openmx_common.h"
+#include "mpi.h"
+
+
+
+unsigned long long Kpath_Restart_Hash(unsigned long long key, void *p, size_t size)
+{
+  size_t i;
+  unsigned char *c;
+
+  /* FNV-1a, where key=0 starts a new hash */
+
+  if (key==0) key = 14695981039346656037ULL;
+
+  c = (unsigned char*)p;
+  for (i=0; i<size; i++){
+    key ^= (unsigned long long)c[i];
+    key *= 1099511628211ULL;
+  }
+
+  return key;
+}
+
+
+int Kpath_Restart_Open(char *ext, int nkpt, int n, unsigned long long key,
+                       int nf, char **exts, FILE **fp)
+{
+  int myid,i,po,kdone,nkpt0,n0;
+  unsigned long long key0;
+  long int *off;
+  char fname[YOUSO10];
+  FILE *fpr;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  kdone = 0;
+
+  if (myid==Host_ID && Band_Restart==1){
+
+    off = (long int*)malloc(sizeof(long int)*(nf+1));
+
+    strcpy(fname,ext);
+    fnjoint(filepath,filename,fname);
+
+    po = 0;
+    if ((fpr = fopen(fname,"r")) != NULL){
+      if (fscanf(fpr,"%d %d %d %llx",&nkpt0,&n0,&kdone,&key0)==4) po = 1;
+      for (i=0; i<nf && po==1; i++){
+        if (fscanf(fpr,"%ld",&off[i])!=1) po = 0;
+      }
+      fclose(fpr);
+    }
+
+    if (po==0 || nkpt0!=nkpt || n0!=n || key0!=key || kdone<=0 || nkpt<kdone) kdone = 0;
+
+    /* the files are cut at the recorded sizes */
+
+    for (i=0; i<nf && 0<kdone; i++){
+
+      strcpy(fname,exts[i]);
+      fnjoint(filepath,filename,fname);
+
+      if ((fp[i] = fopen(fname,"r+")) == NULL
+          || fseek(fp[i],0,SEEK_END)!=0 || ftell(fp[i])<off[i]
+          || ftruncate(fileno(fp[i]),off[i])!=0
+          || fseek(fp[i],off[i],SEEK_SET)!=0){
+
+        printf("<Kpath_Restart> could not resume %s\n",fname);
+        if (fp[i]!=NULL) fclose(fp[i]);
+        while (0<i){ i--; fclose(fp[i]); }
+        kdone = 0;
+      }
+    }
+
+    if (0<kdone && 0<level_stdout){
+      printf("<Kpath_Restart> %d of %d k-points were found\n",kdone,nkpt);
+    }
+
+    free(off);
+  }
+
+  MPI_Bcast(&kdone, 1, MPI_INT, Host_ID, mpi_comm_level1);
+
+  return kdone;
+}
+
+
+void Kpath_Restart_Save(char *ext, int nkpt, int n, unsigned long long key,
+                        int kdone, int nf, FILE **fp)
+{
+  int myid,i;
+  char fname[YOUSO10],ftmp[YOUSO10+32];
+  FILE *fpr;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  if (myid!=Host_ID) return;
+
+  for (i=0; i<nf; i++){
+    if (fp[i]!=NULL) fflush(fp[i]);
+  }
+
+  strcpy(fname,ext);
+  fnjoint(filepath,filename,fname);
+
+  /* a temporal file is renamed, so that an interruption
+     never leaves a broken record */
+
+  sprintf(ftmp,"%s.tmp%d",fname,(int)getpid());
+
+  if ((fpr = fopen(ftmp,"w")) != NULL){
+
+    fprintf(fpr,"%d %d %d %016llx\n",nkpt,n,kdone,key);
+    for (i=0; i<nf; i++){
+      fprintf(fpr,"%ld\n",(fp[i]!=NULL ? ftell(fp[i]) : 0L));
+    }
+    fclose(fpr);
+
+    if (rename(ftmp,fname)!=0) remove(ftmp);
+  }
+}
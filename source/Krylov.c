@@ -7,6 +7,7 @@
   Log of Krylov.c
 
      10/June/2005  Released by T.Ozaki
+     18/Oct/2026   block-CSR cluster matrices and CholQR in Generate_pMatrix
 
 ***********************************************************************/
 
@@ -37,14 +38,37 @@
 #define _mm_storeu_pd _mm_store_pd
 #endif
 
+/* block-CSR copy of the Hamiltonian and overlap matrices of an embedded cluster */
+
+typedef struct {
+  int n;              /* dimension of the cluster */
+  int fan;            /* atoms 0..fan belong to the core region */
+  int nb;             /* number of non-zero blocks */
+  int ld;             /* leading dimension of tmpvec0, tmpvec1, and tmpvec2 */
+  int *bi,*bj;        /* atoms in the cluster for the row and column of a block */
+  int *Anum,*Bnum;    /* first row and column of a block (from 0) */
+  int *ian,*jan;      /* size of a block */
+  long int *off;      /* H[spin][off+m*jan+k] = Hks[spin][ih][kl][m][k] */
+  double *H[2];
+  double *S;          /* S[off+m*jan+k] = OLP0[ih][kl][m][k] */
+} Krylov_Cluster;
+
+static void Pack_Cluster_Matrix( int Mc_AN, int *MP, double *****Hks, double ****OLP0, int ld,
+                                 Krylov_Cluster *CM );
+static void Free_Cluster_Matrix( Krylov_Cluster *CM );
+static void Cluster_SpMM( Krylov_Cluster *CM, double *A, int emb, int ncol,
+                          double *X, int ldx, double *Y, int ldy );
+static int S_orthonormalize_CholQR( Krylov_Cluster *CM, int ncol, double *V, int ldv,
+                                    double *W, double *G );
+
 static void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks, double ****OLP0, double **invS,
                               double ***Krylov_U, double ***Krylov_U_OLP, double **inv_RS, int *MP,
                               int *Msize, int *Msize2, int *Msize3, int *Msize4, int Msize2_max, 
-                              double **tmpvec0, double **tmpvec1, double **tmpvec2 ); 
+                              double **tmpvec0, double **tmpvec1, double **tmpvec2, Krylov_Cluster *CM ); 
                               
 static void Generate_pMatrix2( int myid, int spin, int Mc_AN, double *****Hks, double ****OLP0, double ***Krylov_U, 
                                int *MP, int *Msize, int *Msize2, int *Msize3, 
-                               double **tmpvec1 );
+                               double **tmpvec1, Krylov_Cluster *CM );
 static void Krylov_IOLP( int Mc_AN, double ****OLP0, double ***Krylov_U_OLP, double **inv_RS, 
                          int *MP, int *Msize2, int *Msize4, int Msize2_max, 
                          double **tmpvec0, double **tmpvec1 );
@@ -54,7 +78,7 @@ static void S_orthonormalize_vec( int Mc_AN, int ct_on, double **vec,
 static void Embedding_Matrix(int spin, int Mc_AN, double *****Hks,
                              double ***Krylov_U, double ****EC_matrix, 
 			     int *MP, int *Msize, int *Msize2, int *Msize3, 
-                             double **tmpvec1);
+                             double **tmpvec1, Krylov_Cluster *CM);
 
 static void Inverse_S_by_Cholesky(int Mc_AN, double ****OLP0, double **invS, int *MP, int NUM, double *LoS);
 
@@ -154,6 +178,8 @@ double Krylov(char *mode,
     exit(1);
   }
 
+  if (Bench_flag) Bench_Record(Bench_Krylov,time0);
+
   return time0;
 }
 
@@ -769,9 +795,11 @@ static double Krylov_Col(char *mode,
 
   if (measure_time==1) dtime(&Stime2);
 
+  Atom_Schedule_Start(Sched_Krylov, Msize3, Msize2);
+
 #pragma omp parallel shared(EKC_invS_flag,List_YOUSO,Residues,EDM,CDM,HO_TC,LO_TC,ChemP,EVal,RMI1,S_G2M,EC_matrix,recalc_flag,recalc_EM,Krylov_U,SpinP_switch,EKC_core_size,EKC_core_size_max,rlmax_EC,rlmax_EC2,time11,time10,time9,time8,time7,time6,time5,time4,time3,time2,Hks,OLP0,EKC_Exact_invS_flag,SCF_iter,Msize4,Msize3,Msize2,Msize,Msize2_max,natn,FNAN,SNAN,Spe_Total_CNO,WhatSpecies,M2G,Matomnum,myid,time_per_atom,firsttime) 
   {
-    int OMPID,Nthrds,Nprocs;
+    int OMPID,Nprocs;
     int Mc_AN,Gc_AN,wan,spin;
     int ig,ian,ih,kl,jg,jan,Bnum,m,n,rl;
     int Anum,i,j,k,Gi,wanA,NUM,n2,csize,is,i2;
@@ -793,30 +821,36 @@ static double Krylov_Col(char *mode,
     double **tmpvec0;
     double **tmpvec1;
     double **tmpvec2;
+    Krylov_Cluster CM;
 
     /* get info. on OpenMP */ 
 
     OMPID = omp_get_thread_num();
-    Nthrds = omp_get_num_threads();
     Nprocs = omp_get_num_procs();
 
     /* allocation of arrays */
 
     MP = (int*)malloc(sizeof(int)*List_YOUSO[2]);
 
+    /* the vectors are stored contiguously with the leading dimension Msize2_max
+       so that they can be multiplied as a block by Cluster_SpMM and dgemm */
+
     tmpvec0 = (double**)malloc(sizeof(double*)*EKC_core_size_max);
-    for (i=0; i<EKC_core_size_max; i++){
-      tmpvec0[i] = (double*)malloc(sizeof(double)*Msize2_max);
+    tmpvec0[0] = (double*)malloc(sizeof(double)*EKC_core_size_max*Msize2_max);
+    for (i=1; i<EKC_core_size_max; i++){
+      tmpvec0[i] = tmpvec0[0] + i*Msize2_max;
     }
 
     tmpvec1 = (double**)malloc(sizeof(double*)*EKC_core_size_max);
-    for (i=0; i<EKC_core_size_max; i++){
-      tmpvec1[i] = (double*)malloc(sizeof(double)*Msize2_max);
+    tmpvec1[0] = (double*)malloc(sizeof(double)*EKC_core_size_max*Msize2_max);
+    for (i=1; i<EKC_core_size_max; i++){
+      tmpvec1[i] = tmpvec1[0] + i*Msize2_max;
     }
 
     tmpvec2 = (double**)malloc(sizeof(double*)*EKC_core_size_max);
-    for (i=0; i<EKC_core_size_max; i++){
-      tmpvec2[i] = (double*)malloc(sizeof(double)*Msize2_max);
+    tmpvec2[0] = (double*)malloc(sizeof(double)*EKC_core_size_max*Msize2_max);
+    for (i=1; i<EKC_core_size_max; i++){
+      tmpvec2[i] = tmpvec2[0] + i*Msize2_max;
     }
 
     if (firsttime && OMPID==0){
@@ -829,7 +863,7 @@ static double Krylov_Col(char *mode,
      main loop of calculation 
     ***********************************************/
 
-    for (Mc_AN=1+OMPID; Mc_AN<=Matomnum; Mc_AN+=Nthrds){
+    while ((Mc_AN=Atom_Schedule_Next(Sched_Krylov))!=0){
 
       dtime(&Stime_atom);
 
@@ -914,6 +948,12 @@ static double Krylov_Col(char *mode,
 	}
       }
 
+      /* pack the cluster matrices once for both spins */
+
+      if (recalc_EM==1 || SCF_iter==1 || recalc_flag==1){
+        Pack_Cluster_Matrix( Mc_AN, MP, Hks, OLP0, Msize2_max, &CM );
+      }
+
       for (spin=0; spin<=SpinP_switch; spin++){
 
 	/****************************************************
@@ -925,11 +965,11 @@ static double Krylov_Col(char *mode,
 	if (SCF_iter==1 && Msize3[Mc_AN]<Msize2[Mc_AN]){
 
 	  Generate_pMatrix( myid, spin, Mc_AN, Hks, OLP0, invS, Krylov_U, Krylov_U_OLP, inv_RS, MP, 
-                            Msize, Msize2, Msize3, Msize4, Msize2_max, tmpvec0, tmpvec1, tmpvec2 );
+                            Msize, Msize2, Msize3, Msize4, Msize2_max, tmpvec0, tmpvec1, tmpvec2, &CM );
 	}
 	else if (SCF_iter==1){
 
-	  Generate_pMatrix2( myid, spin, Mc_AN, Hks, OLP0, Krylov_U, MP, Msize, Msize2, Msize3, tmpvec1 );
+	  Generate_pMatrix2( myid, spin, Mc_AN, Hks, OLP0, Krylov_U, MP, Msize, Msize2, Msize3, tmpvec1, &CM );
 	}
 
 	if (measure_time==1 && OMPID==0){ 
@@ -941,7 +981,7 @@ static double Krylov_Col(char *mode,
 
 	if (recalc_EM==1 || SCF_iter==1 || recalc_flag==1){
 
-	  Embedding_Matrix( spin, Mc_AN, Hks, Krylov_U, EC_matrix, MP, Msize, Msize2, Msize3, tmpvec1);
+	  Embedding_Matrix( spin, Mc_AN, Hks, Krylov_U, EC_matrix, MP, Msize, Msize2, Msize3, tmpvec1, &CM);
 	}
 
 	if (measure_time==1 && OMPID==0){ 
@@ -1249,6 +1289,10 @@ static double Krylov_Col(char *mode,
                     freeing of arrays:
       ***********************************************/
 
+      if (recalc_EM==1 || SCF_iter==1 || recalc_flag==1){
+        Free_Cluster_Matrix( &CM );
+      }
+
       free(H_DC);
       free(ko);
       free(C);
@@ -1289,23 +1333,19 @@ static double Krylov_Col(char *mode,
 
     free(MP);
 
-    for (i=0; i<EKC_core_size_max; i++){
-      free(tmpvec0[i]);
-    }
+    free(tmpvec0[0]);
     free(tmpvec0);
 
-    for (i=0; i<EKC_core_size_max; i++){
-      free(tmpvec1[i]);
-    }
+    free(tmpvec1[0]);
     free(tmpvec1);
 
-    for (i=0; i<EKC_core_size_max; i++){
-      free(tmpvec2[i]);
-    }
+    free(tmpvec2[0]);
     free(tmpvec2);
 
   } /* #pragma omp parallel */
 
+  Atom_Schedule_End(Sched_Krylov, "Krylov");
+
   if (measure_time==1){ 
     dtime(&Etime2);
     time16 = Etime2 - Stime2;      
@@ -1735,7 +1775,7 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
                        double ****OLP0, double **invS,
                        double ***Krylov_U, double ***Krylov_U_OLP, double **inv_RS, int *MP, 
                        int *Msize, int *Msize2, int *Msize3, int *Msize4, int Msize2_max, 
-                       double **tmpvec0, double **tmpvec1, double **tmpvec2 ) 
+                       double **tmpvec0, double **tmpvec1, double **tmpvec2, Krylov_Cluster *CM ) 
 {
   int rl,rl0,rl1,ct_AN,fan,san,can,wan,ct_on,i,j;
   int n,Anum,Bnum,k,ian,ih,kl,jg,ig,jan,m,m1,n1;
@@ -1744,6 +1784,9 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
   int mm0,mm1,mm2,mm3,mm4,mm5,mm6,mm7;
 
   int KU_d1, KU_d2, csize; 
+  int ldu,M,N,K,lda,ldb,ldc;
+  double alpha,beta;
+  double *Tmat;
   __m128d mmSum00,mmSum01,mmSum10,mmSum11,mmSum20,mmSum21,mmSum30,mmSum31, mmTmp0, mmTmp1, mmTmp2, mmTmp3, mmTmp4, mmTmp5; 
 
   double mmArr[8];
@@ -1751,7 +1794,7 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
   double time6,time7,time8,time9,time10;
   double Stime1,Etime1;
   double sum0,sum1,sum2,sum3,sum4,sum5,sum6,sum7;
-  double sum,dum,tmp0,tmp1,tmp2,tmp3,rcutA,r0;
+  double sum,tmp0,tmp1,tmp2,tmp3,rcutA,r0;
   double **Utmp,**matRS0,**matRS1;
   double **tmpmat0;
   double *ko,*iko;
@@ -1781,15 +1824,23 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
     Utmp[i] = (double*)malloc(sizeof(double)*EKC_core_size[Mc_AN]);
   }
 
+  /* U0 is contiguous with the leading dimension ldu */
+
+  ldu = Msize2[Mc_AN] + 3;
+
   U0 = (double***)malloc(sizeof(double**)*rlmax_EC[Mc_AN]);
+  U0[0] = (double**)malloc(sizeof(double*)*rlmax_EC[Mc_AN]*EKC_core_size[Mc_AN]);
+  U0[0][0] = (double*)malloc(sizeof(double)*rlmax_EC[Mc_AN]*EKC_core_size[Mc_AN]*ldu);
   for (i=0; i<rlmax_EC[Mc_AN]; i++){
-    U0[i] = (double**)malloc(sizeof(double*)*EKC_core_size[Mc_AN]);
+    U0[i] = U0[0] + i*EKC_core_size[Mc_AN];
     for (j=0; j<EKC_core_size[Mc_AN]; j++){
-      U0[i][j] = (double*)malloc(sizeof(double)*(Msize2[Mc_AN]+3));
-      for (k=0; k<(Msize2[Mc_AN]+3); k++)  U0[i][j][k] = 0.0;
+      U0[i][j] = U0[0][0] + (i*EKC_core_size[Mc_AN]+j)*ldu;
+      for (k=0; k<ldu; k++)  U0[i][j][k] = 0.0;
     }
   }  
 
+  Tmat = (double*)malloc(sizeof(double)*rlmax_EC[Mc_AN]*EKC_core_size[Mc_AN]*EKC_core_size[Mc_AN]);
+
   tmpmat0 = (double**)malloc(sizeof(double*)*(EKC_core_size[Mc_AN]+4));
   for (i=0; i<(EKC_core_size[Mc_AN]+4); i++){
     tmpmat0[i] = (double*)malloc(sizeof(double)*(EKC_core_size[Mc_AN]+4));
@@ -1869,7 +1920,9 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
     }
   }
 
-  S_orthonormalize_vec( Mc_AN, ct_on, tmpvec0, tmpvec1, OLP0, tmpmat0, ko, iko, MP, Msize2 );
+  if (!S_orthonormalize_CholQR( CM, EKC_core_size[Mc_AN], tmpvec0[0], CM->ld, tmpvec1[0], Tmat )){
+    S_orthonormalize_vec( Mc_AN, ct_on, tmpvec0, tmpvec1, OLP0, tmpmat0, ko, iko, MP, Msize2 );
+  }
 
   for (n=0; n<EKC_core_size[Mc_AN]; n++){
     for (i=0; i<Msize2[Mc_AN]; i++){
@@ -1894,120 +1947,7 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
                             H * |Wn)
     *******************************************************/
 
-    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      for (i=0; i<Msize2[Mc_AN]; i++){
-	tmpvec1[n][i]  = 0.0;
-      }
-    }
-
-    for (i=0; i<=can; i++){
-
-      ig = natn[ct_AN][i];
-      ian = Spe_Total_CNO[WhatSpecies[ig]];
-      Anum = MP[i] - 1;
-      ih = S_G2M[ig];
-
-      for (j=0; j<=can; j++){
-
-	kl = RMI1[Mc_AN][i][j];
-	jg = natn[ct_AN][j];
-	jan = Spe_Total_CNO[WhatSpecies[jg]];
-        Bnum = MP[j] - 1;
-
-        if (0<=kl){
-
-#ifdef nosse
-
-      /* original version */
-	  	  
-      	  for (m=0; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += Hks[spin][ih][kl][m][k]*tmpvec0[n][Bnum+k];
-	      }
-
-              tmpvec1[n][Anum+m] += sum;
-	    }
-	  }
-	  
-#else
-      /* Loop Unrolling + SSE version */
-	  
-	  for (m=0; m<(ian-3); m+=4){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      mmSum00 = _mm_setzero_pd();
-	      mmSum01 = _mm_setzero_pd();
-	      mmSum10 = _mm_setzero_pd();
-	      mmSum11 = _mm_setzero_pd();
-	      mmSum20 = _mm_setzero_pd();
-	      mmSum21 = _mm_setzero_pd();
-	      mmSum30 = _mm_setzero_pd();
-	      mmSum31 = _mm_setzero_pd();
-
-	      for (k=0; k<(jan-3); k+=4){
-		mmTmp0 = _mm_loadu_pd(&tmpvec0[n][Bnum+k+0]);
-		mmTmp1 = _mm_loadu_pd(&tmpvec0[n][Bnum+k+2]);
-
-		mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+0][k+0]),mmTmp0));  
-		mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+0][k+2]),mmTmp1));  
-
-		mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+1][k+0]),mmTmp0));  
-		mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+1][k+2]),mmTmp1));  
-
-		mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+2][k+0]),mmTmp0));  
-		mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+2][k+2]),mmTmp1));  
-
-		mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+3][k+0]),mmTmp0));  
-		mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+3][k+2]),mmTmp1));  
-	      }
-
-	      mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	      mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	      mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	      mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	      _mm_storeu_pd(&mmArr[0], mmSum00);
-	      _mm_storeu_pd(&mmArr[2], mmSum10);
-	      _mm_storeu_pd(&mmArr[4], mmSum20);
-	      _mm_storeu_pd(&mmArr[6], mmSum30);
-
-	      sum0 = mmArr[0] + mmArr[1];
-	      sum1 = mmArr[2] + mmArr[3];
-	      sum2 = mmArr[4] + mmArr[5];
-	      sum3 = mmArr[6] + mmArr[7];
-
-	      for (; k<jan; k++){
-		sum0 += Hks[spin][ih][kl][m+0][k]*tmpvec0[n][Bnum+k];
-		sum1 += Hks[spin][ih][kl][m+1][k]*tmpvec0[n][Bnum+k];
-		sum2 += Hks[spin][ih][kl][m+2][k]*tmpvec0[n][Bnum+k];
-		sum3 += Hks[spin][ih][kl][m+3][k]*tmpvec0[n][Bnum+k];
-	      }
-
-              tmpvec1[n][Anum+m+0] += sum0;
-              tmpvec1[n][Anum+m+1] += sum1;
-              tmpvec1[n][Anum+m+2] += sum2;
-              tmpvec1[n][Anum+m+3] += sum3;
-	    }
-	  }
-
-	  for (; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += Hks[spin][ih][kl][m][k]*tmpvec0[n][Bnum+k];
-	      }
-
-              tmpvec1[n][Anum+m] += sum;
-	    }
-	  } 
-#endif	   
-	}
-      }
-    }
+    Cluster_SpMM( CM, CM->H[spin], 0, EKC_core_size[Mc_AN], tmpvec0[0], CM->ld, tmpvec1[0], CM->ld );
 
     if (measure_time==1){ 
       dtime(&Etime1);
@@ -2229,506 +2169,96 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
 
     /* |tmpvec2) = S * |tmpvec0) */
 
-    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      for (i=0; i<Msize2[Mc_AN]; i++){
-	tmpvec2[n][i] = 0.0;
-      }
+    Cluster_SpMM( CM, CM->S, 0, EKC_core_size[Mc_AN], tmpvec0[0], CM->ld, tmpvec2[0], CM->ld );
+
+    if (measure_time==1){ 
+      dtime(&Etime1);
+      time4 += Etime1 - Stime1;      
     }
 
-    for (i=0; i<=can; i++){
+    if (measure_time==1) dtime(&Stime1);
 
-      ig = natn[ct_AN][i];
-      ian = Spe_Total_CNO[WhatSpecies[ig]];
-      Anum = MP[i] - 1;
-      ih = S_G2M[ig];
+    /* (U_rl0|tmpvec2) for all rl0<=rl at once */
 
-      for (j=0; j<=can; j++){
+    M = (rl+1)*EKC_core_size[Mc_AN];
+    N = EKC_core_size[Mc_AN];
+    K = Msize2[Mc_AN];
+    alpha = 1.0; beta = 0.0;
+    lda = ldu; ldb = CM->ld; ldc = M;
 
-	kl = RMI1[Mc_AN][i][j];
-	jg = natn[ct_AN][j];
-	jan = Spe_Total_CNO[WhatSpecies[jg]];
-	Bnum = MP[j] - 1;
+    F77_NAME(dgemm,DGEMM)("T", "N", &M, &N, &K, &alpha, U0[0][0], &lda,
+                          tmpvec2[0], &ldb, &beta, Tmat, &ldc);
 
-	if (0<=kl){
+    /* |tmpvec0) - |U_rl0) * (U_rl0|tmpvec2) */
 
-#ifdef nosse
+    M = Msize2[Mc_AN];
+    N = EKC_core_size[Mc_AN];
+    K = (rl+1)*EKC_core_size[Mc_AN];
+    alpha = -1.0; beta = 1.0;
+    lda = ldu; ldb = K; ldc = CM->ld;
 
-	  /* Original version */
-	  	    
-	  for (m=0; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
+    F77_NAME(dgemm,DGEMM)("N", "N", &M, &N, &K, &alpha, U0[0][0], &lda,
+                          Tmat, &ldb, &beta, tmpvec0[0], &ldc);
 
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += OLP0[ih][kl][m][k]*tmpvec0[n][Bnum+k];
-	      }
+    if (measure_time==1){ 
+      dtime(&Etime1);
+      time5 += Etime1 - Stime1;      
+    }
 
-	      tmpvec2[n][Anum+m] += sum;
-	    }
-	  }
-	  
-#else
+    /*************************************************************
+                   S-orthonormalization of tmpvec0
+    *************************************************************/
 
-	  /* Unrolling + SSE version */
-	  
-	  for (m=0; m<(ian-3); m+=4){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
+    if (measure_time==1) dtime(&Stime1);
 
-	      mmSum00 = _mm_setzero_pd();
-	      mmSum01 = _mm_setzero_pd();
-	      mmSum10 = _mm_setzero_pd();
-	      mmSum11 = _mm_setzero_pd();
-	      mmSum20 = _mm_setzero_pd();
-	      mmSum21 = _mm_setzero_pd();
-	      mmSum30 = _mm_setzero_pd();
-	      mmSum31 = _mm_setzero_pd();
+    /* Cholesky QR, and the eigenvalue-based one if the block is nearly rank deficient */
 
-	      for (k=0; k<(jan-3); k+=4){
-		mmTmp0 = _mm_loadu_pd(&tmpvec0[n][Bnum+k+0]);
-		mmTmp1 = _mm_loadu_pd(&tmpvec0[n][Bnum+k+2]);
+    if (!S_orthonormalize_CholQR( CM, EKC_core_size[Mc_AN], tmpvec0[0], CM->ld, tmpvec1[0], Tmat )){
+      S_orthonormalize_vec( Mc_AN, ct_on, tmpvec0, tmpvec1, OLP0, tmpmat0, ko, iko, MP, Msize2 );
+    }
 
-		mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+0][k+0]),mmTmp0));  
-		mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+0][k+2]),mmTmp1));  
+    for (n=0; n<EKC_core_size[Mc_AN]; n++){
+      for (i=0; i<Msize2[Mc_AN]; i++){
+        U0[rl+1][n][i] = tmpvec0[n][i];
+      }
+    }
 
-		mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+1][k+0]),mmTmp0));  
-		mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+1][k+2]),mmTmp1));  
+    if (measure_time==1){ 
+      dtime(&Etime1);
+      time6 += Etime1 - Stime1;      
+    }
 
-		mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+2][k+0]),mmTmp0));  
-		mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+2][k+2]),mmTmp1));  
+  } /* rl */
 
-		mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+3][k+0]),mmTmp0));  
-		mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+3][k+2]),mmTmp1));  
-	      }
+  /************************************************************
+              orthogonalization by diagonalization
+  ************************************************************/
 
-	      mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	      mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	      mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	      mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	      _mm_storeu_pd(&mmArr[0], mmSum00);
-	      _mm_storeu_pd(&mmArr[2], mmSum10);
-	      _mm_storeu_pd(&mmArr[4], mmSum20);
-	      _mm_storeu_pd(&mmArr[6], mmSum30);
+  if (measure_time==1) dtime(&Stime1);
 
-	      sum0 = mmArr[0] + mmArr[1];
-	      sum1 = mmArr[2] + mmArr[3];
-	      sum2 = mmArr[4] + mmArr[5];
-	      sum3 = mmArr[6] + mmArr[7];
+  for (rl=0; rl<rlmax_EC[Mc_AN]; rl++){
 
-	      for (; k<jan; k++){
-		sum0 += OLP0[ih][kl][m+0][k]*tmpvec0[n][Bnum+k];
-		sum1 += OLP0[ih][kl][m+1][k]*tmpvec0[n][Bnum+k];
-		sum2 += OLP0[ih][kl][m+2][k]*tmpvec0[n][Bnum+k];
-		sum3 += OLP0[ih][kl][m+3][k]*tmpvec0[n][Bnum+k];
-	      }
-
-	      tmpvec2[n][Anum+m+0] += sum0;
-	      tmpvec2[n][Anum+m+1] += sum1;
-	      tmpvec2[n][Anum+m+2] += sum2;
-	      tmpvec2[n][Anum+m+3] += sum3;
-	    }
-	  }
-
-	  for (; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += OLP0[ih][kl][m][k]*tmpvec0[n][Bnum+k];
-	      }
-
-	      tmpvec2[n][Anum+m] += sum;
-	    }
-	  } 
-	  
-#endif
-
-	}
-      }
-    }
-
-    if (measure_time==1){ 
-      dtime(&Etime1);
-      time4 += Etime1 - Stime1;      
-    }
-
-    if (measure_time==1) dtime(&Stime1);
-
-#ifdef nosse
-
-    /* Original version */
-        
-    for (rl0=0; rl0<=rl; rl0++){
-
-      /* (U_rl0|tmpvec2) */
-        
-      for (m=0; m<EKC_core_size[Mc_AN]; m++){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-          sum = 0.0;
-  	  for (i=0; i<Msize2[Mc_AN]; i++){
-            sum += U0[rl0][m][i]*tmpvec2[n][i];
-	  }
-          tmpmat0[m][n] = sum;
-	}
-      }
-    
-      /* |tmpvec0) - |U_rl0) * (U_rl0|tmpvec2) */
-        
-      for (n=0; n<EKC_core_size[Mc_AN]; n++){
-	for (k=0; k<EKC_core_size[Mc_AN]; k++){
-	  dum = tmpmat0[k][n];
-	  for (i=0; i<Msize2[Mc_AN]; i++)  tmpvec0[n][i] -= U0[rl0][k][i]*dum;
-        }
-      }
-
-    }
-    
-#else
-
-    /* Unrolling + SSE version */
-    
-    for (rl0=0; rl0<=rl; rl0++){
-
-      /* (U_rl0|tmpvec2) */
-    
-      for (m=0; m<(EKC_core_size[Mc_AN]-3); m+=4){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	  mmSum00 = _mm_setzero_pd();
-	  mmSum01 = _mm_setzero_pd();
-	  mmSum10 = _mm_setzero_pd();
-	  mmSum11 = _mm_setzero_pd();
-	  mmSum20 = _mm_setzero_pd();
-	  mmSum21 = _mm_setzero_pd();
-	  mmSum30 = _mm_setzero_pd();
-	  mmSum31 = _mm_setzero_pd();
-
-  	  for (i=0; i<(Msize2[Mc_AN]-3); i+=4){
-	    mmTmp0 = _mm_loadu_pd(&tmpvec2[n][i+0]);
-	    mmTmp1 = _mm_loadu_pd(&tmpvec2[n][i+2]);
-
-	    mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+0][i+0]),mmTmp0));  
-	    mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+0][i+2]),mmTmp1));  
-
-	    mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+1][i+0]),mmTmp0));  
-	    mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+1][i+2]),mmTmp1));  
-
-	    mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+2][i+0]),mmTmp0));  
-	    mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+2][i+2]),mmTmp1));  
-
-	    mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+3][i+0]),mmTmp0));  
-	    mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+3][i+2]),mmTmp1));  
-	  }
-
-	  mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	  mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	  mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	  mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	  _mm_storeu_pd(&mmArr[0], mmSum00);
-	  _mm_storeu_pd(&mmArr[2], mmSum10);
-	  _mm_storeu_pd(&mmArr[4], mmSum20);
-	  _mm_storeu_pd(&mmArr[6], mmSum30);
-
-	  sum0 = mmArr[0] + mmArr[1];
-	  sum1 = mmArr[2] + mmArr[3];
-	  sum2 = mmArr[4] + mmArr[5];
-	  sum3 = mmArr[6] + mmArr[7];
-
-  	  for (; i<Msize2[Mc_AN]; i++){
-            sum0 += U0[rl0][m+0][i]*tmpvec2[n][i];
-            sum1 += U0[rl0][m+1][i]*tmpvec2[n][i];
-            sum2 += U0[rl0][m+2][i]*tmpvec2[n][i];
-            sum3 += U0[rl0][m+3][i]*tmpvec2[n][i];
-	  }
-
-          tmpmat0[m+0][n] = sum0;
-          tmpmat0[m+1][n] = sum1;
-          tmpmat0[m+2][n] = sum2;
-          tmpmat0[m+3][n] = sum3;
-	}
-      }
-
-      for (; m<EKC_core_size[Mc_AN]; m++){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-          sum = 0.0;
-  	  for (i=0; i<Msize2[Mc_AN]; i++){
-            sum += U0[rl0][m][i]*tmpvec2[n][i];
-	  }
-          tmpmat0[m][n] = sum;
-	}
-      }
-
-      /* |tmpvec0) - |U_rl0) * (U_rl0|tmpvec2) */
-    
-      for (n=0; n<EKC_core_size[Mc_AN]; n++){
-	for (k=0; k<EKC_core_size[Mc_AN]; k++){
-	  dum = tmpmat0[k][n];
-	  for (i=0; i<Msize2[Mc_AN]; i++)  tmpvec0[n][i] -= U0[rl0][k][i]*dum;
-        }
-      }
-
-    }
-    
-#endif
-
-    if (measure_time==1){ 
-      dtime(&Etime1);
-      time5 += Etime1 - Stime1;      
-    }
-
-    /*************************************************************
-                   S-orthonormalization of tmpvec0
-    *************************************************************/
-
-    if (measure_time==1) dtime(&Stime1);
-
-    S_orthonormalize_vec( Mc_AN, ct_on, tmpvec0, tmpvec1, OLP0, tmpmat0, ko, iko, MP, Msize2 );
-
-    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      for (i=0; i<Msize2[Mc_AN]; i++){
-        U0[rl+1][n][i] = tmpvec0[n][i];
-      }
-    }
-
-    if (measure_time==1){ 
-      dtime(&Etime1);
-      time6 += Etime1 - Stime1;      
-    }
-
-  } /* rl */
-
-  /************************************************************
-              orthogonalization by diagonalization
-  ************************************************************/
-
-  if (measure_time==1) dtime(&Stime1);
-
-  for (rl=0; rl<rlmax_EC[Mc_AN]; rl++){
-
-    /*  S * |Vn) */
-
-    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      for (i=0; i<Msize2[Mc_AN]; i++){
-	tmpvec1[n][i]  = 0.0;
-      }
-    }
-
-    for (i=0; i<=can; i++){
-
-      ig = natn[ct_AN][i];
-      ian = Spe_Total_CNO[WhatSpecies[ig]];
-      Anum = MP[i] - 1;
-      ih = S_G2M[ig];
-
-      for (j=0; j<=can; j++){
-
-	kl = RMI1[Mc_AN][i][j];
-	jg = natn[ct_AN][j];
-	jan = Spe_Total_CNO[WhatSpecies[jg]];
-	Bnum = MP[j] - 1;
-
-	if (0<=kl){
-
-#ifdef nosse
-
-	  /* Original version */
-	  /**/	  
-	  for (m=0; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += OLP0[ih][kl][m][k]*U0[rl][n][Bnum+k];
-	      }
-	      tmpvec1[n][Anum+m] += sum;
-	    }
-	  } 
-	  /**/
-
-#else
-
-	  /* Unrolling + SSE version */
-	  /**/
-	  for (m=0; m<(ian-3); m+=4){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      mmSum00 = _mm_setzero_pd();
-	      mmSum01 = _mm_setzero_pd();
-	      mmSum10 = _mm_setzero_pd();
-	      mmSum11 = _mm_setzero_pd();
-	      mmSum20 = _mm_setzero_pd();
-	      mmSum21 = _mm_setzero_pd();
-	      mmSum30 = _mm_setzero_pd();
-	      mmSum31 = _mm_setzero_pd();
-
-	      for (k=0; k<(jan-3); k+=4){
-		mmTmp0 = _mm_loadu_pd(&U0[rl][n][Bnum+k+0]);
-		mmTmp1 = _mm_loadu_pd(&U0[rl][n][Bnum+k+2]);
-
-		mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+0][k+0]),mmTmp0));  
-		mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+0][k+2]),mmTmp1));  
-
-		mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+1][k+0]),mmTmp0));  
-		mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+1][k+2]),mmTmp1));  
-
-		mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+2][k+0]),mmTmp0));  
-		mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+2][k+2]),mmTmp1));  
-
-		mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+3][k+0]),mmTmp0));  
-		mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+3][k+2]),mmTmp1));  
-	      }
-
-	      mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	      mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	      mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	      mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	      _mm_storeu_pd(&mmArr[0], mmSum00);
-	      _mm_storeu_pd(&mmArr[2], mmSum10);
-	      _mm_storeu_pd(&mmArr[4], mmSum20);
-	      _mm_storeu_pd(&mmArr[6], mmSum30);
-
-	      sum0 = mmArr[0] + mmArr[1];
-	      sum1 = mmArr[2] + mmArr[3];
-	      sum2 = mmArr[4] + mmArr[5];
-	      sum3 = mmArr[6] + mmArr[7];
-
-	      for (; k<jan; k++){
-		sum0 += OLP0[ih][kl][m+0][k]*U0[rl][n][Bnum+k];
-		sum1 += OLP0[ih][kl][m+1][k]*U0[rl][n][Bnum+k];
-		sum2 += OLP0[ih][kl][m+2][k]*U0[rl][n][Bnum+k];
-		sum3 += OLP0[ih][kl][m+3][k]*U0[rl][n][Bnum+k];
-	      }
-
-	      tmpvec1[n][Anum+m+0] += sum0;
-	      tmpvec1[n][Anum+m+1] += sum1;
-	      tmpvec1[n][Anum+m+2] += sum2;
-	      tmpvec1[n][Anum+m+3] += sum3;
-	    }
-	  } 
-
-	  for (; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += OLP0[ih][kl][m][k]*U0[rl][n][Bnum+k];
-	      }
-	      tmpvec1[n][Anum+m] += sum;
-	    }
-	  } 
-	  /**/
-#endif
-
-	}
-      }
-    }
-
-#ifdef nosse
-
-    /* Original version */
-    /**/    
-    for (rl0=rl; rl0<rlmax_EC[Mc_AN]; rl0++){
-      for (m=0; m<EKC_core_size[Mc_AN]; m++){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-  	  sum = 0.0;
-	  for (i=0; i<Msize2[Mc_AN]; i++){
-            sum += U0[rl0][m][i]*tmpvec1[n][i]; 
-	  }
-          FS[rl0*EKC_core_size[Mc_AN]+m+1][rl*EKC_core_size[Mc_AN]+n+1] = sum;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+1] = sum;
-	}
-      }
-    }
-    /**/
-
-#else
-
-    /* Unrolling + SSE version */
-    /**/
-    for (rl0=rl; rl0<rlmax_EC[Mc_AN]; rl0++){
-      for (m=0; m<(EKC_core_size[Mc_AN]-3); m+=4){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	  mmSum00 = _mm_setzero_pd();
-	  mmSum01 = _mm_setzero_pd();
-	  mmSum10 = _mm_setzero_pd();
-	  mmSum11 = _mm_setzero_pd();
-	  mmSum20 = _mm_setzero_pd();
-	  mmSum21 = _mm_setzero_pd();
-	  mmSum30 = _mm_setzero_pd();
-	  mmSum31 = _mm_setzero_pd();
-
-	  for (i=0; i<(Msize2[Mc_AN]-3); i+=4){
-	    mmTmp0 = _mm_loadu_pd(&tmpvec1[n][i+0]);
-	    mmTmp1 = _mm_loadu_pd(&tmpvec1[n][i+2]);
-
-	    mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+0][i+0]),mmTmp0));  
-	    mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+0][i+2]),mmTmp1));  
-
-	    mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+1][i+0]),mmTmp0));  
-	    mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+1][i+2]),mmTmp1));  
-
-	    mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+2][i+0]),mmTmp0));  
-	    mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+2][i+2]),mmTmp1));  
-
-	    mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+3][i+0]),mmTmp0));  
-	    mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+3][i+2]),mmTmp1));  
-	  }
-
-	  mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	  mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	  mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	  mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	  _mm_storeu_pd(&mmArr[0], mmSum00);
-	  _mm_storeu_pd(&mmArr[2], mmSum10);
-	  _mm_storeu_pd(&mmArr[4], mmSum20);
-	  _mm_storeu_pd(&mmArr[6], mmSum30);
-
-	  sum0 = mmArr[0] + mmArr[1];
-	  sum1 = mmArr[2] + mmArr[3];
-	  sum2 = mmArr[4] + mmArr[5];
-	  sum3 = mmArr[6] + mmArr[7];
-
-	  for (; i<Msize2[Mc_AN]; i++){
-            sum0 += U0[rl0][m+0][i]*tmpvec1[n][i]; 
-            sum1 += U0[rl0][m+1][i]*tmpvec1[n][i]; 
-            sum2 += U0[rl0][m+2][i]*tmpvec1[n][i]; 
-            sum3 += U0[rl0][m+3][i]*tmpvec1[n][i]; 
-	  }
+    /*  S * |Vn) */
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+1][rl*EKC_core_size[Mc_AN]+n+1] = sum0;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+1] = sum0;
+    Cluster_SpMM( CM, CM->S, 0, EKC_core_size[Mc_AN], U0[rl][0], ldu, tmpvec1[0], CM->ld );
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+2][rl*EKC_core_size[Mc_AN]+n+1] = sum1;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+2] = sum1;
+    /*  (Vm|S|Vn) for rl<=rl0 by dgemm */
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+3][rl*EKC_core_size[Mc_AN]+n+1] = sum2;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+3] = sum2;
+    M = (rlmax_EC[Mc_AN]-rl)*EKC_core_size[Mc_AN];
+    N = EKC_core_size[Mc_AN];
+    K = Msize2[Mc_AN];
+    alpha = 1.0; beta = 0.0;
+    lda = ldu; ldb = CM->ld; ldc = M;
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+4][rl*EKC_core_size[Mc_AN]+n+1] = sum3;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+4] = sum3;
-	}
-      }
+    F77_NAME(dgemm,DGEMM)("T", "N", &M, &N, &K, &alpha, U0[rl][0], &lda,
+                          tmpvec1[0], &ldb, &beta, Tmat, &ldc);
 
-      for (; m<EKC_core_size[Mc_AN]; m++){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-  	  sum = 0.0;
-	  for (i=0; i<Msize2[Mc_AN]; i++){
-            sum += U0[rl0][m][i]*tmpvec1[n][i]; 
-	  }
-          FS[rl0*EKC_core_size[Mc_AN]+m+1][rl*EKC_core_size[Mc_AN]+n+1] = sum;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+1] = sum;
-	}
+    for (n=0; n<N; n++){
+      for (m=0; m<M; m++){
+        FS[rl*N+m+1][rl*N+n+1] = Tmat[n*M+m];
+        FS[rl*N+n+1][rl*N+m+1] = Tmat[n*M+m];
       }
-
     }
-    /**/
-
-#endif
-
   }
 
   if (measure_time==1){ 
@@ -3108,14 +2638,12 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
   }
   free(Utmp);
 
-  for (i=0; i<rlmax_EC[Mc_AN]; i++){
-    for (j=0; j<EKC_core_size[Mc_AN]; j++){
-      free(U0[i][j]);
-    }
-    free(U0[i]);
-  }  
+  free(U0[0][0]);
+  free(U0[0]);
   free(U0);
 
+  free(Tmat);
+
   for (i=0; i<(EKC_core_size[Mc_AN]+4); i++){
     free(tmpmat0[i]);
   }
@@ -3149,12 +2677,15 @@ void Generate_pMatrix( int myid, int spin, int Mc_AN, double *****Hks,
 
 void Generate_pMatrix2( int myid, int spin, int Mc_AN, double *****Hks, double ****OLP0, 
                         double ***Krylov_U, int *MP, int *Msize, int *Msize2, int *Msize3, 
-                        double **tmpvec1)
+                        double **tmpvec1, Krylov_Cluster *CM)
 {
   int rl,rl0,rl1,ct_AN,fan,san,can,wan,ct_on,i,j;
   int n,Anum,Bnum,k,ian,ih,kl,jg,ig,jan,m,m1,n1;
   int ZeroNum,rl_half;
   int KU_d1,KU_d2,csize;
+  int ldu,M,N,K,lda,ldb,ldc;
+  double alpha,beta;
+  double *Tmat;
   double sum,dum,tmp0,tmp1,tmp2,tmp3;
   double **Utmp;
   double *ko,*iko;
@@ -3190,15 +2721,23 @@ void Generate_pMatrix2( int myid, int spin, int Mc_AN, double *****Hks, double *
     Utmp[i] = (double*)malloc(sizeof(double)*EKC_core_size[Mc_AN]);
   }
 
+  /* U0 is contiguous with the leading dimension ldu */
+
+  ldu = Msize2[Mc_AN] + 3;
+
   U0 = (double***)malloc(sizeof(double**)*rlmax_EC[Mc_AN]);
+  U0[0] = (double**)malloc(sizeof(double*)*rlmax_EC[Mc_AN]*EKC_core_size[Mc_AN]);
+  U0[0][0] = (double*)malloc(sizeof(double)*rlmax_EC[Mc_AN]*EKC_core_size[Mc_AN]*ldu);
   for (i=0; i<rlmax_EC[Mc_AN]; i++){
-    U0[i] = (double**)malloc(sizeof(double*)*EKC_core_size[Mc_AN]);
+    U0[i] = U0[0] + i*EKC_core_size[Mc_AN];
     for (j=0; j<EKC_core_size[Mc_AN]; j++){
-      U0[i][j] = (double*)malloc(sizeof(double)*(Msize2[Mc_AN]+3));
-      for (k=0; k<(Msize2[Mc_AN]+3); k++)  U0[i][j][k] = 0.0;
+      U0[i][j] = U0[0][0] + (i*EKC_core_size[Mc_AN]+j)*ldu;
+      for (k=0; k<ldu; k++)  U0[i][j][k] = 0.0;
     }
   }  
 
+  Tmat = (double*)malloc(sizeof(double)*rlmax_EC[Mc_AN]*EKC_core_size[Mc_AN]*EKC_core_size[Mc_AN]);
+
   FS = (double**)malloc(sizeof(double*)*(rlmax_EC[Mc_AN]+2)*EKC_core_size[Mc_AN]);
   for (i=0; i<(rlmax_EC[Mc_AN]+2)*EKC_core_size[Mc_AN]; i++){
     FS[i] = (double*)malloc(sizeof(double)*(rlmax_EC[Mc_AN]+2)*EKC_core_size[Mc_AN]);
@@ -3222,238 +2761,38 @@ void Generate_pMatrix2( int myid, int spin, int Mc_AN, double *****Hks, double *
   i = 0;
   for (rl=0; rl<rlmax_EC[Mc_AN]; rl++){
     for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      if (i<Msize2[Mc_AN]) U0[rl][n][i] = 1.0;
-      i++;
-    }
-  }
-
-  /************************************************************
-              orthogonalization by diagonalization
-  ************************************************************/
-
-  for (rl=0; rl<rlmax_EC[Mc_AN]; rl++){
-
-    /*  S * |Vn) */
-
-    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      for (i=0; i<Msize2[Mc_AN]; i++){
-	tmpvec1[n][i]  = 0.0;
-      }
-    }
-
-    for (i=0; i<=can; i++){
-
-      ig = natn[ct_AN][i];
-      ian = Spe_Total_CNO[WhatSpecies[ig]];
-      Anum = MP[i] - 1;
-      ih = S_G2M[ig];
-
-      for (j=0; j<=can; j++){
-
-	kl = RMI1[Mc_AN][i][j];
-	jg = natn[ct_AN][j];
-	jan = Spe_Total_CNO[WhatSpecies[jg]];
-	Bnum = MP[j] - 1;
-
-	if (0<=kl){
-
-#ifdef nosse
-
-	  /* Original version */
-	  /**/
-	  for (m=0; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += OLP0[ih][kl][m][k]*U0[rl][n][Bnum+k];
-	      }
-	      tmpvec1[n][Anum+m] += sum;
-	    }
-	  }
-	  /**/
-
-#else
-
-	  /* Unrolling + SSE version */
-
-	  for (m=0; m<(ian-3); m+=4){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      mmSum00 = _mm_setzero_pd();
-	      mmSum01 = _mm_setzero_pd();
-	      mmSum10 = _mm_setzero_pd();
-	      mmSum11 = _mm_setzero_pd();
-	      mmSum20 = _mm_setzero_pd();
-	      mmSum21 = _mm_setzero_pd();
-	      mmSum30 = _mm_setzero_pd();
-	      mmSum31 = _mm_setzero_pd();
-
-	      for (k=0; k<(jan-3); k+=4){
-		mmTmp0 = _mm_loadu_pd(&U0[rl][n][Bnum+k+0]);
-		mmTmp1 = _mm_loadu_pd(&U0[rl][n][Bnum+k+2]);
-
-		mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+0][k+0]),mmTmp0));  
-		mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+0][k+2]),mmTmp1));  
-
-		mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+1][k+0]),mmTmp0));  
-		mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+1][k+2]),mmTmp1));  
-
-		mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+2][k+0]),mmTmp0));  
-		mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+2][k+2]),mmTmp1));  
-
-		mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+3][k+0]),mmTmp0));  
-		mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&OLP0[ih][kl][m+3][k+2]),mmTmp1));  
-	      }
-
-	      mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	      mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	      mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	      mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	      _mm_storeu_pd(&mmArr[0], mmSum00);
-	      _mm_storeu_pd(&mmArr[2], mmSum10);
-	      _mm_storeu_pd(&mmArr[4], mmSum20);
-	      _mm_storeu_pd(&mmArr[6], mmSum30);
-
-	      sum0 = mmArr[0] + mmArr[1];
-	      sum1 = mmArr[2] + mmArr[3];
-	      sum2 = mmArr[4] + mmArr[5];
-	      sum3 = mmArr[6] + mmArr[7];
-
-	      for (; k<jan; k++){
-		sum0 += OLP0[ih][kl][m+0][k]*U0[rl][n][Bnum+k];
-		sum1 += OLP0[ih][kl][m+1][k]*U0[rl][n][Bnum+k];
-		sum2 += OLP0[ih][kl][m+2][k]*U0[rl][n][Bnum+k];
-		sum3 += OLP0[ih][kl][m+3][k]*U0[rl][n][Bnum+k];
-	      }
-
-	      tmpvec1[n][Anum+m+0] += sum0;
-	      tmpvec1[n][Anum+m+1] += sum1;
-	      tmpvec1[n][Anum+m+2] += sum2;
-	      tmpvec1[n][Anum+m+3] += sum3;
-	    }
-	  } 
-
-	  for (; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += OLP0[ih][kl][m][k]*U0[rl][n][Bnum+k];
-	      }
-	      tmpvec1[n][Anum+m] += sum;
-	    }
-	  } 
-
-#endif
-
-	}
-      }
-    }
-
-#ifdef nosse
-
-    /* Original version */
-    /**/
-    for (rl0=rl; rl0<rlmax_EC[Mc_AN]; rl0++){
-      for (m=0; m<EKC_core_size[Mc_AN]; m++){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-  	  sum = 0.0;
-	  for (i=0; i<Msize2[Mc_AN]; i++){
-            sum += U0[rl0][m][i]*tmpvec1[n][i]; 
-	  }
-          FS[rl0*EKC_core_size[Mc_AN]+m+1][rl*EKC_core_size[Mc_AN]+n+1] = sum;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+1] = sum;
-	}
-      }
-    }
-    /**/
-
-#else
-
-    /* Unrolling + SSE version */
-
-    for (rl0=rl; rl0<rlmax_EC[Mc_AN]; rl0++){
-      for (m=0; m<(EKC_core_size[Mc_AN]-3); m+=4){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	  mmSum00 = _mm_setzero_pd();
-	  mmSum01 = _mm_setzero_pd();
-	  mmSum10 = _mm_setzero_pd();
-	  mmSum11 = _mm_setzero_pd();
-	  mmSum20 = _mm_setzero_pd();
-	  mmSum21 = _mm_setzero_pd();
-	  mmSum30 = _mm_setzero_pd();
-	  mmSum31 = _mm_setzero_pd();
-
-	  for (i=0; i<(Msize2[Mc_AN]-3); i+=4){
-	    mmTmp0 = _mm_loadu_pd(&tmpvec1[n][i+0]);
-	    mmTmp1 = _mm_loadu_pd(&tmpvec1[n][i+2]);
-
-	    mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+0][i+0]),mmTmp0));  
-	    mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+0][i+2]),mmTmp1));  
-
-	    mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+1][i+0]),mmTmp0));  
-	    mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+1][i+2]),mmTmp1));  
-
-	    mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+2][i+0]),mmTmp0));  
-	    mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+2][i+2]),mmTmp1));  
-
-	    mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+3][i+0]),mmTmp0));  
-	    mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&U0[rl0][m+3][i+2]),mmTmp1));  
-	  }
-
-	  mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	  mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	  mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	  mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	  _mm_storeu_pd(&mmArr[0], mmSum00);
-	  _mm_storeu_pd(&mmArr[2], mmSum10);
-	  _mm_storeu_pd(&mmArr[4], mmSum20);
-	  _mm_storeu_pd(&mmArr[6], mmSum30);
+      if (i<Msize2[Mc_AN]) U0[rl][n][i] = 1.0;
+      i++;
+    }
+  }
 
-	  sum0 = mmArr[0] + mmArr[1];
-	  sum1 = mmArr[2] + mmArr[3];
-	  sum2 = mmArr[4] + mmArr[5];
-	  sum3 = mmArr[6] + mmArr[7];
+  /************************************************************
+              orthogonalization by diagonalization
+  ************************************************************/
 
-	  for (; i<Msize2[Mc_AN]; i++){
-            sum0 += U0[rl0][m+0][i]*tmpvec1[n][i]; 
-            sum1 += U0[rl0][m+1][i]*tmpvec1[n][i]; 
-            sum2 += U0[rl0][m+2][i]*tmpvec1[n][i]; 
-            sum3 += U0[rl0][m+3][i]*tmpvec1[n][i]; 
-	  }
+  for (rl=0; rl<rlmax_EC[Mc_AN]; rl++){
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+1][rl*EKC_core_size[Mc_AN]+n+1] = sum0;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+1] = sum0;
+    /*  S * |Vn) */
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+2][rl*EKC_core_size[Mc_AN]+n+1] = sum1;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+2] = sum1;
+    Cluster_SpMM( CM, CM->S, 0, EKC_core_size[Mc_AN], U0[rl][0], ldu, tmpvec1[0], CM->ld );
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+3][rl*EKC_core_size[Mc_AN]+n+1] = sum2;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+3] = sum2;
+    /*  (Vm|S|Vn) for rl<=rl0 by dgemm */
 
-          FS[rl0*EKC_core_size[Mc_AN]+m+4][rl*EKC_core_size[Mc_AN]+n+1] = sum3;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+4] = sum3;
-	}
-      }
+    M = (rlmax_EC[Mc_AN]-rl)*EKC_core_size[Mc_AN];
+    N = EKC_core_size[Mc_AN];
+    K = Msize2[Mc_AN];
+    alpha = 1.0; beta = 0.0;
+    lda = ldu; ldb = CM->ld; ldc = M;
 
-      for (; m<EKC_core_size[Mc_AN]; m++){
-        for (n=0; n<EKC_core_size[Mc_AN]; n++){
-  	  sum = 0.0;
-	  for (i=0; i<Msize2[Mc_AN]; i++){
-            sum += U0[rl0][m][i]*tmpvec1[n][i]; 
-	  }
-          FS[rl0*EKC_core_size[Mc_AN]+m+1][rl*EKC_core_size[Mc_AN]+n+1] = sum;
-          FS[rl*EKC_core_size[Mc_AN]+n+1][rl0*EKC_core_size[Mc_AN]+m+1] = sum;
-	}
+    F77_NAME(dgemm,DGEMM)("T", "N", &M, &N, &K, &alpha, U0[rl][0], &lda,
+                          tmpvec1[0], &ldb, &beta, Tmat, &ldc);
+
+    for (n=0; n<N; n++){
+      for (m=0; m<M; m++){
+        FS[rl*N+m+1][rl*N+n+1] = Tmat[n*M+m];
+        FS[rl*N+n+1][rl*N+m+1] = Tmat[n*M+m];
       }
     }
-
-#endif
-
   }
 
   Eigen_lapack(FS,ko,Msize3[Mc_AN],Msize3[Mc_AN]);
@@ -3736,14 +3075,12 @@ void Generate_pMatrix2( int myid, int spin, int Mc_AN, double *****Hks, double *
   }
   free(Utmp);
 
-  for (i=0; i<rlmax_EC[Mc_AN]; i++){
-    for (j=0; j<EKC_core_size[Mc_AN]; j++){
-      free(U0[i][j]);
-    }
-    free(U0[i]);
-  }  
+  free(U0[0][0]);
+  free(U0[0]);
   free(U0);
 
+  free(Tmat);
+
   for (i=0; i<(rlmax_EC[Mc_AN]+2)*EKC_core_size[Mc_AN]; i++){
     free(FS[i]);
   }
@@ -3762,7 +3099,7 @@ void Generate_pMatrix2( int myid, int spin, int Mc_AN, double *****Hks, double *
 void Embedding_Matrix(int spin, int Mc_AN, double *****Hks,
                       double ***Krylov_U, double ****EC_matrix, 
                       int *MP, int *Msize, int *Msize2, int *Msize3, 
-                      double **tmpvec1 )
+                      double **tmpvec1, Krylov_Cluster *CM )
 {
   int ct_AN,fan,san,can,wan,ct_on;
   int rl,rl0,m,n,i,j,k,kl,jg,jan,ih,ian;
@@ -3810,135 +3147,14 @@ void Embedding_Matrix(int spin, int Mc_AN, double *****Hks,
 
     /* C^+ u2 */
 
-    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-      for (i=0; i<Msize2[Mc_AN]; i++){
-	tmpvec1[n][i]  = 0.0;
-      }
-    }
-
-    for (i=0; i<=fan; i++){
-
-      ig = natn[ct_AN][i];
-      ian = Spe_Total_CNO[WhatSpecies[ig]];
-      Anum = MP[i] - 1;
-      ih = S_G2M[ig];
-
-      for (j=fan+1; j<=can; j++){
-
-	kl = RMI1[Mc_AN][i][j];
-	jg = natn[ct_AN][j];
-	jan = Spe_Total_CNO[WhatSpecies[jg]];
-	Bnum = MP[j];
-
-	if (0<=kl){
-
-#ifdef nosse
-
-          if (measure_time==1) dtime(&stime);
-
-	  /* Original version */
-	  /**/	  
-	  for (m=0; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += Hks[spin][ih][kl][m][k]*Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k];
-	      }
-
-	      tmpvec1[n][Anum+m] += sum;
-	    }
-	  }
-	  /**/
-
-          if (measure_time==1){ 
-            dtime(&etime);
-            time1 += etime - stime;
-	  }
-
-#else
-          if (measure_time==1) dtime(&stime);
-
-	  /* Unrolling + SSE version */
-	  /**/
-	  for (m=0; m<(ian-3); m+=4){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      mmSum00 = _mm_setzero_pd();
-	      mmSum01 = _mm_setzero_pd();
-	      mmSum10 = _mm_setzero_pd();
-	      mmSum11 = _mm_setzero_pd();
-	      mmSum20 = _mm_setzero_pd();
-	      mmSum21 = _mm_setzero_pd();
-	      mmSum30 = _mm_setzero_pd();
-	      mmSum31 = _mm_setzero_pd();
-
-	      for (k=0; k<(jan-3); k+=4){
-		mmTmp0 = _mm_loadu_pd(&Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k+0]);
-		mmTmp1 = _mm_loadu_pd(&Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k+2]);
-
-		mmSum00 = _mm_add_pd(mmSum00, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+0][k+0]),mmTmp0));  
-		mmSum01 = _mm_add_pd(mmSum01, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+0][k+2]),mmTmp1));  
-
-		mmSum10 = _mm_add_pd(mmSum10, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+1][k+0]),mmTmp0));  
-		mmSum11 = _mm_add_pd(mmSum11, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+1][k+2]),mmTmp1));  
-
-		mmSum20 = _mm_add_pd(mmSum20, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+2][k+0]),mmTmp0));  
-		mmSum21 = _mm_add_pd(mmSum21, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+2][k+2]),mmTmp1));  
-
-		mmSum30 = _mm_add_pd(mmSum30, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+3][k+0]),mmTmp0));  
-		mmSum31 = _mm_add_pd(mmSum31, _mm_mul_pd(_mm_loadu_pd(&Hks[spin][ih][kl][m+3][k+2]),mmTmp1));  
-	      }
-
-	      mmSum00 = _mm_add_pd(mmSum00, mmSum01);  
-	      mmSum10 = _mm_add_pd(mmSum10, mmSum11);  
-	      mmSum20 = _mm_add_pd(mmSum20, mmSum21);  
-	      mmSum30 = _mm_add_pd(mmSum30, mmSum31);  
-	  
-	      _mm_storeu_pd(&mmArr[0], mmSum00);
-	      _mm_storeu_pd(&mmArr[2], mmSum10);
-	      _mm_storeu_pd(&mmArr[4], mmSum20);
-	      _mm_storeu_pd(&mmArr[6], mmSum30);
-
-	      sum0 = mmArr[0] + mmArr[1];
-	      sum1 = mmArr[2] + mmArr[3];
-	      sum2 = mmArr[4] + mmArr[5];
-	      sum3 = mmArr[6] + mmArr[7];
-
-	      for (; k<jan; k++){
-		sum0 += Hks[spin][ih][kl][m+0][k]*Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k];
-		sum1 += Hks[spin][ih][kl][m+1][k]*Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k];
-		sum2 += Hks[spin][ih][kl][m+2][k]*Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k];
-		sum3 += Hks[spin][ih][kl][m+3][k]*Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k];
-	      }
-
-	      tmpvec1[n][Anum+m+0] += sum0;
-	      tmpvec1[n][Anum+m+1] += sum1;
-	      tmpvec1[n][Anum+m+2] += sum2;
-	      tmpvec1[n][Anum+m+3] += sum3;
-	    }
-	  } 
-
-	  for (; m<ian; m++){
-	    for (n=0; n<EKC_core_size[Mc_AN]; n++){
-
-	      sum = 0.0;
-	      for (k=0; k<jan; k++){
-		sum += Hks[spin][ih][kl][m][k]*Krylov_U[spin][Mc_AN][rl*KU_d1+n*KU_d2+Bnum+k];
-	      }
-
-	      tmpvec1[n][Anum+m] += sum;
-	    }
-	  } 
+    if (measure_time==1) dtime(&stime);
 
-          if (measure_time==1){ 
-            dtime(&etime);
-            time1 += etime - stime;
-	  }
-#endif
+    Cluster_SpMM( CM, CM->H[spin], 1, EKC_core_size[Mc_AN], &Krylov_U[spin][Mc_AN][rl*KU_d1+1], KU_d2,
+                  tmpvec1[0], CM->ld );
 
-	}
-      }
+    if (measure_time==1){ 
+      dtime(&etime);
+      time1 += etime - stime;
     }
 
     /* u1^+ C^+ u2 */
@@ -5089,6 +4305,189 @@ void S_orthonormalize_vec( int Mc_AN, int ct_on, double **vec,
 }
 
 
+void Pack_Cluster_Matrix( int Mc_AN, int *MP, double *****Hks, double ****OLP0, int ld,
+                          Krylov_Cluster *CM )
+{
+  /* copy the non-zero blocks of H and S of the cluster into contiguous 
+     row-major arrays so that the matrices are traversed once per atom 
+     for both spins, Generate_pMatrix, and Embedding_Matrix */
+
+  int i,j,m,k,b,ig,jg,ih,kl,ian,jan,can,ct_AN,spin;
+  long int size,p;
+
+  ct_AN = M2G[Mc_AN];
+  can = FNAN[ct_AN] + SNAN[ct_AN];
+
+  CM->fan = FNAN[ct_AN];
+  CM->ld = ld;
+  CM->n = MP[can] - 1 + Spe_Total_CNO[WhatSpecies[natn[ct_AN][can]]];
+
+  CM->nb = 0;
+  for (i=0; i<=can; i++){
+    for (j=0; j<=can; j++){
+      if (0<=RMI1[Mc_AN][i][j]) CM->nb++;
+    }
+  }
+
+  CM->bi = (int*)malloc(sizeof(int)*6*(CM->nb+1));
+  CM->bj   = CM->bi + 1*(CM->nb+1);
+  CM->Anum = CM->bi + 2*(CM->nb+1);
+  CM->Bnum = CM->bi + 3*(CM->nb+1);
+  CM->ian  = CM->bi + 4*(CM->nb+1);
+  CM->jan  = CM->bi + 5*(CM->nb+1);
+  CM->off = (long int*)malloc(sizeof(long int)*(CM->nb+1));
+
+  b = 0;
+  size = 0;
+
+  for (i=0; i<=can; i++){
+
+    ig = natn[ct_AN][i];
+    ian = Spe_Total_CNO[WhatSpecies[ig]];
+
+    for (j=0; j<=can; j++){
+
+      kl = RMI1[Mc_AN][i][j];
+      jg = natn[ct_AN][j];
+      jan = Spe_Total_CNO[WhatSpecies[jg]];
+
+      if (0<=kl){
+        CM->bi[b] = i;
+        CM->bj[b] = j;
+        CM->Anum[b] = MP[i] - 1;
+        CM->Bnum[b] = MP[j] - 1;
+        CM->ian[b] = ian;
+        CM->jan[b] = jan;
+        CM->off[b] = size;
+        size += ian*jan;
+        b++;
+      }
+    }
+  }
+  CM->off[b] = size;
+
+  CM->H[0] = NULL;
+  CM->H[1] = NULL;
+  for (spin=0; spin<=SpinP_switch; spin++){
+    CM->H[spin] = (double*)malloc(sizeof(double)*(size+1));
+  }
+  CM->S = (double*)malloc(sizeof(double)*(size+1));
+
+  for (b=0; b<CM->nb; b++){
+
+    ih = S_G2M[natn[ct_AN][CM->bi[b]]];
+    kl = RMI1[Mc_AN][CM->bi[b]][CM->bj[b]];
+    p = CM->off[b];
+
+    for (m=0; m<CM->ian[b]; m++){
+      for (k=0; k<CM->jan[b]; k++){
+        for (spin=0; spin<=SpinP_switch; spin++){
+          CM->H[spin][p] = Hks[spin][ih][kl][m][k];
+        }
+        CM->S[p] = OLP0[ih][kl][m][k];
+        p++;
+      }
+    }
+  }
+}
+
+
+void Free_Cluster_Matrix( Krylov_Cluster *CM )
+{
+  int spin;
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    free(CM->H[spin]);
+  }
+  free(CM->S);
+  free(CM->off);
+  free(CM->bi);
+}
+
+
+void Cluster_SpMM( Krylov_Cluster *CM, double *A, int emb, int ncol,
+                   double *X, int ldx, double *Y, int ldy )
+{
+  /* Y = A * X for ncol vectors stored column by column, where A is 
+     CM->H[spin] or CM->S. If emb==1, only the coupling between the core 
+     region (rows) and the outside of it (columns) is multiplied. */
+
+  int b,i,n;
+  INTEGER M,N,K,lda,ldb,ldc;
+  double alpha,beta;
+
+  for (n=0; n<ncol; n++){
+    for (i=0; i<CM->n; i++){
+      Y[n*ldy+i] = 0.0;
+    }
+  }
+
+  alpha = 1.0; beta = 1.0;
+  N = ncol; ldb = ldx; ldc = ldy;
+
+  for (b=0; b<CM->nb; b++){
+
+    if (emb==1 && (CM->fan<CM->bi[b] || CM->bj[b]<=CM->fan)) continue;
+
+    /* the row-major block is the transpose of a column-major one */
+
+    M = CM->ian[b];
+    K = CM->jan[b];
+    lda = K;
+
+    F77_NAME(dgemm,DGEMM)("T", "N", &M, &N, &K, &alpha, &A[CM->off[b]], &lda,
+                          &X[CM->Bnum[b]], &ldb, &beta, &Y[CM->Anum[b]], &ldc);
+  }
+}
+
+
+int S_orthonormalize_CholQR( Krylov_Cluster *CM, int ncol, double *V, int ldv,
+                             double *W, double *G )
+{
+  /* S-orthonormalization of V by the Cholesky QR method:
+     G = V^T S V = R^T R, and V <- V R^{-1}. 
+     0 is returned without changing V if G is numerically singular, 
+     and the caller should use S_orthonormalize_vec instead. */
+
+  char *UPLO="U";
+  INTEGER M,N,K,lda,ldb,ldc,info;
+  int i;
+  double alpha,beta;
+
+  /* W = S V and G = V^T W */
+
+  Cluster_SpMM( CM, CM->S, 0, ncol, V, ldv, W, CM->ld );
+
+  M = ncol; N = ncol; K = CM->n;
+  alpha = 1.0; beta = 0.0;
+  lda = ldv; ldb = CM->ld; ldc = ncol;
+
+  F77_NAME(dgemm,DGEMM)("T", "N", &M, &N, &K, &alpha, V, &lda, W, &ldb, &beta, G, &ldc);
+
+  /* G = R^T R */
+
+  N = ncol; lda = ncol;
+  F77_NAME(dpotrf,DPOTRF)(UPLO, &N, G, &lda, &info);
+
+  if (info!=0) return 0;
+
+  for (i=0; i<ncol; i++){
+    if (G[i*ncol+i]*G[i*ncol+i]<cutoff_value) return 0;
+  }
+
+  /* V = V R^{-1} */
+
+  M = CM->n; N = ncol;
+  alpha = 1.0;
+  lda = ncol; ldb = ldv;
+
+  F77_NAME(dtrsm,DTRSM)("R", UPLO, "N", "N", &M, &N, &alpha, G, &lda, V, &ldb);
+
+  return 1;
+}
+
+
+
 
 void Inverse_S_by_Cholesky(int Mc_AN, double ****OLP0, double **invS, int *MP, int NUM, double *LoS)
 {
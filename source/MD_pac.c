@@ -13,6 +13,7 @@
      14/Jul/2007  RF added by H.M. Weng
      08/Jan/2010  NVT_VS2 added by T. Ohwaki 
      23/Dec/2012  RestartFiles4GeoOpt added by T. Ozaki
+     18/Oct/2026  Gxyz shared by Atom_Allgather_Double
 
 ***********************************************************************/
 
@@ -243,9 +244,9 @@ void NoMD(int iter)
 
 void Correct_Position_In_First_Cell()
 {
-  int i,Mc_AN,Gc_AN,ct_AN,k;
+  int i,Mc_AN,Gc_AN,k;
   int itmp,My_Correct_Position_flag;
-  int numprocs,myid,ID,tag=999;
+  int numprocs,myid,tag=999;
   double Cxyz[4],Frac[4];
 
   MPI_Status stat;
@@ -441,19 +442,14 @@ void Correct_Position_In_First_Cell()
     MPI:  Gxyz
   *****************/
 
-  for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
-    ID = G2ID[ct_AN];
+  Atom_Allgather_Double(Gxyz, 0, 4);
 
-    MPI_Bcast(&Gxyz[ct_AN][0], 4, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    for (k=0; k<Extrapolated_Charge_History; k++){
-      MPI_Bcast(&His_Gxyz[k][(ct_AN-1)*3], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-    }
-
-    for (k=0; k<(M_GDIIS_HISTORY+1); k++){
-      MPI_Bcast(&GxyzHistoryIn[k][ct_AN][0], 4, MPI_DOUBLE, ID, mpi_comm_level1);
-    }
+  for (k=0; k<Extrapolated_Charge_History; k++){
+    Atom_Allgather_Vector(His_Gxyz[k], 3);
+  }
 
+  for (k=0; k<(M_GDIIS_HISTORY+1); k++){
+    Atom_Allgather_Double(GxyzHistoryIn[k], 0, 4);
   }
 
   /*
@@ -519,7 +515,7 @@ void VerletXYZ(int iter)
   double dt,dt2,back,sum,My_Ukc;
   double Wscale,scaled_force;
   int Mc_AN,Gc_AN,j,k,l;
-  int numprocs,myid,ID;
+  int numprocs,myid;
 
   /* MPI */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -677,11 +673,8 @@ void VerletXYZ(int iter)
     }
   }
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17],13, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 13);
 }
 
 
@@ -696,7 +689,7 @@ void Steepest_Descent(int iter, int SD_scaling_flag)
   char fileCoord[YOUSO10];
   char fileSD[YOUSO10];
   FILE *fp_crd,*fp_SD;
-  int numprocs,myid,ID;
+  int numprocs,myid;
   double tmp1,MaxStep;
   char buf[fp_bsize];          /* setvbuf */
   char fileE[YOUSO10];
@@ -838,11 +831,8 @@ void Steepest_Descent(int iter, int SD_scaling_flag)
    MPI, Gxyz
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   if (myid==Host_ID){ 
 
@@ -970,7 +960,7 @@ void Cell_Opt_SD(int iter, int SD_scaling_flag)
   char fileCoord[YOUSO10];
   char fileSD[YOUSO10];
   FILE *fp_crd,*fp_SD;
-  int numprocs,myid,ID;
+  int numprocs,myid;
   double tmp1,MaxStep;
   char buf[fp_bsize];          /* setvbuf */
   char fileE[YOUSO10];
@@ -2569,8 +2559,7 @@ void GDIIS(int iter, int iter0)
   char fileE[YOUSO10];
 
   /* variables for MPI */
-  int Gc_AN;
-  int numprocs,myid,ID;  
+  int numprocs,myid;  
 
   /* MPI myid */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -2578,11 +2567,8 @@ void GDIIS(int iter, int iter0)
   MPI_Barrier(mpi_comm_level1);
 
   /* share Gxyz */
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   if (iter<M_GDIIS_HISTORY)
     diis_iter = iter;
@@ -2883,11 +2869,7 @@ void GDIIS(int iter, int iter0)
 
   MPI_Bcast(&MD_Opt_OK,1,MPI_INT, Host_ID, mpi_comm_level1);
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    /* ID = G2ID[Gc_AN]; */
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, Host_ID, mpi_comm_level1);
-    /*    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, Host_ID, mpi_comm_level1); */
-  }
+  Atom_Bcast_Double(Gxyz, 1, 3, Host_ID);
 
 
   if (myid==Host_ID){ 
@@ -3005,8 +2987,7 @@ void RF(int iter, int iter0)
   char fileE[YOUSO10];
 
   /* variables for MPI */
-  int Gc_AN;
-  int numprocs,myid,ID;  
+  int numprocs,myid;  
 
   /* MPI myid */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -3014,11 +2995,8 @@ void RF(int iter, int iter0)
   MPI_Barrier(mpi_comm_level1);
 
   /* share Gxyz */
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   /* set diis_iter */
 
@@ -3474,11 +3452,7 @@ void RF(int iter, int iter0)
 
   MPI_Bcast(&MD_Opt_OK,1,MPI_INT, Host_ID, mpi_comm_level1);
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    /* ID = G2ID[Gc_AN]; */
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, Host_ID, mpi_comm_level1);
-    /*    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, Host_ID, mpi_comm_level1); */
-  }
+  Atom_Bcast_Double(Gxyz, 1, 3, Host_ID);
 
   if (myid==Host_ID){ 
 
@@ -3593,7 +3567,7 @@ void RFC5(int iter, int iter0, double dE_da[4][4], double itv[4][4])
 
   /* variables for MPI */
   int Gc_AN;
-  int numprocs,myid,ID;  
+  int numprocs,myid;  
 
   /* MPI myid */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -3601,11 +3575,8 @@ void RFC5(int iter, int iter0, double dE_da[4][4], double itv[4][4])
   MPI_Barrier(mpi_comm_level1);
 
   /* share Gxyz */
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   /* set diis_iter */
 
@@ -4351,8 +4322,7 @@ void GDIIS_BFGS(int iter, int iter0)
   char fileE[YOUSO10];
 
   /* variables for MPI */
-  int Gc_AN;
-  int numprocs,myid,ID;  
+  int numprocs,myid;  
 
   /* MPI myid */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -4360,11 +4330,8 @@ void GDIIS_BFGS(int iter, int iter0)
   MPI_Barrier(mpi_comm_level1);
 
   /* share Gxyz */
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   if (iter<M_GDIIS_HISTORY)
     diis_iter = iter;
@@ -4778,11 +4745,7 @@ void GDIIS_BFGS(int iter, int iter0)
 
   MPI_Bcast(&MD_Opt_OK,1,MPI_INT, Host_ID, mpi_comm_level1);
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    /* ID = G2ID[Gc_AN]; */
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, Host_ID, mpi_comm_level1);
-    /*    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, Host_ID, mpi_comm_level1); */
-  }
+  Atom_Bcast_Double(Gxyz, 1, 3, Host_ID);
 
   if (myid==Host_ID){ 
 
@@ -4909,8 +4872,7 @@ void GDIIS_EF(int iter, int iter0)
   FILE *fp;
 
   /* variables for MPI */
-  int Gc_AN;
-  int numprocs,myid,ID;  
+  int numprocs,myid;  
 
   /* MPI myid */
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -4940,11 +4902,8 @@ void GDIIS_EF(int iter, int iter0)
   }
 
   /* share Gxyz */
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   /* set diis_iter */
 
@@ -5450,11 +5409,7 @@ void GDIIS_EF(int iter, int iter0)
 
   MPI_Bcast(&MD_Opt_OK,1,MPI_INT, Host_ID, mpi_comm_level1);
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    /* ID = G2ID[Gc_AN]; */
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, Host_ID, mpi_comm_level1);
-    /*    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, Host_ID, mpi_comm_level1); */
-  }
+  Atom_Bcast_Double(Gxyz, 1, 3, Host_ID);
 
 
   if (myid==Host_ID){ 
@@ -5630,7 +5585,7 @@ void NVT_VS(int iter)
   double dt,dt2,sum,My_Ukc,x,t,xyz0[4],xyz0_l[4];
   double Wscale;
   int Mc_AN,Gc_AN,i,j,k,l;
-  int numprocs,myid,ID;
+  int numprocs,myid;
   char fileE[YOUSO10];
 
   /* MPI */
@@ -5779,12 +5734,9 @@ void NVT_VS(int iter)
    MPI: Gxyz
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][14], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][24], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 14, 3);
+  Atom_Allgather_Double(Gxyz, 24, 3);
 
 }
 
@@ -5843,7 +5795,7 @@ void NVT_Langevin(int iter)
   double vtt,ft_mdt,ftt,ft,vtt_pdt;
   double tmp1,tmp2,tmp3,tmp4,tmp5,tmp6;
   int Mc_AN,Gc_AN,i,j,k,l;
-  int numprocs,myid,ID;
+  int numprocs,myid;
   char fileE[YOUSO10];
 
   /* MPI */
@@ -6102,10 +6054,7 @@ void NVT_Langevin(int iter)
    MPI: Gxyz
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][0], 40, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 0, 40);
 
   /****************************************************
                        Kinetic Energy 
@@ -6190,7 +6139,7 @@ void NVT_VS2(int iter)
   double *Atomic_Temp,*Atomic_Ukc,*Atomic_Scale;
 
   int Mc_AN,Gc_AN,i,j,k,l;
-  int numprocs,myid,ID;
+  int numprocs,myid;
 
   char fileE[YOUSO10];
 
@@ -6360,12 +6309,9 @@ void NVT_VS2(int iter)
    MPI: Gxyz
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][14], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][24], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 14, 3);
+  Atom_Allgather_Double(Gxyz, 24, 3);
 
   free(Atomic_Temp);
   free(Atomic_Ukc);
@@ -6418,7 +6364,7 @@ void NVT_VS4(int iter)
   double *Atomic_Temp,*Atomic_Ukc,*Atomic_Scale;
 
   int Mc_AN,Gc_AN,i,j,k,l;
-  int numprocs,myid,ID;
+  int numprocs,myid;
 
   char fileE[YOUSO10];
 
@@ -6601,12 +6547,9 @@ void NVT_VS4(int iter)
    MPI: Gxyz
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][14], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][24], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 14, 3);
+  Atom_Allgather_Double(Gxyz, 24, 3);
 
 }
 
@@ -6656,7 +6599,7 @@ void NVT_NH(int iter)
   ****************************************************/
 
   int Mc_AN,Gc_AN,i,j,k,l,po,num,NH_switch;
-  int numprocs,myid,ID;
+  int numprocs,myid;
 
   double dt,dt2,sum,My_sum,My_Ukc,x,t,xyz0[4],xyz0_l[4];
   double scaled_force,Wscale,back;
@@ -7067,11 +7010,8 @@ void NVT_NH(int iter)
    MPI: Gxyz
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][1],   3, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Gxyz[Gc_AN][14], 19, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 1, 3);
+  Atom_Allgather_Double(Gxyz, 14, 19);
 }
 
 
@@ -0,0 +1,275 @@
+/**********************************************************************
+  NUMA_Policy.c:
+
+     NUMA_Policy.c is a set of subroutines to control the placement of
+     OpenMP threads and of large arrays on NUMA nodes.
+
+     NUMA_Policy_Init:  binds the OpenMP threads to cores if requested,
+                        and reports the topology and the placement
+     NUMA_First_Touch:  zeroes an array by the threads with the same
+                        partition as the OpenMP loops using it, so that
+                        the pages are placed on the NUMA node of the
+                        thread working on them
+
+     The policy is given by the keywords NUMA.Bind (None, Compact or
+     Spread) and NUMA.FirstTouch (on or off) in the input file, and
+     can be overwritten by the options -bind and -firsttouch of the
+     command line.
+
+  Log of NUMA_Policy.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* defined by math.h with _GNU_SOURCE, but a variable in openmx_common.h */
+#undef SNAN
+
+#include "openmx_common.h"
+#include "mpi.h"
+#include <omp.h>
+
+#define NUMA_MaxNodes   256
+#define NUMA_LineLength 256
+
+static int NUMA_Num_Nodes();
+static int NUMA_Node_of_CPU(int cpu);
+
+
+
+void NUMA_Policy_Init()
+{
+  int numprocs,myid,ID,Nthrds0,po;
+  int num_cpus,num_nodes;
+  char *line,*all_lines;
+  char hostname[64];
+  char *bind_name[3] = {"none","compact","spread"};
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* the command line takes precedence over the input file */
+
+  if (0<=NUMA_Bind_cmd)       NUMA_Bind = NUMA_Bind_cmd;
+  if (0<=NUMA_FirstTouch_cmd) NUMA_FirstTouch = NUMA_FirstTouch_cmd;
+
+  Nthrds0 = omp_get_max_threads();
+  line = (char*)malloc(sizeof(char)*NUMA_LineLength*(Nthrds0+1));
+  line[0] = '\0';
+
+  strcpy(hostname,"unknown");
+
+#ifdef __linux__
+
+  {
+    cpu_set_t mask;
+    int *cpus,i,n;
+
+    gethostname(hostname,63);
+    hostname[63] = '\0';
+
+    CPU_ZERO(&mask);
+    sched_getaffinity(0, sizeof(cpu_set_t), &mask);
+
+    /* CPUs given to the process, e.g., by mpirun */
+
+    num_cpus = CPU_COUNT(&mask);
+    cpus = (int*)malloc(sizeof(int)*(num_cpus+1));
+    n = 0;
+    for (i=0; i<CPU_SETSIZE && n<num_cpus; i++){
+      if (CPU_ISSET(i,&mask)){ cpus[n] = i; n++; }
+    }
+    num_cpus = n;
+    num_nodes = NUMA_Num_Nodes();
+
+    /* binding of the threads to the CPUs of the process.
+       compact: the thread t uses the t-th CPU,
+       spread:  the threads are distributed evenly over the CPUs. */
+
+    po = 0;
+
+    if (NUMA_Bind!=0 && 0<num_cpus){
+
+#pragma omp parallel shared(cpus,num_cpus,NUMA_Bind) private(i) reduction(+:po)
+      {
+        int OMPID,Nthrds;
+        cpu_set_t tmask;
+
+        OMPID = omp_get_thread_num();
+        Nthrds = omp_get_num_threads();
+
+        if (NUMA_Bind==1) i = OMPID % num_cpus;
+        else              i = ((long int)OMPID*num_cpus/Nthrds) % num_cpus;
+
+        CPU_ZERO(&tmask);
+        CPU_SET(cpus[i],&tmask);
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &tmask)!=0) po++;
+      }
+    }
+
+    /* placement of the threads */
+
+    sprintf(line,"  process %4d on %s: %d CPUs, %d NUMA nodes%s\n",
+            myid,hostname,num_cpus,num_nodes,(po!=0 ? ", binding failed" : ""));
+
+#pragma omp parallel shared(line,Nthrds0)
+    {
+      int OMPID,cpu;
+
+      OMPID = omp_get_thread_num();
+      cpu = sched_getcpu();
+
+      if (OMPID<Nthrds0){
+        sprintf(&line[NUMA_LineLength*(OMPID+1)],"    thread %3d: CPU %4d, NUMA node %3d\n",
+                OMPID,cpu,NUMA_Node_of_CPU(cpu));
+      }
+    }
+
+    free(cpus);
+  }
+
+#else
+
+  num_cpus = 0;
+  num_nodes = 0;
+
+  if (NUMA_Bind!=0 && myid==Host_ID){
+    printf("NUMA.Bind is not supported on this system, and is ignored.\n");
+  }
+  NUMA_Bind = 0;
+
+  sprintf(line,"  process %4d: no information on the topology\n",myid);
+  for (ID=0; ID<Nthrds0; ID++) line[NUMA_LineLength*(ID+1)] = '\0';
+
+#endif
+
+  /* report by Host_ID */
+
+  if (myid==Host_ID){
+    all_lines = (char*)malloc(sizeof(char)*NUMA_LineLength*(Nthrds0+1)*numprocs);
+  }
+  else{
+    all_lines = NULL;
+  }
+
+  MPI_Gather(line, NUMA_LineLength*(Nthrds0+1), MPI_CHAR,
+             all_lines, NUMA_LineLength*(Nthrds0+1), MPI_CHAR, Host_ID, mpi_comm_level1);
+
+  if (myid==Host_ID && 0<level_stdout){
+
+    printf("\n*******************************************************\n");
+    printf("             NUMA policy and thread placement             \n");
+    printf("*******************************************************\n\n");
+    printf("  NUMA.Bind       = %s\n",bind_name[NUMA_Bind]);
+    printf("  NUMA.FirstTouch = %s\n\n",(NUMA_FirstTouch==1 ? "on" : "off"));
+
+    for (ID=0; ID<numprocs; ID++){
+      printf("%s",&all_lines[NUMA_LineLength*(Nthrds0+1)*ID]);
+      if (1<level_stdout){
+        for (po=0; po<Nthrds0; po++){
+          printf("%s",&all_lines[NUMA_LineLength*((Nthrds0+1)*ID+po+1)]);
+        }
+      }
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  if (myid==Host_ID) free(all_lines);
+  free(line);
+}
+
+
+void NUMA_First_Touch(void *p, long int n, size_t size)
+{
+  /* The n elements of size bytes are zeroed by the threads in the
+     contiguous partition OMPID*n/Nthrds to (OMPID+1)*n/Nthrds,
+     which is the partition used by the OpenMP loops on the grids. */
+
+  if (p==NULL || n<=0) return;
+
+  if (NUMA_FirstTouch==0){
+    memset(p, 0, size*n);
+    return;
+  }
+
+#pragma omp parallel shared(p,n,size)
+  {
+    int OMPID,Nthrds;
+    long int s,e;
+
+    OMPID = omp_get_thread_num();
+    Nthrds = omp_get_num_threads();
+
+    s = (long int)OMPID*n/Nthrds;
+    e = (long int)(OMPID+1)*n/Nthrds;
+
+    if (s<e) memset((char*)p+size*s, 0, size*(e-s));
+  }
+}
+
+
+static int NUMA_Num_Nodes()
+{
+  int n;
+  char fname[NUMA_LineLength];
+  FILE *fp;
+
+  n = 0;
+  do {
+    sprintf(fname,"/sys/devices/system/node/node%d/cpulist",n);
+    fp = fopen(fname,"r");
+    if (fp!=NULL){ fclose(fp); n++; }
+  } while (fp!=NULL && n<NUMA_MaxNodes);
+
+  if (n==0) n = 1;
+  return n;
+}
+
+
+static int NUMA_Node_of_CPU(int cpu)
+{
+  int node,i0,i1,po,c;
+  char fname[NUMA_LineLength];
+  FILE *fp;
+
+  if (cpu<0) return -1;
+
+  /* the cpulist of the nodes, e.g., 0-3,8-11 */
+
+  for (node=0; node<NUMA_MaxNodes; node++){
+
+    sprintf(fname,"/sys/devices/system/node/node%d/cpulist",node);
+    if ((fp = fopen(fname,"r"))==NULL) break;
+
+    po = 0;
+    while (po==0 && fscanf(fp,"%d",&i0)==1){
+      i1 = i0;
+      c = fgetc(fp);
+      if (c=='-'){
+        if (fscanf(fp,"%d",&i1)!=1) break;
+        c = fgetc(fp);
+      }
+      if (i0<=cpu && cpu<=i1) po = 1;
+      if (c!=',') break;
+    }
+
+    fclose(fp);
+    if (po==1) return node;
+  }
+
+  return 0;
+}
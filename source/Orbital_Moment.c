@@ -7,6 +7,7 @@
   Log of Occupation_Number_LDA_U.c:
 
      20/Nov./2006    -- Released by T.Ozaki
+     18/Oct/2026  orbital moments shared by Atom_Exchange.c
 ***********************************************************************/
 
 #include <stdio.h>
@@ -61,7 +62,6 @@ void OM_dual( char *mode )
   double S_coordinate[3];
   double ***DecMulP_LA;
   double ***DecMulP_LB;
-  double *tmp_array0;
   double *tmp_array;
   double *tmp_array2;
   double *sum_l,*sum_mul;
@@ -100,7 +100,6 @@ void OM_dual( char *mode )
     }
   }
 
-  tmp_array0 = (double*)malloc(sizeof(double)*(List_YOUSO[7]*(SpinP_switch+1)));
   sum_l   = (double*)malloc(sizeof(double)*(SpinP_switch+1));
   sum_mul = (double*)malloc(sizeof(double)*(SpinP_switch+1));
 
@@ -444,62 +443,16 @@ void OM_dual( char *mode )
   Total_OrbitalMomentAngle0 = S_coordinate[1];
   Total_OrbitalMomentAngle1 = S_coordinate[2];
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-
-    ID = G2ID[Gc_AN];
-
-    MPI_Bcast(&Angle0_Orbital[Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Angle1_Orbital[Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&OrbitalMoment[Gc_AN],  1, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Orbital_Moment_XYZ[Gc_AN][0],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    /* DecMulP_LA */
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	tmp_array0[num] = DecMulP_LA[spin][Gc_AN][i];
-	num++;
-      }
-    }
-
-    MPI_Bcast(&tmp_array0[0], num, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	DecMulP_LA[spin][Gc_AN][i] = tmp_array0[num];
-	num++;
-      }
-    }
-
-    /* DecMulP_LB */
+  Atom_Allgather_Vector(&Angle0_Orbital[1], 1);
+  Atom_Allgather_Vector(&Angle1_Orbital[1], 1);
+  Atom_Allgather_Vector(&OrbitalMoment[1], 1);
+  Atom_Allgather_Double(Orbital_Moment_XYZ, 0, 3);
 
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	tmp_array0[num] = DecMulP_LB[spin][Gc_AN][i];
-	num++;
-      }
-    }
+  /* DecMulP_LA and DecMulP_LB, whose rows have List_YOUSO[7] elements */
 
-    MPI_Bcast(&tmp_array0[0], num, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	DecMulP_LB[spin][Gc_AN][i] = tmp_array0[num];
-	num++;
-      }
-    }
+  for (spin=0; spin<3; spin++){
+    Atom_Allgather_Double(DecMulP_LA[spin], 0, List_YOUSO[7]);
+    Atom_Allgather_Double(DecMulP_LB[spin], 0, List_YOUSO[7]);
   }
 
   /*
@@ -715,7 +668,6 @@ void OM_dual( char *mode )
   }
   free(DecMulP_LB);
 
-  free(tmp_array0);
   free(sum_l);
   free(sum_mul);
 }
@@ -733,8 +685,8 @@ void OM_dual( char *mode )
 void OM_onsite( char *mode )
 {
   int i,j,k,l,m,mul,Gc_AN,Mc_AN;
-  int spin,wan1,tno0,num;
-  int numprocs,myid,ID;
+  int spin,wan1,num;
+  int numprocs,myid;
   double tmp0,tmp1,tmp2,tmp;
   double tmpB0,tmpB1,tmpB2;
   double tmpA0,tmpA1,tmpA2;
@@ -747,7 +699,6 @@ void OM_onsite( char *mode )
   double S_coordinate[3];
   double ***DecMulP_LA;
   double ***DecMulP_LB;
-  double *tmp_array0;
   double *sum_l,*sum_mul;
   char *Name_Angular[20][10];
   char *Name_Multiple[20];
@@ -777,7 +728,6 @@ void OM_onsite( char *mode )
     }
   }
 
-  tmp_array0 = (double*)malloc(sizeof(double)*(List_YOUSO[7]*(SpinP_switch+1)));
   sum_l   = (double*)malloc(sizeof(double)*(SpinP_switch+1));
   sum_mul = (double*)malloc(sizeof(double)*(SpinP_switch+1));
 
@@ -875,63 +825,16 @@ void OM_onsite( char *mode )
   Total_OrbitalMomentAngle0 = S_coordinate[1];
   Total_OrbitalMomentAngle1 = S_coordinate[2];
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+  Atom_Allgather_Vector(&Angle0_Orbital[1], 1);
+  Atom_Allgather_Vector(&Angle1_Orbital[1], 1);
+  Atom_Allgather_Vector(&OrbitalMoment[1], 1);
+  Atom_Allgather_Double(Orbital_Moment_XYZ, 0, 3);
 
-    ID = G2ID[Gc_AN];
-
-    MPI_Bcast(&Angle0_Orbital[Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Angle1_Orbital[Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&OrbitalMoment[Gc_AN],  1, MPI_DOUBLE, ID, mpi_comm_level1);
-    MPI_Bcast(&Orbital_Moment_XYZ[Gc_AN][0],  3, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    /* DecMulP_LA */
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	tmp_array0[num] = DecMulP_LA[spin][Gc_AN][i];
-	num++;
-      }
-    }
-
-    MPI_Bcast(&tmp_array0[0], num, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	DecMulP_LA[spin][Gc_AN][i] = tmp_array0[num];
-	num++;
-      }
-    }
-
-    /* DecMulP_LB */
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	tmp_array0[num] = DecMulP_LB[spin][Gc_AN][i];
-	num++;
-      }
-    }
-
-    MPI_Bcast(&tmp_array0[0], num, MPI_DOUBLE, ID, mpi_comm_level1);
-
-    num = 0; 
-    for (spin=0; spin<3; spin++){
-      wan1 = WhatSpecies[Gc_AN];
-      tno0 = Spe_Total_NO[wan1];  
-      for (i=0; i<Spe_Total_CNO[wan1]; i++){
-	DecMulP_LB[spin][Gc_AN][i] = tmp_array0[num];
-	num++;
-      }
-    }
+  /* DecMulP_LA and DecMulP_LB, whose rows have List_YOUSO[7] elements */
 
+  for (spin=0; spin<3; spin++){
+    Atom_Allgather_Double(DecMulP_LA[spin], 0, List_YOUSO[7]);
+    Atom_Allgather_Double(DecMulP_LB[spin], 0, List_YOUSO[7]);
   }
 
   for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
@@ -1090,7 +993,6 @@ void OM_onsite( char *mode )
   }
   free(DecMulP_LB);
 
-  free(tmp_array0);
   free(sum_l);
   free(sum_mul);
 
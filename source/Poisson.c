@@ -109,6 +109,7 @@ double Poisson(int fft_charge_flag,
   MPI_Barrier(mpi_comm_level1);
   dtime(&TEtime);
   time0 = TEtime - TStime;
+  if (Bench_flag) Bench_Record(Bench_Poisson,time0);
   return time0;
 }
 
@@ -179,13 +180,15 @@ void FFT_Poisson(double *ReRhor, double *ImRhor,
     dtime(&Stime_proc);
   }
 
-  array0 = (double*)malloc(sizeof(double)*2*GP_B_AB2CA_S[NN_B_AB2CA_S]); 
-  array1 = (double*)malloc(sizeof(double)*2*GP_B_AB2CA_R[NN_B_AB2CA_R]); 
+  Arena_Push();
 
-  request_send = malloc(sizeof(MPI_Request)*NN_B_AB2CA_S);
-  request_recv = malloc(sizeof(MPI_Request)*NN_B_AB2CA_R);
-  stat_send = malloc(sizeof(MPI_Status)*NN_B_AB2CA_S);
-  stat_recv = malloc(sizeof(MPI_Status)*NN_B_AB2CA_R);
+  array0 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_AB2CA_S[NN_B_AB2CA_S]); 
+  array1 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_AB2CA_R[NN_B_AB2CA_R]); 
+
+  request_send = Arena_Alloc(sizeof(MPI_Request)*NN_B_AB2CA_S);
+  request_recv = Arena_Alloc(sizeof(MPI_Request)*NN_B_AB2CA_R);
+  stat_send = Arena_Alloc(sizeof(MPI_Status)*NN_B_AB2CA_S);
+  stat_recv = Arena_Alloc(sizeof(MPI_Status)*NN_B_AB2CA_R);
 
   NN_S = 0;
   NN_R = 0;
@@ -255,13 +258,7 @@ void FFT_Poisson(double *ReRhor, double *ImRhor,
     }
   }
 
-  free(array0);
-  free(array1);
-
-  free(request_send);
-  free(request_recv);
-  free(stat_send);
-  free(stat_recv);
+  Arena_Pop();
 
   if (measure_time==1){
     MPI_Barrier(mpi_comm_level1);
@@ -304,13 +301,15 @@ void FFT_Poisson(double *ReRhor, double *ImRhor,
     dtime(&Stime_proc);
   }
 
-  array0 = (double*)malloc(sizeof(double)*2*GP_B_CA2CB_S[NN_B_CA2CB_S]); 
-  array1 = (double*)malloc(sizeof(double)*2*GP_B_CA2CB_R[NN_B_CA2CB_R]); 
+  Arena_Push();
+
+  array0 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_CA2CB_S[NN_B_CA2CB_S]); 
+  array1 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_CA2CB_R[NN_B_CA2CB_R]); 
 
-  request_send = malloc(sizeof(MPI_Request)*NN_B_CA2CB_S);
-  request_recv = malloc(sizeof(MPI_Request)*NN_B_CA2CB_R);
-  stat_send = malloc(sizeof(MPI_Status)*NN_B_CA2CB_S);
-  stat_recv = malloc(sizeof(MPI_Status)*NN_B_CA2CB_R);
+  request_send = Arena_Alloc(sizeof(MPI_Request)*NN_B_CA2CB_S);
+  request_recv = Arena_Alloc(sizeof(MPI_Request)*NN_B_CA2CB_R);
+  stat_send = Arena_Alloc(sizeof(MPI_Status)*NN_B_CA2CB_S);
+  stat_recv = Arena_Alloc(sizeof(MPI_Status)*NN_B_CA2CB_R);
 
   NN_S = 0;
   NN_R = 0;
@@ -380,13 +379,7 @@ void FFT_Poisson(double *ReRhor, double *ImRhor,
     }
   }
 
-  free(array0);
-  free(array1);
-
-  free(request_send);
-  free(request_recv);
-  free(stat_send);
-  free(stat_recv);
+  Arena_Pop();
 
   if (measure_time==1){
     MPI_Barrier(mpi_comm_level1);
@@ -541,13 +534,15 @@ void Inverse_FFT_Poisson(double *ReRhor, double *ImRhor,
     dtime(&Stime_proc);
   }
 
-  array0 = (double*)malloc(sizeof(double)*2*GP_B_CA2CB_R[NN_B_CA2CB_R]); 
-  array1 = (double*)malloc(sizeof(double)*2*GP_B_CA2CB_S[NN_B_CA2CB_S]); 
+  Arena_Push();
+
+  array0 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_CA2CB_R[NN_B_CA2CB_R]); 
+  array1 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_CA2CB_S[NN_B_CA2CB_S]); 
 
-  request_send = malloc(sizeof(MPI_Request)*NN_B_CA2CB_R);
-  request_recv = malloc(sizeof(MPI_Request)*NN_B_CA2CB_S);
-  stat_send = malloc(sizeof(MPI_Status)*NN_B_CA2CB_R);
-  stat_recv = malloc(sizeof(MPI_Status)*NN_B_CA2CB_S);
+  request_send = Arena_Alloc(sizeof(MPI_Request)*NN_B_CA2CB_R);
+  request_recv = Arena_Alloc(sizeof(MPI_Request)*NN_B_CA2CB_S);
+  stat_send = Arena_Alloc(sizeof(MPI_Status)*NN_B_CA2CB_R);
+  stat_recv = Arena_Alloc(sizeof(MPI_Status)*NN_B_CA2CB_S);
 
   NN_S = 0;
   NN_R = 0;
@@ -617,13 +612,7 @@ void Inverse_FFT_Poisson(double *ReRhor, double *ImRhor,
     }
   }
 
-  free(array0);
-  free(array1);
-
-  free(request_send);
-  free(request_recv);
-  free(stat_send);
-  free(stat_recv);
+  Arena_Pop();
 
   if (measure_time==1){
     MPI_Barrier(mpi_comm_level1);
@@ -666,13 +655,15 @@ void Inverse_FFT_Poisson(double *ReRhor, double *ImRhor,
     dtime(&Stime_proc);
   }
 
-  array0 = (double*)malloc(sizeof(double)*2*GP_B_AB2CA_R[NN_B_AB2CA_R]); 
-  array1 = (double*)malloc(sizeof(double)*2*GP_B_AB2CA_S[NN_B_AB2CA_S]); 
+  Arena_Push();
+
+  array0 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_AB2CA_R[NN_B_AB2CA_R]); 
+  array1 = (double*)Arena_Alloc(sizeof(double)*2*GP_B_AB2CA_S[NN_B_AB2CA_S]); 
 
-  request_send = malloc(sizeof(MPI_Request)*NN_B_AB2CA_R);
-  request_recv = malloc(sizeof(MPI_Request)*NN_B_AB2CA_S);
-  stat_send = malloc(sizeof(MPI_Status)*NN_B_AB2CA_R);
-  stat_recv = malloc(sizeof(MPI_Status)*NN_B_AB2CA_S);
+  request_send = Arena_Alloc(sizeof(MPI_Request)*NN_B_AB2CA_R);
+  request_recv = Arena_Alloc(sizeof(MPI_Request)*NN_B_AB2CA_S);
+  stat_send = Arena_Alloc(sizeof(MPI_Status)*NN_B_AB2CA_R);
+  stat_recv = Arena_Alloc(sizeof(MPI_Status)*NN_B_AB2CA_S);
 
   NN_S = 0;
   NN_R = 0;
@@ -742,13 +733,7 @@ void Inverse_FFT_Poisson(double *ReRhor, double *ImRhor,
     }
   }
 
-  free(array0);
-  free(array1);
-
-  free(request_send);
-  free(request_recv);
-  free(stat_send);
-  free(stat_recv);
+  Arena_Pop();
 
   if (measure_time==1){
     MPI_Barrier(mpi_comm_level1);
@@ -821,8 +806,10 @@ double FFT_Density(int den_flag,
 
   /* allocation of arrays */
 
-  ReRhor = (double*)malloc(sizeof(double)*My_Max_NumGridB); 
-  ImRhor = (double*)malloc(sizeof(double)*My_Max_NumGridB); 
+  Arena_Push();
+
+  ReRhor = (double*)Arena_Alloc(sizeof(double)*My_Max_NumGridB); 
+  ImRhor = (double*)Arena_Alloc(sizeof(double)*My_Max_NumGridB); 
 
   /* set ReRhor and ImRhor */
 
@@ -882,8 +869,7 @@ double FFT_Density(int den_flag,
 
   /* freeing of arrays */
 
-  free(ReRhor);
-  free(ImRhor);
+  Arena_Pop();
 
   /* for time */
   MPI_Barrier(mpi_comm_level1);
@@ -906,8 +892,10 @@ void Get_Value_inReal(int complex_flag,
 
   /* allocation of arrays */
 
-  ReTmpr = (double*)malloc(sizeof(double)*My_Max_NumGridB); 
-  ImTmpr = (double*)malloc(sizeof(double)*My_Max_NumGridB); 
+  Arena_Push();
+
+  ReTmpr = (double*)Arena_Alloc(sizeof(double)*My_Max_NumGridB); 
+  ImTmpr = (double*)Arena_Alloc(sizeof(double)*My_Max_NumGridB); 
 
   /* call Inverse_FFT_Poisson */
  
@@ -931,6 +919,5 @@ void Get_Value_inReal(int complex_flag,
 
   /* freeing of arrays */
 
-  free(ReTmpr);
-  free(ImTmpr);
+  Arena_Pop();
 }
@@ -0,0 +1,922 @@
+/**********************************************************************
+  Poisson_RS.c:
+
+     Poisson_RS.c is a subroutine to solve Poisson's equation in real
+     space by a preconditioned conjugate gradient (CG) method on the
+     partition B of the grid. Since the partition B is a contiguous set
+     of lines along the c-axis, only 2*Ngrid2 lines on both sides of
+     the partition are exchanged with the neighboring processes, and
+     no global transposition of the grid is needed.
+
+     The Laplacian is discretized with the second order finite
+     difference including the cross terms for non-orthogonal cells,
+     and the CG is preconditioned by the exact inverse of a tridiagonal
+     matrix along each line of the c-axis, whose diagonal is that of the
+     full operator including the three axes and whose off-diagonals are
+     the couplings along the c-axis. It requires no communication.
+     The periodic or open boundary condition can be chosen for each
+     axis with scf.Poisson.Boundary. For open axes, the Hartree
+     potential on the boundary is given by the monopole and dipole
+     (cluster), the line charge (wire), or the planar averaged charge
+     (slab) of the difference charge density.
+     The CG starts from dVHart_Grid_B of the previous SCF step.
+
+  Log of Poisson_RS.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#define  measure_time   0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "openmx_common.h"
+#include "mpi.h"
+#include <omp.h>
+
+#define Max_Stencil  18
+
+/* partition of lines along the c-axis */
+
+static int Np,N1,N2,N3,N2D,Ls,Le,NL,HL,NX;
+
+/* stencil: ext_line = own_line + HL + delta, and n3+d3 */
+
+static int Num_St;
+static int St_d[Max_Stencil][3];
+static double St_w[Max_Stencil],St_w0,St_wc;
+
+/* halo communication */
+
+static int *Num_Snd_Line,*Num_Rcv_Line;
+static int *Snd_Line,*Rcv_Line;
+static double *Snd_Buf,*Rcv_Buf;
+
+/* boundary values for open axes */
+
+static int Num_Open,Open_Axis,Periodic_Axis;
+static double BC_Q,BC_P[4],BC_rc[4],BC_Area,BC_h,BC_lambda;
+static double *BC_Plane_Q;
+
+/* preconditioner */
+
+static double *Tri_cp,*Tri_m,*Cyc_u,Cyc_fac;
+
+static int Line_Start(int ID);
+static int Line_Owner(int g);
+static void Set_Halo(int myid);
+static void Exchange_Halo(double *x);
+static void Apply_Op(int mode, double *x, double *y);
+static void Set_BC(double *rho);
+static double BC_Value(int n1, int n2, int n3);
+static void Set_Precon();
+static void Precon(double *r, double *z);
+static double Dot_B(double *a, double *b);
+
+
+
+double Poisson_RS()
+{
+  int i,j,k,l,BN,iter,a,b,d1,d2,d3,po;
+  double time0,TStime,TEtime;
+  double igtv[4][4],M[4][4],detA,wmax;
+  double *rho,*x,*r,*z,*p,*q,*bv;
+  double rz,rz0,pq,alpha,beta,bnorm,rnorm,mean;
+  int numprocs,myid;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  if (myid==Host_ID && 0<level_stdout){
+    printf("<Poisson_RS>  Poisson's equation by CG in real space...\n");
+  }
+
+  MPI_Barrier(mpi_comm_level1);
+  dtime(&TStime);
+
+  /****************************************************
+                partition of lines
+  ****************************************************/
+
+  Np  = numprocs;
+  N1  = Ngrid1;
+  N2  = Ngrid2;
+  N3  = Ngrid3;
+  N2D = N1*N2;
+  Ls  = Line_Start(myid);
+  Le  = Line_Start(myid+1);
+  NL  = Le - Ls;
+  HL  = 2*N2;
+  if (N2D<HL) HL = N2D;
+  NX  = NL + 2*HL;
+
+  /****************************************************
+    stencil of the Laplacian: \sum_{ab} M_ab d_a d_b
+    with M_ab = \sum_x igtv[x][a] igtv[x][b]
+  ****************************************************/
+
+  detA =   gtv[1][1]*gtv[2][2]*gtv[3][3]
+         + gtv[1][2]*gtv[2][3]*gtv[3][1]
+         + gtv[1][3]*gtv[2][1]*gtv[3][2]
+         - gtv[1][3]*gtv[2][2]*gtv[3][1]
+         - gtv[1][2]*gtv[2][1]*gtv[3][3]
+         - gtv[1][1]*gtv[2][3]*gtv[3][2];
+
+  igtv[1][1] =  (gtv[2][2]*gtv[3][3] - gtv[2][3]*gtv[3][2])/detA;
+  igtv[2][1] = -(gtv[2][1]*gtv[3][3] - gtv[2][3]*gtv[3][1])/detA;
+  igtv[3][1] =  (gtv[2][1]*gtv[3][2] - gtv[2][2]*gtv[3][1])/detA;
+
+  igtv[1][2] = -(gtv[1][2]*gtv[3][3] - gtv[1][3]*gtv[3][2])/detA;
+  igtv[2][2] =  (gtv[1][1]*gtv[3][3] - gtv[1][3]*gtv[3][1])/detA;
+  igtv[3][2] = -(gtv[1][1]*gtv[3][2] - gtv[1][2]*gtv[3][1])/detA;
+
+  igtv[1][3] =  (gtv[1][2]*gtv[2][3] - gtv[1][3]*gtv[2][2])/detA;
+  igtv[2][3] = -(gtv[1][1]*gtv[2][3] - gtv[1][3]*gtv[2][1])/detA;
+  igtv[3][3] =  (gtv[1][1]*gtv[2][2] - gtv[1][2]*gtv[2][1])/detA;
+
+  for (a=1; a<=3; a++){
+    for (b=1; b<=3; b++){
+      M[a][b] = 0.0;
+      for (i=1; i<=3; i++) M[a][b] += igtv[i][a]*igtv[i][b];
+    }
+  }
+
+  wmax = M[1][1];
+  if (wmax<M[2][2]) wmax = M[2][2];
+  if (wmax<M[3][3]) wmax = M[3][3];
+
+  St_w0 = -2.0*(M[1][1] + M[2][2] + M[3][3]);
+  St_wc = M[3][3];
+  Num_St = 0;
+
+  for (a=1; a<=3; a++){
+    for (b=a; b<=3; b++){
+
+      if (a!=b && fabs(M[a][b])<1.0e-12*wmax) continue;
+
+      for (i=-1; i<=1; i+=2){
+        for (j=-1; j<=1; j+=2){
+
+          if (a==b && j==1) continue;
+
+          d1 = d2 = d3 = 0;
+
+          if (a==1) d1 += i;  else if (a==2) d2 += i;  else d3 += i;
+
+          if (a==b){
+            St_w[Num_St] = M[a][a];
+	  }
+          else {
+            if (b==2) d2 += j;  else d3 += j;
+            St_w[Num_St] = 0.5*(double)(i*j)*M[a][b];
+	  }
+
+          St_d[Num_St][0] = d1;
+          St_d[Num_St][1] = d2;
+          St_d[Num_St][2] = d3;
+          Num_St++;
+	}
+      }
+    }
+  }
+
+  /****************************************************
+                  allocation of arrays
+  ****************************************************/
+
+  rho = (double*)malloc(sizeof(double)*(NL*N3+1));
+  bv  = (double*)malloc(sizeof(double)*(NL*N3+1));
+  r   = (double*)malloc(sizeof(double)*(NL*N3+1));
+  z   = (double*)malloc(sizeof(double)*(NL*N3+1));
+  q   = (double*)malloc(sizeof(double)*(NL*N3+1));
+  x   = (double*)malloc(sizeof(double)*(NX*N3+1));
+  p   = (double*)malloc(sizeof(double)*(NX*N3+1));
+
+  for (i=0; i<NX*N3; i++){ x[i] = 0.0; p[i] = 0.0; }
+
+  Set_Halo(myid);
+  Set_Precon();
+
+  /****************************************************
+     right hand side: 4*PI*(n - n_atom) and
+     the contribution of the boundary values
+  ****************************************************/
+
+  for (BN=0; BN<My_NumGridB_AB; BN++){
+    rho[BN] = Density_Grid_B[0][BN] + Density_Grid_B[1][BN] - 2.0*ADensity_Grid_B[BN];
+    bv[BN] = 4.0*PI*rho[BN];
+  }
+
+  Set_BC(rho);
+
+  if (Num_Open!=0){
+    Apply_Op(1, x, bv);
+  }
+
+  /* the G=0 component is excluded in the fully periodic case */
+
+  else {
+    mean = 0.0;
+    for (BN=0; BN<My_NumGridB_AB; BN++) mean += bv[BN];
+    MPI_Allreduce(MPI_IN_PLACE, &mean, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+    mean /= (double)N1*(double)N2*(double)N3;
+    for (BN=0; BN<My_NumGridB_AB; BN++) bv[BN] -= mean;
+  }
+
+  bnorm = sqrt(Dot_B(bv,bv));
+  if (bnorm<1.0e-30) bnorm = 1.0;
+
+  /****************************************************
+     start from dVHart_Grid_B of the previous step
+  ****************************************************/
+
+  for (l=0; l<NL; l++){
+    for (k=0; k<N3; k++){
+      x[(l+HL)*N3+k] = dVHart_Grid_B[l*N3+k];
+    }
+  }
+
+  Exchange_Halo(x);
+  Apply_Op(0, x, q);
+
+  for (BN=0; BN<My_NumGridB_AB; BN++) r[BN] = bv[BN] - q[BN];
+
+  Precon(r,z);
+
+  for (l=0; l<NL; l++){
+    for (k=0; k<N3; k++){
+      p[(l+HL)*N3+k] = z[l*N3+k];
+    }
+  }
+
+  rz = Dot_B(r,z);
+  rnorm = sqrt(Dot_B(r,r));
+
+  /****************************************************
+                      CG iteration
+  ****************************************************/
+
+  iter = 0;
+  po = 0;
+  if (rnorm/bnorm<Poisson_RS_Criterion) po = 1;
+
+  while (po==0 && iter<Poisson_RS_MaxIter){
+
+    Exchange_Halo(p);
+    Apply_Op(0, p, q);
+
+    pq = 0.0;
+    for (l=0; l<NL; l++){
+      for (k=0; k<N3; k++){
+        pq += p[(l+HL)*N3+k]*q[l*N3+k];
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &pq, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+    alpha = rz/pq;
+
+    for (l=0; l<NL; l++){
+      for (k=0; k<N3; k++){
+        x[(l+HL)*N3+k] += alpha*p[(l+HL)*N3+k];
+        r[l*N3+k] -= alpha*q[l*N3+k];
+      }
+    }
+
+    rnorm = sqrt(Dot_B(r,r));
+    iter++;
+
+    if (rnorm/bnorm<Poisson_RS_Criterion){
+      po = 1;
+      break;
+    }
+
+    Precon(r,z);
+
+    rz0 = rz;
+    rz = Dot_B(r,z);
+    beta = rz/rz0;
+
+    for (l=0; l<NL; l++){
+      for (k=0; k<N3; k++){
+        p[(l+HL)*N3+k] = z[l*N3+k] + beta*p[(l+HL)*N3+k];
+      }
+    }
+  }
+
+  if (myid==Host_ID && 1<level_stdout){
+    printf("<Poisson_RS>  iter=%3d  |r|/|b|=%10.5e\n",iter,rnorm/bnorm);
+  }
+
+  if (po==0 && myid==Host_ID && 0<level_stdout){
+    printf("<Poisson_RS>  CG did not converge within %d iterations, |r|/|b|=%10.5e\n",
+           Poisson_RS_MaxIter,rnorm/bnorm);
+  }
+
+  /****************************************************
+    store the solution; the average is set to zero
+    in the fully periodic case as in Poisson().
+  ****************************************************/
+
+  mean = 0.0;
+
+  if (Num_Open==0){
+    for (l=0; l<NL; l++){
+      for (k=0; k<N3; k++){
+        mean += x[(l+HL)*N3+k];
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &mean, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+    mean /= (double)N1*(double)N2*(double)N3;
+  }
+
+  for (l=0; l<NL; l++){
+    for (k=0; k<N3; k++){
+      dVHart_Grid_B[l*N3+k] = x[(l+HL)*N3+k] - mean;
+    }
+  }
+
+  /****************************************************
+                  freeing of arrays
+  ****************************************************/
+
+  free(p);
+  free(x);
+  free(q);
+  free(z);
+  free(r);
+  free(bv);
+  free(rho);
+
+  free(Num_Snd_Line);
+  free(Num_Rcv_Line);
+  free(Snd_Line);
+  free(Rcv_Line);
+  free(Snd_Buf);
+  free(Rcv_Buf);
+
+  if (Num_Open==1) free(BC_Plane_Q);
+
+  free(Tri_cp);
+  free(Tri_m);
+  free(Cyc_u);
+
+  /* for time */
+  MPI_Barrier(mpi_comm_level1);
+  dtime(&TEtime);
+  time0 = TEtime - TStime;
+  if (Bench_flag) Bench_Record(Bench_Poisson,time0);
+  return time0;
+}
+
+
+
+static int Line_Start(int ID)
+{
+  return (int)(((long int)ID*N2D + Np - 1)/Np);
+}
+
+
+
+static int Line_Owner(int g)
+{
+  int ID;
+
+  ID = (int)(((long int)g*Np)/N2D);
+  if (Np<=ID) ID = Np - 1;
+  while (g<Line_Start(ID))     ID--;
+  while (Line_Start(ID+1)<=g)  ID++;
+  return ID;
+}
+
+
+
+/****************************************************
+  Set_Halo sets up the lists of lines to be sent and
+  received. The halo of a process consists of HL lines
+  before and after its own lines, which are ordered
+  by the global line index modulo N2D.
+****************************************************/
+
+static void Set_Halo(int myid)
+{
+  int ID,L,g,s,e,n,num;
+  int *cnt;
+
+  Num_Snd_Line = (int*)malloc(sizeof(int)*(Np+1));
+  Num_Rcv_Line = (int*)malloc(sizeof(int)*(Np+1));
+  cnt = (int*)malloc(sizeof(int)*(Np+1));
+
+  for (ID=0; ID<=Np; ID++){
+    Num_Snd_Line[ID] = 0;
+    Num_Rcv_Line[ID] = 0;
+  }
+
+  /* lines to be received, sorted by the owner and L */
+
+  if (NL!=0){
+    for (L=0; L<NX; L++){
+      if (HL<=L && L<(HL+NL)) continue;
+      g = ((Ls - HL + L) % N2D + N2D) % N2D;
+      Num_Rcv_Line[Line_Owner(g)]++;
+    }
+  }
+
+  num = 0;
+  for (ID=0; ID<Np; ID++){ cnt[ID] = num; num += Num_Rcv_Line[ID]; }
+
+  Rcv_Line = (int*)malloc(sizeof(int)*(num+1));
+  Rcv_Buf = (double*)malloc(sizeof(double)*(num*N3+1));
+
+  if (NL!=0){
+    for (L=0; L<NX; L++){
+      if (HL<=L && L<(HL+NL)) continue;
+      g = ((Ls - HL + L) % N2D + N2D) % N2D;
+      ID = Line_Owner(g);
+      Rcv_Line[cnt[ID]++] = L;
+    }
+  }
+
+  /* lines to be sent in the order of receiving */
+
+  num = 0;
+  for (ID=0; ID<Np; ID++){
+
+    s = Line_Start(ID);
+    e = Line_Start(ID+1);
+    if (s==e) continue;
+
+    for (L=0; L<(e-s+2*HL); L++){
+      if (HL<=L && L<(HL+e-s)) continue;
+      g = ((s - HL + L) % N2D + N2D) % N2D;
+      if (Ls<=g && g<Le){
+        Num_Snd_Line[ID]++;
+        num++;
+      }
+    }
+  }
+
+  Snd_Line = (int*)malloc(sizeof(int)*(num+1));
+  Snd_Buf = (double*)malloc(sizeof(double)*(num*N3+1));
+
+  n = 0;
+  for (ID=0; ID<Np; ID++){
+
+    s = Line_Start(ID);
+    e = Line_Start(ID+1);
+    if (s==e) continue;
+
+    for (L=0; L<(e-s+2*HL); L++){
+      if (HL<=L && L<(HL+e-s)) continue;
+      g = ((s - HL + L) % N2D + N2D) % N2D;
+      if (Ls<=g && g<Le) Snd_Line[n++] = g - Ls;
+    }
+  }
+
+  free(cnt);
+}
+
+
+
+static void Exchange_Halo(double *x)
+{
+  int ID,i,k,n,ns,nr,myid,tag=999;
+  MPI_Request *request;
+  MPI_Status *stat;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  request = (MPI_Request*)malloc(sizeof(MPI_Request)*2*Np);
+  stat = (MPI_Status*)malloc(sizeof(MPI_Status)*2*Np);
+
+  /* pack */
+
+  n = 0;
+  for (ID=0; ID<Np; ID++){
+    for (i=0; i<Num_Snd_Line[ID]; i++){
+      for (k=0; k<N3; k++){
+        Snd_Buf[n*N3+k] = x[(Snd_Line[n]+HL)*N3+k];
+      }
+      n++;
+    }
+  }
+
+  /* MPI communication with the neighbors */
+
+  n = 0;
+  ns = 0;
+  nr = 0;
+
+  for (ID=0; ID<Np; ID++){
+    if (ID!=myid && Num_Rcv_Line[ID]!=0){
+      MPI_Irecv(&Rcv_Buf[nr*N3], Num_Rcv_Line[ID]*N3, MPI_DOUBLE, ID, tag,
+                mpi_comm_level1, &request[n++]);
+    }
+    nr += Num_Rcv_Line[ID];
+  }
+
+  for (ID=0; ID<Np; ID++){
+    if (ID!=myid && Num_Snd_Line[ID]!=0){
+      MPI_Isend(&Snd_Buf[ns*N3], Num_Snd_Line[ID]*N3, MPI_DOUBLE, ID, tag,
+                mpi_comm_level1, &request[n++]);
+    }
+    ns += Num_Snd_Line[ID];
+  }
+
+  /* the halo owned by myid itself */
+
+  ns = 0;
+  nr = 0;
+  for (ID=0; ID<myid; ID++){
+    ns += Num_Snd_Line[ID];
+    nr += Num_Rcv_Line[ID];
+  }
+
+  for (i=0; i<Num_Rcv_Line[myid]; i++){
+    for (k=0; k<N3; k++){
+      Rcv_Buf[(nr+i)*N3+k] = Snd_Buf[(ns+i)*N3+k];
+    }
+  }
+
+  MPI_Waitall(n,request,stat);
+
+  /* unpack */
+
+  nr = 0;
+  for (ID=0; ID<Np; ID++) nr += Num_Rcv_Line[ID];
+
+  for (i=0; i<nr; i++){
+    for (k=0; k<N3; k++){
+      x[Rcv_Line[i]*N3+k] = Rcv_Buf[i*N3+k];
+    }
+  }
+
+  free(stat);
+  free(request);
+}
+
+
+
+/****************************************************
+  Apply_Op:
+    mode 0:  y = -\nabla^2 x, where the values at the
+             points outside of open boundaries are zero.
+    mode 1:  y += (the contribution of the boundary
+             values at points outside of open boundaries)
+****************************************************/
+
+static void Apply_Op(int mode, double *x, double *y)
+{
+  int l;
+
+#pragma omp parallel for private(l)
+  for (l=0; l<NL; l++){
+
+    int g,n1,n2,k,kk,m1,m2,s,delta,ghost;
+    int LX[Max_Stencil];
+    double sum;
+
+    g = Ls + l;
+    n1 = g/N2;
+    n2 = g - n1*N2;
+
+    /* the line of each stencil point */
+
+    for (s=0; s<Num_St; s++){
+
+      m1 = n1 + St_d[s][0];
+      m2 = n2 + St_d[s][1];
+      ghost = 0;
+
+      if (m1<0 || N1<=m1){
+        if (Poisson_RS_BC[1]==0) m1 = (m1 + N1) % N1;
+        else                     ghost = 1;
+      }
+      if (m2<0 || N2<=m2){
+        if (Poisson_RS_BC[2]==0) m2 = (m2 + N2) % N2;
+        else                     ghost = 1;
+      }
+
+      if (ghost){
+        LX[s] = -1;
+      }
+      else {
+        delta = m1*N2 + m2 - g;
+        if ( N2D/2<delta)  delta -= N2D;
+        if (delta<-N2D/2)  delta += N2D;
+        LX[s] = l + HL + delta;
+      }
+    }
+
+    for (k=0; k<N3; k++){
+
+      sum = 0.0;
+
+      for (s=0; s<Num_St; s++){
+
+        kk = k + St_d[s][2];
+        ghost = (LX[s]<0);
+
+        if (kk<0 || N3<=kk){
+          if (Poisson_RS_BC[3]==0) kk = (kk + N3) % N3;
+          else                     ghost = 1;
+	}
+
+        if (mode==0 && !ghost){
+          sum += St_w[s]*x[LX[s]*N3+kk];
+	}
+        else if (mode==1 && ghost){
+          sum += St_w[s]*BC_Value(n1+St_d[s][0], n2+St_d[s][1], k+St_d[s][2]);
+	}
+      }
+
+      if (mode==0) y[l*N3+k] = -St_w0*x[(l+HL)*N3+k] - sum;
+      else         y[l*N3+k] += sum;
+    }
+  }
+}
+
+
+
+/****************************************************
+  Set_BC sets up the multipole or the planar averaged
+  charge used for the boundary values of open axes.
+****************************************************/
+
+static void Set_BC(double *rho)
+{
+  int i,l,k,g,n[4],BN,a,b,c;
+  double r[4],v[4],tmp,len;
+  double sum[5];
+
+  Num_Open = 0;
+  Open_Axis = 0;
+  Periodic_Axis = 0;
+
+  for (i=1; i<=3; i++){
+    if (Poisson_RS_BC[i]==1){ Num_Open++; Open_Axis = i; }
+    else                      Periodic_Axis = i;
+  }
+
+  if (Num_Open==0) return;
+
+  for (i=1; i<=3; i++){
+    BC_rc[i] = Grid_Origin[i] + 0.5*( (double)(N1-1)*gtv[1][i]
+                                    + (double)(N2-1)*gtv[2][i]
+                                    + (double)(N3-1)*gtv[3][i]);
+  }
+
+  /* cluster and wire: monopole and dipole */
+
+  if (Num_Open==3 || Num_Open==2){
+
+    for (i=0; i<=4; i++) sum[i] = 0.0;
+
+    for (l=0; l<NL; l++){
+
+      g = Ls + l;
+      n[1] = g/N2;
+      n[2] = g - n[1]*N2;
+
+      for (k=0; k<N3; k++){
+
+        BN = l*N3 + k;
+        n[3] = k;
+
+        for (i=1; i<=3; i++){
+          r[i] = Grid_Origin[i] + (double)n[1]*gtv[1][i] + (double)n[2]*gtv[2][i]
+               + (double)n[3]*gtv[3][i] - BC_rc[i];
+	}
+
+        sum[0] += rho[BN];
+        sum[1] += rho[BN]*r[1];
+        sum[2] += rho[BN]*r[2];
+        sum[3] += rho[BN]*r[3];
+      }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, sum, 4, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+    BC_Q = sum[0]*GridVol;
+    BC_P[1] = sum[1]*GridVol;
+    BC_P[2] = sum[2]*GridVol;
+    BC_P[3] = sum[3]*GridVol;
+
+    /* charge per length for the wire */
+
+    if (Num_Open==2){
+      a = Periodic_Axis;
+      len = sqrt(gtv[a][1]*gtv[a][1] + gtv[a][2]*gtv[a][2] + gtv[a][3]*gtv[a][3]);
+      if      (a==1) len *= (double)N1;
+      else if (a==2) len *= (double)N2;
+      else           len *= (double)N3;
+      BC_lambda = BC_Q/len;
+    }
+  }
+
+  /* slab: charge of each plane perpendicular to the open axis */
+
+  else if (Num_Open==1){
+
+    a = Open_Axis;
+    if      (a==1){ b = 2; c = 3; }
+    else if (a==2){ b = 3; c = 1; }
+    else          { b = 1; c = 2; }
+
+    if      (a==1) n[0] = N1;
+    else if (a==2) n[0] = N2;
+    else           n[0] = N3;
+
+    BC_Plane_Q = (double*)malloc(sizeof(double)*n[0]);
+    for (i=0; i<n[0]; i++) BC_Plane_Q[i] = 0.0;
+
+    for (l=0; l<NL; l++){
+
+      g = Ls + l;
+      n[1] = g/N2;
+      n[2] = g - n[1]*N2;
+
+      for (k=0; k<N3; k++){
+        n[3] = k;
+        BC_Plane_Q[n[a]] += rho[l*N3+k]*GridVol;
+      }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, BC_Plane_Q, n[0], MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+    /* area of the cell perpendicular to the open axis, and
+       the grid spacing along its normal */
+
+    v[1] = gtv[b][2]*gtv[c][3] - gtv[b][3]*gtv[c][2];
+    v[2] = gtv[b][3]*gtv[c][1] - gtv[b][1]*gtv[c][3];
+    v[3] = gtv[b][1]*gtv[c][2] - gtv[b][2]*gtv[c][1];
+    tmp = sqrt(v[1]*v[1] + v[2]*v[2] + v[3]*v[3]);
+
+    BC_Area = tmp;
+    if (b==1 || c==1) BC_Area *= (double)N1;
+    if (b==2 || c==2) BC_Area *= (double)N2;
+    if (b==3 || c==3) BC_Area *= (double)N3;
+
+    BC_h = fabs(gtv[a][1]*v[1] + gtv[a][2]*v[2] + gtv[a][3]*v[3])/tmp;
+  }
+}
+
+
+
+static double BC_Value(int n1, int n2, int n3)
+{
+  int i,m,nm;
+  double r[4],rr,pr,t,len,V;
+
+  for (i=1; i<=3; i++){
+    r[i] = Grid_Origin[i] + (double)n1*gtv[1][i] + (double)n2*gtv[2][i]
+         + (double)n3*gtv[3][i] - BC_rc[i];
+  }
+
+  /* cluster */
+
+  if (Num_Open==3){
+    rr = sqrt(r[1]*r[1] + r[2]*r[2] + r[3]*r[3]);
+    pr = BC_P[1]*r[1] + BC_P[2]*r[2] + BC_P[3]*r[3];
+    V = BC_Q/rr + pr/(rr*rr*rr);
+  }
+
+  /* wire: -2 lambda log(r_perp) */
+
+  else if (Num_Open==2){
+    i = Periodic_Axis;
+    len = sqrt(gtv[i][1]*gtv[i][1] + gtv[i][2]*gtv[i][2] + gtv[i][3]*gtv[i][3]);
+    t = (r[1]*gtv[i][1] + r[2]*gtv[i][2] + r[3]*gtv[i][3])/len;
+    rr = sqrt(fabs(r[1]*r[1] + r[2]*r[2] + r[3]*r[3] - t*t));
+    V = -2.0*BC_lambda*log(rr);
+  }
+
+  /* slab: -2 PI \sum_m |z-z_m| q_m/A */
+
+  else {
+    if      (Open_Axis==1){ m = n1; nm = N1; }
+    else if (Open_Axis==2){ m = n2; nm = N2; }
+    else                  { m = n3; nm = N3; }
+
+    V = 0.0;
+    for (i=0; i<nm; i++){
+      V += fabs((double)(m - i))*BC_Plane_Q[i];
+    }
+    V *= -2.0*PI*BC_h/BC_Area;
+  }
+
+  return V;
+}
+
+
+
+/****************************************************
+  Set_Precon factorizes the tridiagonal matrix
+  (-St_wc, -St_w0, -St_wc) on a line of the c-axis,
+  where St_w0 is the diagonal of the full operator
+  with the contributions of the three axes, and
+  St_wc is the coupling along the c-axis only.
+  In the periodic case, the cyclic matrix is treated
+  by the Sherman-Morrison formula.
+****************************************************/
+
+static void Set_Precon()
+{
+  int k;
+  double d,e,gamma;
+
+  Tri_cp = (double*)malloc(sizeof(double)*(N3+1));
+  Tri_m  = (double*)malloc(sizeof(double)*(N3+1));
+  Cyc_u  = (double*)malloc(sizeof(double)*(N3+1));
+
+  if (N3<3) return;
+
+  d = -St_w0;
+  e = -St_wc;
+  gamma = -d;
+
+  for (k=0; k<N3; k++) Tri_m[k] = d;
+
+  if (Poisson_RS_BC[3]==0){
+    Tri_m[0]    = d - gamma;
+    Tri_m[N3-1] = d - e*e/gamma;
+  }
+
+  Tri_cp[0] = e/Tri_m[0];
+  for (k=1; k<N3; k++){
+    Tri_m[k] = Tri_m[k] - e*Tri_cp[k-1];
+    Tri_cp[k] = e/Tri_m[k];
+  }
+
+  if (Poisson_RS_BC[3]==0){
+
+    /* solve T' u = (gamma,0,...,0,e) */
+
+    Cyc_u[0] = gamma/Tri_m[0];
+    for (k=1; k<N3; k++){
+      Cyc_u[k] = ((k==(N3-1) ? e : 0.0) - e*Cyc_u[k-1])/Tri_m[k];
+    }
+    for (k=N3-2; 0<=k; k--){
+      Cyc_u[k] -= Tri_cp[k]*Cyc_u[k+1];
+    }
+
+    Cyc_fac = 1.0/(1.0 + Cyc_u[0] + e*Cyc_u[N3-1]/gamma);
+  }
+}
+
+
+
+static void Precon(double *r, double *z)
+{
+  int l;
+  double d,e,gamma;
+
+  d = -St_w0;
+  e = -St_wc;
+  gamma = -d;
+
+#pragma omp parallel for private(l)
+  for (l=0; l<NL; l++){
+
+    int k;
+    double *rl,*zl,f;
+
+    rl = &r[l*N3];
+    zl = &z[l*N3];
+
+    if (N3<3){
+      for (k=0; k<N3; k++) zl[k] = rl[k]/d;
+      continue;
+    }
+
+    zl[0] = rl[0]/Tri_m[0];
+    for (k=1; k<N3; k++){
+      zl[k] = (rl[k] - e*zl[k-1])/Tri_m[k];
+    }
+    for (k=N3-2; 0<=k; k--){
+      zl[k] -= Tri_cp[k]*zl[k+1];
+    }
+
+    if (Poisson_RS_BC[3]==0){
+      f = Cyc_fac*(zl[0] + e*zl[N3-1]/gamma);
+      for (k=0; k<N3; k++) zl[k] -= f*Cyc_u[k];
+    }
+  }
+}
+
+
+
+static double Dot_B(double *a, double *b)
+{
+  int i;
+  double sum;
+
+  sum = 0.0;
+  for (i=0; i<NL*N3; i++) sum += a[i]*b[i];
+
+  MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+  return sum;
+}
@@ -0,0 +1,947 @@
+/**********************************************************************
+  Pole_DFT.c:
+
+     Pole_DFT.c is a subroutine to calculate the density matrix by the
+     pole expansion of the Fermi function and the selected inversion,
+     which is applicable to large metallic systems.
+
+     Using the poles of the continued fraction representation of the
+     Fermi function (zero_cfrac), the density and energy density
+     matrices are given by
+
+       DM  = 1/2 S^{-1} + sum_p Herm[ w_p G(alpha_p) ]
+       EDM = 1/2 S^{-1} H S^{-1} - sum_p Re(w_p) S^{-1}
+             + sum_p Herm[ w_p alpha_p G(alpha_p) ]
+
+     where G(z) = (zS - H)^{-1}, alpha_p = ChemP + i zp/Beta, and
+     w_p = -2Rp/Beta. The moment terms are evaluated by a pole at iR
+     with a large R as in Cluster_DFT_ON2.
+
+     Only the blocks of G(z) between atoms in FNAN are needed. They are
+     calculated by the selected inversion: zS - H is factorized as LDU
+     in atom blocks in the minimum degree ordering of atoms, and G(z)
+     is calculated only on the filled pattern of L and U, from the last
+     atom in the ordering to the first one.
+
+     H(k) and S(k) are formed at the k-points given by scf.Kgrid, so
+     that the cluster and band calculations are treated in the same
+     way. The pairs of a k-point, spin, and pole are distributed to MPI
+     processes and OpenMP threads. The chemical potential is searched
+     by the secant method with bracketing.
+
+  Log of Pole_DFT.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "openmx_common.h"
+#include "lapack_prototypes.h"
+#include "mpi.h"
+#include <omp.h>
+
+#define Tno(G)  Spe_Total_CNO[WhatSpecies[G]]
+#define R_moment       1.0e+6
+#define Criterion_Num  1.0e-8
+
+/* symbolic factorization, done at the first SCF step of each MD step */
+
+static int *Ord;          /* Ord[s]: atom eliminated at step s */
+static int *Pos;          /* Pos[Gc_AN]: step at which Gc_AN is eliminated */
+static int *Nstr;         /* # of atoms in the structure of Gc_AN */
+static int **Str;         /* atoms coupled to Gc_AN in L and U, eliminated
+                             after Gc_AN, in ascending order */
+static long int *Doff;    /* offsets of the diagonal blocks */
+static long int **Loff;   /* offsets of the off-diagonal blocks of L and U */
+static long int SizeD,SizeL;
+static int Sym_atomnum = 0;
+
+/* H and S gathered in all the processes */
+
+static long int **Hoff;   /* Hoff[Gc_AN][h_AN]: offset of the block */
+static long int SizeH;
+
+/* k-points */
+
+static int Pole_Nk;
+static double *Pole_k1,*Pole_k2,*Pole_k3,*Pole_kw;
+
+/* poles */
+
+static dcomplex *Pole_zp,*Pole_Rp;
+static int Pole_Np = 0;
+
+static double Pole_Col(char *mode,
+                       int SCF_iter,
+                       double *****Hks,
+                       double ****OLP0,
+                       double *****CDM,
+                       double *****EDM,
+                       double Eele0[2], double Eele1[2]);
+static double Calc_DM(double mu, double **Hg, double *Sg, double **DMg, double **EDMg);
+static void Factorize_Selinv(double complex z, double k1, double k2, double k3,
+                             double *Hg, double *Sg,
+                             double complex *AD, double complex *AL, double complex *AU,
+                             double complex *GD, double complex *GL, double complex *GU,
+                             double complex *W1);
+static double complex *Blk(int i, int j, double complex *D, double complex *L, double complex *U);
+static void Add_Blk(int m, int n, int l, double complex alpha,
+                    double complex *A, double complex *B, double complex *C);
+static void Symbolic();
+static void Free_Symbolic();
+static void Set_Kpoints();
+static int Find_Str(int v, int G);
+int Lapack_LU_Zinverse(int , dcomplex *);
+
+
+
+double Pole_DFT(char *mode,
+                int SCF_iter,
+                double *****Hks,
+                double *****ImNL,
+                double ****OLP0,
+                double *****CDM,
+                double *****EDM,
+                double Eele0[2], double Eele1[2])
+{
+  double time0;
+
+  time0 = 0.0;
+
+  /****************************************************
+         collinear without spin-orbit coupling
+  ****************************************************/
+
+  if ( (SpinP_switch==0 || SpinP_switch==1) && SO_switch==0 ){
+    time0 = Pole_Col(mode,SCF_iter, Hks, OLP0, CDM, EDM, Eele0, Eele1);
+  }
+
+  /****************************************************
+         collinear with spin-orbit coupling
+  ****************************************************/
+
+  else if ( (SpinP_switch==0 || SpinP_switch==1) && SO_switch==1 ){
+    printf("Spin-orbit coupling is not supported for collinear DFT calculations.\n");
+    MPI_Finalize();
+    exit(1);
+  }
+
+  /****************************************************
+   non-collinear with and without spin-orbit coupling
+  ****************************************************/
+
+  else if (SpinP_switch==3){
+    printf("The pole expansion method is not supported for non-collinear DFT calculations.\n");
+    MPI_Finalize();
+    exit(1);
+  }
+
+  return time0;
+}
+
+
+
+
+static double Pole_Col(char *mode,
+                       int SCF_iter,
+                       double *****Hks,
+                       double ****OLP0,
+                       double *****CDM,
+                       double *****EDM,
+                       double Eele0[2], double Eele1[2])
+{
+  int Mc_AN,Gc_AN,h_AN,Gh_AN,tno1,tno2,i,j,spin,myid;
+  int loopN,po,po_lo,po_hi;
+  long int n,k;
+  double My_TZ,TZ,Ne,Num,Dnum,mu,mu_lo,mu_hi,N_lo,N_hi,mu0,N0,step;
+  double *Hg[2],*Sg,*DMg[2],*EDMg[2];
+  double TStime,TEtime;
+
+  if (strcasecmp(mode,"scf")!=0) return 0.0;
+
+  dtime(&TStime);
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* poles */
+
+  if (Pole_Np!=Pole_Npoles){
+
+    if (Pole_Np!=0){
+      free(Pole_zp);
+      free(Pole_Rp);
+    }
+
+    Pole_Np = Pole_Npoles;
+    Pole_zp = (dcomplex*)malloc(sizeof(dcomplex)*(Pole_Np+1));
+    Pole_Rp = (dcomplex*)malloc(sizeof(dcomplex)*(Pole_Np+1));
+    zero_cfrac(Pole_Np,Pole_zp,Pole_Rp);
+  }
+
+  /* the neighbor lists change at each MD step */
+
+  if (SCF_iter==1 || Sym_atomnum!=atomnum){
+    if (Sym_atomnum!=0) Free_Symbolic();
+    Symbolic();
+    Set_Kpoints();
+  }
+
+  /****************************************************
+                gather H and S globally
+  ****************************************************/
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    Hg[spin]   = (double*)malloc(sizeof(double)*SizeH);
+    DMg[spin]  = (double*)malloc(sizeof(double)*SizeH);
+    EDMg[spin] = (double*)malloc(sizeof(double)*SizeH);
+    for (k=0; k<SizeH; k++) Hg[spin][k] = 0.0;
+  }
+  Sg = (double*)malloc(sizeof(double)*SizeH);
+  for (k=0; k<SizeH; k++) Sg[k] = 0.0;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      tno2 = Tno(Gh_AN);
+      k = Hoff[Gc_AN][h_AN];
+      for (i=0; i<tno1; i++){
+        for (j=0; j<tno2; j++){
+          for (spin=0; spin<=SpinP_switch; spin++){
+            Hg[spin][k] = Hks[spin][Mc_AN][h_AN][i][j];
+          }
+          Sg[k] = OLP0[Mc_AN][h_AN][i][j];
+          k++;
+        }
+      }
+    }
+  }
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    MPI_Allreduce(MPI_IN_PLACE, Hg[spin], SizeH, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+  }
+  MPI_Allreduce(MPI_IN_PLACE, Sg, SizeH, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+  /* the number of electrons */
+
+  My_TZ = 0.0;
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    My_TZ += Spe_Core_Charge[WhatSpecies[Gc_AN]];
+  }
+  MPI_Allreduce(&My_TZ, &TZ, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+  Ne = TZ - system_charge;
+
+  /****************************************************
+     search of the chemical potential by the secant
+     method, started from ChemP of the previous step
+  ****************************************************/
+
+  mu = ChemP;
+  mu0 = mu;
+  N0 = 0.0;
+  po_lo = 0;
+  po_hi = 0;
+  po = 0;
+  loopN = 0;
+  step = 0.02;
+
+  do {
+
+    Num = Calc_DM(mu,Hg,Sg,DMg,EDMg);
+    Dnum = Ne - Num;
+
+    if (myid==Host_ID && 2<=level_stdout){
+      printf("<Pole_DFT> ChemP=%15.12f Ne=%15.12f Num_state=%15.12f\n",mu,Ne,Num);
+    }
+
+    if (fabs(Dnum)<Criterion_Num) po = 1;
+
+    else if (40<=loopN){
+
+      po = 1;
+
+      if (myid==Host_ID){
+        printf("<Pole_DFT> ChemP is not converged within 40 steps, |Ne-Num_state|=%10.5e\n",fabs(Dnum));
+      }
+    }
+
+    else {
+
+      if (0.0<Dnum){ mu_lo = mu; N_lo = Num; po_lo = 1; }
+      else         { mu_hi = mu; N_hi = Num; po_hi = 1; }
+
+      /* regula falsi with bisection every third step */
+
+      if (po_lo && po_hi){
+        if ((loopN%3)==2 || (N_hi-N_lo)<1.0e-14) mu = 0.5*(mu_lo + mu_hi);
+        else mu = mu_lo + (Ne - N_lo)*(mu_hi - mu_lo)/(N_hi - N_lo);
+      }
+
+      /* secant until the root is bracketed */
+
+      else {
+
+        if (0<loopN && 1.0e-14<fabs(Num-N0)){
+          step = (Ne - Num)*(mu - mu0)/(Num - N0);
+          if (0.2<fabs(step)) step = 0.2*step/fabs(step);
+        }
+        else {
+          step = 0.0<Dnum ? fabs(step) : -fabs(step);
+        }
+
+        mu0 = mu;
+        N0 = Num;
+        mu = mu + step;
+      }
+    }
+
+    loopN++;
+
+  } while (po==0);
+
+  ChemP = mu;
+
+  /****************************************************
+                  store DM and EDM
+  ****************************************************/
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      tno2 = Tno(Gh_AN);
+      k = Hoff[Gc_AN][h_AN];
+      for (i=0; i<tno1; i++){
+        for (j=0; j<tno2; j++){
+          for (spin=0; spin<=SpinP_switch; spin++){
+            CDM[spin][Mc_AN][h_AN][i][j] = DMg[spin][k];
+            EDM[spin][Mc_AN][h_AN][i][j] = EDMg[spin][k];
+          }
+          k++;
+        }
+      }
+    }
+  }
+
+  /* Eele0 = Tr(EDM S), Eele1 = Tr(DM H) */
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    Eele0[spin] = 0.0;
+    Eele1[spin] = 0.0;
+    for (n=0; n<SizeH; n++){
+      Eele0[spin] += EDMg[spin][n]*Sg[n];
+      Eele1[spin] += DMg[spin][n]*Hg[spin][n];
+    }
+  }
+
+  if (SpinP_switch==0){
+    Eele0[1] = Eele0[0];
+    Eele1[1] = Eele1[0];
+  }
+
+  if (3<=level_stdout && myid==Host_ID){
+    printf("Eele00=%15.12f Eele01=%15.12f\n",Eele0[0],Eele0[1]);
+    printf("Eele10=%15.12f Eele11=%15.12f\n",Eele1[0],Eele1[1]);
+  }
+
+  /* freeing of arrays */
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    free(Hg[spin]);
+    free(DMg[spin]);
+    free(EDMg[spin]);
+  }
+  free(Sg);
+
+  dtime(&TEtime);
+  return TEtime - TStime;
+}
+
+
+
+/****************************************************
+  Calc_DM calculates DM and EDM at the chemical
+  potential mu in the layout of Hg, and returns the
+  number of electrons.
+****************************************************/
+
+static double Calc_DM(double mu, double **Hg, double *Sg, double **DMg, double **EDMg)
+{
+  int numprocs,myid,spin,p,Ntask;
+  long int n;
+  double csum,Num,spin_degeneracy;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  Ntask = Pole_Nk*(SpinP_switch+1)*(Pole_Np+1);
+
+  /* the constant in EDM */
+
+  csum = 0.0;
+  for (p=0; p<Pole_Np; p++) csum += 2.0*Pole_Rp[p].r/Beta;
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    for (n=0; n<SizeH; n++){
+      DMg[spin][n] = 0.0;
+      EDMg[spin][n] = 0.0;
+    }
+  }
+
+#pragma omp parallel shared(Ntask,numprocs,myid,mu,csum,Hg,Sg,DMg,EDMg,SizeD,SizeL,SizeH,SpinP_switch,Pole_Np,Pole_zp,Pole_Rp,Pole_k1,Pole_k2,Pole_k3,Pole_kw,Beta,atomnum,FNAN,natn,ncn,atv_ijk,Hoff,WhatSpecies,Spe_Total_CNO)
+  {
+    int t,kloop,spin,p,Gc_AN,h_AN,Gh_AN,Rn,tno1,tno2,i,j;
+    long int n,k;
+    double kRn,kw;
+    double complex z,w,we,ph,g1,g2;
+    double complex *AD,*AL,*AU,*GD,*GL,*GU,*W1,*G12,*G21;
+    double *dm,*edm;
+
+    Arena_Push();
+
+    AD = (double complex*)Arena_Alloc(sizeof(double complex)*SizeD);
+    GD = (double complex*)Arena_Alloc(sizeof(double complex)*SizeD);
+    AL = (double complex*)Arena_Alloc(sizeof(double complex)*(SizeL+1));
+    AU = (double complex*)Arena_Alloc(sizeof(double complex)*(SizeL+1));
+    GL = (double complex*)Arena_Alloc(sizeof(double complex)*(SizeL+1));
+    GU = (double complex*)Arena_Alloc(sizeof(double complex)*(SizeL+1));
+    W1 = (double complex*)Arena_Alloc(sizeof(double complex)*List_YOUSO[7]*List_YOUSO[7]);
+    dm  = (double*)Arena_Alloc(sizeof(double)*(SpinP_switch+1)*SizeH);
+    edm = (double*)Arena_Alloc(sizeof(double)*(SpinP_switch+1)*SizeH);
+
+    for (n=0; n<(SpinP_switch+1)*SizeH; n++){
+      dm[n] = 0.0;
+      edm[n] = 0.0;
+    }
+
+#pragma omp for schedule(dynamic)
+    for (t=myid; t<Ntask; t+=numprocs){
+
+      kloop = t/((SpinP_switch+1)*(Pole_Np+1));
+      spin  = (t/(Pole_Np+1))%(SpinP_switch+1);
+      p     = t%(Pole_Np+1);
+      kw    = Pole_kw[kloop];
+
+      /* poles and the moments at iR */
+
+      if (p<Pole_Np){
+        z  = mu + I*Pole_zp[p].i/Beta;
+        w  = -2.0*Pole_Rp[p].r/Beta;
+        we = w*z;
+      }
+      else {
+        z  = I*R_moment;
+        w  = 0.5*I*R_moment;
+        we = -0.5*R_moment*R_moment + I*R_moment*csum;
+      }
+
+      Factorize_Selinv(z,Pole_k1[kloop],Pole_k2[kloop],Pole_k3[kloop],
+                       Hg[spin],Sg,AD,AL,AU,GD,GL,GU,W1);
+
+      /* Herm[w G] at R: Re[w G_ij e^{-ikR} + w G_ji e^{ikR}]/2 */
+
+      for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+
+        tno1 = Tno(Gc_AN);
+
+        for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+
+          Gh_AN = natn[Gc_AN][h_AN];
+          Rn = ncn[Gc_AN][h_AN];
+          tno2 = Tno(Gh_AN);
+
+          kRn = Pole_k1[kloop]*(double)atv_ijk[Rn][1]
+              + Pole_k2[kloop]*(double)atv_ijk[Rn][2]
+              + Pole_k3[kloop]*(double)atv_ijk[Rn][3];
+          ph = cos(2.0*PI*kRn) - I*sin(2.0*PI*kRn);
+
+          G12 = Blk(Gc_AN,Gh_AN,GD,GL,GU);
+          G21 = Blk(Gh_AN,Gc_AN,GD,GL,GU);
+          k = spin*SizeH + Hoff[Gc_AN][h_AN];
+
+          for (i=0; i<tno1; i++){
+            for (j=0; j<tno2; j++){
+              g1 = G12[i*tno2+j]*ph;
+              g2 = G21[j*tno1+i]*conj(ph);
+              dm[k]  += 0.5*kw*creal(w*(g1 + g2));
+              edm[k] += 0.5*kw*creal(we*(g1 + g2));
+              k++;
+            }
+          }
+        }
+      }
+    }
+
+#pragma omp critical (Pole_DFT_critical)
+    {
+      for (spin=0; spin<=SpinP_switch; spin++){
+        for (n=0; n<SizeH; n++){
+          DMg[spin][n]  += dm[spin*SizeH+n];
+          EDMg[spin][n] += edm[spin*SizeH+n];
+        }
+      }
+    }
+
+    Arena_Pop();
+
+  } /* #pragma omp parallel */
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    MPI_Allreduce(MPI_IN_PLACE, DMg[spin], SizeH, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+    MPI_Allreduce(MPI_IN_PLACE, EDMg[spin], SizeH, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+  }
+
+  /* the number of electrons: Tr(DM S) */
+
+  if      (SpinP_switch==0) spin_degeneracy = 2.0;
+  else                      spin_degeneracy = 1.0;
+
+  Num = 0.0;
+  for (spin=0; spin<=SpinP_switch; spin++){
+    for (n=0; n<SizeH; n++) Num += spin_degeneracy*DMg[spin][n]*Sg[n];
+  }
+
+  return Num;
+}
+
+
+
+/****************************************************
+  Factorize_Selinv factorizes A = zS(k) - H(k) as
+  A = L D U, and calculates the blocks of G = A^{-1}
+  on the filled pattern:
+
+    G_{C,v} = -G_{C,C} L_{C,v}
+    G_{v,C} = -U_{v,C} G_{C,C}
+    G_{v,v} = D_v^{-1} - U_{v,C} G_{C,v}
+
+  where C is the structure of atom v.
+****************************************************/
+
+static void Factorize_Selinv(double complex z, double k1, double k2, double k3,
+                             double *Hg, double *Sg,
+                             double complex *AD, double complex *AL, double complex *AU,
+                             double complex *GD, double complex *GL, double complex *GU,
+                             double complex *W1)
+{
+  int s,v,a,b,i,j,tv,ti,tj,Gc_AN,h_AN,Gh_AN,Rn,tno1,tno2,l;
+  long int n,k;
+  double kRn;
+  double complex ph;
+  double complex *A,*Dinv,*Li,*Uj,*Lv,*Uv;
+
+  for (n=0; n<SizeD; n++) AD[n] = 0.0;
+  for (n=0; n<SizeL; n++){
+    AL[n] = 0.0;
+    AU[n] = 0.0;
+  }
+
+  /* A = zS(k) - H(k) */
+
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+
+    tno1 = Tno(Gc_AN);
+
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+
+      Gh_AN = natn[Gc_AN][h_AN];
+      Rn = ncn[Gc_AN][h_AN];
+      tno2 = Tno(Gh_AN);
+
+      kRn = k1*(double)atv_ijk[Rn][1] + k2*(double)atv_ijk[Rn][2] + k3*(double)atv_ijk[Rn][3];
+      ph = cos(2.0*PI*kRn) + I*sin(2.0*PI*kRn);
+
+      A = Blk(Gc_AN,Gh_AN,AD,AL,AU);
+      k = Hoff[Gc_AN][h_AN];
+
+      for (l=0; l<tno1*tno2; l++){
+        A[l] += (z*Sg[k+l] - Hg[k+l])*ph;
+      }
+    }
+  }
+
+  /****************************************************
+                    factorization
+  ****************************************************/
+
+  for (s=0; s<atomnum; s++){
+
+    v = Ord[s];
+    tv = Tno(v);
+
+    /* D_v^{-1} is kept in GD */
+
+    Dinv = GD + Doff[v];
+    for (l=0; l<tv*tv; l++) Dinv[l] = AD[Doff[v]+l];
+    Lapack_LU_Zinverse(tv,(dcomplex*)Dinv);
+
+    /* L_iv = A_iv D_v^{-1} */
+
+    for (a=0; a<Nstr[v]; a++){
+      ti = Tno(Str[v][a]);
+      Li = AL + Loff[v][a];
+      for (l=0; l<ti*tv; l++){
+        W1[l] = Li[l];
+        Li[l] = 0.0;
+      }
+      Add_Blk(ti,tv,tv,1.0,W1,Dinv,Li);
+    }
+
+    /* A_ij -= L_iv A_vj */
+
+    for (a=0; a<Nstr[v]; a++){
+      i = Str[v][a];
+      ti = Tno(i);
+      Li = AL + Loff[v][a];
+
+      for (b=0; b<Nstr[v]; b++){
+        j = Str[v][b];
+        tj = Tno(j);
+        Uj = AU + Loff[v][b];
+        Add_Blk(ti,tj,tv,-1.0,Li,Uj,Blk(i,j,AD,AL,AU));
+      }
+    }
+
+    /* U_vj = D_v^{-1} A_vj */
+
+    for (b=0; b<Nstr[v]; b++){
+      tj = Tno(Str[v][b]);
+      Uj = AU + Loff[v][b];
+      for (l=0; l<tv*tj; l++){
+        W1[l] = Uj[l];
+        Uj[l] = 0.0;
+      }
+      Add_Blk(tv,tj,tv,1.0,Dinv,W1,Uj);
+    }
+  }
+
+  /****************************************************
+                  selected inversion
+  ****************************************************/
+
+  for (s=atomnum-1; 0<=s; s--){
+
+    v = Ord[s];
+    tv = Tno(v);
+
+    for (a=0; a<Nstr[v]; a++){
+
+      i = Str[v][a];
+      ti = Tno(i);
+
+      Lv = GL + Loff[v][a];
+      Uv = GU + Loff[v][a];
+      for (l=0; l<ti*tv; l++){
+        Lv[l] = 0.0;
+        Uv[l] = 0.0;
+      }
+
+      for (b=0; b<Nstr[v]; b++){
+        j = Str[v][b];
+        tj = Tno(j);
+        Add_Blk(ti,tv,tj,-1.0,Blk(i,j,GD,GL,GU),AL+Loff[v][b],Lv);
+        Add_Blk(tv,ti,tj,-1.0,AU+Loff[v][b],Blk(j,i,GD,GL,GU),Uv);
+      }
+    }
+
+    for (a=0; a<Nstr[v]; a++){
+      ti = Tno(Str[v][a]);
+      Add_Blk(tv,tv,ti,-1.0,AU+Loff[v][a],GL+Loff[v][a],GD+Doff[v]);
+    }
+  }
+}
+
+
+
+/* the block (i,j) of a matrix on the filled pattern */
+
+static double complex *Blk(int i, int j, double complex *D, double complex *L, double complex *U)
+{
+  if (i==j)              return D + Doff[i];
+  else if (Pos[i]<Pos[j]) return U + Loff[i][Find_Str(i,j)];
+  else                   return L + Loff[j][Find_Str(j,i)];
+}
+
+
+
+/* C[m][n] += alpha*A[m][l]*B[l][n] in row-major order */
+
+static void Add_Blk(int m, int n, int l, double complex alpha,
+                    double complex *A, double complex *B, double complex *C)
+{
+  dcomplex al,be;
+
+  al.r = creal(alpha);
+  al.i = cimag(alpha);
+  be.r = 1.0;
+  be.i = 0.0;
+
+  F77_NAME(zgemm,ZGEMM)("N","N", &n,&m,&l, &al, (dcomplex*)B,&n, (dcomplex*)A,&l, &be, (dcomplex*)C,&n);
+}
+
+
+
+/****************************************************
+  Symbolic orders atoms by the minimum degree method
+  on the graph given by FNAN, and sets the filled
+  pattern of L and U. The layout of the gathered H
+  is also set here.
+****************************************************/
+
+static void Symbolic()
+{
+  int Gc_AN,h_AN,Gh_AN,s,v,u,a,b,c,n,dmin,tno1;
+  int *nadj,*elim,**adj,*tmp;
+
+  Sym_atomnum = atomnum;
+
+  /* layout of H */
+
+  Hoff = (long int**)malloc(sizeof(long int*)*(atomnum+1));
+  SizeH = 0;
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    Hoff[Gc_AN] = (long int*)malloc(sizeof(long int)*(FNAN[Gc_AN]+1));
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Hoff[Gc_AN][h_AN] = SizeH;
+      SizeH += Tno(Gc_AN)*Tno(natn[Gc_AN][h_AN]);
+    }
+  }
+
+  /* symmetric graph of atoms */
+
+  nadj = (int*)malloc(sizeof(int)*(atomnum+1));
+  elim = (int*)malloc(sizeof(int)*(atomnum+1));
+  adj  = (int**)malloc(sizeof(int*)*(atomnum+1));
+  tmp  = (int*)malloc(sizeof(int)*(2*atomnum+2));
+
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    nadj[Gc_AN] = FNAN[Gc_AN];
+    elim[Gc_AN] = 0;
+  }
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    for (h_AN=1; h_AN<=FNAN[Gc_AN]; h_AN++){
+      nadj[natn[Gc_AN][h_AN]]++;
+    }
+  }
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    adj[Gc_AN] = (int*)malloc(sizeof(int)*(nadj[Gc_AN]+1));
+    nadj[Gc_AN] = 0;
+  }
+
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    for (h_AN=1; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      adj[Gc_AN][nadj[Gc_AN]++] = Gh_AN;
+      adj[Gh_AN][nadj[Gh_AN]++] = Gc_AN;
+    }
+  }
+
+  /* sort and remove duplicates and self-images */
+
+  for (u=1; u<=atomnum; u++){
+    qsort_int1((long)nadj[u],adj[u]);
+    n = 0;
+    for (a=0; a<nadj[u]; a++){
+      if (adj[u][a]!=u && (n==0 || adj[u][a]!=adj[u][n-1])) adj[u][n++] = adj[u][a];
+    }
+    nadj[u] = n;
+  }
+
+  /* elimination by the minimum degree */
+
+  Ord  = (int*)malloc(sizeof(int)*(atomnum+1));
+  Pos  = (int*)malloc(sizeof(int)*(atomnum+1));
+  Nstr = (int*)malloc(sizeof(int)*(atomnum+1));
+  Str  = (int**)malloc(sizeof(int*)*(atomnum+1));
+
+  for (s=0; s<atomnum; s++){
+
+    v = 0;
+    dmin = atomnum + 1;
+    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+      if (elim[Gc_AN]==0 && nadj[Gc_AN]<dmin){
+        dmin = nadj[Gc_AN];
+        v = Gc_AN;
+      }
+    }
+
+    Ord[s] = v;
+    Pos[v] = s;
+    elim[v] = 1;
+
+    /* the neighbors of v are eliminated after v */
+
+    Nstr[v] = nadj[v];
+    Str[v] = adj[v];
+
+    /* the neighbors of v form a clique */
+
+    for (a=0; a<nadj[v]; a++){
+
+      u = adj[v][a];
+
+      b = 0; c = 0; n = 0;
+      while (b<nadj[u] || c<nadj[v]){
+        if      (c==nadj[v] || (b<nadj[u] && adj[u][b]<adj[v][c])) tmp[n++] = adj[u][b++];
+        else if (b==nadj[u] || adj[v][c]<adj[u][b])               tmp[n++] = adj[v][c++];
+        else { tmp[n++] = adj[u][b++]; c++; }
+      }
+
+      free(adj[u]);
+      adj[u] = (int*)malloc(sizeof(int)*(n+1));
+
+      nadj[u] = 0;
+      for (b=0; b<n; b++){
+        if (tmp[b]!=u && tmp[b]!=v) adj[u][nadj[u]++] = tmp[b];
+      }
+    }
+  }
+
+  /* offsets of blocks */
+
+  Doff = (long int*)malloc(sizeof(long int)*(atomnum+1));
+  Loff = (long int**)malloc(sizeof(long int*)*(atomnum+1));
+
+  SizeD = 0;
+  SizeL = 0;
+
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
+    tno1 = Tno(Gc_AN);
+    Doff[Gc_AN] = SizeD;
+    SizeD += tno1*tno1;
+    Loff[Gc_AN] = (long int*)malloc(sizeof(long int)*(Nstr[Gc_AN]+1));
+    for (a=0; a<Nstr[Gc_AN]; a++){
+      Loff[Gc_AN][a] = SizeL;
+      SizeL += tno1*Tno(Str[Gc_AN][a]);
+    }
+  }
+
+  if (2<=level_stdout){
+    n = 0;
+    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++) n += Nstr[Gc_AN];
+    MPI_Comm_rank(mpi_comm_level1,&a);
+    if (a==Host_ID){
+      printf("<Pole_DFT> # of filled atom blocks in L = %d (%8.3f per atom)\n",
+             n,(double)n/(double)atomnum);
+    }
+  }
+
+  free(tmp);
+  free(adj);
+  free(elim);
+  free(nadj);
+}
+
+
+
+static void Free_Symbolic()
+{
+  int Gc_AN;
+
+  for (Gc_AN=1; Gc_AN<=Sym_atomnum; Gc_AN++){
+    free(Loff[Gc_AN]);
+    free(Str[Gc_AN]);
+    free(Hoff[Gc_AN]);
+  }
+  free(Loff);
+  free(Doff);
+  free(Str);
+  free(Nstr);
+  free(Pos);
+  free(Ord);
+  free(Hoff);
+
+  free(Pole_k1);
+  free(Pole_k2);
+  free(Pole_k3);
+  free(Pole_kw);
+}
+
+
+
+/****************************************************
+  Set_Kpoints sets the k-points in the same way as
+  Band_DFT_Col, where only one of k and -k is used
+  with the weight of two by the time reversal symmetry.
+****************************************************/
+
+static void Set_Kpoints()
+{
+  int i,j,k,n,ii,ij,ik,N;
+  double k1,k2,k3;
+
+  N = Kspace_grid1*Kspace_grid2*Kspace_grid3;
+
+  Pole_k1 = (double*)malloc(sizeof(double)*N);
+  Pole_k2 = (double*)malloc(sizeof(double)*N);
+  Pole_k3 = (double*)malloc(sizeof(double)*N);
+  Pole_kw = (double*)malloc(sizeof(double)*N);
+
+  n = 0;
+
+  for (i=0; i<Kspace_grid1; i++){
+
+    if (Kspace_grid1==1) k1 = 0.0;
+    else                 k1 = -0.5 + (2.0*(double)i+1.0)/(2.0*(double)Kspace_grid1) + Shift_K_Point;
+
+    for (j=0; j<Kspace_grid2; j++){
+
+      if (Kspace_grid2==1) k2 = 0.0;
+      else                 k2 = -0.5 + (2.0*(double)j+1.0)/(2.0*(double)Kspace_grid2) - Shift_K_Point;
+
+      for (k=0; k<Kspace_grid3; k++){
+
+        if (Kspace_grid3==1) k3 = 0.0;
+        else                 k3 = -0.5 + (2.0*(double)k+1.0)/(2.0*(double)Kspace_grid3) + 2.0*Shift_K_Point;
+
+        ii = Kspace_grid1 - 1 - i;
+        ij = Kspace_grid2 - 1 - j;
+        ik = Kspace_grid3 - 1 - k;
+
+        if ( ii*Kspace_grid2*Kspace_grid3 + ij*Kspace_grid3 + ik
+            < i*Kspace_grid2*Kspace_grid3 + j*Kspace_grid3 + k ) continue;
+
+        Pole_k1[n] = k1;
+        Pole_k2[n] = k2;
+        Pole_k3[n] = k3;
+
+        if (ii!=i || ij!=j || ik!=k) Pole_kw[n] = 2.0/(double)N;
+        else                         Pole_kw[n] = 1.0/(double)N;
+
+        n++;
+      }
+    }
+  }
+
+  Pole_Nk = n;
+}
+
+
+
+/* index of atom G in the structure of v */
+
+static int Find_Str(int v, int G)
+{
+  int lo,hi,k;
+
+  lo = 0;
+  hi = Nstr[v] - 1;
+
+  while (lo<=hi){
+    k = (lo + hi)/2;
+    if      (Str[v][k]==G) return k;
+    else if (Str[v][k]<G)  lo = k + 1;
+    else                   hi = k - 1;
+  }
+
+  return -1;
+}
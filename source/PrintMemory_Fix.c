@@ -7,6 +7,7 @@
   Log of PrintMemory_Fix.c:
 
      24/May/2003  Released by T.Ozaki
+     18/Oct/2026  sizes per process of node-shared tables
 
 ***********************************************************************/
 
@@ -36,10 +37,10 @@ void PrintMemory_Fix()
   PrintMemory("SetPara_DFT: Spe_PAO_XV",sizeof(double)*ASIZE18*ASIZE21,NULL);
   PrintMemory("SetPara_DFT: Spe_PAO_RV",sizeof(double)*ASIZE18*ASIZE21,NULL);
   PrintMemory("SetPara_DFT: Spe_Atomic_Den",sizeof(double)*ASIZE18*ASIZE21,NULL);
-  PrintMemory("SetPara_DFT: Spe_PAO_RWF",sizeof(double)*ASIZE18*(ASIZE25+1)*
-                                                        ASIZE24*ASIZE21,NULL);
-  PrintMemory("SetPara_DFT: Spe_RF_Bessel",sizeof(double)*ASIZE18*(ASIZE25+1)*
-                                                          ASIZE24*ASIZE15,NULL);
+  Shm_PrintMemory("SetPara_DFT: Spe_PAO_RWF",Spe_PAO_RWF,
+                  sizeof(double)*ASIZE18*(ASIZE25+1)*ASIZE24*ASIZE21);
+  Shm_PrintMemory("SetPara_DFT: Spe_RF_Bessel",Spe_RF_Bessel,
+                  sizeof(double)*ASIZE18*(ASIZE25+1)*ASIZE24*ASIZE15);
 
   /****************************************************
     PrintMemory 
@@ -51,11 +52,18 @@ void PrintMemory_Fix()
   PrintMemory("SetPara_DFT: Spe_Vna",sizeof(double)*ASIZE18*ASIZE22,NULL);
   PrintMemory("SetPara_DFT: Spe_VH_Atom",sizeof(double)*ASIZE18*ASIZE22,NULL);
   PrintMemory("SetPara_DFT: Spe_Atomic_PCC",sizeof(double)*ASIZE18*ASIZE22,NULL);
-  PrintMemory("SetPara_DFT: Spe_VNL",sizeof(double)*ASIZE18*ASIZE19*ASIZE22,NULL);
+  Shm_PrintMemory("SetPara_DFT: Spe_VNL",Spe_VNL,sizeof(double)*ASIZE18*ASIZE19*ASIZE22);
   PrintMemory("SetPara_DFT: Spe_VNLE",sizeof(double)*ASIZE18*ASIZE19,NULL);
   PrintMemory("SetPara_DFT: Spe_VPS_List",sizeof(double)*ASIZE18*ASIZE19,NULL);
-  PrintMemory("SetPara_DFT: Spe_NLRF_Bessel",sizeof(double)*ASIZE18*(ASIZE19+2)*
-                                                            ASIZE15,NULL);
+  Shm_PrintMemory("SetPara_DFT: Spe_NLRF_Bessel",Spe_NLRF_Bessel,
+                  sizeof(double)*ASIZE18*(ASIZE19+2)*ASIZE15);
+
+  if (ProExpn_VNA==1){
+    Shm_PrintMemory("SetPara_DFT: Projector_VNA",Projector_VNA,
+                    sizeof(double)*ASIZE18*(List_YOUSO[35]+1)*List_YOUSO[34]*ASIZE22);
+    Shm_PrintMemory("SetPara_DFT: Spe_VNA_Bessel",Spe_VNA_Bessel,
+                    sizeof(double)*ASIZE18*(List_YOUSO[35]+1)*List_YOUSO[34]*(GL_Mesh+2));
+  }
 
   /* allocated in SetPara_DFT.c */
 
@@ -0,0 +1,1120 @@
+/**********************************************************************
+  Purify.c:
+
+     Purify.c is a subroutine to calculate the density matrix by the
+     density matrix purification, which is a linear-scaling method
+     without the diagonalization of clusters.
+
+     The Hamiltonian and overlap matrices are summed over the periodic
+     images, i.e., the calculation is performed at the gamma point,
+     and they are stored as block-sparse matrices, where a block is
+     given by a pair of atoms, and the block rows are distributed to
+     the processes in the same way as atoms (Matomnum, M2G). The
+     product of matrices is calculated only for pairs of non-zero
+     blocks, and blocks whose Frobenius norm is smaller than
+     orderN.Purify.Threshold are dropped from the product.
+
+       1. Z = S^{-1/2} by the Newton-Schulz iteration at the first
+          SCF step of each MD step
+       2. H' = Z H Z
+       3. P' = theta(ChemP - H') by the grand canonical McWeeny
+          purification, where ChemP is searched by the bisection so
+          that the number of electrons is conserved
+       4. DM = Z P' Z and EDM = Z P' H' P' Z
+
+     Since the purification gives the idempotent density matrix, the
+     electronic temperature is not taken into account. The method is
+     suitable for systems with a band gap.
+
+     Purify_Free frees Z kept over the SCF steps.
+
+  Log of Purify.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "mpi.h"
+#include <omp.h>
+
+#define Tno(G)  Spe_Total_CNO[WhatSpecies[G]]
+
+/* a block row of a block-sparse matrix */
+
+typedef struct {
+  int n;          /* # of non-zero blocks */
+  int *col;       /* global atom numbers of the blocks in ascending order */
+  int *off;       /* val+off[k] is the k-th block, off[n] is the size of val */
+  double *val;    /* blocks of Tno(row) x Tno(col[k]) in row-major order */
+} Purify_Row;
+
+static int *G2M_loc;   /* Gc_AN -> Mc_AN for the atoms in the process */
+static int Norb;       /* total # of orbitals */
+static Purify_Row *Z = NULL;   /* S^{-1/2} kept over the SCF steps */
+
+static double Purify_Col(char *mode,
+                         int SCF_iter,
+                         double *****Hks,
+                         double ****OLP0,
+                         double *****CDM,
+                         double *****EDM,
+                         double Eele0[2], double Eele1[2]);
+static Purify_Row *Inverse_Sqrt(Purify_Row *S);
+static Purify_Row *McWeeny(Purify_Row *H, double mu, double emin, double emax, int *iter);
+
+static Purify_Row *Mat_Alloc();
+static void Mat_Free(Purify_Row *A);
+static Purify_Row *Mat_From_OpenMX(double ****M);
+static void Mat_To_OpenMX(Purify_Row *A, double ****M);
+static Purify_Row *Mat_Identity();
+static Purify_Row *Mat_Add(double alpha, Purify_Row *A, double beta, Purify_Row *B);
+static Purify_Row *Mat_Mult(Purify_Row *A, Purify_Row *B);
+static Purify_Row *Fetch_Rows(Purify_Row *A, Purify_Row *B, int **ibuf, int **obuf, double **dbuf);
+static double Mat_Trace(Purify_Row *A);
+static double Mat_Dot(Purify_Row *A, Purify_Row *B);
+static void Mat_Gershgorin(Purify_Row *A, double *emin, double *emax);
+static int Find_Col(Purify_Row *r, int G);
+
+
+
+double Purify(char *mode,
+              int SCF_iter,
+              double *****Hks,
+              double *****ImNL,
+              double ****OLP0,
+              double *****CDM,
+              double *****EDM,
+              double Eele0[2], double Eele1[2])
+{
+  double time0;
+
+  time0 = 0.0;
+
+  /****************************************************
+         collinear without spin-orbit coupling
+  ****************************************************/
+
+  if ( (SpinP_switch==0 || SpinP_switch==1) && SO_switch==0 ){
+    time0 = Purify_Col(mode,SCF_iter, Hks, OLP0, CDM, EDM, Eele0, Eele1);
+  }
+
+  /****************************************************
+         collinear with spin-orbit coupling
+  ****************************************************/
+
+  else if ( (SpinP_switch==0 || SpinP_switch==1) && SO_switch==1 ){
+    printf("Spin-orbit coupling is not supported for collinear DFT calculations.\n");
+    MPI_Finalize();
+    exit(1);
+  }
+
+  /****************************************************
+   non-collinear with and without spin-orbit coupling
+  ****************************************************/
+
+  else if (SpinP_switch==3){
+    printf("The purification method is not supported for non-collinear DFT calculations.\n");
+    MPI_Finalize();
+    exit(1);
+  }
+
+  return time0;
+}
+
+
+
+
+static double Purify_Col(char *mode,
+                         int SCF_iter,
+                         double *****Hks,
+                         double ****OLP0,
+                         double *****CDM,
+                         double *****EDM,
+                         double Eele0[2], double Eele1[2])
+{
+  Purify_Row *S,*H,*T,*T2,*D,*Ho[2],*P[2];
+  int Mc_AN,Gc_AN,h_AN,Gh_AN,tno1,tno2,i,j,spin;
+  int myid,loopN,po,iter,num_iter;
+  double My_TZ,TZ,Ne,Num,Dnum,spin_degeneracy;
+  double mu,mu_min,mu_max,emin,emax,emin1,emax1;
+  double My_Eele1[2];
+  double TStime,TEtime;
+
+  if (strcasecmp(mode,"scf")!=0) return 0.0;
+
+  dtime(&TStime);
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* conversion from Gc_AN to Mc_AN */
+
+  G2M_loc = (int*)malloc(sizeof(int)*(atomnum+1));
+  for (Gc_AN=0; Gc_AN<=atomnum; Gc_AN++) G2M_loc[Gc_AN] = 0;
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++) G2M_loc[M2G[Mc_AN]] = Mc_AN;
+
+  Norb = 0;
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++) Norb += Tno(Gc_AN);
+
+  /* the number of electrons */
+
+  My_TZ = 0.0;
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    My_TZ += Spe_Core_Charge[WhatSpecies[Gc_AN]];
+  }
+  MPI_Allreduce(&My_TZ, &TZ, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+  Ne = TZ - system_charge;
+
+  if      (SpinP_switch==0) spin_degeneracy = 2.0;
+  else                      spin_degeneracy = 1.0;
+
+  /****************************************************
+       Z = S^{-1/2}, calculated once in each MD step
+  ****************************************************/
+
+  if (SCF_iter==1 || Z==NULL){
+
+    if (Z!=NULL) Mat_Free(Z);
+
+    S = Mat_From_OpenMX(OLP0);
+    Z = Inverse_Sqrt(S);
+    Mat_Free(S);
+  }
+
+  /****************************************************
+                      H' = Z H Z
+  ****************************************************/
+
+  emin = 1.0e+100;
+  emax =-1.0e+100;
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+
+    H = Mat_From_OpenMX(Hks[spin]);
+    T = Mat_Mult(Z,H);
+    Ho[spin] = Mat_Mult(T,Z);
+    Mat_Free(T);
+    Mat_Free(H);
+
+    Mat_Gershgorin(Ho[spin],&emin1,&emax1);
+    if (emin1<emin) emin = emin1;
+    if (emax<emax1) emax = emax1;
+  }
+
+  /****************************************************
+     search of the chemical potential by bisection,
+     started from ChemP of the previous SCF step
+  ****************************************************/
+
+  mu_min = emin;
+  mu_max = emax;
+
+  if (SCF_iter==1 || ChemP<=emin || emax<=ChemP) mu = 0.5*(emin + emax);
+  else                                            mu = ChemP;
+
+  for (spin=0; spin<=SpinP_switch; spin++) P[spin] = NULL;
+
+  po = 0;
+  loopN = 0;
+
+  do {
+
+    Num = 0.0;
+    num_iter = 0;
+
+    for (spin=0; spin<=SpinP_switch; spin++){
+      if (P[spin]!=NULL) Mat_Free(P[spin]);
+      P[spin] = McWeeny(Ho[spin],mu,emin,emax,&iter);
+      Num += spin_degeneracy*Mat_Trace(P[spin]);
+      num_iter += iter;
+    }
+
+    Dnum = Ne - Num;
+
+    if (myid==Host_ID && 2<=level_stdout){
+      printf("<Purify> ChemP=%15.12f Ne=%15.12f Num_state=%15.12f  McWeeny iter=%3d\n",
+             mu,Ne,Num,num_iter);
+    }
+
+    if (fabs(Dnum)<1.0e-8*TZ || (mu_max-mu_min)<1.0e-10) po = 1;
+    else {
+      if (0.0<Dnum) mu_min = mu;
+      else          mu_max = mu;
+      mu = 0.5*(mu_min + mu_max);
+    }
+
+    loopN++;
+
+  } while (po==0 && loopN<=100);
+
+  ChemP = mu;
+
+  /****************************************************
+           DM = Z P' Z and EDM = Z P' H' P' Z
+  ****************************************************/
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+
+    T = Mat_Mult(Z,P[spin]);
+    D = Mat_Mult(T,Z);
+    Mat_To_OpenMX(D,CDM[spin]);
+    Mat_Free(D);
+    Mat_Free(T);
+
+    T = Mat_Mult(Ho[spin],P[spin]);
+    T2 = Mat_Mult(P[spin],T);
+    Mat_Free(T);
+    T = Mat_Mult(Z,T2);
+    D = Mat_Mult(T,Z);
+    Mat_To_OpenMX(D,EDM[spin]);
+    Mat_Free(D);
+    Mat_Free(T);
+    Mat_Free(T2);
+
+    Mat_Free(P[spin]);
+    Mat_Free(Ho[spin]);
+  }
+
+  /****************************************************
+                     bond energies
+  ****************************************************/
+
+  My_Eele1[0] = 0.0;
+  My_Eele1[1] = 0.0;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      tno2 = Tno(Gh_AN);
+
+      for (spin=0; spin<=SpinP_switch; spin++){
+        for (i=0; i<tno1; i++){
+          for (j=0; j<tno2; j++){
+            My_Eele1[spin] += CDM[spin][Mc_AN][h_AN][i][j]*Hks[spin][Mc_AN][h_AN][i][j];
+          }
+        }
+      }
+    }
+  }
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+    MPI_Allreduce(&My_Eele1[spin], &Eele1[spin], 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+    Eele0[spin] = Eele1[spin];
+  }
+
+  if (SpinP_switch==0){
+    Eele0[1] = Eele0[0];
+    Eele1[1] = Eele1[0];
+  }
+
+  if (3<=level_stdout && myid==Host_ID){
+    printf("Eele00=%15.12f Eele01=%15.12f\n",Eele0[0],Eele0[1]);
+    printf("Eele10=%15.12f Eele11=%15.12f\n",Eele1[0],Eele1[1]);
+  }
+
+  free(G2M_loc);
+
+  dtime(&TEtime);
+  return TEtime - TStime;
+}
+
+
+
+void Purify_Free()
+{
+  if (Z!=NULL) Mat_Free(Z);
+  Z = NULL;
+}
+
+
+
+/****************************************************
+  Inverse_Sqrt calculates S^{-1/2} by the coupled
+  Newton-Schulz iteration:
+    Y0 = S/lmax, Z0 = I,
+    T = (3I - Z Y)/2, Y <- Y T, Z <- T Z,
+  where lmax is the upper bound of the spectrum of S.
+****************************************************/
+
+static Purify_Row *Inverse_Sqrt(Purify_Row *S)
+{
+  int iter,myid;
+  double emin,emax,err;
+  Purify_Row *I,*Y,*Z,*ZY,*T,*R,*Y1,*Z1;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  Mat_Gershgorin(S,&emin,&emax);
+
+  I = Mat_Identity();
+  Y = Mat_Add(1.0/emax,S,0.0,I);
+  Z = Mat_Identity();
+
+  iter = 0;
+
+  do {
+
+    ZY = Mat_Mult(Z,Y);
+
+    R = Mat_Add(-1.0,ZY,1.0,I);
+    err = Mat_Dot(R,R)/(double)Norb;
+    Mat_Free(R);
+
+    if (myid==Host_ID && 2<=level_stdout){
+      printf("<Purify> S^{-1/2} iter=%3d  err=%15.12e\n",iter,err);
+    }
+
+    if (err<Purify_Criterion || Purify_MaxIter<=iter){
+      Mat_Free(ZY);
+      break;
+    }
+
+    T = Mat_Add(-0.5,ZY,1.5,I);
+    Mat_Free(ZY);
+
+    Y1 = Mat_Mult(Y,T);
+    Z1 = Mat_Mult(T,Z);
+    Mat_Free(T);
+    Mat_Free(Y);
+    Mat_Free(Z);
+    Y = Y1;
+    Z = Z1;
+
+    iter++;
+
+  } while (1);
+
+  if (Purify_Criterion<=err && myid==Host_ID && 0<level_stdout){
+    printf("<Purify> S^{-1/2} is not converged, err=%15.12e\n",err);
+  }
+
+  /* S^{-1/2} = Z/sqrt(lmax) */
+
+  Z1 = Mat_Add(1.0/sqrt(emax),Z,0.0,I);
+
+  Mat_Free(Z);
+  Mat_Free(Y);
+  Mat_Free(I);
+
+  return Z1;
+}
+
+
+
+/****************************************************
+  McWeeny gives theta(mu - H) by the grand canonical
+  purification:
+    P0 = I/2 - (H - mu I)/(2 max(emax-mu, mu-emin)),
+    P <- 3P^2 - 2P^3
+****************************************************/
+
+static Purify_Row *McWeeny(Purify_Row *H, double mu, double emin, double emax, int *iter)
+{
+  double s,err,err0,tr1,tr2;
+  Purify_Row *I,*P,*P2,*P3;
+
+  s = emax - mu;
+  if (s<(mu-emin)) s = mu - emin;
+  s = 0.5/s;
+
+  I = Mat_Identity();
+  P = Mat_Add(-s,H,0.5+mu*s,I);
+  Mat_Free(I);
+
+  err0 = 1.0e+100;
+  *iter = 0;
+
+  while (*iter<Purify_MaxIter){
+
+    P2 = Mat_Mult(P,P);
+
+    tr1 = Mat_Trace(P);
+    tr2 = Mat_Trace(P2);
+    err = fabs(tr1 - tr2)/(double)Norb;
+
+    /* stop if converged, or the error does not decrease due to the threshold */
+
+    if (err<Purify_Criterion || (10<*iter && err0<=err)){
+      Mat_Free(P2);
+      break;
+    }
+
+    P3 = Mat_Mult(P2,P);
+    Mat_Free(P);
+    P = Mat_Add(3.0,P2,-2.0,P3);
+    Mat_Free(P3);
+    Mat_Free(P2);
+
+    err0 = err;
+    (*iter)++;
+  }
+
+  return P;
+}
+
+
+
+static Purify_Row *Mat_Alloc()
+{
+  int Mc_AN;
+  Purify_Row *A;
+
+  A = (Purify_Row*)malloc(sizeof(Purify_Row)*(Matomnum+1));
+  for (Mc_AN=0; Mc_AN<=Matomnum; Mc_AN++){
+    A[Mc_AN].n = 0;
+    A[Mc_AN].col = NULL;
+    A[Mc_AN].off = NULL;
+    A[Mc_AN].val = NULL;
+  }
+
+  /* the number of rows is kept, since Matomnum changes at each MD step */
+
+  A[0].n = Matomnum;
+
+  return A;
+}
+
+
+
+static void Mat_Free(Purify_Row *A)
+{
+  int Mc_AN;
+
+  for (Mc_AN=1; Mc_AN<=A[0].n; Mc_AN++){
+    if (A[Mc_AN].col!=NULL) free(A[Mc_AN].col);
+    if (A[Mc_AN].off!=NULL) free(A[Mc_AN].off);
+    if (A[Mc_AN].val!=NULL) free(A[Mc_AN].val);
+  }
+  free(A);
+}
+
+
+
+/* allocation of a row with n blocks given by col */
+
+static void Row_Alloc(Purify_Row *r, int tno1, int n, int *col)
+{
+  int k;
+
+  r->n = n;
+  r->col = (int*)malloc(sizeof(int)*(n+1));
+  r->off = (int*)malloc(sizeof(int)*(n+1));
+
+  r->off[0] = 0;
+  for (k=0; k<n; k++){
+    r->col[k] = col[k];
+    r->off[k+1] = r->off[k] + tno1*Tno(col[k]);
+  }
+
+  r->val = (double*)malloc(sizeof(double)*(r->off[n]+1));
+  for (k=0; k<r->off[n]; k++) r->val[k] = 0.0;
+}
+
+
+
+/****************************************************
+  Mat_From_OpenMX converts M[Mc_AN][h_AN][i][j] to
+  the block-sparse matrix, where the blocks of the
+  periodic images of an atom are summed up.
+****************************************************/
+
+static Purify_Row *Mat_From_OpenMX(double ****M)
+{
+  int Mc_AN,Gc_AN,h_AN,Gh_AN,tno1,tno2,i,j,k,n;
+  int *col,*idx;
+  double *v;
+  Purify_Row *A;
+
+  A = Mat_Alloc();
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+
+    col = (int*)malloc(sizeof(int)*(FNAN[Gc_AN]+2));
+    idx = (int*)malloc(sizeof(int)*(FNAN[Gc_AN]+2));
+
+    n = 0;
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      for (k=1; k<=n; k++){
+        if (col[k]==Gh_AN) break;
+      }
+      if (n<k){
+        n++;
+        col[n] = Gh_AN;
+        idx[n] = n;
+      }
+    }
+
+    qsort_int((long)n,col,idx);
+
+    Row_Alloc(&A[Mc_AN],tno1,n,&col[1]);
+
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+      Gh_AN = natn[Gc_AN][h_AN];
+      tno2 = Tno(Gh_AN);
+      k = Find_Col(&A[Mc_AN],Gh_AN);
+      v = A[Mc_AN].val + A[Mc_AN].off[k];
+
+      for (i=0; i<tno1; i++){
+        for (j=0; j<tno2; j++){
+          v[i*tno2+j] += M[Mc_AN][h_AN][i][j];
+        }
+      }
+    }
+
+    free(idx);
+    free(col);
+  }
+
+  return A;
+}
+
+
+
+/* the block of A is stored to all the periodic images */
+
+static void Mat_To_OpenMX(Purify_Row *A, double ****M)
+{
+  int Mc_AN,Gc_AN,h_AN,Gh_AN,tno1,tno2,i,j,k;
+  double *v;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+
+    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
+
+      Gh_AN = natn[Gc_AN][h_AN];
+      tno2 = Tno(Gh_AN);
+      k = Find_Col(&A[Mc_AN],Gh_AN);
+
+      if (k<0){
+        for (i=0; i<tno1; i++){
+          for (j=0; j<tno2; j++){
+            M[Mc_AN][h_AN][i][j] = 0.0;
+          }
+        }
+      }
+      else {
+        v = A[Mc_AN].val + A[Mc_AN].off[k];
+        for (i=0; i<tno1; i++){
+          for (j=0; j<tno2; j++){
+            M[Mc_AN][h_AN][i][j] = v[i*tno2+j];
+          }
+        }
+      }
+    }
+  }
+}
+
+
+
+static Purify_Row *Mat_Identity()
+{
+  int Mc_AN,Gc_AN,tno1,i;
+  Purify_Row *A;
+
+  A = Mat_Alloc();
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+    Row_Alloc(&A[Mc_AN],tno1,1,&Gc_AN);
+    for (i=0; i<tno1; i++) A[Mc_AN].val[i*tno1+i] = 1.0;
+  }
+
+  return A;
+}
+
+
+
+/* alpha*A + beta*B */
+
+static Purify_Row *Mat_Add(double alpha, Purify_Row *A, double beta, Purify_Row *B)
+{
+  int Mc_AN,Gc_AN,tno1,n,ka,kb,k,l,len;
+  int *col;
+  double *v;
+  Purify_Row *C,*a,*b;
+
+  C = Mat_Alloc();
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+    a = &A[Mc_AN];
+    b = &B[Mc_AN];
+
+    /* union of the blocks */
+
+    col = (int*)malloc(sizeof(int)*(a->n+b->n+1));
+
+    n = 0; ka = 0; kb = 0;
+    while (ka<a->n || kb<b->n){
+      if      (kb==b->n || (ka<a->n && a->col[ka]<b->col[kb])) col[n++] = a->col[ka++];
+      else if (ka==a->n || b->col[kb]<a->col[ka])              col[n++] = b->col[kb++];
+      else { col[n++] = a->col[ka++]; kb++; }
+    }
+
+    Row_Alloc(&C[Mc_AN],tno1,n,col);
+
+    for (k=0; k<a->n; k++){
+      v = C[Mc_AN].val + C[Mc_AN].off[Find_Col(&C[Mc_AN],a->col[k])];
+      len = a->off[k+1] - a->off[k];
+      for (l=0; l<len; l++) v[l] += alpha*a->val[a->off[k]+l];
+    }
+
+    for (k=0; k<b->n; k++){
+      v = C[Mc_AN].val + C[Mc_AN].off[Find_Col(&C[Mc_AN],b->col[k])];
+      len = b->off[k+1] - b->off[k];
+      for (l=0; l<len; l++) v[l] += beta*b->val[b->off[k]+l];
+    }
+
+    free(col);
+  }
+
+  return C;
+}
+
+
+
+/****************************************************
+  Mat_Mult calculates A*B. The block rows of B which
+  are needed in the process are gathered first, and
+  then each block row of A*B is calculated by a thread.
+****************************************************/
+
+static Purify_Row *Mat_Mult(Purify_Row *A, Purify_Row *B)
+{
+  int *ibuf,*obuf;
+  double *dbuf,thr2;
+  Purify_Row *C,*tab;
+
+  tab = Fetch_Rows(A,B,&ibuf,&obuf,&dbuf);
+  C = Mat_Alloc();
+  thr2 = Purify_Threshold*Purify_Threshold;
+
+#pragma omp parallel shared(A,C,tab,thr2,Matomnum,M2G,atomnum,WhatSpecies,Spe_Total_CNO)
+  {
+    int Mc_AN,Gi,Gk,Gj,tno1,tno2,tno3,k,l,q,nc,m,len,a,b,c;
+    int *pos,*scol,*sidx,*soff,*keep;
+    double x,sum;
+    double *acc,*Ap,*Bp,*Cp;
+    Purify_Row *r;
+
+    Arena_Push();
+
+    pos = (int*)Arena_Alloc(sizeof(int)*(atomnum+1));
+    for (k=0; k<=atomnum; k++) pos[k] = -1;
+
+#pragma omp for schedule(dynamic)
+    for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+      Gi = M2G[Mc_AN];
+      tno1 = Tno(Gi);
+
+      m = 0;
+      for (k=0; k<A[Mc_AN].n; k++) m += tab[A[Mc_AN].col[k]].n;
+
+      Arena_Push();
+
+      scol = (int*)Arena_Alloc(sizeof(int)*(m+1));
+      sidx = (int*)Arena_Alloc(sizeof(int)*(m+1));
+      soff = (int*)Arena_Alloc(sizeof(int)*(m+1));
+      keep = (int*)Arena_Alloc(sizeof(int)*(m+1));
+
+      /* blocks of the row */
+
+      nc = 0;
+      len = 0;
+
+      for (k=0; k<A[Mc_AN].n; k++){
+        r = &tab[A[Mc_AN].col[k]];
+        for (l=0; l<r->n; l++){
+          Gj = r->col[l];
+          if (pos[Gj]<0){
+            nc++;
+            pos[Gj] = nc;
+            scol[nc] = Gj;
+            sidx[nc] = nc;
+            soff[nc] = len;
+            len += tno1*Tno(Gj);
+          }
+        }
+      }
+
+      acc = (double*)Arena_Alloc(sizeof(double)*(len+1));
+      for (q=0; q<len; q++) acc[q] = 0.0;
+
+      /* C_ij += A_ik B_kj */
+
+      for (k=0; k<A[Mc_AN].n; k++){
+
+        Gk = A[Mc_AN].col[k];
+        tno2 = Tno(Gk);
+        Ap = A[Mc_AN].val + A[Mc_AN].off[k];
+        r = &tab[Gk];
+
+        for (l=0; l<r->n; l++){
+
+          Gj = r->col[l];
+          tno3 = Tno(Gj);
+          Bp = r->val + r->off[l];
+          Cp = acc + soff[pos[Gj]];
+
+          for (a=0; a<tno1; a++){
+            for (b=0; b<tno2; b++){
+              x = Ap[a*tno2+b];
+              if (x==0.0) continue;
+              for (c=0; c<tno3; c++){
+                Cp[a*tno3+c] += x*Bp[b*tno3+c];
+              }
+            }
+          }
+        }
+      }
+
+      for (q=1; q<=nc; q++) pos[scol[q]] = -1;
+
+      qsort_int((long)nc,scol,sidx);
+
+      /* small blocks are dropped except for the diagonal one */
+
+      m = 0;
+      for (q=1; q<=nc; q++){
+
+        Cp = acc + soff[sidx[q]];
+        tno3 = tno1*Tno(scol[q]);
+
+        sum = 0.0;
+        for (c=0; c<tno3; c++) sum += Cp[c]*Cp[c];
+
+        if (scol[q]==Gi || thr2<=sum){
+          m++;
+          scol[m] = scol[q];
+          keep[m] = sidx[q];
+        }
+      }
+
+      Row_Alloc(&C[Mc_AN],tno1,m,&scol[1]);
+
+      for (q=1; q<=m; q++){
+        Cp = acc + soff[keep[q]];
+        len = C[Mc_AN].off[q] - C[Mc_AN].off[q-1];
+        for (c=0; c<len; c++) C[Mc_AN].val[C[Mc_AN].off[q-1]+c] = Cp[c];
+      }
+
+      Arena_Pop();
+    }
+
+    Arena_Pop();
+
+  } /* #pragma omp parallel */
+
+  free(tab);
+  free(ibuf);
+  free(obuf);
+  free(dbuf);
+
+  return C;
+}
+
+
+
+/****************************************************
+  Fetch_Rows returns a table of the block rows of B
+  indexed by Gc_AN, which contains the rows in the
+  process and the rows in the other processes needed
+  for A*B. The latter are received into ibuf, obuf,
+  and dbuf.
+****************************************************/
+
+static Purify_Row *Fetch_Rows(Purify_Row *A, Purify_Row *B, int **ibuf, int **obuf, double **dbuf)
+{
+  int numprocs,myid,ID,Mc_AN,Gk,k,p,n,ni,no,nd;
+  int *need,*scnt,*rcnt,*sdsp,*rdsp,*req,*ask;
+  int *sni,*rni,*sdi,*rdi,*snd,*rnd,*sdd,*rdd,*sbi;
+  double *sbd;
+  Purify_Row *tab,*r;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  tab = (Purify_Row*)malloc(sizeof(Purify_Row)*(atomnum+1));
+  for (Gk=0; Gk<=atomnum; Gk++){
+    tab[Gk].n = 0;
+    tab[Gk].col = NULL;
+    tab[Gk].off = NULL;
+    tab[Gk].val = NULL;
+  }
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++) tab[M2G[Mc_AN]] = B[Mc_AN];
+
+  /* rows needed */
+
+  need = (int*)malloc(sizeof(int)*(atomnum+1));
+  for (Gk=0; Gk<=atomnum; Gk++) need[Gk] = 0;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    for (k=0; k<A[Mc_AN].n; k++){
+      Gk = A[Mc_AN].col[k];
+      if (G2ID[Gk]!=myid) need[Gk] = 1;
+    }
+  }
+
+  scnt = (int*)malloc(sizeof(int)*numprocs*12);
+  rcnt = scnt + numprocs;
+  sdsp = scnt + 2*numprocs;
+  rdsp = scnt + 3*numprocs;
+  sni  = scnt + 4*numprocs;
+  rni  = scnt + 5*numprocs;
+  sdi  = scnt + 6*numprocs;
+  rdi  = scnt + 7*numprocs;
+  snd  = scnt + 8*numprocs;
+  rnd  = scnt + 9*numprocs;
+  sdd  = scnt + 10*numprocs;
+  rdd  = scnt + 11*numprocs;
+
+  for (ID=0; ID<numprocs; ID++) scnt[ID] = 0;
+  for (Gk=1; Gk<=atomnum; Gk++){
+    if (need[Gk]) scnt[G2ID[Gk]]++;
+  }
+
+  sdsp[0] = 0;
+  for (ID=1; ID<numprocs; ID++) sdsp[ID] = sdsp[ID-1] + scnt[ID-1];
+
+  req = (int*)malloc(sizeof(int)*(sdsp[numprocs-1]+scnt[numprocs-1]+1));
+
+  for (ID=0; ID<numprocs; ID++) sni[ID] = sdsp[ID];
+  for (Gk=1; Gk<=atomnum; Gk++){
+    if (need[Gk]) req[sni[G2ID[Gk]]++] = Gk;
+  }
+
+  /* requests */
+
+  MPI_Alltoall(scnt, 1, MPI_INT, rcnt, 1, MPI_INT, mpi_comm_level1);
+
+  rdsp[0] = 0;
+  for (ID=1; ID<numprocs; ID++) rdsp[ID] = rdsp[ID-1] + rcnt[ID-1];
+
+  ask = (int*)malloc(sizeof(int)*(rdsp[numprocs-1]+rcnt[numprocs-1]+1));
+
+  MPI_Alltoallv(req, scnt, sdsp, MPI_INT, ask, rcnt, rdsp, MPI_INT, mpi_comm_level1);
+
+  /* rows asked by the other processes: n, col[n], and val */
+
+  for (ID=0; ID<numprocs; ID++){
+    sni[ID] = 0;
+    snd[ID] = 0;
+    for (p=rdsp[ID]; p<(rdsp[ID]+rcnt[ID]); p++){
+      r = &B[G2M_loc[ask[p]]];
+      sni[ID] += 1 + r->n;
+      snd[ID] += r->off[r->n];
+    }
+  }
+
+  sdi[0] = 0;
+  sdd[0] = 0;
+  for (ID=1; ID<numprocs; ID++){
+    sdi[ID] = sdi[ID-1] + sni[ID-1];
+    sdd[ID] = sdd[ID-1] + snd[ID-1];
+  }
+
+  sbi = (int*)malloc(sizeof(int)*(sdi[numprocs-1]+sni[numprocs-1]+1));
+  sbd = (double*)malloc(sizeof(double)*(sdd[numprocs-1]+snd[numprocs-1]+1));
+
+  ni = 0;
+  nd = 0;
+  for (p=0; p<(rdsp[numprocs-1]+rcnt[numprocs-1]); p++){
+    r = &B[G2M_loc[ask[p]]];
+    sbi[ni++] = r->n;
+    for (k=0; k<r->n; k++) sbi[ni++] = r->col[k];
+    for (k=0; k<r->off[r->n]; k++) sbd[nd++] = r->val[k];
+  }
+
+  MPI_Alltoall(sni, 1, MPI_INT, rni, 1, MPI_INT, mpi_comm_level1);
+  MPI_Alltoall(snd, 1, MPI_INT, rnd, 1, MPI_INT, mpi_comm_level1);
+
+  rdi[0] = 0;
+  rdd[0] = 0;
+  for (ID=1; ID<numprocs; ID++){
+    rdi[ID] = rdi[ID-1] + rni[ID-1];
+    rdd[ID] = rdd[ID-1] + rnd[ID-1];
+  }
+
+  *ibuf = (int*)malloc(sizeof(int)*(rdi[numprocs-1]+rni[numprocs-1]+1));
+  *obuf = (int*)malloc(sizeof(int)*(rdi[numprocs-1]+rni[numprocs-1]+1));
+  *dbuf = (double*)malloc(sizeof(double)*(rdd[numprocs-1]+rnd[numprocs-1]+1));
+
+  MPI_Alltoallv(sbi, sni, sdi, MPI_INT, *ibuf, rni, rdi, MPI_INT, mpi_comm_level1);
+  MPI_Alltoallv(sbd, snd, sdd, MPI_DOUBLE, *dbuf, rnd, rdd, MPI_DOUBLE, mpi_comm_level1);
+
+  /* the received rows are in the order of req */
+
+  ni = 0;
+  no = 0;
+  nd = 0;
+  for (p=0; p<(sdsp[numprocs-1]+scnt[numprocs-1]); p++){
+
+    Gk = req[p];
+    n = (*ibuf)[ni];
+
+    tab[Gk].n = n;
+    tab[Gk].col = &(*ibuf)[ni+1];
+    tab[Gk].off = &(*obuf)[no];
+    tab[Gk].val = &(*dbuf)[nd];
+
+    tab[Gk].off[0] = 0;
+    for (k=0; k<n; k++){
+      tab[Gk].off[k+1] = tab[Gk].off[k] + Tno(Gk)*Tno(tab[Gk].col[k]);
+    }
+
+    ni += 1 + n;
+    no += 1 + n;
+    nd += tab[Gk].off[n];
+  }
+
+  free(sbd);
+  free(sbi);
+  free(ask);
+  free(req);
+  free(scnt);
+  free(need);
+
+  return tab;
+}
+
+
+
+static double Mat_Trace(Purify_Row *A)
+{
+  int Mc_AN,Gc_AN,tno1,i,k;
+  double My_sum,sum;
+  double *v;
+
+  My_sum = 0.0;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+    k = Find_Col(&A[Mc_AN],Gc_AN);
+    if (k<0) continue;
+    v = A[Mc_AN].val + A[Mc_AN].off[k];
+    for (i=0; i<tno1; i++) My_sum += v[i*tno1+i];
+  }
+
+  MPI_Allreduce(&My_sum, &sum, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+  return sum;
+}
+
+
+
+/* sum_{ij} A_ij B_ij */
+
+static double Mat_Dot(Purify_Row *A, Purify_Row *B)
+{
+  int Mc_AN,ka,kb,l,len;
+  double My_sum,sum;
+  Purify_Row *a,*b;
+
+  My_sum = 0.0;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+    a = &A[Mc_AN];
+    b = &B[Mc_AN];
+    ka = 0;
+    kb = 0;
+
+    while (ka<a->n && kb<b->n){
+      if      (a->col[ka]<b->col[kb]) ka++;
+      else if (b->col[kb]<a->col[ka]) kb++;
+      else {
+        len = a->off[ka+1] - a->off[ka];
+        for (l=0; l<len; l++) My_sum += a->val[a->off[ka]+l]*b->val[b->off[kb]+l];
+        ka++;
+        kb++;
+      }
+    }
+  }
+
+  MPI_Allreduce(&My_sum, &sum, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
+
+  return sum;
+}
+
+
+
+/* bounds of the spectrum by the Gershgorin circle theorem */
+
+static void Mat_Gershgorin(Purify_Row *A, double *emin, double *emax)
+{
+  int Mc_AN,Gc_AN,tno1,tno2,i,j,k;
+  double My_emin,My_emax,rad,d;
+  double *v;
+
+  My_emin = 1.0e+100;
+  My_emax =-1.0e+100;
+
+  for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+
+    Gc_AN = M2G[Mc_AN];
+    tno1 = Tno(Gc_AN);
+
+    for (i=0; i<tno1; i++){
+
+      rad = 0.0;
+      d = 0.0;
+
+      for (k=0; k<A[Mc_AN].n; k++){
+        tno2 = Tno(A[Mc_AN].col[k]);
+        v = A[Mc_AN].val + A[Mc_AN].off[k] + i*tno2;
+        for (j=0; j<tno2; j++){
+          if (A[Mc_AN].col[k]==Gc_AN && i==j) d = v[j];
+          else                                 rad += fabs(v[j]);
+        }
+      }
+
+      if ((d-rad)<My_emin) My_emin = d - rad;
+      if (My_emax<(d+rad)) My_emax = d + rad;
+    }
+  }
+
+  MPI_Allreduce(&My_emin, emin, 1, MPI_DOUBLE, MPI_MIN, mpi_comm_level1);
+  MPI_Allreduce(&My_emax, emax, 1, MPI_DOUBLE, MPI_MAX, mpi_comm_level1);
+}
+
+
+
+/* index of the block of atom G in r, or -1 */
+
+static int Find_Col(Purify_Row *r, int G)
+{
+  int lo,hi,k;
+
+  lo = 0;
+  hi = r->n - 1;
+
+  while (lo<=hi){
+    k = (lo + hi)/2;
+    if      (r->col[k]==G) return k;
+    else if (r->col[k]<G)  lo = k + 1;
+    else                   hi = k - 1;
+  }
+
+  return -1;
+}
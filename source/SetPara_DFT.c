@@ -7,6 +7,8 @@
   Log of SetPara_DFT.c:
 
      22/Nov/2001  Released by T.Ozaki
+     18/Oct/2026  node-shared Spe_PAO_RWF, Spe_VNL, and Projector_VNA
+     18/Oct/2026  PAO and VPS files parsed from images by species.cache
 
 ***********************************************************************/
 
@@ -301,6 +303,11 @@ void ReadPara_DFT()
   sprintf(DirPAO,"%s/PAO/",DFT_DATA_PATH);
   sprintf(DirVPS,"%s/VPS/",DFT_DATA_PATH);
 
+  /* with species.cache on, Host_ID reads the files once and 
+     the processes parse their images in memory */
+
+  Species_Cache_Images();
+
   /****************************************************
    Read the data of pseudo atomic orbitals and density
   ****************************************************/
@@ -319,7 +326,7 @@ void ReadPara_DFT()
 
     fnjoint2(DirPAO,SpeBasisName[spe],ExtPAO,FN_PAO);    
 
-    if ((fp = fopen(FN_PAO,"r")) != NULL){
+    if ((fp = Species_Cache_fopen(FN_PAO)) != NULL){
 
 #ifdef xt3
       setvbuf(fp,buf,_IOFBF,fp_bsize);  /* setvbuf */
@@ -347,7 +354,7 @@ void ReadPara_DFT()
 
     fnjoint2(DirPAO,SpeBasisName[spe],ExtPAO,FN_PAO);    
 
-    if ((fp = fopen(FN_PAO,"r")) != NULL){
+    if ((fp = Species_Cache_fopen(FN_PAO)) != NULL){
 
 #ifdef xt3
       setvbuf(fp,buf,_IOFBF,fp_bsize);  /* setvbuf */
@@ -368,6 +375,10 @@ void ReadPara_DFT()
     }
   }
 
+  /* keep one copy of the radial functions per node */
+
+  Spe_PAO_RWF = Shm_Share_Double4(Spe_PAO_RWF,List_YOUSO[18],List_YOUSO[25]+1,List_YOUSO[24],List_YOUSO[21]);
+
   /****************************************************
       Read the data of pseudopotentials and pcc
   ****************************************************/
@@ -387,7 +398,7 @@ void ReadPara_DFT()
   for (spe=0; spe<real_SpeciesNum; spe++){
 
     fnjoint2(DirVPS,SpeVPS[spe],ExtVPS,FN_VPS);    
-    if ((fp = fopen(FN_VPS,"r")) != NULL){
+    if ((fp = Species_Cache_fopen(FN_VPS)) != NULL){
 
 #ifdef xt3
       setvbuf(fp,buf,_IOFBF,fp_bsize);  /* setvbuf */
@@ -414,7 +425,7 @@ void ReadPara_DFT()
 
     fnjoint2(DirVPS,SpeVPS[spe],ExtVPS,FN_VPS);
 
-    if ((fp = fopen(FN_VPS,"r")) != NULL){
+    if ((fp = Species_Cache_fopen(FN_VPS)) != NULL){
 
 #ifdef xt3
       setvbuf(fp,buf,_IOFBF,fp_bsize);  /* setvbuf */
@@ -459,6 +470,15 @@ void ReadPara_DFT()
            List_YOUSO[19],List_YOUSO[20]);
   }
 
+  /* keep one copy of the projectors per node */
+
+  Spe_VNL = Shm_Share_Double4(Spe_VNL,SO_switch+1,List_YOUSO[18],List_YOUSO[19],List_YOUSO[22]);
+
+  if (ProExpn_VNA==1){
+    Projector_VNA = Shm_Share_Double4(Projector_VNA,List_YOUSO[18],List_YOUSO[35]+1,
+                                      List_YOUSO[34],List_YOUSO[22]);
+  }
+
   /*************************
       check j-dependency 
   *************************/
@@ -475,6 +495,8 @@ void ReadPara_DFT()
     }
   }
 
+  Species_Cache_Free();
+
 }
 
 void Read_PAO(int spe, char *file)
@@ -488,7 +510,7 @@ void Read_PAO(int spe, char *file)
                       open the file
   ****************************************************/
 
-  input_open(file);
+  input_open_stream(Species_Cache_fopen(file),file);
 
   /****************************************************
                        read data
@@ -643,7 +665,7 @@ void Read_VPS(int spe, char *file)
                       open the file
   ****************************************************/
 
-  input_open(file);
+  input_open_stream(Species_Cache_fopen(file),file);
 
   /****************************************************
                        read data
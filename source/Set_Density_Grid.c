@@ -8,6 +8,7 @@
 
      22/Nov/2001  Released by T.Ozaki
      19/Apr/2013  Modified by A.M.Ito     
+     18/Oct/2026  grid data exchanged in single precision by scf.Grid.Precision
 
 ***********************************************************************/
 
@@ -21,6 +22,10 @@
 
 #define  measure_time   0
 
+/* the data on grids are sent in single precision if Grid_Float_Comm==1 */
+
+#define  Grid_MPI_Type  (Grid_Float_Comm==1 ? MPI_FLOAT : MPI_DOUBLE)
+
 
 
 double Set_Density_Grid(int Cnt_kind, int Calc_CntOrbital_ON, double *****CDM)
@@ -670,14 +675,15 @@ double Set_Density_Grid(int Cnt_kind, int Calc_CntOrbital_ON, double *****CDM)
     IDR = (myid - ID + numprocs) % numprocs;
 
     if (Num_Snd_Grid_A2B[IDS]!=0){
+      Grid_Float_Pack(&Den_Snd_Grid_A2B[IDS][0], Num_Snd_Grid_A2B[IDS]*(SpinP_switch+1));
       MPI_Isend( &Den_Snd_Grid_A2B[IDS][0], Num_Snd_Grid_A2B[IDS]*(SpinP_switch+1), 
-	         MPI_DOUBLE, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
+	         Grid_MPI_Type, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
       NN_S++;
     }
 
     if (Num_Rcv_Grid_A2B[IDR]!=0){
       MPI_Irecv( &Den_Rcv_Grid_A2B[IDR][0], Num_Rcv_Grid_A2B[IDR]*(SpinP_switch+1), 
-  	         MPI_DOUBLE, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
+  	         Grid_MPI_Type, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
       NN_R++;
     }
   }
@@ -690,6 +696,11 @@ double Set_Density_Grid(int Cnt_kind, int Calc_CntOrbital_ON, double *****CDM)
   free(stat_send);
   free(stat_recv);
 
+  for (ID=1; ID<numprocs; ID++){
+    IDR = (myid - ID + numprocs) % numprocs;
+    Grid_Float_Unpack(&Den_Rcv_Grid_A2B[IDR][0], Num_Rcv_Grid_A2B[IDR]*(SpinP_switch+1));
+  }
+
   /* for myid */
   for (i=0; i<Num_Rcv_Grid_A2B[myid]*(SpinP_switch+1); i++){
     Den_Rcv_Grid_A2B[myid][i] = Den_Snd_Grid_A2B[myid][i];
@@ -788,6 +799,8 @@ double Set_Density_Grid(int Cnt_kind, int Calc_CntOrbital_ON, double *****CDM)
   time0 = TEtime - TStime;
   if(myid==0 && measure_time) printf("time0=%18.5f\n",time0);
 
+  if (Bench_flag) Bench_Record(Bench_Density_Grid,time0);
+
   return time0;
 }
 
@@ -844,7 +857,7 @@ void Data_Grid_Copy_B2C_2(double **data_B, double **data_C)
 
     if (IDR!=myid){ 
       MPI_Irecv( &Work_Array_Rcv_Grid_B2C[(SpinP_switch+1)*gp], Num_Rcv_Grid_B2C[IDR]*(SpinP_switch+1),
-                 MPI_DOUBLE, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
+                 Grid_MPI_Type, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
       NN_R++;
     }
 
@@ -878,8 +891,9 @@ void Data_Grid_Copy_B2C_2(double **data_B, double **data_C)
     } /* LN */        
 
     if (IDS!=myid){
+      Grid_Float_Pack(&Work_Array_Snd_Grid_B2C[(SpinP_switch+1)*gp], Num_Snd_Grid_B2C[IDS]*(SpinP_switch+1));
       MPI_Isend( &Work_Array_Snd_Grid_B2C[(SpinP_switch+1)*gp], Num_Snd_Grid_B2C[IDS]*(SpinP_switch+1), 
-		 MPI_DOUBLE, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
+		 Grid_MPI_Type, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
       NN_S++;
     }
   }
@@ -928,6 +942,8 @@ void Data_Grid_Copy_B2C_2(double **data_B, double **data_C)
 
       gp = GP_B2C_R[ID];
 
+      Grid_Float_Unpack(&Work_Array_Rcv_Grid_B2C[(SpinP_switch+1)*gp], Num_Rcv_Grid_B2C[IDR]*(SpinP_switch+1));
+
       for (LN=0; LN<Num_Rcv_Grid_B2C[IDR]; LN++){
 	CN = Index_Rcv_Grid_B2C[IDR][LN];
 
@@ -1021,7 +1037,7 @@ void Data_Grid_Copy_B2C_1(double *data_B, double *data_C)
 
     if (IDR!=myid){ 
       MPI_Irecv( &Work_Array_Rcv_Grid_B2C[gp], Num_Rcv_Grid_B2C[IDR],
-                 MPI_DOUBLE, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
+                 Grid_MPI_Type, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
       NN_R++;
     }
   }
@@ -1041,8 +1057,9 @@ void Data_Grid_Copy_B2C_1(double *data_B, double *data_C)
     } 
 
     if (IDS!=myid){
+      Grid_Float_Pack(&Work_Array_Snd_Grid_B2C[gp], Num_Snd_Grid_B2C[IDS]);
       MPI_Isend( &Work_Array_Snd_Grid_B2C[gp], Num_Snd_Grid_B2C[IDS], 
-		 MPI_DOUBLE, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
+		 Grid_MPI_Type, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
       NN_S++;
     }
   }
@@ -1073,6 +1090,7 @@ void Data_Grid_Copy_B2C_1(double *data_B, double *data_C)
     else{
 
       gp = GP_B2C_R[ID];
+      Grid_Float_Unpack(&Work_Array_Rcv_Grid_B2C[gp], Num_Rcv_Grid_B2C[IDR]);
       for (LN=0; LN<Num_Rcv_Grid_B2C[IDR]; LN++){
 	CN = Index_Rcv_Grid_B2C[IDR][LN];
 	data_C[CN] = Work_Array_Rcv_Grid_B2C[gp+LN];
@@ -1140,7 +1158,7 @@ void Density_Grid_Copy_B2D()
 
     if (IDR!=myid){ 
       MPI_Irecv( &Work_Array_Rcv_Grid_B2D[(SpinP_switch+1)*gp], Num_Rcv_Grid_B2D[IDR]*(SpinP_switch+1),
-                 MPI_DOUBLE, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
+                 Grid_MPI_Type, IDR, tag, mpi_comm_level1, &request_recv[NN_R]);
       NN_R++;
     }
   }
@@ -1174,8 +1192,9 @@ void Density_Grid_Copy_B2D()
     } /* LN */        
 
     if (IDS!=myid){
+      Grid_Float_Pack(&Work_Array_Snd_Grid_B2D[(SpinP_switch+1)*gp], Num_Snd_Grid_B2D[IDS]*(SpinP_switch+1));
       MPI_Isend( &Work_Array_Snd_Grid_B2D[(SpinP_switch+1)*gp], Num_Snd_Grid_B2D[IDS]*(SpinP_switch+1), 
-		 MPI_DOUBLE, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
+		 Grid_MPI_Type, IDS, tag, mpi_comm_level1, &request_send[NN_S]);
       NN_S++;
     }
   }
@@ -1225,6 +1244,8 @@ void Density_Grid_Copy_B2D()
 
       gp = GP_B2D_R[ID];
 
+      Grid_Float_Unpack(&Work_Array_Rcv_Grid_B2D[(SpinP_switch+1)*gp], Num_Rcv_Grid_B2D[IDR]*(SpinP_switch+1));
+
       for (LN=0; LN<Num_Rcv_Grid_B2D[IDR]; LN++){
 
 	DN = Index_Rcv_Grid_B2D[IDR][LN];
@@ -199,7 +199,9 @@ void Calc_MatrixElements_dVH_Vxc_VNA(int Cnt_kind)
   int *OneD2spin,*OneD2Mc_AN,*OneD2h_AN;
   int numprocs,myid;
   double time0,time1,time2,mflops;
+  double TStime,TEtime;
 
+  dtime(&TStime);
   if(measure_time) dtime(&time1);
 
   MPI_Comm_size(mpi_comm_level1,&numprocs);
@@ -772,4 +774,7 @@ void Calc_MatrixElements_dVH_Vxc_VNA(int Cnt_kind)
     dtime(&time2);
     printf("myid=%4d Time4=%18.10f\n",myid,time2-time1);fflush(stdout);
   }
+
+  dtime(&TEtime);
+  if (Bench_flag) Bench_Record(Bench_MatrixElements,TEtime-TStime);
 }
@@ -7,6 +7,7 @@
   Log of Set_Orbitals_Grid.c:
 
      22/Nov/2001  Released by T.Ozaki
+     18/Oct/2026  gradients stored in dOrbs_Grid if dOrbs_Grid_flag==1
 
 ***********************************************************************/
 
@@ -59,9 +60,10 @@ double Set_Orbitals_Grid(int Cnt_kind)
     if (Cnt_kind==0)  NO0 = Spe_Total_NO[Cwan];
     else              NO0 = Spe_Total_CNO[Cwan]; 
 
-#pragma omp parallel shared(Comp2Real,Spe_PAO_RWF,Spe_Num_Basis,Spe_MaxL_Basis,Spe_PAO_RV,Spe_Num_Mesh_PAO,List_YOUSO,Orbs_Grid,Cnt_kind,Gxyz,atv,CellListAtom,GridListAtom,GridN_Atom,Gc_AN,Cwan,Mc_AN,NO0) private(OMPID,Nthrds,Nprocs,Nc,GNc,GRc,Cxyz,x,y,z,dx,dy,dz,i,j)
+#pragma omp parallel shared(Comp2Real,Spe_PAO_RWF,Spe_Num_Basis,Spe_MaxL_Basis,Spe_PAO_RV,Spe_Num_Mesh_PAO,List_YOUSO,Orbs_Grid,dOrbs_Grid,dOrbs_Grid_flag,Cnt_kind,Gxyz,atv,CellListAtom,GridListAtom,GridN_Atom,Gc_AN,Cwan,Mc_AN,NO0) private(OMPID,Nthrds,Nprocs,Nc,GNc,GRc,Cxyz,x,y,z,dx,dy,dz,i,j)
     {
       double *Chi0;
+      double **dChi;
       double Cxyz0[4]; 
       double **RF;
       double **AF;
@@ -84,6 +86,15 @@ double Set_Orbitals_Grid(int Cnt_kind)
 
       Chi0 = (double*)malloc(sizeof(double)*List_YOUSO[7]);
 
+      dChi = NULL;
+
+      if (dOrbs_Grid_flag){
+        dChi = (double**)malloc(sizeof(double*)*4);
+        for (i=0; i<4; i++){
+          dChi[i] = (double*)malloc(sizeof(double)*List_YOUSO[7]);
+        }
+      }
+
       RF = (double**)malloc(sizeof(double*)*(List_YOUSO[25]+1));
       for (i=0; i<(List_YOUSO[25]+1); i++){
 	RF[i] = (double*)malloc(sizeof(double)*List_YOUSO[24]);
@@ -110,7 +121,22 @@ double Set_Orbitals_Grid(int Cnt_kind)
 	y = Cxyz[2] + atv[GRc][2] - Gxyz[Gc_AN][2]; 
 	z = Cxyz[3] + atv[GRc][3] - Gxyz[Gc_AN][3];
 
-	if (Cnt_kind==0){
+	/* values and gradients in a single evaluation */
+
+	if (dOrbs_Grid_flag){
+
+	  if (Cnt_kind==0)  Get_dOrbitals(Cwan,x,y,z,dChi);
+	  else              Get_Cnt_dOrbitals(Mc_AN,x,y,z,dChi);
+
+	  for (i=0; i<NO0; i++){
+	    Chi0[i] = dChi[0][i];
+	    dOrbs_Grid[Mc_AN][Nc][3*i  ] = (Type_Orbs_Grid)dChi[1][i];
+	    dOrbs_Grid[Mc_AN][Nc][3*i+1] = (Type_Orbs_Grid)dChi[2][i];
+	    dOrbs_Grid[Mc_AN][Nc][3*i+2] = (Type_Orbs_Grid)dChi[3][i];
+	  }
+	}
+
+	else if (Cnt_kind==0){
 
           /* Get_Orbitals(Cwan,x,y,z,Chi0); */
           /* start of inlining of Get_Orbitals */
@@ -414,6 +440,13 @@ double Set_Orbitals_Grid(int Cnt_kind)
 
       free(Chi0);
 
+      if (dOrbs_Grid_flag){
+        for (i=0; i<4; i++){
+          free(dChi[i]);
+        }
+        free(dChi);
+      }
+
       for (i=0; i<(List_YOUSO[25]+1); i++){
 	free(RF[i]);
       }
@@ -430,6 +463,10 @@ double Set_Orbitals_Grid(int Cnt_kind)
     time_per_atom[Gc_AN] += Etime_atom - Stime_atom;
   }
 
+  /* kind of the orbitals whose gradients are stored in dOrbs_Grid */
+
+  if (dOrbs_Grid_flag) dOrbs_Grid_kind = Cnt_kind;
+
   /****************************************************
      Calculate Orbs_Grid_FNAN
   ****************************************************/
@@ -830,5 +867,7 @@ double Set_Orbitals_Grid(int Cnt_kind)
   dtime(&TEtime);
   time0 = TEtime - TStime;
 
+  if (Bench_flag) Bench_Record(Bench_Orbitals_Grid,time0);
+
   return time0;
 }
@@ -10,6 +10,9 @@
 #include "exx_xc.h"
 /*---------- until here */
 
+/* number of grid points treated at once in the batched XC kernels */
+#define XC_Block  128
+
 
 void Set_XC_Grid(int XC_P_switch, int XC_switch, 
                  double *Den0, double *Den1, 
@@ -42,17 +45,13 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
   ***********************************************************************************************/
 
   static int firsttime=1;
-  int MN,MN1,MN2,i,j,k,ri,ri1,ri2;
-  int i1,i2,j1,j2,k1,k2,n,nmax;
+  int MN,MN1,MN2,i,j,k;
+  int l,l_s,l_e,N2D,MN0,MN_s,MN_e,nb,p;
   int Ng1,Ng2,Ng3;
   int dDen_Grid_NULL_flag;
   int dEXC_dGD_NULL_flag;
   double den_min=1.0e-14; 
-  double Ec_unif[1],Vc_unif[2],Exc[2],Vxc[2];
-  double Ex_unif[1],Vx_unif[2],tot_den;
-  double ED[2],GDENS[3][2];
-  double DEXDD[2],DECDD[2];
-  double DEXDGD[3][2],DECDGD[3][2];
+  double Exc[2],tot_den;
   double up_x_a,up_x_b,up_x_c;
   double up_y_a,up_y_b,up_y_c;
   double up_z_a,up_z_b,up_z_c;
@@ -65,6 +64,7 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
   double tmp0,tmp1;
   double cot,sit,sip,cop,phi,theta;
   double detA,igtv[4][4];
+  double TStime,TEtime;
   int numprocs,myid;
 
   /* for OpenMP */
@@ -74,6 +74,8 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
   MPI_Comm_size(mpi_comm_level1,&numprocs);
   MPI_Comm_rank(mpi_comm_level1,&myid);
 
+  dtime(&TStime);
+
   /****************************************************
                  allocation of arrays
   ****************************************************/
@@ -135,7 +137,10 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
     igtv[2][3] = -(gtv[1][1]*gtv[2][3] - gtv[1][3]*gtv[2][1])/detA;
     igtv[3][3] =  (gtv[1][1]*gtv[2][2] - gtv[1][2]*gtv[2][1])/detA; 
 
-#pragma omp parallel shared(My_NumGridD,Min_Grid_Index_D,Max_Grid_Index_D,igtv,dDen_Grid,PCCDensity_Grid_D,PCC_switch,Den0,Den1,Den2,Den3,den_min) private(OMPID,Nthrds,nmax,n,i,j,k,ri,ri1,ri2,i1,i2,j1,j2,k1,k2,MN,MN1,MN2,up_a,dn_a,up_b,dn_b,up_c,dn_c,Ng1,Ng2,Ng3)
+    /* each thread takes a contiguous set of lines along the c-axis,
+       and the central differences are taken with fixed strides */
+
+#pragma omp parallel shared(My_NumGridD,Min_Grid_Index_D,Max_Grid_Index_D,igtv,dDen_Grid,PCCDensity_Grid_D,PCC_switch,Den0,Den1,Den2,Den3,den_min) private(OMPID,Nthrds,l,l_s,l_e,N2D,MN0,i,j,k,MN,up_a,dn_a,up_b,dn_b,up_c,dn_c,Ng1,Ng2,Ng3)
     {
 
       OMPID = omp_get_thread_num();
@@ -144,113 +149,72 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
       Ng1 = Max_Grid_Index_D[1] - Min_Grid_Index_D[1] + 1;
       Ng2 = Max_Grid_Index_D[2] - Min_Grid_Index_D[2] + 1;
       Ng3 = Max_Grid_Index_D[3] - Min_Grid_Index_D[3] + 1;
+      N2D = Ng2*Ng3;
 
-      for (MN=OMPID; MN<My_NumGridD; MN+=Nthrds){
-
-        i = MN/(Ng2*Ng3);
-	j = (MN-i*Ng2*Ng3)/Ng3;
-	k = MN - i*Ng2*Ng3 - j*Ng3; 
-
-        if ( i==0 || i==(Ng1-1) || j==0 || j==(Ng2-1) || k==0 || k==(Ng3-1) ){
-
-	  dDen_Grid[0][0][MN] = 0.0;
-	  dDen_Grid[0][1][MN] = 0.0;
-	  dDen_Grid[0][2][MN] = 0.0;
-	  dDen_Grid[1][0][MN] = 0.0;
-	  dDen_Grid[1][1][MN] = 0.0;
-	  dDen_Grid[1][2][MN] = 0.0;
-        }
-
-        else {
+      l_s = (int)(((long int)Ng1*Ng2*OMPID)/Nthrds);
+      l_e = (int)(((long int)Ng1*Ng2*(OMPID+1))/Nthrds);
 
-          /* set i1, i2, j1, j2, k1, and k2 */ 
+      for (l=l_s; l<l_e; l++){
 
-          i1 = i - 1;
-          i2 = i + 1;
+        i = l/Ng2;
+        j = l - i*Ng2;
+        MN0 = l*Ng3;
 
-          j1 = j - 1;
-          j2 = j + 1;
+        for (k=0; k<Ng3; k++){
 
-          k1 = k - 1;
-          k2 = k + 1;
-
-	  /* set dDen_Grid */
-
-	  if ( den_min<(Den0[MN]+Den1[MN]) ){
-
-	    /* a-axis */
-
-	    MN1 = i1*Ng2*Ng3 + j*Ng3 + k;
-	    MN2 = i2*Ng2*Ng3 + j*Ng3 + k;
-
-	    if (PCC_switch==0) {
-	      up_a = Den0[MN2] - Den0[MN1];
-	      dn_a = Den1[MN2] - Den1[MN1];
-	    }
-	    else if (PCC_switch==1) {
-	      up_a = Den0[MN2] + PCCDensity_Grid_D[0][MN2]
-	           - Den0[MN1] - PCCDensity_Grid_D[0][MN1];
-	      dn_a = Den1[MN2] + PCCDensity_Grid_D[1][MN2]
-	           - Den1[MN1] - PCCDensity_Grid_D[1][MN1];
-	    }
+          MN = MN0 + k;
 
-	    /* b-axis */
-
-	    MN1 = i*Ng2*Ng3 + j1*Ng3 + k; 
-	    MN2 = i*Ng2*Ng3 + j2*Ng3 + k; 
-
-	    if (PCC_switch==0) {
-	      up_b = Den0[MN2] - Den0[MN1];
-	      dn_b = Den1[MN2] - Den1[MN1];
-	    }
-	    else if (PCC_switch==1) {
-	      up_b = Den0[MN2] + PCCDensity_Grid_D[0][MN2]
-	           - Den0[MN1] - PCCDensity_Grid_D[0][MN1];
-	      dn_b = Den1[MN2] + PCCDensity_Grid_D[1][MN2]
-	           - Den1[MN1] - PCCDensity_Grid_D[1][MN1];
-	    }
-
-	    /* c-axis */
-
-	    MN1 = i*Ng2*Ng3 + j*Ng3 + k1; 
-	    MN2 = i*Ng2*Ng3 + j*Ng3 + k2; 
-
-	    if (PCC_switch==0) {
-	      up_c = Den0[MN2] - Den0[MN1];
-	      dn_c = Den1[MN2] - Den1[MN1];
-	    }
-	    else if (PCC_switch==1) {
-	      up_c = Den0[MN2] + PCCDensity_Grid_D[0][MN2]
-	           - Den0[MN1] - PCCDensity_Grid_D[0][MN1];
-	      dn_c = Den1[MN2] + PCCDensity_Grid_D[1][MN2]
-	           - Den1[MN1] - PCCDensity_Grid_D[1][MN1];
-	    }
-
-	    /* up */
-
-	    dDen_Grid[0][0][MN] = 0.5*(igtv[1][1]*up_a + igtv[1][2]*up_b + igtv[1][3]*up_c);
-	    dDen_Grid[0][1][MN] = 0.5*(igtv[2][1]*up_a + igtv[2][2]*up_b + igtv[2][3]*up_c);
-	    dDen_Grid[0][2][MN] = 0.5*(igtv[3][1]*up_a + igtv[3][2]*up_b + igtv[3][3]*up_c);
-
-	    /* down */
-
-	    dDen_Grid[1][0][MN] = 0.5*(igtv[1][1]*dn_a + igtv[1][2]*dn_b + igtv[1][3]*dn_c);
-	    dDen_Grid[1][1][MN] = 0.5*(igtv[2][1]*dn_a + igtv[2][2]*dn_b + igtv[2][3]*dn_c);
-	    dDen_Grid[1][2][MN] = 0.5*(igtv[3][1]*dn_a + igtv[3][2]*dn_b + igtv[3][3]*dn_c);
-	  }
+          if ( i==0 || i==(Ng1-1) || j==0 || j==(Ng2-1) || k==0 || k==(Ng3-1)
+               || (Den0[MN]+Den1[MN])<=den_min ){
 
-	  else{
 	    dDen_Grid[0][0][MN] = 0.0;
 	    dDen_Grid[0][1][MN] = 0.0;
 	    dDen_Grid[0][2][MN] = 0.0;
 	    dDen_Grid[1][0][MN] = 0.0;
 	    dDen_Grid[1][1][MN] = 0.0;
 	    dDen_Grid[1][2][MN] = 0.0;
-	  }
-
-	} /* else */
-
-      } /* n */
+            continue;
+          }
+
+          /* a-, b-, and c-axes */
+
+          if (PCC_switch==0) {
+            up_a = Den0[MN+N2D] - Den0[MN-N2D];
+            dn_a = Den1[MN+N2D] - Den1[MN-N2D];
+            up_b = Den0[MN+Ng3] - Den0[MN-Ng3];
+            dn_b = Den1[MN+Ng3] - Den1[MN-Ng3];
+            up_c = Den0[MN+1]   - Den0[MN-1];
+            dn_c = Den1[MN+1]   - Den1[MN-1];
+          }
+          else {
+            up_a = Den0[MN+N2D] + PCCDensity_Grid_D[0][MN+N2D]
+                 - Den0[MN-N2D] - PCCDensity_Grid_D[0][MN-N2D];
+            dn_a = Den1[MN+N2D] + PCCDensity_Grid_D[1][MN+N2D]
+                 - Den1[MN-N2D] - PCCDensity_Grid_D[1][MN-N2D];
+            up_b = Den0[MN+Ng3] + PCCDensity_Grid_D[0][MN+Ng3]
+                 - Den0[MN-Ng3] - PCCDensity_Grid_D[0][MN-Ng3];
+            dn_b = Den1[MN+Ng3] + PCCDensity_Grid_D[1][MN+Ng3]
+                 - Den1[MN-Ng3] - PCCDensity_Grid_D[1][MN-Ng3];
+            up_c = Den0[MN+1] + PCCDensity_Grid_D[0][MN+1]
+                 - Den0[MN-1] - PCCDensity_Grid_D[0][MN-1];
+            dn_c = Den1[MN+1] + PCCDensity_Grid_D[1][MN+1]
+                 - Den1[MN-1] - PCCDensity_Grid_D[1][MN-1];
+          }
+
+          /* up */
+
+          dDen_Grid[0][0][MN] = 0.5*(igtv[1][1]*up_a + igtv[1][2]*up_b + igtv[1][3]*up_c);
+          dDen_Grid[0][1][MN] = 0.5*(igtv[2][1]*up_a + igtv[2][2]*up_b + igtv[2][3]*up_c);
+          dDen_Grid[0][2][MN] = 0.5*(igtv[3][1]*up_a + igtv[3][2]*up_b + igtv[3][3]*up_c);
+
+          /* down */
+
+          dDen_Grid[1][0][MN] = 0.5*(igtv[1][1]*dn_a + igtv[1][2]*dn_b + igtv[1][3]*dn_c);
+          dDen_Grid[1][1][MN] = 0.5*(igtv[2][1]*dn_a + igtv[2][2]*dn_b + igtv[2][3]*dn_c);
+          dDen_Grid[1][2][MN] = 0.5*(igtv[3][1]*dn_a + igtv[3][2]*dn_b + igtv[3][3]*dn_c);
+
+        } /* k */
+      } /* l */
 
 #pragma omp flush(dDen_Grid)
 
@@ -261,13 +225,40 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
    loop MN
   ****************************************************/
 
-#pragma omp parallel shared(dDen_Grid,dEXC_dGD,den_min,Vxc0,Vxc1,Vxc2,Vxc3,My_NumGridD,XC_P_switch,XC_switch,Den0,Den1,Den2,Den3,PCC_switch,PCCDensity_Grid_D) private(OMPID,Nthrds,MN,tot_den,tmp0,tmp1,ED,Exc,Ec_unif,Vc_unif,Vxc,Ex_unif,Vx_unif,GDENS,DEXDD,DECDD,DEXDGD,DECDGD)
+#pragma omp parallel shared(dDen_Grid,dEXC_dGD,den_min,Vxc0,Vxc1,Vxc2,Vxc3,My_NumGridD,XC_P_switch,XC_switch,Den0,Den1,Den2,Den3,PCC_switch,PCCDensity_Grid_D) private(OMPID,Nthrds,MN,MN0,MN_s,MN_e,nb,p,i,k,tot_den,tmp0,tmp1,Exc)
   {
+    /* work arrays for a block of grid points */
+    double Den_b[2][XC_Block],Exc_b[XC_Block],Vxc_b[2][XC_Block];
+    double dEXC_b[2][3][XC_Block];
+    double *gden[2][3],*dgd[2][3];
 
     OMPID = omp_get_thread_num();
     Nthrds = omp_get_num_threads();
 
-    for (MN=OMPID; MN<My_NumGridD; MN+=Nthrds){
+    /* each thread takes a contiguous chunk of grid points,
+       which avoids false sharing on Vxc0-3 and dEXC_dGD */
+
+    MN_s = (int)(((long int)My_NumGridD*OMPID)/Nthrds);
+    MN_e = (int)(((long int)My_NumGridD*(OMPID+1))/Nthrds);
+
+    for (MN0=MN_s; MN0<MN_e; MN0+=XC_Block){
+
+      nb = MN_e - MN0;
+      if (XC_Block<nb) nb = XC_Block;
+
+      /* densities including the partial core correction */
+
+      for (p=0; p<nb; p++){
+        Den_b[0][p] = Den0[MN0+p];
+        Den_b[1][p] = Den1[MN0+p];
+      }
+
+      if (PCC_switch==1) {
+        for (p=0; p<nb; p++){
+          Den_b[0][p] += PCCDensity_Grid_D[0][MN0+p];
+          Den_b[1][p] += PCCDensity_Grid_D[1][MN0+p];
+	}
+      }
 
       switch(XC_switch){
         
@@ -285,18 +276,14 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
 	******************************************************************/
         
       case 1:
-        
-	tot_den = Den0[MN] + Den1[MN];
 
-	/* partial core correction */
-	if (PCC_switch==1) {
-	  tot_den += PCCDensity_Grid_D[0][MN] + PCCDensity_Grid_D[1][MN];
+        for (p=0; p<nb; p++){
+          MN = MN0 + p;
+	  tot_den = Den_b[0][p] + Den_b[1][p];
+	  tmp0 = XC_Ceperly_Alder(tot_den,XC_P_switch);
+	  Vxc0[MN] = tmp0;
+	  Vxc1[MN] = tmp0;
 	}
-
-	tmp0 = XC_Ceperly_Alder(tot_den,XC_P_switch);
-
-	Vxc0[MN] = tmp0;
-	Vxc1[MN] = tmp0;
         
 	break;
 
@@ -315,19 +302,13 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
 
       case 2:
 
-	ED[0] = Den0[MN];
-	ED[1] = Den1[MN];
-
-	/* partial core correction */
-	if (PCC_switch==1) {
-	  ED[0] += PCCDensity_Grid_D[0][MN];
-	  ED[1] += PCCDensity_Grid_D[1][MN];
+        for (p=0; p<nb; p++){
+          MN = MN0 + p;
+	  XC_CA_LSDA(Den_b[0][p], Den_b[1][p], Exc, XC_P_switch);
+	  Vxc0[MN] = Exc[0];
+	  Vxc1[MN] = Exc[1];
 	}
 
-	XC_CA_LSDA(ED[0], ED[1], Exc, XC_P_switch);
-	Vxc0[MN] = Exc[0];
-	Vxc1[MN] = Exc[1];
-
 	break;
 
 	/******************************************************************
@@ -339,75 +320,27 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
 
       case 3:
 
-	ED[0] = Den0[MN];
-	ED[1] = Den1[MN];
-
-	/* partial core correction */
-	if (PCC_switch==1) {
-	  ED[0] += PCCDensity_Grid_D[0][MN];
-	  ED[1] += PCCDensity_Grid_D[1][MN];
-	}
-
-	if ((ED[0]+ED[1])<den_min){
-	  Vxc0[MN] = 0.0;
-	  Vxc1[MN] = 0.0;
-	}
-	else{
-      
-	  if (XC_P_switch==0){
-
-	    XC_PW92C(ED,Ec_unif,Vc_unif);
-
-	    Vxc[0] = Vc_unif[0];
-	    Vxc[1] = Vc_unif[1];
-	    Exc[0] = Ec_unif[0];
-
-	    XC_EX(1,2.0*ED[0],ED,Ex_unif,Vx_unif);
-	    Vxc[0] = Vxc[0] + Vx_unif[0];
-	    Exc[1] = 2.0*ED[0]*Ex_unif[0];
+        XC_PW92_Batch(nb, Den_b[0], Den_b[1], Exc_b, Vxc_b[0], Vxc_b[1]);
 
-	    XC_EX(1,2.0*ED[1],ED,Ex_unif,Vx_unif);
-	    Vxc[1] += Vx_unif[0];
-	    Exc[1] += 2.0*ED[1]*Ex_unif[0];
+        for (p=0; p<nb; p++){
 
-	    Exc[1] = 0.5*Exc[1]/(ED[0]+ED[1]);
+          MN = MN0 + p;
 
-	    Vxc0[MN] = Exc[0] + Exc[1];
-	    Vxc1[MN] = Exc[0] + Exc[1];
+	  if ((Den_b[0][p]+Den_b[1][p])<den_min){
+	    Vxc0[MN] = 0.0;
+	    Vxc1[MN] = 0.0;
+	  }
+	  else if (XC_P_switch==0){
+	    Vxc0[MN] = Exc_b[p];
+	    Vxc1[MN] = Exc_b[p];
 	  }
-
 	  else if (XC_P_switch==1){
-	    XC_PW92C(ED,Ec_unif,Vc_unif);
-	    Vxc0[MN] = Vc_unif[0];
-	    Vxc1[MN] = Vc_unif[1];
-
-	    XC_EX(1,2.0*ED[0],ED,Ex_unif,Vx_unif);
-	    Vxc0[MN] = Vxc0[MN] + Vx_unif[0];
-
-	    XC_EX(1,2.0*ED[1],ED,Ex_unif,Vx_unif);
-	    Vxc1[MN] = Vxc1[MN] + Vx_unif[0];
+	    Vxc0[MN] = Vxc_b[0][p];
+	    Vxc1[MN] = Vxc_b[1][p];
 	  }
-
 	  else if (XC_P_switch==2){
-
-	    XC_PW92C(ED,Ec_unif,Vc_unif);
-
-	    Vxc[0] = Vc_unif[0];
-	    Vxc[1] = Vc_unif[1];
-	    Exc[0] = Ec_unif[0];
-
-	    XC_EX(1,2.0*ED[0],ED,Ex_unif,Vx_unif);
-	    Vxc[0]  = Vxc[0] + Vx_unif[0];
-	    Exc[1]  = 2.0*ED[0]*Ex_unif[0];
-
-	    XC_EX(1,2.0*ED[1],ED,Ex_unif,Vx_unif);
-	    Vxc[1] += Vx_unif[0];
-	    Exc[1] += 2.0*ED[1]*Ex_unif[0];
-
-	    Exc[1] = 0.5*Exc[1]/(ED[0]+ED[1]);
-
-	    Vxc0[MN] = Exc[0] + Exc[1] - Vxc[0];
-	    Vxc1[MN] = Exc[0] + Exc[1] - Vxc[1];
+	    Vxc0[MN] = Exc_b[p] - Vxc_b[0][p];
+	    Vxc1[MN] = Exc_b[p] - Vxc_b[1][p];
 	  }
 	}
 
@@ -423,110 +356,74 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
       case 4:
 
 	/****************************************************
-         ED[0]       density of up spin:     n_up   
-         ED[1]       density of down spin:   n_down
-
-         GDENS[0][0] derivative (x) of density of up spin
-         GDENS[1][0] derivative (y) of density of up spin
-         GDENS[2][0] derivative (z) of density of up spin
-         GDENS[0][1] derivative (x) of density of down spin
-         GDENS[1][1] derivative (y) of density of down spin
-         GDENS[2][1] derivative (z) of density of down spin
-
-         DEXDD[0]    d(fx)/d(n_up) 
-         DEXDD[1]    d(fx)/d(n_down) 
-         DECDD[0]    d(fc)/d(n_up) 
-         DECDD[1]    d(fc)/d(n_down) 
-
-         n'_up_x   = d(n_up)/d(x)
-         n'_up_y   = d(n_up)/d(y)
-         n'_up_z   = d(n_up)/d(z)
-         n'_down_x = d(n_down)/d(x)
-         n'_down_y = d(n_down)/d(y)
-         n'_down_z = d(n_down)/d(z)
-       
-         DEXDGD[0][0] d(fx)/d(n'_up_x) 
-         DEXDGD[1][0] d(fx)/d(n'_up_y) 
-         DEXDGD[2][0] d(fx)/d(n'_up_z) 
-         DEXDGD[0][1] d(fx)/d(n'_down_x) 
-         DEXDGD[1][1] d(fx)/d(n'_down_y) 
-         DEXDGD[2][1] d(fx)/d(n'_down_z) 
-
-         DECDGD[0][0] d(fc)/d(n'_up_x) 
-         DECDGD[1][0] d(fc)/d(n'_up_y) 
-         DECDGD[2][0] d(fc)/d(n'_up_z) 
-         DECDGD[0][1] d(fc)/d(n'_down_x) 
-         DECDGD[1][1] d(fc)/d(n'_down_y) 
-         DECDGD[2][1] d(fc)/d(n'_down_z) 
+         Den_b[0]          density of up spin:     n_up   
+         Den_b[1]          density of down spin:   n_down
+         dDen_Grid[s][x]   derivative (x,y,z) of density of spin s
+
+         Exc_b             fx + fc
+         Vxc_b[s]          d(fx)/d(n_s) + d(fc)/d(n_s)
+         dEXC_b[s][x]      d(fx)/d(n'_s_x) + d(fc)/d(n'_s_x)
 	****************************************************/
 
-	ED[0] = Den0[MN];
-	ED[1] = Den1[MN];
+        for (i=0; i<=1; i++){
+          for (k=0; k<=2; k++){
+            gden[i][k] = &dDen_Grid[i][k][MN0];
+            dgd[i][k] = dEXC_b[i][k];
+          }
+        }
 
-	if ((ED[0]+ED[1])<den_min){
+        XC_PBE_Batch(nb, Den_b[0], Den_b[1], gden, Exc_b, Vxc_b[0], Vxc_b[1], dgd);
 
-          if (XC_P_switch!=3){
-  	    Vxc0[MN] = 0.0;
-	    Vxc1[MN] = 0.0;
-	  }
+        for (p=0; p<nb; p++){
 
-	  /* later add its derivatives */
-	  if (XC_P_switch!=0){
-	    dEXC_dGD[0][0][MN] = 0.0;
-	    dEXC_dGD[0][1][MN] = 0.0;
-	    dEXC_dGD[0][2][MN] = 0.0;
+          MN = MN0 + p;
 
-	    dEXC_dGD[1][0][MN] = 0.0;
-	    dEXC_dGD[1][1][MN] = 0.0;
-	    dEXC_dGD[1][2][MN] = 0.0;
-	  }
-	}
-     
-	else{
-
-	  GDENS[0][0] = dDen_Grid[0][0][MN];
-	  GDENS[1][0] = dDen_Grid[0][1][MN];
-	  GDENS[2][0] = dDen_Grid[0][2][MN];
-	  GDENS[0][1] = dDen_Grid[1][0][MN];
-	  GDENS[1][1] = dDen_Grid[1][1][MN];
-	  GDENS[2][1] = dDen_Grid[1][2][MN];
-
-	  if (PCC_switch==1) {
-	    ED[0] += PCCDensity_Grid_D[0][MN];
-	    ED[1] += PCCDensity_Grid_D[1][MN];
-	  }
+	  if ((Den0[MN]+Den1[MN])<den_min){
 
-	  XC_PBE(ED, GDENS, Exc, DEXDD, DECDD, DEXDGD, DECDGD);
+	    if (XC_P_switch!=3){
+	      Vxc0[MN] = 0.0;
+	      Vxc1[MN] = 0.0;
+	    }
 
-	  /* XC energy density */
-	  if      (XC_P_switch==0){
-	    Vxc0[MN] = Exc[0] + Exc[1];
-	    Vxc1[MN] = Exc[0] + Exc[1];
+	    /* later add its derivatives */
+	    if (XC_P_switch!=0){
+	      for (i=0; i<=1; i++){
+		for (k=0; k<=2; k++){
+		  dEXC_dGD[i][k][MN] = 0.0;
+		}
+	      }
+	    }
 	  }
 
-	  /* XC potential */
-	  else if (XC_P_switch==1){
-	    Vxc0[MN] = DEXDD[0] + DECDD[0];
-	    Vxc1[MN] = DEXDD[1] + DECDD[1];
-	  }
+	  else{
 
-	  /* XC energy density - XC potential */
-	  else if (XC_P_switch==2){
-	    Vxc0[MN] = Exc[0] + Exc[1] - DEXDD[0] - DECDD[0];
-	    Vxc1[MN] = Exc[0] + Exc[1] - DEXDD[1] - DECDD[1];
-	  }
+	    /* XC energy density */
+	    if      (XC_P_switch==0){
+	      Vxc0[MN] = Exc_b[p];
+	      Vxc1[MN] = Exc_b[p];
+	    }
+
+	    /* XC potential */
+	    else if (XC_P_switch==1){
+	      Vxc0[MN] = Vxc_b[0][p];
+	      Vxc1[MN] = Vxc_b[1][p];
+	    }
 
-	  /* later add its derivatives */
-	  if (XC_P_switch!=0){
-	    dEXC_dGD[0][0][MN] = DEXDGD[0][0] + DECDGD[0][0];
-	    dEXC_dGD[0][1][MN] = DEXDGD[1][0] + DECDGD[1][0];
-	    dEXC_dGD[0][2][MN] = DEXDGD[2][0] + DECDGD[2][0];
+	    /* XC energy density - XC potential */
+	    else if (XC_P_switch==2){
+	      Vxc0[MN] = Exc_b[p] - Vxc_b[0][p];
+	      Vxc1[MN] = Exc_b[p] - Vxc_b[1][p];
+	    }
 
-	    dEXC_dGD[1][0][MN] = DEXDGD[0][1] + DECDGD[0][1];
-	    dEXC_dGD[1][1][MN] = DEXDGD[1][1] + DECDGD[1][1];
-	    dEXC_dGD[1][2][MN] = DEXDGD[2][1] + DECDGD[2][1];
+	    /* later add its derivatives */
+	    if (XC_P_switch!=0){
+	      for (i=0; i<=1; i++){
+		for (k=0; k<=2; k++){
+		  dEXC_dGD[i][k][MN] = dEXC_b[i][k][p];
+		}
+	      }
+	    }
 	  }
-
 	}
 	
 	break;
@@ -534,25 +431,19 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
       /*---------- added by TOYODA 14/JAN/2010 from here */ 
       case 5: /* EXX-TEST */
         /* only X part of CA-LSDA XC is used */
- 
-	ED[0] = Den0[MN];
-	ED[1] = Den1[MN];
 
-	/* partial core correction */
-	if (PCC_switch==1) {
-	  ED[0] += PCCDensity_Grid_D[0][MN];
-	  ED[1] += PCCDensity_Grid_D[1][MN];
+        for (p=0; p<nb; p++){
+          MN = MN0 + p;
+	  EXX_XC_CA_LSDA(Den_b[0][p], Den_b[1][p], Exc, XC_P_switch);
+	  Vxc0[MN] = Exc[0];
+	  Vxc1[MN] = Exc[1];
 	}
-
-	EXX_XC_CA_LSDA(ED[0], ED[1], Exc, XC_P_switch);
-	Vxc0[MN] = Exc[0];
-	Vxc1[MN] = Exc[1];
         
 	break;
         /*---------- added by TOYODA 14/JAN/2010 until here */
 
       } /* switch(XC_switch) */
-    }   /* MN */
+    }   /* MN0 */
 
     if (XC_switch==4){
 #pragma omp flush(dEXC_dGD)
@@ -567,7 +458,7 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
 
   if (XC_switch==4 && (XC_P_switch==1 || XC_P_switch==2)){
     
-#pragma omp parallel shared(Min_Grid_Index_D,Max_Grid_Index_D,My_NumGridD,XC_P_switch,Vxc0,Vxc1,Vxc2,Vxc3,igtv,dEXC_dGD,Den0,Den1,Den2,Den3,den_min) private(OMPID,Nthrds,nmax,i,j,k,ri,ri1,ri2,i1,i2,j1,j2,k1,k2,MN,MN1,MN2,up_x_a,up_y_a,up_z_a,dn_x_a,dn_y_a,dn_z_a,up_x_b,up_y_b,up_z_b,dn_x_b,dn_y_b,dn_z_b,up_x_c,up_y_c,up_z_c,dn_x_c,dn_y_c,dn_z_c,tmp0,tmp1,Ng1,Ng2,Ng3)
+#pragma omp parallel shared(Min_Grid_Index_D,Max_Grid_Index_D,My_NumGridD,XC_P_switch,Vxc0,Vxc1,Vxc2,Vxc3,igtv,dEXC_dGD,Den0,Den1,Den2,Den3,den_min) private(OMPID,Nthrds,l,l_s,l_e,N2D,MN0,i,j,k,MN,MN1,MN2,up_x_a,up_y_a,up_z_a,dn_x_a,dn_y_a,dn_z_a,up_x_b,up_y_b,up_z_b,dn_x_b,dn_y_b,dn_z_b,up_x_c,up_y_c,up_z_c,dn_x_c,dn_y_c,dn_z_c,tmp0,tmp1,Ng1,Ng2,Ng3)
     {
 
       OMPID = omp_get_thread_num();
@@ -576,106 +467,98 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
       Ng1 = Max_Grid_Index_D[1] - Min_Grid_Index_D[1] + 1;
       Ng2 = Max_Grid_Index_D[2] - Min_Grid_Index_D[2] + 1;
       Ng3 = Max_Grid_Index_D[3] - Min_Grid_Index_D[3] + 1;
+      N2D = Ng2*Ng3;
 
-      for (MN=OMPID; MN<My_NumGridD; MN+=Nthrds){
-
-        i = MN/(Ng2*Ng3);
-	j = (MN-i*Ng2*Ng3)/Ng3;
-	k = MN - i*Ng2*Ng3 - j*Ng3; 
-
-        if ( i<=1 || (Ng1-2)<=i || j<=1 || (Ng2-2)<=j || k<=1 || (Ng3-2)<=k ){
-
-	  Vxc0[MN] = 0.0;
-	  Vxc1[MN] = 0.0;
-	}
- 
-        else {
-
-          /* set i1, i2, j1, j2, k1, and k2 */ 
+      l_s = (int)(((long int)Ng1*Ng2*OMPID)/Nthrds);
+      l_e = (int)(((long int)Ng1*Ng2*(OMPID+1))/Nthrds);
 
-          i1 = i - 1;
-          i2 = i + 1;
+      for (l=l_s; l<l_e; l++){
 
-          j1 = j - 1;
-          j2 = j + 1;
+        i = l/Ng2;
+        j = l - i*Ng2;
+        MN0 = l*Ng3;
 
-          k1 = k - 1;
-          k2 = k + 1;
+        for (k=0; k<Ng3; k++){
 
-	  /* set Vxc_Grid */
+          MN = MN0 + k;
 
-	  if ( den_min<(Den0[MN]+Den1[MN]) ){
+          if ( i<=1 || (Ng1-2)<=i || j<=1 || (Ng2-2)<=j || k<=1 || (Ng3-2)<=k ){
+	    Vxc0[MN] = 0.0;
+	    Vxc1[MN] = 0.0;
+            continue;
+          }
 
-	    /* a-axis */
+	  if ( (Den0[MN]+Den1[MN])<=den_min ) continue;
 
-	    MN1 = i1*Ng2*Ng3 + j*Ng3 + k;
-	    MN2 = i2*Ng2*Ng3 + j*Ng3 + k;
+	  /* a-axis */
 
-	    up_x_a = dEXC_dGD[0][0][MN2] - dEXC_dGD[0][0][MN1];
-	    up_y_a = dEXC_dGD[0][1][MN2] - dEXC_dGD[0][1][MN1];
-	    up_z_a = dEXC_dGD[0][2][MN2] - dEXC_dGD[0][2][MN1];
+	  MN1 = MN - N2D;
+	  MN2 = MN + N2D;
 
-	    dn_x_a = dEXC_dGD[1][0][MN2] - dEXC_dGD[1][0][MN1];
-	    dn_y_a = dEXC_dGD[1][1][MN2] - dEXC_dGD[1][1][MN1];
-	    dn_z_a = dEXC_dGD[1][2][MN2] - dEXC_dGD[1][2][MN1];
+	  up_x_a = dEXC_dGD[0][0][MN2] - dEXC_dGD[0][0][MN1];
+	  up_y_a = dEXC_dGD[0][1][MN2] - dEXC_dGD[0][1][MN1];
+	  up_z_a = dEXC_dGD[0][2][MN2] - dEXC_dGD[0][2][MN1];
 
-	    /* b-axis */
+	  dn_x_a = dEXC_dGD[1][0][MN2] - dEXC_dGD[1][0][MN1];
+	  dn_y_a = dEXC_dGD[1][1][MN2] - dEXC_dGD[1][1][MN1];
+	  dn_z_a = dEXC_dGD[1][2][MN2] - dEXC_dGD[1][2][MN1];
 
-	    MN1 = i*Ng2*Ng3 + j1*Ng3 + k; 
-	    MN2 = i*Ng2*Ng3 + j2*Ng3 + k; 
+	  /* b-axis */
 
-	    up_x_b = dEXC_dGD[0][0][MN2] - dEXC_dGD[0][0][MN1];
-	    up_y_b = dEXC_dGD[0][1][MN2] - dEXC_dGD[0][1][MN1];
-	    up_z_b = dEXC_dGD[0][2][MN2] - dEXC_dGD[0][2][MN1];
+	  MN1 = MN - Ng3;
+	  MN2 = MN + Ng3;
 
-	    dn_x_b = dEXC_dGD[1][0][MN2] - dEXC_dGD[1][0][MN1];
-	    dn_y_b = dEXC_dGD[1][1][MN2] - dEXC_dGD[1][1][MN1];
-	    dn_z_b = dEXC_dGD[1][2][MN2] - dEXC_dGD[1][2][MN1];
+	  up_x_b = dEXC_dGD[0][0][MN2] - dEXC_dGD[0][0][MN1];
+	  up_y_b = dEXC_dGD[0][1][MN2] - dEXC_dGD[0][1][MN1];
+	  up_z_b = dEXC_dGD[0][2][MN2] - dEXC_dGD[0][2][MN1];
 
-	    /* c-axis */
+	  dn_x_b = dEXC_dGD[1][0][MN2] - dEXC_dGD[1][0][MN1];
+	  dn_y_b = dEXC_dGD[1][1][MN2] - dEXC_dGD[1][1][MN1];
+	  dn_z_b = dEXC_dGD[1][2][MN2] - dEXC_dGD[1][2][MN1];
 
-	    MN1 = i*Ng2*Ng3 + j*Ng3 + k1; 
-	    MN2 = i*Ng2*Ng3 + j*Ng3 + k2; 
+	  /* c-axis */
 
-	    up_x_c = dEXC_dGD[0][0][MN2] - dEXC_dGD[0][0][MN1];
-	    up_y_c = dEXC_dGD[0][1][MN2] - dEXC_dGD[0][1][MN1];
-	    up_z_c = dEXC_dGD[0][2][MN2] - dEXC_dGD[0][2][MN1];
+	  MN1 = MN - 1;
+	  MN2 = MN + 1;
 
-	    dn_x_c = dEXC_dGD[1][0][MN2] - dEXC_dGD[1][0][MN1];
-	    dn_y_c = dEXC_dGD[1][1][MN2] - dEXC_dGD[1][1][MN1];
-	    dn_z_c = dEXC_dGD[1][2][MN2] - dEXC_dGD[1][2][MN1];
+	  up_x_c = dEXC_dGD[0][0][MN2] - dEXC_dGD[0][0][MN1];
+	  up_y_c = dEXC_dGD[0][1][MN2] - dEXC_dGD[0][1][MN1];
+	  up_z_c = dEXC_dGD[0][2][MN2] - dEXC_dGD[0][2][MN1];
 
-	    /* up */
+	  dn_x_c = dEXC_dGD[1][0][MN2] - dEXC_dGD[1][0][MN1];
+	  dn_y_c = dEXC_dGD[1][1][MN2] - dEXC_dGD[1][1][MN1];
+	  dn_z_c = dEXC_dGD[1][2][MN2] - dEXC_dGD[1][2][MN1];
 
-	    tmp0 = igtv[1][1]*up_x_a + igtv[1][2]*up_x_b + igtv[1][3]*up_x_c
-	         + igtv[2][1]*up_y_a + igtv[2][2]*up_y_b + igtv[2][3]*up_y_c
-	         + igtv[3][1]*up_z_a + igtv[3][2]*up_z_b + igtv[3][3]*up_z_c;
-	    tmp0 = 0.5*tmp0;
+	  /* up */
 
-	    /* down */
+	  tmp0 = igtv[1][1]*up_x_a + igtv[1][2]*up_x_b + igtv[1][3]*up_x_c
+	       + igtv[2][1]*up_y_a + igtv[2][2]*up_y_b + igtv[2][3]*up_y_c
+	       + igtv[3][1]*up_z_a + igtv[3][2]*up_z_b + igtv[3][3]*up_z_c;
+	  tmp0 = 0.5*tmp0;
 
-	    tmp1 = igtv[1][1]*dn_x_a + igtv[1][2]*dn_x_b + igtv[1][3]*dn_x_c
-	         + igtv[2][1]*dn_y_a + igtv[2][2]*dn_y_b + igtv[2][3]*dn_y_c
-	         + igtv[3][1]*dn_z_a + igtv[3][2]*dn_z_b + igtv[3][3]*dn_z_c;
-	    tmp1 = 0.5*tmp1;
+	  /* down */
 
-	    /* XC potential */
+	  tmp1 = igtv[1][1]*dn_x_a + igtv[1][2]*dn_x_b + igtv[1][3]*dn_x_c
+	       + igtv[2][1]*dn_y_a + igtv[2][2]*dn_y_b + igtv[2][3]*dn_y_c
+	       + igtv[3][1]*dn_z_a + igtv[3][2]*dn_z_b + igtv[3][3]*dn_z_c;
+	  tmp1 = 0.5*tmp1;
 
-	    if (XC_P_switch==1){
-	      Vxc0[MN] -= tmp0; 
-	      Vxc1[MN] -= tmp1;
-	    }
+	  /* XC potential */
 
-	    /* XC energy density - XC potential */
+	  if (XC_P_switch==1){
+	    Vxc0[MN] -= tmp0; 
+	    Vxc1[MN] -= tmp1;
+	  }
 
-	    else if (XC_P_switch==2){
-	      Vxc0[MN] += tmp0; 
-	      Vxc1[MN] += tmp1;
-	    }
+	  /* XC energy density - XC potential */
 
+	  else if (XC_P_switch==2){
+	    Vxc0[MN] += tmp0; 
+	    Vxc1[MN] += tmp1;
 	  }
-	}
-      }
+
+        } /* k */
+      } /* l */
 
 #pragma omp flush(Vxc0,Vxc1,Vxc2,Vxc3)
 
@@ -688,13 +571,16 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
 
   if (SpinP_switch==3 && (XC_P_switch==1 || XC_P_switch==2)){
 
-#pragma omp parallel shared(Den0,Den1,Den2,Den3,Vxc0,Vxc1,Vxc2,Vxc3,My_NumGridD) private(OMPID,Nthrds,MN,tmp0,tmp1,theta,phi,sit,cot,sip,cop)
+#pragma omp parallel shared(Den0,Den1,Den2,Den3,Vxc0,Vxc1,Vxc2,Vxc3,My_NumGridD) private(OMPID,Nthrds,MN,MN_s,MN_e,tmp0,tmp1,theta,phi,sit,cot,sip,cop)
     {
 
       OMPID = omp_get_thread_num();
       Nthrds = omp_get_num_threads();
 
-      for (MN=OMPID; MN<My_NumGridD; MN+=Nthrds){
+      MN_s = (int)(((long int)My_NumGridD*OMPID)/Nthrds);
+      MN_e = (int)(((long int)My_NumGridD*(OMPID+1))/Nthrds);
+
+      for (MN=MN_s; MN<MN_e; MN++){
 
 	tmp0 = 0.5*(Vxc0[MN] + Vxc1[MN]);
 	tmp1 = 0.5*(Vxc0[MN] - Vxc1[MN]);
@@ -764,4 +650,6 @@ void Set_XC_Grid(int XC_P_switch, int XC_switch,
     free(dEXC_dGD);
   }
 
+  dtime(&TEtime);
+  if (Bench_flag) Bench_Record(Bench_XC_Grid,TEtime-TStime);
 }
@@ -0,0 +1,306 @@
+/**********************************************************************
+  Shared_Memory.c:
+
+     Shared_Memory.c is a set of subroutines to keep read-only tables
+     of species, such as Spe_PAO_RWF and Spe_RF_Bessel, only once per
+     node in an MPI-3 shared memory window. The processes on a node
+     access the table through their own pointer arrays, and only the
+     process with the rank 0 in the node (the writer) fills it.
+
+     Shm_Malloc_Double4:  allocates a four-dimensional table
+     Shm_Share_Double4:   moves a table allocated by malloc into a window
+     Shm_Free_Double4:    frees a table allocated by the routines above
+     Shm_Writer:          returns 1 if the process may write the table
+     Shm_Sync:            makes the written data visible on the node
+     Shm_Bcast_Double:    MPI_Bcast for a part of a shared table
+     Shm_PrintMemory:     PrintMemory with the size per process
+
+     If memory.shared.tables is off, the tables are allocated by
+     malloc as before, and the routines reduce to the usual ones.
+
+  Log of Shared_Memory.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "openmx_common.h"
+#include "mpi.h"
+
+#define Shm_MaxTables  32
+
+static struct {
+  void *table;
+  double **p3;
+  double ***p2;
+  MPI_Win win;
+  long int size;
+} Shm_List[Shm_MaxTables];
+
+static int Shm_Num = 0;
+static int Shm_Initialized = 0;
+static int Shm_NodeID,Shm_NodeProcs;
+static int *Shm_Leader;
+static MPI_Comm Shm_Comm_Node;
+static MPI_Comm Shm_Comm_Leader;
+
+static void Shm_Init();
+static int Shm_Find(void *table);
+
+
+
+static void Shm_Init()
+{
+  int numprocs,myid,lid;
+
+  MPI_Comm_size(mpi_comm_level1,&numprocs);
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* processes sharing the memory */
+
+  MPI_Comm_split_type(mpi_comm_level1, MPI_COMM_TYPE_SHARED, myid, MPI_INFO_NULL, &Shm_Comm_Node);
+  MPI_Comm_rank(Shm_Comm_Node,&Shm_NodeID);
+  MPI_Comm_size(Shm_Comm_Node,&Shm_NodeProcs);
+
+  /* the writers of the nodes, and the writer for each process */
+
+  MPI_Comm_split(mpi_comm_level1, (Shm_NodeID==0 ? 0 : MPI_UNDEFINED), myid, &Shm_Comm_Leader);
+
+  lid = 0;
+  if (Shm_NodeID==0) MPI_Comm_rank(Shm_Comm_Leader,&lid);
+  MPI_Bcast(&lid, 1, MPI_INT, 0, Shm_Comm_Node);
+
+  Shm_Leader = (int*)malloc(sizeof(int)*numprocs);
+  MPI_Allgather(&lid, 1, MPI_INT, Shm_Leader, 1, MPI_INT, mpi_comm_level1);
+
+  Shm_Num = 0;
+  Shm_Initialized = 1;
+}
+
+
+static int Shm_Find(void *table)
+{
+  int i;
+
+  if (table==NULL) return -1;
+
+  for (i=0; i<Shm_Num; i++){
+    if (Shm_List[i].table==table) return i;
+  }
+  return -1;
+}
+
+
+double ****Shm_Malloc_Double4(int n1, int n2, int n3, int n4)
+{
+  int i,j,k,disp;
+  long int size;
+  MPI_Aint qsize;
+  double *base,*local;
+  double ****a;
+
+  /* malloc as before */
+
+  if (Shared_Tables_flag==0){
+
+    a = (double****)malloc(sizeof(double***)*n1);
+    for (i=0; i<n1; i++){
+      a[i] = (double***)malloc(sizeof(double**)*n2);
+      for (j=0; j<n2; j++){
+        a[i][j] = (double**)malloc(sizeof(double*)*n3);
+        for (k=0; k<n3; k++){
+          a[i][j][k] = (double*)malloc(sizeof(double)*n4);
+        }
+      }
+    }
+
+    return a;
+  }
+
+  if (Shm_Initialized==0) Shm_Init();
+
+  if (Shm_MaxTables<=Shm_Num){
+    printf("Shm_Malloc_Double4: too many shared tables\n");
+    MPI_Finalize();
+    exit(1);
+  }
+
+  /* a window owned by the writer */
+
+  size = (long int)n1*n2*n3*n4;
+
+  MPI_Win_allocate_shared( (Shm_NodeID==0 ? (MPI_Aint)(sizeof(double)*size) : 0),
+                           sizeof(double), MPI_INFO_NULL, Shm_Comm_Node,
+                           &local, &Shm_List[Shm_Num].win );
+
+  MPI_Win_shared_query( Shm_List[Shm_Num].win, 0, &qsize, &disp, &base );
+  MPI_Win_lock_all( MPI_MODE_NOCHECK, Shm_List[Shm_Num].win );
+
+  /* pointer arrays of the process */
+
+  a = (double****)malloc(sizeof(double***)*n1);
+  Shm_List[Shm_Num].p2 = (double***)malloc(sizeof(double**)*n1*n2);
+  Shm_List[Shm_Num].p3 = (double**)malloc(sizeof(double*)*n1*n2*n3);
+
+  for (i=0; i<n1; i++){
+    a[i] = Shm_List[Shm_Num].p2 + i*n2;
+    for (j=0; j<n2; j++){
+      a[i][j] = Shm_List[Shm_Num].p3 + (i*n2+j)*n3;
+      for (k=0; k<n3; k++){
+        a[i][j][k] = base + ((long int)(i*n2+j)*n3+k)*n4;
+      }
+    }
+  }
+
+  Shm_List[Shm_Num].table = (void*)a;
+  Shm_List[Shm_Num].size = size;
+  Shm_Num++;
+
+  if (Shm_NodeID==0 && 0<size) memset(base, 0, sizeof(double)*size);
+  Shm_Sync();
+
+  return a;
+}
+
+
+double ****Shm_Share_Double4(double ****a, int n1, int n2, int n3, int n4)
+{
+  int i,j,k,l;
+  double ****b;
+
+  if (Shared_Tables_flag==0) return a;
+
+  b = Shm_Malloc_Double4(n1,n2,n3,n4);
+
+  if (Shm_Writer(b)){
+    for (i=0; i<n1; i++){
+      for (j=0; j<n2; j++){
+        for (k=0; k<n3; k++){
+          for (l=0; l<n4; l++){
+            b[i][j][k][l] = a[i][j][k][l];
+          }
+        }
+      }
+    }
+  }
+
+  Shm_Sync();
+
+  for (i=0; i<n1; i++){
+    for (j=0; j<n2; j++){
+      for (k=0; k<n3; k++){
+        free(a[i][j][k]);
+      }
+      free(a[i][j]);
+    }
+    free(a[i]);
+  }
+  free(a);
+
+  return b;
+}
+
+
+void Shm_Free_Double4(double ****a, int n1, int n2, int n3)
+{
+  int i,j,k,n;
+
+  n = Shm_Find((void*)a);
+
+  /* allocated by malloc */
+
+  if (n<0){
+
+    for (i=0; i<n1; i++){
+      for (j=0; j<n2; j++){
+        for (k=0; k<n3; k++){
+          free(a[i][j][k]);
+        }
+        free(a[i][j]);
+      }
+      free(a[i]);
+    }
+    free(a);
+
+    return;
+  }
+
+  /* allocated in a window */
+
+  MPI_Win_unlock_all(Shm_List[n].win);
+  MPI_Win_free(&Shm_List[n].win);
+  free(Shm_List[n].p3);
+  free(Shm_List[n].p2);
+  free(a);
+
+  Shm_Num--;
+  Shm_List[n] = Shm_List[Shm_Num];
+
+  /* the communicators are made again for the next mpi_comm_level1 */
+
+  if (Shm_Num==0){
+    free(Shm_Leader);
+    if (Shm_Comm_Leader!=MPI_COMM_NULL) MPI_Comm_free(&Shm_Comm_Leader);
+    MPI_Comm_free(&Shm_Comm_Node);
+    Shm_Initialized = 0;
+  }
+}
+
+
+int Shm_Writer(void *table)
+{
+  if (Shm_Find(table)<0) return 1;
+  return (Shm_NodeID==0);
+}
+
+
+void Shm_Sync()
+{
+  int n;
+
+  if (Shm_Initialized==0 || Shm_Num==0) return;
+
+  for (n=0; n<Shm_Num; n++) MPI_Win_sync(Shm_List[n].win);
+  MPI_Barrier(Shm_Comm_Node);
+  for (n=0; n<Shm_Num; n++) MPI_Win_sync(Shm_List[n].win);
+}
+
+
+void Shm_Bcast_Double(void *table, double *buf, int count, int root)
+{
+  /* root is the rank in mpi_comm_level1 which has the data.
+     In a shared table, the data is already in the window of its
+     node, so only the writers of the nodes communicate. */
+
+  if (Shm_Find(table)<0){
+    MPI_Bcast(buf, count, MPI_DOUBLE, root, mpi_comm_level1);
+    return;
+  }
+
+  Shm_Sync();
+
+  if (Shm_Comm_Leader!=MPI_COMM_NULL){
+    MPI_Bcast(buf, count, MPI_DOUBLE, Shm_Leader[root], Shm_Comm_Leader);
+  }
+
+  Shm_Sync();
+}
+
+
+void Shm_PrintMemory(char *name, void *table, long int size)
+{
+  char name2[YOUSO10];
+
+  if (Shm_Find(table)<0){
+    PrintMemory(name, size, NULL);
+  }
+  else{
+    sprintf(name2,"%s (node-shared by %d, saves %.2f MB)",
+            name,Shm_NodeProcs,(double)size*(Shm_NodeProcs-1)/Shm_NodeProcs/(1024*1024));
+    PrintMemory(name2, size/Shm_NodeProcs, NULL);
+  }
+}
@@ -0,0 +1,325 @@
+/**********************************************************************
+  Species_Cache.c:
+
+     Species_Cache.c is a set of subroutines for the cache of compiled
+     species, which saves the parsing of the PAO and VPS files and the
+     Fourier transforms of FT_PAO, FT_NLP, FT_ProExpn_VNA, FT_VNA and
+     FT_ProductPAO in repeated calculations.
+
+     Species_Cache_Images:  Host_ID reads the PAO and VPS files once,
+                            and broadcasts their images to all the
+                            processes, which parse them in memory
+     Species_Cache_fopen:   opens a file from its image if any
+     Species_Cache_Free:    frees the images
+     Species_Cache_File:    name of a table in the cache, keyed by a
+                            hash of the files and the parameters
+     Species_Cache_Read:    Host_ID reads a table and broadcasts it
+     Species_Cache_Write:   Host_ID writes a table
+
+     The cache is switched on by species.cache, and is stored in the
+     directory given by species.cache.dir.
+
+  Log of Species_Cache.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "openmx_common.h"
+#include "mpi.h"
+
+static struct {
+  char name[YOUSO10];
+  char *buf;
+  long int size;
+} *SC_Image;
+
+static int SC_Num = 0;
+static unsigned long long SC_Key = 0;
+
+static void SC_Hash(unsigned long long *h, void *p, size_t n);
+static void SC_Add_Image(char *name, int myid);
+
+
+
+void Species_Cache_Images()
+{
+  int spe,myid;
+  char FN[YOUSO10];
+  char DirPAO[YOUSO10];
+  char DirVPS[YOUSO10];
+  char ExtPAO[YOUSO10] = ".pao";
+  char ExtVPS[YOUSO10] = ".vps";
+
+  MPI_Comm_rank(MPI_COMM_WORLD1,&myid);
+
+  Species_Cache_Free();
+  SC_Key = 14695981039346656037ULL;  /* offset basis of FNV-1a */
+
+  if (Species_Cache_flag==0) return;
+
+  SC_Image = malloc(sizeof(*SC_Image)*2*real_SpeciesNum);
+
+  /* the cache is switched off if the path is too long, since
+     the key must contain the contents of the files */
+
+  if (YOUSO10<=snprintf(DirPAO,YOUSO10,"%s/PAO/",DFT_DATA_PATH) ||
+      YOUSO10<=snprintf(DirVPS,YOUSO10,"%s/VPS/",DFT_DATA_PATH)){
+    Species_Cache_flag = 0;
+    return;
+  }
+
+  for (spe=0; spe<real_SpeciesNum; spe++){
+    fnjoint2(DirPAO,SpeBasisName[spe],ExtPAO,FN);
+    SC_Add_Image(FN,myid);
+  }
+
+  for (spe=0; spe<real_SpeciesNum; spe++){
+    fnjoint2(DirVPS,SpeVPS[spe],ExtVPS,FN);
+    SC_Add_Image(FN,myid);
+  }
+}
+
+
+static void SC_Add_Image(char *name, int myid)
+{
+  int i;
+  long int size,n;
+  FILE *fp;
+
+  /* the same file of two species */
+
+  for (i=0; i<SC_Num; i++){
+    if (strcmp(SC_Image[i].name,name)==0) return;
+  }
+
+  /* Host_ID reads the file */
+
+  size = -1;
+
+  if (myid==Host_ID){
+    if ((fp = fopen(name,"rb")) != NULL){
+      fseek(fp,0,SEEK_END);
+      size = ftell(fp);
+      rewind(fp);
+      SC_Image[SC_Num].buf = (char*)malloc(sizeof(char)*(size+1));
+      n = fread(SC_Image[SC_Num].buf,sizeof(char),size,fp);
+      if (n!=size){ free(SC_Image[SC_Num].buf); size = -1; }
+      fclose(fp);
+    }
+  }
+
+  MPI_Bcast(&size, 1, MPI_LONG, Host_ID, MPI_COMM_WORLD1);
+
+  /* the file is opened as before, and the error is reported there */
+
+  if (size<0) return;
+
+  if (myid!=Host_ID){
+    SC_Image[SC_Num].buf = (char*)malloc(sizeof(char)*(size+1));
+  }
+
+  MPI_Bcast(SC_Image[SC_Num].buf, size, MPI_CHAR, Host_ID, MPI_COMM_WORLD1);
+  SC_Image[SC_Num].buf[size] = '\0';
+
+  strcpy(SC_Image[SC_Num].name,name);
+  SC_Image[SC_Num].size = size;
+
+  SC_Hash(&SC_Key, SC_Image[SC_Num].buf, size);
+  SC_Num++;
+}
+
+
+FILE *Species_Cache_fopen(char *name)
+{
+  int i;
+
+  for (i=0; i<SC_Num; i++){
+    if (strcmp(SC_Image[i].name,name)==0){
+      return fmemopen(SC_Image[i].buf, SC_Image[i].size, "r");
+    }
+  }
+
+  return fopen(name,"r");
+}
+
+
+void Species_Cache_Free()
+{
+  int i;
+
+  for (i=0; i<SC_Num; i++) free(SC_Image[i].buf);
+  free(SC_Image);
+
+  SC_Image = NULL;
+  SC_Num = 0;
+}
+
+
+int Species_Cache_File(char *ext, char *fname)
+{
+  static int warned=0;
+  int spe,myid,gl_mesh,len;
+  double kmin;
+  unsigned long long key;
+
+  if (Species_Cache_flag==0) return 0;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* the numerical parameters which the tables depend on */
+
+  key = SC_Key;
+  SC_Hash(&key, ext, strlen(ext));
+  SC_Hash(&key, List_YOUSO, sizeof(int)*NYOUSO);
+  SC_Hash(&key, &SpeciesNum, sizeof(int));
+  SC_Hash(&key, &SO_switch, sizeof(int));
+  SC_Hash(&key, &ProExpn_VNA, sizeof(int));
+  SC_Hash(&key, &Ngrid_NormK, sizeof(int));
+  SC_Hash(&key, &PAO_Nkmax, sizeof(double));
+  SC_Hash(&key, &OneD_Grid, sizeof(int));
+
+  /* constants of the build */
+
+  gl_mesh = GL_Mesh;
+  kmin = Radial_kmin;
+  SC_Hash(&key, &gl_mesh, sizeof(int));
+  SC_Hash(&key, &kmin, sizeof(double));
+
+  for (spe=0; spe<SpeciesNum; spe++){
+    SC_Hash(&key, &Spe_MaxL_Basis[spe], sizeof(int));
+    SC_Hash(&key, Spe_Num_Basis[spe], sizeof(int)*(Spe_MaxL_Basis[spe]+1));
+    SC_Hash(&key, &VPS_j_dependency[spe], sizeof(int));
+    SC_Hash(&key, &Spe_Num_RVPS[spe], sizeof(int));
+    SC_Hash(&key, &Spe_Atom_Cut1[spe], sizeof(double));
+    SC_Hash(&key, &Spe_Num_Mesh_PAO[spe], sizeof(int));
+    SC_Hash(&key, &Spe_Num_Mesh_VPS[spe], sizeof(int));
+  }
+
+  /* which files are assigned to which species, since the images
+     are hashed once per file */
+
+  for (spe=0; spe<real_SpeciesNum; spe++){
+    SC_Hash(&key, SpeBasisName[spe], strlen(SpeBasisName[spe])+1);
+    SC_Hash(&key, SpeVPS[spe], strlen(SpeVPS[spe])+1);
+  }
+
+  MPI_Bcast(&key, 1, MPI_UNSIGNED_LONG_LONG, Host_ID, mpi_comm_level1);
+
+  len = snprintf(fname,YOUSO10,"%s/%016llx%s",Species_Cache_Dir,key,ext);
+
+  /* the cache is not used if the name is truncated */
+
+  if (len<0 || YOUSO10<=len){
+    if (myid==Host_ID && warned==0){
+      printf("<Species_Cache>   species.cache.dir is too long, and the cache is not used\n");
+      warned = 1;
+    }
+    return 0;
+  }
+
+  return 1;
+}
+
+
+int Species_Cache_Read(char *fname, void *table, double **rows, int nrows, int len)
+{
+  int myid,i,po;
+  double *buf;
+  FILE *fp;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  /* Host_ID reads the table, and the others do not touch the file */
+
+  buf = (double*)malloc(sizeof(double)*((long int)nrows*len+1));
+
+  po = 0;
+  if (myid==Host_ID){
+    if ((fp = fopen(fname,"rb")) != NULL){
+      if (fread(buf,sizeof(double),(long int)nrows*len,fp)==(long int)nrows*len) po = 1;
+      fclose(fp);
+    }
+  }
+
+  MPI_Bcast(&po, 1, MPI_INT, Host_ID, mpi_comm_level1);
+
+  if (po==1){
+
+    /* in a node-shared table, only the writers of the nodes receive it */
+
+    Shm_Bcast_Double(table, buf, nrows*len, Host_ID);
+
+    if (Shm_Writer(table)){
+      for (i=0; i<nrows; i++){
+        memcpy(rows[i], &buf[(long int)i*len], sizeof(double)*len);
+      }
+    }
+    Shm_Sync();
+
+    if (myid==Host_ID && 0<level_stdout){
+      printf("<Species_Cache>   %s was read\n",fname);
+    }
+  }
+
+  free(buf);
+
+  return po;
+}
+
+
+void Species_Cache_Write(char *fname, double **rows, int nrows, int len)
+{
+  int myid,i,po;
+  char ftmp[YOUSO10+32];
+  FILE *fp;
+
+  MPI_Comm_rank(mpi_comm_level1,&myid);
+
+  if (myid!=Host_ID) return;
+
+  if (Species_Cache_flag==1) mkdir(Species_Cache_Dir,0775);
+
+  /* a temporal file is renamed, so that jobs sharing the cache
+     never read a table being written */
+
+  sprintf(ftmp,"%s.tmp%d",fname,(int)getpid());
+
+  if ((fp = fopen(ftmp,"wb")) != NULL){
+
+    po = 1;
+    for (i=0; i<nrows; i++){
+      if (fwrite(rows[i],sizeof(double),len,fp)!=len) po = 0;
+    }
+    fclose(fp);
+
+    if (po==0 || rename(ftmp,fname)!=0){
+      remove(ftmp);
+      printf("Could not write a file %s\n",fname);
+    }
+  }
+  else{
+    printf("Could not open a file %s\n",fname);
+  }
+}
+
+
+static void SC_Hash(unsigned long long *h, void *p, size_t n)
+{
+  size_t i;
+  unsigned char *c = (unsigned char*)p;
+
+  /* FNV-1a */
+
+  for (i=0; i<n; i++){
+    *h ^= (unsigned long long)c[i];
+    *h *= 1099511628211ULL;
+  }
+}
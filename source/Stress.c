@@ -7,11 +7,15 @@
   Log of Stress.c:
 
      150326 Kinetic and overlap terms are implemented by yshiihara.
+     18/Oct/2026 The mode "force+stress" accumulates atomic forces into
+                 Gxyz[][17,18,19] from the same derivative blocks used
+                 for the stress (called from Force()).
 ***********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 #include "openmx_common.h"
 #include "mpi.h"
@@ -21,7 +25,7 @@
 #define measure_time 0
 
 /*** subroutine */
-static void MPI_OLP(double *****OLP1);
+void MPI_OLP(double *****OLP1); /* from Force.c */
 static void Set_Lebedev_Grid();
 static void Stress3();
 static void Stress4();
@@ -46,7 +50,7 @@ static void dHNL(int where_flag,
 		 dcomplex ***Hx, dcomplex ***Hy, dcomplex ***Hz,
 		 dcomplex *****H_sts);
 
-static void dHNL_SO(
+void dHNL_SO( /* from Force.c */
 	     double *sumx0r,
 	     double *sumy0r, 
 	     double *sumz0r, 
@@ -83,10 +87,14 @@ static void dHNL_SO(
 #define  Num_Leb_Grid  590
 double Leb_Grid_XYZW[Num_Leb_Grid][4];
 
+/* 1: forces are accumulated into Gxyz[][17,18,19] along with the stress */
+static int Force_flag;
 
 
 
-double Stress(double *****H0,
+
+double Stress(char *mode,
+	      double *****H0,
 	      double ******DS_NL,
 	      double *****OLP,
 	      double *****CDM,
@@ -654,6 +662,11 @@ double Stress(double *****H0,
     Stress_Tensor[i] = 0.0;
   }
 
+  /* forces are evaluated together with the stress in case of "force+stress" */
+
+  if (strcasecmp(mode,"force+stress")==0) Force_flag = 1;
+  else                                     Force_flag = 0;
+
   /* Each stress component will be calculated below... */
 
   /****************************************************
@@ -940,6 +953,14 @@ double Stress(double *****H0,
 	My_Stress_threads[OMPID][8] -= (sumt1[8]+sumt2[8]+sumt3[8]+sumt4[8])*GridVol;
 	/* end(yshiihara) */
 
+	/* force #1 */
+
+	if (Force_flag){
+	  Gxyz[Gc_AN][17] = -sumx*GridVol;
+	  Gxyz[Gc_AN][18] = -sumy*GridVol;
+	  Gxyz[Gc_AN][19] = -sumz*GridVol;
+	}
+
 	dtime(&Etime_atom);
 	time_per_atom[Gc_AN] += Etime_atom - Stime_atom;
       
@@ -1677,6 +1698,14 @@ double Stress(double *****H0,
 	      My_Stress_threads[OMPID][7] += 0.5*dEy*lz;
 	      My_Stress_threads[OMPID][8] += 0.5*dEz*lz;
 
+	      /* force #2 */
+
+	      if (Force_flag){
+		Gxyz[Gc_AN][17] += dEx;
+		Gxyz[Gc_AN][18] += dEy;
+		Gxyz[Gc_AN][19] += dEz;
+	      }
+
 	    }
 
 	    /* collinear spin polarized or non-colliear without SO and LDA+U */
@@ -1725,6 +1754,14 @@ double Stress(double *****H0,
 	      My_Stress_threads[OMPID][6] += 0.5*dEx*lz;
 	      My_Stress_threads[OMPID][7] += 0.5*dEy*lz;
 	      My_Stress_threads[OMPID][8] += 0.5*dEz*lz;
+
+	      /* force #2 */
+
+	      if (Force_flag){
+		Gxyz[Gc_AN][17] += dEx;
+		Gxyz[Gc_AN][18] += dEy;
+		Gxyz[Gc_AN][19] += dEz;
+	      }
 	    }
 	    
 	    /* spin collinear with spin-orbit coupling */
@@ -1960,6 +1997,14 @@ double Stress(double *****H0,
 	    My_Stress_threads[OMPID][6] -= dx*lz;
 	    My_Stress_threads[OMPID][7] -= dy*lz;
 	    My_Stress_threads[OMPID][8] -= dz*lz;
+
+	    /* force #5 */
+
+	    if (Force_flag){
+	      Gxyz[Gc_AN][17] -= 2.0*dx;
+	      Gxyz[Gc_AN][18] -= 2.0*dy;
+	      Gxyz[Gc_AN][19] -= 2.0*dz;
+	    }
 	    
 	  } /* Hwan */
 	} /*i<Spe_Total_CNO*/
@@ -2335,7 +2380,17 @@ void Stress3()
 	dxyz[Nc][2] = dz;
 	/* end(yshiihara) */
 	
-	if (Cnt_switch==0){
+	/* gradients stored by Set_Orbitals_Grid() */
+
+	if (dOrbs_Grid_flag && dOrbs_Grid_kind==Cnt_switch){
+	  int i;
+	  for (i=0; i<NO0; i++){
+	    dorbs0[1][i] = dOrbs_Grid[Mc_AN][Nc][3*i  ];
+	    dorbs0[2][i] = dOrbs_Grid[Mc_AN][Nc][3*i+1];
+	    dorbs0[3][i] = dOrbs_Grid[Mc_AN][Nc][3*i+2];
+	  }
+	}
+	else if (Cnt_switch==0){
 	  Get_dOrbitals(Cwan,dx,dy,dz,dorbs0);
 	}else{
 	  Get_Cnt_dOrbitals(Mc_AN,dx,dy,dz,dorbs0);
@@ -2585,6 +2640,22 @@ void Stress3()
       My_Stress_threads[OMPID][7] += sumt[7]*GridVol; 
       My_Stress_threads[OMPID][8] += sumt[8]*GridVol;
       /* end(yshiihara)   */
+
+      /* force #3: the same reduction as in Force3() */
+
+      if (Force_flag){
+
+#pragma omp barrier
+#pragma omp master
+	{
+	  int t;
+	  for (t=0; t<Nthrds*3; t+=3){
+	    Gxyz[Gc_AN][17] += ai_sh_sum[t];
+	    Gxyz[Gc_AN][18] += ai_sh_sum[t+1];
+	    Gxyz[Gc_AN][19] += ai_sh_sum[t+2];
+	  }
+	}
+      }
       
     } /* Mc_AN */
 
@@ -2957,6 +3028,12 @@ void Stress4()
       My_Stress[j] += sumt[j]*GridVol*(double)F_VNA_flag;
     }
     /* end(yshiihara) */
+
+    if (Force_flag){
+      Gxyz[Gc_AN][17] += sumx*GridVol;
+      Gxyz[Gc_AN][18] += sumy*GridVol;
+      Gxyz[Gc_AN][19] += sumz*GridVol;
+    }
     
   }
 
@@ -3076,6 +3153,17 @@ void Stress4B(double *****CDM0)
     for (j=0; j<9; j++) My_Stress_threads[i][j] = 0.0;
   }
 
+  /* initialize the temporal array storing the force contribution */
+
+  if (Force_flag){
+    for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+      Gc_AN = F_M2G[Mc_AN];
+      Gxyz[Gc_AN][41] = 0.0;
+      Gxyz[Gc_AN][42] = 0.0;
+      Gxyz[Gc_AN][43] = 0.0;
+    }
+  }
+
   /* initialization of Stress and My_Stress */
 
   for (i=0; i<9; i++){
@@ -3167,9 +3255,11 @@ void Stress4B(double *****CDM0)
   /* When Stress.c is integrated into Force.c and Total_Energy.c, the following note is very important.
      if Stress() is called after calling Force(), the following calculations should be skipped.
      Otherwise, DS_VNA[kk] is multiplied by "ene" twice.
+     Force() calls Stress() before Force4B(), and Force4B() skips the multiplication
+     in case of "force+stress".
   */
 
-  if (0){
+  {
 
 #pragma omp parallel shared(CntDS_VNA,DS_VNA,Cnt_switch,VNA_proj_ene,VNA_List2,VNA_List,Num_RVNA,natn,FNAN,Spe_Total_CNO,WhatSpecies,F_M2G,Matomnum) private(kk,OMPID,Nthrds,Nprocs,Gc_AN,Cwan,tno0,Mc_AN,h_AN,Gh_AN,Hwan,i,l,l1,LL,Mul1,ene,l2,l3)
   {
@@ -3816,6 +3906,17 @@ void Stress4B(double *****CDM0)
 
   } /* #pragma omp parallel */
 
+  /* adding Gxyz[Gc_AN][41,42,43] to Gxyz[Gc_AN][17,18,19] */
+
+  if (Force_flag){
+    for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+      Gc_AN = M2G[Mc_AN];
+      Gxyz[Gc_AN][17] += Gxyz[Gc_AN][41];
+      Gxyz[Gc_AN][18] += Gxyz[Gc_AN][42];
+      Gxyz[Gc_AN][19] += Gxyz[Gc_AN][43];
+    }
+  }
+
   /* summing up results calculated by OpenMP threads */
 
   for(i=0; i<Nthrds0; i++){
@@ -4683,6 +4784,17 @@ void Stress_HNL(double *****CDM0, double *****iDM0)
     for (j=0; j<9; j++) My_Stress_threads[i][j] = 0.0;
   }
 
+  /* initialize the temporal array storing the force contribution */
+
+  if (Force_flag){
+    for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+      Gc_AN = F_M2G[Mc_AN];
+      Gxyz[Gc_AN][41] = 0.0;
+      Gxyz[Gc_AN][42] = 0.0;
+      Gxyz[Gc_AN][43] = 0.0;
+    }
+  }
+
   /* initialization of Stress and My_Stress */
 
   for (i=0; i<9; i++){
@@ -5785,6 +5897,17 @@ void Stress_HNL(double *****CDM0, double *****iDM0)
 
   } /* #pragma omp parallel */
 
+  /* adding Gxyz[Gc_AN][41,42,43] to Gxyz[Gc_AN][17,18,19] */
+
+  if (Force_flag){
+    for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+      Gc_AN = M2G[Mc_AN];
+      Gxyz[Gc_AN][17] += Gxyz[Gc_AN][41];
+      Gxyz[Gc_AN][18] += Gxyz[Gc_AN][42];
+      Gxyz[Gc_AN][19] += Gxyz[Gc_AN][43];
+    }
+  }
+
   /* summing up results calculated by OpenMP threads */
 
   for(i=0; i<Nthrds0; i++){
@@ -7860,781 +7983,6 @@ void dHNL(int where_flag,
 }
 
 
-void dHNL_SO(
-	     double *sumx0r,
-	     double *sumy0r, 
-	     double *sumz0r, 
-	     double *sumx1r,
-	     double *sumy1r, 
-	     double *sumz1r, 
-	     double *sumx2r,
-	     double *sumy2r, 
-	     double *sumz2r, 
-	     double *sumx0i,
-	     double *sumy0i, 
-	     double *sumz0i, 
-	     double *sumx1i,
-	     double *sumy1i, 
-	     double *sumz1i, 
-	     double *sumx2i,
-	     double *sumy2i, 
-	     double *sumz2i, 
-             double fugou,
-	     double PFp,
-	     double PFm,
-	     double ene_p,
-	     double ene_m,
-	     int l2, int *l,
-	     int Mc_AN, int k,  int m,
-	     int Mj_AN, int kl, int n,
-	     double ******DS_NL1)
-{
-
-  int l3,i;
-  double tmpx,tmpy,tmpz;
-  double tmp0,tmp1,tmp2;
-  double tmp3,tmp4,tmp5,tmp6;
-  double deri[4];
-
-  /****************************************************
-    off-diagonal contribution to up-dn matrix
-    for spin non-collinear
-  ****************************************************/
-
-  if (SpinP_switch==3){
-
-    /* p */ 
-    if (l2==2){
-
-      /* real contribution of l+1/2 to off diagonal up-down matrix */ 
-      tmpx = 
-        fugou*
-        ( ene_p/3.0*DS_NL1[0][1][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-         -ene_p/3.0*DS_NL1[0][1][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l  ] );      
-
-      tmpy = 
-        fugou*
-        ( ene_p/3.0*DS_NL1[0][2][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-         -ene_p/3.0*DS_NL1[0][2][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l  ] );      
-
-      tmpz = 
-        fugou*
-        ( ene_p/3.0*DS_NL1[0][3][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-         -ene_p/3.0*DS_NL1[0][3][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l  ] );      
-
-      *sumx2r += tmpx;
-      *sumy2r += tmpy;
-      *sumz2r += tmpz;
-
-      /* imaginary contribution of l+1/2 to off diagonal up-down matrix */ 
-
-      tmpx = 
-        fugou*
-        ( -ene_p/3.0*DS_NL1[0][1][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-          +ene_p/3.0*DS_NL1[0][1][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1] );
-
-      tmpy = 
-        fugou*
-        ( -ene_p/3.0*DS_NL1[0][2][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-          +ene_p/3.0*DS_NL1[0][2][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1] );
-
-      tmpz = 
-        fugou*
-        ( -ene_p/3.0*DS_NL1[0][3][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-          +ene_p/3.0*DS_NL1[0][3][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1] );
-
-      *sumx2i += tmpx;
-      *sumy2i += tmpy;
-      *sumz2i += tmpz;
-
-       /* real contribution of l-1/2 for to diagonal up-down matrix */ 
-
-      tmpx = 
-        fugou*
-        ( ene_m/3.0*DS_NL1[1][1][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-         -ene_m/3.0*DS_NL1[1][1][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l  ] );
-
-      tmpy = 
-        fugou*
-        ( ene_m/3.0*DS_NL1[1][2][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-         -ene_m/3.0*DS_NL1[1][2][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l  ] );
-
-      tmpz = 
-        fugou*
-        ( ene_m/3.0*DS_NL1[1][3][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-         -ene_m/3.0*DS_NL1[1][3][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l  ] );
-
-      *sumx2r -= tmpx;
-      *sumy2r -= tmpy;
-      *sumz2r -= tmpz;
-
-       /* imaginary contribution of l-1/2 to off diagonal up-down matrix */ 
-
-      tmpx = 
-        fugou*
-        ( -ene_m/3.0*DS_NL1[1][1][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-          +ene_m/3.0*DS_NL1[1][1][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1] );   
-
-      tmpy = 
-        fugou*
-        ( -ene_m/3.0*DS_NL1[1][2][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-          +ene_m/3.0*DS_NL1[1][2][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1] );   
-
-      tmpz = 
-        fugou*
-        ( -ene_m/3.0*DS_NL1[1][3][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-          +ene_m/3.0*DS_NL1[1][3][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1] );   
-
-      *sumx2i -= tmpx;
-      *sumy2i -= tmpy;
-      *sumz2i -= tmpz;
-
-    }
-
-    /* d */ 
-    if (l2==4){
-
-       tmp0 = sqrt(3.0);
-       tmp1 = ene_p/5.0; 
-       tmp2 = tmp0*tmp1;
-
-       /* real contribution of l+1/2 to off diagonal up-down matrix */ 
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-            fugou* 
-            ( -tmp2*DS_NL1[0][i][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-              +tmp2*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l  ]
-              +tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-              -tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-              +tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-              -tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+2] );
-       }
-       *sumx2r += deri[1];
-       *sumy2r += deri[2];
-       *sumz2r += deri[3];
-
-       /* imaginary contribution of l+1/2 to off diagonal up-down matrix */ 
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-            fugou* 
-            ( +tmp2*DS_NL1[0][i][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-              -tmp2*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l  ]
-              +tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-              -tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-              -tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-              +tmp1*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+2] );
-       }
-       *sumx2i += deri[1];
-       *sumy2i += deri[2];
-       *sumz2i += deri[3];
-
-       /* real contribution of l-1/2 for to diagonal up-down matrix */ 
-
-       tmp1 = ene_m/5.0; 
-       tmp2 = tmp0*tmp1;
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-            fugou* 
-            ( -tmp2*DS_NL1[1][i][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-              +tmp2*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l  ]
-              +tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-              -tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-              +tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-              -tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+2] );
-       }
-       *sumx2r -= deri[1];
-       *sumy2r -= deri[2];
-       *sumz2r -= deri[3];
-
-       /* imaginary contribution of l-1/2 to off diagonal up-down matrix */ 
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-            fugou* 
-	    ( +tmp2*DS_NL1[1][i][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-              -tmp2*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l  ]
-              +tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-              -tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-              -tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-	      +tmp1*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+2] );
-       }
-       *sumx2i -= deri[1];
-       *sumy2i -= deri[2];
-       *sumz2i -= deri[3];
-    }
-
-    /* f */ 
-    if (l2==6){
-
-      /* real contribution of l+1/2 to off diagonal up-down matrix */ 
-
-      tmp0 = sqrt(6.0);
-      tmp1 = sqrt(3.0/2.0);
-      tmp2 = sqrt(5.0/2.0);
-
-      tmp3 = ene_p/7.0; 
-      tmp4 = tmp1*tmp3; /* sqrt(3.0/2.0) */
-      tmp5 = tmp2*tmp3; /* sqrt(5.0/2.0) */
-      tmp6 = tmp0*tmp3; /* sqrt(6.0)     */
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-	   fugou*
-             ( -tmp6*DS_NL1[0][i][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-               +tmp6*DS_NL1[0][i][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l  ]
-               -tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-               +tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-               -tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-	       +tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-               -tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+5]
-	       +tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+5]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-               -tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+6]
-               +tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+6]*DS_NL1[0][0][Mj_AN][kl][n][*l+4] ); 
-       }
-       *sumx2r += deri[1];
-       *sumy2r += deri[2];
-       *sumz2r += deri[3];
-
-       /* imaginary contribution of l+1/2 to off diagonal up-down matrix */ 
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-	   fugou*
-	     ( +tmp6*DS_NL1[0][i][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-               -tmp6*DS_NL1[0][i][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l  ]
-               +tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-               -tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-               -tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-	       +tmp5*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-               +tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+6]
-	       -tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+6]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-               -tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+5]
-               +tmp4*DS_NL1[0][i][Mc_AN][k][m][*l+5]*DS_NL1[0][0][Mj_AN][kl][n][*l+4] );
-       }
-       *sumx2i += deri[1];
-       *sumy2i += deri[2];
-       *sumz2i += deri[3];
-
-       /* real contribution of l-1/2 for to diagonal up-down matrix */ 
-
-       tmp3 = ene_m/7.0; 
-       tmp4 = tmp1*tmp3; /* sqrt(3.0/2.0) */
-       tmp5 = tmp2*tmp3; /* sqrt(5.0/2.0) */
-       tmp6 = tmp0*tmp3; /* sqrt(6.0)     */
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-	   fugou*
-	     ( -tmp6*DS_NL1[1][i][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-               +tmp6*DS_NL1[1][i][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l  ]
-               -tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-               +tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-               -tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-	       +tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-               -tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+5]
-	       +tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+5]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-               -tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+6]
-               +tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+6]*DS_NL1[1][0][Mj_AN][kl][n][*l+4] );
-       }
-       *sumx2r -= deri[1];
-       *sumy2r -= deri[2];
-       *sumz2r -= deri[3];
-
-       /* imaginary contribution of l-1/2 to off diagonal up-down matrix */ 
-
-       for (i=1; i<=3; i++){
-         deri[i] = 
-            fugou* 
-	      ( +tmp6*DS_NL1[1][i][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-                -tmp6*DS_NL1[1][i][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l  ]
-                +tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-                -tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-                -tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-	        +tmp5*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-                +tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+6]
-	        -tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+6]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-                -tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+5]
-                +tmp4*DS_NL1[1][i][Mc_AN][k][m][*l+5]*DS_NL1[1][0][Mj_AN][kl][n][*l+4] );
-       }
-       *sumx2i -= deri[1];
-       *sumy2i -= deri[2];
-       *sumz2i -= deri[3];
-	   
-    }
-
-  }
-
-  /****************************************************
-      off-diagonal contribution on up-up and dn-dn
-  ****************************************************/
-
-  /* p */ 
-  if (l2==2){
- 
-    tmpx =
-       fugou*
-       ( ene_p/3.0*DS_NL1[0][1][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-        -ene_p/3.0*DS_NL1[0][1][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l  ] ); 
-
-    tmpy =
-       fugou*
-       ( ene_p/3.0*DS_NL1[0][2][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-        -ene_p/3.0*DS_NL1[0][2][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l  ] ); 
-
-    tmpz =
-       fugou*
-       ( ene_p/3.0*DS_NL1[0][3][Mc_AN][k][m][*l  ]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-        -ene_p/3.0*DS_NL1[0][3][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l  ] ); 
-
-    /* contribution of l+1/2 for up spin */ 
-    *sumx0i += -tmpx;
-    *sumy0i += -tmpy;
-    *sumz0i += -tmpz;
-
-    /* contribution of l+1/2 for down spin */ 
-    *sumx1i += tmpx;
-    *sumy1i += tmpy;
-    *sumz1i += tmpz;
-
-    tmpx =
-       fugou*
-       ( ene_m/3.0*DS_NL1[1][1][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-        -ene_m/3.0*DS_NL1[1][1][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l  ] ); 
-
-    tmpy =
-       fugou*
-       ( ene_m/3.0*DS_NL1[1][2][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-        -ene_m/3.0*DS_NL1[1][2][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l  ] ); 
-
-    tmpz =
-       fugou*
-       ( ene_m/3.0*DS_NL1[1][3][Mc_AN][k][m][*l  ]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-        -ene_m/3.0*DS_NL1[1][3][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l  ] ); 
-
-    /* contribution of l-1/2 for up spin */
-    *sumx0i += tmpx;
-    *sumy0i += tmpy;
-    *sumz0i += tmpz;
-
-    /* contribution of l+1/2 for down spin */ 
-    *sumx1i += -tmpx;
-    *sumy1i += -tmpy;
-    *sumz1i += -tmpz;
-  }
-
-  /* d */ 
-  else if (l2==4){
-
-    tmpx =
-       fugou*
-       (
-       ene_p*2.0/5.0*DS_NL1[0][1][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-      -ene_p*2.0/5.0*DS_NL1[0][1][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-      +ene_p*1.0/5.0*DS_NL1[0][1][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-      -ene_p*1.0/5.0*DS_NL1[0][1][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+3] ); 
-
-    tmpy =
-       fugou*
-       (
-       ene_p*2.0/5.0*DS_NL1[0][2][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-      -ene_p*2.0/5.0*DS_NL1[0][2][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-      +ene_p*1.0/5.0*DS_NL1[0][2][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-      -ene_p*1.0/5.0*DS_NL1[0][2][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+3] ); 
-
-    tmpz =
-       fugou*
-       (
-       ene_p*2.0/5.0*DS_NL1[0][3][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-      -ene_p*2.0/5.0*DS_NL1[0][3][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-      +ene_p*1.0/5.0*DS_NL1[0][3][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-      -ene_p*1.0/5.0*DS_NL1[0][3][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+3] ); 
-
-    /* contribution of l+1/2 for up spin */ 
-    *sumx0i += -tmpx;
-    *sumy0i += -tmpy;
-    *sumz0i += -tmpz;
-
-    /* contribution of l+1/2 for down spin */ 
-    *sumx1i += tmpx;
-    *sumy1i += tmpy;
-    *sumz1i += tmpz;
-
-    tmpx =
-       fugou*
-       (
-       ene_m*2.0/5.0*DS_NL1[1][1][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-      -ene_m*2.0/5.0*DS_NL1[1][1][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-      +ene_m*1.0/5.0*DS_NL1[1][1][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-      -ene_m*1.0/5.0*DS_NL1[1][1][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+3] ); 
-
-    tmpy = 
-       fugou*
-       (
-       ene_m*2.0/5.0*DS_NL1[1][2][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-      -ene_m*2.0/5.0*DS_NL1[1][2][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-      +ene_m*1.0/5.0*DS_NL1[1][2][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-      -ene_m*1.0/5.0*DS_NL1[1][2][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+3] ); 
-
-    tmpz =
-       fugou*
-       (
-       ene_m*2.0/5.0*DS_NL1[1][3][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-      -ene_m*2.0/5.0*DS_NL1[1][3][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-      +ene_m*1.0/5.0*DS_NL1[1][3][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-      -ene_m*1.0/5.0*DS_NL1[1][3][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+3] ); 
-
-    /* contribution of l-1/2 for up spin */ 
-    *sumx0i += tmpx;
-    *sumy0i += tmpy;
-    *sumz0i += tmpz;
-
-    /* contribution of l-1/2 for down spin */ 
-    *sumx1i += -tmpx;
-    *sumy1i += -tmpy;
-    *sumz1i += -tmpz;
-
-  }
-  
-  /* f */ 
-  else if (l2==6){
-
-    tmpx =
-       fugou*
-       (
-       ene_p*1.0/7.0*DS_NL1[0][1][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-      -ene_p*1.0/7.0*DS_NL1[0][1][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-      +ene_p*2.0/7.0*DS_NL1[0][1][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-      -ene_p*2.0/7.0*DS_NL1[0][1][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-      +ene_p*3.0/7.0*DS_NL1[0][1][Mc_AN][k][m][*l+5]*DS_NL1[0][0][Mj_AN][kl][n][*l+6]
-      -ene_p*3.0/7.0*DS_NL1[0][1][Mc_AN][k][m][*l+6]*DS_NL1[0][0][Mj_AN][kl][n][*l+5] );
-
-    tmpy = 
-       fugou*
-       (
-       ene_p*1.0/7.0*DS_NL1[0][2][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-      -ene_p*1.0/7.0*DS_NL1[0][2][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-      +ene_p*2.0/7.0*DS_NL1[0][2][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-      -ene_p*2.0/7.0*DS_NL1[0][2][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-      +ene_p*3.0/7.0*DS_NL1[0][2][Mc_AN][k][m][*l+5]*DS_NL1[0][0][Mj_AN][kl][n][*l+6]
-      -ene_p*3.0/7.0*DS_NL1[0][2][Mc_AN][k][m][*l+6]*DS_NL1[0][0][Mj_AN][kl][n][*l+5] );
-
-    tmpz =
-       fugou*
-       (
-       ene_p*1.0/7.0*DS_NL1[0][3][Mc_AN][k][m][*l+1]*DS_NL1[0][0][Mj_AN][kl][n][*l+2]
-      -ene_p*1.0/7.0*DS_NL1[0][3][Mc_AN][k][m][*l+2]*DS_NL1[0][0][Mj_AN][kl][n][*l+1]
-      +ene_p*2.0/7.0*DS_NL1[0][3][Mc_AN][k][m][*l+3]*DS_NL1[0][0][Mj_AN][kl][n][*l+4]
-      -ene_p*2.0/7.0*DS_NL1[0][3][Mc_AN][k][m][*l+4]*DS_NL1[0][0][Mj_AN][kl][n][*l+3]
-      +ene_p*3.0/7.0*DS_NL1[0][3][Mc_AN][k][m][*l+5]*DS_NL1[0][0][Mj_AN][kl][n][*l+6]
-      -ene_p*3.0/7.0*DS_NL1[0][3][Mc_AN][k][m][*l+6]*DS_NL1[0][0][Mj_AN][kl][n][*l+5] );
-
-    /* contribution of l+1/2 for up spin */ 
-    *sumx0i += -tmpx;
-    *sumy0i += -tmpy;
-    *sumz0i += -tmpz;
-
-    /* contribution of l+1/2 for down spin */ 
-    *sumx1i += tmpx;
-    *sumy1i += tmpy;
-    *sumz1i += tmpz;
-
-    tmpx =
-       fugou*
-       (
-       ene_m*1.0/7.0*DS_NL1[1][1][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-      -ene_m*1.0/7.0*DS_NL1[1][1][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-      +ene_m*2.0/7.0*DS_NL1[1][1][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-      -ene_m*2.0/7.0*DS_NL1[1][1][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-      +ene_m*3.0/7.0*DS_NL1[1][1][Mc_AN][k][m][*l+5]*DS_NL1[1][0][Mj_AN][kl][n][*l+6]
-      -ene_m*3.0/7.0*DS_NL1[1][1][Mc_AN][k][m][*l+6]*DS_NL1[1][0][Mj_AN][kl][n][*l+5] );
-
-    tmpy =
-       fugou*
-       (
-       ene_m*1.0/7.0*DS_NL1[1][2][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-      -ene_m*1.0/7.0*DS_NL1[1][2][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-      +ene_m*2.0/7.0*DS_NL1[1][2][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-      -ene_m*2.0/7.0*DS_NL1[1][2][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-      +ene_m*3.0/7.0*DS_NL1[1][2][Mc_AN][k][m][*l+5]*DS_NL1[1][0][Mj_AN][kl][n][*l+6]
-      -ene_m*3.0/7.0*DS_NL1[1][2][Mc_AN][k][m][*l+6]*DS_NL1[1][0][Mj_AN][kl][n][*l+5] );
-
-    tmpz =
-       fugou*
-       (
-       ene_m*1.0/7.0*DS_NL1[1][3][Mc_AN][k][m][*l+1]*DS_NL1[1][0][Mj_AN][kl][n][*l+2]
-      -ene_m*1.0/7.0*DS_NL1[1][3][Mc_AN][k][m][*l+2]*DS_NL1[1][0][Mj_AN][kl][n][*l+1]
-      +ene_m*2.0/7.0*DS_NL1[1][3][Mc_AN][k][m][*l+3]*DS_NL1[1][0][Mj_AN][kl][n][*l+4]
-      -ene_m*2.0/7.0*DS_NL1[1][3][Mc_AN][k][m][*l+4]*DS_NL1[1][0][Mj_AN][kl][n][*l+3]
-      +ene_m*3.0/7.0*DS_NL1[1][3][Mc_AN][k][m][*l+5]*DS_NL1[1][0][Mj_AN][kl][n][*l+6]
-      -ene_m*3.0/7.0*DS_NL1[1][3][Mc_AN][k][m][*l+6]*DS_NL1[1][0][Mj_AN][kl][n][*l+5] );
-
-    /* contribution of l-1/2 for up spin */ 
-    *sumx0i += tmpx;
-    *sumy0i += tmpy;
-    *sumz0i += tmpz;
-
-    /* contribution of l-1/2 for down spin */ 
-    *sumx1i += -tmpx;
-    *sumy1i += -tmpy;
-    *sumz1i += -tmpz;
-  }
-
-  /****************************************************
-      diagonal contribution on up-up and dn-dn
-  ****************************************************/
-
-  for (l3=0; l3<=l2; l3++){
-
-    /* VNL for j=l+1/2 */
-              
-    tmpx = PFp*ene_p*DS_NL1[0][1][Mc_AN][k][m][*l]*DS_NL1[0][0][Mj_AN][kl][n][*l];
-    tmpy = PFp*ene_p*DS_NL1[0][2][Mc_AN][k][m][*l]*DS_NL1[0][0][Mj_AN][kl][n][*l];
-    tmpz = PFp*ene_p*DS_NL1[0][3][Mc_AN][k][m][*l]*DS_NL1[0][0][Mj_AN][kl][n][*l];
-
-    *sumx0r += tmpx;
-    *sumy0r += tmpy;
-    *sumz0r += tmpz;
-
-    *sumx1r += tmpx;
-    *sumy1r += tmpy;
-    *sumz1r += tmpz;
-
-    /* VNL for j=l-1/2 */
-              
-    tmpx = PFm*ene_m*DS_NL1[1][1][Mc_AN][k][m][*l]*DS_NL1[1][0][Mj_AN][kl][n][*l];
-    tmpy = PFm*ene_m*DS_NL1[1][2][Mc_AN][k][m][*l]*DS_NL1[1][0][Mj_AN][kl][n][*l];
-    tmpz = PFm*ene_m*DS_NL1[1][3][Mc_AN][k][m][*l]*DS_NL1[1][0][Mj_AN][kl][n][*l];
-
-    *sumx0r += tmpx;
-    *sumy0r += tmpy;
-    *sumz0r += tmpz;
-
-    *sumx1r += tmpx;
-    *sumy1r += tmpy;
-    *sumz1r += tmpz;
-
-    *l = *l + 1;
-  }
-}
-
-
-  
-
-void MPI_OLP(double *****OLP1)
-{
-  int i,j,h_AN,Gh_AN,Hwan,n;
-  int tno1,tno2,Mc_AN,Gc_AN,Cwan;
-  int num,k,size1,size2;
-  double *tmp_array;
-  double *tmp_array2;
-  int *Snd_S_Size,*Rcv_S_Size;
-  int numprocs,myid,ID,IDS,IDR,tag=999;
-
-  MPI_Status stat;
-  MPI_Request request;
-
-  /* MPI */
-  MPI_Comm_size(mpi_comm_level1,&numprocs);
-  MPI_Comm_rank(mpi_comm_level1,&myid);
-
-  /****************************************************
-    allocation of arrays:
-  ****************************************************/
-
-  Snd_S_Size = (int*)malloc(sizeof(int)*numprocs);
-  Rcv_S_Size = (int*)malloc(sizeof(int)*numprocs);
-
-  /******************************************************************
-   MPI
-
-   OLP[1], OLP[2], and OLP[3]
-
-   note:
-
-   OLP is used in DC and GDC method, where overlap integrals
-   of Matomnum+MatomnumF+MatomnumS+1 are stored.
-   However, overlap integrals of Matomnum+MatomnumF+1 are
-   stored in Force.c. So, F_TopMAN should be used to refer
-   overlap integrals in Force.c, while S_TopMAN should be
-   used in DC and GDC routines.
-
-   Although OLP is used in Eff_Hub_Pot.c, the usage is 
-   consistent with that of DC and GDC routines by the following 
-   reason:
-
-   DC or GDC:      OLP + Spe_Total_NO   if no orbital optimization 
-                CntOLP + Spe_Total_CNO  if orbital optimization
-
-   Eff_Hub_Pot:    OLP + Spe_Total_NO   always since the U-potential
-                                        affects to primitive orbital 
-
-   If no orbital optimization, both the usages are consistent.
-   If orbital optimization, CntOLP and OLP are used in DC(GDC) and 
-   Eff_Hub_Pot.c, respectively. Therefore, there is no conflict. 
-  *******************************************************************/
-
-  /***********************************
-             set data size
-  ************************************/
-
-  for (ID=0; ID<numprocs; ID++){
-
-    IDS = (myid + ID) % numprocs;
-    IDR = (myid - ID + numprocs) % numprocs;
-
-    if (ID!=0){
-      tag = 999;
-
-      /* find data size to send block data */
-      if (F_Snd_Num[IDS]!=0){
-	size1 = 0;
-	for (n=0; n<F_Snd_Num[IDS]; n++){
-	  Mc_AN = Snd_MAN[IDS][n];
-	  Gc_AN = Snd_GAN[IDS][n];
-	  Cwan = WhatSpecies[Gc_AN]; 
-	  tno1 = Spe_Total_NO[Cwan];
-	  for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
-	    Gh_AN = natn[Gc_AN][h_AN];        
-	    Hwan = WhatSpecies[Gh_AN];
-	    tno2 = Spe_Total_NO[Hwan];
-            size1 += 4*tno1*tno2;
-	  }
-	}
-
-	Snd_S_Size[IDS] = size1;
-	MPI_Isend(&size1, 1, MPI_INT, IDS, tag, mpi_comm_level1, &request);
-      }
-      else{
-	Snd_S_Size[IDS] = 0;
-      }
-
-      /* receiving of size of data */
- 
-      if (F_Rcv_Num[IDR]!=0){
-	MPI_Recv(&size2, 1, MPI_INT, IDR, tag, mpi_comm_level1, &stat);
-	Rcv_S_Size[IDR] = size2;
-      }
-      else{
-	Rcv_S_Size[IDR] = 0;
-      }
-
-      if (F_Snd_Num[IDS]!=0) MPI_Wait(&request,&stat);
-    }
-    else{
-      Snd_S_Size[IDS] = 0;
-      Rcv_S_Size[IDR] = 0;
-    }
-  }
-
-  /***********************************
-               data transfer
-  ************************************/
-
-  tag = 999;
-  for (ID=0; ID<numprocs; ID++){
-
-    IDS = (myid + ID) % numprocs;
-    IDR = (myid - ID + numprocs) % numprocs;
-
-    if (ID!=0){
-
-      /*****************************
-                sending of data 
-      *****************************/
-
-      if (F_Snd_Num[IDS]!=0){
-
-	size1 = Snd_S_Size[IDS];
-
-	/* allocation of array */
-
-	tmp_array = (double*)malloc(sizeof(double)*size1);
-
-	/* multidimentional array to vector array */
-
-	num = 0;
-
-        for (k=0; k<=3; k++){
-  	  for (n=0; n<F_Snd_Num[IDS]; n++){
-	    Mc_AN = Snd_MAN[IDS][n];
-	    Gc_AN = Snd_GAN[IDS][n];
-	    Cwan = WhatSpecies[Gc_AN]; 
-	    tno1 = Spe_Total_NO[Cwan];
-	    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
-	      Gh_AN = natn[Gc_AN][h_AN];        
-	      Hwan = WhatSpecies[Gh_AN];
-	      tno2 = Spe_Total_NO[Hwan];
-	      for (i=0; i<tno1; i++){
-		for (j=0; j<tno2; j++){
-		  tmp_array[num] = OLP1[k][Mc_AN][h_AN][i][j];
-		  num++;
-		} 
-	      } 
-	    }
-	  }
-	}
-
-	MPI_Isend(&tmp_array[0], size1, MPI_DOUBLE, IDS, tag, mpi_comm_level1, &request);
-      }
-
-      /*****************************
-           receiving of block data
-      *****************************/
-
-      if (F_Rcv_Num[IDR]!=0){
-          
-	size2 = Rcv_S_Size[IDR];
-        
-	/* allocation of array */
-	tmp_array2 = (double*)malloc(sizeof(double)*size2);
-         
-	MPI_Recv(&tmp_array2[0], size2, MPI_DOUBLE, IDR, tag, mpi_comm_level1, &stat);
-
-	num = 0;
-
-        for (k=0; k<=3; k++){
-	  Mc_AN = F_TopMAN[IDR] - 1; /* F_TopMAN should be used. */
-  	  for (n=0; n<F_Rcv_Num[IDR]; n++){
-	    Mc_AN++;
-	    Gc_AN = Rcv_GAN[IDR][n];
-	    Cwan = WhatSpecies[Gc_AN]; 
-	    tno1 = Spe_Total_NO[Cwan];
-
-	    for (h_AN=0; h_AN<=FNAN[Gc_AN]; h_AN++){
-	      Gh_AN = natn[Gc_AN][h_AN];        
-	      Hwan = WhatSpecies[Gh_AN];
-	      tno2 = Spe_Total_NO[Hwan];
-	      for (i=0; i<tno1; i++){
-		for (j=0; j<tno2; j++){
-		  OLP1[k][Mc_AN][h_AN][i][j] = tmp_array2[num];
-		  num++;
-		}
-	      }
-	    }
-	  }        
-	}
-
-	/* freeing of array */
-	free(tmp_array2);
-      }
-
-      if (F_Snd_Num[IDS]!=0){
-	MPI_Wait(&request,&stat);
-	free(tmp_array); /* freeing of array */
-      }
-    }
-  }
- 
-  /****************************************************
-    freeing of arrays:
-  ****************************************************/
-
-  free(Snd_S_Size);
-  free(Rcv_S_Size);
-}
 
 void Set_Lebedev_Grid()
 {
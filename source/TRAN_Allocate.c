@@ -173,6 +173,8 @@ void TRAN_Deallocate_Lead_Region()
 {
   int k,iside;
 
+  TRAN_SelfEnergy_Cache_Free();
+
   for (iside=0; iside<=1; iside++){
     free(S00_e[iside]);
   }
@@ -1132,8 +1132,8 @@ static void Print_Voronoi_CDensity(
 static void TRAN_Voronoi_CDEN(double ***CDensity,
   int TRAN_OffDiagonalCurrent)
 {
-  int Mc_AN, Gc_AN, Nog, GNc, GRc, ispin, iaxis;
-  double Cxyz[4], x, y, z, FuzzyW;
+  int Mc_AN, Gc_AN, Nog, GNc, ispin, iaxis;
+  double FuzzyW, *FW;
   double ***VCurrent, *Voronoi_Vol;
 
   VCurrent = (double***)malloc(sizeof(double**) * (SpinP_switch + 1));
@@ -1152,18 +1152,15 @@ static void TRAN_Voronoi_CDEN(double ***CDensity,
 
     Gc_AN = M2G[Mc_AN];
 
-    for (Nog = 0; Nog<NumOLG[Mc_AN][0]; Nog++) {
+    /* calculate fuzzy weights */
 
-      /* calculate fuzzy weight */
+    FW = (double*)malloc(sizeof(double)*(GridN_Atom[Gc_AN] + 1));
+    Fuzzy_Weight_Grid(Mc_AN, FW);
 
-      GNc = GridListAtom[Mc_AN][Nog];
-      GRc = CellListAtom[Mc_AN][Nog];
+    for (Nog = 0; Nog<NumOLG[Mc_AN][0]; Nog++) {
 
-      Get_Grid_XYZ(GNc, Cxyz);
-      x = Cxyz[1] + atv[GRc][1];
-      y = Cxyz[2] + atv[GRc][2];
-      z = Cxyz[3] + atv[GRc][3];
-      FuzzyW = Fuzzy_Weight(Gc_AN, Mc_AN, 0, x, y, z);
+      GNc = GridListAtom[Mc_AN][Nog];
+      FuzzyW = FW[Nog];
 
       for (ispin = 0; ispin < SpinP_switch + 1; ispin++) {
         for (iaxis = 0; iaxis < 3; iaxis++) {
@@ -1175,6 +1172,8 @@ static void TRAN_Voronoi_CDEN(double ***CDensity,
 
     }/*for (Nog = 0; Nog<NumOLG[Mc_AN][0]; Nog++)*/
 
+    free(FW);
+
   } /* Mc_AN */
 
   for (ispin = 0; ispin < SpinP_switch + 1; ispin++) {
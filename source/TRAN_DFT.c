@@ -138,6 +138,7 @@ static void TRAN_DFT_Kdependent(
                           double k2,
                           double k3,
                           int k_op,
+                          int kloop,
                           int *order_GA,
                           double **DM1,
                           double **H1,
@@ -877,6 +878,14 @@ double TRAN_DFT_Original(
 
   size_H1 = Get_OneD_HS_Col(1, CntOLP, S1, MP, order_GA, My_NZeros, SP_NZeros, SP_Atoms);
 
+  /* the self energies of the leads are reused over the SCF iterations */
+
+  if      (SpinP_switch==0) spin = 1;
+  else if (SpinP_switch==1) spin = 2;
+  else if (SpinP_switch==3) spin = 1;
+
+  TRAN_SelfEnergy_Cache_Reset(iter, T_knum, tran_omega_n_scf*spin);
+
   /***********************************************************
    start "kloop0"
   ***********************************************************/
@@ -893,7 +902,7 @@ double TRAN_DFT_Original(
 
       TRAN_DFT_Kdependent(MPI_CommWD1[myworld1],
 			  parallel_mode, numprocs1, myid1,
-			  level_stdout, iter, SpinP_switch, k2, k3, k_op, order_GA,
+			  level_stdout, iter, SpinP_switch, k2, k3, k_op, kloop, order_GA,
                           DM1,H1,S1,
                           nh, ImNL, CntOLP,
 			  atomnum, Matomnum, WhatSpecies, Spe_Total_CNO, FNAN,
@@ -903,7 +912,7 @@ double TRAN_DFT_Original(
 
       TRAN_DFT_Kdependent(comm1,
 			  parallel_mode, 1, 0,
-			  level_stdout, iter, SpinP_switch, k2, k3, k_op, order_GA,
+			  level_stdout, iter, SpinP_switch, k2, k3, k_op, kloop, order_GA,
                           DM1,H1,S1,
                           nh, ImNL, CntOLP,
 			  atomnum, Matomnum, WhatSpecies, Spe_Total_CNO, FNAN,
@@ -1193,6 +1202,7 @@ static void TRAN_DFT_Kdependent(
                           double k2,
                           double k3,
                           int k_op,
+                          int kloop,
                           int *order_GA,
                           double **DM1,
                           double **H1,
@@ -1315,6 +1325,8 @@ static void TRAN_DFT_Kdependent(
   else if (SpinP_switch==1) spinsize = 2;
   else if (SpinP_switch==3) spinsize = 1;
 
+  TRAN_SelfEnergy_Cache_Set_Index(kloop, NUM_c, NUM_e, SCL, SCR, HCL, HCR, spinsize);
+
   /**************************************************************
              calculation of Green functions at k and iw
   **************************************************************/
@@ -1337,21 +1349,31 @@ static void TRAN_DFT_Kdependent(
 
     iside = 0;
 
-    TRAN_Calc_SurfGreen_direct(w, NUM_e[iside], H00_e[iside][k], H01_e[iside][k],
-			       S00_e[iside], S01_e[iside], tran_surfgreen_iteration_max,
-			       tran_surfgreen_eps, GRL);
+    if (!TRAN_SelfEnergy_Cache_Get(iside, kloop, Miw, NUM_c, SigmaL)){
+
+      TRAN_Calc_SurfGreen_direct(w, NUM_e[iside], H00_e[iside][k], H01_e[iside][k],
+				 S00_e[iside], S01_e[iside], tran_surfgreen_iteration_max,
+				 tran_surfgreen_eps, GRL);
 
-    TRAN_Calc_SelfEnergy(w, NUM_e[iside], GRL, NUM_c, HCL[k], SCL, SigmaL);
+      TRAN_Calc_SelfEnergy(w, NUM_e[iside], GRL, NUM_c, HCL[k], SCL, SigmaL);
+
+      TRAN_SelfEnergy_Cache_Put(iside, kloop, Miw, NUM_c, SigmaL);
+    }
 
     /* calculation of surface Green's function and self energy from the RIGHT lead */
 
     iside = 1;
 
-    TRAN_Calc_SurfGreen_direct(w, NUM_e[iside], H00_e[iside][k], H01_e[iside][k],
-			       S00_e[iside], S01_e[iside], tran_surfgreen_iteration_max,
-			       tran_surfgreen_eps, GRR);
+    if (!TRAN_SelfEnergy_Cache_Get(iside, kloop, Miw, NUM_c, SigmaR)){
+
+      TRAN_Calc_SurfGreen_direct(w, NUM_e[iside], H00_e[iside][k], H01_e[iside][k],
+				 S00_e[iside], S01_e[iside], tran_surfgreen_iteration_max,
+				 tran_surfgreen_eps, GRR);
 
-    TRAN_Calc_SelfEnergy(w, NUM_e[iside], GRR, NUM_c, HCR[k], SCR, SigmaR);
+      TRAN_Calc_SelfEnergy(w, NUM_e[iside], GRR, NUM_c, HCR[k], SCR, SigmaR);
+
+      TRAN_SelfEnergy_Cache_Put(iside, kloop, Miw, NUM_c, SigmaR);
+    }
 
     /* calculation of central retarded Green's function */
 
@@ -117,6 +117,14 @@ void TRAN_Input_std(
   input_int(   "NEGF.Surfgreen.iterationmax", &tran_surfgreen_iteration_max, 600);
   input_double("NEGF.Surfgreen.convergeeps", &tran_surfgreen_eps, 1.0e-12); 
 
+  /* reuse of the self energies of the leads over the SCF iterations */
+
+  input_logical("NEGF.SelfEnergy.Cache",&TRAN_SigmaCache_flag,1);
+  input_double("NEGF.SelfEnergy.Cache.MaxMem",&TRAN_SigmaCache_MaxMem,1000.0); /* in MByte */
+  input_logical("NEGF.SelfEnergy.Cache.Disk",&TRAN_SigmaCache_Disk,0);
+  strncpy(TRAN_SigmaCache_filepath,filepath,YOUSO10*2-1);
+  TRAN_SigmaCache_filepath[YOUSO10*2-1] = '\0';
+
   /****  k-points parallel to the layer, which are used for the SCF calc. ****/
 
   i_vec2[0]=1;
@@ -0,0 +1,279 @@
+/**********************************************************************
+  TRAN_SelfEnergy_Cache.c:
+
+  TRAN_SelfEnergy_Cache.c is a set of subroutines to keep the self
+  energies of the leads over the SCF iterations of the NEGF calculation.
+  Since H00_e, H01_e, HCL, HCR, SCL, SCR, and the contour points are
+  fixed during the SCF, Sigma_L and Sigma_R at each (k,w) are calculated
+  at the first SCF step only, and reused in the later steps.
+  Only the block of Sigma spanned by the orbitals in the C region
+  coupled with the leads is stored. Blocks exceeding the memory limit
+  given by NEGF.SelfEnergy.Cache.MaxMem are written to a scratch file
+  if NEGF.SelfEnergy.Cache.Disk is on, otherwise they are recalculated.
+
+  TRAN_SelfEnergy_Cache_Reset:     called from TRAN_DFT
+  TRAN_SelfEnergy_Cache_Set_Index: called from TRAN_DFT
+  TRAN_SelfEnergy_Cache_Get:       called from TRAN_DFT
+  TRAN_SelfEnergy_Cache_Put:       called from TRAN_DFT
+  TRAN_SelfEnergy_Cache_Free:      called from TRAN_Deallocate_Lead_Region
+
+  Log of TRAN_SelfEnergy_Cache.c:
+
+     18/Oct/2026   Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "tran_prototypes.h"
+#include "tran_variables.h"
+
+static int Cache_knum = 0;
+static int Cache_wnum = 0;
+static int Cache_iter = 0;
+static double Cache_Mem = 0.0;
+
+/* Cache_nb[iside][kloop]: # of orbitals in C coupled with the lead iside */
+static int *Cache_nb[2];
+/* Cache_idx[iside][kloop][i]: their indices (0-based) in C */
+static int **Cache_idx[2];
+/* Cache_Sigma[iside][kloop*wnum+Miw]: compact Sigma of size nb*nb */
+static dcomplex **Cache_Sigma[2];
+/* Cache_Stat: 0 not stored, 1 in memory, 2 in the scratch file */
+static char *Cache_Stat[2];
+static long *Cache_Offset[2];
+
+static FILE *Cache_fp = NULL;
+static long Cache_fp_end = 0;
+static char Cache_fname[YOUSO10*3];
+
+
+
+void TRAN_SelfEnergy_Cache_Reset(int iter, int knum, int wnum)
+{
+  int iside,i,n;
+
+  if (TRAN_SigmaCache_flag==0) return;
+
+  /* the cache is valid as long as the SCF steps go forward */
+
+  if (Cache_knum==knum && Cache_wnum==wnum && Cache_iter<iter){
+    Cache_iter = iter;
+    return;
+  }
+
+  TRAN_SelfEnergy_Cache_Free();
+
+  Cache_knum = knum;
+  Cache_wnum = wnum;
+  Cache_iter = iter;
+  n = knum*wnum;
+
+  for (iside=0; iside<=1; iside++){
+
+    Cache_nb[iside] = (int*)malloc(sizeof(int)*knum);
+    Cache_idx[iside] = (int**)malloc(sizeof(int*)*knum);
+    for (i=0; i<knum; i++){
+      Cache_nb[iside][i] = -1;
+      Cache_idx[iside][i] = NULL;
+    }
+
+    Cache_Sigma[iside] = (dcomplex**)malloc(sizeof(dcomplex*)*n);
+    Cache_Stat[iside] = (char*)malloc(sizeof(char)*n);
+    Cache_Offset[iside] = (long*)malloc(sizeof(long)*n);
+
+    for (i=0; i<n; i++){
+      Cache_Sigma[iside][i] = NULL;
+      Cache_Stat[iside][i] = 0;
+      Cache_Offset[iside][i] = -1;
+    }
+  }
+}
+
+
+
+/* find the orbitals in C coupled with the leads from the non-zero
+   rows of SCL (SCR) and HCL (HCR); Sigma vanishes outside them. */
+
+void TRAN_SelfEnergy_Cache_Set_Index(
+   int kloop, int nc, int ne[2],
+   dcomplex *SCL, dcomplex *SCR, dcomplex **HCL, dcomplex **HCR, int spinsize)
+{
+  int iside,i,j,k,nb,po;
+  dcomplex *sce,**hce;
+
+  if (TRAN_SigmaCache_flag==0) return;
+
+  for (iside=0; iside<=1; iside++){
+
+    if (0<=Cache_nb[iside][kloop]) continue;
+
+    if (iside==0){ sce = SCL; hce = HCL; }
+    else         { sce = SCR; hce = HCR; }
+
+    Cache_idx[iside][kloop] = (int*)malloc(sizeof(int)*nc);
+
+    nb = 0;
+    for (i=0; i<nc; i++){
+
+      po = 0;
+      for (j=0; j<ne[iside] && po==0; j++){
+        if (sce[nc*j+i].r!=0.0 || sce[nc*j+i].i!=0.0) po = 1;
+        for (k=0; k<spinsize; k++){
+          if (hce[k][nc*j+i].r!=0.0 || hce[k][nc*j+i].i!=0.0) po = 1;
+	}
+      }
+
+      if (po) Cache_idx[iside][kloop][nb++] = i;
+    }
+
+    Cache_nb[iside][kloop] = nb;
+  }
+}
+
+
+
+/* If Sigma at (kloop,Miw) has been stored, expand it into sigma
+   of size nc*nc and return 1. Otherwise return 0. */
+
+int TRAN_SelfEnergy_Cache_Get(int iside, int kloop, int Miw, int nc, dcomplex *sigma)
+{
+  int i,j,nb,n;
+  int *idx;
+  dcomplex *cs;
+
+  if (TRAN_SigmaCache_flag==0) return 0;
+
+  n = kloop*Cache_wnum + Miw;
+  if (Cache_Stat[iside][n]==0) return 0;
+
+  nb = Cache_nb[iside][kloop];
+  idx = Cache_idx[iside][kloop];
+
+  if (Cache_Stat[iside][n]==2){
+    cs = (dcomplex*)malloc(sizeof(dcomplex)*(nb*nb+1));
+    fseek(Cache_fp, Cache_Offset[iside][n], SEEK_SET);
+    if (fread(cs, sizeof(dcomplex), nb*nb, Cache_fp)!=nb*nb){
+      free(cs);
+      Cache_Stat[iside][n] = 0;
+      return 0;
+    }
+  }
+  else {
+    cs = Cache_Sigma[iside][n];
+  }
+
+  TRAN_Set_Value_double(sigma, nc*nc, 0.0, 0.0);
+
+  for (j=0; j<nb; j++){
+    for (i=0; i<nb; i++){
+      sigma[nc*idx[j]+idx[i]] = cs[nb*j+i];
+    }
+  }
+
+  if (Cache_Stat[iside][n]==2) free(cs);
+
+  return 1;
+}
+
+
+
+void TRAN_SelfEnergy_Cache_Put(int iside, int kloop, int Miw, int nc, dcomplex *sigma)
+{
+  int i,j,nb,n,myid;
+  int *idx;
+  double size;
+  dcomplex *cs;
+
+  if (TRAN_SigmaCache_flag==0) return;
+
+  n = kloop*Cache_wnum + Miw;
+  if (Cache_Stat[iside][n]!=0) return;
+
+  nb = Cache_nb[iside][kloop];
+  idx = Cache_idx[iside][kloop];
+  size = (double)sizeof(dcomplex)*(double)nb*(double)nb/(1024.0*1024.0);
+
+  cs = (dcomplex*)malloc(sizeof(dcomplex)*(nb*nb+1));
+
+  for (j=0; j<nb; j++){
+    for (i=0; i<nb; i++){
+      cs[nb*j+i] = sigma[nc*idx[j]+idx[i]];
+    }
+  }
+
+  /* in memory */
+
+  if ((Cache_Mem+size)<=TRAN_SigmaCache_MaxMem){
+    Cache_Sigma[iside][n] = cs;
+    Cache_Stat[iside][n] = 1;
+    Cache_Mem += size;
+    return;
+  }
+
+  /* in the scratch file */
+
+  if (TRAN_SigmaCache_Disk){
+
+    if (Cache_fp==NULL){
+      MPI_Comm_rank(MPI_COMM_WORLD,&myid);
+      sprintf(Cache_fname,"%snegf_sigma_cache_%i.tmp",TRAN_SigmaCache_filepath,myid);
+      Cache_fp = fopen(Cache_fname,"w+b");
+      Cache_fp_end = 0;
+      if (Cache_fp==NULL){
+        printf("TRAN_SelfEnergy_Cache: could not open %s, the disk cache is disabled.\n",
+               Cache_fname);
+        TRAN_SigmaCache_Disk = 0;
+      }
+    }
+
+    if (Cache_fp!=NULL){
+      fseek(Cache_fp, Cache_fp_end, SEEK_SET);
+      if (fwrite(cs, sizeof(dcomplex), nb*nb, Cache_fp)==nb*nb){
+        Cache_Offset[iside][n] = Cache_fp_end;
+        Cache_Stat[iside][n] = 2;
+        Cache_fp_end += (long)sizeof(dcomplex)*(long)nb*(long)nb;
+      }
+    }
+  }
+
+  free(cs);
+}
+
+
+
+void TRAN_SelfEnergy_Cache_Free()
+{
+  int iside,i;
+
+  if (Cache_knum==0) return;
+
+  for (iside=0; iside<=1; iside++){
+
+    for (i=0; i<Cache_knum; i++){
+      if (Cache_idx[iside][i]!=NULL) free(Cache_idx[iside][i]);
+    }
+    free(Cache_idx[iside]);
+    free(Cache_nb[iside]);
+
+    for (i=0; i<Cache_knum*Cache_wnum; i++){
+      if (Cache_Stat[iside][i]==1) free(Cache_Sigma[iside][i]);
+    }
+    free(Cache_Sigma[iside]);
+    free(Cache_Stat[iside]);
+    free(Cache_Offset[iside]);
+  }
+
+  if (Cache_fp!=NULL){
+    fclose(Cache_fp);
+    remove(Cache_fname);
+    Cache_fp = NULL;
+  }
+
+  Cache_knum = 0;
+  Cache_wnum = 0;
+  Cache_iter = 0;
+  Cache_Mem = 0.0;
+}
@@ -8,6 +8,7 @@
      22/Nov/2001  Released by T.Ozaki
      19/Feb/2006  The subroutine name 'Correction_Energy' was changed 
                   to 'Total_Energy'
+     18/Oct/2026  forces and DFT-D3 arrays shared by Atom_Exchange.c
 
 ***********************************************************************/
 
@@ -1098,7 +1099,7 @@ double Calc_EH0(int MD_iter)
   double dEx,dEy,dEz,Dx,Sx;
   double Z1,Z2,factor;
   double My_dEx,My_dEy,My_dEz;
-  int numprocs,myid,ID;
+  int numprocs,myid;
   double stime,etime;
   double Stime_atom, Etime_atom;
   /* for OpenMP */
@@ -1410,10 +1411,7 @@ double Calc_EH0(int MD_iter)
    MPI, Gxyz[Gc_AN][17-19]
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
   /****************************************************
     freeing of arrays:
@@ -1453,7 +1451,7 @@ void Calc_EXC_EH1(double ECE[],double *****CDM)
   double My_Eef,Eef;
   double My_Ena,Ena;
   double sum_charge,My_charge;
-  int numprocs,myid,tag=999,ID,IDS,IDR;
+  int numprocs,myid,tag=999,IDS,IDR;
   double Cxyz[4],gradxyz[4];
   double Stime_atom,Etime_atom;
   double time0,time1;
@@ -1904,10 +1902,9 @@ void Calc_EXC_EH1(double ECE[],double *****CDM)
    MPI, Gxyz[Gc_AN][17-19]
   ****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Gxyz[Gc_AN][17], 3, MPI_DOUBLE, ID, mpi_comm_level1);
+  Atom_Allgather_Double(Gxyz, 17, 3);
 
+  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
     if (2<=level_stdout && myid==Host_ID){
       printf("<Total_Ene>  force(t) myid=%2d Gc_AN=%2d  %15.12f %15.12f %15.12f\n",
               myid,Gc_AN,Gxyz[Gc_AN][17],Gxyz[Gc_AN][18],Gxyz[Gc_AN][19]);fflush(stdout);
@@ -3788,22 +3785,11 @@ double Calc_EdftD3()
 
   /*MPI BROADCAST GRADIENTS AND REDUCE ENERGIES - MPI_Barrier(mpi_comm_level1); */    
   MPI_Allreduce(&My_EdftD, &EdftD, 1, MPI_DOUBLE, MPI_SUM, mpi_comm_level1);
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    wanA = WhatSpecies[Gc_AN];
-    iZ = Spe_WhatAtom[wanA];
-    if ( iZ>0 ) {
-      ID = G2ID[Gc_AN];
-      MPI_Bcast(&CN[Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-      for (Gc_BN=1; Gc_BN<=atomnum; Gc_BN++){
-	wanB = WhatSpecies[Gc_BN];
-	iZ = Spe_WhatAtom[wanB];
-	if ( iZ>0 ) {
-	  MPI_Bcast(&dC6ij[Gc_AN][Gc_BN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-	  MPI_Bcast(&dEC0[Gc_AN][Gc_BN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-	}
-      } /* Gc_BN */
-    }
-  } /* Gc_AN */
+  /* the rows of all the atoms are shared, though only those with iZ>0 are used */
+
+  Atom_Allgather_Vector(&CN[1], 1);
+  Atom_Allgather_Double(dC6ij, 1, atomnum);
+  Atom_Allgather_Double(dEC0, 1, atomnum);
   MPI_Barrier(mpi_comm_level1); /* NOT SURE IF ITS NEEDED! */
 
   /* Calculate three body terms of gradients */
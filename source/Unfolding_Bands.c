@@ -7,6 +7,8 @@
   Log of Band_Unfolding.c:
 
       6/Jan/2016  Released by Chi-Cheng Lee
+     18/Oct/2026  weights of the states shared by the processes,
+                  and resumed by Band.restart
 
 ***********************************************************************/
 
@@ -42,6 +44,9 @@ static void buildMapRlist();
 static void buildtabr4RN(const double* a,const double* b,const double* c,double* origin,const int* mapN2n);
 static void abc_by_ABC(double** S);
 static void buildrnmap(const int* mapN2n);
+static void Unfold_Weight(dcomplex **v, double *K, double *a, double *b, double *c,
+                          dcomplex **weight);
+static unsigned long long Unfold_Path_Key(int nkpoint, double **kpoint);
 
 static void Unfolding_Bands_Col(
 				int nkpoint, double **kpoint,
@@ -85,17 +90,15 @@ static void Unfolding_Bands_Col(
   double* c;
   double* K;
   double* K2;
-  double* r;
-  double* r0;
-  double* kj_e;
-  int* iskj_e;
-  int countkj_e;
   double pk1,pk2,pk3;
   double dis2pk;
   double kdis;
   dcomplex** weight;
-  dcomplex*** kj_v;
-  dcomplex**** tmpelem;
+  dcomplex** kj_v;
+  int *sel,nsel,s0,K0,nf;
+  double *wbuf,*wall,*w;
+  char *exts[4] = {".unfold_totup",".unfold_orbup",".unfold_totdn",".unfold_orbdn"};
+  FILE *fps[4],*fp_tot,*fp_orb;
   double **fracabc;
 
   int i,j,k,l,n,wan;
@@ -105,7 +108,7 @@ static void Unfolding_Bands_Col(
   int ct_AN,h_AN,wanA,tnoA,wanB,tnoB;
   int GA_AN,Anum;
   int ii,ij,ik,Rn,AN;
-  int num0,num1,mul,m,wan1,Gc_AN;
+  int mul,m,wan1,Gc_AN;
   int LB_AN,GB_AN,Bnum;
   double time0,tmp,av_num;
   double snum_i,snum_j,snum_k,k1,k2,k3,sum,sumi,Num_State,FermiF;
@@ -130,7 +133,6 @@ static void Unfolding_Bands_Col(
   FILE *fp_EV1;
   FILE *fp_EV2;
   FILE *fp_EV3;
-  char buf[fp_bsize];          /* setvbuf */
   int numprocs,myid,ID;
   int *is1,*ie1;
   MPI_Status *stat_send;
@@ -313,27 +315,15 @@ static void Unfolding_Bands_Col(
          Solve eigenvalue problem at each k-point
   *****************************************************/
 
-  kj_e=(double*)malloc(sizeof(double)*4);
-  iskj_e=(int*)malloc(sizeof(int)*4);
   K=(double*)malloc(sizeof(double)*3);
   K2=(double*)malloc(sizeof(double)*3);
-  r=(double*)malloc(sizeof(double)*3);
-  r0=(double*)malloc(sizeof(double)*3);
   weight=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
   for (i=0; i<atomnum; i++) weight[i]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[i]);
-  kj_v=(dcomplex***)malloc(sizeof(dcomplex**)*4);
-  for (i=0; i<4; i++) {
-    kj_v[i]=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
-    for (j=0; j<atomnum; j++) kj_v[i][j]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
-  }
-  tmpelem=(dcomplex****)malloc(sizeof(dcomplex***)*atomnum);
-  for (i=0; i<atomnum; i++) tmpelem[i]=(dcomplex***)malloc(sizeof(dcomplex**)*atomnum);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) {
-    tmpelem[i][j]=(dcomplex**)malloc(sizeof(dcomplex*)*Norbperatom[i]);
-    for (k=0; k<Norbperatom[i]; k++) {
-      tmpelem[i][j][k]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
-    }
-  }
+  kj_v=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
+  for (j=0; j<atomnum; j++) kj_v[j]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
+  sel=(int*)malloc(sizeof(int)*(n+1));
+  wbuf=(double*)malloc(sizeof(double)*(Norb+1));
+  wall=(double*)malloc(sizeof(double)*(myid==Host_ID ? numprocs*(Norb+1) : 1));
 
   Name_Angular[0][0] = "s          ";
   Name_Angular[1][0] = "px         ";
@@ -368,10 +358,18 @@ static void Unfolding_Bands_Col(
   Name_Multiple[4] = "4";
   Name_Multiple[5] = "5";
 
+  /* the k-points already written are skipped if Band.restart is on */
+
+  nf = (SpinP_switch==1) ? 4 : 2;
+  K0 = Kpath_Restart_Open(".unfold_restart",totnkpts,n,Unfold_Path_Key(nkpoint,kpoint),nf,exts,fps);
+
   if (myid==Host_ID){
+
+    /* the header is appended to .EV only if the calculation is not resumed */
+
     strcpy(file_EV,".EV");
     fnjoint(filepath,filename,file_EV);
-    if ((fp_EV = fopen(file_EV,"a")) != NULL){
+    if (K0==0 && (fp_EV = fopen(file_EV,"a")) != NULL){
       fprintf(fp_EV,"\n");
       fprintf(fp_EV,"***********************************************************\n");
       fprintf(fp_EV,"***********************************************************\n");
@@ -442,12 +440,20 @@ static void Unfolding_Bands_Col(
       fclose(fp_EV);
 
     }
-    else{
+    else if (K0==0){
       printf("Failure of saving the EV file.\n");
       fclose(fp_EV);
     }
 
-    if (SpinP_switch==0) {
+    if (0<K0){
+      fp_EV  = fps[0];
+      fp_EV1 = fps[1];
+      if (SpinP_switch==1){
+        fp_EV2 = fps[2];
+        fp_EV3 = fps[3];
+      }
+    }
+    else if (SpinP_switch==0) {
 
       strcpy(file_EV,".unfold_totup");
       fnjoint(filepath,filename,file_EV);
@@ -498,6 +504,13 @@ static void Unfolding_Bands_Col(
 	fclose(fp_EV3);
       }
     }
+
+    fps[0] = fp_EV;
+    fps[1] = fp_EV1;
+    if (SpinP_switch==1){
+      fps[2] = fp_EV2;
+      fps[3] = fp_EV3;
+    }
   }
 
   int kloopi,kloopj;
@@ -673,6 +686,22 @@ static void Unfolding_Bands_Col(
         -coe*kpt1*(fracabc[0][0]*fracabc[2][1]-fracabc[2][0]*fracabc[0][1])
         +coe*kpt2*(fracabc[0][0]*fracabc[1][1]-fracabc[1][0]*fracabc[0][1]);
 
+      K[0]=k1*rtv[1][1]+k2*rtv[2][1]+k3*rtv[3][1];
+      K[1]=k1*rtv[1][2]+k2*rtv[2][2]+k3*rtv[3][2];
+      K[2]=k1*rtv[1][3]+k2*rtv[2][3]+k3*rtv[3][3];
+      K2[0]=pk1*rtv[1][1]+pk2*rtv[2][1]+pk3*rtv[3][1];
+      K2[1]=pk1*rtv[1][2]+pk2*rtv[2][2]+pk3*rtv[3][2];
+      K2[2]=pk1*rtv[1][3]+pk2*rtv[2][3]+pk3*rtv[3][3];
+      dis2pk=distwovec(K,K2);
+      kdis+=dis2pk;
+
+      if (kloop<=K0){
+        pk1=k1;
+        pk2=k2;
+        pk3=k3;
+        continue;
+      }
+
       /* make S */
 
       for (i1=1; i1<=n; i1++){
@@ -967,143 +996,75 @@ static void Unfolding_Bands_Col(
                           Output
       ****************************************************/
 
-      if (myid==Host_ID){
-
-#ifdef xt3
-        setvbuf(fp_EV,buf,_IOFBF,fp_bsize);  /* setvbuf */
-#endif
-
-	K[0]=k1*rtv[1][1]+k2*rtv[2][1]+k3*rtv[3][1];
-	K[1]=k1*rtv[1][2]+k2*rtv[2][2]+k3*rtv[3][2];
-	K[2]=k1*rtv[1][3]+k2*rtv[2][3]+k3*rtv[3][3];
-	K2[0]=pk1*rtv[1][1]+pk2*rtv[2][1]+pk3*rtv[3][1];
-	K2[1]=pk1*rtv[1][2]+pk2*rtv[2][2]+pk3*rtv[3][2];
-	K2[2]=pk1*rtv[1][3]+pk2*rtv[2][3]+pk3*rtv[3][3];
-	dis2pk=distwovec(K,K2);
-	kdis+=dis2pk;
-
-	num0 = 4;
-	num1 = n/num0 + 1*(n%num0!=0);
-
-	for (spin=0; spin<=SpinP_switch; spin++){
-	  for (i=1; i<=num1; i++){
+      /* the states in the energy window are shared by the processes,
+         and Host_ID writes their weights in the order of the states */
 
-            countkj_e=0;
-            for (j=0; j<4; j++) iskj_e[j]=0;
-
-	    for (i1=-2; i1<=0; i1++){
-
-	      for (j=1; j<=num0; j++){
-
-		j1 = num0*(i-1) + j;
+      for (spin=0; spin<=SpinP_switch; spin++){
 
-		if (j1<=n){ 
+	nsel = 0;
+	for (j1=1; j1<=n; j1++){
+	  if (((EIGEN[spin][j1]-ChemP)<=unfold_ubound)&&((EIGEN[spin][j1]-ChemP)>=unfold_lbound)) {
+	    sel[nsel++] = j1;
+	  }
+	}
 
-		  if (i1==-1){
+	for (s0=0; s0<nsel; s0+=numprocs){
 
-                    if (((EIGEN[spin][j1]-ChemP)<=unfold_ubound)&&((EIGEN[spin][j1]-ChemP)>=unfold_lbound)) {
-                      kj_e[countkj_e]=(EIGEN[spin][j1]-ChemP);
-                      iskj_e[countkj_e]=1; }
-                    countkj_e++;
+	  if (s0+myid<nsel){
 
-		  }
+	    j1 = sel[s0+myid];
 
-		}
+	    i1 = 1;
+	    for (j=0; j<atomnum; j++){
+	      for (k=0; k<Norbperatom[j]; k++){
+		kj_v[j][k] = C[spin][j1][i1];
+		i1++;
 	      }
 	    }
 
-	    i1 = 1; 
-            int iorb;
+	    Unfold_Weight(kj_v,K,a,b,c,weight);
 
-	    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-              iorb=0;
-
-	      wan1 = WhatSpecies[Gc_AN];
-            
-	      for (l=0; l<=Supported_MaxL; l++){
-		for (mul=0; mul<Spe_Num_CBasis[wan1][l]; mul++){
-		  for (m=0; m<(2*l+1); m++){
-
-                    countkj_e = 0;
-
-		    for (j=1; j<=num0; j++){
-
-		      j1 = num0*(i-1) + j;
+	    wbuf[0] = 0.0;
+	    for (j=0; j<atomnum; j++){
+	      for (k=0; k<Norbperatom[j]; k++){
+		wbuf[0] += weight[j][k].r;
+	      }
+	    }
 
-		      if (0<i1 && j1<=n){
-			kj_v[countkj_e++][Gc_AN-1][iorb]=Complex(C[spin][j1][i1].r,C[spin][j1][i1].i);
-		      }
-		    }
+	    /* set negative weight to zero for plotting purpose */
 
-		    i1++;
-                    iorb++;
-		  }
-		}
+	    i = 1;
+	    for (j=0; j<atomnum; j++){
+	      for (k=0; k<Norbperatom[j]; k++){
+		if (weight[j][k].r<0.0) wbuf[i] = 0.0;
+		else                    wbuf[i] = weight[j][k].r;
+		i++;
 	      }
 	    }
+	  }
 
-            for (countkj_e=0; countkj_e<4; countkj_e++) if (iskj_e[countkj_e]==1) {
-
-	      for (k=0; k<atomnum; k++) for (j=0; j<Norbperatom[k]; j++) weight[k][j]=Complex(0.,0.);
-
-	      for (j=0; j<atomnum; j++) for (k=0; k<atomnum; k++) for (l=0; l<Norbperatom[j]; l++)
-		for (m=0; m<Norbperatom[k]; m++) tmpelem[j][k][l][m]=Cmul(Conjg(kj_v[countkj_e][j][l]),kj_v[countkj_e][k][m]);
-
-	      int NA,ir,MA,MO,NO;
-	      dcomplex dtmp;
-	      for (NA=0; NA<atomnum; NA++) {
-		int n=unfold_mapN2n[NA]; int r0x=tabr4RN[0][NA][0]; int r0y=tabr4RN[0][NA][1]; int r0z=tabr4RN[0][NA][2];
-		r0[0]=r0x*a[0]+r0y*b[0]+r0z*c[0];
-		r0[1]=r0x*a[1]+r0y*b[1]+r0z*c[1];
-		r0[2]=r0x*a[2]+r0y*b[2]+r0z*c[2];
-		dcomplex phase1=Cexp(Complex(0.,-dot(K,r0)));
-		for (ir=0; ir<nr; ir++) {
-		  if (rnmap[ir][n][1]==-1) continue;
-		  r[0]=rlist[ir][0]*a[0]+rlist[ir][1]*b[0]+rlist[ir][2]*c[0];
-		  r[1]=rlist[ir][0]*a[1]+rlist[ir][1]*b[1]+rlist[ir][2]*c[1];
-		  r[2]=rlist[ir][0]*a[2]+rlist[ir][1]*b[2]+rlist[ir][2]*c[2];
-		  dcomplex phase2=Cmul(phase1,Cexp(Complex(0.,dot(K,r))));
-
-		  for (MA=0; MA<atomnum; MA++) {
-		    if (Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][0][0]<-99999.) continue;
-		    for (MO=0; MO<Norbperatom[MA]; MO++) for (NO=0; NO<Norbperatom[NA]; NO++) {
-		      dtmp=RCmul(Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][MO][NO],tmpelem[MA][NA][MO][NO]);
-		      weight[NA][NO]=Cadd(weight[NA][NO],Cmul(phase2,dtmp));
-		    }}}}
-
-	      double sumallorb=0.;
-
-	      for (j=0; j<atomnum; j++){
-                for (k=0; k<Norbperatom[j]; k++){
-                   sumallorb += weight[j][k].r;
-		}
-	      }
+	  MPI_Gather(wbuf,Norb+1,MPI_DOUBLE,wall,Norb+1,MPI_DOUBLE,Host_ID,mpi_comm_level1);
 
-	      if (spin==0) 
-                fprintf(fp_EV,"%f %f %10.7f\n",kdis,kj_e[countkj_e]*eV2Hartree,fabs(sumallorb)/coe);
-	      else 
-                fprintf(fp_EV2,"%f %f %10.7f\n",kdis,kj_e[countkj_e]*eV2Hartree,fabs(sumallorb)/coe);
+	  if (myid==Host_ID){
 
-	      /* set negative weight to zero for plotting purpose */
-	      for (j=0; j<atomnum; j++){
-                for (k=0; k<Norbperatom[j]; k++){
-                   if (weight[j][k].r<0.0) weight[j][k].r=0.0;
-		}
-	      }
+	    if (spin==0){ fp_tot = fp_EV;  fp_orb = fp_EV1; }
+	    else        { fp_tot = fp_EV2; fp_orb = fp_EV3; }
 
-	      if (spin==0) fprintf(fp_EV1,"%f %f ",kdis,kj_e[countkj_e]*eV2Hartree);
-	      else fprintf(fp_EV3,"%f %f ",kdis,kj_e[countkj_e]*eV2Hartree);
-	      for (j=0; j<atomnum; j++) {
-		if (spin==0) for (k=0; k<Norbperatom[j]; k++) fprintf(fp_EV1,"%e ",weight[j][k].r/coe);
-		else for (k=0; k<Norbperatom[j]; k++) fprintf(fp_EV3,"%e ",weight[j][k].r/coe);
-	      }
-	      if (spin==0) fprintf(fp_EV1,"\n");
-	      else fprintf(fp_EV3,"\n");
+	    for (ID=0; ID<numprocs && s0+ID<nsel; ID++){
+
+	      j1 = sel[s0+ID];
+	      w = &wall[ID*(Norb+1)];
+
+	      fprintf(fp_tot,"%f %f %10.7f\n",kdis,(EIGEN[spin][j1]-ChemP)*eV2Hartree,fabs(w[0])/coe);
+	      fprintf(fp_orb,"%f %f ",kdis,(EIGEN[spin][j1]-ChemP)*eV2Hartree);
+	      for (i=1; i<=Norb; i++) fprintf(fp_orb,"%e ",w[i]/coe);
+	      fprintf(fp_orb,"\n");
 	    }
 	  }
 	}
+      }
 
-      } /* if (myid==Host_ID) */
+      Kpath_Restart_Save(".unfold_restart",totnkpts,n,Unfold_Path_Key(nkpoint,kpoint),kloop,nf,fps);
    
       pk1=k1;
       pk2=k2;
@@ -1124,10 +1085,9 @@ static void Unfolding_Bands_Col(
 
   free(K);
   free(K2);
-  free(r);
-  free(r0);
-  free(kj_e);
-  free(iskj_e);
+  free(sel);
+  free(wbuf);
+  free(wall);
   free(unfold_mapN2n);
   free(a);
   free(b);
@@ -1135,8 +1095,7 @@ static void Unfolding_Bands_Col(
   free(unfold_origin);
   free(np);
   for (i=0; i<3; i++) free(unfold_abc[i]); free(unfold_abc);
-  for (i=0; i<4; i++) for (j=0; j<atomnum; j++) free(kj_v[i][j]);
-  for (i=0; i<4; i++) free(kj_v[i]); free(kj_v);
+  for (j=0; j<atomnum; j++) free(kj_v[j]); free(kj_v);
   for (i=0; i<atomnum; i++) free(weight[i]); free(weight);
   for (i=0; i<NR; i++) free(Rlist[i]); free(Rlist);
   for (i=0; i<nr; i++) free(rlist[i]); free(rlist);
@@ -1150,10 +1109,6 @@ static void Unfolding_Bands_Col(
   for (i=0; i<NR; i++) for (j=0; j<atomnum; j++) for (k=0; k<atomnum; k++) free(Elem[i][j][k]);
   for (i=0; i<NR; i++) for (j=0; j<atomnum; j++) free(Elem[i][j]);
   for (i=0; i<NR; i++) free(Elem[i]); free(Elem);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[i]; k++)
-    free(tmpelem[i][j][k]);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) free(tmpelem[i][j]);
-  for (i=0; i<atomnum; i++) free(tmpelem[i]); free(tmpelem);
   for (i=0; i<3; i++) free(fracabc[i]); free(fracabc);
   free(Norbperatom);
   for (i=0; i<unfold_Nkpoint+1; i++) free(unfold_kpoint[i]); free(unfold_kpoint);
@@ -1236,20 +1191,17 @@ static void Unfolding_Bands_NonCol(
   double* c;
   double* K;
   double* K2;
-  double* r;
-  double* r0;
-  double* kj_e;
-  int* iskj_e;
-  int countkj_e;
   double pk1,pk2,pk3;
   double dis2pk;
   double kdis;
   dcomplex** weight;
   dcomplex** weight1;
-  dcomplex*** kj_v;
-  dcomplex*** kj_v1;
-  dcomplex**** tmpelem;
-  dcomplex**** tmpelem1;
+  dcomplex** kj_v;
+  dcomplex** kj_v1;
+  int *sel,nsel,s0,K0,nf;
+  double *wbuf,*wall,*w;
+  char *exts[2] = {".unfold_tot",".unfold_orb"};
+  FILE *fps[2];
   double **fracabc;
 
   int i,j,k,l,n,wan,m,ii1,jj1,jj2,n2;
@@ -1263,7 +1215,7 @@ static void Unfolding_Bands_NonCol(
   int ct_AN,h_AN,wanA,tnoA,wanB,tnoB;
   int GA_AN,Anum;
   int ii,ij,ik,MaxN;
-  int wan1,mul,Gc_AN,num0,num1;
+  int wan1,mul,Gc_AN;
   int LB_AN,GB_AN,Bnum;
 
   double time0,tmp,av_num;
@@ -1297,7 +1249,6 @@ static void Unfolding_Bands_NonCol(
   FILE *fp_EV0;
   FILE *fp_EV;
   FILE *fp_EV1;
-  char buf[fp_bsize];          /* setvbuf */
   int numprocs,myid,ID;
   int OMPID,Nthrds,Nprocs;
   int *is1,*ie1;
@@ -1532,42 +1483,19 @@ static void Unfolding_Bands_NonCol(
          Solve eigenvalue problem at each k-point
   *****************************************************/
 
-  kj_e=(double*)malloc(sizeof(double)*2);
-  iskj_e=(int*)malloc(sizeof(int)*2);
   K=(double*)malloc(sizeof(double)*3);
   K2=(double*)malloc(sizeof(double)*3);
-  r=(double*)malloc(sizeof(double)*3);
-  r0=(double*)malloc(sizeof(double)*3);
   weight=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
   for (i=0; i<atomnum; i++) weight[i]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[i]);
   weight1=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
   for (i=0; i<atomnum; i++) weight1[i]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[i]);
-  kj_v=(dcomplex***)malloc(sizeof(dcomplex**)*2);
-  for (i=0; i<2; i++) {
-    kj_v[i]=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
-    for (j=0; j<atomnum; j++) kj_v[i][j]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
-  }
-  kj_v1=(dcomplex***)malloc(sizeof(dcomplex**)*2);
-  for (i=0; i<2; i++) {
-    kj_v1[i]=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
-    for (j=0; j<atomnum; j++) kj_v1[i][j]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
-  }
-  tmpelem=(dcomplex****)malloc(sizeof(dcomplex***)*atomnum);
-  for (i=0; i<atomnum; i++) tmpelem[i]=(dcomplex***)malloc(sizeof(dcomplex**)*atomnum);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) {
-    tmpelem[i][j]=(dcomplex**)malloc(sizeof(dcomplex*)*Norbperatom[i]);
-    for (k=0; k<Norbperatom[i]; k++) {
-      tmpelem[i][j][k]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
-    }
-  }
-  tmpelem1=(dcomplex****)malloc(sizeof(dcomplex***)*atomnum);
-  for (i=0; i<atomnum; i++) tmpelem1[i]=(dcomplex***)malloc(sizeof(dcomplex**)*atomnum);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) {
-    tmpelem1[i][j]=(dcomplex**)malloc(sizeof(dcomplex*)*Norbperatom[i]);
-    for (k=0; k<Norbperatom[i]; k++) {
-      tmpelem1[i][j][k]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
-    }
-  }
+  kj_v=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
+  for (j=0; j<atomnum; j++) kj_v[j]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
+  kj_v1=(dcomplex**)malloc(sizeof(dcomplex*)*atomnum);
+  for (j=0; j<atomnum; j++) kj_v1[j]=(dcomplex*)malloc(sizeof(dcomplex)*Norbperatom[j]);
+  sel=(int*)malloc(sizeof(int)*(2*n+1));
+  wbuf=(double*)malloc(sizeof(double)*(Norb+1));
+  wall=(double*)malloc(sizeof(double)*(myid==Host_ID ? numprocs*(Norb+1) : 1));
 
   Name_Angular[0][0] = "s          ";
   Name_Angular[1][0] = "px         ";
@@ -1602,10 +1530,18 @@ static void Unfolding_Bands_NonCol(
   Name_Multiple[4] = "4";
   Name_Multiple[5] = "5";
 
+  /* the k-points already written are skipped if Band.restart is on */
+
+  nf = 2;
+  K0 = Kpath_Restart_Open(".unfold_restart",totnkpts,2*n,Unfold_Path_Key(nkpoint,kpoint),nf,exts,fps);
+
   if (myid==Host_ID){
+
+    /* the header is appended to .EV only if the calculation is not resumed */
+
     strcpy(file_EV,".EV");
     fnjoint(filepath,filename,file_EV);
-    if ((fp_EV = fopen(file_EV,"a")) != NULL){
+    if (K0==0 && (fp_EV = fopen(file_EV,"a")) != NULL){
       fprintf(fp_EV,"\n");
       fprintf(fp_EV,"***********************************************************\n");
       fprintf(fp_EV,"***********************************************************\n");
@@ -1675,25 +1611,34 @@ static void Unfolding_Bands_NonCol(
       fprintf(fp_EV,"\n");
       fclose(fp_EV);
     }
-    else{
+    else if (K0==0){
       printf("Failure of saving the EV file.\n");
       fclose(fp_EV);
     }
 
-    strcpy(file_EV,".unfold_tot");
-    fnjoint(filepath,filename,file_EV);
-    fp_EV = fopen(file_EV,"w");
-    if (fp_EV == NULL) {
-      printf("Failure of saving the System.Name.unfold_totup file.\n");
-      fclose(fp_EV);
+    if (0<K0){
+      fp_EV  = fps[0];
+      fp_EV1 = fps[1];
     }
-    strcpy(file_EV,".unfold_orb");
-    fnjoint(filepath,filename,file_EV);
-    fp_EV1 = fopen(file_EV,"w");
-    if (fp_EV1 == NULL) {
-      printf("Failure of saving the System.Name.unfold_orbup file.\n");
-      fclose(fp_EV1);
+    else {
+      strcpy(file_EV,".unfold_tot");
+      fnjoint(filepath,filename,file_EV);
+      fp_EV = fopen(file_EV,"w");
+      if (fp_EV == NULL) {
+        printf("Failure of saving the System.Name.unfold_totup file.\n");
+        fclose(fp_EV);
+      }
+      strcpy(file_EV,".unfold_orb");
+      fnjoint(filepath,filename,file_EV);
+      fp_EV1 = fopen(file_EV,"w");
+      if (fp_EV1 == NULL) {
+        printf("Failure of saving the System.Name.unfold_orbup file.\n");
+        fclose(fp_EV1);
+      }
     }
+
+    fps[0] = fp_EV;
+    fps[1] = fp_EV1;
   }
 
   int kloopi,kloopj;
@@ -1865,6 +1810,22 @@ static void Unfolding_Bands_NonCol(
          -coe*kpt1*(fracabc[0][0]*fracabc[2][1]-fracabc[2][0]*fracabc[0][1])
          +coe*kpt2*(fracabc[0][0]*fracabc[1][1]-fracabc[1][0]*fracabc[0][1]);
 
+      K[0]=k1*rtv[1][1]+k2*rtv[2][1]+k3*rtv[3][1];
+      K[1]=k1*rtv[1][2]+k2*rtv[2][2]+k3*rtv[3][2];
+      K[2]=k1*rtv[1][3]+k2*rtv[2][3]+k3*rtv[3][3];
+      K2[0]=pk1*rtv[1][1]+pk2*rtv[2][1]+pk3*rtv[3][1];
+      K2[1]=pk1*rtv[1][2]+pk2*rtv[2][2]+pk3*rtv[3][2];
+      K2[2]=pk1*rtv[1][3]+pk2*rtv[2][3]+pk3*rtv[3][3];
+      dis2pk=distwovec(K,K2);
+      kdis+=dis2pk;
+
+      if (kloop<=K0){
+        pk1=k1;
+        pk2=k2;
+        pk3=k3;
+        continue;
+      }
+
       /* make S and H */
 
       for (i=1; i<=n; i++){
@@ -2236,152 +2197,68 @@ static void Unfolding_Bands_NonCol(
                         Output
       ****************************************************/
 
-      if (myid==Host_ID){
-
-#ifdef xt3
-	setvbuf(fp_EV,buf,_IOFBF,fp_bsize);  /* setvbuf */
-#endif
-
-	K[0]=k1*rtv[1][1]+k2*rtv[2][1]+k3*rtv[3][1];
-	K[1]=k1*rtv[1][2]+k2*rtv[2][2]+k3*rtv[3][2];
-	K[2]=k1*rtv[1][3]+k2*rtv[2][3]+k3*rtv[3][3];
-	K2[0]=pk1*rtv[1][1]+pk2*rtv[2][1]+pk3*rtv[3][1];
-	K2[1]=pk1*rtv[1][2]+pk2*rtv[2][2]+pk3*rtv[3][2];
-	K2[2]=pk1*rtv[1][3]+pk2*rtv[2][3]+pk3*rtv[3][3];
-	dis2pk=distwovec(K,K2);
-	kdis+=dis2pk;
-
-	num0 = 2;
-	num1 = 2*n/num0 + 1*((2*n)%num0!=0);
-  
-	for (i=1; i<=num1; i++){
-
-          countkj_e=0;
-          for (j=0; j<2; j++) iskj_e[j]=0;
-
-	  for (i1=-2; i1<=0; i1++){
+      /* the states in the energy window are shared by the processes,
+         and Host_ID writes their weights in the order of the states */
 
-	    for (j=1; j<=num0; j++){
-
-	      j1 = num0*(i-1) + j;
+      nsel = 0;
+      for (j1=1; j1<=2*n; j1++){
+	if (((EIGEN[j1]-ChemP)<=unfold_ubound)&&((EIGEN[j1]-ChemP)>=unfold_lbound)) {
+	  sel[nsel++] = j1;
+	}
+      }
 
-	      if (j1<=2*n){ 
+      for (s0=0; s0<nsel; s0+=numprocs){
 
-		if (i1==-1){
+	if (s0+myid<nsel){
 
-                  if (((EIGEN[j1]-ChemP)<=unfold_ubound)&&((EIGEN[j1]-ChemP)>=unfold_lbound)) {
-                    kj_e[countkj_e]=(EIGEN[j1]-ChemP);
-                    iskj_e[countkj_e]=1; }
-                  countkj_e++;
+	  j1 = sel[s0+myid];
 
-		}
-	      }
+	  i1 = 1;
+	  for (j=0; j<atomnum; j++){
+	    for (k=0; k<Norbperatom[j]; k++){
+	      kj_v[j][k]  = H[i1  ][j1];
+	      kj_v1[j][k] = H[i1+n][j1];
+	      i1++;
 	    }
 	  }
 
-	  i1 = 1; 
-          int iorb;
-
-	  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-            iorb=0;
-
-	    wan1 = WhatSpecies[Gc_AN];
-            
-	    for (l=0; l<=Supported_MaxL; l++){
-	      for (mul=0; mul<Spe_Num_CBasis[wan1][l]; mul++){
-		for (m=0; m<(2*l+1); m++){
-
-                  countkj_e=0;
-
-		  for (j=1; j<=num0; j++){
+	  Unfold_Weight(kj_v, K,a,b,c,weight);
+	  Unfold_Weight(kj_v1,K,a,b,c,weight1);
 
-		    j1 = num0*(i-1) + j;
+	  wbuf[0] = 0.0;
+	  for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[j]; k++) wbuf[0] += weight[j][k].r;
+	  for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[j]; k++) wbuf[0] += weight1[j][k].r;
 
-		    if (0<i1 && j1<=2*n){
-                      kj_v[countkj_e][Gc_AN-1][iorb]=Complex(H[i1][j1].r,H[i1][j1].i);
-                      kj_v1[countkj_e++][Gc_AN-1][iorb]=Complex(H[i1+n][j1].r,H[i1+n][j1].i);
-		    }
-		  }
+	  /* set negative weight to zero for plotting purpose */
 
-		  i1++;
-                  iorb++;
-		}
-	      }
+	  i = 1;
+	  for (j=0; j<atomnum; j++){
+	    for (k=0; k<Norbperatom[j]; k++){
+	      if ((weight[j][k].r+weight1[j][k].r)<0.0) wbuf[i] = 0.0;
+	      else                                      wbuf[i] = weight[j][k].r + weight1[j][k].r;
+	      i++;
 	    }
 	  }
+	}
 
-          for (countkj_e=0; countkj_e<2; countkj_e++) if (iskj_e[countkj_e]==1) {
-	    for (k=0; k<atomnum; k++) for (j=0; j<Norbperatom[k]; j++) weight[k][j]=Complex(0.,0.);
-	    for (k=0; k<atomnum; k++) for (j=0; j<Norbperatom[k]; j++) weight1[k][j]=Complex(0.,0.);
-
-	    for (j=0; j<atomnum; j++) for (k=0; k<atomnum; k++) for (l=0; l<Norbperatom[j]; l++)
-	      for (m=0; m<Norbperatom[k]; m++) tmpelem[j][k][l][m]=Cmul(Conjg(kj_v[countkj_e][j][l]),kj_v[countkj_e][k][m]);
-	    for (j=0; j<atomnum; j++) for (k=0; k<atomnum; k++) for (l=0; l<Norbperatom[j]; l++)
-	      for (m=0; m<Norbperatom[k]; m++) tmpelem1[j][k][l][m]=Cmul(Conjg(kj_v1[countkj_e][j][l]),kj_v1[countkj_e][k][m]);
-
-	    int NA,ir,MA,MO,NO;
-	    dcomplex dtmp,dtmp1;
-
-	    for (NA=0; NA<atomnum; NA++) {
-
-	      int n=unfold_mapN2n[NA]; 
-              int r0x=tabr4RN[0][NA][0]; 
-              int r0y=tabr4RN[0][NA][1]; 
-              int r0z=tabr4RN[0][NA][2];
-
-	      r0[0]=r0x*a[0]+r0y*b[0]+r0z*c[0];
-	      r0[1]=r0x*a[1]+r0y*b[1]+r0z*c[1];
-	      r0[2]=r0x*a[2]+r0y*b[2]+r0z*c[2];
-
-	      dcomplex phase1=Cexp(Complex(0.,-dot(K,r0)));
-
-	      for (ir=0; ir<nr; ir++) {
-
-		if (rnmap[ir][n][1]==-1) continue;
-
-		r[0]=rlist[ir][0]*a[0]+rlist[ir][1]*b[0]+rlist[ir][2]*c[0];
-		r[1]=rlist[ir][0]*a[1]+rlist[ir][1]*b[1]+rlist[ir][2]*c[1];
-		r[2]=rlist[ir][0]*a[2]+rlist[ir][1]*b[2]+rlist[ir][2]*c[2];
-
-		dcomplex phase2=Cmul(phase1,Cexp(Complex(0.,dot(K,r))));
-
-		for (MA=0; MA<atomnum; MA++) {
-
-		  if (Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][0][0]<-99999.) continue;
+	MPI_Gather(wbuf,Norb+1,MPI_DOUBLE,wall,Norb+1,MPI_DOUBLE,Host_ID,mpi_comm_level1);
 
-		  for (MO=0; MO<Norbperatom[MA]; MO++) for (NO=0; NO<Norbperatom[NA]; NO++) {
-		    dtmp=RCmul(Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][MO][NO],tmpelem[MA][NA][MO][NO]);
-		    dtmp1=RCmul(Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][MO][NO],tmpelem1[MA][NA][MO][NO]);
-		    weight[NA][NO]=Cadd(weight[NA][NO],Cmul(phase2,dtmp));
-		    weight1[NA][NO]=Cadd(weight1[NA][NO],Cmul(phase2,dtmp1));
-		  }}}}
+	if (myid==Host_ID){
 
-	    double sumallorb=0.;
-	    for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[j]; k++) sumallorb+=weight[j][k].r;
-	    for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[j]; k++) sumallorb+=weight1[j][k].r;
-	    fprintf(fp_EV,"%f %f %10.7f\n",kdis,kj_e[countkj_e]*eV2Hartree,fabs(sumallorb)/coe);
+	  for (ID=0; ID<numprocs && s0+ID<nsel; ID++){
 
-	    /* set negative weight to zero for plotting purpose */
-	    for (j=0; j<atomnum; j++){
-              for (k=0; k<Norbperatom[j]; k++){
-
-  	        if ( (weight[j][k].r+weight1[j][k].r)<0.0) {
-                   weight[j][k].r  = 0.0; 
-                   weight1[j][k].r = 0.0; 
-                }
-	      }
-	    }
+	    j1 = sel[s0+ID];
+	    w = &wall[ID*(Norb+1)];
 
-	    fprintf(fp_EV1,"%f %f ",kdis,kj_e[countkj_e]*eV2Hartree);
-	    for (j=0; j<atomnum; j++) {
-	      for (k=0; k<Norbperatom[j]; k++) fprintf(fp_EV1,"%e ",(weight[j][k].r+weight1[j][k].r)/coe);
-	    }
+	    fprintf(fp_EV,"%f %f %10.7f\n",kdis,(EIGEN[j1]-ChemP)*eV2Hartree,fabs(w[0])/coe);
+	    fprintf(fp_EV1,"%f %f ",kdis,(EIGEN[j1]-ChemP)*eV2Hartree);
+	    for (i=1; i<=Norb; i++) fprintf(fp_EV1,"%e ",w[i]/coe);
 	    fprintf(fp_EV1,"\n");
-          }  
-        }
-      } /* if (myid==Host_ID) */
+	  }
+	}
+      }
 
-      MPI_Barrier(mpi_comm_level1);
+      Kpath_Restart_Save(".unfold_restart",totnkpts,2*n,Unfold_Path_Key(nkpoint,kpoint),kloop,nf,fps);
 
       pk1=k1;
       pk2=k2;
@@ -2401,10 +2278,9 @@ static void Unfolding_Bands_NonCol(
 
   free(K);
   free(K2);
-  free(r);
-  free(r0);
-  free(kj_e);
-  free(iskj_e);
+  free(sel);
+  free(wbuf);
+  free(wall);
   free(unfold_mapN2n);
   free(a);
   free(b);
@@ -2413,10 +2289,8 @@ static void Unfolding_Bands_NonCol(
   free(np);
 
   for (i=0; i<3; i++) free(unfold_abc[i]); free(unfold_abc);
-  for (i=0; i<2; i++) for (j=0; j<atomnum; j++) free(kj_v[i][j]);
-  for (i=0; i<2; i++) free(kj_v[i]); free(kj_v);
-  for (i=0; i<2; i++) for (j=0; j<atomnum; j++) free(kj_v1[i][j]);
-  for (i=0; i<2; i++) free(kj_v1[i]); free(kj_v1);
+  for (j=0; j<atomnum; j++) free(kj_v[j]); free(kj_v);
+  for (j=0; j<atomnum; j++) free(kj_v1[j]); free(kj_v1);
   for (i=0; i<atomnum; i++) free(weight[i]); free(weight);
   for (i=0; i<atomnum; i++) free(weight1[i]); free(weight1);
   for (i=0; i<NR; i++) free(Rlist[i]); free(Rlist);
@@ -2431,14 +2305,6 @@ static void Unfolding_Bands_NonCol(
   for (i=0; i<NR; i++) for (j=0; j<atomnum; j++) for (k=0; k<atomnum; k++) free(Elem[i][j][k]);
   for (i=0; i<NR; i++) for (j=0; j<atomnum; j++) free(Elem[i][j]);
   for (i=0; i<NR; i++) free(Elem[i]); free(Elem);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[i]; k++)
-    free(tmpelem[i][j][k]);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) free(tmpelem[i][j]);
-  for (i=0; i<atomnum; i++) free(tmpelem[i]); free(tmpelem);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) for (k=0; k<Norbperatom[i]; k++)
-    free(tmpelem1[i][j][k]);
-  for (i=0; i<atomnum; i++) for (j=0; j<atomnum; j++) free(tmpelem1[i][j]);
-  for (i=0; i<atomnum; i++) free(tmpelem1[i]); free(tmpelem1);
   for (i=0; i<3; i++) free(fracabc[i]); free(fracabc);
   free(Norbperatom);
   for (i=0; i<unfold_Nkpoint+1; i++) free(unfold_kpoint[i]); free(unfold_kpoint);
@@ -2506,6 +2372,78 @@ static void Unfolding_Bands_NonCol(
 }
 
 
+static void Unfold_Weight(dcomplex **v, double *K, double *a, double *b, double *c,
+                          dcomplex **weight)
+{
+  int NA;
+
+  /* weight[NA][NO] of a state given by the coefficients v,
+     where the products of v are taken on the fly */
+
+#pragma omp parallel for shared(v,K,a,b,c,weight,atomnum,nr,Norbperatom,unfold_mapN2n,tabr4RN,rlist,rnmap,Elem)
+
+  for (NA=0; NA<atomnum; NA++) {
+
+    int n,ir,MA,MO,NO;
+    double r[3],r0[3];
+    dcomplex phase1,phase2,dtmp;
+
+    for (NO=0; NO<Norbperatom[NA]; NO++) weight[NA][NO]=Complex(0.,0.);
+
+    n=unfold_mapN2n[NA];
+
+    r0[0]=tabr4RN[0][NA][0]*a[0]+tabr4RN[0][NA][1]*b[0]+tabr4RN[0][NA][2]*c[0];
+    r0[1]=tabr4RN[0][NA][0]*a[1]+tabr4RN[0][NA][1]*b[1]+tabr4RN[0][NA][2]*c[1];
+    r0[2]=tabr4RN[0][NA][0]*a[2]+tabr4RN[0][NA][1]*b[2]+tabr4RN[0][NA][2]*c[2];
+
+    phase1=Cexp(Complex(0.,-dot(K,r0)));
+
+    for (ir=0; ir<nr; ir++) {
+
+      if (rnmap[ir][n][1]==-1) continue;
+
+      r[0]=rlist[ir][0]*a[0]+rlist[ir][1]*b[0]+rlist[ir][2]*c[0];
+      r[1]=rlist[ir][0]*a[1]+rlist[ir][1]*b[1]+rlist[ir][2]*c[1];
+      r[2]=rlist[ir][0]*a[2]+rlist[ir][1]*b[2]+rlist[ir][2]*c[2];
+
+      phase2=Cmul(phase1,Cexp(Complex(0.,dot(K,r))));
+
+      for (MA=0; MA<atomnum; MA++) {
+
+        if (Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][0][0]<-99999.) continue;
+
+        for (MO=0; MO<Norbperatom[MA]; MO++) for (NO=0; NO<Norbperatom[NA]; NO++) {
+          dtmp=RCmul(Elem[rnmap[ir][n][0]][MA][rnmap[ir][n][1]][MO][NO],Cmul(Conjg(v[MA][MO]),v[NA][NO]));
+          weight[NA][NO]=Cadd(weight[NA][NO],Cmul(phase2,dtmp));
+        }
+      }
+    }
+  }
+}
+
+
+static unsigned long long Unfold_Path_Key(int nkpoint, double **kpoint)
+{
+  int i;
+  unsigned long long key;
+
+  /* the end points and the numbers of k-points of the segments,
+     and the reference cell which the weights depend on */
+
+  key = 0;
+  for (i=0; i<nkpoint; i++){
+    key = Kpath_Restart_Hash(key, &np[i], sizeof(int));
+    key = Kpath_Restart_Hash(key, &kpoint[i][1], sizeof(double)*3);
+  }
+  for (i=0; i<3; i++){
+    key = Kpath_Restart_Hash(key, unfold_abc[i], sizeof(double)*3);
+  }
+  key = Kpath_Restart_Hash(key, unfold_origin, sizeof(double)*3);
+
+  return key;
+}
+
+
 static double volume(const double* a,const double* b,const double* c) {
   return fabs(a[0]*b[1]*c[2]+b[0]*c[1]*a[2]+c[0]*a[1]*b[2]-c[0]*b[1]*a[2]-a[1]*b[0]*c[2]-a[0]*c[1]*b[2]);}
 
@@ -6,6 +6,8 @@
   Log of Voronoi_Charge.c:
 
      2/Feb/2004  Released by T.Ozaki
+     18/Oct/2026  VC and Voronoi_Vol shared by Atom_Allgather_Vector
+     18/Oct/2026  fuzzy weights by Fuzzy_Weight_Grid
 
 ***********************************************************************/
 
@@ -22,10 +24,9 @@ void Voronoi_Charge()
 {
   double time0;
   int Mc_AN,Gc_AN,Mh_AN,h_AN,Gh_AN;
-  int Cwan,GNc,GRc,Nog,Nh,MN,spin;
-  double x,y,z,dx,dy,dz,fw;
-  double Cxyz[4];
-  double FuzzyW,sum0,sum1;
+  int Cwan,Nog,Nh,MN,spin;
+  double dx,dy,dz,fw;
+  double FuzzyW,sum0,sum1,*FW;
   double magx,magy,magz;
   double tmagx,tmagy,tmagz;
   double tden,tmag,theta,phi,rho,mag;
@@ -34,7 +35,7 @@ void Voronoi_Charge()
   double **VC,*Voronoi_Vol;
   double TStime,TEtime;
   double S_coordinate[3];
-  int numprocs,myid,tag=999,ID;
+  int numprocs,myid,tag=999;
   FILE *fp_VC;
   char file_VC[YOUSO10];
   char buf[fp_bsize];          /* setvbuf */
@@ -66,7 +67,7 @@ void Voronoi_Charge()
             calculation of Voronoi charge
   *****************************************************/
 
-#pragma omp parallel shared(S_coordinate,GridVol,VC,Voronoi_Vol,Density_Grid,SpinP_switch,MGridListAtom,atv,CellListAtom,GridListAtom,NumOLG,WhatSpecies,M2G,Matomnum) private(OMPID,Nthrds,Nprocs,Mc_AN,Gc_AN,Cwan,sum0,sum1,vol,tden,tmagx,tmagy,tmagz,Nog,GNc,GRc,Cxyz,x,y,z,FuzzyW,MN,den0,den1,theta,phi,rho,mag,magx,magy,magz,tmag)
+#pragma omp parallel shared(S_coordinate,GridVol,VC,Voronoi_Vol,Density_Grid,SpinP_switch,MGridListAtom,atv,CellListAtom,GridListAtom,NumOLG,WhatSpecies,M2G,Matomnum) private(OMPID,Nthrds,Nprocs,Mc_AN,Gc_AN,Cwan,sum0,sum1,vol,tden,tmagx,tmagy,tmagz,Nog,FW,FuzzyW,MN,den0,den1,theta,phi,rho,mag,magx,magy,magz,tmag)
   {
 
     /* get info. on OpenMP */ 
@@ -89,18 +90,14 @@ void Voronoi_Charge()
       tmagy = 0.0;
       tmagz = 0.0;
 
-      for (Nog=0; Nog<NumOLG[Mc_AN][0]; Nog++){
+      /* calculate fuzzy weights */
 
-	/* calculate fuzzy weight */
+      FW = (double*)malloc(sizeof(double)*(GridN_Atom[Gc_AN]+1));
+      Fuzzy_Weight_Grid(Mc_AN,FW);
 
-	GNc = GridListAtom[Mc_AN][Nog];
-	GRc = CellListAtom[Mc_AN][Nog];
+      for (Nog=0; Nog<NumOLG[Mc_AN][0]; Nog++){
 
-	Get_Grid_XYZ(GNc,Cxyz);
-	x = Cxyz[1] + atv[GRc][1];
-	y = Cxyz[2] + atv[GRc][2]; 
-	z = Cxyz[3] + atv[GRc][3];
-	FuzzyW = Fuzzy_Weight(Gc_AN,Mc_AN,0,x,y,z);
+	FuzzyW = FW[Nog];
 
 	/* find charge */
 
@@ -167,6 +164,8 @@ void Voronoi_Charge()
 
       Voronoi_Vol[Gc_AN] = vol*GridVol*BohrR*BohrR*BohrR;
 
+      free(FW);
+
     } /* Mc_AN */
 
   } /* #pragma omp parallel */
@@ -175,33 +174,15 @@ void Voronoi_Charge()
     MPI VC
   *****************************************************/
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&VC[0][Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
-
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&VC[1][Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Vector(&VC[0][1], 1);
+  Atom_Allgather_Vector(&VC[1][1], 1);
 
   if (SpinP_switch==3){
-
-    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-      ID = G2ID[Gc_AN];
-      MPI_Bcast(&VC[2][Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-    }
-
-    for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-      ID = G2ID[Gc_AN];
-      MPI_Bcast(&VC[3][Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-    }
+    Atom_Allgather_Vector(&VC[2][1], 1);
+    Atom_Allgather_Vector(&VC[3][1], 1);
   }
 
-  for (Gc_AN=1; Gc_AN<=atomnum; Gc_AN++){
-    ID = G2ID[Gc_AN];
-    MPI_Bcast(&Voronoi_Vol[Gc_AN], 1, MPI_DOUBLE, ID, mpi_comm_level1);
-  }
+  Atom_Allgather_Vector(&Voronoi_Vol[1], 1);
 
   VC_S = 0.0;
   T_VC0 = 0.0;
@@ -8,6 +8,7 @@
   Log of Voronoi_Orbital_Moment.c:
 
     23/Nov./2006  Released by T.Ozaki
+    18/Oct/2026   fuzzy weights by Fuzzy_Weight_Grid
 
 ***********************************************************************/
 
@@ -36,7 +37,7 @@ void Voronoi_Orbital_Moment()
   FILE *fp_VOM;
   char file_VOM[YOUSO10];
   char buf[fp_bsize];          /* setvbuf */
-  double sum,FuzzyW,dx,dy,dz,x,y,z;
+  double sum,FuzzyW,dx,dy,dz,x,y,z,*FW;
   double idm0,idm1,MagL,tmp;
   double sumx,sumy,sumz,lx,ly,lz;
   double Cxyz[4];
@@ -401,6 +402,9 @@ void Voronoi_Orbital_Moment()
      store them into Tmp_Orb 
     ****************************************/
 
+    FW = (double*)malloc(sizeof(double)*(GridN_Atom[Gc_AN]+1));
+    Fuzzy_Weight_Grid(Mc_AN,FW);
+
     for (Nc=0; Nc<GridN_Atom[Gc_AN]; Nc++){
 
       GNc = GridListAtom[Mc_AN][Nc]; 
@@ -415,7 +419,7 @@ void Voronoi_Orbital_Moment()
       dy = y - Gxyz[Gc_AN][2];
       dz = z - Gxyz[Gc_AN][3];
 
-      FuzzyW = Fuzzy_Weight(Gc_AN,Mc_AN,0,x,y,z);
+      FuzzyW = FW[Nc];
       Orbitals_on_Grid(Cwan,Lmax,Nmul,dx,dy,dz,Chi0,RF,AF);
 
       for (L=0; L<=Lmax; L++){
@@ -427,6 +431,8 @@ void Voronoi_Orbital_Moment()
       }
     }
 
+    free(FW);
+
     /****************************************
      calculate the weighted overlap matrix
     ****************************************/
@@ -0,0 +1,294 @@
+/**********************************************************************
+  XC_Batch.c:
+
+     XC_Batch.c is a set of subroutines to evaluate the LSDA-PW92 and
+     GGA-PBE exchange-correlation functionals for a batch of grid
+     points at once. The formulae are identical to those in XC_PW92C.c,
+     XC_EX.c, and XC_PBE.c, but the densities and their gradients are
+     passed as contiguous arrays, and the loop over points carries no
+     function call nor branch other than selects, so that it can be
+     vectorized by the compiler with SIMD versions of pow, log, and exp.
+
+     XC_PW92_Batch:  LSDA-PW92, called from Set_XC_Grid
+     XC_PBE_Batch:   GGA-PBE,   called from Set_XC_Grid
+
+  Log of XC_Batch.c:
+
+     18/Oct/2026  Released
+
+***********************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include "openmx_common.h"
+
+#define den_min       1.0e-14
+#define den_min_half  0.5e-14
+#define gd_min        1.0e-14
+#define beta          0.06672455060314922
+#define kappa         0.8040
+#define THD           (1.0/3.0)
+#define TWOTHD        (2.0/3.0)
+
+
+
+/* XC_PW92C for given up and down densities */
+
+static inline void PW92C_Point(double d0, double d1,
+                               double *Ec, double *Vc0, double *Vc1)
+{
+  int i;
+  double dtot,rs,srs,zeta,tmp0,drsdd,dzdd0,dzdd1;
+  double b,c,dbdrs,dcdrs,dum,dum1,dum2,tmp1,tmp2,tmp12,tmp22,f,dfdz;
+  double G[3],dGdrs[3],dEcdrs,dEcdz;
+
+  const double A[3]      = {0.0310910,  0.0155450,  0.0168870};
+  const double alpha1[3] = {0.2137000,  0.2054800,  0.1112500};
+  const double beta1[3]  = {7.5957000, 14.1189000, 10.3570000};
+  const double beta2[3]  = {3.5876000,  6.1977000,  3.6231000};
+  const double beta3[3]  = {1.6382000,  3.3662000,  0.8802600};
+  const double beta4[3]  = {0.4929400,  0.6251700,  0.4967100};
+
+  dtot = d0 + d1;
+
+  rs   = (dtot<=den_min) ? 6203.504908994 : 0.6203504908994*pow(dtot,-0.33333333333333333333333);
+  d0   = (dtot<=den_min) ? den_min_half : d0;
+  d1   = (dtot<=den_min) ? den_min_half : d1;
+  dtot = (dtot<=den_min) ? den_min : dtot;
+
+  tmp0 = 1.0/dtot;
+  zeta = tmp0*(d0 - d1);
+  zeta = (0.99<zeta) ?  0.99 : zeta;
+  zeta = (zeta<-1.0) ? -0.99 : zeta;
+
+  drsdd = -0.3333333333333333333333*rs*tmp0;
+  dzdd0 = tmp0*( 1.0 - zeta);
+  dzdd1 = tmp0*(-1.0 - zeta);
+
+  srs = sqrt(rs);
+
+  for (i=0; i<=2; i++){
+    b = beta1[i]*srs + rs*(beta2[i] + beta3[i]*srs + beta4[i]*rs);
+    dbdrs = beta1[i]*0.50/srs + beta2[i] + beta3[i]*1.50*srs + beta4[i]*2.0*rs;
+    c = 1.0 + 1.0/(2.0*A[i]*b);
+    dcdrs = -(c - 1.0)*dbdrs/b;
+    dum = log(c);
+    dum1 = 1.0 + alpha1[i]*rs;
+    G[i] = -2.0*A[i]*dum1*dum;
+    dGdrs[i] = -2.0*A[i]*(alpha1[i]*dum + dum1*dcdrs/c);
+  }
+
+  c = 1.92366105093154;
+  dum1 = 1.0 + zeta;
+  dum2 = 1.0 - zeta;
+  tmp1  = pow(dum1,0.333333333333333333);
+  tmp2  = pow(dum2,0.333333333333333333);
+  tmp12 = tmp1*tmp1;
+  tmp22 = tmp2*tmp2;
+  f = (tmp12*tmp12 + tmp22*tmp22 - 2.0)*c;
+  dfdz = 1.333333333333333333*(tmp1 - tmp2)*c;
+
+  dum1 = zeta*zeta*zeta;
+  dum  = dum1*zeta;
+
+  *Ec = G[0] - G[2]*f/1.70992093416137*(1.0 - dum) + (G[1] - G[0])*f*dum;
+
+  dEcdrs =   dGdrs[0] - dGdrs[2]*f/1.70992093416137*(1.0 - dum)
+          + (dGdrs[1] - dGdrs[0])*f*dum;
+
+  dEcdz = - G[2]/1.70992093416137*(dfdz*(1.0 - dum) - f*4.0*dum1)
+          + (G[1] - G[0])*(dfdz*dum + f*4.0*dum1);
+
+  dum = dEcdrs*drsdd;
+  *Vc0 = *Ec + dtot*(dum + dEcdz*dzdd0);
+  *Vc1 = *Ec + dtot*(dum + dEcdz*dzdd1);
+}
+
+
+
+/* XC_EX with NSP=1 */
+
+static inline void EX_Point(double DS0, double *EX, double *VX)
+{
+  double RS;
+
+  RS = (DS0<=den_min) ? 0.6203504908994*pow(den_min,-1.0/3.0)
+                      : 0.6203504908994*pow(DS0,-0.333333333333333);
+  *VX = -0.610887057710857/RS;
+  *EX = 0.750*(*VX);
+}
+
+
+
+/****************************************************
+  XC_PW92_Batch
+
+  input:  den0[n], den1[n]   up and down densities
+  output: exc[n]             XC energy density
+          vxc0[n], vxc1[n]   XC potentials of up and down spins
+****************************************************/
+
+void XC_PW92_Batch(int n, double *den0, double *den1,
+                   double *exc, double *vxc0, double *vxc1)
+{
+  int p;
+
+#pragma omp simd
+  for (p=0; p<n; p++){
+
+    double d0,d1,dtot,Ec,Vc0,Vc1,Ex0,Vx0,Ex1,Vx1;
+
+    d0 = den0[p];
+    d1 = den1[p];
+
+    PW92C_Point(d0, d1, &Ec, &Vc0, &Vc1);
+
+    /* XC_PW92C resets the densities in this case */
+
+    dtot = d0 + d1;
+    d0 = (dtot<=den_min) ? den_min_half : d0;
+    d1 = (dtot<=den_min) ? den_min_half : d1;
+
+    EX_Point(2.0*d0, &Ex0, &Vx0);
+    EX_Point(2.0*d1, &Ex1, &Vx1);
+
+    exc[p]  = Ec + 0.5*(2.0*d0*Ex0 + 2.0*d1*Ex1)/(d0 + d1);
+    vxc0[p] = Vc0 + Vx0;
+    vxc1[p] = Vc1 + Vx1;
+  }
+}
+
+
+
+/****************************************************
+  XC_PBE_Batch
+
+  input:  den0[n], den1[n]        up and down densities
+          gden[spin][xyz][n]      their gradients
+  output: exc[n]                  XC energy density
+          vxc0[n], vxc1[n]        d(fxc)/d(n_up), d(fxc)/d(n_down)
+          dgd[spin][xyz][n]       d(fxc)/d(nabla n)
+****************************************************/
+
+void XC_PBE_Batch(int n, double *den0, double *den1, double *gden[2][3],
+                  double *exc, double *vxc0, double *vxc1, double *dgd[2][3])
+{
+  int p;
+  double gamma,mu;
+
+  gamma = (1.0 - log(2.0))/(PI*PI);
+  mu = beta*PI*PI/3.0;
+
+#pragma omp simd
+  for (p=0; p<n; p++){
+
+    int IS;
+    double D[2],GD[3][2],GDM[2],GDT[3],GDMT,dt,kF,ks,zeta,phi,t;
+    double Ec_unif,Vc_unif[2],f1,f2,f3,f4,A,H,Fc,Fx;
+    double DKFDD,DKSDD,DZDD[2],DPDZ,DECUDD,DPDD,DTDD;
+    double DF1DD,DF2DD,DADD,DF3DD,DF4DD,DHDD,DFCDD[2],DFCDGD,c3;
+    double DS,GDMS,KFS,s,f,DSDD,DFDD,DFXDD[2],Ex_unif,Vx_unif,DFDGD;
+
+    D[0] = (den0[p]<0.5*den_min) ? 0.5*den_min : den0[p];
+    D[1] = (den1[p]<0.5*den_min) ? 0.5*den_min : den1[p];
+    dt = D[0] + D[1];
+
+    GD[0][0] = gden[0][0][p];  GD[0][1] = gden[1][0][p];
+    GD[1][0] = gden[0][1][p];  GD[1][1] = gden[1][1][p];
+    GD[2][0] = gden[0][2][p];  GD[2][1] = gden[1][2][p];
+
+    GDT[0] = GD[0][0] + GD[0][1];
+    GDT[1] = GD[1][0] + GD[1][1];
+    GDT[2] = GD[2][0] + GD[2][1];
+
+    GDM[0] = sqrt(GD[0][0]*GD[0][0] + GD[1][0]*GD[1][0] + GD[2][0]*GD[2][0]);
+    GDM[1] = sqrt(GD[0][1]*GD[0][1] + GD[1][1]*GD[1][1] + GD[2][1]*GD[2][1]);
+    GDMT   = sqrt(GDT[0]*GDT[0] + GDT[1]*GDT[1] + GDT[2]*GDT[2]);
+    GDMT   = (GDMT<gd_min) ? gd_min : GDMT;
+
+    /* local correlation */
+
+    PW92C_Point(D[0], D[1], &Ec_unif, &Vc_unif[0], &Vc_unif[1]);
+
+    /* total correlation */
+
+    kF = pow(3.0*PI*PI*dt,THD);
+    ks = sqrt(4.0*kF/PI);
+    zeta = (D[0] - D[1])/dt;
+    zeta = (0.99<zeta) ?  0.99 : zeta;
+    zeta = (zeta<-1.0) ? -0.99 : zeta;
+
+    phi = 0.50*(pow(1.0 + zeta,TWOTHD) + pow(1.0 - zeta,TWOTHD));
+    c3 = phi*phi*phi;
+    t = GDMT/(2.0*phi*ks*dt);
+    f1 = Ec_unif/(gamma*c3);
+    f2 = exp(-f1);
+    A = beta/gamma/(f2 - 1.0);
+    f3 = t*t + A*t*t*t*t;
+    f4 = beta/gamma * f3/(1.0 + A*f3);
+    H = gamma*c3*log(1.0 + f4);
+    Fc = Ec_unif + H;
+
+    /* correlation derivatives */
+
+    DKFDD =   THD*kF/dt;
+    DKSDD = 0.5*ks*DKFDD/kF;
+    DZDD[0] = 1.0/dt - zeta/dt;
+    DZDD[1] = -(1.0/dt) - zeta/dt;
+    DPDZ = 0.5*TWOTHD*(1.0/pow(1.0+zeta,THD) - 1.0/pow(1.0-zeta,THD));
+
+    for (IS=0; IS<=1; IS++){
+      DECUDD = (Vc_unif[IS] - Ec_unif)/dt;
+      DPDD = DPDZ*DZDD[IS];
+      DTDD = (-t)*(DPDD/phi + DKSDD/ks + 1.0/dt);
+      DF1DD = f1*(DECUDD/Ec_unif - 3.0*DPDD/phi);
+      DF2DD = (-f2)*DF1DD;
+      DADD = (-A)*DF2DD/(f2 - 1.0);
+      DF3DD = (2.0*t + 4.0*A*t*t*t) * DTDD + DADD*t*t*t*t;
+      DF4DD = f4*(DF3DD/f3 - (DADD*f3+A*DF3DD)/(1.0 + A*f3));
+      DHDD = 3.0*H*DPDD/phi + gamma*c3*DF4DD/(1.0 + f4);
+      DFCDD[IS] = Vc_unif[IS] + H + dt*DHDD;
+    }
+
+    /* d(fc)/d(nabla n) is common to both spins */
+
+    DFCDGD = dt*gamma*c3*f4*(2.0*t + 4.0*A*t*t*t)*(1.0/f3 - A/(1.0 + A*f3))
+             /(1.0 + f4)*(t/GDMT)/GDMT;
+
+    /* exchange */
+
+    Fx = 0.0;
+    for (IS=0; IS<=1; IS++){
+
+      DS = (2.0*D[IS]<den_min) ? den_min : 2.0*D[IS];
+      GDMS = (2.0*GDM[IS]<gd_min) ? gd_min : 2.0*GDM[IS];
+      KFS = pow(3.0*PI*PI*DS,THD);
+      s = GDMS/(2.0*KFS*DS);
+      f1 = 1.0 + mu*s*s/kappa;
+      f = 1.0 + kappa - kappa/f1;
+
+      EX_Point(DS, &Ex_unif, &Vx_unif);
+
+      Fx = Fx + DS*Ex_unif*f;
+      DKFDD = THD*KFS/DS;
+      DSDD = s*(-(DKFDD/KFS) - 1.0/DS);
+      DF1DD = 2.0*(f1 - 1.0)*DSDD/s;
+      DFDD = kappa*DF1DD/(f1*f1);
+      DFXDD[IS] = Vx_unif*f + DS*Ex_unif*DFDD;
+
+      /* d(fx)/d(nabla n) = DS*Ex*DFDGD*(2 GD) */
+
+      DFDGD = DS*Ex_unif*kappa*2.0*mu*s*(s/GDMS)/GDMS/kappa/(f1*f1)*2.0;
+
+      dgd[IS][0][p] = DFDGD*GD[0][IS] + DFCDGD*GDT[0];
+      dgd[IS][1][p] = DFDGD*GD[1][IS] + DFCDGD*GDT[1];
+      dgd[IS][2][p] = DFDGD*GD[2][IS] + DFCDGD*GDT[2];
+    }
+    Fx = 0.5*Fx/dt;
+
+    exc[p]  = Fx + Fc;
+    vxc0[p] = DFXDD[0] + DFCDD[0];
+    vxc1[p] = DFXDD[1] + DFCDD[1];
+  }
+}
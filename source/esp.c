@@ -7,6 +7,8 @@
      usage:  ./esp name -c 0 -s 1.4 2.0   
 
        Note: name.out and name.vhart.cube must be in the same directory.
+             name.vhart.cube.bin is used instead of name.vhart.cube
+             if it exists.
 
        -c      constraint parameter 
                '-c 0' means charge conservation 
@@ -26,12 +28,18 @@
 
      4/Feb/2004  Released by T.Ozaki 
     25/Sep/2004  local ESP scheme added by T.Ozaki
+    18/Oct/2026  binary cube file, cell lists for the shell, and
+                 the normal equation by DGEMM with OpenMP
 ***********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "Inputtools.h"
 #include "lapack_prototypes.h"
 #include "f77func.h"
@@ -45,11 +53,16 @@
 #define YOUSO10       100
 #define MAXBUF        1024
 #define fp_bsize      1048576     /* buffer size for setvbuf */
+#define ESP_Block     1024        /* the number of points in a block of the design matrix */
+#define Cube_Bin_Head 512         /* bytes of the header of .cube.bin before the atoms */
 
 #include "mpi.h"
 
 void read_input(char *file);
+void open_vhart(char *name);
 void read_vhart(char *file);
+void read_vhart_bin(char *file);
+void set_tv();
 void read_vna(char *file);
 void set_vdw();
 void find_grids();
@@ -78,10 +91,9 @@ char **SpeBasis;
 char **SpeVPS;
 double ***VHart;
 double ***VNA;
-double ***X_grid;
-double ***Y_grid;
-double ***Z_grid;
-int ***grid_flag;
+int num_grid;
+double *Grid_xyz;
+double *Grid_V;
 
 int main(int argc, char *argv[]) 
 {
@@ -185,9 +197,8 @@ int main(int argc, char *argv[])
 
   /* -l */
   if (po_l==1){
-    sprintf(file[1],"%s.vhart.cube",argv[1]);  
     sprintf(file[2],"%s.LESP",argv[1]);
-    read_vhart(file[1]);
+    open_vhart(argv[1]);
     LESP(file[2]);   
     exit(0);
   }
@@ -204,7 +215,6 @@ int main(int argc, char *argv[])
   }
   
   sprintf(file[0],"%s.out",argv[1]);  
-  sprintf(file[1],"%s.vhart.cube",argv[1]);  
 
   s_vec[0]="Constraint: charge "; s_vec[1]="Constraint: charge + dipole moment";
   printf("%s\n",s_vec[Modified_MK]);
@@ -220,7 +230,7 @@ int main(int argc, char *argv[])
            Read a vhart file
   ****************************************************/
 
-  read_vhart(file[1]);
+  open_vhart(argv[1]);
 
   /****************************************************
            Read a vna file
@@ -381,32 +391,20 @@ void LESP(char *file)
 
 void calc_esp()
 {
-  static int ct_AN,n1,n2,n3,po,spe;
-  static int i,j,k;
-  static int Rn1,Rn2,Rn3;
-  static int num_grid;
-  static double sum0,sum1,rij,rik;
-  static double cx,cy,cz;
-  static double bik,bij;
-  static double x,y,z;
-  static double dif,total_diff;
-  static double GridVol;
-  static double dx,dy,dz;
-  static double dpx,dpy,dpz,tdp;
-  static double tmp[4];
-  static double **A,*B;
-  static double *A2;
-  static INTEGER N, NRHS, LDA, *IPIV, LDB, INFO;
-
-  /* find the number of grids in the shell */
-  num_grid = 0;
-  for (n1=0; n1<Ngrid1; n1++){
-    for (n2=0; n2<Ngrid2; n2++){
-      for (n3=0; n3<Ngrid3; n3++){
-        if (grid_flag[n1][n2][n3]==1) num_grid++;
-      }
-    }
-  }
+  int ct_AN,p,p0,np;
+  int i,j,k,N,NB;
+  int Rn1,Rn2,Rn3,Rn,NRn;
+  double rij;
+  double x,y,z;
+  double dif,total_diff;
+  double GridVol;
+  double dx,dy,dz;
+  double dpx,dpy,dpz,tdp;
+  double alpha,beta;
+  double tmp[4];
+  double cR[(2*MaxRn1+1)*(2*MaxRn2+1)*(2*MaxRn3+1)][4];
+  double *A2,*B,*D;
+  INTEGER NRHS, LDA, *IPIV, LDB, INFO, NN;
 
   printf("Number of grids in a van der Waals shell = %2d\n",num_grid);
 
@@ -414,124 +412,92 @@ void calc_esp()
   GridVol = fabs( Dot_Product(gtv[1],tmp) );
   printf("Volume per grid = %15.10f (Bohr^3)\n",GridVol);
 
-  /* make a matrix A and a vector B */
-  A = (double**)malloc(sizeof(double*)*(atomnum+10));
-  for (i=0; i<(atomnum+10); i++){
-    A[i] = (double*)malloc(sizeof(double)*(atomnum+10));
-    for (j=0; j<(atomnum+10); j++) A[i][j] = 0.0;
-  }    
-
-  A2 = (double*)malloc(sizeof(double)*(atomnum+10)*(atomnum+10));
-  B = (double*)malloc(sizeof(double)*(atomnum+10));
+  /* translation vectors of the periodic images */
 
-  for (j=1; j<=atomnum; j++){
-    for (k=1; k<=atomnum; k++){
+  Rn = 0;
+  for (Rn1=-MaxRn1; Rn1<=MaxRn1; Rn1++){
+    for (Rn2=-MaxRn2; Rn2<=MaxRn2; Rn2++){
+      for (Rn3=-MaxRn3; Rn3<=MaxRn3; Rn3++){
+        cR[Rn][1] = (double)Rn1*tv[1][1] + (double)Rn2*tv[2][1] + (double)Rn3*tv[3][1]; 
+        cR[Rn][2] = (double)Rn1*tv[1][2] + (double)Rn2*tv[2][2] + (double)Rn3*tv[3][2]; 
+        cR[Rn][3] = (double)Rn1*tv[1][3] + (double)Rn2*tv[2][3] + (double)Rn3*tv[3][3]; 
+        Rn++;
+      }
+    }
+  }
+  NRn = Rn;
 
-      sum0 = 0.0;
-      sum1 = 0.0;
+  /* A2 is stored in column major order with the rows and columns
+     for the constraints */
 
-      for (n1=0; n1<Ngrid1; n1++){
-	for (n2=0; n2<Ngrid2; n2++){
-	  for (n3=0; n3<Ngrid3; n3++){
-	    if (grid_flag[n1][n2][n3]==1){
+  if (Modified_MK==0) N = atomnum + 1;
+  else                N = atomnum + 4;
 
-	      x = X_grid[n1][n2][n3];
-	      y = Y_grid[n1][n2][n3];
-	      z = Z_grid[n1][n2][n3];
-     
-              bij = 0.0;
-              bik = 0.0;
-
-              for (Rn1=-MaxRn1; Rn1<=MaxRn1; Rn1++){
-                for (Rn2=-MaxRn2; Rn2<=MaxRn2; Rn2++){
-                  for (Rn3=-MaxRn3; Rn3<=MaxRn3; Rn3++){
-
-                    cx = (double)Rn1*tv[1][1] + (double)Rn2*tv[2][1] + (double)Rn3*tv[3][1]; 
-                    cy = (double)Rn1*tv[1][2] + (double)Rn2*tv[2][2] + (double)Rn3*tv[3][2]; 
-                    cz = (double)Rn1*tv[1][3] + (double)Rn2*tv[2][3] + (double)Rn3*tv[3][3]; 
-
-                    /* rij */
-                    dx = x - (Gxyz[j][1] + cx); 
-                    dy = y - (Gxyz[j][2] + cy); 
-                    dz = z - (Gxyz[j][3] + cz); 
-                    rij = sqrt(dx*dx + dy*dy + dz*dz); 
-                    bij += 1.0/rij;
- 
-		    /* rik */
-		    dx = x - (Gxyz[k][1] + cx); 
-		    dy = y - (Gxyz[k][2] + cy); 
-		    dz = z - (Gxyz[k][3] + cz); 
-		    rik = sqrt(dx*dx + dy*dy + dz*dz); 
-                    bik += 1.0/rik;
-                  }
-                }
-              }
+  A2 = (double*)malloc(sizeof(double)*N*N);
+  for (i=0; i<N*N; i++) A2[i] = 0.0;
+  B = (double*)malloc(sizeof(double)*(atomnum+10));
+  for (i=0; i<(atomnum+10); i++) B[i] = 0.0;
 
-              sum0 += bij*bik;
+  /****************************************************
+     D[j*NB+p] = sum_R 1/|r_p - (R_j + R)| for a block
+     of the points, and A2 += D^t*D and B -= D^t*V
+  ****************************************************/
 
-              if (j==1){
-		
-                /*
-                sum1 -= (VHart[n1][n2][n3] + VNA[n1][n2][n3])*bik;
-		*/
+  NB = ESP_Block;
+  D = (double*)malloc(sizeof(double)*NB*atomnum);
 
-		sum1 -= VHart[n1][n2][n3]*bik;
-              }
+  for (p0=0; p0<num_grid; p0+=NB){
 
-            }
-	  }
-	}
-      }
+    np = num_grid - p0;
+    if (NB<np) np = NB;
 
-      A[j][k] = sum0;
-      if (j==1) B[k-1] = sum1;
-    }
-  }
+#pragma omp parallel for private(p,j,Rn,x,y,z,dx,dy,dz,rij) shared(np,p0,NB,NRn,D,Grid_xyz,Gxyz,cR,atomnum) schedule(static)
 
+    for (p=0; p<np; p++){
 
-  /* MK */
-  if (Modified_MK==0){
+      x = Grid_xyz[3*(p0+p)  ];
+      y = Grid_xyz[3*(p0+p)+1];
+      z = Grid_xyz[3*(p0+p)+2];
 
-    for (k=1; k<=atomnum; k++){
-      A[atomnum+1][k] = 1.0;
-      A[k][atomnum+1] = 1.0;
-    }
-    A[atomnum+1][atomnum+1] = 0.0;
-    B[atomnum] = 0.0;
+      for (j=1; j<=atomnum; j++){
 
-    /* A to A2 */
+        D[(j-1)*NB+p] = 0.0;
 
-    i = 0;
-    for (k=1; k<=(atomnum+1); k++){
-      for (j=1; j<=(atomnum+1); j++){
-	A2[i] = A[j][k];         
-	i++;
+        for (Rn=0; Rn<NRn; Rn++){
+          dx = x - (Gxyz[j][1] + cR[Rn][1]); 
+          dy = y - (Gxyz[j][2] + cR[Rn][2]); 
+          dz = z - (Gxyz[j][3] + cR[Rn][3]); 
+          rij = sqrt(dx*dx + dy*dy + dz*dz); 
+          D[(j-1)*NB+p] += 1.0/rij;
+        }
       }
     }
 
-    /* solve Aq = B */
+    alpha = 1.0;
+    beta = 1.0;
 
-    N = atomnum + 1;
-    NRHS = 1;
-    LDA = N;
-    LDB = N;
-    IPIV = (INTEGER*)malloc(sizeof(INTEGER)*N);
+    F77_NAME(dgemm,DGEMM)("T","N", &atomnum, &atomnum, &np, &alpha, D, &NB, D, &NB, &beta, A2, &N);
 
-    F77_NAME(dgesv,DGESV)(&N, &NRHS, A2, &LDA, IPIV, B, &LDB, &INFO);
+#pragma omp parallel for private(k,p) shared(np,p0,NB,D,B,Grid_V,atomnum) schedule(static)
 
-    if( INFO==0 ){
-      printf("Success\n" ); 
-    }
-    else{
-      printf("Failure: linear dependent\n" ); 
-      exit(0); 
+    for (k=0; k<atomnum; k++){
+      for (p=0; p<np; p++){
+        B[k] -= Grid_V[p0+p]*D[k*NB+p];
+      }
     }
+  }
 
-    printf("\n");    
-    for(i=0; i<atomnum; i++){
-      printf("  Atom=%4d  Fitting Effective Charge=%15.11f\n",i+1,B[i]);
-    }
+  free(D);
+
+  /* MK */
+  if (Modified_MK==0){
 
+    for (k=1; k<=atomnum; k++){
+      A2[(k-1)*N+atomnum] = 1.0;
+      A2[atomnum*N+(k-1)] = 1.0;
+    }
+    A2[atomnum*N+atomnum] = 0.0;
+    B[atomnum] = 0.0;
   }
 
   /* Modified MK */
@@ -539,56 +505,44 @@ void calc_esp()
 
     for (k=1; k<=atomnum; k++){
 
-      A[atomnum+1][k] = 1.0;
-      A[k][atomnum+1] = 1.0;
-
-      A[atomnum+2][k] = Gxyz[k][1];
-      A[atomnum+3][k] = Gxyz[k][2];
-      A[atomnum+4][k] = Gxyz[k][3];
+      A2[(k-1)*N+atomnum  ] = 1.0;
+      A2[(k-1)*N+atomnum+1] = Gxyz[k][1];
+      A2[(k-1)*N+atomnum+2] = Gxyz[k][2];
+      A2[(k-1)*N+atomnum+3] = Gxyz[k][3];
 
-      A[k][atomnum+2] = Gxyz[k][1];
-      A[k][atomnum+3] = Gxyz[k][2];
-      A[k][atomnum+4] = Gxyz[k][3];
+      A2[(atomnum  )*N+(k-1)] = 1.0;
+      A2[(atomnum+1)*N+(k-1)] = Gxyz[k][1];
+      A2[(atomnum+2)*N+(k-1)] = Gxyz[k][2];
+      A2[(atomnum+3)*N+(k-1)] = Gxyz[k][3];
     }
 
     B[atomnum  ] = 0.0;
     B[atomnum+1] = Ref_DipMx/AU2Debye;
     B[atomnum+2] = Ref_DipMy/AU2Debye;
     B[atomnum+3] = Ref_DipMz/AU2Debye;
+  }
 
-    /* A to A2 */
-
-    i = 0;
-    for (k=1; k<=(atomnum+4); k++){
-      for (j=1; j<=(atomnum+4); j++){
-	A2[i] = A[j][k];         
-	i++;
-      }
-    }
-
-    /* solve Aq = B */
-
-    N = atomnum + 4;
-    NRHS = 1;
-    LDA = N;
-    LDB = N;
-    IPIV = (INTEGER*)malloc(sizeof(INTEGER)*N);
+  /* solve Aq = B */
 
-    F77_NAME(dgesv,DGESV)(&N, &NRHS, A2, &LDA, IPIV, B, &LDB, &INFO); 
+  NN = N;
+  NRHS = 1;
+  LDA = N;
+  LDB = N;
+  IPIV = (INTEGER*)malloc(sizeof(INTEGER)*N);
 
-    if( INFO==0 ){
-      printf("Success\n" ); 
-    }
-    else{
-      printf("Failure: linear dependent\n" ); 
-      exit(0); 
-    }
+  F77_NAME(dgesv,DGESV)(&NN, &NRHS, A2, &LDA, IPIV, B, &LDB, &INFO);
 
-    printf("\n");    
-    for(i=0; i<atomnum; i++){
-      printf("  Atom=%4d  Fitting Effective Charge=%15.11f\n",i+1,B[i]);
-    }
+  if( INFO==0 ){
+    printf("Success\n" ); 
+  }
+  else{
+    printf("Failure: linear dependent\n" ); 
+    exit(0); 
+  }
 
+  printf("\n");    
+  for(i=0; i<atomnum; i++){
+    printf("  Atom=%4d  Fitting Effective Charge=%15.11f\n",i+1,B[i]);
   }
 
   dpx = 0.0;
@@ -613,38 +567,24 @@ void calc_esp()
 
   total_diff = 0.0; 
 
-  for (n1=0; n1<Ngrid1; n1++){
-    for (n2=0; n2<Ngrid2; n2++){
-      for (n3=0; n3<Ngrid3; n3++){
-	if (grid_flag[n1][n2][n3]==1){
-
-          x = X_grid[n1][n2][n3];
-	  y = Y_grid[n1][n2][n3];
-	  z = Z_grid[n1][n2][n3];
+#pragma omp parallel for private(p,j,Rn,x,y,z,dx,dy,dz,rij,dif) shared(NRn,Grid_xyz,Grid_V,Gxyz,cR,B,atomnum,num_grid) reduction(+:total_diff) schedule(static)
 
-          for (Rn1=-MaxRn1; Rn1<=MaxRn1; Rn1++){
-            for (Rn2=-MaxRn2; Rn2<=MaxRn2; Rn2++){
-              for (Rn3=-MaxRn3; Rn3<=MaxRn3; Rn3++){
+  for (p=0; p<num_grid; p++){
 
-                cx = (double)Rn1*tv[1][1] + (double)Rn2*tv[2][1] + (double)Rn3*tv[3][1]; 
-                cy = (double)Rn1*tv[1][2] + (double)Rn2*tv[2][2] + (double)Rn3*tv[3][2]; 
-                cz = (double)Rn1*tv[1][3] + (double)Rn2*tv[2][3] + (double)Rn3*tv[3][3]; 
+    x = Grid_xyz[3*p  ];
+    y = Grid_xyz[3*p+1];
+    z = Grid_xyz[3*p+2];
 
-                for (j=1; j<=atomnum; j++){
+    for (Rn=0; Rn<NRn; Rn++){
+      for (j=1; j<=atomnum; j++){
 
-                  dx = x - (Gxyz[j][1] + cx); 
-                  dy = y - (Gxyz[j][2] + cy); 
-                  dz = z - (Gxyz[j][3] + cz); 
-                  rij = sqrt(dx*dx + dy*dy + dz*dz); 
+        dx = x - (Gxyz[j][1] + cR[Rn][1]); 
+        dy = y - (Gxyz[j][2] + cR[Rn][2]); 
+        dz = z - (Gxyz[j][3] + cR[Rn][3]); 
+        rij = sqrt(dx*dx + dy*dy + dz*dz); 
 
-                  dif = -VHart[n1][n2][n3] + B[j-1]/rij;
-                  total_diff += dif*dif;
- 	        }
-	      }
-	    }
-	  }
-
-	}
+        dif = -Grid_V[p] + B[j-1]/rij;
+        total_diff += dif*dif;
       }
     }
   }
@@ -654,110 +594,177 @@ void calc_esp()
          total_diff);
 
   /* freeing of arrays */
-  for (i=0; i<(atomnum+10); i++){
-    free(A[i]);
-  }    
-  free(A);
 
   free(B);
   free(A2);
   free(IPIV);
-
 }
 
 
 void find_grids()
 {
+  int ct_AN,wan,n1,n2,n3,i;
+  long int p;
+  int nc[4],Nc;
+  int *head,*next;
+  unsigned char *flag;
+  double rcut,rmin[4],rmax[4];
 
-  static int ct_AN,n1,n2,n3,po,wsp,wan;
-  static double x,y,z,dx,dy,dz,r;
-  
-  static int nn1;
+  /****************************************************
+     the atoms are sorted into cubic cells whose size
+     is the largest outer radius, so that a grid point
+     is checked only with the atoms in 27 cells
+  ****************************************************/
 
-  for (n1=0; n1<Ngrid1; n1++){
-    for (n2=0; n2<Ngrid2; n2++){
-      for (n3=0; n3<Ngrid3; n3++){
-        grid_flag[n1][n2][n3] = 0;
-      }
+  rcut = 0.0;
+  for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
+
+    wan = WhatSpecies[ct_AN];
+
+    if (wan<0 || 104<wan || Atom_vdw[wan]==0.0){
+      printf("unknown van der Waal radius of atom %d\n",wan);          
+      printf("Please set your value for van der Waal radius of atom %d\n",wan);          
+      exit(1);
+    } 
+
+    if (rcut<scale2*Atom_vdw[wan]) rcut = scale2*Atom_vdw[wan];
+  }
+
+  for (i=1; i<=3; i++){
+    rmin[i] = Gxyz[1][i];
+    rmax[i] = Gxyz[1][i];
+    for (ct_AN=2; ct_AN<=atomnum; ct_AN++){
+      if (Gxyz[ct_AN][i]<rmin[i]) rmin[i] = Gxyz[ct_AN][i];
+      if (rmax[i]<Gxyz[ct_AN][i]) rmax[i] = Gxyz[ct_AN][i];
     }
+    nc[i] = (int)((rmax[i]-rmin[i])/rcut) + 1;
   }
-  
-  /* find outer grids for the fisrt vdw surface */
+
+  Nc = nc[1]*nc[2]*nc[3];
+  head = (int*)malloc(sizeof(int)*Nc);
+  next = (int*)malloc(sizeof(int)*(atomnum+1));
+  for (i=0; i<Nc; i++) head[i] = 0;
+
+  for (ct_AN=atomnum; 1<=ct_AN; ct_AN--){
+    i = ((int)((Gxyz[ct_AN][1]-rmin[1])/rcut)*nc[2]
+       + (int)((Gxyz[ct_AN][2]-rmin[2])/rcut))*nc[3]
+       + (int)((Gxyz[ct_AN][3]-rmin[3])/rcut);
+    next[ct_AN] = head[i];
+    head[i] = ct_AN;
+  }
+
+  /****************************************************
+     a grid point is in the shell if it is inside the
+     second vdw surface and outside the first one
+  ****************************************************/
+
+  flag = (unsigned char*)malloc(sizeof(unsigned char)*(long int)Ngrid1*Ngrid2*Ngrid3);
+
+#pragma omp parallel for private(n1,n2,n3) shared(flag,head,next,nc,rmin,rcut,Gxyz,WhatSpecies,Atom_vdw,scale1,scale2,gtv,Grid_Origin,Ngrid1,Ngrid2,Ngrid3) schedule(dynamic)
 
   for (n1=0; n1<Ngrid1; n1++){
     for (n2=0; n2<Ngrid2; n2++){
       for (n3=0; n3<Ngrid3; n3++){
-        x = X_grid[n1][n2][n3];
-        y = Y_grid[n1][n2][n3];
-        z = Z_grid[n1][n2][n3];
 
-        po = 0;
-        ct_AN = 1;
-        do{
+        int c1,c2,c3,i1,i2,i3,ct_AN,wan,po_out,po_in;
+        double x,y,z,dx,dy,dz,r;
+
+        flag[((long int)n1*Ngrid2+n2)*Ngrid3+n3] = 0;
+
+	x = (double)n1*gtv[1][1] + (double)n2*gtv[2][1] + (double)n3*gtv[3][1] + Grid_Origin[1];
+	y = (double)n1*gtv[1][2] + (double)n2*gtv[2][2] + (double)n3*gtv[3][2] + Grid_Origin[2];
+	z = (double)n1*gtv[1][3] + (double)n2*gtv[2][3] + (double)n3*gtv[3][3] + Grid_Origin[3];
+
+        c1 = (int)floor((x-rmin[1])/rcut);
+        c2 = (int)floor((y-rmin[2])/rcut);
+        c3 = (int)floor((z-rmin[3])/rcut);
 
-          wan = WhatSpecies[ct_AN];
+        if (c1<-1 || nc[1]<c1 || c2<-1 || nc[2]<c2 || c3<-1 || nc[3]<c3) continue;
 
-          dx = x - Gxyz[ct_AN][1]; 
-          dy = y - Gxyz[ct_AN][2]; 
-          dz = z - Gxyz[ct_AN][3]; 
+        po_out = 0;
+        po_in = 0;
 
-          r = sqrt(dx*dx + dy*dy + dz*dz);  
+        for (i1=c1-1; i1<=c1+1 && po_in==0; i1++){
+          if (i1<0 || nc[1]<=i1) continue;
+          for (i2=c2-1; i2<=c2+1 && po_in==0; i2++){
+            if (i2<0 || nc[2]<=i2) continue;
+            for (i3=c3-1; i3<=c3+1 && po_in==0; i3++){
+              if (i3<0 || nc[3]<=i3) continue;
 
-          if (Atom_vdw[wan]==0.0){
-            printf("unknown van der Waal radius of atom %d\n",wan);          
-            printf("Please set your value for van der Waal radius of atom %d\n",wan);          
-            exit(1);
-          } 
+              for (ct_AN=head[(i1*nc[2]+i2)*nc[3]+i3]; ct_AN!=0 && po_in==0; ct_AN=next[ct_AN]){
 
-          if ( r < (scale2*Atom_vdw[wan]) ) po = 1;
+                wan = WhatSpecies[ct_AN];
 
-          ct_AN++; 
-        } while (ct_AN<=atomnum && po==0);  
+                dx = x - Gxyz[ct_AN][1]; 
+                dy = y - Gxyz[ct_AN][2]; 
+                dz = z - Gxyz[ct_AN][3]; 
+                r = sqrt(dx*dx + dy*dy + dz*dz);  
+
+                if ( r < (scale2*Atom_vdw[wan]) ) po_out = 1;
+                if ( r < (scale1*Atom_vdw[wan]) ) po_in = 1;
+              }
+            }
+          }
+        }
 
-        if (po==1) grid_flag[n1][n2][n3] = 1; 
+        if (po_out==1 && po_in==0) flag[((long int)n1*Ngrid2+n2)*Ngrid3+n3] = 1;
       }
     }
   }
 
-  /* find inner grids for the second vdw surface among surviving grids */
+  /* the points in the shell and the potential on them */
 
+  num_grid = 0;
+  for (p=0; p<(long int)Ngrid1*Ngrid2*Ngrid3; p++) num_grid += flag[p];
+
+  Grid_xyz = (double*)malloc(sizeof(double)*3*(num_grid+1));
+  Grid_V = (double*)malloc(sizeof(double)*(num_grid+1));
+
+  p = 0;
   for (n1=0; n1<Ngrid1; n1++){
     for (n2=0; n2<Ngrid2; n2++){
       for (n3=0; n3<Ngrid3; n3++){
+        if (flag[((long int)n1*Ngrid2+n2)*Ngrid3+n3]==1){
 
-        if (grid_flag[n1][n2][n3]==1){
-
-	  x = X_grid[n1][n2][n3];
-	  y = Y_grid[n1][n2][n3];
-	  z = Z_grid[n1][n2][n3];
+	  Grid_xyz[3*p  ] = (double)n1*gtv[1][1] + (double)n2*gtv[2][1]
+	                  + (double)n3*gtv[3][1] + Grid_Origin[1];
+	  Grid_xyz[3*p+1] = (double)n1*gtv[1][2] + (double)n2*gtv[2][2]
+	                  + (double)n3*gtv[3][2] + Grid_Origin[2];
+	  Grid_xyz[3*p+2] = (double)n1*gtv[1][3] + (double)n2*gtv[2][3]
+	                  + (double)n3*gtv[3][3] + Grid_Origin[3];
 
-	  po = 1;
-	  ct_AN = 1;
-	  do{
-
-            wan = WhatSpecies[ct_AN];
-
-	    dx = x - Gxyz[ct_AN][1]; 
-	    dy = y - Gxyz[ct_AN][2]; 
-	    dz = z - Gxyz[ct_AN][3]; 
+	  Grid_V[p] = VHart[n1][n2][n3];
+          p++;
+	}
+      }
+    }
+  }
 
-	    r = sqrt(dx*dx + dy*dy + dz*dz);
- 
-	    if ( r < (scale1*Atom_vdw[wan]) ) po = 0;
+  free(flag);
+  free(next);
+  free(head);
+}
 
-	    ct_AN++;
-	  } while (ct_AN<=atomnum && po==1);
+void open_vhart(char *name)
+{
+  char file[YOUSO10+20];
+  FILE *fp;
 
-	  if (po==0)  grid_flag[n1][n2][n3] = 0; 
+  /* name.vhart.cube.bin is used if it exists */
 
-	}
+  sprintf(file,"%s.vhart.cube.bin",name);
 
-      }
-    }
+  if ((fp = fopen(file,"rb")) != NULL){
+    fclose(fp);
+    read_vhart_bin(file);
+  }
+  else{
+    sprintf(file,"%s.vhart.cube",name);
+    read_vhart(file);
   }
-
 }
 
+
 void read_vhart(char *file)
 {
   static int i,ct_AN,n1,n2,n3;
@@ -792,17 +799,7 @@ void read_vhart(char *file)
     fscanf(fp,"%d %lf %lf %lf",&Ngrid2,&gtv[2][1],&gtv[2][2],&gtv[2][3]);
     fscanf(fp,"%d %lf %lf %lf",&Ngrid3,&gtv[3][1],&gtv[3][2],&gtv[3][3]);
 
-    tv[1][1] = (double)Ngrid1*gtv[1][1];
-    tv[1][2] = (double)Ngrid1*gtv[1][2];
-    tv[1][3] = (double)Ngrid1*gtv[1][3];
-
-    tv[2][1] = (double)Ngrid2*gtv[2][1];
-    tv[2][2] = (double)Ngrid2*gtv[2][2];
-    tv[2][3] = (double)Ngrid2*gtv[2][3];
-
-    tv[3][1] = (double)Ngrid3*gtv[3][1];
-    tv[3][2] = (double)Ngrid3*gtv[3][2];
-    tv[3][3] = (double)Ngrid3*gtv[3][3];
+    set_tv();
 
     VHart = (double***)malloc(sizeof(double**)*Ngrid1);
     for (n1=0; n1<Ngrid1; n1++){
@@ -812,38 +809,6 @@ void read_vhart(char *file)
       }
     }
 
-    X_grid = (double***)malloc(sizeof(double**)*Ngrid1);
-    for (n1=0; n1<Ngrid1; n1++){
-      X_grid[n1] = (double**)malloc(sizeof(double*)*Ngrid2);
-      for (n2=0; n2<Ngrid2; n2++){
-        X_grid[n1][n2] = (double*)malloc(sizeof(double)*Ngrid3);
-      }
-    }
-
-    Y_grid = (double***)malloc(sizeof(double**)*Ngrid1);
-    for (n1=0; n1<Ngrid1; n1++){
-      Y_grid[n1] = (double**)malloc(sizeof(double*)*Ngrid2);
-      for (n2=0; n2<Ngrid2; n2++){
-        Y_grid[n1][n2] = (double*)malloc(sizeof(double)*Ngrid3);
-      }
-    }
-
-    Z_grid = (double***)malloc(sizeof(double**)*Ngrid1);
-    for (n1=0; n1<Ngrid1; n1++){
-      Z_grid[n1] = (double**)malloc(sizeof(double*)*Ngrid2);
-      for (n2=0; n2<Ngrid2; n2++){
-        Z_grid[n1][n2] = (double*)malloc(sizeof(double)*Ngrid3);
-      }
-    }
-
-    grid_flag = (int***)malloc(sizeof(int**)*Ngrid1);
-    for (n1=0; n1<Ngrid1; n1++){
-      grid_flag[n1] = (int**)malloc(sizeof(int*)*Ngrid2);
-      for (n2=0; n2<Ngrid2; n2++){
-        grid_flag[n1][n2] = (int*)malloc(sizeof(int)*Ngrid3);
-      }
-    }
-
     /* Gxyz */
     for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
       fscanf(fp,"%d %lf %lf %lf %lf",
@@ -861,21 +826,6 @@ void read_vhart(char *file)
       }
     }
 
-    /* XYZ_grid */
-    for (n1=0; n1<Ngrid1; n1++){
-      for (n2=0; n2<Ngrid2; n2++){
-        for (n3=0; n3<Ngrid3; n3++){
-
-  	  X_grid[n1][n2][n3] = (double)n1*gtv[1][1] + (double)n2*gtv[2][1]
- 	                     + (double)n3*gtv[3][1] + Grid_Origin[1];
-	  Y_grid[n1][n2][n3] = (double)n1*gtv[1][2] + (double)n2*gtv[2][2]
-	                     + (double)n3*gtv[3][2] + Grid_Origin[2];
-	  Z_grid[n1][n2][n3] = (double)n1*gtv[1][3] + (double)n2*gtv[2][3]
-	                     + (double)n3*gtv[3][3] + Grid_Origin[3];
-	}
-      }
-    }
-
     fclose(fp);
   }
   else{
@@ -888,6 +838,96 @@ void read_vhart(char *file)
 
 
 
+void read_vhart_bin(char *file)
+{
+  int fd,ct_AN,n1,n2;
+  long int size,ngrid;
+  char *map,*p;
+  double *dlist,*data;
+  struct stat st;
+
+  /* the file is mapped to the memory, and VHart points to the data */
+
+  if ((fd = open(file,O_RDONLY))<0 || fstat(fd,&st)!=0){
+    printf("Failure of reading vhart file.\n");
+    exit(0);
+  }
+
+  size = (long int)st.st_size;
+  map = (char*)mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+
+  if (map==MAP_FAILED || size<Cube_Bin_Head){
+    printf("Failure of reading vhart file.\n");
+    exit(0);
+  }
+
+  /* the header given by Print_CubeTitle in OutData_Binary.c */
+
+  p = map + 400;
+  memcpy(&atomnum,p,sizeof(int));             p += sizeof(int);
+  memcpy(&Grid_Origin[1],p,sizeof(double)*3); p += sizeof(double)*3;
+  memcpy(&Ngrid1,p,sizeof(int));              p += sizeof(int);
+  memcpy(&gtv[1][1],p,sizeof(double)*3);      p += sizeof(double)*3;
+  memcpy(&Ngrid2,p,sizeof(int));              p += sizeof(int);
+  memcpy(&gtv[2][1],p,sizeof(double)*3);      p += sizeof(double)*3;
+  memcpy(&Ngrid3,p,sizeof(int));              p += sizeof(int);
+  memcpy(&gtv[3][1],p,sizeof(double)*3);      p += sizeof(double)*3;
+
+  ngrid = (long int)Ngrid1*Ngrid2*Ngrid3;
+
+  if (atomnum<=0 || ngrid<=0 || size<Cube_Bin_Head+(long int)sizeof(double)*(5*atomnum+ngrid)){
+    printf("Failure of reading vhart file.\n");
+    exit(0);
+  }
+
+  Gxyz = (double**)malloc(sizeof(double*)*(atomnum+1));
+  for (ct_AN=0; ct_AN<=atomnum; ct_AN++){
+    Gxyz[ct_AN] = (double*)malloc(sizeof(double)*4);
+  }
+  WhatSpecies = (int*)malloc(sizeof(int)*(atomnum+1));
+
+  dlist = (double*)p;
+  for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
+    WhatSpecies[ct_AN] = (int)dlist[5*(ct_AN-1)];
+    Gxyz[ct_AN][1] = dlist[5*(ct_AN-1)+2];
+    Gxyz[ct_AN][2] = dlist[5*(ct_AN-1)+3];
+    Gxyz[ct_AN][3] = dlist[5*(ct_AN-1)+4];
+  }
+  p += sizeof(double)*5*atomnum;
+
+  data = (double*)p;
+  VHart = (double***)malloc(sizeof(double**)*Ngrid1);
+  for (n1=0; n1<Ngrid1; n1++){
+    VHart[n1] = (double**)malloc(sizeof(double*)*Ngrid2);
+    for (n2=0; n2<Ngrid2; n2++){
+      VHart[n1][n2] = &data[((long int)n1*Ngrid2+n2)*Ngrid3];
+    }
+  }
+
+  set_tv();
+}
+
+
+void set_tv()
+{
+  int i,j;
+  int Ngrid[4];
+
+  Ngrid[1] = Ngrid1;
+  Ngrid[2] = Ngrid2;
+  Ngrid[3] = Ngrid3;
+
+  for (i=1; i<=3; i++){
+    for (j=1; j<=3; j++){
+      tv[i][j] = (double)Ngrid[i]*gtv[i][j];
+    }
+  }
+}
+
+
+
+
 void read_vna(char *file)
 {
 
@@ -9,11 +9,15 @@
      30/Aug/2003  Released by Myung Joon Han (supervised by Prof. J. Yu)
       7/Dec/2003  Modified by Taisuke Ozaki
      03/Mar/2011  Modified by Fumiyuki Ishii for MPI 
+     18/Oct/2026  all-pairs mode: J of a list of pairs, or of all the
+                  pairs within a cutoff, with one diagonalization per
+                  k-point (options -pairs and -cutoff)
 ***********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 #include <sys/types.h>
 #include <sys/times.h>
@@ -48,6 +52,13 @@ static void Hamiltonian_Band(double ****RH, dcomplex **H, int *MP,
 static void calc_J_band1(int First_Atom, int Second_Atom, int *MPF,
                          dcomplex ***C, double **ko,
                          int F_TNumOrbs, int F_TNumOrbs3, double Jmat[2]);
+static int Band_Eigen_k(double k1, double k2, double k3, int *MPF,
+                        dcomplex **H, dcomplex **S, dcomplex **C,
+                        dcomplex ***Coes, double **ko, double *M1);
+static void calc_J_band_pairs(int Num_Pairs, int **Pairs, int *MPF,
+                              dcomplex ***C, double **ko, int n1,
+                              double *Jr, double *Ji);
+static int jx_pairs(int argc, char *argv[], int ***Pairs);
 static void dtime(double *t);
 
 
@@ -89,10 +100,14 @@ int main(int argc, char *argv[])
   double *JiTk;
   /* for MPI end */
 
+  /* for the all-pairs mode */
+  int p,Num_Pairs,**Pairs;
+  double *Jr_pairs,*Ji_pairs;
+
   static double snum_i,snum_j,snum_k;
   static double *KGrids1,*KGrids2,*KGrids3;
   static double Jmat[2],Jr,Ji;
-  static int ij,ik,P_min;
+  static int ij,ik;
   static int knum_i,knum_j,knum_k;
   static int knum_switch;
   static int ***k_op;
@@ -100,11 +115,10 @@ int main(int argc, char *argv[])
   static dcomplex **H,**S,**C,***Coes;
   static double **ko, *M1;
   static double k1,k2,k3; 
-  static double OLP_eigen_cut = 1.0e-10;
 
   /* variable & arrays for PART-2; same with that of Cluster_DFT.c */
-  static int l,n,n2,n1,i1,j1,l1;
-  static double sum,sumi,sum1;
+  static int l,n2,n1,l1;
+  static double sum,sum1;
 
   /* MPI initialize */
 
@@ -399,14 +413,77 @@ int main(int argc, char *argv[])
       if (E_knum<0)           E_knum = 0;
     }
 
+    /****************************************************
+       all-pairs mode: each k-point is diagonalized once,
+       and J of all the pairs is evaluated in the same pass
+    ****************************************************/
+
+    end_switch = 0;
+    Num_Pairs = jx_pairs(argc, argv, &Pairs);
+
+    if (0<=Num_Pairs){
+
+      Jr_pairs = (double*)malloc(sizeof(double)*Num_Pairs);
+      Ji_pairs = (double*)malloc(sizeof(double)*Num_Pairs);
+
+      for (p=0; p<Num_Pairs; p++){
+        Jr_pairs[p] = 0.0;
+        Ji_pairs[p] = 0.0;
+      }
+
+      /* the k-points of myid */
+
+      for (kloop=S_knum; 0<=kloop && kloop<=E_knum; kloop++){
+
+        k1 = T_KGrids1[kloop];
+        k2 = T_KGrids2[kloop];
+        k3 = T_KGrids3[kloop];
+
+        n1 = Band_Eigen_k(k1,k2,k3,MPF,H,S,C,Coes,ko,M1);
+        calc_J_band_pairs(Num_Pairs, Pairs, MPF, Coes, ko, n1, Jr_pairs, Ji_pairs);
+      }
+
+      /* sum over the k-points */
+
+      MPI_Allreduce(MPI_IN_PLACE, Jr_pairs, Num_Pairs, MPI_DOUBLE, MPI_SUM, comm1);
+      MPI_Allreduce(MPI_IN_PLACE, Ji_pairs, Num_Pairs, MPI_DOUBLE, MPI_SUM, comm1);
+
+      if (myid==Host_ID){
+
+        printf("\n     i     j     r (Ang)        J_ij (cm^{-1})\n");
+
+        for (p=0; p<Num_Pairs; p++){
+
+          First_Atom  = Pairs[p][0];
+          Second_Atom = Pairs[p][1];
+
+          sum = 0.0;
+          for (l=1; l<=3; l++){
+            sum += (Gxyz[First_Atom][l]-Gxyz[Second_Atom][l])
+                  *(Gxyz[First_Atom][l]-Gxyz[Second_Atom][l]);
+          }
+
+          printf(" %5d %5d %12.6f %20.12f\n",
+                 First_Atom, Second_Atom, 0.529177249*sqrt(sum),
+                 Jr_pairs[p]/(double)(knum_i*knum_j*knum_k));
+        }
+      }
+
+      free(Pairs[0]);
+      free(Pairs);
+      free(Jr_pairs);
+      free(Ji_pairs);
+
+      end_switch = 1;
+    }
+
     /****************************************************
                          start calc J
     ****************************************************/
 
     /** printf("\n"); **/
 
-    end_switch = 0;
-    do {
+    while (end_switch==0){
 
       /* specify two atoms */ 
       if (myid==Host_ID){
@@ -482,88 +559,7 @@ int main(int argc, char *argv[])
 			 atom i in arraies H and S
 	    ****************************************************/
 
-	    Overlap_Band(OLP,S,MPF,k1,k2,k3);
-
-	    n = S[0][0].r;
-	    EigenBand_lapack(S,ko[0],n);
-
-	    P_min = 1;
-	    for (l=1; l<=n; l++) if (ko[0][l]<OLP_eigen_cut) P_min = l + 1;
-	    for (l=P_min; l<=n; l++) M1[l] = 1.0/sqrt(ko[0][l]);
-
-	    for (spin=0; spin<=SpinP_switch; spin++){
-
-	      Hamiltonian_Band(Hks[spin], H, MPF, k1, k2, k3);
-
-	      /****************************************************
-			   M1 * U^t * H * U * M1
-	      ****************************************************/
- 
-	      for (i1=1; i1<=n; i1++){
-		for (j1=P_min; j1<=n; j1++){
-		  sum = 0.0; sumi=0.0;
-		  for (l=1; l<=n; l++){
-		    sum  += ( H[i1][l].r*S[l][j1].r
-			    - H[i1][l].i*S[l][j1].i)*M1[j1];
-		    sumi += ( H[i1][l].r*S[l][j1].i
-			    + H[i1][l].i*S[l][j1].r)*M1[j1];
-		  }
-		  C[i1][j1].r = sum;
-		  C[i1][j1].i = sumi;
-		}
-	      }     
-
-	      for (i1=P_min; i1<=n; i1++){
-		for (j1=1; j1<=n; j1++){
-		  sum = 0.0; sumi=0.0;
-		  for (l=1; l<=n; l++){
-		    sum  +=  M1[i1]*( S[l][i1].r*C[l][j1].r +
-				      S[l][i1].i*C[l][j1].i );
-		    sumi +=  M1[i1]*( S[l][i1].r*C[l][j1].i -
-				      S[l][i1].i*C[l][j1].r );
-		  }
-		  H[i1][j1].r = sum;
-		  H[i1][j1].i = sumi;
-		}
-	      }     
-
-	      for (i1=P_min; i1<=n; i1++){
-		for (j1=P_min; j1<=n; j1++){
-		  C[i1-(P_min-1)][j1-(P_min-1)] = H[i1][j1];
-		}
-	      }
-
-	      n1 = n - (P_min - 1);
-	      EigenBand_lapack(C,ko[spin],n1);
-
-	      /****************************************************
-		   Transformation to the original eigenvectors.
-			   NOTE JRCAT-244p and JAIST-2122p 
-	      ****************************************************/
-
-	      for (i1=1; i1<=n; i1++){
-		for (j1=1; j1<=n; j1++){
-		  H[i1][j1].r = 0.0;
-		  H[i1][j1].i = 0.0;
-		}
-	      }
-
-	      for (i1=1; i1<=n; i1++){
-		for (j1=1; j1<=n1; j1++){
-		  sum = 0.0; sumi=0.0;
-		  for (l=P_min; l<=n; l++){
-		    sum  +=  S[i1][l].r*M1[l]*C[l-(P_min-1)][j1].r
-		           - S[i1][l].i*M1[l]*C[l-(P_min-1)][j1].i;
-		    sumi +=  S[i1][l].r*M1[l]*C[l-(P_min-1)][j1].i
-		           + S[i1][l].i*M1[l]*C[l-(P_min-1)][j1].r;
-		  }
-		  Coes[spin][i1][j1].r = sum;
-		  Coes[spin][i1][j1].i = sumi;
-		}
-	      }
-
-
-	    } /* spin */
+	    n1 = Band_Eigen_k(k1,k2,k3,MPF,H,S,C,Coes,ko,M1);
 
 	    /************************************************************************* 
 	       PART-3 : Calculation of J
@@ -614,7 +610,7 @@ int main(int argc, char *argv[])
 	}
       } /* else */
 
-    } while(end_switch==0);
+    } /* while (end_switch==0) */
     /*********************************************
     freeing of arrays:
 
@@ -719,7 +715,7 @@ void jx_cluster1(int argc, char *argv[])
   double **FullOLP;  /* full overlap     */
 
   /* variable & arrays for PART-2; same with that of Cluster_DFT.c */
-  static int l,n,n2,n1,i1,j1,k1,l1;
+  static int l,n,n2,i1,j1,k1,l1;
   static double **ko, *M1;
   static double **B, ***C, **D;
   static double sum,sum1;                                                      
@@ -1549,6 +1545,396 @@ void calc_J_band1(int First_Atom, int Second_Atom, int *MPF, dcomplex ***C, doub
 
 
 
+
+int Band_Eigen_k(double k1, double k2, double k3, int *MPF,
+                 dcomplex **H, dcomplex **S, dcomplex **C,
+                 dcomplex ***Coes, double **ko, double *M1)
+{
+  /* the eigenvalues ko[spin][1:n1] and the eigenvectors
+     Coes[spin][1:n][1:n1] at k, which are used for all the pairs */
+
+  int l,n,n1,i1,j1,spin,P_min;
+  double sum,sumi;
+  double OLP_eigen_cut = 1.0e-10;
+
+  Overlap_Band(OLP,S,MPF,k1,k2,k3);
+
+  n = S[0][0].r;
+  EigenBand_lapack(S,ko[0],n);
+
+  P_min = 1;
+  for (l=1; l<=n; l++) if (ko[0][l]<OLP_eigen_cut) P_min = l + 1;
+  for (l=P_min; l<=n; l++) M1[l] = 1.0/sqrt(ko[0][l]);
+
+  n1 = n - (P_min - 1);
+
+  for (spin=0; spin<=SpinP_switch; spin++){
+
+    Hamiltonian_Band(Hks[spin], H, MPF, k1, k2, k3);
+
+    /****************************************************
+		 M1 * U^t * H * U * M1
+    ****************************************************/
+ 
+    for (i1=1; i1<=n; i1++){
+      for (j1=P_min; j1<=n; j1++){
+	sum = 0.0; sumi=0.0;
+	for (l=1; l<=n; l++){
+	  sum  += ( H[i1][l].r*S[l][j1].r
+		  - H[i1][l].i*S[l][j1].i)*M1[j1];
+	  sumi += ( H[i1][l].r*S[l][j1].i
+		  + H[i1][l].i*S[l][j1].r)*M1[j1];
+	}
+	C[i1][j1].r = sum;
+	C[i1][j1].i = sumi;
+      }
+    }     
+
+    for (i1=P_min; i1<=n; i1++){
+      for (j1=1; j1<=n; j1++){
+	sum = 0.0; sumi=0.0;
+	for (l=1; l<=n; l++){
+	  sum  +=  M1[i1]*( S[l][i1].r*C[l][j1].r +
+			    S[l][i1].i*C[l][j1].i );
+	  sumi +=  M1[i1]*( S[l][i1].r*C[l][j1].i -
+			    S[l][i1].i*C[l][j1].r );
+	}
+	H[i1][j1].r = sum;
+	H[i1][j1].i = sumi;
+      }
+    }     
+
+    for (i1=P_min; i1<=n; i1++){
+      for (j1=P_min; j1<=n; j1++){
+	C[i1-(P_min-1)][j1-(P_min-1)] = H[i1][j1];
+      }
+    }
+
+    EigenBand_lapack(C,ko[spin],n1);
+
+    /****************************************************
+	 Transformation to the original eigenvectors.
+		 NOTE JRCAT-244p and JAIST-2122p 
+    ****************************************************/
+
+    for (i1=1; i1<=n; i1++){
+      for (j1=1; j1<=n; j1++){
+	H[i1][j1].r = 0.0;
+	H[i1][j1].i = 0.0;
+      }
+    }
+
+    for (i1=1; i1<=n; i1++){
+      for (j1=1; j1<=n1; j1++){
+	sum = 0.0; sumi=0.0;
+	for (l=P_min; l<=n; l++){
+	  sum  +=  S[i1][l].r*M1[l]*C[l-(P_min-1)][j1].r
+		 - S[i1][l].i*M1[l]*C[l-(P_min-1)][j1].i;
+	  sumi +=  S[i1][l].r*M1[l]*C[l-(P_min-1)][j1].i
+		 + S[i1][l].i*M1[l]*C[l-(P_min-1)][j1].r;
+	}
+	Coes[spin][i1][j1].r = sum;
+	Coes[spin][i1][j1].i = sumi;
+      }
+    }
+
+
+  } /* spin */
+
+  return n1;
+}
+
+
+void calc_J_band_pairs(int Num_Pairs, int **Pairs, int *MPF,
+                       dcomplex ***C, double **ko, int n1,
+                       double *Jr, double *Ji)
+{
+  int p,spin,ct_AN,NO,MA,jj,ll,b;
+  int *used;
+  double v,sum_r,sum_i;
+  double *Fftn0,*Fftn1;
+  dcomplex ****T;
+  static double kB=0.000003166813628;  /* Boltzman constant (Hatree/K) */
+
+  /*********************************************
+   With V_i = 0.5*( H_i,up - H_i,down ) of the
+   on-site block (h_AN=0) of atom i,
+
+     T[spin][i][jj][b] = sum_ll V_i[jj][ll] C[spin][ll][b]
+
+   is made once per atom, so that VVi and VVj
+   of calc_J_band1 are products of C and T.
+  *********************************************/
+
+  used = (int*)malloc(sizeof(int)*(atomnum+1));
+  for (ct_AN=0; ct_AN<=atomnum; ct_AN++) used[ct_AN] = 0;
+  for (p=0; p<Num_Pairs; p++){
+    used[Pairs[p][0]] = 1;
+    used[Pairs[p][1]] = 1;
+  }
+
+  T = (dcomplex****)malloc(sizeof(dcomplex***)*2);
+  for (spin=0; spin<=1; spin++){
+    T[spin] = (dcomplex***)malloc(sizeof(dcomplex**)*(atomnum+1));
+    for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
+      T[spin][ct_AN] = NULL;
+      if (used[ct_AN]){
+        NO = Total_NumOrbs[ct_AN];
+        T[spin][ct_AN] = (dcomplex**)malloc(sizeof(dcomplex*)*NO);
+        for (jj=0; jj<NO; jj++){
+          T[spin][ct_AN][jj] = (dcomplex*)malloc(sizeof(dcomplex)*(n1+1));
+        }
+      }
+    }
+  }
+
+#pragma omp parallel for schedule(dynamic) private(ct_AN,NO,MA,spin,jj,ll,b,v,sum_r,sum_i)
+  for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
+
+    if (used[ct_AN]){
+
+      NO = Total_NumOrbs[ct_AN];
+      MA = MPF[ct_AN];
+
+      for (spin=0; spin<=1; spin++){
+        for (jj=0; jj<NO; jj++){
+          for (b=1; b<=n1; b++){
+
+            sum_r = 0.0;
+            sum_i = 0.0;
+
+            for (ll=0; ll<NO; ll++){
+              v = 0.5*(Hks[0][ct_AN][0][jj][ll] - Hks[1][ct_AN][0][jj][ll]);
+              sum_r += v*C[spin][MA+ll][b].r;
+              sum_i += v*C[spin][MA+ll][b].i;
+            }
+
+            T[spin][ct_AN][jj][b].r = sum_r;
+            T[spin][ct_AN][jj][b].i = sum_i;
+          }
+        }
+      }
+    }
+  }
+
+  /* the Fermi function */
+
+  Fftn0 = (double*)malloc(sizeof(double)*(n1+1));
+  Fftn1 = (double*)malloc(sizeof(double)*(n1+1));
+
+  for (b=1; b<=n1; b++){
+    Fftn0[b] = 1.0/( exp( (ko[0][b]- ChemP)/(kB*E_Temp) ) + 1.0 );
+    Fftn1[b] = 1.0/( exp( (ko[1][b]- ChemP)/(kB*E_Temp) ) + 1.0 );
+  }
+
+  /*********************************************
+   J_ij of the pairs, distributed over threads:
+
+     J_ij = sum_ab 0.5*(f0_a - f1_b)/(e1_b - e0_a)
+                  * VVj[0][1][a][b] * VVi[1][0][b][a]
+
+   The pairs of bands with f0_a = f1_b, i.e.,
+   both occupied or both unoccupied, do not
+   contribute and are skipped.
+  *********************************************/
+
+#pragma omp parallel for schedule(dynamic) private(p)
+  for (p=0; p<Num_Pairs; p++){
+
+    int I,J,NOI,NOJ,MI,MJ,a,b,ii;
+    double Ar,Ai,Br,Bi,dFftn,dko,J_ij_r,J_ij_i;
+    dcomplex c,t;
+
+    I = Pairs[p][0];
+    J = Pairs[p][1];
+    NOI = Total_NumOrbs[I];
+    NOJ = Total_NumOrbs[J];
+    MI = MPF[I];
+    MJ = MPF[J];
+
+    J_ij_r = 0.0;
+    J_ij_i = 0.0;
+
+    for (a=1; a<=n1; a++){
+      for (b=1; b<=n1; b++){
+
+        dFftn = Fftn0[a] - Fftn1[b];
+        if (dFftn==0.0) continue;
+
+        /* VVj[0][1][a][b] */
+
+        Ar = 0.0;
+        Ai = 0.0;
+        for (ii=0; ii<NOJ; ii++){
+          c = C[0][MJ+ii][a];
+          t = T[1][J][ii][b];
+          Ar += c.r*t.r + c.i*t.i;
+          Ai += c.r*t.i - c.i*t.r;
+        }
+
+        /* VVi[1][0][b][a] */
+
+        Br = 0.0;
+        Bi = 0.0;
+        for (ii=0; ii<NOI; ii++){
+          c = C[1][MI+ii][b];
+          t = T[0][I][ii][a];
+          Br += c.r*t.r + c.i*t.i;
+          Bi += c.r*t.i - c.i*t.r;
+        }
+
+        dko = ko[1][b] - ko[0][a];
+        J_ij_r += 0.5*dFftn*(Ar*Br - Ai*Bi)/dko;
+        J_ij_i += 0.5*dFftn*(Ar*Bi + Ai*Br)/dko;
+      }
+    }
+
+    /* unit conversion: Hartree to cm^{-1} */
+
+    Jr[p] += 2.194746*100000.0*J_ij_r;
+    Ji[p] += 2.194746*100000.0*J_ij_i;
+  }
+
+  /* freeing of arrays */
+
+  free(Fftn1);
+  free(Fftn0);
+
+  for (spin=0; spin<=1; spin++){
+    for (ct_AN=1; ct_AN<=atomnum; ct_AN++){
+      if (used[ct_AN]){
+        for (jj=0; jj<Total_NumOrbs[ct_AN]; jj++){
+          free(T[spin][ct_AN][jj]);
+        }
+        free(T[spin][ct_AN]);
+      }
+    }
+    free(T[spin]);
+  }
+  free(T);
+  free(used);
+}
+
+
+int jx_pairs(int argc, char *argv[], int ***Pairs)
+{
+  /*********************************************
+   The pairs of the all-pairs mode are given by
+
+     jx file.scfout -pairs file.pairs
+
+   where each line of file.pairs has two atoms
+   "i j", or by
+
+     jx file.scfout -cutoff r
+
+   for all the pairs i<j with |R_i-R_j|<=r (Ang).
+   Without the options, -1 is returned, and the
+   pairs are asked one by one as before.
+  *********************************************/
+
+  int i,j,k,l,num,myid;
+  int atm[2];
+  double rcut,sum;
+  char *fpairs;
+  FILE *fp;
+
+  MPI_Comm_rank(comm1,&myid);
+
+  fpairs = NULL;
+  rcut = -1.0;
+
+  for (i=2; i<(argc-1); i++){
+    if      (strcmp(argv[i],"-pairs")==0)  fpairs = argv[i+1];
+    else if (strcmp(argv[i],"-cutoff")==0) rcut = atof(argv[i+1]);
+  }
+
+  if (fpairs==NULL && rcut<0.0) return -1;
+
+  /* count the pairs, and store them in the second pass */
+
+  *Pairs = NULL;
+
+  for (k=0; k<2; k++){
+
+    num = 0;
+
+    if (fpairs!=NULL){
+
+      /* Host_ID reads the file */
+
+      if (myid==Host_ID){
+
+        if ((fp = fopen(fpairs,"r")) != NULL){
+
+          while (fscanf(fp,"%d %d",&atm[0],&atm[1])==2){
+
+            if (atm[0]<1 || atomnum<atm[0] || atm[1]<1 || atomnum<atm[1]){
+              if (k==0) printf(" Invalid atom: %d %d\n",atm[0],atm[1]);
+            }
+            else{
+              if (k==1){
+                (*Pairs)[num][0] = atm[0];
+                (*Pairs)[num][1] = atm[1];
+              }
+              num++;
+            }
+          }
+
+          fclose(fp);
+        }
+        else{
+          if (k==0) printf(" Could not open a file %s\n",fpairs);
+        }
+      }
+
+      MPI_Bcast(&num, 1, MPI_INT, Host_ID, comm1);
+    }
+
+    else{
+
+      for (i=1; i<=atomnum; i++){
+        for (j=i+1; j<=atomnum; j++){
+
+          sum = 0.0;
+          for (l=1; l<=3; l++){
+            sum += (Gxyz[i][l]-Gxyz[j][l])*(Gxyz[i][l]-Gxyz[j][l]);
+          }
+
+          if (0.529177249*sqrt(sum)<=rcut){
+            if (k==1){
+              (*Pairs)[num][0] = i;
+              (*Pairs)[num][1] = j;
+            }
+            num++;
+          }
+        }
+      }
+    }
+
+    if (k==0){
+      *Pairs = (int**)malloc(sizeof(int*)*(num+1));
+      (*Pairs)[0] = (int*)malloc(sizeof(int)*(2*num+1));
+      for (i=1; i<num; i++){
+        (*Pairs)[i] = (*Pairs)[0] + 2*i;
+      }
+    }
+  }
+
+  /* the pairs read by Host_ID */
+
+  if (fpairs!=NULL && 0<num){
+    MPI_Bcast((*Pairs)[0], 2*num, MPI_INT, Host_ID, comm1);
+  }
+
+  if (myid==Host_ID){
+    printf("\n All-pairs mode: J of %d pairs with one diagonalization per k-point\n",num);
+  }
+
+  return num;
+}
+
+
 void calc_J_cluster1(int First_Atom, int Second_Atom, int *MPF, double ***C, double **ko,
                      int F_TNumOrbs, int F_TNumOrbs3)
 {
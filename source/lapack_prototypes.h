@@ -82,6 +82,8 @@ void zheev_(char *JOBZ, char *UPLO, INTEGER *N, dcomplex *A, INTEGER *LDA, doubl
 void zheevx_(char *JOBZ, char *RANGE, char *UPLO, INTEGER *N, dcomplex *A, INTEGER *LDA, double *VL, double *VU, INTEGER *IL, INTEGER *IU,
                         double *ABSTOL, INTEGER *M, double *W, dcomplex *Z, INTEGER *LDZ, dcomplex *WORK, INTEGER *LWORK, double *RWORK,
                         INTEGER *IWORK, INTEGER *IFAIL, INTEGER *INFO);
+void zheevd_(char *JOBZ, char *UPLO, INTEGER *N, dcomplex *A, INTEGER *LDA, double *W, dcomplex *WORK, INTEGER *LWORK,
+       double *RWORK, INTEGER *LRWORK, INTEGER *IWORK, INTEGER *LIWORK, INTEGER *INFO);
 
 
 void zheev_(char *JOBZ, char *UPLO, int *N, dcomplex *A, int *LDA, double *W, dcomplex *WORK, int *LWORK, double *RWORK,
@@ -111,6 +113,8 @@ void zgesv_(INTEGER *n, INTEGER *nrhs, dcomplex *a, INTEGER *lda,
 
 void dpotrf_(char *uplo, INTEGER *n, double *a, INTEGER *lda, INTEGER *info);
 void dpotri_(char *uplo, INTEGER *n, double *a, INTEGER *lda, INTEGER *info);
+void dtrsm_(char *side, char *uplo, char *transa, char *diag, INTEGER *m, INTEGER *n,
+            double *alpha, double *a, INTEGER *lda, double *b, INTEGER *ldb);
 void dggevx_(char *balanc, char *jobvl, char *jobvr, char *sense,
              INTEGER *n, double *a, INTEGER *lda, double *b, 
 	     INTEGER *ldb, double *alphar, double *alphai, double *beta,
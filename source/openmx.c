@@ -103,9 +103,10 @@ int main(int argc, char *argv[])
     exit(0);
   } 
 
-  /* initialize Runtest_flag */
+  /* initialize Runtest_flag and Bench_flag */
 
   Runtest_flag = 0;
+  Bench_flag = 0;
 
   /****************************************************
     ./openmx -nt # 
@@ -156,6 +157,36 @@ int main(int argc, char *argv[])
     printf("\nThe number of threads in each node for OpenMP parallelization is %d.\n\n",openmp_threads_num);
   }
 
+  /****************************************************
+    ./openmx -bind none|compact|spread
+    ./openmx -firsttouch on|off
+
+    overwrite NUMA.Bind and NUMA.FirstTouch given
+    in the input file
+  ****************************************************/
+
+  NUMA_Bind_cmd = -1;
+  NUMA_FirstTouch_cmd = -1;
+
+  if (myid==Host_ID){
+    for (i=1; i<(argc-1); i++){
+      if ( strcmp(argv[i],"-bind")==0 ){
+        if      ( strcasecmp(argv[i+1],"none")==0 )    NUMA_Bind_cmd = 0;
+        else if ( strcasecmp(argv[i+1],"compact")==0 ) NUMA_Bind_cmd = 1;
+        else if ( strcasecmp(argv[i+1],"spread")==0 )  NUMA_Bind_cmd = 2;
+        else    printf("check the option of -bind\n");
+      }
+      if ( strcmp(argv[i],"-firsttouch")==0 ){
+        if      ( strcasecmp(argv[i+1],"off")==0 ) NUMA_FirstTouch_cmd = 0;
+        else if ( strcasecmp(argv[i+1],"on")==0 )  NUMA_FirstTouch_cmd = 1;
+        else    printf("check the option of -firsttouch\n");
+      }
+    }
+  }
+
+  MPI_Bcast(&NUMA_Bind_cmd, 1, MPI_INT, Host_ID, MPI_COMM_WORLD1);
+  MPI_Bcast(&NUMA_FirstTouch_cmd, 1, MPI_INT, Host_ID, MPI_COMM_WORLD1);
+
   /****************************************************
     ./openmx -show directory 
 
@@ -192,6 +223,18 @@ int main(int argc, char *argv[])
     Runtest("S",argc,argv);
   }
 
+  /****************************************************
+   ./openmx -benchmark [size]
+
+   measure the performance of computational kernels
+   for synthetic systems, and strong and weak scaling
+   over threads and processes.
+  ****************************************************/
+
+  if (strcmp(argv[1],"-benchmark")==0){
+    Benchmark(argc,argv);
+  }
+
   /****************************************************
    ./openmx -maketestL
 
@@ -445,6 +488,10 @@ int main(int argc, char *argv[])
 
   MPI_Barrier(MPI_COMM_WORLD1);
 
+  /* binding of threads and report of the placement */
+
+  NUMA_Policy_Init();
+
   /* initialize PrintMemory routine */
 
   sprintf(fileMemory,"%s%s.memory%i",filepath,filename,myid);
@@ -703,8 +750,11 @@ int main(int argc, char *argv[])
   /* free arrays */
 
   Free_Arrays(0);
+  Purify_Free();
   /* print memory */
 
+  Arena_PrintMemory();
+  Arena_Free();
   PrintMemory("total",0,"sum");
 
   MPI_Barrier(MPI_COMM_WORLD);
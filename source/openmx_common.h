@@ -1142,6 +1142,19 @@ Type_Orbs_Grid ***COrbs_Grid;
 *******************************************************/
 Type_Orbs_Grid ****Orbs_Grid_FNAN;
 
+/*******************************************************
+ Type_Orbs_Grid ***dOrbs_Grid;
+  Cartesian gradients of basis orbitals on grids, 
+  dOrbs_Grid[Mc_AN][Nc][3*i+k] with k=x,y,z.
+  allocated only if dOrbs_Grid_flag==1.
+  size: dOrbs_Grid[Matomnum+1]
+                  [GridN_Atom[Gc_AN]]
+                  [3*Spe_Total_NO[Cwan]]
+  allocation: allocate in truncation.c
+  free:       call as Free_Arrays(0) in openmx.c
+*******************************************************/
+Type_Orbs_Grid ***dOrbs_Grid;
+
 /*******************************************************
  double *****H0;
   matrix elements of basis orbitals for T+VNL
@@ -2448,12 +2461,18 @@ int MD_Init_Velocity,Correct_Position_flag;
 int rlmax_IS,XC_switch,PCC_switch,SpinP_switch,SpeciesNum,real_SpeciesNum;
 int Hub_U_switch,Hub_U_occupation,Hub_U_Enhance_OrbPol;  /* --- added by MJ */
 int SO_switch,MPI_tunedgrid_flag,Voronoi_Charge_flag,Voronoi_OrbM_flag;
+int Voronoi_Weight_Cache;
 int Constraint_NCS_switch,openmp_threads_eq_procs,openmp_threads_num;
 int Zeeman_NCS_switch,Zeeman_NCO_switch;
 int atomnum,Catomnum,Latomnum,Ratomnum;
 int POLES,rlmax,Solver,dste_flag,Ngrid_fixed_flag,scf_eigen_lib_flag;
+int Eigen_Subspace_flag,Eigen_Subspace_Degree,Eigen_Subspace_MaxIter;
+double Eigen_Subspace_Criterion;
 int KrylovH_order,KrylovS_order,recalc_EM,EKC_invS_flag;
 int EC_Sub_Dim,Energy_Decomposition_flag;
+int Purify_MaxIter;
+double Purify_Threshold,Purify_Criterion;
+int Pole_Npoles;
 int EKC_Exact_invS_flag,EKC_expand_core_flag,orderN_FNAN_SNAN_flag;
 int MD_switch,PeriodicGamma_flag,CellOpt_switch;
 int Max_FNAN,Max_FSNAN,Max_GridN_Atom,Max_NumOLG,Max_OneD_Grids;
@@ -2465,6 +2484,14 @@ int PreNum,TempNum,TCpyCell,CpyCell;
 int Runtest_flag;
 int Num_Mixing_pDM,level_stdout,level_fileout,HS_fileout;
 int memoryusage_fileout;  
+int Shared_Tables_flag;
+int NUMA_Bind,NUMA_Bind_cmd;
+int NUMA_FirstTouch,NUMA_FirstTouch_cmd;
+int Species_Cache_flag;
+char Species_Cache_Dir[YOUSO10];
+int Band_Restart;
+int Grid_Precision,Grid_Float_Comm;
+double Grid_Promotion_Criterion;
 int Pulay_SCF,Pulay_SCF_original,EveryPulay_SCF,SCF_Control_Temp;
 int Cnt_switch,RCnt_switch,SICnt_switch,ACnt_switch,SCnt_switch;
 int E_Field_switch,Simple_InitCnt[10];
@@ -2472,6 +2499,7 @@ int MD_Opt_OK,orbitalOpt_SCF,orbitalOpt_MD,orbitalOpt_per_MDIter;
 int orbitalOpt_History,orbitalOpt_StartPulay,OrbOpt_OptMethod;
 int orbitalOpt_Force_Skip,Initial_Hessian_flag;
 int NOHS_L,NOHS_C,ProExpn_VNA,BufferL_ProVNA;
+int dOrbs_Grid_switch,dOrbs_Grid_flag,dOrbs_Grid_kind;
 int M_GDIIS_HISTORY,OptStartDIIS,OptEveryDIIS;
 int Extrapolated_Charge_History;
 int orderN_Kgrid,FT_files_save,FT_files_read;
@@ -2483,6 +2511,26 @@ int Cell_Fixed_XYZ[4][4];
 
 double **CompTime;
 
+/* kernel timers used in the -benchmark mode (see Benchmark.c) */
+#define Num_Bench_Kernels    8
+#define Bench_Orbitals_Grid  0
+#define Bench_Density_Grid   1
+#define Bench_MatrixElements 2
+#define Bench_Poisson        3
+#define Bench_XC_Grid        4
+#define Bench_Eigen_PHH      5
+#define Bench_Krylov         6
+#define Bench_DC             7
+int Bench_flag;
+int Bench_Calls[Num_Bench_Kernels];
+double Bench_Time[Num_Bench_Kernels];
+
+/* queues of atoms for OpenMP threads in the O(N) methods (see Atom_Schedule.c) */
+#define Sched_Num            3
+#define Sched_DC_Col         0
+#define Sched_DC_NonCol      1
+#define Sched_Krylov         2
+
 char filename[YOUSO10],filepath[YOUSO10],command[YOUSO10];
 char DFT_DATA_PATH[YOUSO10];
 double Oopt_NormD[10];
@@ -2514,6 +2562,7 @@ int DosGauss_Num_Mesh;
 double DosGauss_Width;
 double Dos_Erange[2];
 int Dos_Kgrid[3];
+int Dos_Accum_Method,Dos_Dump;
 int Opticalconductivity_fileout;
 
 /*  electric field */ 
@@ -2575,6 +2624,8 @@ void Force_test(int argc, char *argv[]);
 void Check_Force(char *argv[]);
 void Stress_test(int argc, char *argv[]); 
 void Check_Stress(char *argv[]);
+void Benchmark(int argc, char *argv[]);
+void Bench_Record(int kernel, double time0);
 
 double RF_BesselF(int Gensi, int GL, int Mul, double R);
 double Nonlocal_RadialF(int Gensi, int l, int so, double R);
@@ -2757,6 +2808,23 @@ double Krylov(char *mode,
               double *****CDM,
               double *****EDM,
               double Eele0[2], double Eele1[2]);
+double Purify(char *mode,
+              int SCF_iter,
+              double *****Hks,
+              double *****ImNL,
+              double ****OLP0,
+              double *****CDM,
+              double *****EDM,
+              double Eele0[2], double Eele1[2]);
+void Purify_Free();
+double Pole_DFT(char *mode,
+                int SCF_iter,
+                double *****Hks,
+                double *****ImNL,
+                double ****OLP0,
+                double *****CDM,
+                double *****EDM,
+                double Eele0[2], double Eele1[2]);
 double Divide_Conquer_Dosout(double *****Hks,
                              double *****ImNL,
                              double ****OLP0);
@@ -2779,6 +2847,8 @@ void FT_ProductPAO();
 double Poisson(int fft_charge_flag,
                double *ReDenk, double *ImDenk);
 
+double Poisson_RS();
+
 double FFT_Density(int den_flag,
                    double *ReDenk, double *ImDenk);
 
@@ -2802,12 +2872,14 @@ double Set_Hamiltonian(char *mode,
                        double *****CDM,
                        double *****H);
 double Total_Energy(int MD_iter, double *****CDM, double ECE[]);
-double Force(double *****H0,
+double Force(char *mode,
+	     double *****H0,
 	     double ******DS_NL, 
 	     double *****OLP,
 	     double *****CDM, 
 	     double *****EDM); 
-double Stress(double *****H0,
+double Stress(char *mode,
+	      double *****H0,
 	      double ******DS_NL,
 	      double *****OLP,
 	      double *****CDM,
@@ -2832,10 +2904,17 @@ void XC_PBE(double dens[2], double GDENS[3][2], double Exc[2],
             double DEXDD[2], double DECDD[2],
             double DEXDGD[3][2], double DECDGD[3][2]);
 void XC_EX(int NSP, double DS0, double DS[2], double EX[1], double VX[2]);
+void XC_PW92_Batch(int n, double *den0, double *den1,
+                   double *exc, double *vxc0, double *vxc1);
+void XC_PBE_Batch(int n, double *den0, double *den1, double *gden[2][3],
+                  double *exc, double *vxc0, double *vxc1, double *dgd[2][3]);
 void Voronoi_Charge();
 void Voronoi_Orbital_Moment();
 
 double Fuzzy_Weight(int ct_AN, int Mc_AN, int Rn, double x, double y, double z);
+void Fuzzy_Weight_Grid(int Mc_AN, double *W);
+void Fuzzy_Weight_Alloc();
+void Fuzzy_Weight_Free();
 
 void neb(int argc, char *argv[]);
 void neb_run(char *argv[], MPI_Comm mpi_commWD, int index_images, double ***neb_atom_coordinates,
@@ -3073,6 +3152,9 @@ double Band_DFT_Dosout( int knum_i, int knum_j, int knum_k,
                         double *****nh,
                         double *****ImNL,
                         double ****CntOLP );
+void Dos_Accum_Init(int n, int Nspin, int knum_i, int knum_j, int knum_k);
+void Dos_Accum_Add(int spin, int kloop, int l, double eig, float *SD);
+void Dos_Accum_Output(double ***EIGEN);
 
 void Unfolding_Bands( int nkpoint, double **kpoint,
 		      int SpinP_switch, 
@@ -3112,6 +3194,9 @@ void Eigen_PReHH(MPI_Comm MPI_Current_Comm_WD,
                  double **ac, double *ko, int n, int EVmax, int bcast_flag);
 void Eigen_PHH(MPI_Comm MPI_Current_Comm_WD, 
                dcomplex **ac, double *ko, int n, int EVmax, int bcast_flag);
+int Eigen_Subspace(MPI_Comm comm, int spin, double **a, double *ko, int n, int MaxN);
+void Eigen_Subspace_Store(MPI_Comm comm, int spin, double **H, int n, int MaxN,
+                          int *is, int *ie);
 void BroadCast_ReMatrix(MPI_Comm MPI_Curret_Comm_WD, 
                         double **Mat, int n, int *is1,int *ie1, int myid, int numprocs,
                         MPI_Status *stat_send,
@@ -3238,6 +3323,50 @@ dcomplex Cexp(dcomplex a);
 
 void PrintMemory_Fix();
 void PrintMemory(char *name, long int size0, char *mode);
+void Arena_Push();
+void *Arena_Alloc(size_t size);
+void Arena_Pop();
+void Arena_Reset();
+void Arena_PrintMemory();
+void Arena_Free();
+void Atom_Schedule_Start(int phase, int *s1, int *s2);
+int Atom_Schedule_Next(int phase);
+void Atom_Schedule_End(int phase, char *name);
+double ****Shm_Malloc_Double4(int n1, int n2, int n3, int n4);
+double ****Shm_Share_Double4(double ****a, int n1, int n2, int n3, int n4);
+void Shm_Free_Double4(double ****a, int n1, int n2, int n3);
+int Shm_Writer(void *table);
+void Shm_Sync();
+void Shm_Bcast_Double(void *table, double *buf, int count, int root);
+void Shm_PrintMemory(char *name, void *table, long int size);
+void NUMA_Policy_Init();
+void NUMA_First_Touch(void *p, long int n, size_t size);
+void Species_Cache_Images();
+FILE *Species_Cache_fopen(char *name);
+void Species_Cache_Free();
+int Species_Cache_File(char *ext, char *fname);
+int Species_Cache_Read(char *fname, void *table, double **rows, int nrows, int len);
+void Species_Cache_Write(char *fname, double **rows, int nrows, int len);
+void Rows_Allgather_Double(double **rows, int num, int n, int *owner);
+void Atom_Allgather_Double(double **a, int i0, int n);
+void Atom_Allgather_Vector(double *a, int n);
+void Atom_Bcast_Double(double **a, int i0, int n, int root);
+dcomplex *Bloch_Sum_Phase(int nk, double *k1, double *k2, double *k3);
+void Bloch_Sum_Col(dcomplex *phase, int *order_GA, int *MP,
+                   double *A1, dcomplex *Ak, int n);
+void Bloch_Sum_BlockCyclic(dcomplex *phase, int *order_GA, int *MP,
+                           double *A1, dcomplex *As, int n,
+                           int nblk, int np_rows, int np_cols,
+                           int my_prow, int my_pcol,
+                           int na_rows, int na_cols);
+unsigned long long Kpath_Restart_Hash(unsigned long long key, void *p, size_t size);
+int Kpath_Restart_Open(char *ext, int nkpt, int n, unsigned long long key,
+                       int nf, char **exts, FILE **fp);
+void Kpath_Restart_Save(char *ext, int nkpt, int n, unsigned long long key,
+                        int kdone, int nf, FILE **fp);
+void Grid_Precision_Set(double NormRD0);
+void Grid_Float_Pack(double *a, int n);
+void Grid_Float_Unpack(double *a, int n);
 void dtime(double *);
  
 /* okuno */
@@ -3894,6 +4023,15 @@ double ESM_buffer_range;
 
  /**  ESM end  **/
 
+/* real-space Poisson solver (Poisson_RS.c) */
+
+/* Poisson_RS_switch: 0 FFT, 1 CG in real space */
+int Poisson_RS_switch;
+/* Poisson_RS_BC[1..3]: 0 periodic, 1 open for the a-, b-, and c-axes */
+int Poisson_RS_BC[4];
+int Poisson_RS_MaxIter;
+double Poisson_RS_Criterion;
+
 int Set_Allocate_Atom2CPU(int MD_iter, int isw, int weight_flag);
 
  /* added by T.Ohwaki */
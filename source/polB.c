@@ -10,6 +10,9 @@
      27/Feb/2006   Modified by Fumiyuki Ishii
      28/July/2006  Modified for MPI by Fumiyuki Ishii
      19/Jan/2007   Modified by Taisuke Ozaki
+     18/Oct/2026   strings over MPI processes and k-points along
+                   a string over OpenMP threads, each k-point
+                   diagonalized once by zheevd
 ***********************************************************************/
 
 #include <stdio.h>
@@ -23,6 +26,7 @@
 #include "lapack_prototypes.h"
 #include "f77func.h"
 #include "mpi.h"
+#include <omp.h>
 
 #define Host_ID       0         /* ID of the host CPU in MPI */
 
@@ -47,8 +51,12 @@ static void Overlap_k1k2(
 			 dcomplex ***Sop, dcomplex ***Wk1, dcomplex ***Wk2,
 			 double **EigenVal1, double **EigenVal2);
 
-static void Eigen_HH(dcomplex **ac, double *ko, int n, int EVmax);
-static void lapack_dstevx2(INTEGER N, double *D, double *E, double *W, dcomplex **ev);
+static void Eigen_Bloch(double kp[4], int spinsize,
+                        int fsize, int fsize2, int fsize3, int *MP,
+                        dcomplex ***Wk, double **EigenVal);
+static void Eigen_zheevd(dcomplex **ac, double *ko, int n);
+static dcomplex ***Allocate_Wk(int spinsize, int fsize3);
+static void Free_Wk(dcomplex ***Wk, int spinsize, int fsize3);
 static void Overlap_Band(double ****OLP,
                          dcomplex **S,int *MP,
                          double k1, double k2, double k3);
@@ -75,14 +83,13 @@ double Dot_Product(double a[4], double b[4]);
 int main(int argc, char *argv[]) 
 {
   int fsize,fsize2,fsize3,fsize4;
-  int spin,spinsize,diag_flag;
-  int i,j,k,hos,po,wan,hog2,valnonmag;
-  int n1,n2,n3,i1,i2,i3;
+  int spin,spinsize;
+  int i,j,k,po,wan,valnonmag;
+  int n1,n2,n3,i2,i3;
   int Nk[4],kloop[4][4];
   int pflag[4];
   int hog[1];
   int metal;
-  double k1[4],k2[4];
   double pol_abc[4];
   double Edpx,Edpy,Edpz;
   double Cdpx,Cdpy,Cdpz,Cdpi[4];
@@ -110,28 +117,20 @@ int main(int argc, char *argv[])
   int ct_AN,h_AN;
   char *s_vec[20];
   int *MP;  
-  double **EigenVal1;
-  double **EigenVal2;
-  double **EigenVal3;
-  dcomplex ***Sop;
-  dcomplex ***Wk1;
-  dcomplex ***Wk2;
-  dcomplex ***Wk3;
+  dcomplex ****Wfirst;
+  double ***EVfirst;
+  double *mul_thrds;
+  int Nthrds0,Nthrds1;
   MPI_Comm comm1;
   int numprocs,myid,ID,ID1;
   double TStime,TEtime;
 
-  dcomplex *work1;   /* for determinant */
-  dcomplex *work2;   /* for determinant */
-  dcomplex Cdet[2];  /* for determinant */
-  INTEGER *ipiv;     /* for determinant */
   /* for MPI*/
-  int *arpo;
   int AB_knum,S_knum,E_knum,num_ABloop0;
   int ik1,ik2,ik3,ABloop,ABloop0,abcount;
   double tmp4;
   double *psiAB;
-  int *AB_Nk2, *AB_Nk3, *ABmesh2ID;
+  int *AB_Nk2, *AB_Nk3;
 
   /* MPI initialize */
 
@@ -192,7 +191,6 @@ int main(int argc, char *argv[])
      in the full matrix */
 
   MP = (int*)malloc(sizeof(int)*(atomnum+1)); 
-  arpo = (int*)malloc(sizeof(int)*numprocs);
 
   fsize = 1;
   for (i=1; i<=atomnum; i++){
@@ -218,87 +216,8 @@ int main(int argc, char *argv[])
      else if (SpinP_switch==3){ spinsize=1; fsize2=Valence_Electrons;fsize3=2*fsize+2;}*/
 
 
-  /* Sop:
-     overlap matrix between one-particle wave functions
-     calculated at two k-points, k1 and k2 */
-
-  Sop = (dcomplex***)malloc(sizeof(dcomplex**)*spinsize); 
-  for (spin=0; spin<spinsize; spin++){
-    Sop[spin] = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3); 
-    for (i=0; i<fsize3; i++){
-      Sop[spin][i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3); 
-      for (j=0; j<fsize3; j++){ Sop[spin][i][j].r=0.0; Sop[spin][i][j].i=0.0;}
-    } 
-  }
-
-  /* Wk1:
-     wave functions at k1 */
-
-  Wk1 = (dcomplex***)malloc(sizeof(dcomplex**)*spinsize); 
-  for (spin=0; spin<spinsize; spin++){
-    Wk1[spin] = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3); 
-    for (i=0; i<fsize3; i++){
-      Wk1[spin][i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3); 
-      for (j=0; j<fsize3; j++){ Wk1[spin][i][j].r=0.0; Wk1[spin][i][j].i=0.0;}
-    } 
-  }
-
-  /* Wk2:
-     wave functions at k2 */
-
-  Wk2 = (dcomplex***)malloc(sizeof(dcomplex**)*spinsize); 
-  for (spin=0; spin<spinsize; spin++){
-    Wk2[spin] = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3); 
-    for (i=0; i<fsize3; i++){
-      Wk2[spin][i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3); 
-      for (j=0; j<fsize3; j++){ Wk2[spin][i][j].r=0.0; Wk2[spin][i][j].i=0.0;}
-    } 
-  }
-
-  /* Wk3:
-     wave functions for temporal storing */
-
-  Wk3 = (dcomplex***)malloc(sizeof(dcomplex**)*spinsize); 
-  for (spin=0; spin<spinsize; spin++){
-    Wk3[spin] = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3); 
-    for (i=0; i<fsize3; i++){
-      Wk3[spin][i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3); 
-      for (j=0; j<fsize3; j++){ Wk3[spin][i][j].r=0.0; Wk3[spin][i][j].i=0.0;}
-    } 
-  }
-
-  /* EigenVal1:
-     eigenvalues at k1 */
-
-  EigenVal1 = (double**)malloc(sizeof(double*)*spinsize);
-  for (spin=0; spin<spinsize; spin++){
-    EigenVal1[spin] = (double*)malloc(sizeof(double)*fsize3);
-    for (j=0; j<fsize3; j++) EigenVal1[spin][j] = 0.0;
-  }
-
-  /* EigenVal2:
-     eigenvalues at k2 */
-
-  EigenVal2 = (double**)malloc(sizeof(double*)*spinsize);
-  for (spin=0; spin<spinsize; spin++){
-    EigenVal2[spin] = (double*)malloc(sizeof(double)*fsize3);
-    for (j=0; j<fsize3; j++) EigenVal2[spin][j] = 0.0;
-  }
-
-  /* EigenVal3:
-     eigenvalues for temporal storing */
-
-  EigenVal3 = (double**)malloc(sizeof(double*)*spinsize);
-  for (spin=0; spin<spinsize; spin++){
-    EigenVal3[spin] = (double*)malloc(sizeof(double)*fsize3);
-    for (j=0; j<fsize3; j++) EigenVal3[spin][j] = 0.0;
-  }
-
-  /* for determinatn */
-
-  ipiv = (INTEGER*)malloc(sizeof(INTEGER)*fsize3);
-  work1 = (dcomplex*)malloc(sizeof(dcomplex)*fsize3*fsize3);
-  work2 = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
+  /* Sop, the wave functions, and the eigenvalues are
+     allocated by each thread in the loop for strings */
 
   /******************************************
               the standard output
@@ -448,7 +367,6 @@ int main(int argc, char *argv[])
 
       AB_Nk2= (int*)malloc(sizeof(int)*AB_knum);
       AB_Nk3= (int*)malloc(sizeof(int)*AB_knum);
-      ABmesh2ID= (int*)malloc(sizeof(int)*AB_knum);
       psiAB = (double*)malloc(sizeof(double)*AB_knum);
 
       AB_knum = 0;
@@ -495,42 +413,94 @@ int main(int argc, char *argv[])
              start ABloop for Berry phase 
       ****************************************************/
 
-      for (ABloop0=0; ABloop0<num_ABloop0; ABloop0++){
+      /* the threads share the k-points along a string */
+
+      Nthrds0 = omp_get_max_threads();
+      if (Nk[n1]<Nthrds0) Nthrds0 = Nk[n1];
+
+      Wfirst = (dcomplex****)malloc(sizeof(dcomplex***)*Nthrds0);
+      EVfirst = (double***)malloc(sizeof(double**)*Nthrds0);
+      mul_thrds = (double*)malloc(sizeof(double)*Nthrds0*4);
+
+      for (ABloop=S_knum; 0<=ABloop && ABloop<=E_knum; ABloop++){
 
         if (myid==Host_ID){
-   	  printf("  calculating the polarization along the %s .... %3d/%3d\n",
-                 s_vec[k],ABloop0+1,num_ABloop0);fflush(stdout);
+   	  printf("  direction %d, string %4d/%4d\n",
+                 k,ABloop-S_knum+1,E_knum-S_knum+1);fflush(stdout);
 	}
 
-	ABloop = ABloop0 + S_knum;
+	i2=AB_Nk2[ABloop];
+	i3=AB_Nk3[ABloop];
 
-	arpo[myid] = -1;
-	if (S_knum<=ABloop && ABloop<=E_knum) arpo[myid] = ABloop;
-	for (ID=0; ID<numprocs; ID++){
-	  MPI_Bcast(&arpo[ID], 1, MPI_INT, ID, comm1);
-	}
+	/****************************************************
+          The links i1 to i1+1 of the string are divided
+          into contiguous parts of the threads. The first
+          k-point of each part is diagonalized by its thread,
+          and is also used by the previous thread for its
+          last link, so that each k-point is diagonalized
+          exactly once. The last link of the string uses
+          the first k-point shifted by a reciprocal vector.
+	****************************************************/
 
-	ABloop = arpo[myid];
+#pragma omp parallel num_threads(Nthrds0) shared(Nk,n1,n2,n3,i2,i3,kg,spinsize,fsize,fsize2,fsize3,fsize4,MP,Wfirst,EVfirst,mul_thrds,Nthrds1,SpinP_switch,Valence_Electrons,ChemP) reduction(|:metal)
+	{
+	  int OMPID,Nthrds,is,ie,i1,spin,i,po,hos,hog2;
+	  double k1[4],k2[4],tmpr,tmpi;
+	  double mulr[2],muli[2];
+	  double **EVA,**EVB,**EVcur,**EVnext;
+	  dcomplex ***WkA,***WkB,***Wcur,***Wnext,***Sop;
+	  dcomplex *work1,*work2,Cdet[2];
+	  INTEGER *ipiv;
 
-	for (ID=0; ID<numprocs; ID++){
-	  ABmesh2ID[ABloop] = ID;
-	  MPI_Bcast(ABmesh2ID, AB_knum, MPI_INT, ID, comm1);
-	}
+	  OMPID = omp_get_thread_num();
+	  Nthrds = omp_get_num_threads();
+
+	  /* the team may be smaller than Nthrds0 */
 
-	if (0<=ABloop){
+	  if (OMPID==0) Nthrds1 = Nthrds;
 
-	  /* for (i2=0; i2<Nk[n2]; i2++){ */
-	  /* for (i3=0; i3<Nk[n3]; i3++){ */
+	  is = OMPID*Nk[n1]/Nthrds;
+	  ie = (OMPID+1)*Nk[n1]/Nthrds;
 
-	  i2=AB_Nk2[ABloop];
-	  i3=AB_Nk3[ABloop];
+	  /* allocation of arrays */
+
+	  Sop = Allocate_Wk(spinsize,fsize3);
+	  WkA = Allocate_Wk(spinsize,fsize3);
+	  WkB = Allocate_Wk(spinsize,fsize3);
+	  Wfirst[OMPID] = Allocate_Wk(spinsize,fsize3);
+
+	  EVA = (double**)malloc(sizeof(double*)*spinsize);
+	  EVB = (double**)malloc(sizeof(double*)*spinsize);
+	  EVfirst[OMPID] = (double**)malloc(sizeof(double*)*spinsize);
+	  for (spin=0; spin<spinsize; spin++){
+	    EVA[spin] = (double*)malloc(sizeof(double)*fsize3);
+	    EVB[spin] = (double*)malloc(sizeof(double)*fsize3);
+	    EVfirst[OMPID][spin] = (double*)malloc(sizeof(double)*fsize3);
+	  }
+
+	  ipiv = (INTEGER*)malloc(sizeof(INTEGER)*fsize3);
+	  work1 = (dcomplex*)malloc(sizeof(dcomplex)*fsize3*fsize3);
+	  work2 = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
+
+	  /* the first k-point of the thread */
+
+	  k1[n1] = kg[n1][is];
+	  k1[n2] = kg[n2][i2]; 
+	  k1[n3] = kg[n3][i3];
+
+	  Eigen_Bloch(k1, spinsize, fsize, fsize2, fsize3, MP, Wfirst[OMPID], EVfirst[OMPID]);
+
+#pragma omp barrier
 
 	  for (spin=0; spin<spinsize; spin++){
 	    mulr[spin] = 1.0;
 	    muli[spin] = 0.0;
 	  }
 
-	  for (i1=0; i1<Nk[n1]; i1++){
+	  Wcur = Wfirst[OMPID];
+	  EVcur = EVfirst[OMPID];
+
+	  for (i1=is; i1<ie; i1++){
 
 	    k1[n1] = kg[n1][i1];
 	    k1[n2] = kg[n2][i2]; 
@@ -540,52 +510,22 @@ int main(int argc, char *argv[])
 	    k2[n2] = kg[n2][i2]; 
 	    k2[n3] = kg[n3][i3];
 
-	    /*if (myid==Host_ID){
-	      printf("\n k1:%10.6f %10.6f %10.6f\n",k1[n1],k1[n2],k1[n3]);
-	      printf(" k2:%10.6f %10.6f %10.6f\n",k2[n1],k2[n2],k2[n3]); 
-	      } */
+	    /* the wave functions at k2 */
 
-	    if      (i1==0)           diag_flag = 0;
-	    else if (i1==(Nk[n1]-1))  diag_flag = 3;
-	    else                      diag_flag = 2;
-
-	    /* calculate the overlap matrix */
-
-	    if (i1%2==0){
-
-	      if (i1!=(Nk[n1]-1)){
-		Overlap_k1k2( diag_flag, k1, k2, spinsize, fsize, fsize2, fsize3, fsize4,
-			      MP, Sop, Wk1, Wk2, EigenVal1, EigenVal2 );
-	      }
-	      else{
-		Overlap_k1k2( diag_flag, k1, k2, spinsize, fsize, fsize2, fsize3, fsize4,
-			      MP, Sop, Wk1, Wk3, EigenVal1, EigenVal3 );
-	      }
+	    if (i1==(ie-1)){
+	      Wnext = Wfirst[(OMPID+1)%Nthrds];
+	      EVnext = EVfirst[(OMPID+1)%Nthrds];
 	    }
 	    else{
-
-	      if (i1!=(Nk[n1]-1)){
-		Overlap_k1k2( diag_flag, k1, k2, spinsize, fsize, fsize2, fsize3, fsize4,
-			      MP, Sop, Wk2, Wk1, EigenVal2, EigenVal1 );
-	      }
-	      else{
-		Overlap_k1k2( diag_flag, k1, k2, spinsize, fsize, fsize2, fsize3, fsize4,
-			      MP, Sop, Wk2, Wk3, EigenVal2, EigenVal3 );
-	      }
+	      if (Wcur==WkA){ Wnext = WkB; EVnext = EVB; }
+	      else          { Wnext = WkA; EVnext = EVA; }
+	      Eigen_Bloch(k2, spinsize, fsize, fsize2, fsize3, MP, Wnext, EVnext);
 	    }
 
-	    /* store Wk1 and EigenVal1 at i1==0 */  
+	    /* calculate the overlap matrix */
 
-	    if (i1==0){
-	      for (spin=0; spin<spinsize; spin++){
-		for (i=0; i<fsize3; i++){
-		  for (j=0; j<fsize3; j++){
-		    Wk3[spin][i][j] = Wk1[spin][i][j];
-		  }
-		  EigenVal3[spin][i] = EigenVal1[spin][i]; 
-		} 
-	      }
-	    }
+	    Overlap_k1k2( 3, k1, k2, spinsize, fsize, fsize2, fsize3, fsize4,
+			  MP, Sop, Wcur, Wnext, EVcur, EVnext );
 
 	    for (spin=0; spin<spinsize; spin++){
 
@@ -594,7 +534,7 @@ int main(int argc, char *argv[])
 	      po = 0;
 	      i = 1;
 	      do {
-		if (ChemP<EigenVal1[spin][i]){
+		if (ChemP<EVcur[spin][i]){
 		  po = 1;
 		  hos = i - 1;
 		}
@@ -610,7 +550,6 @@ int main(int argc, char *argv[])
 	      if (SpinP_switch==1){ hog2=hos;}
 
 	      if(hog2!=hos){metal=1;}
-	      if(metal==1){printf("Metallic !! \n");}
 
 	      determinant( spin, hog2, Sop[spin], ipiv, work1, work2, Cdet );
 
@@ -623,52 +562,95 @@ int main(int argc, char *argv[])
 	      muli[spin] = tmpi; 
 
 	    } /* spin */
+
+	    Wcur = Wnext;
+	    EVcur = EVnext;
+
 	  }   /* i1   */            
 
 	  for (spin=0; spin<spinsize; spin++){
+	    mul_thrds[4*OMPID+2*spin  ] = mulr[spin];
+	    mul_thrds[4*OMPID+2*spin+1] = muli[spin];
+	  }
+
+	  /* Wfirst is used by the other threads until here */
+
+#pragma omp barrier
+
+	  Free_Wk(Sop,spinsize,fsize3);
+	  Free_Wk(WkA,spinsize,fsize3);
+	  Free_Wk(WkB,spinsize,fsize3);
+	  Free_Wk(Wfirst[OMPID],spinsize,fsize3);
+
+	  for (spin=0; spin<spinsize; spin++){
+	    free(EVA[spin]);
+	    free(EVB[spin]);
+	    free(EVfirst[OMPID][spin]);
+	  }
+	  free(EVA);
+	  free(EVB);
+	  free(EVfirst[OMPID]);
+
+	  free(ipiv);
+	  free(work1);
+	  free(work2);
+
+	} /* #pragma omp parallel */
+
+	if (metal==1 && myid==Host_ID){printf("Metallic !! \n");}
+
+	/* the product over the threads */
+
+	for (spin=0; spin<spinsize; spin++){
+
+	  mulr[spin] = 1.0;
+	  muli[spin] = 0.0;
+
+	  for (i=0; i<Nthrds1; i++){
+	    tmpr = mulr[spin]*mul_thrds[4*i+2*spin] - muli[spin]*mul_thrds[4*i+2*spin+1];
+	    tmpi = mulr[spin]*mul_thrds[4*i+2*spin+1] + muli[spin]*mul_thrds[4*i+2*spin];
+	    mulr[spin] = tmpr;
+	    muli[spin] = tmpi;
+	  }
+	}
+
+	for (spin=0; spin<spinsize; spin++){
         
-	    /****************************************
+	  /****************************************
             calculate Im[log(mul)]
 
             note: acos(-1 to 1) gives PI to 0   
-	    ****************************************/
+	  ****************************************/
 
-	    norm = sqrt( mulr[spin]*mulr[spin] + muli[spin]*muli[spin] );
-	    detr = mulr[spin]/norm;
+	  norm = sqrt( mulr[spin]*mulr[spin] + muli[spin]*muli[spin] );
+	  detr = mulr[spin]/norm;
 
-	    /* the first and second quadrants */
+	  /* the first and second quadrants */
 
-	    if (0.0<=muli[spin]){
-	      psi = acos(detr); 
-	    }
-
-	    /* the third and fourth quadrants */
+	  if (0.0<=muli[spin]){
+	    psi = acos(detr); 
+	  }
 
-	    else {
-	      psi = -acos(detr);
-	    }
+	  /* the third and fourth quadrants */
 
-	    /* add psi */
+	  else {
+	    psi = -acos(detr);
+	  }
 
-	    /* MPI psi from node */
+	  /* add psi */
 
-	    psiAB[ABloop] += psi;
+	  psiAB[ABloop] += psi;
          
-	  } /* spin */
-	} /* if(0=<ABloop) */
+	} /* spin */
       } /* end of ABloop */
 
-      MPI_Barrier(comm1); 
-      ABloop = 0;
-      for (ik2=0; ik2<Nk[n2]; ik2++){
-	for (ik3=0; ik3<Nk[n3]; ik3++){
-	  ID1 = ABmesh2ID[ABloop];
-	  MPI_Bcast(&psiAB[ABloop], 1, MPI_DOUBLE, ID1, comm1);
-	  ABloop++;
-	}
-      }
+      free(mul_thrds);
+      free(EVfirst);
+      free(Wfirst);
+
+      /* psi of the strings calculated by the processes */
 
-      MPI_Barrier(comm1); 
+      MPI_Allreduce(MPI_IN_PLACE, psiAB, AB_knum, MPI_DOUBLE, MPI_SUM, comm1);
 
       AB_knum = 0;
       for (ik2=0; ik2<Nk[n2]; ik2++){
@@ -678,6 +660,10 @@ int main(int argc, char *argv[])
 	}
       } 
 
+      free(AB_Nk2);
+      free(AB_Nk3);
+      free(psiAB);
+
       /* collinear spin-unpolarized */
 
       if (SpinP_switch==0) {
@@ -874,57 +860,6 @@ int main(int argc, char *argv[])
 
   free(MP);
 
-  for (spin=0; spin<spinsize; spin++){
-    for (i=0; i<fsize3; i++){
-      free(Sop[spin][i]);
-    } 
-    free(Sop[spin]);
-  }
-  free(Sop);
-
-  for (spin=0; spin<spinsize; spin++){
-    for (i=0; i<fsize3; i++){
-      free(Wk1[spin][i]);
-    } 
-    free(Wk1[spin]);
-  }
-  free(Wk1);
-
-  for (spin=0; spin<spinsize; spin++){
-    for (i=0; i<fsize3; i++){
-      free(Wk2[spin][i]);
-    } 
-    free(Wk2[spin]);
-  }
-  free(Wk2);
-
-  for (spin=0; spin<spinsize; spin++){
-    for (i=0; i<fsize3; i++){
-      free(Wk3[spin][i]);
-    } 
-    free(Wk3[spin]);
-  }
-  free(Wk3);
-
-  for (spin=0; spin<spinsize; spin++){
-    free(EigenVal1[spin]);
-  }
-  free(EigenVal1);
-
-  for (spin=0; spin<spinsize; spin++){
-    free(EigenVal2[spin]);
-  }
-  free(EigenVal2);
-
-  for (spin=0; spin<spinsize; spin++){
-    free(EigenVal3[spin]);
-  }
-  free(EigenVal3);
-
-  free(ipiv);
-  free(work1);
-  free(work2);
-
   for (i=0; i<=3; i++){
     free(kg[i]);
   }
@@ -1075,14 +1010,11 @@ void Overlap_k1k2(int diag_flag,
   **********************************************************************/
 
   int spin;
-  int ik,i1,j1,i,j,l,k;
+  int i1,j1;
   int ct_AN,h_AN,mu1,mu2;
   int Anum,Bnum,tnoA,tnoB;
-  int mn,jj1,ii1,m;
   int Rnh,Gh_AN,l1,l2,l3;
   int recalc[2];
-  double kpoints[2][4];
-  double *ko,*M1;
   double sumr,sumi;
   double tmp1r,tmp1i;
   double tmp2r,tmp2i;
@@ -1095,44 +1027,6 @@ void Overlap_k1k2(int diag_flag,
   double dkx,dky,dkz;
   double dka,dkb,dkc;
   double k1x,k1y,k1z;
-  dcomplex **S,**H,**C;  
-  double OLP_eigen_cut = 1.0e-12;
-  dcomplex Ctmp1,Ctmp2;  
-
-  /****************************************************
-                 allocation of arrays:
-  ****************************************************/
-
-  ko = (double*)malloc(sizeof(double)*fsize3);
-  M1 = (double*)malloc(sizeof(double)*fsize3);
-
-  S = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
-  for (i=0; i<fsize3; i++){
-    S[i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
-    for (j=0; j<fsize3; j++){ S[i][j].r = 0.0; S[i][j].i = 0.0; }
-  }
-
-  H = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
-  for (i=0; i<fsize3; i++){
-    H[i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
-    for (j=0; j<fsize3; j++){ H[i][j].r = 0.0; H[i][j].i = 0.0; }
-  }
-
-  C = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
-  for (i=0; i<fsize3; i++){
-    C[i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
-    for (j=0; j<fsize3; j++){ C[i][j].r = 0.0; C[i][j].i = 0.0; }
-  }
-
-  /* set kpoints */
-
-  kpoints[0][1] = k1[1];
-  kpoints[0][2] = k1[2];
-  kpoints[0][3] = k1[3];
-
-  kpoints[1][1] = k2[1];
-  kpoints[1][2] = k2[2];
-  kpoints[1][3] = k2[3];
 
   k1x = k1[1]*rtv[1][1] + k1[2]*rtv[2][1] + k1[3]*rtv[3][1];
   k1y = k1[1]*rtv[1][2] + k1[2]*rtv[2][2] + k1[3]*rtv[3][2];
@@ -1154,303 +1048,9 @@ void Overlap_k1k2(int diag_flag,
   /****************************************************
      diagonalize Bloch matrix at k-points, k1 and k2
   ****************************************************/
-  
-  for (ik=0; ik<2; ik++){
-
-    if (recalc[ik]){     
-
-      Overlap_Band(OLP,S,MP,kpoints[ik][1],kpoints[ik][2],kpoints[ik][3]);
-
-      Eigen_HH(S,ko,fsize,fsize);
-
-      for (l=1; l<=fsize; l++){
-	if (ko[l]<OLP_eigen_cut){
-	  printf("found an overcomplete basis set\n");
-          MPI_Finalize();
-	  exit(0); 
-	}
-      } 
-
-      for (l=1; l<=fsize; l++) M1[l] = 1.0/sqrt(ko[l]);
-
-      /*
-	for (i1=1; i1<=fsize; i1++){
-	printf("ik=%2d i1=%3d ko[i1]=%15.12f\n",ik,i1,ko[i1]);
-	}
-      */
-
-      /* S * M1  */
-
-      for (i1=1; i1<=fsize; i1++){
-	for (j1=1; j1<=fsize; j1++){
-	  S[i1][j1].r = S[i1][j1].r*M1[j1];
-	  S[i1][j1].i = S[i1][j1].i*M1[j1];
-	} 
-      } 
-
-      for (spin=0; spin<spinsize; spin++){
-
-	/* transpose S */
-
-	for (i1=1; i1<=fsize; i1++){
-	  for (j1=i1+1; j1<=fsize; j1++){
-	    Ctmp1 = S[i1][j1];
-	    Ctmp2 = S[j1][i1];
-	    S[i1][j1] = Ctmp2;
-	    S[j1][i1] = Ctmp1;
-	  }
-	}
-
-	/****************************************************
-                          collinear case
-	****************************************************/
-
-	if (SpinP_switch==0 || SpinP_switch==1){
-
-	  Hamiltonian_Band(Hks[spin],H,MP,kpoints[ik][1],kpoints[ik][2],kpoints[ik][3]);
-
-	  /****************************************************
-                        M1 * U^t * H * U * M1
-	  ****************************************************/
-
-	  /* H * U * M1 */
-
-	  for (j1=1; j1<=fsize; j1++){
-	    for (i1=1; i1<=fsize; i1++){
-
-	      sumr = 0.0;
-	      sumi = 0.0;
-
-	      for (l=1; l<=fsize; l++){
-		sumr += H[i1][l].r*S[j1][l].r - H[i1][l].i*S[j1][l].i;
-		sumi += H[i1][l].r*S[j1][l].i + H[i1][l].i*S[j1][l].r;
-	      }
-
-	      C[j1][i1].r = sumr;
-	      C[j1][i1].i = sumi;
-	    }
-	  }     
-
-	  /* M1 * U^+ H * U * M1 */
-
-	  for (i1=1; i1<=fsize; i1++){
-	    for (j1=1; j1<=fsize; j1++){
-	      sumr = 0.0;
-	      sumi = 0.0;
-	      for (l=1; l<=fsize; l++){
-		sumr +=  S[i1][l].r*C[j1][l].r + S[i1][l].i*C[j1][l].i;
-		sumi +=  S[i1][l].r*C[j1][l].i - S[i1][l].i*C[j1][l].r;
-	      }
-	      H[i1][j1].r = sumr;
-	      H[i1][j1].i = sumi;
-	    }
-	  } 
-
-	  /* H to C */
-
-	  for (i1=1; i1<=fsize; i1++){
-	    for (j1=1; j1<=fsize; j1++){
-	      C[i1][j1] = H[i1][j1];
-	    }
-	  }
-
-	  /* solve eigenvalue problem */
-
-	  if (ik==0){
-	    Eigen_HH(C,EigenVal1[spin],fsize,fsize);
-
-	    /*
-	      for (i1=1; i1<=fsize; i1++){
-	      printf("ik=%2d i1=%3d spin=%2d EigenVal2[spin]=%15.12f\n", 
-	      ik,i1,spin,EigenVal1[spin][i1]);
-	      }
-	    */
-
-
-	  }
-	  else if (ik==1){
-	    Eigen_HH(C,EigenVal2[spin],fsize,fsize);
-
-	    /*
-	      for (i1=1; i1<=fsize; i1++){
-	      printf("ik=%2d i1=%3d spin=%2d EigenVal2[spin]=%15.12f\n",
-	      ik,i1,spin,EigenVal2[spin][i1]);
-	      }
-	    */
-	  }
-
-	  /****************************************************
-	     transformation to the original eigenvectors.
-	     NOTE JRCAT-244p and JAIST-2122p 
-	  ****************************************************/
-
-	  /* transpose */
-	  for (i1=1; i1<=fsize; i1++){
-	    for (j1=i1+1; j1<=fsize; j1++){
-	      Ctmp1 = S[i1][j1];
-	      Ctmp2 = S[j1][i1];
-	      S[i1][j1] = Ctmp2;
-	      S[j1][i1] = Ctmp1;
-	    }
-	  }
-
-	  /* transpose */
-	  for (i1=1; i1<=fsize; i1++){
-	    for (j1=i1+1; j1<=fsize; j1++){
-	      Ctmp1 = C[i1][j1];
-	      Ctmp2 = C[j1][i1];
-	      C[i1][j1] = Ctmp2;
-	      C[j1][i1] = Ctmp1;
-	    }
-	  }
-
-          /* calculate wave functions */
-
-	  for (i1=1; i1<=fsize; i1++){
-	    for (j1=1; j1<=fsize; j1++){
-	      sumr = 0.0;
-	      sumi = 0.0;
-	      for (l=1; l<=fsize; l++){
-		sumr +=  S[i1][l].r*C[j1][l].r - S[i1][l].i*C[j1][l].i;
-		sumi +=  S[i1][l].r*C[j1][l].i + S[i1][l].i*C[j1][l].r;
-	      }
-
-	      if (ik==0){
-		Wk1[spin][j1][i1].r = sumr;
-		Wk1[spin][j1][i1].i = sumi;
-	      }
-	      else if (ik==1){
-		Wk2[spin][j1][i1].r = sumr;
-		Wk2[spin][j1][i1].i = sumi;
-	      }
-	    }
-	  }
-	}
-
-	/****************************************************
-                        non-collinear case
-	****************************************************/
- 
-	else if (SpinP_switch==3){
-
-          Hamiltonian_Band_NC(Hks,iHks,H,MP,kpoints[ik][1],kpoints[ik][2],kpoints[ik][3]);
-
-	  /* H * U * M1 */
-
-	  for (j1=1; j1<=fsize; j1++){
-	    for (i1=1; i1<=fsize2; i1++){
-	      for (m=0; m<=1; m++){
-
-		sumr = 0.0;
-		sumi = 0.0;
-		mn = m*fsize;
-		for (l=1; l<=fsize; l++){
-		  sumr += H[i1][l+mn].r*S[j1][l].r - H[i1][l+mn].i*S[j1][l].i;
-		  sumi += H[i1][l+mn].r*S[j1][l].i + H[i1][l+mn].i*S[j1][l].r;
-		}
 
-		jj1 = 2*j1 - 1 + m;
-
-		C[jj1][i1].r = sumr;
-		C[jj1][i1].i = sumi;
-	      }
-	    }
-	  }     
-
-	  /* M1 * U^+ H * U * M1 */
-
-	  for (i1=1; i1<=fsize; i1++){
-
-	    for (m=0; m<=1; m++){
-
-	      ii1 = 2*i1 - 1 + m;
-
-	      for (j1=1; j1<=fsize2; j1++){
-		sumr = 0.0;
-		sumi = 0.0;
-		mn = m*fsize;
-		for (l=1; l<=fsize; l++){
-		  sumr +=  S[i1][l].r*C[j1][l+mn].r + S[i1][l].i*C[j1][l+mn].i;
-		  sumi +=  S[i1][l].r*C[j1][l+mn].i - S[i1][l].i*C[j1][l+mn].r;
-		}
-		H[ii1][j1].r = sumr;
-		H[ii1][j1].i = sumi;
-	      }
-	    }
-	  }
-
-          /* solve eigenvalue problem */
-
-	  if (ik==0){
-            Eigen_HH(H,EigenVal1[0],fsize2,fsize2);
-
-
-	    /*
-	      for (i1=1; i1<=fsize2; i1++){
-	      printf("ik=%2d i1=%3d spin=%2d EigenVal2[0]=%15.12f\n", 
-	      ik,i1,spin,EigenVal1[0][i1]);
-	      }
-	    */
-
-
-	  }
-	  else if (ik==1){
-            Eigen_HH(H,EigenVal2[0],fsize2,fsize2);
-	  }
-
-          /****************************************************
-             transformation to the original eigenvectors
-                    NOTE JRCAT-244p and JAIST-2122p 
-                       C = U * lambda^{-1/2} * D
-          ****************************************************/
-
-          /* transpose */
-
-          for (i1=1; i1<=fsize; i1++){
-   	    for (j1=i1+1; j1<=fsize; j1++){
-	      Ctmp1 = S[i1][j1];
-	      Ctmp2 = S[j1][i1];
-	      S[i1][j1] = Ctmp2;
-	      S[j1][i1] = Ctmp1;
-	    }
-          }
-
-	  for (i1=1; i1<=fsize2; i1++){
-	    for (j1=1; j1<=fsize2; j1++){
-	      C[i1][j1].r = 0.0;
-	      C[i1][j1].i = 0.0;
-	    }
-	  }
-
-	  for (m=0; m<=1; m++){
-	    for (i1=1; i1<=fsize; i1++){
-	      for (j1=1; j1<=fsize2; j1++){
-
-		sumr = 0.0; 
-		sumi = 0.0;
-
-		for (l=1; l<=fsize; l++){
-		  sumr +=  S[i1][l].r*H[2*l-1+m][j1].r - S[i1][l].i*H[2*l-1+m][j1].i;
-		  sumi +=  S[i1][l].r*H[2*l-1+m][j1].i + S[i1][l].i*H[2*l-1+m][j1].r;
-		} 
-
-                if (ik==0){
-		  Wk1[0][j1][i1+m*fsize].r = sumr;
-		  Wk1[0][j1][i1+m*fsize].i = sumi;
-		}
-                else if (ik==1){
-		  Wk2[0][j1][i1+m*fsize].r = sumr;
-		  Wk2[0][j1][i1+m*fsize].i = sumi;
-		}
-	      }
-	    }
-	  }
-
-	}
-
-      } /* spin */
-    } /* if (recalc[ik]) */
-  } /* ik */
+  if (recalc[0]) Eigen_Bloch(k1,spinsize,fsize,fsize2,fsize3,MP,Wk1,EigenVal1);
+  if (recalc[1]) Eigen_Bloch(k2,spinsize,fsize,fsize2,fsize3,MP,Wk2,EigenVal2);
 
   /****************************************************
   calculate an overlap matrix between one-particle
@@ -1647,23 +1247,6 @@ void Overlap_k1k2(int diag_flag,
                  allocation of arrays:
   ****************************************************/
 
-  free(ko);
-  free(M1);
-
-  for (i=0; i<fsize3; i++){
-    free(S[i]);
-  }
-  free(S);
-
-  for (i=0; i<fsize3; i++){
-    free(H[i]);
-  }
-  free(H);
-
-  for (i=0; i<fsize3; i++){
-    free(C[i]);
-  }
-  free(C);
 
 }
 
@@ -1680,10 +1263,10 @@ void Overlap_Band(double ****OLP,
                   dcomplex **S,int *MP,
                   double k1, double k2, double k3)
 {
-  static int i,j,wanA,wanB,tnoA,tnoB,Anum,Bnum,NUM,GA_AN,LB_AN,GB_AN;
-  static int l1,l2,l3,Rn,n2;
-  static double **S1,**S2;
-  static double kRn,si,co,s;
+  int i,j,wanA,wanB,tnoA,tnoB,Anum,Bnum,NUM,GA_AN,LB_AN,GB_AN;
+  int l1,l2,l3,Rn,n2;
+  double **S1,**S2;
+  double kRn,si,co,s;
 
   Anum = 1;
   for (i=1; i<=atomnum; i++){
@@ -1775,10 +1358,10 @@ void Overlap_Band(double ****OLP,
 void Hamiltonian_Band(double ****RH, dcomplex **H, int *MP,
                       double k1, double k2, double k3)
 {
-  static int i,j,wanA,wanB,tnoA,tnoB,Anum,Bnum,NUM,GA_AN,LB_AN,GB_AN;
-  static int l1,l2,l3,Rn,n2;
-  static double **H1,**H2;
-  static double kRn,si,co,h;
+  int i,j,wanA,wanB,tnoA,tnoB,Anum,Bnum,NUM,GA_AN,LB_AN,GB_AN;
+  int l1,l2,l3,Rn,n2;
+  double **H1,**H2;
+  double kRn,si,co,h;
 
   Anum = 1;
   for (i=1; i<=atomnum; i++){
@@ -1881,13 +1464,13 @@ void Hamiltonian_Band_NC(double *****RH, double *****IH,
                          dcomplex **H, int *MP,
                          double k1, double k2, double k3)
 {
-  static int i,j,k,wanA,wanB,tnoA,tnoB,Anum,Bnum;
-  static int NUM,GA_AN,LB_AN,GB_AN;
-  static int l1,l2,l3,Rn,n2;
-  static double **H11r,**H11i;
-  static double **H22r,**H22i;
-  static double **H12r,**H12i;
-  static double kRn,si,co,h;
+  int i,j,k,wanA,wanB,tnoA,tnoB,Anum,Bnum;
+  int NUM,GA_AN,LB_AN,GB_AN;
+  int l1,l2,l3,Rn,n2;
+  double **H11r,**H11i;
+  double **H22r,**H22i;
+  double **H12r,**H12i;
+  double kRn,si,co,h;
 
   /* set MP */
 
@@ -2041,371 +1624,414 @@ void Hamiltonian_Band_NC(double *****RH, double *****IH,
 
 
 
-void Eigen_HH(dcomplex **ac, double *ko, int n, int EVmax)
+void Eigen_Bloch(double kp[4], int spinsize,
+                 int fsize, int fsize2, int fsize3, int *MP,
+                 dcomplex ***Wk, double **EigenVal)
 {
-  /**********************************************************************
-    Eigen_HH:
+  /********************************************************************
+   void Eigen_Bloch(double kp[4], int spinsize,
+                    int fsize, int fsize2, int fsize3, int *MP,
+                    dcomplex ***Wk, double **EigenVal)
+
+    a routine for calculating one-particle wave functions Wk and
+    eigenvalues EigenVal at a k-point kp, where the arguments are
+    the same as those of Overlap_k1k2.
+    The routine is thread-safe, so that the k-points along a string
+    can be diagonalized by the OpenMP threads.
+  ********************************************************************/
 
-    Eigen_HH.c is a subroutine to solve a standard eigenvalue problem
-    with a Hermite complex matrix using Householder method and lapack's
-    F77_NAME(dstegr,DSTEGR)() or dstedc_().
+  int spin,i,j,i1,j1,l,m,mn,jj1,ii1;
+  double sumr,sumi;
+  double *ko,*M1;
+  dcomplex **S,**H,**C;  
+  double OLP_eigen_cut = 1.0e-12;
+  dcomplex Ctmp1,Ctmp2;  
 
-    Log of Eigen_HH.c:
+  /****************************************************
+                 allocation of arrays:
+  ****************************************************/
 
-       Dec/07/2004  Released by T.Ozaki
+  ko = (double*)malloc(sizeof(double)*fsize3);
+  M1 = (double*)malloc(sizeof(double)*fsize3);
 
-  ***********************************************************************/
+  S = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
+  for (i=0; i<fsize3; i++){
+    S[i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
+    for (j=0; j<fsize3; j++){ S[i][j].r = 0.0; S[i][j].i = 0.0; }
+  }
 
-  static double ABSTOL=1.0e-13;
+  H = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
+  for (i=0; i<fsize3; i++){
+    H[i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
+    for (j=0; j<fsize3; j++){ H[i][j].r = 0.0; H[i][j].i = 0.0; }
+  }
 
-  static dcomplex **ad,*u,*b1,*p,*q,tmp1,tmp2,u1,u2,p1,ss;
-  static double *D,*E,*uu,*alphar,*alphai,
-    s1,s2,s3,r,
-    sum,ar,ai,br,bi,e,
-    a1,a2,a3,a4,a5,a6,b7,r1,r2,
-    r3,x1,x2,xap,
-    bb,bb1,ui,uj,uij;
+  C = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
+  for (i=0; i<fsize3; i++){
+    C[i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
+    for (j=0; j<fsize3; j++){ C[i][j].r = 0.0; C[i][j].i = 0.0; }
+  }
 
-  static int jj,jj1,jj2,k,ii,ll,i3,i2,j2,
-    i,j,i1,j1,n1,n2,ik,
-    jk,po1,nn,count;
+  Overlap_Band(OLP,S,MP,kp[1],kp[2],kp[3]);
 
-  static double Stime, Etime;
-  static double Stime1, Etime1;
-  static double Stime2, Etime2;
-  static double time1,time2;
+  Eigen_zheevd(S,ko,fsize);
 
-  /****************************************************
-    allocation of arrays:
-  ****************************************************/
+  for (l=1; l<=fsize; l++){
+    if (ko[l]<OLP_eigen_cut){
+      printf("found an overcomplete basis set\n");
+      MPI_Finalize();
+      exit(0); 
+    }
+  } 
 
-  n2 = n + 5;
+  for (l=1; l<=fsize; l++) M1[l] = 1.0/sqrt(ko[l]);
 
-  ad = (dcomplex**)malloc(sizeof(dcomplex*)*n2);
-  for (i=0; i<n2; i++){
-    ad[i] = (dcomplex*)malloc(sizeof(dcomplex)*n2);
-  }
+  /* S * M1  */
 
-  b1 = (dcomplex*)malloc(sizeof(dcomplex)*n2);
-  u = (dcomplex*)malloc(sizeof(dcomplex)*n2);
-  uu = (double*)malloc(sizeof(double)*n2);
-  p = (dcomplex*)malloc(sizeof(dcomplex)*n2);
-  q = (dcomplex*)malloc(sizeof(dcomplex)*n2);
+  for (i1=1; i1<=fsize; i1++){
+    for (j1=1; j1<=fsize; j1++){
+      S[i1][j1].r = S[i1][j1].r*M1[j1];
+      S[i1][j1].i = S[i1][j1].i*M1[j1];
+    } 
+  } 
 
-  D = (double*)malloc(sizeof(double)*n2);
-  E = (double*)malloc(sizeof(double)*n2);
+  for (spin=0; spin<spinsize; spin++){
 
-  alphar = (double*)malloc(sizeof(double)*n2);
-  alphai = (double*)malloc(sizeof(double)*n2);
+    /* transpose S */
 
-  for (i=1; i<=(n+2); i++){
-    uu[i] = 0.0;
-  }
+    for (i1=1; i1<=fsize; i1++){
+      for (j1=i1+1; j1<=fsize; j1++){
+	Ctmp1 = S[i1][j1];
+	Ctmp2 = S[j1][i1];
+	S[i1][j1] = Ctmp2;
+	S[j1][i1] = Ctmp1;
+      }
+    }
 
-  if (measure_time==1) printf("size n=%3d EVmax=%2d\n",n,EVmax);
-  if (measure_time==1) dtime(&Stime);
+    /****************************************************
+		      collinear case
+    ****************************************************/
 
-  /****************************************************
-               Householder transformation
-  ****************************************************/
+    if (SpinP_switch==0 || SpinP_switch==1){
 
-  for (i=1; i<=(n-1); i++){
+      Hamiltonian_Band(Hks[spin],H,MP,kp[1],kp[2],kp[3]);
 
-    s1 = ac[i+1][i].r * ac[i+1][i].r + ac[i+1][i].i * ac[i+1][i].i;
-    s2 = 0.0;
+      /****************************************************
+		    M1 * U^t * H * U * M1
+      ****************************************************/
 
-    u[i+1].r = ac[i+1][i].r;
-    u[i+1].i = ac[i+1][i].i;
- 
-    for (i1=i+2; i1<=n; i1++){
+      /* H * U * M1 */
 
-      tmp1.r = ac[i1][i].r; 
-      tmp1.i = ac[i1][i].i; 
+      for (j1=1; j1<=fsize; j1++){
+	for (i1=1; i1<=fsize; i1++){
 
-      s2 += tmp1.r*tmp1.r + tmp1.i*tmp1.i;
+	  sumr = 0.0;
+	  sumi = 0.0;
 
-      u[i1].r = tmp1.r;
-      u[i1].i = tmp1.i;
-    }
+	  for (l=1; l<=fsize; l++){
+	    sumr += H[i1][l].r*S[j1][l].r - H[i1][l].i*S[j1][l].i;
+	    sumi += H[i1][l].r*S[j1][l].i + H[i1][l].i*S[j1][l].r;
+	  }
 
-    s3 = fabs(s1 + s2);
+	  C[j1][i1].r = sumr;
+	  C[j1][i1].i = sumi;
+	}
+      }     
 
-    if ( ABSTOL<(fabs(ac[i+1][i].r)+fabs(ac[i+1][i].i)) ){
-      if (ac[i+1][i].r<0.0)  s3 =  sqrt(s3);
-      else                   s3 = -sqrt(s3);
-    }
-    else{
-      s3 = sqrt(s3);
-    }
+      /* M1 * U^+ H * U * M1 */
 
-    if ( ABSTOL<fabs(s2) || i==(n-1) ){
-
-      ss.r = ac[i+1][i].r;
-      ss.i = ac[i+1][i].i;
-
-      ac[i+1][i].r = s3;
-      ac[i+1][i].i = 0.0;
-      ac[i][i+1].r = s3;
-      ac[i][i+1].i = 0.0;
-
-      u[i+1].r = u[i+1].r - s3;
-      u[i+1].i = u[i+1].i;
-      
-      u1.r = s3 * s3 - ss.r * s3;
-      u1.i =         - ss.i * s3;
-      u2.r = 2.0 * u1.r;
-      u2.i = 2.0 * u1.i;
-      
-      e = u2.r/(u1.r*u1.r + u1.i*u1.i);
-      ar = e*u1.r;
-      ai = e*u1.i;
-
-      /* store alpha */
-      alphar[i] = ar;
-      alphai[i] = ai;
-
-      /* store u2 */
-      uu[i] = u2.r;
-
-      /* store the first component of u */
-      b1[i].r = ss.r - s3;
-      b1[i].i = ss.i;
-
-      r = 0.0;
-      for (i1=i+1; i1<=n; i1++){
-
-	p1.r = 0.0;
-	p1.i = 0.0;
-	for (j=i+1; j<=n; j++){
-	  p1.r += ac[i1][j].r * u[j].r - ac[i1][j].i * u[j].i;
-	  p1.i += ac[i1][j].r * u[j].i + ac[i1][j].i * u[j].r;
+      for (i1=1; i1<=fsize; i1++){
+	for (j1=1; j1<=fsize; j1++){
+	  sumr = 0.0;
+	  sumi = 0.0;
+	  for (l=1; l<=fsize; l++){
+	    sumr +=  S[i1][l].r*C[j1][l].r + S[i1][l].i*C[j1][l].i;
+	    sumi +=  S[i1][l].r*C[j1][l].i - S[i1][l].i*C[j1][l].r;
+	  }
+	  H[i1][j1].r = sumr;
+	  H[i1][j1].i = sumi;
 	}
-	p[i1].r = p1.r / u1.r;
-	p[i1].i = p1.i / u1.r;
+      } 
+
+      /* H to C */
 
-	r += u[i1].r * p[i1].r + u[i1].i * p[i1].i;
+      for (i1=1; i1<=fsize; i1++){
+	for (j1=1; j1<=fsize; j1++){
+	  C[i1][j1] = H[i1][j1];
+	}
       }
 
-      r = 0.5*r / u2.r;
+      /* solve eigenvalue problem */
 
-      br =  ar*r;
-      bi = -ai*r;
+      Eigen_zheevd(C,EigenVal[spin],fsize);
 
-      for (i1=i+1; i1<=n; i1++){
-	tmp1.r = 0.5*(p[i1].r - (br * u[i1].r - bi*u[i1].i));
-	tmp1.i = 0.5*(p[i1].i - (br * u[i1].i + bi*u[i1].r));
-	q[i1].r = ar * tmp1.r - ai * tmp1.i; 
-	q[i1].i = ar * tmp1.i + ai * tmp1.r; 
+      /****************************************************
+	 transformation to the original eigenvectors.
+	 NOTE JRCAT-244p and JAIST-2122p 
+      ****************************************************/
+
+      /* transpose */
+      for (i1=1; i1<=fsize; i1++){
+	for (j1=i1+1; j1<=fsize; j1++){
+	  Ctmp1 = S[i1][j1];
+	  Ctmp2 = S[j1][i1];
+	  S[i1][j1] = Ctmp2;
+	  S[j1][i1] = Ctmp1;
+	}
       }
 
-      for (i1=i+1; i1<=n; i1++){
-        tmp1.r = u[i1].r;
-        tmp1.i = u[i1].i;
-        tmp2.r = q[i1].r; 
-        tmp2.i = q[i1].i; 
-	for (j1=i+1; j1<=n; j1++){
-	  ac[i1][j1].r -= ( tmp1.r * q[j1].r + tmp1.i * q[j1].i
-                           +tmp2.r * u[j1].r + tmp2.i * u[j1].i );
-	  ac[i1][j1].i -= (-tmp1.r * q[j1].i + tmp1.i * q[j1].r
-                           -tmp2.r * u[j1].i + tmp2.i * u[j1].r );
+      /* transpose */
+      for (i1=1; i1<=fsize; i1++){
+	for (j1=i1+1; j1<=fsize; j1++){
+	  Ctmp1 = C[i1][j1];
+	  Ctmp2 = C[j1][i1];
+	  C[i1][j1] = Ctmp2;
+	  C[j1][i1] = Ctmp1;
 	}
       }
-    }
-  }
 
-  for (i=1; i<=n; i++){
-    for (j=1; j<=n; j++){
-      ad[i][j].r = ac[i][j].r;
-      ad[i][j].i = ac[i][j].i;
+      /* calculate wave functions */
+
+      for (i1=1; i1<=fsize; i1++){
+	for (j1=1; j1<=fsize; j1++){
+	  sumr = 0.0;
+	  sumi = 0.0;
+	  for (l=1; l<=fsize; l++){
+	    sumr +=  S[i1][l].r*C[j1][l].r - S[i1][l].i*C[j1][l].i;
+	    sumi +=  S[i1][l].r*C[j1][l].i + S[i1][l].i*C[j1][l].r;
+	  }
+
+	  Wk[spin][j1][i1].r = sumr;
+	  Wk[spin][j1][i1].i = sumi;
+	}
+      }
     }
-  }
 
-  if (measure_time==1){
-    dtime(&Etime);
-    printf("T1   %15.12f\n",Etime-Stime);
-  }
+    /****************************************************
+		    non-collinear case
+    ****************************************************/
 
-  /****************************************************
-                     call a lapack routine
-  ****************************************************/
+    else if (SpinP_switch==3){
 
-  if (measure_time==1) dtime(&Stime);
+      Hamiltonian_Band_NC(Hks,iHks,H,MP,kp[1],kp[2],kp[3]);
 
-  for (i=1; i<=n; i++){
-    D[i-1] = ad[i][i  ].r;
-    E[i-1] = ad[i][i+1].r;
-  }
+      /* H * U * M1 */
 
-  /*
-  if      (dste_flag==0) lapack_dstegr2(n,D,E,ko,ac);
-  else if (dste_flag==1) lapack_dstedc2(n,D,E,ko,ac);
-  else if (dste_flag==2) lapack_dstevx2(n,D,E,ko,ac);
-  */
+      for (j1=1; j1<=fsize; j1++){
+	for (i1=1; i1<=fsize2; i1++){
+	  for (m=0; m<=1; m++){
 
-  lapack_dstevx2(n,D,E,ko,ac);
+	    sumr = 0.0;
+	    sumi = 0.0;
+	    mn = m*fsize;
+	    for (l=1; l<=fsize; l++){
+	      sumr += H[i1][l+mn].r*S[j1][l].r - H[i1][l+mn].i*S[j1][l].i;
+	      sumi += H[i1][l+mn].r*S[j1][l].i + H[i1][l+mn].i*S[j1][l].r;
+	    }
 
-  if (measure_time==1){
-    dtime(&Etime);
-    printf("T2   %15.12f\n",Etime-Stime);
-  }
+	    jj1 = 2*j1 - 1 + m;
 
-  /****************************************************
-    transformation of eigenvectors to original space
-  ****************************************************/
+	    C[jj1][i1].r = sumr;
+	    C[jj1][i1].i = sumi;
+	  }
+	}
+      }     
 
-  if (measure_time==1) dtime(&Stime);
+      /* M1 * U^+ H * U * M1 */
 
-  /* ad stores u */
-  for (i=2; i<=n; i++){
-    ad[i-1][i].r = b1[i-1].r;
-    ad[i-1][i].i =-b1[i-1].i;
-    ad[i][i-1].r = b1[i-1].r;
-    ad[i][i-1].i = b1[i-1].i;
-  }
-  
-  for (k=1; k<=EVmax; k++){
-  
-    for (nn=1; nn<=n-1; nn++){
+      for (i1=1; i1<=fsize; i1++){
 
-      if ( (1.0e-3*ABSTOL)<fabs(uu[n-nn])){
+	for (m=0; m<=1; m++){
 
-	tmp1.r = 0.0;
-	tmp1.i = 0.0;
+	  ii1 = 2*i1 - 1 + m;
 
-	for (i=n-nn+1; i<=n; i++){
-	  tmp1.r += ad[n-nn][i].r * ac[k][i].r - ad[n-nn][i].i * ac[k][i].i;
-	  tmp1.i += ad[n-nn][i].i * ac[k][i].r + ad[n-nn][i].r * ac[k][i].i;
+	  for (j1=1; j1<=fsize2; j1++){
+	    sumr = 0.0;
+	    sumi = 0.0;
+	    mn = m*fsize;
+	    for (l=1; l<=fsize; l++){
+	      sumr +=  S[i1][l].r*C[j1][l+mn].r + S[i1][l].i*C[j1][l+mn].i;
+	      sumi +=  S[i1][l].r*C[j1][l+mn].i - S[i1][l].i*C[j1][l+mn].r;
+	    }
+	    H[ii1][j1].r = sumr;
+	    H[ii1][j1].i = sumi;
+	  }
 	}
+      }
+
+      /* solve eigenvalue problem */
 
-	ss.r = (alphar[n-nn]*tmp1.r - alphai[n-nn]*tmp1.i) / uu[n-nn];
-	ss.i = (alphar[n-nn]*tmp1.i + alphai[n-nn]*tmp1.r) / uu[n-nn];
+      Eigen_zheevd(H,EigenVal[0],fsize2);
 
-	for (i=n-nn+1; i<=n; i++){
-	  ac[k][i].r -= ss.r * ad[n-nn][i].r + ss.i * ad[n-nn][i].i;
-	  ac[k][i].i -=-ss.r * ad[n-nn][i].i + ss.i * ad[n-nn][i].r;
+      /****************************************************
+	 transformation to the original eigenvectors
+		NOTE JRCAT-244p and JAIST-2122p 
+		   C = U * lambda^{-1/2} * D
+      ****************************************************/
+
+      /* transpose */
+
+      for (i1=1; i1<=fsize; i1++){
+	for (j1=i1+1; j1<=fsize; j1++){
+	  Ctmp1 = S[i1][j1];
+	  Ctmp2 = S[j1][i1];
+	  S[i1][j1] = Ctmp2;
+	  S[j1][i1] = Ctmp1;
 	}
       }
-    }
-  }
 
-  if (measure_time==1){
-    dtime(&Etime);
-    printf("T4   %15.12f\n",Etime-Stime);
-  }
+      for (i1=1; i1<=fsize2; i1++){
+	for (j1=1; j1<=fsize2; j1++){
+	  C[i1][j1].r = 0.0;
+	  C[i1][j1].i = 0.0;
+	}
+      }
 
-  /****************************************************
-                     normalization
-  ****************************************************/
+      for (m=0; m<=1; m++){
+	for (i1=1; i1<=fsize; i1++){
+	  for (j1=1; j1<=fsize2; j1++){
+
+	    sumr = 0.0; 
+	    sumi = 0.0;
+
+	    for (l=1; l<=fsize; l++){
+	      sumr +=  S[i1][l].r*H[2*l-1+m][j1].r - S[i1][l].i*H[2*l-1+m][j1].i;
+	      sumi +=  S[i1][l].r*H[2*l-1+m][j1].i + S[i1][l].i*H[2*l-1+m][j1].r;
+	    } 
+
+	    Wk[0][j1][i1+m*fsize].r = sumr;
+	    Wk[0][j1][i1+m*fsize].i = sumi;
+	  }
+	}
+      }
 
-  if (measure_time==1) dtime(&Stime);
-  
-  for (j=1; j<=EVmax; j++){
-    sum = 0.0;
-    for (i=1; i<=n; i++){
-      sum += ac[j][i].r * ac[j][i].r + ac[j][i].i * ac[j][i].i;
-    }
-    sum = 1.0/sqrt(sum);
-    for (i=1; i<=n; i++){
-      ac[j][i].r = ac[j][i].r * sum;
-      ac[j][i].i = ac[j][i].i * sum;
     }
-  }
 
-  if (measure_time==1){
-    dtime(&Etime);
-    printf("T5   %15.12f\n",Etime-Stime);
-  }
+  } /* spin */
 
   /****************************************************
-                     transpose ac
+                    free arrays
   ****************************************************/
 
-  for (i=1; i<=n; i++){
-    for (j=(i+1); j<=n; j++){
-      tmp1 = ac[i][j];
-      tmp2 = ac[j][i];
-      ac[i][j] = tmp2;
-      ac[j][i] = tmp1;
-    }
+  free(ko);
+  free(M1);
+
+  for (i=0; i<fsize3; i++){
+    free(S[i]);
   }
+  free(S);
 
-  /****************************************************
-                  freeing of arrays:
-  ****************************************************/
+  for (i=0; i<fsize3; i++){
+    free(H[i]);
+  }
+  free(H);
 
-  for (i=0; i<n2; i++){
-    free(ad[i]);
-  }
-  free(ad);
-
-  free(b1);
-  free(u);
-  free(uu);
-  free(p);
-  free(q);
-  free(D);
-  free(E);
-  free(alphar);
-  free(alphai);
+  for (i=0; i<fsize3; i++){
+    free(C[i]);
+  }
+  free(C);
 }
 
 
 
-void lapack_dstevx2(INTEGER N, double *D, double *E, double *W, dcomplex **ev)
+void Eigen_zheevd(dcomplex **ac, double *ko, int n)
 {
-  static int i,j;
-
-  char  *JOBZ="V";
-  char  *RANGE="A";
-
-  double VL,VU; /* dummy */
-  INTEGER IL,IU; 
-  double ABSTOL=1.0e-12;
-  INTEGER M;
-  double *Z;
-  INTEGER LDZ;
-  double *WORK;
-  INTEGER *IWORK;
-  INTEGER *IFAIL;
-  INTEGER INFO;
-
-  M = N;
-  LDZ = N;
-
-  Z = (double*)malloc(sizeof(double)*LDZ*N);
-  WORK = (double*)malloc(sizeof(double)*5*N);
-  IWORK = (INTEGER*)malloc(sizeof(INTEGER)*5*N);
-  IFAIL = (INTEGER*)malloc(sizeof(INTEGER)*N);
-
-  F77_NAME(dstevx,DSTEVX)( JOBZ, RANGE, &N,  D, E, &VL, &VU, &IL, &IU, &ABSTOL,
-           &M, W, Z, &LDZ, WORK, IWORK, IFAIL, &INFO );
-
-  /* store eigenvectors */
-
-  for (i=0; i<N; i++) {
-    for (j=0; j<N; j++) {
-      ev[i+1][j+1].r = Z[i*N+j];
-      ev[i+1][j+1].i = 0.0;
+  /********************************************************************
+   void Eigen_zheevd(dcomplex **ac, double *ko, int n)
+
+    a routine for solving a standard eigenvalue problem of a Hermitian
+    matrix ac[1:n][1:n] by lapack's zheevd (divide and conquer).
+    The eigenvalues are stored in ko[1:n] in ascending order, and
+    the eigenvector of ko[j] is stored in the column ac[1:n][j].
+  ********************************************************************/
+
+  int i,j;
+  char *JOBZ="V";
+  char *UPLO="L";
+  INTEGER N,LDA,LWORK,LRWORK,LIWORK,INFO;
+  INTEGER *IWORK,iwork0;
+  double *RWORK,rwork0;
+  dcomplex *A,*WORK,work0;
+
+  N = n;
+  LDA = n;
+
+  A = (dcomplex*)malloc(sizeof(dcomplex)*n*n);
+
+  for (i=1; i<=n; i++){
+    for (j=1; j<=n; j++){
+      A[(j-1)*n+(i-1)] = ac[i][j];
     }
   }
 
-  /* shift ko by 1 */
-  for (i=N; i>=1; i--){
-    W[i]= W[i-1];
-  }
+  /* query of the size of work space */
+
+  LWORK = -1;
+  LRWORK = -1;
+  LIWORK = -1;
 
-  if (INFO>0) {
-    printf("\n error in dstevx_, info=%d\n\n",INFO);
+  F77_NAME(zheevd,ZHEEVD)( JOBZ, UPLO, &N, A, &LDA, &ko[1], &work0, &LWORK,
+                           &rwork0, &LRWORK, &iwork0, &LIWORK, &INFO );
+
+  LWORK = (INTEGER)work0.r;
+  LRWORK = (INTEGER)rwork0;
+  LIWORK = iwork0;
+
+  WORK = (dcomplex*)malloc(sizeof(dcomplex)*LWORK);
+  RWORK = (double*)malloc(sizeof(double)*LRWORK);
+  IWORK = (INTEGER*)malloc(sizeof(INTEGER)*LIWORK);
+
+  F77_NAME(zheevd,ZHEEVD)( JOBZ, UPLO, &N, A, &LDA, &ko[1], WORK, &LWORK,
+                           RWORK, &LRWORK, IWORK, &LIWORK, &INFO );
+
+  if (INFO!=0){
+    printf("ERROR in zheevd_(), info=%2d\n",(int)INFO);
   }
-  if (INFO<0) {
-    printf("info=%d in dstevx_\n",INFO);
-    exit(0);
+
+  for (i=1; i<=n; i++){
+    for (j=1; j<=n; j++){
+      ac[i][j] = A[(j-1)*n+(i-1)];
+    }
   }
 
-  free(Z);
+  free(A);
   free(WORK);
+  free(RWORK);
   free(IWORK);
-  free(IFAIL);
+}
+
+
+
+dcomplex ***Allocate_Wk(int spinsize, int fsize3)
+{
+  int spin,i,j;
+  dcomplex ***Wk;
+
+  Wk = (dcomplex***)malloc(sizeof(dcomplex**)*spinsize);
+  for (spin=0; spin<spinsize; spin++){
+    Wk[spin] = (dcomplex**)malloc(sizeof(dcomplex*)*fsize3);
+    for (i=0; i<fsize3; i++){
+      Wk[spin][i] = (dcomplex*)malloc(sizeof(dcomplex)*fsize3);
+      for (j=0; j<fsize3; j++){ Wk[spin][i][j].r = 0.0; Wk[spin][i][j].i = 0.0; }
+    }
+  }
+
+  return Wk;
+}
+
+
+
+void Free_Wk(dcomplex ***Wk, int spinsize, int fsize3)
+{
+  int spin,i;
+
+  for (spin=0; spin<spinsize; spin++){
+    for (i=0; i<fsize3; i++){
+      free(Wk[spin][i]);
+    }
+    free(Wk[spin]);
+  }
+  free(Wk);
 }
 
 
@@ -2457,8 +2083,8 @@ void determinant( int spin, int N, dcomplex **a, INTEGER *ipiv, dcomplex *a1d,
      to those with spin index 0 and 1.
   ********************************************************************/
 
-  static int i,j;
-  static INTEGER lda,info,lwork;
+  int i,j;
+  INTEGER lda,info,lwork;
   dcomplex Ctmp;
 
   lda = N;
@@ -184,6 +184,23 @@ void TRAN_Calc_SelfEnergy(
           );
 
 
+/* TRAN_SelfEnergy_Cache.c */
+void TRAN_SelfEnergy_Cache_Reset(int iter, int knum, int wnum);
+void TRAN_SelfEnergy_Cache_Set_Index(
+            int kloop,
+            int nc,
+            int ne[2],
+            dcomplex *SCL,
+            dcomplex *SCR,
+            dcomplex **HCL,
+            dcomplex **HCR,
+            int spinsize
+          );
+int TRAN_SelfEnergy_Cache_Get(int iside, int kloop, int Miw, int nc, dcomplex *sigma);
+void TRAN_SelfEnergy_Cache_Put(int iside, int kloop, int Miw, int nc, dcomplex *sigma);
+void TRAN_SelfEnergy_Cache_Free();
+
+
 /* TRAN_Calc_Hopping_G.c */
 void TRAN_Calc_Hopping_G(
                          /* input */
@@ -114,6 +114,12 @@ int *tran_integ_method_scf;
 int tran_surfgreen_iteration_max;
 double tran_surfgreen_eps; 
 
+/* self energies of the leads kept over the SCF, see TRAN_SelfEnergy_Cache.c */
+int TRAN_SigmaCache_flag;
+int TRAN_SigmaCache_Disk;
+double TRAN_SigmaCache_MaxMem; /* in MByte per process */
+char TRAN_SigmaCache_filepath[YOUSO10*2];
+
 int tran_num_poles;
 
 
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <unistd.h>
 #include "openmx_common.h" 
 #include "mpi.h"
 #include "omp.h"
@@ -35,6 +36,7 @@ static void Output_Connectivity(FILE *fp);
 static void UCell_Box(int MD_iter, int estimate_switch, int CpyCell);
 static void Set_Inf_SndRcv();
 static void Construct_MPI_Data_Structure_Grid();
+static int Decide_dOrbs_Grid(double size);
 
 int TFNAN,TFNAN2,TSNAN,TSNAN2;
 
@@ -48,7 +50,7 @@ double truncation(int MD_iter,int UCell_flag)
   int tno0,tno1,tno2,Cwan,Hwan,N,so,spin;
   int num,n2,wanA,wanB,Gi,NO1;
   int Anum,Bnum,fan,csize,NUM;
-  int size_Orbs_Grid,size_COrbs_Grid;
+  int size_Orbs_Grid,size_COrbs_Grid,size_dOrbs_Grid;
   int size_Orbs_Grid_FNAN;
   int size_H0,size_CntH0,size_H,size_CntH;
   int size_HNL,size_HisH1,size_HisH2;
@@ -2938,43 +2940,48 @@ double truncation(int MD_iter,int UCell_flag)
       Density_Grid_B = (double**)malloc(sizeof(double*)*4); 
       for (k=0; k<=3; k++){
         Density_Grid_B[k] = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
-        for (i=0; i<My_NumGridB_AB; i++) Density_Grid_B[k][i] = 0.0;
+        NUMA_First_Touch(Density_Grid_B[k], My_NumGridB_AB, sizeof(double));
       }
     }
     else{
       Density_Grid_B = (double**)malloc(sizeof(double*)*2); 
       for (k=0; k<=1; k++){
         Density_Grid_B[k] = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
-        for (i=0; i<My_NumGridB_AB; i++) Density_Grid_B[k][i] = 0.0;
+        NUMA_First_Touch(Density_Grid_B[k], My_NumGridB_AB, sizeof(double));
       }
     }
 
     ADensity_Grid_B = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
+    NUMA_First_Touch(ADensity_Grid_B, My_NumGridB_AB, sizeof(double));
 
     PCCDensity_Grid_B = (double**)malloc(sizeof(double*)*2); 
     PCCDensity_Grid_B[0] = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
     PCCDensity_Grid_B[1] = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
 
-    for (i=0; i<My_NumGridB_AB; i++){
-      PCCDensity_Grid_B[0][i] = 0.0;  
-      PCCDensity_Grid_B[1][i] = 0.0;
-    }
+    /* zeroed with the partition of the OpenMP loops on the grids, 
+       so that the pages are placed near the threads using them */
+
+    NUMA_First_Touch(PCCDensity_Grid_B[0], My_NumGridB_AB, sizeof(double));
+    NUMA_First_Touch(PCCDensity_Grid_B[1], My_NumGridB_AB, sizeof(double));
 
     dVHart_Grid_B = (double*)malloc(sizeof(double)*My_Max_NumGridB); 
-    for (i=0; i<My_Max_NumGridB; i++) dVHart_Grid_B[i] = 0.0;
+    NUMA_First_Touch(dVHart_Grid_B, My_Max_NumGridB, sizeof(double));
 
     RefVxc_Grid_B = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
+    NUMA_First_Touch(RefVxc_Grid_B, My_NumGridB_AB, sizeof(double));
 
     if (SpinP_switch==3){ /* spin non-collinear */
       Vxc_Grid_B = (double**)malloc(sizeof(double*)*4); 
       for (k=0; k<=3; k++){
         Vxc_Grid_B[k] = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
+        NUMA_First_Touch(Vxc_Grid_B[k], My_NumGridB_AB, sizeof(double));
       }
     }
     else{
       Vxc_Grid_B = (double**)malloc(sizeof(double*)*2); 
       for (k=0; k<=1; k++){
         Vxc_Grid_B[k] = (double*)malloc(sizeof(double)*My_NumGridB_AB);
+        NUMA_First_Touch(Vxc_Grid_B[k], My_NumGridB_AB, sizeof(double));
       }
     }
 
@@ -2982,12 +2989,14 @@ double truncation(int MD_iter,int UCell_flag)
       Vpot_Grid_B = (double**)malloc(sizeof(double*)*4); 
       for (k=0; k<=3; k++){
         Vpot_Grid_B[k] = (double*)malloc(sizeof(double)*My_NumGridB_AB); 
+        NUMA_First_Touch(Vpot_Grid_B[k], My_NumGridB_AB, sizeof(double));
       }
     }
     else{
       Vpot_Grid_B = (double**)malloc(sizeof(double*)*2); 
       for (k=0; k<=1; k++){
         Vpot_Grid_B[k] = (double*)malloc(sizeof(double)*My_NumGridB_AB);
+        NUMA_First_Touch(Vpot_Grid_B[k], My_NumGridB_AB, sizeof(double));
       }
     }
 
@@ -3009,22 +3018,21 @@ double truncation(int MD_iter,int UCell_flag)
     PCCDensity_Grid_D[0] = (double*)malloc(sizeof(double)*My_NumGridD); 
     PCCDensity_Grid_D[1] = (double*)malloc(sizeof(double)*My_NumGridD); 
 
-    for (i=0; i<My_NumGridD; i++){
-      PCCDensity_Grid_D[0][i] = 0.0; PCCDensity_Grid_D[1][i] = 0.0; 
-    }
+    NUMA_First_Touch(PCCDensity_Grid_D[0], My_NumGridD, sizeof(double));
+    NUMA_First_Touch(PCCDensity_Grid_D[1], My_NumGridD, sizeof(double));
 
     if (SpinP_switch==3){ /* spin non-collinear */
       Density_Grid_D = (double**)malloc(sizeof(double*)*4); 
       for (k=0; k<=3; k++){
         Density_Grid_D[k] = (double*)malloc(sizeof(double)*My_NumGridD); 
-        for (i=0; i<My_NumGridD; i++) Density_Grid_D[k][i] = 0.0;
+        NUMA_First_Touch(Density_Grid_D[k], My_NumGridD, sizeof(double));
       }
     }
     else{
       Density_Grid_D = (double**)malloc(sizeof(double*)*2); 
       for (k=0; k<=1; k++){
         Density_Grid_D[k] = (double*)malloc(sizeof(double)*My_NumGridD); 
-        for (i=0; i<My_NumGridD; i++) Density_Grid_D[k][i] = 0.0;
+        NUMA_First_Touch(Density_Grid_D[k], My_NumGridD, sizeof(double));
       }
     }
 
@@ -3032,12 +3040,14 @@ double truncation(int MD_iter,int UCell_flag)
       Vxc_Grid_D = (double**)malloc(sizeof(double*)*4); 
       for (k=0; k<=3; k++){
         Vxc_Grid_D[k] = (double*)malloc(sizeof(double)*My_NumGridD); 
+        NUMA_First_Touch(Vxc_Grid_D[k], My_NumGridD, sizeof(double));
       }
     }
     else{
       Vxc_Grid_D = (double**)malloc(sizeof(double*)*2); 
       for (k=0; k<=1; k++){
         Vxc_Grid_D[k] = (double*)malloc(sizeof(double)*My_NumGridD);
+        NUMA_First_Touch(Vxc_Grid_D[k], My_NumGridD, sizeof(double));
       }
     }
 
@@ -3050,15 +3060,50 @@ double truncation(int MD_iter,int UCell_flag)
       Gc_AN = F_M2G[Mc_AN];
       Cwan = WhatSpecies[Gc_AN];
       /* AITUNE */
-      Orbs_Grid[Mc_AN] = (Type_Orbs_Grid**)malloc(sizeof(Type_Orbs_Grid*)*GridN_Atom[Gc_AN]); 
+      Orbs_Grid[Mc_AN] = (Type_Orbs_Grid**)malloc(sizeof(Type_Orbs_Grid*)*(GridN_Atom[Gc_AN]+1)); 
       int Nc;
+
+      /* one block per atom, whose rows Nc are touched first by the thread 
+         computing them in Set_Orbitals_Grid */
+
+      Orbs_Grid[Mc_AN][0] = (Type_Orbs_Grid*)malloc(sizeof(Type_Orbs_Grid)*(GridN_Atom[Gc_AN]*Spe_Total_NO[Cwan]+1)); 
+      NUMA_First_Touch(Orbs_Grid[Mc_AN][0], GridN_Atom[Gc_AN], sizeof(Type_Orbs_Grid)*Spe_Total_NO[Cwan]);
+
       for (Nc=0; Nc<GridN_Atom[Gc_AN]; Nc++){
-        Orbs_Grid[Mc_AN][Nc] = (Type_Orbs_Grid*)malloc(sizeof(Type_Orbs_Grid)*Spe_Total_NO[Cwan]); 
+        Orbs_Grid[Mc_AN][Nc] = Orbs_Grid[Mc_AN][0] + Nc*Spe_Total_NO[Cwan]; 
 	size_Orbs_Grid += Spe_Total_NO[Cwan];
       }
       /* AITUNE */
     }
 
+    /* the cache of fuzzy weights */
+    Fuzzy_Weight_Alloc();
+
+    /* dOrbs_Grid */
+    size_dOrbs_Grid = 0;
+    dOrbs_Grid_flag = Decide_dOrbs_Grid(3.0*(double)sizeof(Type_Orbs_Grid)*(double)size_Orbs_Grid);
+    dOrbs_Grid_kind = -1;
+
+    if (dOrbs_Grid_flag){
+      dOrbs_Grid = (Type_Orbs_Grid***)malloc(sizeof(Type_Orbs_Grid**)*(Matomnum+1)); 
+      dOrbs_Grid[0] = (Type_Orbs_Grid**)malloc(sizeof(Type_Orbs_Grid*)*1); 
+      dOrbs_Grid[0][0] = (Type_Orbs_Grid*)malloc(sizeof(Type_Orbs_Grid)*1); 
+      for (Mc_AN=1; Mc_AN<=Matomnum; Mc_AN++){
+        Gc_AN = F_M2G[Mc_AN];
+        Cwan = WhatSpecies[Gc_AN];
+        dOrbs_Grid[Mc_AN] = (Type_Orbs_Grid**)malloc(sizeof(Type_Orbs_Grid*)*(GridN_Atom[Gc_AN]+1)); 
+        int Nc;
+
+        dOrbs_Grid[Mc_AN][0] = (Type_Orbs_Grid*)malloc(sizeof(Type_Orbs_Grid)*(GridN_Atom[Gc_AN]*3*Spe_Total_NO[Cwan]+1)); 
+        NUMA_First_Touch(dOrbs_Grid[Mc_AN][0], GridN_Atom[Gc_AN], sizeof(Type_Orbs_Grid)*3*Spe_Total_NO[Cwan]);
+
+        for (Nc=0; Nc<GridN_Atom[Gc_AN]; Nc++){
+          dOrbs_Grid[Mc_AN][Nc] = dOrbs_Grid[Mc_AN][0] + Nc*3*Spe_Total_NO[Cwan]; 
+          size_dOrbs_Grid += 3*Spe_Total_NO[Cwan];
+        }
+      }
+    }
+
     /* COrbs_Grid */
     size_COrbs_Grid = 0;
     if (Cnt_switch!=0){
@@ -3143,6 +3188,9 @@ double truncation(int MD_iter,int UCell_flag)
       PrintMemory("truncation: Orbs_Grid",        sizeof(Type_Orbs_Grid)*size_Orbs_Grid,   NULL);
       PrintMemory("truncation: COrbs_Grid",       sizeof(Type_Orbs_Grid)*size_COrbs_Grid,  NULL);
       PrintMemory("truncation: Orbs_Grid_FNAN",   sizeof(Type_Orbs_Grid)*size_Orbs_Grid_FNAN,  NULL);
+      if (dOrbs_Grid_flag){
+        PrintMemory("truncation: dOrbs_Grid",     sizeof(Type_Orbs_Grid)*size_dOrbs_Grid,  NULL);
+      }
 
       if (ProExpn_VNA==0){
         PrintMemory("truncation: VNA_Grid",         sizeof(double)*N,                  NULL);
@@ -7235,22 +7283,27 @@ void free_arrays_truncation0()
     /* Orbs_Grid */
 
     for (Mc_AN=0; Mc_AN<=Matomnum; Mc_AN++){
-      if (Mc_AN==0){
-        Gc_AN = 0;
-        num = 1;
-      }
-      else{
-        Gc_AN = F_M2G[Mc_AN];
-        num = GridN_Atom[Gc_AN];
-      }
-
-      for (Nc=0; Nc<num; Nc++){
-        free(Orbs_Grid[Mc_AN][Nc]);
-      }
+      free(Orbs_Grid[Mc_AN][0]);
       free(Orbs_Grid[Mc_AN]); 
     }
     free(Orbs_Grid); 
 
+    /* the cached fuzzy weights */
+
+    Fuzzy_Weight_Free();
+
+    /* dOrbs_Grid */
+
+    if (dOrbs_Grid_flag){
+      for (Mc_AN=0; Mc_AN<=Matomnum; Mc_AN++){
+        free(dOrbs_Grid[Mc_AN][0]);
+        free(dOrbs_Grid[Mc_AN]); 
+      }
+      free(dOrbs_Grid); 
+
+      dOrbs_Grid_flag = 0;
+    }
+
     /* COrbs_Grid */
 
     if (Cnt_switch!=0){
@@ -8029,6 +8082,41 @@ void Set_Inf_SndRcv()
 
 
 
+int Decide_dOrbs_Grid(double size)
+{
+  /****************************************************
+   decide whether the gradients of basis orbitals are 
+   stored on grids (dOrbs_Grid) by Set_Orbitals_Grid().
+   In case of "Auto", they are stored if the sum of 
+   "size" over the MPI processes sharing a node is less 
+   than a half of the physical memory available on it.
+  ****************************************************/
+
+  int flag,node_flag;
+  double node_size,avail;
+  MPI_Comm comm_node;
+
+  if      (dOrbs_Grid_switch==0) return 0;
+  else if (dOrbs_Grid_switch==1) return 1;
+
+  MPI_Comm_split_type(mpi_comm_level1,MPI_COMM_TYPE_SHARED,0,MPI_INFO_NULL,&comm_node);
+  MPI_Allreduce(&size, &node_size, 1, MPI_DOUBLE, MPI_SUM, comm_node);
+  MPI_Comm_free(&comm_node);
+
+  avail = (double)sysconf(_SC_AVPHYS_PAGES)*(double)sysconf(_SC_PAGESIZE);
+
+  if (node_size<0.5*avail) node_flag = 1;
+  else                     node_flag = 0;
+
+  /* the same decision for all the processes */
+
+  MPI_Allreduce(&node_flag, &flag, 1, MPI_INT, MPI_MIN, mpi_comm_level1);
+
+  return flag;
+}
+
+
+
 void Construct_MPI_Data_Structure_Grid()
 {
   static int firsttime=1;